@@ -2,7 +2,7 @@
 
 namespace {
 // Subtract `sub` from `counter`, clamping at 0 to avoid quint64 underflow if
-// accounting ever drifts (e.g. a prior raw QHash::insert bypassed the API).
+// accounting ever drifts.
 inline void safeSubBytes(std::atomic<quint64> &counter, quint64 sub) {
     quint64 cur = counter.load(std::memory_order_relaxed);
     while (true) {
@@ -13,46 +13,224 @@ inline void safeSubBytes(std::atomic<quint64> &counter, quint64 sub) {
             break;
     }
 }
+
+inline quint64 imageBytes(const QImage &image) {
+    return static_cast<quint64>(image.sizeInBytes());
+}
 }
 
 ImageCacheData::ImageCacheData(QObject *) {}
 
-bool ImageCacheData::contains(const QString &key)
+bool ImageCacheData::contains(const QString &key) const
 {
-    QMutexLocker locker(&rwLock);
-    return imCache.contains(key);
+    const size_t h = hashKey(key);
+    // Lock-free negative: nothing with this hash bucket has been inserted.
+    if (filterFor(h).load(std::memory_order_acquire) == 0) return false;
+
+    Shard &s = shardFor(h);
+    QMutexLocker locker(&s.lock);
+    return s.hash.contains(key);
 }
 
-void ImageCacheData::insert(const QString &key, const QImage &image)
+bool ImageCacheData::find(const QString &key, QImage &image, QSize *fullSize) const
 {
-    QMutexLocker locker(&rwLock);
+    const size_t h = hashKey(key);
+    if (filterFor(h).load(std::memory_order_acquire) == 0) return false;
 
-    // replace: subtract the old image's bytes before swapping
-    if (auto it = imCache.find(key); it != imCache.end()) {
-        safeSubBytes(bytes, static_cast<quint64>(it.value().sizeInBytes()));
-        it.value() = image; // replace in place to avoid rehash
-    }
-    // else add new image
-    else {
-        imCache.insert(key, image);
+    Shard &s = shardFor(h);
+    QMutexLocker locker(&s.lock);
+    auto it = s.hash.find(key);
+    if (it == s.hash.end()) return false;
+    it.value().lastUse = tick();
+    image = it.value().image;               // implicitly shared, no pixel copy
+    if (fullSize) *fullSize = it.value().fullSize;
+    return true;
+}
+
+bool ImageCacheData::isReduced(const QString &key) const
+{
+    const size_t h = hashKey(key);
+    if (filterFor(h).load(std::memory_order_acquire) == 0) return false;
+
+    Shard &s = shardFor(h);
+    QMutexLocker locker(&s.lock);
+    auto it = s.hash.constFind(key);
+    return it != s.hash.cend() && it.value().fullSize.isValid();
+}
+
+QImage ImageCacheData::value(const QString &key) const
+{
+    QImage image;
+    find(key, image);
+    return image;
+}
+
+void ImageCacheData::insert(const QString &key, const QImage &image, QSize fullSize)
+{
+    const size_t h = hashKey(key);
+    Shard &s = shardFor(h);
+    {
+        QMutexLocker locker(&s.lock);
+
+        // replace: subtract the old image's bytes before swapping
+        if (auto it = s.hash.find(key); it != s.hash.end()) {
+            safeSubBytes(s.bytes, imageBytes(it.value().image));
+            it.value().image = image; // replace in place to avoid rehash
+            it.value().lastUse = tick();
+            it.value().fullSize = fullSize;
+        }
+        // else add new image
+        else {
+            s.hash.insert(key, Entry{image, tick(), fullSize});
+            filterFor(h).fetch_add(1, std::memory_order_release);
+            entries.fetch_add(1, std::memory_order_relaxed);
+        }
+        // add bytes to stripe total bytes
+        s.bytes.fetch_add(imageBytes(image), std::memory_order_relaxed);
     }
-    // add bytes to cache total bytes
-    bytes.fetch_add(static_cast<quint64>(image.sizeInBytes()),
-                    std::memory_order_relaxed);
+
+    if (overBudget()) overBudgetInserts.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ImageCacheData::replaceIfUnchanged(const QString &key, qint64 expectedCacheKey,
+                                        const QImage &image, QSize fullSize)
+{
+    const size_t h = hashKey(key);
+    if (filterFor(h).load(std::memory_order_acquire) == 0) return false;
+
+    Shard &s = shardFor(h);
+    QMutexLocker locker(&s.lock);
+    auto it = s.hash.find(key);
+    if (it == s.hash.end() || it.value().image.cacheKey() != expectedCacheKey) return false;
+    safeSubBytes(s.bytes, imageBytes(it.value().image));
+    it.value().image = image;               // lastUse kept: same entry, fewer pixels
+    it.value().fullSize = fullSize;
+    s.bytes.fetch_add(imageBytes(image), std::memory_order_relaxed);
+    return true;
+}
+
+QImage ImageCacheData::take(const QString &key, QSize *fullSize)
+{
+    const size_t h = hashKey(key);
+    if (filterFor(h).load(std::memory_order_acquire) == 0) return QImage();
+
+    Shard &s = shardFor(h);
+    QMutexLocker locker(&s.lock);
+    auto it = s.hash.find(key);
+    if (it == s.hash.end()) return QImage();
+    QImage image = std::move(it.value().image);
+    if (fullSize) *fullSize = it.value().fullSize;
+    s.hash.erase(it);
+    safeSubBytes(s.bytes, imageBytes(image));
+    filterFor(h).fetch_sub(1, std::memory_order_release);
+    entries.fetch_sub(1, std::memory_order_relaxed);
+    return image;
 }
 
 void ImageCacheData::remove(const QString &key)
 {
-    QMutexLocker locker(&rwLock);
+    take(key);
+}
 
-    // take() gives us the removed value so we can adjust bytes
-    QImage img = imCache.take(key);
-    safeSubBytes(bytes, static_cast<quint64>(img.sizeInBytes()));
+bool ImageCacheData::rename(const QString &oldKey, const QString &newKey)
+{
+    if (!contains(oldKey)) return false;
+    QSize fullSize;
+    QImage image = take(oldKey, &fullSize);
+    // take() can lose a race with a concurrent remove; do not cache a null image
+    if (image.isNull()) return false;
+    insert(newKey, image, fullSize);
+    return true;
 }
 
 void ImageCacheData::clear()
 {
-    QMutexLocker locker(&rwLock);
-    imCache.clear();
-    bytes.store(0, std::memory_order_relaxed);
+    for (Shard &s : shards) {
+        QMutexLocker locker(&s.lock);
+        for (auto it = s.hash.cbegin(); it != s.hash.cend(); ++it) {
+            filterFor(hashKey(it.key())).fetch_sub(1, std::memory_order_release);
+            entries.fetch_sub(1, std::memory_order_relaxed);
+        }
+        s.hash.clear();
+        s.bytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+QStringList ImageCacheData::removeIf(const std::function<bool(const QString &)> &pred)
+{
+    QStringList removed;
+    for (Shard &s : shards) {
+        QMutexLocker locker(&s.lock);
+        auto it = s.hash.begin();
+        while (it != s.hash.end()) {
+            if (!pred(it.key())) { ++it; continue; }
+            removed.append(it.key());
+            safeSubBytes(s.bytes, imageBytes(it.value().image));
+            filterFor(hashKey(it.key())).fetch_sub(1, std::memory_order_release);
+            entries.fetch_sub(1, std::memory_order_relaxed);
+            it = s.hash.erase(it);
+        }
+    }
+    return removed;
+}
+
+void ImageCacheData::forEach(const std::function<void(const QString &, const QImage &)> &fn) const
+{
+    for (const Shard &s : shards) {
+        QMutexLocker locker(&s.lock);
+        for (auto it = s.hash.cbegin(); it != s.hash.cend(); ++it)
+            fn(it.key(), it.value().image);
+    }
+}
+
+QStringList ImageCacheData::keys() const
+{
+    QStringList keys;
+    keys.reserve(count());
+    for (const Shard &s : shards) {
+        QMutexLocker locker(&s.lock);
+        for (auto it = s.hash.cbegin(); it != s.hash.cend(); ++it)
+            keys.append(it.key());
+    }
+    return keys;
+}
+
+quint64 ImageCacheData::sizeBytes() const noexcept
+{
+    quint64 sum = 0;
+    for (const Shard &s : shards) sum += s.bytes.load(std::memory_order_relaxed);
+    return sum;
+}
+
+void ImageCacheData::setMaxBytes(quint64 maxBytes) noexcept
+{
+    budget.store(maxBytes, std::memory_order_relaxed);
+}
+
+bool ImageCacheData::overBudget() const noexcept
+{
+    const quint64 cap = budget.load(std::memory_order_relaxed);
+    return cap && sizeBytes() > cap;
+}
+
+void ImageCacheData::toDisplayFormat(QImage &image, bool opaque)
+{
+    if (image.isNull()) return;
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return;
+    case QImage::Format_ARGB32:
+        if (opaque) image.reinterpretAsFormat(QImage::Format_RGB32);
+        else image.convertTo(QImage::Format_ARGB32_Premultiplied);
+        return;
+    default:
+        image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                : QImage::Format_RGB32);
+    }
+}
+
+void ImageCacheData::noteViewHandoff(bool shared) noexcept
+{
+    (shared ? handoffShared : handoffCopied).fetch_add(1, std::memory_order_relaxed);
 }
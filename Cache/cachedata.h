@@ -2,7 +2,52 @@
 #define CACHEDATA_H
 
 #include <QtWidgets>
+#include <array>
 #include <atomic>
+#include <functional>
+
+/*
+    ImageCacheData is the decoded-image store shared by the ImageCache thread, every
+    ImageDecoder (via fillCache -> cacheImage) and the views on the GUI thread.
+
+    It used to be one QHash<QString, QImage> behind one QMutex, so every decoder insert,
+    every view lookup and every trimOutsideTargetRange serialised on the same lock. It is
+    now split into shardCount stripes, each a QHash + QMutex, selected by qHash(path).
+    Two operations on different paths contend only when they land in the same stripe.
+
+    contains() answers "no" without taking a lock: a counting presence filter (one atomic
+    counter per hash bucket, bumped on insert and dropped on remove) is checked first, and
+    only a non-zero bucket falls through to the stripe lock for an exact answer. Misses
+    are the common case for okToDecode / setTargetRange, which ask about rows that have
+    not been decoded yet.
+
+    Byte accounting lives here too. Every stripe keeps its own byte count and sizeBytes()
+    is their sum. maxBytes() is the ceiling ImageCache sets (maxMBCeiling), but the store
+    only checks it: removing an entry is ImageCache's call (trimOutsideTargetRange), as
+    only it keeps cacheItemList, toCache and the DataModel cached flag in step and knows
+    which row is current. insert() counts the inserts that leave the store over the
+    ceiling, so the diagnostics show when the target range sizing lags the decoders.
+
+    Entries must go through the API. There is no public hash any more; iterate with
+    keys() / forEach() and read with value().
+
+    Zero-copy handoff. One pixel buffer travels decoder -> done() -> fillCache ->
+    insert() -> value() -> QPixmap::fromImage in ImageView; every step is an implicitly
+    shared QImage and nobody writes to it, so nothing detaches. The one step that used to
+    copy was fromImage itself: it converts anything but the raster-native format (RGB32,
+    or ARGB32_Premultiplied with alpha) and first scans every ARGB32 pixel for alpha, on
+    the GUI thread. Raw and developed images are written as RGB32 by OutputTransform, and
+    toDisplayFormat() brings the rest there on the decoder thread, so fromImage shares
+    the buffer. CacheSizeColumn budgets 4 bytes a pixel, the size of the converted image.
+    ImageView reports each handoff through noteViewHandoff(); the copied count (ImageCache
+    diagnostics) should stay 0 while scrubbing.
+
+    Resolution tiers. An entry is either the full resolution decode or a REDUCED copy
+    sized for the loupe (see ImageCache::decodeEdge). A reduced entry carries the full
+    image size it stands in for (fullSize), so ImageView can present it at the full
+    logical size (ScaledPixmapItem) and ask for the full decode on zoom-in. Consumers
+    that need real pixels (export, stacking, Develop) check isReduced() first.
+*/
 
 class ImageCacheData : public QObject
 {
@@ -10,15 +55,57 @@ class ImageCacheData : public QObject
 public:
     explicit ImageCacheData(QObject *);
 
-    bool contains(const QString &key);
-    void insert(const QString &key, const QImage &image);
+    bool contains(const QString &key) const;
+    QImage value(const QString &key) const;     // null QImage if absent
+    /* fullSize (optional) receives the size a reduced entry stands in for, or an invalid
+       QSize when the entry is full resolution. Read together with the image, under the
+       same stripe lock, so an upgrade between two calls cannot mismatch them. */
+    bool find(const QString &key, QImage &image, QSize *fullSize = nullptr) const;
+    /* fullSize: invalid (default) = image is the full resolution decode; otherwise the
+       full size this reduced image stands in for. */
+    void insert(const QString &key, const QImage &image, QSize fullSize = QSize());
+    /* Swap in a reduced copy only if the entry still holds the image whose cacheKey() is
+       expectedCacheKey (it was not replaced or removed meanwhile). */
+    bool replaceIfUnchanged(const QString &key, qint64 expectedCacheKey,
+                            const QImage &image, QSize fullSize);
+    bool isReduced(const QString &key) const;   // false if absent or full resolution
     void remove(const QString &key);
+    QImage take(const QString &key, QSize *fullSize = nullptr);
+    bool rename(const QString &oldKey, const QString &newKey);
     void clear();
 
+    /* Remove every entry whose key satisfies pred; returns the removed keys. Each stripe
+       is visited under its own lock, so lookups on the other stripes keep running. */
+    QStringList removeIf(const std::function<bool(const QString &key)> &pred);
+
+    /* Visit every entry, one stripe at a time under that stripe's lock. fn must not call
+       back into this ImageCacheData. */
+    void forEach(const std::function<void(const QString &key, const QImage &image)> &fn) const;
+
+    QStringList keys() const;
+    int count() const noexcept { return entries.load(std::memory_order_relaxed); }
+    bool isEmpty() const noexcept { return count() == 0; }
+
+    /* Convert in place to the format QPixmap uses on the raster backend, so the view can
+       share the buffer; RGB32 and ARGB32_Premultiplied pass through. opaque is the
+       decoder's word that the source had no alpha (the ICC transform returns ARGB32 for
+       it): such an ARGB32 image is relabelled RGB32 without reading the pixels. Call on
+       the decoder thread, before the image is shared. */
+    static void toDisplayFormat(QImage &image, bool opaque);
+
+    // Zero-copy instrumentation: did ImageView's QPixmap share the cached buffer?
+    void noteViewHandoff(bool shared) noexcept;
+    quint64 viewHandoffsShared() const noexcept { return handoffShared.load(std::memory_order_relaxed); }
+    quint64 viewHandoffsCopied() const noexcept { return handoffCopied.load(std::memory_order_relaxed); }
+
+    // Byte ceiling, checked but not enforced (see above). 0 = unlimited.
+    void setMaxBytes(quint64 maxBytes) noexcept;
+    quint64 maxBytes() const noexcept { return budget.load(std::memory_order_relaxed); }
+    bool overBudget() const noexcept;
+    quint64 overBudgetCount() const noexcept { return overBudgetInserts.load(std::memory_order_relaxed); }
+
     // O(1) read, no lock needed
-    quint64 sizeBytes() const noexcept {
-        return bytes.load(std::memory_order_relaxed);
-    }
+    quint64 sizeBytes() const noexcept;
     // quint64 sizeMB() const noexcept {
     //     return static_cast<quint64>(sizeBytes() / (1024 * 1024));
     // }
@@ -26,16 +113,41 @@ public:
         return double(sizeBytes()) / (1024.0 * 1024.0);
     }
 
-    // image cache hash
-    QHash<QString, QImage> imCache;
-
-    // Was QReadWriteLock; replaced with QMutex because ThreadSanitizer
-    // cannot track QReadWriteLock as a synchronization primitive (false-
-    // positive races on imCache). Reads are infrequent enough that the
-    // simpler primitive is fine.
-    mutable QMutex rwLock;
+    static constexpr int shardCount = 16;       // power of two
 
 private:
-    std::atomic<quint64> bytes{0}; // total pixel bytes of images
+    struct Entry {
+        QImage image;
+        quint64 lastUse = 0;                    // useClock tick of last insert/lookup
+        QSize fullSize;                         // valid only for a reduced entry
+    };
+    // Each stripe on its own cache line so the lock words do not false-share.
+    struct alignas(64) Shard {
+        // Was QReadWriteLock; replaced with QMutex because ThreadSanitizer
+        // cannot track QReadWriteLock as a synchronization primitive (false-
+        // positive races on the hash).
+        mutable QMutex lock;
+        QHash<QString, Entry> hash;
+        std::atomic<quint64> bytes{0};          // total pixel bytes in this stripe
+    };
+
+    static constexpr int filterSize = 4096;     // presence filter buckets, power of two
+
+    static size_t hashKey(const QString &key) noexcept { return qHash(key); }
+    Shard &shardFor(size_t h) const noexcept { return shards[h & (shardCount - 1)]; }
+    std::atomic<quint32> &filterFor(size_t h) const noexcept {
+        // high bits, so the bucket is independent of the stripe selection
+        return filter[(h >> 8) & (filterSize - 1)];
+    }
+    quint64 tick() const noexcept { return useClock.fetch_add(1, std::memory_order_relaxed); }
+
+    mutable std::array<Shard, shardCount> shards;
+    mutable std::array<std::atomic<quint32>, filterSize> filter{};
+    mutable std::atomic<quint64> useClock{0};
+    std::atomic<int> entries{0};
+    std::atomic<quint64> budget{0};
+    std::atomic<quint64> overBudgetInserts{0};
+    std::atomic<quint64> handoffShared{0};
+    std::atomic<quint64> handoffCopied{0};
 };
 #endif // CACHEDATA_H
@@ -0,0 +1,56 @@
+#ifndef DECODEPRIORITY_H
+#define DECODEPRIORITY_H
+
+#pragma once
+#include <QList>
+#include <QtGlobal>
+#include <algorithm>
+#include <limits>
+
+/*
+    Decode order for ImageCache's toCache queue.
+
+    toCache used to be served in insertion order. setTargetRange appends rows the first
+    time it sees them, so after a jump the rows queued for the old position (still inside
+    the new, overlapping target range) sat in front of the new current image and its
+    neighbours. nextToCache now serves the queue by rank():
+
+        current row             0
+        ahead, distance d       2d          (ahead = direction of travel, isForward)
+        behind, distance d      4d - 1
+
+    so an ahead row is worth a behind row half its distance, the same 2:1 split
+    setTargetRange uses when it sizes the range (2/3 of maxMB ahead). Ranks are unique
+    (ahead even, behind odd), so the order is total and stable across calls.
+
+    Header only: ImageCache and tst_decodepriority share it.
+*/
+namespace Winnow::Cache {
+
+struct DecodePriority
+{
+    static constexpr int lowest = std::numeric_limits<int>::max();
+
+    static int rank(int sfRow, int currRow, bool isForward) noexcept
+    {
+        if (sfRow < 0 || currRow < 0) return lowest;
+        const int d = sfRow - currRow;
+        if (d == 0) return 0;
+        const bool ahead = isForward ? d > 0 : d < 0;
+        const qint64 dist = qAbs(qint64(d));
+        const qint64 r = ahead ? 2 * dist : 4 * dist - 1;
+        return r < lowest ? int(r) : lowest;
+    }
+
+    // Sort rows best first.
+    static void order(QList<int> &rows, int currRow, bool isForward)
+    {
+        std::stable_sort(rows.begin(), rows.end(), [=](int a, int b) {
+            return rank(a, currRow, isForward) < rank(b, currRow, isForward);
+        });
+    }
+};
+
+} // namespace Winnow::Cache
+
+#endif // DECODEPRIORITY_H
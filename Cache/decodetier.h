@@ -0,0 +1,57 @@
+#ifndef DECODETIER_H
+#define DECODETIER_H
+
+#pragma once
+#include <algorithm>
+
+/*
+    Which decode a raw file gets, and at what resolution.
+
+    Develop decodes the sensor data whenever Decode Raw is on (G::useRaw, which the mode
+    owns: setOperationMode turns it on entering Develop and off leaving it). Preview shows
+    the embedded preview unless "Decode raw in loupe" (G::useRawInLoupe) is on; then the
+    loupe shows the sensor decode too, and that is what the half size path is for:
+
+        Preview, fit to window      reduced: RawFormat demosaics 2x2 quads (RunHalfSize)
+        Preview, zoomed past it     full (requestFullResolution -> needsFull)
+        Develop                     full (needsFull: the pipeline, scopes and export)
+
+    Header only: ImageDecoder, ImageCache, RawFormat and tst_decodetier share it.
+*/
+namespace Winnow::Cache {
+
+struct DecodeTier
+{
+    // ImageDecoder::sensorDecodeActive: does a raw with a sensor decoder take RawFormat?
+    static bool sensorDecode(bool develop, bool useRaw, bool rawInLoupe) noexcept
+    {
+        return develop ? useRaw : rawInLoupe;
+    }
+
+    /* ImageCache::decodeEdge: long edge to reduce a fresh decode to, 0 for full resolution.
+       Off without the tiered cache or a known loupe size, and for a row that must be full.
+       Otherwise every row is reduced except the current one, which the loupe may zoom into
+       next -- unless it is a sensor decode, which fit to window costs a quarter of the
+       demosaic and upgrades on zoom like any reduced entry. */
+    static int reduceToEdge(int loupeEdge, bool tiered, bool needsFull,
+                            bool current, bool sensor) noexcept
+    {
+        if (!tiered || loupeEdge <= 0 || needsFull) return 0;
+        if (current && !sensor) return 0;
+        return loupeEdge;
+    }
+
+    /* RawFormat::Decode: take the half size path for a reduced decode of a Bayer mosaic
+       when half the sensor's long edge still covers the loupe. X-Trans quads are not
+       RGGB, and a "Denoise raw" decode builds a full develop base. */
+    static bool halfSize(int reduceToEdge, int sensorW, int sensorH,
+                         bool bayer, bool denoise) noexcept
+    {
+        return reduceToEdge > 0 && bayer && !denoise
+               && std::max(sensorW, sensorH) / 2 >= reduceToEdge;
+    }
+};
+
+} // namespace Winnow::Cache
+
+#endif // DECODETIER_H
@@ -0,0 +1,30 @@
+#include "Cache/draftjpeg.h"
+#include <QIODevice>
+#include <QImageReader>
+#include <algorithm>
+
+bool DraftJpeg::read(QIODevice *device, int edge, QImage &image, QSize &fullSize)
+{
+/*
+    Qt's JPEG handler passes a scaled size on to libjpeg, which runs the inverse DCT at
+    1/2, 1/4 or 1/8 size (entropy decoding still reads the whole scan, but IDCT,
+    upsampling and colour conversion shrink with the scale) and only smooth-scales the
+    small remainder.
+*/
+    image = QImage();
+    const qint64 start = device->pos();
+    QImageReader reader(device, "JPEG");
+    const QSize full = reader.size();
+    if (edge <= 0 || !full.isValid() || std::max(full.width(), full.height()) <= edge) {
+        device->seek(start);
+        return false;
+    }
+    reader.setScaledSize(full.scaled(edge, edge, Qt::KeepAspectRatio));
+    if (!reader.read(&image)) {
+        device->seek(start);
+        image = QImage();
+        return false;
+    }
+    fullSize = full;
+    return true;
+}
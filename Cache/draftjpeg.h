@@ -0,0 +1,35 @@
+#ifndef DRAFTJPEG_H
+#define DRAFTJPEG_H
+
+#include <QImage>
+#include <QSize>
+
+class QIODevice;
+
+/*
+    Scrubbing drafts of JPEG data (ImageCache::useDraftDecode): a JPEG, or a raw file's
+    embedded one, decoded straight to about the loupe size by libjpeg's DCT scaling
+    instead of decoded in full and scaled. ImageDecoder marks such a decode a draft,
+    which keeps it out of the disk preview tier and gets it replaced once scrubbing stops.
+
+    Two decoders can produce one: Qt's JPEG handler through read(), and on macOS JpegTurbo,
+    which DCT-scales whenever it is given a long side. isDraft() is the rule both paths
+    use to mark the result.
+*/
+namespace DraftJpeg {
+
+/* Decode device to edge on the long side through Qt's JPEG handler; fullSize receives the
+   size in the header. Returns false, leaving device rewound and image null, if the data
+   is not a readable JPEG or is no larger than edge. */
+bool read(QIODevice *device, int edge, QImage &image, QSize &fullSize);
+
+/* A decode of a full-size JPEG to decoded is a draft when one was wanted and the decoder
+   did scale: a JPEG already within the loupe size decodes in full on either path. */
+inline bool isDraft(bool wanted, const QSize &decoded, const QSize &full)
+{
+    return wanted && decoded.isValid() && full.isValid() && decoded != full;
+}
+
+} // namespace DraftJpeg
+
+#endif // DRAFTJPEG_H
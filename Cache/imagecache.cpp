@@ -1,8 +1,13 @@
 #include "Cache/imagecache.h"
 #include "Main/global.h"
 #include "Develop/workingimagecache.h"
+#include "Cache/previewdiskcache.h"
+#include "Cache/decodetier.h"
 #include "ImageFormats/Raw/rawformat.h"
+#include "ImageFormats/Heic/heicgrid.h"
 #include <QFileInfo>
+#include <QThreadPool>
+#include <cmath>
 
 /*  How the Image Cache works:
 
@@ -20,10 +25,12 @@
 Data structures:
 
     The image data structures are in a separate class ImageCacheData to facilitate
-    concurrent data access. The image cache for QImages reside in the hash table imCache.
-    This table is written to by cacheImage() and read by ImageView.  imCache is in a
-    separate class ImageCacheData, in an instance pointed to by *icd.  This is likely
-    unnecessary but has not been refactored.
+    concurrent data access. The image cache for QImages (imCache) is a sharded store:
+    ImageCacheData::shardCount stripes, each a hash + mutex, selected by the path hash,
+    so decoders and views only contend when they touch the same stripe. It is written to
+    by cacheImage() and read by ImageView, always through the ImageCacheData API, which
+    also owns the byte accounting and the hard budget (see cachedata.h). imCache lives
+    in an instance pointed to by *icd.
 
     The list toCache and hash toCacheStatus keep track of the datamodel rows to be cached,
     based on additions in the target range, and removals when cached.
@@ -148,6 +155,9 @@ ImageCache::ImageCache(QObject *parent,
 
     maxMB = 1000;  // maxMB change
 
+    // before/after timing of the decode scheduler (diagnostics: time to first pixel)
+    usePriorityScheduler = qEnvironmentVariableIntValue("WINNOW_INSERTION_ORDER") != 1;
+
     // create n decoder threads
     decoderCount = QThread::idealThreadCount();
     decoderMetadatas.reserve(decoderCount);
@@ -172,6 +182,8 @@ ImageCache::ImageCache(QObject *parent,
         decoderThreads.append(thread);
         cycling.append(false);
         decoderIsRaw.append(false);
+        decodingRow.append(-1);
+        schedulerCancelled.append(false);
     }
 
     pressureHistory.reserve(50);    // avoid reallocations
@@ -313,9 +325,9 @@ quint64 ImageCache::getImCacheSize()
 
     quint64 cacheMB = 0;
 
-    for (auto it = icd->imCache.constBegin(); it != icd->imCache.constEnd(); ++it) {
-        cacheMB += static_cast<quint64>(it.value().sizeInBytes()) / (1 << 20);
-    }
+    icd->forEach([&cacheMB](const QString &, const QImage &image) {
+        cacheMB += static_cast<quint64>(image.sizeInBytes()) / (1 << 20);
+    });
 
     if (debugCaching)
     {
@@ -411,6 +423,7 @@ void ImageCache::updateToCache()
     if (!abort) setDirection();
     if (!abort) setTargetRange(currRow);
     if (!abort) trimOutsideTargetRange();
+    if (!abort && usePriorityScheduler) cancelOutOfRangeDecodes();
 
     if (instance != dm->instance) {
         instance = dm->instance;
@@ -477,33 +490,28 @@ void ImageCache::trimOutsideTargetRange()
 
     // rows being removed
     removedFromCache.clear();
-    // path keys being removed
-    QVector<QString> keysToRemove;
 
-    {
-        QMutexLocker locker(&icd->rwLock);
-        for (auto it = icd->imCache.cbegin(); it != icd->imCache.cend(); ++it) {
-            const QString &fPath = it.key();
-            const int sfRow = dm->proxyRowFromPath(fPath, src);
-
-            // Not in datamodel anymore OR outside target range
-            const bool notInModel = !isValidKey(sfRow);          // (sfRow == -1)
-            const bool outOfRange = !notInModel && (sfRow < targetFirst || sfRow > targetLast);
-
-            if (notInModel || outOfRange) {
-                keysToRemove.append(fPath);
-                removedFromCache.append(sfRow);
-                emit setCached(sfRow, false, instance);
-            }
-        }
-        // release locker
-    }
+    // Removal happens inside the store, one stripe lock at a time, so decoders
+    // inserting into other stripes are not held up by the trim.
+    const QStringList removedKeys = icd->removeIf([&](const QString &fPath) {
+        const int sfRow = dm->proxyRowFromPath(fPath, src);
 
-    // Perform removals using the API (write-locked inside remove())
-    for (const auto &key : keysToRemove) {
-        icd->remove(key);
-        trimmedCount.fetch_add(1, std::memory_order_relaxed);
+        // Not in datamodel anymore OR outside target range
+        const bool notInModel = !isValidKey(sfRow);          // (sfRow == -1)
+        const bool outOfRange = !notInModel && (sfRow < targetFirst || sfRow > targetLast);
+
+        if (notInModel || outOfRange) {
+            removedFromCache.append(sfRow);
+            return true;
+        }
+        return false;
+    });
+    // signal after the stripe locks are released
+    for (int sfRow : std::as_const(removedFromCache)) {
+        emit setCached(sfRow, false, instance);
     }
+    trimmedCount.fetch_add(static_cast<quint64>(removedKeys.size()), std::memory_order_relaxed);
+    for (const QString &key : removedKeys) draftPaths.remove(key);
 
     if (instance != dm->instance) return;
 
@@ -553,6 +561,8 @@ inline void ImageCache::updateMotion(int key, bool isForwardNow) {
 
     const int dRows = key - lastKeyForMotion;
     const qint64 dt = t - lastMoveMs;
+    // a dispatch that is not a move (cache size change, pressure relief, settle)
+    if (dRows == 0) return;
 
     // only consider pure forward steps in the current direction
     if (isForwardNow && dRows == +1) {
@@ -804,12 +814,12 @@ void ImageCache::setTargetRange(int key)
         }
 
         const QString fPath = dm->valueSf(pos, 0, G::PathRole).toString();
-        imgMB = dm->sf->index(pos, G::CacheSizeColumn).data().toFloat();
+        imgMB = tierMB(pos, fPath);     // per resolution tier, see decodeEdge
         sumMB += imgMB;
         count++;
 
         // If not already queued to cache, then add to queue
-        if (!toCache.contains(pos) && !icd->contains(fPath)) {
+        if (!toCache.contains(pos) && (!icd->contains(fPath) || needsUpgrade(fPath))) {
             /*
             QString msg = "pos = " + QVariant(pos).toString();
             msg += " posMB = " + QVariant(posMB).toString();
@@ -840,6 +850,10 @@ void ImageCache::setTargetRange(int key)
         }
     };
 
+    // motion first: scrubbing decides what needsUpgrade asks of the rows queued below
+    updateMotion(key, isForward);
+    updateScrubbing();
+
     /* Develop mode: view/edit a SINGLE image at best quality. Forward read-ahead is a low priority
        here -- and each neighbour decode caches its own scene-linear WorkingImage, evicting the one
        the Develop pipeline needs (WorkingImageCache is small relative to a 50-60MP image). So target
@@ -881,7 +895,6 @@ void ImageCache::setTargetRange(int key)
             cushion = qAbs(nearestNotCached - key);
         }
         memChk();
-        updateMotion(key, isForward);
         relievePressure();
     }
     else {
@@ -976,10 +989,7 @@ void ImageCache::rename(QString oldPath, QString newPath)
 */
 {
     if (debugLog || G::isLogger) log("rename");
-    if (icd->contains(oldPath)) {
-        QImage image = icd->imCache.take(oldPath);  // Remove the old key-value pair
-        icd->imCache.insert(newPath, image);
-    }
+    icd->rename(oldPath, newPath);
 }
 
 void ImageCache::toCacheAppend(int sfRow)
@@ -1105,6 +1115,9 @@ void ImageCache::memChk()
                                         std::max<qint64>(minMB, capBudgetMB));
     }
 
+    // the store checks the ceiling on every insert (diagnostics: store budget)
+    icd->setMaxBytes(static_cast<quint64>(maxMBCeiling) << 20);
+
     /* Publish the memory the image cache still intends to claim (ceiling minus what it
        already holds) so DataModel's thumbnail budget can avoid double-counting it. */
     G::imageCacheHeadroomMB.store(
@@ -1165,6 +1178,7 @@ QString ImageCache::diagnostics()
     rpt << "\n\n";
     rpt << reportHealthChecks();
     rpt << reportMemoryFootprint();
+    rpt << reportDiskPreviewCache();
     rpt << reportMemoryWarnings();
     rpt << reportLifetimeCounters();
     rpt << reportCacheParameters();
@@ -1201,13 +1215,10 @@ QString ImageCache::reportHealthChecks()
     {
         quint64 sumBytes = 0;
         int n = 0;
-        {
-            QMutexLocker locker(&icd->rwLock);
-            for (auto it = icd->imCache.cbegin(); it != icd->imCache.cend(); ++it) {
-                sumBytes += static_cast<quint64>(it.value().sizeInBytes());
-                ++n;
-            }
-        }
+        icd->forEach([&](const QString &, const QImage &image) {
+            sumBytes += static_cast<quint64>(image.sizeInBytes());
+            ++n;
+        });
         const quint64 reported = icd->sizeBytes();
         const quint64 diff = (reported > sumBytes) ? reported - sumBytes
                                                    : sumBytes - reported;
@@ -1229,7 +1240,7 @@ QString ImageCache::reportHealthChecks()
     }
 
     // 2. imCache empty vs currMB > 0
-    if (icd->imCache.isEmpty() && icd->sizeBytes() > 0) {
+    if (icd->isEmpty() && icd->sizeBytes() > 0) {
         line("WARN", "imCache vs sizeBytes",
              QString("imCache is empty but sizeBytes() = %1")
                  .arg(Utilities::fitNumber(icd->sizeBytes(), 22)));
@@ -1333,6 +1344,16 @@ QString ImageCache::reportHealthChecks()
         line("WARN", "thread state", "thread not running but abort=false");
     }
 
+    /* 8. Store budget. The store does not evict (ImageCacheData): this flags the target
+          range sizing (tierMB) letting the decoders run past maxMBCeiling. */
+    {
+        const QString detail = QString("%1 of %2 MB, %3 inserts over")
+                                   .arg(icd->sizeMB(), 0, 'f', 1)
+                                   .arg(icd->maxBytes() >> 20)
+                                   .arg(icd->overBudgetCount());
+        line(icd->overBudget() ? "WARN" : "OK", "store budget", detail);
+    }
+
     rpt << "\n";
     return reportString;
 }
@@ -1357,6 +1378,37 @@ QString ImageCache::reportLifetimeCounters()
         << Utilities::fitNumber(lateDecodeCount.load(),   12) << "\n";
     rpt << "  hit attempt cap        : "
         << Utilities::fitNumber(attemptCapHitCount.load(),12) << "\n";
+    rpt << "  demoted to reduced     : "
+        << Utilities::fitNumber(demotedCount.load(),      12) << "\n";
+    rpt << "  zoom-in full requests  : "
+        << Utilities::fitNumber(fullResRequestCount.load(),12) << "\n";
+    rpt << "  loupe handoffs shared  : "
+        << Utilities::fitNumber(icd->viewHandoffsShared(),12) << "\n";
+    rpt << "  loupe handoffs copied  : "
+        << Utilities::fitNumber(icd->viewHandoffsCopied(),12)
+        << "   (pixel copies in QPixmap::fromImage; expect 0)\n";
+    rpt << "  scrubbing drafts       : "
+        << Utilities::fitNumber(draftCount.load(),        12) << "\n";
+    rpt << "  drafts backfilled      : "
+        << Utilities::fitNumber(draftBackfillCount.load(),12) << "\n";
+    rpt << "  scheduler cancelled    : "
+        << Utilities::fitNumber(cancelledCount.load(),    12)
+        << "   (in-flight decodes outside a new target range)\n";
+    rpt << "  scheduler preempted    : "
+        << Utilities::fitNumber(preemptedCount.load(),    12)
+        << "   (in-flight decodes freed for the current image)\n";
+    rpt << "  time to first pixel    : "
+        << (usePriorityScheduler ? "priority scheduler" : "insertion order")
+        << ", current image not yet cached when selected\n"
+        << "    (WINNOW_INSERTION_ORDER=1 runs the session in insertion order, to compare)\n";
+    const char *jumpLabel[] = {"1 row", "2-10 rows", "11-100 rows", "> 100 rows"};
+    for (int i = 0; i < int(firstPixel.size()); ++i) {
+        const FirstPixelStat &s = firstPixel[i];
+        rpt << "    jump " << QString(jumpLabel[i]).leftJustified(12)
+            << "n = " << QString::number(s.n).leftJustified(6)
+            << "avg = " << QString::number(s.n ? s.totMs / qint64(s.n) : 0).rightJustified(6) << " ms"
+            << "   max = " << QString::number(s.maxMs).rightJustified(6) << " ms\n";
+    }
     rpt << "\n";
     return reportString;
 }
@@ -1390,6 +1442,13 @@ QString ImageCache::reportCacheParameters()
     rpt << "maxMB                    = " << Utilities::fitNumber(maxMB, 14)            << "\n";
     rpt << "minMB                    = " << Utilities::fitNumber(minMB, 14)            << "\n";
     rpt << "maxMBCeiling             = " << Utilities::fitNumber(maxMBCeiling, 14)     << "\n";
+    rpt << "store budget (bytes)     = " << Utilities::fitNumber(icd->maxBytes(), 22) << "\n";
+    rpt << "store budget overruns    = " << icd->overBudgetCount() << "\n";
+    int reducedEntries = 0;
+    for (const QString &key : icd->keys()) if (icd->isReduced(key)) ++reducedEntries;
+    rpt << "resolution tiers         = " << (G::useTieredImageCache ? "on" : "off")
+        << "  loupe edge " << G::loupeEdgePx.load() << " px  "
+        << reducedEntries << " of " << icd->count() << " entries reduced\n";
     rpt << "G::availableMemoryMB     = " << Utilities::fitNumber(G::availableMemoryMB.load(), 14) << "\n";
     rpt << "memThrottle              = " << memThrottle << "\n";
     rpt << "maxAttemptsToCacheImage  = " << maxAttemptsToCacheImage << "\n";
@@ -1407,6 +1466,8 @@ QString ImageCache::reportCacheParameters()
     rpt << "sumStep                  = " << sumStep << "\n";
     rpt << "directionChangeThreshold = " << directionChangeThreshold << "\n";
     rpt << "isForward                = " << (isForward ? "true" : "false") << "\n";
+    rpt << "scrubbing (drafts)       = " << (scrubbing ? "true" : "false")
+        << "  (" << draftPaths.size() << " draft entries)\n";
 
     rpt << "\n";
     rpt << "targetFirst              = " << targetFirst << "\n";
@@ -1446,7 +1507,7 @@ QString ImageCache::reportCacheParameters()
 
     rpt << "\n";
     rpt << "toCache count            = " << toCache.count() << "\n";
-    rpt << "Cached count             = " << icd->imCache.count() << "\n";
+    rpt << "Cached count             = " << icd->count() << "\n";
     rpt << "cacheUpToDate            = " << (cacheUpToDate() ? "true" : "false") << "\n";
     rpt << "\n";
 
@@ -1512,6 +1573,8 @@ QString ImageCache::reportCacheDecoders()
         rpt.setFieldWidth(0);  rpt << "  " << decoders[id]->errMsg << "\n";
     }
     rpt.setFieldWidth(0);
+    // HEIC grid and thumbnail decode times (Heic::decodePrimaryImage, decodeThumbnail)
+    rpt << HeicGrid::report() << "\n";
     rpt << "\n";
     return reportString;
 }
@@ -1793,7 +1856,7 @@ QString ImageCache::reportImCache()
     QImage image;
     int mem = 0;
 
-    QStringList keys = icd->imCache.keys();
+    QStringList keys = icd->keys();
     if (keys.size() == 0) {
         rpt << "\nicd->imCache is empty";
         return reportString;
@@ -1813,7 +1876,7 @@ QString ImageCache::reportImCache()
         imRptItem.hashKey = i;
         imRptItem.fPath = keys.at(i);
         imRptItem.sfRow = dm->proxyRowFromPath(imRptItem.fPath, "ImageCache::reportImCache");
-        image = icd->imCache.value(keys.at(i));    // QHash<QString, QImage> imCache
+        image = icd->value(keys.at(i));
         imRptItem.w = image.width();
         imRptItem.h = image.height();
         imRptItem.mb = static_cast<float>(image.sizeInBytes() / (1 << 20));
@@ -1886,12 +1949,10 @@ QString ImageCache::reportImCacheRows()
     reportString = "";
     rpt.setString(&reportString);
     QList<int> imCacheRows;
-    auto it = icd->imCache.begin();
-    while (it != icd->imCache.end()) {
-        QString fPath = it.key();
+    const QStringList keys = icd->keys();
+    for (const QString &fPath : keys) {
         int sfRow = dm->proxyRowFromPath(fPath, "ImageCache::reportImCacheRows");
         imCacheRows.append(sfRow);
-        ++it;
     }
     rpt << "Cached:  ";
     // sort imCacheRows
@@ -2026,6 +2087,18 @@ void ImageCache::initialize()
     trimmedCount.store(0, std::memory_order_relaxed);
     lateDecodeCount.store(0, std::memory_order_relaxed);
     attemptCapHitCount.store(0, std::memory_order_relaxed);
+    demotedCount.store(0, std::memory_order_relaxed);
+    fullResRequestCount.store(0, std::memory_order_relaxed);
+    cancelledCount.store(0, std::memory_order_relaxed);
+    preemptedCount.store(0, std::memory_order_relaxed);
+    firstPixel.fill(FirstPixelStat());
+    firstPixelJump = -1;
+    draftCount.store(0, std::memory_order_relaxed);
+    draftBackfillCount.store(0, std::memory_order_relaxed);
+    draftPaths.clear();
+    scrubbing = false;
+    currentTierPath.clear();
+    fullResPath.clear();
 
     updateStatus(StatusAction::Clear, "ImageCache::initializeImageCache");
 
@@ -2141,6 +2214,7 @@ void ImageCache::memoryPause(quint64 footprintMB, quint64 capMB)
     const qint64 shrunkMB = std::max<qint64>(minMB, static_cast<qint64>(beforeMB * 0.70));
     maxMB = static_cast<quint64>(shrunkMB);
     maxMBCeiling = std::min<qint64>(maxMBCeiling, shrunkMB);
+    icd->setMaxBytes(static_cast<quint64>(maxMBCeiling) << 20);
 
     /* Recompute the (smaller) target range and evict everything outside it. Decoders are
        parked via the throttle flag, so this frees memory without immediately re-filling. */
@@ -2199,14 +2273,194 @@ QString ImageCache::reportMemoryWarnings()
     return reportString;
 }
 
+QString ImageCache::diskPreviewSignature(int sfRow) const
+{
+/*
+    Decode-pipeline signature for sfRow, matching what ImageDecoder::writeDiskPreview
+    stores: whether load() takes the sensor path (ImageDecoder::sensorDecodeActive).
+*/
+    const bool sensor = willUseSensorDecode(sfRow);
+    const int orientation = dm->sf->index(sfRow, G::OrientationColumn).data().toInt();
+    const int rotation = dm->sf->index(sfRow, G::RotationDegreesColumn).data().toInt();
+    return PreviewDiskCache::signatureFor(G::colorManage, sensor, orientation, rotation);
+}
+
+bool ImageCache::diskPreviewLookup(int sfRow, QImage &image, QSize &fullSize)
+{
+    PreviewDiskCache &disk = PreviewDiskCache::instance();
+    if (!disk.isEnabled() || !isValidKey(sfRow)) return false;
+    const QString fPath = dm->sf->index(sfRow, 0).data(G::PathRole).toString();
+    if (fPath.isEmpty()) return false;
+    return disk.get(fPath, diskPreviewSignature(sfRow), image, &fullSize);
+}
+
+bool ImageCache::needsFull(const QString &fPath) const
+{
+/*
+    Rows whose cache entry must be the full resolution decode: everything in Develop
+    (the pipeline, scopes and export read icd), and the current image once the loupe
+    has zoomed past its reduced copy (requestFullResolution).
+*/
+    return G::operationMode == G::OperationMode::Develop
+           || (!fullResPath.isEmpty() && fPath == fullResPath);
+}
+
+bool ImageCache::needsUpgrade(const QString &fPath) const
+{
+    if (!scrubbing && draftPaths.contains(fPath) && icd->contains(fPath)) return true;
+    return needsFull(fPath) && icd->isReduced(fPath);
+}
+
+bool ImageCache::useDraftDecode(const QString &fPath) const
+{
+/*
+    Decode fPath as a scrubbing draft? Every row while scrubbing, the current one too: at
+    ~14 fps it is behind the cursor before a full decode would land, and a draft on screen
+    beats a blank frame. Not for a row that must be full resolution.
+*/
+    return scrubbing && G::loupeEdgePx.load(std::memory_order_relaxed) > 0
+           && !needsFull(fPath);
+}
+
+void ImageCache::updateScrubbing()
+{
+/*
+    Called by setTargetRange after updateMotion. Scrubbing follows isRapidForward (the
+    same motion heuristic relievePressure uses) in Preview mode with the tiered cache on.
+    While it lasts, each step re-arms a settle timer; the last one to fire ends it.
+*/
+    scrubbing = draftWhileScrubbing && G::useTieredImageCache
+                && G::operationMode != G::OperationMode::Develop
+                && isRapidForward();
+    if (!scrubbing) return;
+    const int generation = ++scrubGeneration;
+    QTimer::singleShot(scrubSettleMs, this, [this, generation] {
+        if (generation == scrubGeneration) scrubSettled();
+    });
+}
+
+void ImageCache::scrubSettled()
+{
+/*
+    No step for scrubSettleMs: the user stopped. Drop out of draft mode and dispatch, so
+    setTargetRange queues the drafts (needsUpgrade) and the decoders backfill them,
+    current image first (DecodePriority).
+*/
+    if (!scrubbing) return;
+    if (debugLog || G::isLogger) log("scrubSettled", "drafts = " + QString::number(draftPaths.size()));
+    scrubbing = false;
+    forwardStreak = 0;          // stopped, so no longer rapid
+    dispatch();
+}
+
+int ImageCache::decodeEdge(int sfRow, const QString &fPath) const
+{
+/*
+    Long edge (device pixels) to reduce a fresh decode of sfRow to, or 0 for full
+    resolution. Only the current image is decoded full by default: it is the one the
+    loupe may zoom into next. Everything else is cached at loupe size (G::loupeEdgePx),
+    so a 45 MP frame costs a few MB instead of ~180 MB and the same maxMB covers many
+    more rows ahead of the cursor.
+
+    A raw the loupe shows from sensor data ("Decode raw in loupe" in Preview) is reduced
+    even when current: fit to window, RawFormat decodes it at half size (no full
+    demosaic), and zooming in asks for the full decode like any reduced entry
+    (requestFullResolution -> needsFull). The rule itself is DecodeTier::reduceToEdge.
+*/
+    const bool current = sfRow == currRow;
+    return Winnow::Cache::DecodeTier::reduceToEdge(
+        G::loupeEdgePx.load(std::memory_order_relaxed), G::useTieredImageCache,
+        needsFull(fPath), current, current && willUseSensorDecode(sfRow));
+}
+
+float ImageCache::tierMB(int sfRow, const QString &fPath) const
+{
+/*
+    The target range budget in setTargetRange sums what each row will actually occupy:
+    the full decode size (CacheSizeColumn) for a full resolution entry, or that scaled by
+    the square of the reduction for a reduced one. The reduction is derived from the
+    full size and the image aspect (Width/Height columns), so it needs no decoded image.
+*/
+    const float fullMB = dm->sf->index(sfRow, G::CacheSizeColumn).data().toFloat();
+    const int edge = G::loupeEdgePx.load(std::memory_order_relaxed);
+    bool reduced;
+    if (icd->contains(fPath)) reduced = icd->isReduced(fPath) && !needsFull(fPath);
+    else reduced = decodeEdge(sfRow, fPath) > 0;
+    if (!reduced || edge <= 0 || fullMB <= 0) return fullMB;
+
+    const float w = dm->sf->index(sfRow, G::WidthColumn).data().toFloat();
+    const float h = dm->sf->index(sfRow, G::HeightColumn).data().toFloat();
+    const float aspect = (w > 0 && h > 0) ? std::max(w, h) / std::min(w, h) : 1.5f;
+    const float longEdge = std::sqrt(fullMB * 262144.0f * aspect);  // see CacheSizeColumn
+    if (longEdge <= edge) return fullMB;
+    const float s = edge / longEdge;
+    return fullMB * s * s;
+}
+
+void ImageCache::demoteToReduced(const QString &fPath)
+{
+/*
+    The current image moved on: if its entry is the full resolution decode, replace it
+    with a loupe size copy so only the current image holds full resolution pixels. The
+    scale runs on the global pool, not this thread, and only lands if the entry is still
+    the same image (it may be trimmed or re-decoded meanwhile).
+*/
+    const int edge = G::loupeEdgePx.load(std::memory_order_relaxed);
+    if (!G::useTieredImageCache || edge <= 0 || fPath.isEmpty() || needsFull(fPath)) return;
+    QImage full;
+    QSize fullSize;
+    if (!icd->find(fPath, full, &fullSize) || fullSize.isValid()) return;
+    if (std::max(full.width(), full.height()) <= edge) return;
+
+    ImageCacheData *store = icd;
+    std::atomic<quint64> *demoted = &demotedCount;
+    QThreadPool::globalInstance()->start([store, demoted, fPath, full, edge] {
+        const QImage reduced = full.scaled(edge, edge, Qt::KeepAspectRatio,
+                                           Qt::SmoothTransformation);
+        if (store->replaceIfUnchanged(fPath, full.cacheKey(), reduced, full.size()))
+            demoted->fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
+void ImageCache::requestFullResolution(QString fPath)
+{
+/*
+    ImageView zoomed the current image past the resolution of its reduced cache entry.
+    Mark it as needing the full decode and re-dispatch: setTargetRange queues it again
+    (needsUpgrade) and cacheImage swaps the full image in; the setCached that follows
+    makes the loupe reload it in place.
+*/
+    if (debugLog || G::isLogger) log("requestFullResolution", fPath);
+    if (fPath.isEmpty() || fPath == fullResPath) return;
+    if (fPath != currentTierPath) return;           // stale request from a previous image
+    fullResPath = fPath;
+    if (!icd->isReduced(fPath)) return;             // already full (or not cached yet)
+    fullResRequestCount.fetch_add(1, std::memory_order_relaxed);
+    abort = false;
+    dispatch();
+}
+
+QString ImageCache::reportDiskPreviewCache()
+{
+    QString reportString;
+    QTextStream rpt;
+    rpt.setString(&reportString);
+    rpt << Utilities::centeredRptHdr('-', "Disk Preview Cache");
+    rpt << "\n";
+    rpt << PreviewDiskCache::instance().report();
+    rpt << "\n";
+    return reportString;
+}
+
 bool ImageCache::willUseSensorDecode(int sfRow) const
 {
 /*
     True when a decode of sfRow will take the memory-heavy full-sensor RAW path: Decode Raw
-    is on AND the file extension has a sensor decoder. With Decode Raw off, RAW files use the
-    embedded JPG (cheap), so this returns false and the concurrency cap does not apply.
+    is on in a mode that decodes sensor data (ImageDecoder::sensorDecodeActive) AND the file
+    extension has a sensor decoder. Otherwise RAW files use the embedded JPG (cheap), so this
+    returns false and the concurrency cap does not apply.
 */
-    if (!G::useRaw) return false;
+    if (!ImageDecoder::sensorDecodeActive()) return false;
     if (sfRow < 0 || sfRow >= dm->sf->rowCount()) return false;
     const QString fPath = dm->sf->index(sfRow, 0).data(G::PathRole).toString();
     const QString ext = QFileInfo(fPath).suffix().toLower();
@@ -2253,17 +2507,15 @@ QString ImageCache::reportMemoryFootprint()
     rpt << "\n";
     rpt << "  process footprint       : " << G::processFootprintMB() << " MB\n";
     rpt << "  memoryAbortMB cap        : " << G::memoryAbortMB << " MB\n";
-    int imCacheCount = 0;
-    {
-        QMutexLocker locker(&icd->rwLock);
-        imCacheCount = icd->imCache.count();
-    }
+    const int imCacheCount = icd->count();
     rpt << "  imageCache (imCache)     : " << icd->sizeMB()
         << " MB (" << imCacheCount << " images)\n";
     rpt << "  WorkingImageCache        : " << static_cast<qint64>(wic.currentBytes() / MB)
         << " MB (" << wic.count() << " entries, budget "
         << static_cast<qint64>(wic.maxBytes() / MB) << " MB)\n";
     rpt << "  Decode Raw (G::useRaw)   : " << (G::useRaw ? "ON" : "off") << "\n";
+    rpt << "  Decode raw in loupe      : " << (G::useRawInLoupe ? "ON" : "off")
+        << "  (Preview: half size until zoomed)\n";
     rpt << "  decoderCount             : " << decoderCount << "\n";
     rpt << "  active raw decodes       : " << activeRawDecodes.load(std::memory_order_relaxed)
         << " (peak " << peakActiveRawDecodes << ")\n";
@@ -2299,7 +2551,7 @@ void ImageCache::filterChange(QString currentImageFullPath, QString src)
         qDebug().noquote()
             << fun.leftJustified(col0Width, ' ')
             << "dm->sf->rowCount() =" << dm->sf->rowCount()
-            << "icd->imCache.count() =" << icd->imCache.count()
+            << "icd->count() =" << icd->count()
             << "currentImageFullPath =" << currentImageFullPath
             << "dm->fPathRowContains =" << dm->fPathRowContains(currentImageFullPath)
             << "currentImageFullPath =" << currentImageFullPath
@@ -2392,12 +2644,21 @@ void ImageCache::setCurrentPosition(QString fPath, QString src)
     // if (row == prevRow) return;
     // currRow = row;
 
+    const int fromRow = currRow;
     currRow = dm->proxyRowFromPath(fPath, fun);
 
     if (debugLog || G::isLogger || G::isFlowLogger) {
         QString msg = "row = " + QString::number(currRow) + " " + fPath;
         log("setCurrentPosition", msg);
     }
+
+    /* Resolution tiers: the image we are leaving gives up its full resolution entry and
+       a zoom-in request only holds for the image it was made on. */
+    if (fPath != currentTierPath) {
+        demoteToReduced(currentTierPath);
+        currentTierPath = fPath;
+        fullResPath.clear();
+    }
     if (debugCaching)
     {
         qDebug().noquote() << fun.leftJustified(col0Width, ' ')
@@ -2432,6 +2693,13 @@ void ImageCache::setCurrentPosition(QString fPath, QString src)
         return;
     }
 
+    // time to first pixel, stopped in cacheImage (a reduced entry counts: it is on screen)
+    if (icd->contains(fPath)) firstPixelJump = -1;
+    else {
+        firstPixelJump = qAbs(currRow - fromRow);
+        firstPixelTimer.start();
+    }
+
     abort = false;
     dispatch();
 }
@@ -2446,7 +2714,7 @@ bool ImageCache::okToDecode(int sfRow, int id, QString &msg)
 
     // already in imCache
     QString fPath = dm->sf->index(sfRow, 0).data(G::PathRole).toString();
-    if (icd->contains(fPath)) {
+    if (icd->contains(fPath) && !needsUpgrade(fPath)) {
         msg = "Already in imCache";
         return false;
     }
@@ -2515,8 +2783,9 @@ bool ImageCache::okToDecode(int sfRow, int id, QString &msg)
 int ImageCache::nextToCache(int id)
 {
 /*
-    The next image to cache is determined by traversing the toCache list in ascending
-    order to find the first one not currently being cached:
+    The next image to cache is determined by traversing the toCache list, ordered best
+    first by DecodePriority (current image, then ahead and behind by distance), to find
+    the first one not currently being cached:
 
     • isCaching is false and attempts < maxAttemptsToCacheImage.
 
@@ -2566,6 +2835,13 @@ int ImageCache::nextToCache(int id)
         return -1;
     }
 
+    /* Re-sorted on every call: setTargetRange, nullInImCache and requestFullResolution
+       append, so rows queued for an earlier position would otherwise be served ahead of
+       the current image after a jump. Sorting a few hundred ints is noise next to one
+       decode. */
+    if (usePriorityScheduler)
+        Winnow::Cache::DecodePriority::order(toCache, currRow, isForward);
+
     if (debugCaching)
     {
         qDebug().noquote()
@@ -2648,13 +2924,27 @@ void ImageCache::decodeNextImage(int id, int sfRow)
         return;
     }
 
+    /* On-disk preview tier (PreviewDiskCache): when this file was decoded on an earlier
+       visit its display preview is on disk, memory mapped here instead of launching the
+       decoder. Checked before the raw cap so a hit never takes a raw decode slot. */
+    const QString rowPath = dm->sf->index(sfRow, 0).data(G::PathRole).toString();
+    QImage diskPreview;
+    QSize diskFullSize;
+    QElapsedTimer diskTimer;
+    diskTimer.start();
+    /* A row that must be full resolution (Develop, or the loupe zoomed in) skips the disk
+       tier: its previews are capped at PreviewDiskCache::maxEdge. */
+    const bool diskHit = !needsFull(rowPath)
+                         && diskPreviewLookup(sfRow, diskPreview, diskFullSize);
+    const qint64 diskNs = diskTimer.nsecsElapsed();
+
     /* Raw-decode concurrency cap: bound how many full-sensor RAW decodes run at once so
        their combined float working set stays under the memory cap. Park this decoder if we
        are already at the limit; a finishing sensor decode (fillCache) frees a slot, and the
        remaining active decoders keep the pipeline full. Not applied to JPEG/HEIC or the
        Decode-Raw-off embedded-JPG path (willUseSensorDecode returns false), so that path is
        unchanged and runs at full concurrency. */
-    const bool sensorRaw = willUseSensorDecode(sfRow);
+    const bool sensorRaw = !diskHit && willUseSensorDecode(sfRow);
     if (sensorRaw) {
         const int limit = rawDecodeLimit(sfRow);
         if (activeRawDecodes.load(std::memory_order_relaxed) >= limit) {
@@ -2711,6 +3001,36 @@ void ImageCache::decodeNextImage(int id, int sfRow)
             ;
     }
 
+    /* Disk hit: hand the mapped preview to fillCache exactly as if decoder id had
+       returned it, so okToCache / cacheImage / nextToCache run unchanged. Queued rather
+       than called, so a long run of hits unwinds through the event loop instead of
+       recursing fillCache -> decodeNextImage -> fillCache. The slot's instance is stamped
+       the way ImageDecoder::decode would, for okToCache's instance check. */
+    if (diskHit) {
+        decoders[id]->instance = instance;
+        QMetaObject::invokeMethod(this, "fillCache", Qt::QueuedConnection,
+                                  Q_ARG(int, id),
+                                  Q_ARG(int, int(ImageDecoder::Success)),
+                                  Q_ARG(int, sfRow),
+                                  Q_ARG(QImage, diskPreview),
+                                  Q_ARG(QString, rowPath),
+                                  Q_ARG(qint64, diskNs),
+                                  Q_ARG(QSize, diskFullSize),
+                                  Q_ARG(bool, false));
+        return;
+    }
+
+    // resolution tier for this decode (decoder is idle: safe to set before invoking)
+    const bool draft = useDraftDecode(rowPath);
+    decoders[id]->draft = draft;
+    decoders[id]->reduceToEdge = draft ? G::loupeEdgePx.load(std::memory_order_relaxed)
+                                       : decodeEdge(sfRow, rowPath);
+    decodingRow[id] = sfRow;
+    schedulerCancelled[id] = false;
+    /* Cleared here, not in decode(): a cancel between this and the queued decode() running
+       (cancelOutOfRangeDecodes, preemptForCurrent) must not be lost. */
+    decoders[id]->clearAbort();
+
     if (!decoderThreads[id]->isRunning()) decoderThreads[id]->start();
 
     // emit decode(sfRow, instance);
@@ -2743,7 +3063,9 @@ void ImageCache::decodeNextImage(int id, int sfRow)
 
 void ImageCache::cacheImage(int id, int sfRow,
                             const QImage &doneImage,
-                            const QString &doneFPath)
+                            const QString &doneFPath,
+                            QSize doneFullSize,
+                            bool doneDraft)
 {
 /*
     Called from fillCache to insert a QImage that has been decoded into icd->imCache.
@@ -2779,12 +3101,26 @@ void ImageCache::cacheImage(int id, int sfRow,
 
     // cache the image (icd->insert handles locking, duplicates, and bytes accounting)
     if (!abort) {
+        /* Already cached by another decoder. The exceptions are a full resolution image
+           arriving for a reduced entry (requestFullResolution / Develop) and a normal
+           decode arriving for a scrubbing draft: they replace it. */
+        const bool isDraft = draftPaths.contains(fPath);
         if (icd->contains(fPath)) {
-            // Already cached by another decoder
-            return;
+            const bool upgradesReduced = !doneFullSize.isValid() && icd->isReduced(fPath);
+            const bool upgradesDraft = !doneDraft && isDraft;
+            if (!upgradesReduced && !upgradesDraft) return;
+            if (upgradesDraft) draftBackfillCount.fetch_add(1, std::memory_order_relaxed);
         }
-        icd->insert(fPath, doneImage);
+        icd->insert(fPath, doneImage, doneFullSize);
         cachedCount.fetch_add(1, std::memory_order_relaxed);
+        if (doneDraft) {
+            draftPaths.insert(fPath);
+            draftCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (isDraft) draftPaths.remove(fPath);
+        if (firstPixelJump >= 0 && fPath == currentTierPath) noteFirstPixel();
+        // a full decode for the current image that landed after the user moved on
+        if (!doneFullSize.isValid() && fPath != currentTierPath) demoteToReduced(fPath);
     }
 
      // remove from toCache
@@ -2896,20 +3232,12 @@ bool ImageCache::nullInImCache()
     QString src = "ImageCache::nullInImCache";
 
     bool isEmptyImage = false;
-    // Snapshot keys under the read lock so a concurrent clear()/insert()
-    // cannot rehash imCache mid-iteration (crash site).
-    QList<QString> paths;
-    {
-        QMutexLocker locker(&icd->rwLock);
-        paths = icd->imCache.keys();
-    }
+    // Snapshot keys (stripe by stripe, under each stripe lock) so a concurrent
+    // clear()/insert() cannot rehash the store mid-iteration (crash site).
+    const QStringList paths = icd->keys();
     for (const QString &path : paths) {
         // empty image in cache
-        QImage img;
-        {
-            QMutexLocker locker(&icd->rwLock);
-            img = icd->imCache.value(path);
-        }
+        const QImage img = icd->value(path);
         if (img.width() == 0) {
             int sfRow = dm->proxyRowFromPath(path, "ImageCache::nullInImCache");
             // add back to toCache list
@@ -2927,7 +3255,9 @@ void ImageCache::fillCache(int id,
                            int doneSfRow,
                            QImage doneImage,
                            QString doneFPath,
-                           qint64 doneMsToDecode)
+                           qint64 doneMsToDecode,
+                           QSize doneFullSize,
+                           bool doneDraft)
 {
 
     /*
@@ -2995,6 +3325,14 @@ void ImageCache::fillCache(int id,
         activeRawDecodes.fetch_sub(1, std::memory_order_relaxed);
     }
 
+    // decoder is off its row; a scheduler cancel does not cost the row an attempt
+    bool wasCancelled = false;
+    if (id >= 0 && id < decodingRow.size()) {
+        wasCancelled = schedulerCancelled[id];
+        decodingRow[id] = -1;
+        schedulerCancelled[id] = false;
+    }
+
     // Prefer the snapshot delivered via the done() signal (stable copy from emit time).
     // Fall back to live decoder state only for legacy callers that pass no snapshot
     // (sentinel doneStatus == -1), e.g. the invokeMethod-fail retry below.
@@ -3004,6 +3342,9 @@ void ImageCache::fillCache(int id,
     QImage effectiveImage = haveSnapshot ? doneImage    : decoders[id]->image;
     QString effectiveFPath= haveSnapshot ? doneFPath    : decoders[id]->fPath;
     qint64 effectiveMs    = haveSnapshot ? doneMsToDecode : decoders[id]->nsToDecode;
+    // resolution tier of the returned image, from the same snapshot
+    QSize effectiveFullSize = haveSnapshot ? doneFullSize   : decoders[id]->fullSize;
+    bool effectiveDraft     = haveSnapshot ? doneDraft      : decoders[id]->draft;
 
     if (debugCaching)
     {
@@ -3037,10 +3378,16 @@ void ImageCache::fillCache(int id,
                                << "isRunning =" << imageCacheThread.isRunning()
                 ;
         }
-        if (!abort) cacheImage(id, cacheRow, effectiveImage, effectiveFPath);
+        if (!abort) cacheImage(id, cacheRow, effectiveImage, effectiveFPath, effectiveFullSize,
+                               effectiveDraft);
         // calc average recent decoder time (not being used except reporting)
         decodeHistory(effectiveMs);
     }
+    else if (wasCancelled && isValidKey(cacheRow)) {
+        int attempts = dm->sf->index(cacheRow, G::AttemptsColumn).data().toInt();
+        emit setValSf(cacheRow, G::AttemptsColumn, qMax(0, attempts - 1), instance,
+                      "ImageCache::fillCache cancelled");
+    }
 
     // get next image to cache
     int toCacheKey = nextToCache(id);
@@ -3110,7 +3457,7 @@ void ImageCache::fillCache(int id,
                 return;
             }
 
-            bool moreAvailableToCache = icd->imCache.count() < dm->sf->rowCount();
+            bool moreAvailableToCache = icd->count() < dm->sf->rowCount();
             if (cushion < cushionLow && moreAvailableToCache) {
                 // qDebug() << "ImageCache::fillCache chk cushion =" << cushion;
                 ignorePressureRestraints = true;
@@ -3251,4 +3598,88 @@ void ImageCache::dispatch()
     emit updateIsRunning(true, true);   // (isRunning, showCacheLabel)
 
     if (!abort) launchDecoders("ImageCache::dispatch");
+    if (!abort && usePriorityScheduler) preemptForCurrent();
+}
+
+void ImageCache::cancelOutOfRangeDecodes()
+{
+/*
+    Called by updateToCache after trimOutsideTargetRange. A jump leaves decoders working
+    on rows the new target range no longer holds; their images would be trimmed on
+    arrival. Abort them so they come back through fillCache and take the new range.
+
+    ImageDecoder::abortProcessing only sets the decoder's atomic abort flag: a sensor
+    RAW decode notices it per demosaic row, other formats between pipeline stages, and
+    the decode returns Status::Abort (transient, see okToCache).
+*/
+    for (int id = 0; id < decoderCount; ++id) {
+        const int sfRow = decodingRow.at(id);
+        if (sfRow < 0 || schedulerCancelled.at(id)) continue;
+        if (sfRow >= targetFirst && sfRow <= targetLast) continue;
+        if (debugCaching)
+            qDebug().noquote() << QString("ImageCache::cancelOutOfRangeDecodes").leftJustified(col0Width, ' ')
+                               << "decoder" << QString::number(id).leftJustified(3)
+                               << "row =" << sfRow;
+        schedulerCancelled[id] = true;
+        decoders[id]->abortProcessing();
+        cancelledCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ImageCache::preemptForCurrent()
+{
+/*
+    Called by dispatch after launchDecoders. The current image ranks first in
+    nextToCache, so any free decoder takes it. When none is free (every decoder busy, or
+    the raw decode cap parked it) the decoder on the lowest priority row is aborted
+    instead of making the user wait for a neighbour's decode to finish; its fillCache
+    hands the decoder straight to the current row. One preemption at a time.
+*/
+    if (memoryThrottled.load(std::memory_order_relaxed)) return;
+    if (!toCacheStatus.contains(currRow) || toCacheStatus[currRow].isCaching) return;
+    if (dm->sf->index(currRow, G::MetadataStatusColumn).data().toInt() != G::MetaLoaded) return;
+    QString msg;
+    if (!okToDecode(currRow, -1, msg)) return;
+
+    // raw decode cap full: only a sensor decode frees the slot the current row needs
+    const bool rawSlotNeeded = willUseSensorDecode(currRow)
+        && activeRawDecodes.load(std::memory_order_relaxed) >= rawDecodeLimit(currRow);
+
+    int victim = -1;
+    int worst = 0;
+    for (int id = 0; id < decoderCount; ++id) {
+        if (schedulerCancelled.at(id)) return;         // one is already unwinding
+        if (!cycling.at(id)) {
+            if (!rawSlotNeeded) return;                 // a free decoder will take it
+            continue;
+        }
+        if (decodingRow.at(id) < 0) continue;           // disk tier hit, returns at once
+        if (rawSlotNeeded && !decoderIsRaw.at(id)) continue;
+        const int r = Winnow::Cache::DecodePriority::rank(decodingRow.at(id), currRow, isForward);
+        if (r > worst) {
+            worst = r;
+            victim = id;
+        }
+    }
+    if (victim == -1) return;
+
+    if (debugCaching)
+        qDebug().noquote() << QString("ImageCache::preemptForCurrent").leftJustified(col0Width, ' ')
+                           << "decoder" << QString::number(victim).leftJustified(3)
+                           << "row =" << decodingRow.at(victim)
+                           << "for current row" << currRow;
+    schedulerCancelled[victim] = true;
+    decoders[victim]->abortProcessing();
+    preemptedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ImageCache::noteFirstPixel()
+{
+    const qint64 ms = firstPixelTimer.elapsed();
+    const int j = firstPixelJump;
+    FirstPixelStat &s = firstPixel[j <= 1 ? 0 : j <= 10 ? 1 : j <= 100 ? 2 : 3];
+    s.n++;
+    s.totMs += ms;
+    s.maxMs = std::max(s.maxMs, ms);
+    firstPixelJump = -1;
 }
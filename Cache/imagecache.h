@@ -9,6 +9,7 @@
 #include "Metadata/metadata.h"
 #include "Image/pixmap.h"
 #include "Cache/imagedecoder.h"
+#include "Cache/decodepriority.h"
 #include "Utilities/MovingAvg.h"
 #include <algorithm>         // reqd to sort cache
 #include <QMutex>
@@ -16,6 +17,7 @@
 #include <QThread>
 #include <QWaitCondition>
 #include <QGradient>
+#include <array>
 #include <vector>
 
 #ifdef Q_OS_WIN
@@ -68,6 +70,7 @@ public:
     QString reportImCacheRows();
     QString reportToCacheRows();
     QString reportMemoryWarnings();
+    QString reportDiskPreviewCache();
     void debugRunStatus();
 
     bool isIdle();
@@ -115,14 +118,17 @@ public slots:
     void setMaxMB(quint64 mb);
 
     void updateInstance();
-    // doneStatus/doneSfRow/doneImage/doneFPath/doneMsToDecode are the snapshot
-    // carried by ImageDecoder::done; defaulted so non-signal callers still work.
+    void requestFullResolution(QString fPath);  // ImageView zoomed past a reduced entry
+    // doneStatus/doneSfRow/doneImage/doneFPath/doneMsToDecode/doneFullSize/doneDraft are
+    // the snapshot carried by ImageDecoder::done; defaulted so non-signal callers still work.
     void fillCache(int id,
                    int doneStatus = -1,
                    int doneSfRow = -1,
                    QImage doneImage = QImage(),
                    QString doneFPath = QString(),
-                   qint64 doneMsToDecode = 0);
+                   qint64 doneMsToDecode = 0,
+                   QSize doneFullSize = QSize(),
+                   bool doneDraft = false);
     void setCurrentPosition(QString path, QString src);
     void filterChange(QString currentImageFullPath, QString source = "");
     void cacheSizeChange();         // flag when cache size is changed in preferences
@@ -298,10 +304,71 @@ private:
     bool nullInImCache();
     void cacheImage(int id, int cacheKey,
                     const QImage &doneImage,
-                    const QString &doneFPath);  // make room and add image to imageCache
+                    const QString &doneFPath,
+                    QSize doneFullSize,
+                    bool doneDraft);            // make room and add image to imageCache
     bool cacheUpToDate();           // target range all cached
     void resetStaleIsCaching();
     void decodeNextImage(int id, int sfRow);   // launch decoder for the next image in cacheItemList
+    QString diskPreviewSignature(int sfRow) const;
+    bool diskPreviewLookup(int sfRow, QImage &image, QSize &fullSize);  // PreviewDiskCache hit?
+
+    /* Resolution tiers (see ImageCacheData). currentTierPath is the image the loupe is on,
+       fullResPath the one it zoomed into (needs the full decode even if cached reduced). */
+    QString currentTierPath;
+    QString fullResPath;
+    std::atomic<quint64> demotedCount{0};           // full entries scaled down on move
+    std::atomic<quint64> fullResRequestCount{0};    // zoom-in upgrades requested
+
+    /* Decode scheduler. toCache is served best first (decodepriority.h); after a jump the
+       in-flight decodes that fell out of the target range are cancelled and, when no
+       decoder is free for the current image, the lowest priority one is preempted.
+       decodingRow[id] is the row decoder id is on (-1 idle), tracked here because a
+       trimmed row loses its toCacheStatus entry. schedulerCancelled[id] marks a decode
+       aborted by the scheduler, so it is not counted against the row's attempts.
+       WINNOW_INSERTION_ORDER=1 in the environment turns it off for the session, serving
+       toCache in insertion order with no cancel or preempt: the old way, to time against. */
+    bool usePriorityScheduler = true;
+    QVector<int> decodingRow;
+    QVector<bool> schedulerCancelled;
+    std::atomic<quint64> cancelledCount{0};         // in-flight decodes outside a new range
+    std::atomic<quint64> preemptedCount{0};         // in-flight decodes freed for currRow
+    void cancelOutOfRangeDecodes();
+    void preemptForCurrent();
+
+    /* Time to first pixel: setCurrentPosition -> the current image landing in icd, for
+       selections that were not already cached, bucketed by rows jumped (1, 2-10, 11-100,
+       more). Reported in reportLifetimeCounters. */
+    struct FirstPixelStat {
+        quint64 n = 0;
+        qint64 totMs = 0;
+        qint64 maxMs = 0;
+    };
+    std::array<FirstPixelStat, 4> firstPixel;
+    QElapsedTimer firstPixelTimer;
+    int firstPixelJump = -1;                // rows jumped; -1 = not waiting
+    void noteFirstPixel();
+
+    /* Scrubbing drafts. While isRapidForward() holds (an arrow key held down) rows are
+       decoded as drafts (ImageDecoder::draft): JPEG data DCT-scaled straight to loupe
+       size. draftPaths are the cached entries that are drafts; once the motion stops
+       (scrubSettleMs after the last step) needsUpgrade queues them for a normal decode. */
+    bool draftWhileScrubbing = true;        // tuning knob
+    bool scrubbing = false;
+    int scrubSettleMs = 250;
+    int scrubGeneration = 0;                // invalidates stale settle timers
+    QSet<QString> draftPaths;
+    std::atomic<quint64> draftCount{0};             // draft decodes cached
+    std::atomic<quint64> draftBackfillCount{0};     // drafts replaced by a normal decode
+    void updateScrubbing();
+    void scrubSettled();
+    bool useDraftDecode(const QString &fPath) const;
+
+    bool needsFull(const QString &fPath) const;
+    bool needsUpgrade(const QString &fPath) const;  // needsFull but cached reduced, or a draft
+    int decodeEdge(int sfRow, const QString &fPath) const;   // 0 = full resolution
+    float tierMB(int sfRow, const QString &fPath) const;     // budget cost of sfRow
+    void demoteToReduced(const QString &fPath);
     void trimOutsideTargetRange();// define start and end key in the target range to cache
     bool anyDecoderCycling();        // All decoder status is ready
     void setDirection();            // caching direction
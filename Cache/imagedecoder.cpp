@@ -5,6 +5,9 @@
 #include "Develop/inputtransform.h"
 #include "Develop/outputtransform.h"
 #include "Develop/workingimagecache.h"
+#include "Cache/previewdiskcache.h"
+#include "Cache/draftjpeg.h"
+#include "Cache/decodetier.h"
 #include <memory>
 
 #ifdef Q_OS_MAC
@@ -122,9 +125,13 @@ bool ImageDecoder::isRunning() const
     return running.loadRelaxed();
 }
 
-void ImageDecoder::decode(int row, int instance)
+void ImageDecoder::clearAbort()
 {
     abort.storeRelease(0);
+}
+
+void ImageDecoder::decode(int row, int instance)
+{
     sfRow = row;                   // set early so fillCache has valid row
     this->instance = instance;
 
@@ -132,7 +139,7 @@ void ImageDecoder::decode(int row, int instance)
         status = Status::Failed;
         errMsg = dm->sf->isSuspended() ? "Proxy suspended." : "Row out of range.";
         setIdle();
-        emit done(threadId, int(status), sfRow, QImage(), QString(), 0);
+        emit done(threadId, int(status), sfRow, QImage(), QString(), 0, QSize(), false);
         return;
     }
 
@@ -144,6 +151,7 @@ void ImageDecoder::decode(int row, int instance)
     status = Status::Undefined;
     fPath = dm->sf->index(sfRow,0).data(G::PathRole).toString();
     image = QImage();
+    fullSize = QSize();
     errMsg = "";
     if (isLog || G::isLogger) G::log("ImageDecoder::decode", "sfRow = " + QString::number(sfRow));
 
@@ -163,7 +171,7 @@ void ImageDecoder::decode(int row, int instance)
         errMsg = "Instance clash.  New folder selected, processing old folder.";
         G::issueDedup("Comment", errMsg, "ImageDecoder::run", sfRow, fPath);
         setIdle();
-        emit done(threadId, int(status), sfRow, QImage(), fPath, 0);
+        emit done(threadId, int(status), sfRow, QImage(), fPath, 0, QSize(), false);
         if (isDebug)
         {
             QString fun = "ImageDecoder::decode instance clash";
@@ -192,10 +200,24 @@ void ImageDecoder::decode(int row, int instance)
                 << "ms =" << t.elapsed()
                 << fPath;
         }
+        // before colorManage, which hands back ARGB32 whether or not there is alpha
+        const bool opaque = !image.hasAlphaChannel();
         if (metadata->rotateFormats.contains(ext) && !abort.loadAcquire()) rotate();
         if (!abort.loadAcquire()) applyDevelop();
         if (G::colorManage && !abort.loadAcquire()) colorManage();
         if (image.isNull()) status = Status::Failed;
+        else if (!abort.loadAcquire()) {
+            /* raster-native format now, on this thread, so the loupe's QPixmap shares
+               the buffer instead of converting it on the GUI thread (see cachedata.h) */
+            ImageCacheData::toDisplayFormat(image, opaque);
+            /* decoded below full size (a draft, a half-size raw): fullSize was set by the
+               decode, before rotate() */
+            if (fullSize.isValid()
+                && (fullSize.width() > fullSize.height()) != (image.width() > image.height()))
+                fullSize.transpose();
+            writeDiskPreview();
+            reduce();
+        }
     }
     else {
         if (isDebug)
@@ -210,6 +232,10 @@ void ImageDecoder::decode(int row, int instance)
         }
     }
 
+    /* Cancelled (ImageCache scheduler or stop) after load() succeeded: the image skipped
+       the display conversion and tiering above, so report Abort rather than cache it. */
+    if (status == Status::Success && abort.loadAcquire()) status = Status::Abort;
+
     setIdle();
 
     nsToDecode = t.nsecsElapsed();
@@ -225,7 +251,7 @@ void ImageDecoder::decode(int row, int instance)
                   "ImageDecoder::decode", Qt::EditRole,
                   int(Qt::AlignRight | Qt::AlignVCenter));
 
-    emit done(threadId, int(status), sfRow, image, fPath, nsToDecode);
+    emit done(threadId, int(status), sfRow, image, fPath, nsToDecode, fullSize, draft);
 }
 
 bool ImageDecoder::load()
@@ -237,6 +263,8 @@ bool ImageDecoder::load()
     if (isLog || G::isLogger) G::log("ImageDecoder::load",
                "sfRow = " + QString::number(sfRow) + "  " + fPath);
     QString fun = "ImageDecoder::load";
+    const bool wantDraft = draft && reduceToEdge > 0;
+    draft = false;           // set again by the JPEG paths if the decode is a draft
     if (isDebug)
     {
         QString fun = "ImageDecoder::load";
@@ -302,7 +330,7 @@ bool ImageDecoder::load()
         lock-guarded getter -- cheaper and thread-safer than rebuilding the whole
         ImageMetadata, since UnpackCfa only consults rawInfo.
     */
-    if (G::operationMode == G::OperationMode::Develop && G::useRaw) {
+    if (sensorDecodeActive()) {
         if (std::unique_ptr<RawFormat> rawFormat = RawFormat::Create(ext)) {
             /* Reuse an already-decoded clean base (e.g. one MW::ensureRawDenoise
                published on select) instead of repeating the costly
@@ -312,7 +340,8 @@ bool ImageDecoder::load()
             if (auto cached = WorkingImageCache::instance().get(fPath);
                 cached && cached->sceneReferred && !abort.loadAcquire()) {
                 OutputTransform output;
-                if (output.ToImage(*cached, image)) {
+                if (output.ToImage(*cached, image, OutputTransform::Space::sRGB,
+                                   QImage::Format_RGB32)) {
                     decoderToUse = Raw;
                     developApplied = true;
                     imFile.close();
@@ -340,14 +369,19 @@ bool ImageDecoder::load()
                 const QString fp = fPath;
                 demProg = [this, row, fp](int d, int t){ emit demosaicProgress(row, fp, d, t); };
             }
+            /* A reduced decode (loupe fit to window) may take the half-size preview path;
+               it leaves work empty, so only a full decode becomes the cached base. */
+            rawFormat->SetReduceToEdge(reduceToEdge);
             if (rawFormat->Decode(imFile, rawMeta, image, &editParams, &abort, &work,
                                   false, demProg)) {
                 decoderToUse = Raw;
                 developApplied = true;   // RAW develops internally; skip the generic pass
+                /* reduce() takes the size before scaling from here, not from the half image */
+                if (rawFormat->DecodedHalfSize()) fullSize = rawFormat->SensorSize();
                 /* Cache the pre-develop WorkingImage so a later edit re-renders without
                    re-decoding/re-demosaicing (UnpackCfa+Demosaic+RawColor is the costly part;
                    Develop+OutputTransform that follow are cheap). */
-                WorkingImageCache::instance().put(fPath, work);
+                if (work) WorkingImageCache::instance().put(fPath, work);
                 imFile.close();
                 status = Status::Success;
                 emit setValSf(sfRow, G::RawRenderColumn, true, instance,
@@ -423,10 +457,15 @@ bool ImageDecoder::load()
         #endif
 
         #ifdef Q_OS_MAC
-        decoderToUse = QtImage;            // QtImage or TurboJpg or Rory
+        decoderToUse = TurboJpg;           // QtImage or TurboJpg or Rory
         if (decoderToUse == TurboJpg) {
+            /* DCT-scaled to no smaller than the cache tier; reduce() finishes the scale */
             JpegTurbo jpegTurbo;
-            image = jpegTurbo.decode(buf);
+            QSize jpgSize;
+            image = jpegTurbo.decode(buf, reduceToEdge, &jpgSize);
+            if (!image.isNull() && image.size() != jpgSize) fullSize = jpgSize;
+            // DCT-scaled by TurboJpg itself, so marked here rather than by readDraftJpeg
+            draft = DraftJpeg::isDraft(wantDraft, image.size(), jpgSize);
             if (image.isNull()) {
                 errMsg = "Could not read JPG because JpegTurbo::decode failed.";
                 G::issue("Warning", errMsg, "ImageDecoder::load", sfRow, fPath);
@@ -437,7 +476,10 @@ bool ImageDecoder::load()
         #endif
 
         if (decoderToUse == QtImage) {
-            if (!image.loadFromData(buf, "JPEG")) {
+            QBuffer draftBuf(&buf);
+            const bool drafted = wantDraft && draftBuf.open(QIODevice::ReadOnly)
+                                 && readDraftJpeg(&draftBuf);
+            if (!drafted && !image.loadFromData(buf, "JPEG")) {
                 errMsg = "Could not read JPG because QImage::loadFromData failed.";
                 G::issue("Warning", errMsg, "ImageDecoder::load", sfRow, fPath);
                 imFile.close();
@@ -573,10 +615,13 @@ bool ImageDecoder::load()
         decoderToUse = QtImage;
         #endif
         #ifdef Q_OS_MAC
-        decoderToUse = QtImage;            // QtImage or TurboJpg or Rory
+        decoderToUse = TurboJpg;           // QtImage or TurboJpg or Rory
         if (decoderToUse == TurboJpg) {
             JpegTurbo jpegTurbo;
-            image = jpegTurbo.decode(fPath);
+            QSize jpgSize;
+            image = jpegTurbo.decode(fPath, reduceToEdge, &jpgSize);
+            if (!image.isNull() && image.size() != jpgSize) fullSize = jpgSize;
+            draft = DraftJpeg::isDraft(wantDraft, image.size(), jpgSize);
             if (image.isNull()) {
                 errMsg = "Could not read because TurboJpg decoder failed.";
                 G::issue("Warning", errMsg, "ImageDecoder::load", sfRow, fPath);
@@ -599,8 +644,10 @@ bool ImageDecoder::load()
         }
 
         if (decoderToUse == QtImage) {
-            imFile.close();
-            image.load(fPath);  // crash 2024-11-23 EXC_BAD_ACCESS (SIGSEGV)
+            if (!(wantDraft && readDraftJpeg(&imFile))) {
+                imFile.close();
+                image.load(fPath);  // crash 2024-11-23 EXC_BAD_ACCESS (SIGSEGV)
+            }
             if (image.isNull()) {
                 errMsg = "Could not read because Qt decoder failed.";
                 G::issue("Warning", errMsg, "ImageDecoder::load", sfRow, fPath);
@@ -748,7 +795,59 @@ void ImageDecoder::applyDevelop()
 
     /* Re-render through Develop + OutputTransform. render() copies the cached image (Develop
        mutates in place) and leaves the cache entry pristine for the next slider value. */
-    WorkingImageCache::render(*work, editParams, image);
+    WorkingImageCache::render(*work, editParams, image, nullptr,
+                              WorkingImageCache::OutDepth::Display);
+}
+
+void ImageDecoder::writeDiskPreview()
+{
+/*
+    Save the finished (rotated, colour managed) image to the on-disk preview tier so the
+    next visit to this folder is served by ImageCache::decodeNextImage from disk instead
+    of another decode. The signature must match ImageCache::diskPreviewSignature.
+*/
+    PreviewDiskCache &disk = PreviewDiskCache::instance();
+    if (!disk.isEnabled() || status != Status::Success || draft) return;
+    const int orientation = dm->sf->index(sfRow, G::OrientationColumn).data().toInt();
+    const int rotation = dm->sf->index(sfRow, G::RotationDegreesColumn).data().toInt();
+    const QString sig = PreviewDiskCache::signatureFor(G::colorManage, decoderToUse == Raw,
+                                                       orientation, rotation);
+    disk.put(fPath, sig, image, fullSize);
+}
+
+bool ImageDecoder::sensorDecodeActive()
+{
+    return Winnow::Cache::DecodeTier::sensorDecode(
+        G::operationMode == G::OperationMode::Develop, G::useRaw, G::useRawInLoupe);
+}
+
+void ImageDecoder::reduce()
+{
+/*
+    Reduced cache tier: scale the finished image down to the loupe size requested by
+    ImageCache (reduceToEdge) here on the decoder thread, so the cache holds a fraction of
+    the bytes and the ImageCache thread never pays for the scale. Images that already fit
+    are left alone and stay full resolution.
+*/
+    if (reduceToEdge <= 0 || status != Status::Success) return;
+    if (std::max(image.width(), image.height()) <= reduceToEdge) return;
+    if (!fullSize.isValid()) fullSize = image.size();
+    image = image.scaled(reduceToEdge, reduceToEdge, Qt::KeepAspectRatio,
+                         Qt::SmoothTransformation);
+}
+
+bool ImageDecoder::readDraftJpeg(QIODevice *device)
+{
+/*
+    Scrubbing draft through Qt's JPEG handler (DraftJpeg::read). Returns false, leaving
+    the device rewound, if the data is not a readable JPEG or is already small, so the
+    caller falls back to its normal decode.
+*/
+    QSize full;
+    if (!DraftJpeg::read(device, reduceToEdge, image, full)) return false;
+    fullSize = full;
+    draft = true;
+    return true;
 }
 
 void ImageDecoder::colorManage()
@@ -47,7 +47,16 @@ public:
                                                          std::shared_ptr<const WorkingImage> *outClean = nullptr,
                                                          bool *outDenoiseApplied = nullptr);
 
+    /* Does a RAW file with a sensor decoder take the RawFormat path in the current mode?
+       Develop with Decode Raw on, Preview with G::useRawInLoupe (DecodeTier). Shared with
+       ImageCache so its disk preview signature and resolution tier agree with load(). */
+    static bool sensorDecodeActive();
+
     bool isRunning() const;
+    /* Re-arm the abort flag for the next decode. ImageCache::decodeNextImage calls it
+       before queueing decode(), which never clears the flag itself: an abortProcessing()
+       that lands while decode() is still queued must stop that decode. */
+    void clearAbort();
     void setIdle();
     void setBusy();
     bool isIdle();
@@ -60,6 +69,19 @@ public:
     QString fPath;
     QString errMsg;
     qint64 nsToDecode;
+    /* Resolution tier (see ImageCacheData). reduceToEdge is set by
+       ImageCache::decodeNextImage before each decode: 0 decodes at full resolution,
+       otherwise the finished image is scaled so its long edge fits. fullSize reports the
+       outcome: the size before scaling, or invalid if the image was not reduced. Sent with
+       the image in done(). */
+    int reduceToEdge = 0;
+    QSize fullSize;
+    /* Draft decode while scrubbing (ImageCache::useDraftDecode). Set with reduceToEdge:
+       JPEG data (embedded previews included) is decoded straight to reduceToEdge by
+       libjpeg's DCT scaling instead of decoded in full and scaled. Left true after the
+       decode only if the image is such a draft; formats without a scaled decode path
+       clear it. A draft is never written to the disk preview tier. */
+    bool draft = false;
     /* Progress sink for the RAW demosaic, set by decodeIndependent and forwarded to
        RawFormat::Decode by load(). Empty for all other decode paths. */
     std::function<void(int, int)> decodeProgress;
@@ -127,8 +149,11 @@ signals:
     // doneStatus / doneSfRow / doneImage / doneFPath snapshot the decoder state at emit time.
     // Qt copies these into the queued event, so the consumer on imageCacheThread sees a
     // stable view even if the decoder has already started the next decode() on its thread.
+    // doneFullSize / doneDraft are the image's resolution tier (fullSize, draft), carried
+    // with it for the same reason.
     void done(int threadId, int doneStatus, int doneSfRow,
-              QImage doneImage, QString doneFPath, qint64 doneMsToDecode);
+              QImage doneImage, QString doneFPath, qint64 doneMsToDecode,
+              QSize doneFullSize, bool doneDraft);
     /* Per-tile progress of the in-house RAW demosaic (cache-mode decode). ImageCache
        relays it to MW, which shows a "Demosaic" status-bar row for the current image
        while a Winnow raw decodes with Auto-run denoise off (MW::onDemosaicProgress). */
@@ -148,6 +173,9 @@ private:
     void rotate();
     void applyDevelop();
     void colorManage();
+    void writeDiskPreview();
+    void reduce();
+    bool readDraftJpeg(QIODevice *device);
     bool idle = true;
     QAtomicInt abort {0};
     DataModel *dm;
@@ -0,0 +1,287 @@
+#include "Cache/previewdiskcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'P', 'V', '1'};
+constexpr quint32 kVersion = 2;            // 2: full size of a downscaled preview
+constexpr qint64 kHeaderBytes = 64;         // pixels start 64-byte aligned in the mapping
+const QString kSuffix = ".wpv";
+
+struct Header {
+    char magic[4];
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint64 bytesPerLine;
+    qint32 format;                          // QImage::Format
+    qint32 fullWidth;                       // source size when downscaled, else 0
+    qint32 fullHeight;
+};
+static_assert(sizeof(Header) <= kHeaderBytes, "preview header must fit its slot");
+
+qint64 nowMs() { return QDateTime::currentMSecsSinceEpoch(); }
+
+// QImage cleanup: closing the QFile drops the mapping the pixels live in.
+void unmapPreview(void *info) { delete static_cast<QFile *>(info); }
+
+} // namespace
+
+PreviewDiskCache &PreviewDiskCache::instance()
+{
+    static PreviewDiskCache cache;
+    return cache;
+}
+
+PreviewDiskCache::PreviewDiskCache()
+{
+    dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/previews";
+}
+
+QString PreviewDiskCache::signatureFor(bool colorManaged, bool sensorDecode,
+                                       int orientation, int rotationDegrees)
+{
+    return QString("cm%1 raw%2 o%3 r%4 v%5")
+        .arg(int(colorManaged)).arg(int(sensorDecode))
+        .arg(orientation).arg(rotationDegrees).arg(kVersion);
+}
+
+QString PreviewDiskCache::fileFor(const QString &fPath, const QString &signature) const
+{
+    const QFileInfo info(fPath);
+    const QString key = fPath + '|'
+                        + QString::number(info.lastModified().toMSecsSinceEpoch()) + '|'
+                        + QString::number(info.size()) + '|'
+                        + signature;
+    return QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex() + kSuffix;
+}
+
+bool PreviewDiskCache::get(const QString &fPath, const QString &signature, QImage &out,
+                           QSize *fullSize)
+{
+    if (!isEnabled()) return false;
+    QElapsedTimer t;
+    t.start();
+
+    const QString name = fileFor(fPath, signature);
+    QString path;
+    {
+        QMutexLocker lock(&mutex);
+        if (!scanned) scanLocked();
+        auto it = index.find(name);
+        if (it == index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        it->lastUseMs = nowMs();
+        path = dir + "/" + name;
+    }
+
+    auto dropEntry = [&] {
+        QMutexLocker lock(&mutex);
+        if (auto it = index.find(name); it != index.end()) {
+            totalBytes -= it->bytes;
+            index.erase(it);
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    auto *file = new QFile(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < kHeaderBytes) {
+        delete file;
+        dropEntry();
+        return false;
+    }
+    const uchar *map = file->map(0, file->size());
+    Header h;
+    if (map) std::memcpy(&h, map, sizeof(Header));
+    const bool valid = map
+                       && std::memcmp(h.magic, kMagic, 4) == 0
+                       && h.version == kVersion
+                       && h.width > 0 && h.height > 0
+                       && h.format > QImage::Format_Invalid && h.format < QImage::NImageFormats
+                       && h.bytesPerLine > 0
+                       && kHeaderBytes + h.bytesPerLine * h.height <= file->size();
+    if (!valid) {
+        delete file;
+        QFile::remove(path);                // corrupt or from another version
+        dropEntry();
+        return false;
+    }
+
+    // const data: any write to the QImage detaches instead of touching the mapping
+    out = QImage(map + kHeaderBytes, h.width, h.height, h.bytesPerLine,
+                 static_cast<QImage::Format>(h.format), unmapPreview, file);
+    if (fullSize) *fullSize = (h.fullWidth > 0 && h.fullHeight > 0)
+                                  ? QSize(h.fullWidth, h.fullHeight) : QSize();
+    // persist the LRU position across restarts (scanLocked reads mtime)
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    hits.fetch_add(1, std::memory_order_relaxed);
+    readNs.fetch_add(t.nsecsElapsed(), std::memory_order_relaxed);
+    return true;
+}
+
+void PreviewDiskCache::put(const QString &fPath, const QString &signature, const QImage &image,
+                           const QSize &fullSize)
+{
+    if (!isEnabled() || image.isNull()) return;
+
+    QImage im = image;
+    const int maxPx = maxEdge();
+    if (maxPx > 0 && std::max(im.width(), im.height()) > maxPx)
+        im = image.scaled(maxPx, maxPx, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    const QString name = fileFor(fPath, signature);
+    const QString folder = directory();
+    QDir().mkpath(folder);
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.width = im.width();
+    h.height = im.height();
+    h.bytesPerLine = im.bytesPerLine();
+    h.format = int(im.format());
+    const QSize full = fullSize.isValid() ? fullSize : image.size();
+    if (im.size() != full) {
+        h.fullWidth = full.width();
+        h.fullHeight = full.height();
+    }
+    QByteArray header(kHeaderBytes, '\0');
+    std::memcpy(header.data(), &h, sizeof(Header));
+
+    QSaveFile f(folder + "/" + name);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(header);
+    f.write(reinterpret_cast<const char *>(im.constBits()), im.sizeInBytes());
+    if (!f.commit()) return;
+
+    const qint64 bytes = kHeaderBytes + im.sizeInBytes();
+    QMutexLocker lock(&mutex);
+    if (!scanned) scanLocked();
+    Entry &e = index[name];
+    totalBytes += bytes - e.bytes;
+    e.bytes = bytes;
+    e.lastUseMs = nowMs();
+    writes.fetch_add(1, std::memory_order_relaxed);
+    trimLocked();
+}
+
+void PreviewDiskCache::scanLocked()
+{
+    index.clear();
+    totalBytes = 0;
+    const QFileInfoList files = QDir(dir).entryInfoList({"*" + kSuffix}, QDir::Files);
+    for (const QFileInfo &fi : files) {
+        index.insert(fi.fileName(), {fi.size(), fi.lastModified().toMSecsSinceEpoch()});
+        totalBytes += fi.size();
+    }
+    scanned = true;
+}
+
+void PreviewDiskCache::trimLocked()
+{
+/*
+    Delete least recently used previews until the folder fits the budget. Runs under the
+    index mutex; deletes are cheap next to the write that triggered them. A file that
+    cannot be removed (Windows refuses while a QImage still maps it) is dropped from the
+    index anyway and picked up again by the next scan.
+*/
+    while (totalBytes > budget && !index.isEmpty()) {
+        auto oldest = index.begin();
+        for (auto it = index.begin(); it != index.end(); ++it)
+            if (it->lastUseMs < oldest->lastUseMs) oldest = it;
+        QFile::remove(dir + "/" + oldest.key());
+        totalBytes -= oldest->bytes;
+        index.erase(oldest);
+        trims.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void PreviewDiskCache::clear()
+{
+    QMutexLocker lock(&mutex);
+    const QFileInfoList files = QDir(dir).entryInfoList({"*" + kSuffix}, QDir::Files);
+    for (const QFileInfo &fi : files) QFile::remove(fi.absoluteFilePath());
+    index.clear();
+    totalBytes = 0;
+    scanned = true;
+}
+
+void PreviewDiskCache::setEnabled(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void PreviewDiskCache::setMaxBytes(qint64 bytes)
+{
+    QMutexLocker lock(&mutex);
+    budget = std::max<qint64>(0, bytes);
+    if (scanned) trimLocked();
+}
+
+qint64 PreviewDiskCache::maxBytes() const
+{
+    QMutexLocker lock(&mutex);
+    return budget;
+}
+
+void PreviewDiskCache::setMaxEdge(int px)
+{
+    edge.store(px, std::memory_order_relaxed);
+}
+
+void PreviewDiskCache::setDirectory(const QString &d)
+{
+    QMutexLocker lock(&mutex);
+    if (d == dir) return;
+    dir = d;
+    scanned = false;                    // rescan lazily on next access
+}
+
+QString PreviewDiskCache::directory() const
+{
+    QMutexLocker lock(&mutex);
+    return dir;
+}
+
+QString PreviewDiskCache::report()
+{
+    QString reportString;
+    QTextStream rpt(&reportString);
+    qint64 bytes = 0, cap = 0;
+    int files = 0;
+    QString folder;
+    {
+        QMutexLocker lock(&mutex);
+        if (isEnabled() && !scanned) scanLocked();
+        bytes = totalBytes;
+        cap = budget;
+        files = index.size();
+        folder = dir;
+    }
+    const quint64 h = hits.load(std::memory_order_relaxed);
+    const quint64 m = misses.load(std::memory_order_relaxed);
+    const double avgMs = h ? readNs.load(std::memory_order_relaxed) / 1e6 / double(h) : 0.0;
+    rpt << "  disk preview cache       : " << (isEnabled() ? "ON" : "off") << "  "
+        << (bytes >> 20) << " of " << (cap >> 20) << " MB (" << files << " previews, "
+        << "max edge " << maxEdge() << " px)\n";
+    rpt << "  disk preview hits/misses : " << h << " / " << m
+        << "  (avg hit " << QString::number(avgMs, 'f', 2) << " ms)"
+        << "  writes " << writes.load(std::memory_order_relaxed)
+        << "  trimmed " << trims.load(std::memory_order_relaxed) << "\n";
+    rpt << "  disk preview folder      : " << folder << "\n";
+    return reportString;
+}
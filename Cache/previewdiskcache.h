@@ -0,0 +1,105 @@
+#ifndef PREVIEWDISKCACHE_H
+#define PREVIEWDISKCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QImage>
+#include <atomic>
+
+/*
+    Second, on-disk tier behind ImageCache: display-resolution previews of decoded
+    images, so re-opening a recently culled folder fills the target range at disk-read
+    speed instead of decode speed (a RAW folder otherwise re-runs ImageDecoder::load for
+    every frame, because ImageCache::initialize drops every QImage on a folder change).
+
+    Optional (G::useDiskPreviewCache, Preferences > Productivity) and size capped
+    (G::diskPreviewCacheMB) with LRU trimming.
+
+    Key. One file per preview, named by a hash of
+        path + mtime + size + signature
+    where signature (signatureFor) captures everything else that changes the decoded
+    pixels: colour management, the sensor vs embedded-JPG path, orientation and user
+    rotation. A file edited in place changes mtime/size and so simply misses; its stale
+    entry ages out through the LRU.
+
+    Layout. A fixed 64-byte header (magic, version, width, height, bytesPerLine, QImage
+    format, and the full size when the preview was scaled down) followed by the raw scanlines, so get() can memory-map the file and wrap the
+    mapping in a QImage without reading or copying a single pixel up front. The kernel
+    pages the pixels in as the view first touches them. The mapping stays alive as long
+    as any QImage shares it (the QImage cleanup function closes the file).
+
+    Writes go through QSaveFile (write to temp, rename) from the decoder threads, so a
+    crash mid-write never leaves a truncated preview behind. Previews larger than
+    maxEdge() on their long side are scaled down before writing: this is a browse
+    accelerator, not an archive of full-resolution decodes.
+
+    Process-wide singleton (like WorkingImageCache). Thread-safe: the index is guarded
+    by one mutex; preview reads and writes run outside it, LRU deletes run under it.
+*/
+class PreviewDiskCache
+{
+public:
+    static PreviewDiskCache &instance();
+
+    /* Signature of the decode pipeline state that produced an image. Both the lookup
+       (ImageCache::decodeNextImage) and the write (ImageDecoder::decode) must build it
+       from the same inputs or every lookup misses. */
+    static QString signatureFor(bool colorManaged, bool sensorDecode,
+                                int orientation, int rotationDegrees);
+
+    /* Memory-mapped preview for fPath, or false on a miss. A hit refreshes the entry's
+       LRU position (on disk too, so it survives a restart). fullSize receives the size
+       of the decode the preview was scaled down from, or an invalid QSize if it was
+       stored at full resolution (ImageCacheData's reduced-tier convention). */
+    bool get(const QString &fPath, const QString &signature, QImage &out,
+             QSize *fullSize = nullptr);
+
+    /* Store a preview (scaled to maxEdge() if larger) and trim to the byte budget.
+       fullSize, when valid, is the size image itself was decoded down from (a half-size
+       raw). No-op when disabled or image is null. */
+    void put(const QString &fPath, const QString &signature, const QImage &image,
+             const QSize &fullSize = QSize());
+
+    void clear();                       // delete every preview file
+
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setMaxBytes(qint64 bytes);     // smaller budget trims immediately
+    qint64 maxBytes() const;
+    void setMaxEdge(int px);            // long-edge cap for stored previews
+    int maxEdge() const { return edge.load(std::memory_order_relaxed); }
+    void setDirectory(const QString &dir);
+    QString directory() const;
+
+    QString report();                   // summary row for ImageCache::diagnostics()
+
+private:
+    PreviewDiskCache();
+    QString fileFor(const QString &fPath, const QString &signature) const;
+    void scanLocked();                  // build the index from the directory once
+    void trimLocked();                  // delete LRU files until under budget
+
+    struct Entry {
+        qint64 bytes = 0;
+        qint64 lastUseMs = 0;
+    };
+
+    mutable QMutex mutex;
+    QString dir;
+    QHash<QString, Entry> index;        // file name -> entry
+    bool scanned = false;
+    qint64 totalBytes = 0;
+    qint64 budget = 4000LL << 20;
+    std::atomic<bool> enabled{false};
+    std::atomic<int> edge{3840};
+
+    // instrumentation (report())
+    std::atomic<quint64> hits{0};
+    std::atomic<quint64> misses{0};
+    std::atomic<quint64> writes{0};
+    std::atomic<quint64> trims{0};
+    std::atomic<qint64> readNs{0};      // total get() time on hits
+};
+
+#endif // PREVIEWDISKCACHE_H
@@ -319,6 +319,39 @@ void Reader::readIcon()
     }
 }
 
+void Reader::readIconFirst()
+{
+/*
+    Thumbnail first: when a row needs both, show its icon from the embedded preview
+    (Thumb::loadThumbFirst, a minimal IFD walk and a DCT-scaled decode) before the full
+    metadata parse, so the grid of a large card dump fills while the metadata follows.
+    Nothing is emitted on failure and read() takes the usual readIcon path after
+    readMetadata.
+*/
+    QString fun = "Reader::readIconFirst";
+    if (G::isLogger) G::log(fun, fPath);
+
+    QElapsedTimer tIcon;
+    tIcon.start();
+    QImage image;
+    if (!thumb->loadThumbFirst(fPath, dmRow, image, instance)) return;
+    if (abort) return;
+
+    loadedIcon = true;
+    dm->queuedReaderEvents.fetch_add(1, std::memory_order_relaxed);
+    emit setIcon(dmRow, image, instance, "Reader::readIconFirst");
+    qint64 msToDecode = tIcon.nsecsElapsed()/1000;
+    emit setValDm(dmRow, G::NSThumbColumn, msToDecode, instance,
+                  "Reader::readIconFirst", Qt::EditRole,
+                  int(Qt::AlignRight | Qt::AlignVCenter));
+    if (isDebug)
+        qDebug().noquote()
+            << fun.leftJustified(col0Width)
+            << "id =" << QString::number(threadId).leftJustified(2, ' ')
+            << "row =" << QString::number(dmRow).leftJustified(4, ' ')
+            << "microsec =" << msToDecode;
+}
+
 void Reader::read(int dmRow, QString filePath, int instance,
                   bool needMeta, bool needIcon)
 {
@@ -374,8 +407,9 @@ void Reader::read(int dmRow, QString filePath, int instance,
             ;
     }
 
+    if (!abort && needMeta && needIcon && !isVideo) readIconFirst();
     if (!abort && needMeta) readMetadata();
-    if (!abort && needIcon) {
+    if (!abort && needIcon && !loadedIcon) {
         /* Icon-only read: readMetadata() was skipped, so m still points at the previous
            row's metadata (or, on the reader's first task, a default-constructed struct).
            Pull this row's embedded-thumb offsets from the DataModel and preset them, so
@@ -85,6 +85,7 @@ private:
     bool abort = false;
     bool readMetadata();
     void readIcon();
+    void readIconFirst();
     inline bool instanceOk();
     DataModel *dm;
     ImageMetadata *m;
@@ -0,0 +1,151 @@
+#include "Cache/regiondecoder.h"
+#include "Cache/cachedata.h"
+#include "Cache/imagedecoder.h"
+#include "Datamodel/datamodel.h"
+#include "Main/global.h"
+#include "Metadata/metadata.h"
+#include "ImageFormats/Tiff/tiff.h"
+#include "Utilities/icc.h"
+#include <QBuffer>
+#include <QFile>
+#include <QImageReader>
+
+RegionDecoder::Request RegionDecoder::request(DataModel *dm, Metadata *metadata, int sfRow,
+                                              QSize fullSize)
+{
+/*
+    Runs on the GUI thread. Mirrors the source selection in ImageDecoder::load, so the
+    region is cut from the same image the full decode will produce: the embedded JPEG
+    for raw files (unless the sensor is being decoded), the file itself for JPEG and TIFF.
+*/
+    Request req;
+    if (!dm || !metadata || sfRow < 0 || sfRow >= dm->sf->rowCount()) return req;
+    if (fullSize.isEmpty()) return req;
+
+    const QString ext = dm->sf->index(sfRow, G::TypeColumn).data().toString().toLower();
+    const quint32 offsetFull = dm->sf->index(sfRow, G::OffsetFullColumn).data().toUInt();
+    const quint32 lengthFull = dm->sf->index(sfRow, G::LengthFullColumn).data().toUInt();
+
+    if (metadata->hasJpg.contains(ext) || (ext == "jpg" && offsetFull)
+        || (metadata->hasHeic.contains(ext) && lengthFull)) {
+        // the loupe shows the demosaiced sensor, not the preview
+        if (metadata->hasJpg.contains(ext) && ImageDecoder::sensorDecodeActive()) return req;
+        if (!lengthFull) return req;
+        req.source = EmbeddedJpeg;
+        req.offset = offsetFull;
+        req.length = lengthFull;
+    }
+    else if (ext == "jpg" || ext == "jpeg") req.source = Jpeg;
+    else if (ext == "tif") req.source = Tiff;
+    else return req;
+
+    // same rotation as ImageDecoder::rotate
+    if (metadata->rotateFormats.contains(ext)) {
+        const int orientation = dm->sf->index(sfRow, G::OrientationColumn).data().toInt();
+        int degrees = dm->sf->index(sfRow, G::RotationDegreesColumn).data().toInt();
+        if (orientation == 3) degrees += 180;
+        else if (orientation == 6) degrees += 90;
+        else if (orientation == 8) degrees += 270;
+        degrees = ((degrees % 360) + 360) % 360;
+        if (degrees % 90) {                 // ImageDecoder would resample; not a region
+            req.source = None;
+            return req;
+        }
+        req.degrees = degrees;
+    }
+
+    if (G::colorManage && metadata->iccFormats.contains(ext)) {
+        req.colorManage = true;
+        req.iccBuf = dm->sf->index(sfRow, G::ICCBufColumn).data().toByteArray();
+    }
+
+    req.fPath = dm->sf->index(sfRow, G::PathColumn).data(G::PathRole).toString();
+    req.ext = ext;
+    req.fullSize = fullSize;
+    return req;
+}
+
+bool RegionDecoder::decode(const Request &req, QImage &image, QRect &rect)
+{
+    if (G::isLogger) G::log("RegionDecoder::decode", req.fPath);
+    if (req.source == None || req.fPath.isEmpty()) return false;
+
+    const QSize stored = storedSize(req.fullSize, req.degrees);
+    const QRect sRect = storedRect(req.rect, req.fullSize, req.degrees);
+    if (sRect.isEmpty()) return false;
+    const qreal scale = qBound(0.01, req.scale, 1.0);
+
+    QImage region;
+    bool ok = false;
+    switch (req.source) {
+    case Jpeg: {
+        QFile file(req.fPath);
+        ok = file.open(QIODevice::ReadOnly) && readJpeg(&file, sRect, stored, scale, region);
+        break;
+    }
+    case EmbeddedJpeg: {
+        QFile file(req.fPath);
+        if (!file.open(QIODevice::ReadOnly) || !file.seek(req.offset)) return false;
+        QByteArray buf = file.read(req.length);
+        QBuffer device(&buf);
+        ok = device.open(QIODevice::ReadOnly) && readJpeg(&device, sRect, stored, scale, region);
+        break;
+    }
+    case Tiff: {
+        /* 1:1 only; a scaled region is smoothed down from it (still only the strips or
+           tiles under the rect were read) */
+        class Tiff tiff("RegionDecoder::decode");
+        ok = tiff.readRegion(req.fPath, sRect, &region);
+        if (ok && region.size() != sRect.size()) ok = false;
+        if (ok && scale < 1.0)
+            region = region.scaled((QSizeF(sRect.size()) * scale).toSize().expandedTo(QSize(1, 1)),
+                                   Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        break;
+    }
+    case None:
+        break;
+    }
+    if (!ok || region.isNull()) return false;
+
+    if (req.degrees) region = region.transformed(QTransform().rotate(req.degrees));
+
+    const bool opaque = !region.hasAlphaChannel();
+    // ICC::transform assumes TYPE_BGRA_8, as in ImageDecoder::colorManage
+    if (req.colorManage) {
+        if (region.format() != QImage::Format_ARGB32 && region.format() != QImage::Format_RGB32)
+            region = region.convertToFormat(QImage::Format_ARGB32);
+        ICC::transform(req.iccBuf, region);
+    }
+    ImageCacheData::toDisplayFormat(region, opaque);
+
+    image = region;
+    rect = displayedRect(sRect, stored, req.degrees);
+    return true;
+}
+
+bool RegionDecoder::readJpeg(QIODevice *device, const QRect &stored, QSize storedSize,
+                             qreal scale, QImage &image)
+{
+/*
+    The clip is applied inside Qt's JPEG handler, so only the clip is ever converted and
+    allocated, and decoding stops at its bottom row. The region must match the image the
+    full decode shows: a JPEG whose own size is not the cached full size (an odd embedded
+    preview) is refused rather than guessed at.
+*/
+    QImageReader reader(device, "JPEG");
+    reader.setAutoTransform(false);         // ImageDecoder::rotate owns orientation
+    if (reader.size() != storedSize) return false;
+    if (scale >= 1.0) {
+        reader.setClipRect(stored);
+    }
+    else {
+        const QSize scaled = (QSizeF(storedSize) * scale).toSize().expandedTo(QSize(1, 1));
+        const qreal sx = qreal(scaled.width()) / storedSize.width();
+        const qreal sy = qreal(scaled.height()) / storedSize.height();
+        const QRect clip = QTransform::fromScale(sx, sy).mapRect(QRectF(stored)).toAlignedRect()
+                           & QRect(QPoint(0, 0), scaled);
+        reader.setScaledSize(scaled);
+        reader.setScaledClipRect(clip);
+    }
+    return reader.read(&image) && !image.isNull();
+}
@@ -0,0 +1,124 @@
+#ifndef REGIONDECODER_H
+#define REGIONDECODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QTransform>
+
+class DataModel;
+class Metadata;
+class QIODevice;
+
+/*
+    Region-of-interest decode for the loupe.
+
+    Zooming to 100% on a reduced cache entry asks ImageCache for the full decode
+    (ImageView::requestFullResolutionIfZoomed). On a 60 MP TIFF or JPEG that is the whole
+    file -- seconds before a single 1:1 pixel shows, while the viewport needs perhaps 3%
+    of it. RegionDecoder decodes just that part: the rectangle the loupe can see (plus a
+    margin), at the zoom's scale, straight from the file. ImageView lays the result over
+    the stretched reduced pixmap until the full decode lands, and asks for another
+    region when a pan leaves the one it has.
+
+    What each source decodes:
+
+        JPEG (the file, or the embedded preview a raw file shows in the loupe)
+            Qt's JPEG handler with a (scaled) clip rect: libjpeg decodes the MCU rows down
+            to the bottom of the clip and no further, and below 1:1 runs the IDCT at 1/2,
+            1/4 or 1/8 size. Without a restart-marker index a baseline scan cannot be
+            entered part way, so the rows above the clip are still entropy decoded.
+        TIFF
+            Tiff::readRegion: libtiff reads only the strips or tiles the rect touches.
+        HEIC, raw sensor decode, everything else
+            Not supported -- the bundled libheif (1.5.1) has no tile decode API and the raw
+            pipeline decodes whole frames. request() returns source None and the loupe waits
+            for the full decode as before.
+
+    The rect is in DISPLAYED image coordinates (after ImageDecoder::rotate). The decode
+    works in the file's stored orientation: storedRect() maps the rect back, the region is
+    decoded, and rotated forward like the full image would be. Colour management and the
+    display format match ImageDecoder, so the region and the full decode that replaces it
+    are the same pixels.
+
+    decode() is thread-safe and touches neither the DataModel nor Metadata: request()
+    snapshots what it needs on the GUI thread.
+*/
+class RegionDecoder
+{
+public:
+    enum Source {
+        None,
+        Jpeg,           // the file is a JPEG
+        EmbeddedJpeg,   // [offset, offset + length) of the file is a JPEG
+        Tiff
+    };
+
+    struct Request {
+        Source source = None;
+        QString fPath;
+        QString ext;
+        quint32 offset = 0;     // EmbeddedJpeg
+        quint32 length = 0;
+        int degrees = 0;        // clockwise rotation ImageDecoder::rotate applies
+        QSize fullSize;         // displayed image size
+        QRect rect;             // wanted region, displayed image coordinates
+        qreal scale = 1.0;      // output pixels per image pixel, <= 1
+        QByteArray iccBuf;      // source profile, empty when not colour managing
+        bool colorManage = false;
+    };
+
+    struct Result {
+        bool ok = false;
+        QImage image;
+        QRect rect;             // displayed image coordinates image covers
+    };
+
+    /* Snapshot the source of sfRow for a region decode on another thread. source is
+       None when the format, or the current decode mode, has no region path. */
+    static Request request(DataModel *dm, Metadata *metadata, int sfRow, QSize fullSize);
+
+    /* Decode req.rect. On success image covers rect (returned clipped to the image, in
+       displayed coordinates) at req.scale. */
+    static bool decode(const Request &req, QImage &image, QRect &rect);
+    static Result decode(const Request &req)
+    {
+        Result r;
+        r.ok = decode(req, r.image, r.rect);
+        return r;
+    }
+
+    /* Size of the image as stored in the file, before rotation by degrees. */
+    static QSize storedSize(QSize displayed, int degrees)
+    {
+        return (degrees % 180) ? displayed.transposed() : displayed;
+    }
+
+    /* The rotation ImageDecoder::rotate applies, as a transform on the stored image.
+       QImage::trueMatrix puts the rotated image back at the origin. */
+    static QTransform storedToDisplayed(QSize stored, int degrees)
+    {
+        return QImage::trueMatrix(QTransform().rotate(degrees), stored.width(), stored.height());
+    }
+
+    /* Displayed rect -> the rect of the stored image it comes from, clipped to the image. */
+    static QRect storedRect(const QRect &displayed, QSize displayedSize, int degrees)
+    {
+        const QSize s = storedSize(displayedSize, degrees);
+        const QTransform t = storedToDisplayed(s, degrees).inverted();
+        return t.mapRect(QRectF(displayed)).toAlignedRect() & QRect(QPoint(0, 0), s);
+    }
+
+    /* Stored rect -> where it lands once the image is rotated for display. */
+    static QRect displayedRect(const QRect &stored, QSize storedSize, int degrees)
+    {
+        return storedToDisplayed(storedSize, degrees).mapRect(QRectF(stored)).toAlignedRect();
+    }
+
+private:
+    static bool readJpeg(QIODevice *device, const QRect &stored, QSize storedSize,
+                         qreal scale, QImage &image);
+};
+
+#endif // REGIONDECODER_H
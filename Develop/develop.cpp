@@ -207,11 +207,25 @@ constexpr double kGrainCellMax      = 3.75;    // grain cell (units) at size = 1
 constexpr int    kGrainRoughFreqDiv = 4;       // roughness field: lower frequency factor
 constexpr uint64_t kGrainSeed = 0x9E3779B97F4A7C15ULL;   // fixed: grain must not shimmer
 
+/* Local NR (Denoise, spatial op #1): the bilateral spatial sigmas, in full-resolution
+   pixels, and the working resolution each runs at -- shared with Develop::halo, which
+   has to know how far they reach. The luma filter runs with the FRAME held to ~2 MP
+   (scale 1 at or below that), so a viewport window filters at its frame's resolution;
+   the chroma filter always runs at a quarter. */
+inline double denoiseLumaSigma(float amt) { return 2.0 + 4.0 * static_cast<double>(amt); }
+inline double denoiseChromaSigma(float amt) { return 2.0 + 6.0 * static_cast<double>(amt); }
+constexpr int kDenoiseChromaScale = 4;
+inline int denoiseLumaScale(int frameW, int frameH)
+{
+    const double mp = static_cast<double>(frameW) * static_cast<double>(frameH) / 1e6;
+    return (mp > 2.0) ? std::max(1, int(std::lround(std::sqrt(mp / 2.0)))) : 1;
+}
+
 /* Run fn over the pixel-index range [0, n) split into chunks across the global pool (the same
-   data-parallel idiom as Develop::applyPointOps / OutputTransform::ToImage). fn(i0, i1) must
-   process a disjoint half-open slice; chunks are pixel-aligned so callers that index rgb[i*3+c],
-   yp[i], etc. stay race-free. Falls back to a single in-line call when the pool is one thread or
-   the work is small. */
+   data-parallel idiom as OutputTransform::ToImage; the ops after Denoise use the Tiler instead).
+   fn(i0, i1) must process a disjoint half-open slice; chunks are pixel-aligned so callers that
+   index rgb[i*3+c], yp[i], etc. stay race-free. Falls back to a single in-line call when the
+   pool is one thread or the work is small. */
 template <class F>
 inline void parallelFor(size_t n, F fn)
 {
@@ -233,6 +247,9 @@ inline void parallelFor(size_t n, F fn)
     for (QFuture<void> &f : futures) f.waitForFinished();
 }
 
+/* Tile edge override for tests (Develop::setTileEdge); 0 = Develop::kTile. */
+std::atomic<int> tileEdgeOverride{0};
+
 /* ------------------------------------------------------------------------------------
    Shared perceptual-luminance band pass
 
@@ -242,26 +259,22 @@ inline void parallelFor(size_t n, F fn)
    middle step differs. These two helpers own the first and third, so each op is just its
    own blur plus its own shape function -- see Develop/localcontrast.h for the shared
    scalar math and tests/unit/tst_localcontrast.cpp for the characterization gate that
-   pins what Texture and Dehaze rendered before this was extracted.
+   pins what Texture and Dehaze rendered before this was extracted. Both work one tile at
+   a time on the Tiler's shared luma planes.
    ------------------------------------------------------------------------------------ */
 
-/* Perceptual, white-normalised luminance into a blurrable cv::Mat, plus the scene-linear
-   luma kept alongside for the ratio fold-back. */
-inline void buildPerceptualLuma(const WorkingImage &img, cv::Mat &Yp,
-                                std::vector<float> &Ylin)
+/* Perceptual, white-normalised luminance of one tile into the shared plane, plus the
+   scene-linear luma kept alongside for the ratio fold-back. */
+inline void extractLumaTile(const WorkingImage &img, float *yp, float *ylin,
+                            const Develop::Tile &t)
 {
-    const int w = img.width, h = img.height;
-    const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h);
+    const size_t w = static_cast<size_t>(img.width);
     const float white = (img.white > 0.0f) ? img.white : 1.0f;
     const float invWhite = 1.0f / white;
     const float *rgb = img.rgb.data();
-
-    Yp.create(h, w, CV_32FC1);
-    Ylin.resize(n);
-    float *yp = Yp.ptr<float>();
-    float *ylin = Ylin.data();
-    parallelFor(n, [=](size_t i0, size_t i1) {
-        for (size_t i = i0; i < i1; ++i) {
+    for (int y = t.y0; y < t.y1; ++y) {
+        const size_t end = y * w + t.x1;
+        for (size_t i = y * w + t.x0; i < end; ++i) {
             const float r = rgb[i * 3 + 0], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
             const float Y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
             ylin[i] = Y;
@@ -269,56 +282,181 @@ inline void buildPerceptualLuma(const WorkingImage &img, cv::Mat &Yp,
             if (nrm < 0.0f) nrm = 0.0f;
             yp[i] = std::pow(nrm, kInvGamma);
         }
-    });
+    }
+}
+
+/* The long edge every size-relative radius is a fraction of: the FRAME's, which is the
+   image's own unless it is a viewport window (WorkingImage::frameW). */
+inline int frameLongEdge(const WorkingImage &img)
+{
+    return qMax(img.frameWidth(), img.frameHeight());
+}
+
+/* The reduced-resolution round trip Denoise and gaussianBase take: area-downscale src
+   (image-sized, CV_32F, any channel count) to 1/factor of the FRAME, run fn on the small
+   Mat (it may replace it), and linearly upscale back to src's size.
+
+   For a whole frame that is the two cv::resize calls it always was. A viewport window
+   has to land on the frame's reduced grid, not one of its own: the frame's cell is
+   fw / (fw / factor) pixels, which is not an integer when the edge is not a multiple of
+   factor, so a window resized by itself would sample between the frame's cells. So it
+   builds the frame cells it overlaps with cv::resize's area weights, and samples them
+   back with its half-pixel lerp, at the window's offset. A cell the window edge cuts
+   averages only the part inside; Develop::halo keeps those out of what is shown. */
+template <class Fn>
+inline cv::Mat reducedRoundTrip(const cv::Mat &src, const WorkingImage &img, int factor, Fn fn)
+{
+    const int w = src.cols, h = src.rows;
+    const int fw = img.frameWidth(), fh = img.frameHeight();
+    const int sw = std::max(1, fw / factor), sh = std::max(1, fh / factor);
+    cv::Mat small, out;
+    if (img.frameW <= 0) {
+        cv::resize(src, small, cv::Size(sw, sh), 0, 0, cv::INTER_AREA);
+        fn(small);
+        cv::resize(small, out, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
+        return out;
+    }
+
+    /* Area taps: the frame cells [c0, c0 + taps.size()) that the span [o, o + n) of an
+       axis overlaps, each with its source pixels (span index, normalised coverage). */
+    struct Tap { int i; float wgt; };
+    auto areaTaps = [](int o, int n, int frameN, int cellsN, int &c0,
+                       std::vector<std::vector<Tap>> &taps) {
+        const double r = static_cast<double>(frameN) / cellsN;
+        c0 = qBound(0, static_cast<int>(std::floor(o / r)), cellsN - 1);
+        const int c1 = qBound(c0 + 1, static_cast<int>(std::ceil((o + n) / r)), cellsN);
+        taps.assign(c1 - c0, {});
+        for (int c = c0; c < c1; ++c) {
+            const double a = qMax(c * r, static_cast<double>(o));
+            const double b = qMin((c + 1) * r, static_cast<double>(o + n));
+            std::vector<Tap> &t = taps[c - c0];
+            double sum = 0.0;
+            for (int px = static_cast<int>(std::floor(a)); px < b; ++px) {
+                const double cover = qMin(b, px + 1.0) - qMax(a, static_cast<double>(px));
+                if (cover <= 0.0) continue;
+                t.push_back({px - o, static_cast<float>(cover)});
+                sum += cover;
+            }
+            for (Tap &tap : t) tap.wgt = static_cast<float>(tap.wgt / sum);
+        }
+    };
+    const int ch = src.channels();
+    int cx0 = 0, cy0 = 0;
+    std::vector<std::vector<Tap>> tx, ty;
+    areaTaps(img.frameX, w, fw, sw, cx0, tx);
+    areaTaps(img.frameY, h, fh, sh, cy0, ty);
+    const int nx = static_cast<int>(tx.size()), ny = static_cast<int>(ty.size());
+
+    cv::Mat across(h, nx, CV_MAKETYPE(CV_32F, ch), cv::Scalar::all(0));
+    for (int y = 0; y < h; ++y) {
+        const float *s = src.ptr<float>(y);
+        float *d = across.ptr<float>(y);
+        for (int c = 0; c < nx; ++c)
+            for (const Tap &t : tx[c])
+                for (int k = 0; k < ch; ++k) d[c * ch + k] += t.wgt * s[t.i * ch + k];
+    }
+    small = cv::Mat(ny, nx, across.type(), cv::Scalar::all(0));
+    for (int c = 0; c < ny; ++c) {
+        float *d = small.ptr<float>(c);
+        for (const Tap &t : ty[c]) {
+            const float *s = across.ptr<float>(t.i);
+            for (int j = 0; j < nx * ch; ++j) d[j] += t.wgt * s[j];
+        }
+    }
+    fn(small);
+
+    /* INTER_LINEAR's mapping in frame coordinates, onto the cells held. */
+    auto lerpAxis = [](int d, int frameN, int cellsN, int c0, int held, int &i0, int &i1,
+                       float &f) {
+        f = static_cast<float>((d + 0.5) * (static_cast<double>(cellsN) / frameN) - 0.5);
+        int i = static_cast<int>(std::floor(f));
+        f -= i;
+        if (i < 0) { i = 0; f = 0.0f; }
+        if (i >= cellsN - 1) { i = cellsN - 1; f = 0.0f; }
+        i0 = qBound(0, i - c0, held - 1);
+        i1 = qBound(0, i + 1 - c0, held - 1);
+    };
+    std::vector<int> xa(w), xb(w);
+    std::vector<float> xf(w);
+    for (int x = 0; x < w; ++x) lerpAxis(img.frameX + x, fw, sw, cx0, nx, xa[x], xb[x], xf[x]);
+    out.create(h, w, small.type());
+    for (int y = 0; y < h; ++y) {
+        int ya, yb;
+        float fy;
+        lerpAxis(img.frameY + y, fh, sh, cy0, ny, ya, yb, fy);
+        const float *r0 = small.ptr<float>(ya);
+        const float *r1 = small.ptr<float>(yb);
+        float *d = out.ptr<float>(y);
+        for (int x = 0; x < w; ++x) {
+            const float f = xf[x];
+            const float *a0 = r0 + xa[x] * ch, *b0 = r0 + xb[x] * ch;
+            const float *a1 = r1 + xa[x] * ch, *b1 = r1 + xb[x] * ch;
+            for (int k = 0; k < ch; ++k) {
+                const float top = a0[k] * (1.0f - f) + b0[k] * f;
+                const float bot = a1[k] * (1.0f - f) + b1[k] * f;
+                d[x * ch + k] = top * (1.0f - fy) + bot * fy;
+            }
+        }
+    }
+    return out;
 }
 
 /* Gaussian base for a band op, with the large-sigma downscale trick.
 
-   sigmaFrac is a fraction of the image's LONGER EDGE, so the proxy and the full-res
-   settle render shape the same relative band (the invariant every spatial op but Sharpen
-   holds). The base is a smooth low-frequency signal, so for a large sigma the costly
-   Gaussian runs on a DOWNSCALED luminance image and is upsampled -- visually identical to
-   a full-res blur, but the cost drops ~kDown^2, and GaussianBlur is the dominant cost of
-   these ops at full resolution. The downscale targets a well-sampled small-image working
+   sigmaFrac is a fraction of the frame's LONGER EDGE, so the proxy, the full-res settle
+   render and a viewport window all shape the same relative band (the invariant every
+   spatial op but Sharpen holds). The base is a smooth low-frequency signal, so for a
+   large sigma the costly Gaussian runs on a DOWNSCALED luminance image and is upsampled
+   (reducedRoundTrip) -- visually identical to a full-res blur, but the cost drops
+   ~kDown^2, and GaussianBlur is the dominant cost of these ops at full resolution.
+   baseSigma / baseDown are split out for Develop::halo. The downscale targets a well-sampled small-image working
    sigma (~3px) and is capped so the base stays smooth; a sigma <= ~3 (e.g. on the proxy)
    blurs at full size. Shared by Texture (#6) and Clarity (#6.5); Dehaze uses a box blur
    instead because at its much larger radius a running-sum blur is cheaper still. */
-inline cv::Mat gaussianBase(const cv::Mat &Yp, float sigmaFrac, int w, int h)
+inline double baseSigma(float sigmaFrac, int longEdge)
+{
+    return qMax(1.0, static_cast<double>(sigmaFrac) * longEdge);
+}
+inline int baseDown(double sigma) { return qBound(1, static_cast<int>(sigma / 3.0), 4); }
+
+inline cv::Mat gaussianBase(const cv::Mat &Yp, float sigmaFrac, const WorkingImage &img)
 {
-    const double sigma = qMax(1.0, static_cast<double>(sigmaFrac) * qMax(w, h));
-    const int kDown = qBound(1, static_cast<int>(sigma / 3.0), 4);
+    const int fw = img.frameWidth(), fh = img.frameHeight();
+    const double sigma = baseSigma(sigmaFrac, frameLongEdge(img));
+    const int kDown = baseDown(sigma);
     cv::Mat base;
-    if (kDown > 1 && w >= kDown * 2 && h >= kDown * 2) {
-        cv::Mat small;
-        cv::resize(Yp, small, cv::Size(w / kDown, h / kDown), 0, 0, cv::INTER_AREA);
-        cv::GaussianBlur(small, small, cv::Size(0, 0), sigma / kDown);
-        cv::resize(small, base, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
+    if (kDown > 1 && fw >= kDown * 2 && fh >= kDown * 2) {
+        base = reducedRoundTrip(Yp, img, kDown, [&](cv::Mat &small) {
+            cv::GaussianBlur(small, small, cv::Size(0, 0), sigma / kDown);
+        });
     } else {
         cv::GaussianBlur(Yp, base, cv::Size(0, 0), sigma);
     }
     return base;
 }
 
-/* Reshape the perceptual luma and fold it back onto RGB as a ratio.
+/* Reshape the perceptual luma of one tile and fold it back onto RGB as a ratio.
 
-   shape(i, yp[i]) returns the new perceptual luma for pixel i; the op's own lambda closes
-   over its blurred base. TEMPLATED ON PURPOSE: the shape inlines into this loop, so the
-   op still costs ONE parallel pass and no extra buffer, exactly as the hand-written
-   versions did. Pixels at or below black are skipped so true black stays black (a ratio
-   is meaningless there). */
+   shape(i, x, y, yp[i]) returns the new perceptual luma for pixel i at (x, y); the op's
+   own lambda closes over its blurred base, indexed by i when the base is frame-sized or
+   by (x, y) when it is the tile's own. TEMPLATED ON PURPOSE: the shape inlines into this
+   loop, so the op costs no extra buffer, exactly as the hand-written versions did. Pixels
+   at or below black are skipped so true black stays black (a ratio is meaningless
+   there). */
 template <class Shape>
-inline void shapeAndFoldLuma(WorkingImage &img, const float *yp, const float *ylin,
-                             Shape shape)
+inline void foldLumaTile(WorkingImage &img, const float *yp, const float *ylin,
+                         const Develop::Tile &t, Shape shape)
 {
-    const size_t n = static_cast<size_t>(img.width) * static_cast<size_t>(img.height);
+    const size_t w = static_cast<size_t>(img.width);
     const float white = (img.white > 0.0f) ? img.white : 1.0f;
     float *rgb = img.rgb.data();
     constexpr float kEps = 1e-6f;
-    parallelFor(n, [=](size_t i0, size_t i1) {
-        for (size_t i = i0; i < i1; ++i) {
+    for (int y = t.y0; y < t.y1; ++y) {
+        for (int x = t.x0; x < t.x1; ++x) {
+            const size_t i = y * w + x;
             const float Y = ylin[i];
             if (Y <= kEps) continue;
-            float s = shape(i, yp[i]);
+            float s = shape(i, x, y, yp[i]);
             if (s < 0.0f) s = 0.0f;
             const float Yd = std::pow(s, kGamma) * white;
             const float r = Yd / Y;
@@ -326,8 +464,291 @@ inline void shapeAndFoldLuma(WorkingImage &img, const float *yp, const float *yl
             rgb[i * 3 + 1] *= r;
             rgb[i * 3 + 2] *= r;
         }
-    });
+    }
+}
+
+/* cv::resize(src, dst, Size(w, h), 0, 0, INTER_LINEAR) evaluated one tile at a time --
+   the same half-pixel mapping, edge clamp and horizontal-then-vertical lerp -- so Grain
+   upsamples its noise fields inside the tile pass instead of materialising two
+   full-resolution planes. row(y) selects the output row, at(x) samples it. */
+class LinearUpsample
+{
+public:
+    /* src spans a w x h frame; the image's pixel (0,0) sits at (ox, oy) in it (non-zero
+       only for a viewport window). Tile, row and at() take image coordinates. */
+    LinearUpsample(const cv::Mat &src, int w, int h, const Develop::Tile &t, int ox = 0,
+                   int oy = 0)
+        : src(src), h(h), x0(t.x0), oy(oy)
+    {
+        const int n = t.x1 - t.x0;
+        const double scale = static_cast<double>(src.cols) / w;
+        ix.resize(n);
+        fx.resize(n);
+        for (int k = 0; k < n; ++k) axis(ox + t.x0 + k, scale, src.cols, ix[k], fx[k]);
+    }
+
+    void row(int y)
+    {
+        int iy;
+        axis(oy + y, static_cast<double>(src.rows) / h, src.rows, iy, fy);
+        r0 = src.ptr<float>(iy);
+        r1 = src.ptr<float>(qMin(iy + 1, src.rows - 1));
+    }
+
+    float at(int x) const
+    {
+        const int k = x - x0;
+        const int a = ix[k];
+        const int b = qMin(a + 1, src.cols - 1);
+        const float f = fx[k];
+        const float top = r0[a] * (1.0f - f) + r0[b] * f;
+        const float bot = r1[a] * (1.0f - f) + r1[b] * f;
+        return top * (1.0f - fy) + bot * fy;
+    }
+
+private:
+    static void axis(int d, double scale, int size, int &i, float &f)
+    {
+        f = static_cast<float>((d + 0.5) * scale - 0.5);
+        i = static_cast<int>(std::floor(f));
+        f -= i;
+        if (i < 0) { i = 0; f = 0.0f; }
+        if (i >= size - 1) { i = size - 1; f = 0.0f; }
+    }
+
+    const cv::Mat &src;
+    int h, x0, oy;
+    std::vector<int> ix;
+    std::vector<float> fx;
+    const float *r0 = nullptr, *r1 = nullptr;
+    float fy = 0.0f;
+};
 }
+
+/*
+    The fused tile passes behind Develop::Apply.
+
+    Ops queue STAGES (a function run on one tile) with add(). Nothing runs until a pass is
+    flushed, and then every queued stage runs on a tile before the next tile is claimed, so
+    the tile's RGB, luma and base stay in L2 from the first op to the last instead of each
+    op streaming the whole frame through memory. A pass is flushed only where an op needs
+    the whole frame first:
+
+      syncLuma  the band ops' base blur, and Sharpen's halo, read the perceptual luma of
+                the CURRENT pixels. The extraction is queued as the last stage of the
+                pass that last changed them, rather than being a pass of its own, and the
+                planes are allocated once and shared by every band op.
+      wide      frame-wide work between passes (the band ops' blurred bases, the grain
+                fields), timed into the op's StageTimings field.
+
+    A stage writes only its own tile's pixels. Sharpen is the one stage that READS beyond
+    its tile -- a halo of the luma plane -- so syncLuma never queues the extraction (which
+    writes that plane) into a pass holding it.
+*/
+class Develop::Tiler
+{
+public:
+    enum class Slot { Point, Texture, Clarity, Dehaze, Vignette, Sharpen, Grain, Count };
+    using Stage = std::function<void(const Tile &)>;
+
+    Tiler(WorkingImage &img, StageTimings *t) : img(img), t(t) {}
+
+    WorkingImage &img;
+    /* Shared perceptual (Yp) and scene-linear (Ylin) luma, frame-sized. Describe the
+       current pixels after syncLuma() until the next add(). */
+    cv::Mat Yp;
+    std::vector<float> Ylin;
+
+    void add(Slot s, Stage fn, bool readsHalo = false)
+    {
+        stages.push_back({s, std::move(fn)});
+        haloQueued = haloQueued || readsHalo;
+        lumaValid = false;
+    }
+
+    void syncLuma(Slot s)
+    {
+        if (lumaValid) return;
+        if (haloQueued) flush();
+        if (Yp.empty()) {
+            wide(s, [this] {
+                Yp.create(img.height, img.width, CV_32FC1);
+                Ylin.resize(static_cast<size_t>(img.width) * static_cast<size_t>(img.height));
+            });
+        }
+        const WorkingImage &src = img;
+        float *yp = Yp.ptr<float>();
+        float *ylin = Ylin.data();
+        add(s, [&src, yp, ylin](const Tile &tile) { extractLumaTile(src, yp, ylin, tile); });
+        flush();
+        lumaValid = true;
+    }
+
+    void wide(Slot s, const std::function<void()> &fn)
+    {
+        if (!t) { fn(); return; }
+        QElapsedTimer probe;
+        probe.start();
+        fn();
+        slotNs[static_cast<int>(s)] += probe.nsecsElapsed();
+    }
+
+    void flush();
+
+    /* Run what is still queued and write the per-op timings. */
+    void finish()
+    {
+        flush();
+        if (!t) return;
+        auto ms = [this](Slot s) { return slotNs[static_cast<int>(s)] / 1000000; };
+        t->pointMs    = ms(Slot::Point);
+        t->textureMs  = ms(Slot::Texture);
+        t->clarityMs  = ms(Slot::Clarity);
+        t->dehazeMs   = ms(Slot::Dehaze);
+        t->vignetteMs = ms(Slot::Vignette);
+        t->sharpenMs  = ms(Slot::Sharpen);
+        t->grainMs    = ms(Slot::Grain);
+    }
+
+private:
+    static constexpr int kSlots = static_cast<int>(Slot::Count);
+    struct Queued { Slot slot; Stage fn; };
+    /* One worker's CPU time per slot and its slowest tile. */
+    struct Clock { qint64 ns[kSlots] = {}; qint64 maxNs = 0; };
+
+    StageTimings *t;
+    std::vector<Queued> stages;
+    bool haloQueued = false;
+    bool lumaValid = false;
+    qint64 slotNs[kSlots] = {};
+};
+
+void Develop::Tiler::flush()
+{
+/*
+    Same scheduling as Demosaic::ForEachTile: tiles are claimed from a shared counter in
+    row-major order (so tiles sharing a halo run at about the same time), and the calling
+    thread claims them too, so a caller that is itself a pool thread cannot stall the
+    pass. Every stage is a pure function of the tile's own pixels (plus, for Sharpen, a
+    luma plane no stage of the pass writes), so the result is independent of the order
+    and the thread count.
+
+    With timing on, each stage is clocked per tile. The pass's wall-clock is then split
+    across the ops in proportion to the CPU time their stages took, which keeps the
+    StageTimings fields summing to the wall-clock of Apply() even though the ops now
+    share their passes.
+*/
+    if (stages.empty()) return;
+    const int w = img.width;
+    const int h = img.height;
+    const int o = tileEdgeOverride.load(std::memory_order_relaxed);
+    const int edge = (o > 0) ? o : kTile;
+    const int tilesX = (w + edge - 1) / edge;
+    const int tilesY = (h + edge - 1) / edge;
+    const int nTiles = tilesX * tilesY;
+    const bool timing = (t != nullptr);
+
+    QElapsedTimer wall;
+    if (timing) wall.start();
+
+    const int maxThreads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int helpers = qMin(maxThreads, nTiles) - 1;
+    std::vector<Clock> clocks(static_cast<size_t>(helpers) + 1);
+    std::atomic<int> next{0};
+
+    auto work = [&](Clock &clock) {
+        QElapsedTimer probe;
+        for (;;) {
+            const int i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= nTiles) return;
+            Tile tile;
+            tile.x0 = (i % tilesX) * edge;
+            tile.y0 = (i / tilesX) * edge;
+            tile.x1 = qMin(w, tile.x0 + edge);
+            tile.y1 = qMin(h, tile.y0 + edge);
+            if (!timing) {
+                for (const Queued &q : stages) q.fn(tile);
+                continue;
+            }
+            qint64 tileNs = 0;
+            for (const Queued &q : stages) {
+                probe.start();
+                q.fn(tile);
+                const qint64 ns = probe.nsecsElapsed();
+                clock.ns[static_cast<int>(q.slot)] += ns;
+                tileNs += ns;
+            }
+            clock.maxNs = qMax(clock.maxNs, tileNs);
+        }
+    };
+
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 1; k <= helpers; ++k) {
+        Clock *clock = &clocks[k];
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(),
+                                         [&work, clock]() { work(*clock); }));
+    }
+    work(clocks[0]);
+    for (QFuture<void> &f : futures) f.waitForFinished();
+
+    stages.clear();
+    haloQueued = false;
+    if (!timing) return;
+
+    const qint64 wallNs = wall.nsecsElapsed();
+    qint64 cpu[kSlots] = {};
+    qint64 cpuTotal = 0, maxNs = 0;
+    for (const Clock &clock : clocks) {
+        for (int s = 0; s < kSlots; ++s) cpu[s] += clock.ns[s];
+        maxNs = qMax(maxNs, clock.maxNs);
+    }
+    for (int s = 0; s < kSlots; ++s) cpuTotal += cpu[s];
+    for (int s = 0; s < kSlots; ++s)
+        if (cpuTotal > 0)
+            slotNs[s] += static_cast<qint64>(static_cast<double>(wallNs) * cpu[s] / cpuTotal);
+    t->tilePasses += 1;
+    t->tiles      += nTiles;
+    t->tileCpuUs  += cpuTotal / 1000;
+    t->tileMaxUs   = qMax(t->tileMaxUs, maxNs / 1000);
+}
+
+void Develop::setTileEdge(int tileEdge)
+{
+    tileEdgeOverride.store(qMax(0, tileEdge), std::memory_order_relaxed);
+}
+
+int Develop::halo(const EditParams &p, int frameW, int frameH)
+{
+    /* Each op's reach in full-resolution pixels: its kernel radius (OpenCV sizes a float
+       Gaussian to 4 sigma and a d = 0 bilateral to 1.5 sigma) plus, where it works at a
+       reduced resolution, a source pixel per step for the area downscale and for the
+       linear upscale back. Rounded up, and a pixel over, rather than exact. */
+    if (p.isIdentity()) return 0;
+    const int longEdge = qMax(frameW, frameH);
+    auto ceilPx = [](double v) { return static_cast<int>(std::ceil(v)); };
+    int reach = 0;
+    if (p.localDenoiseLuma > 0.0f) {
+        const int scale = denoiseLumaScale(frameW, frameH);
+        reach += ceilPx(1.5 * denoiseLumaSigma(p.localDenoiseLuma)) + 3 * scale;
+    }
+    if (p.localDenoiseChroma > 0.0f)
+        reach += kDenoiseChromaScale *
+                 (ceilPx(1.5 * denoiseChromaSigma(p.localDenoiseChroma)) + 3);
+    auto band = [&](float sigmaFrac) {
+        const double sigma = baseSigma(sigmaFrac, longEdge);
+        return ceilPx(4.0 * sigma) + 3 * baseDown(sigma);
+    };
+    if (p.texture != 0.0f) reach += band(kTextureSigmaFrac);
+    if (p.clarity != 0.0f) reach += band(kClaritySigmaFrac);
+    if (p.dehaze != 0.0f)
+        reach += qMax(1, static_cast<int>(std::lround(static_cast<double>(kDehazeSigmaFrac) *
+                                                      longEdge))) + 1;
+    if (p.sharpenAmount > 0.0f)         // + the gate's Sobel, one pixel out
+        reach += ceilPx(4.0 * Sharpen::effectiveSigma(p.sharpenRadius, 1.0f)) + 2;
+    /* Point ops, Vignette and Grain are per pixel: they read the frame position, never a
+       neighbour. */
+    return reach;
 }
 
 bool Develop::Apply(WorkingImage &img, const EditParams &p, StageTimings *t)
@@ -338,36 +759,42 @@ bool Develop::Apply(WorkingImage &img, const EditParams &p, StageTimings *t)
     QElapsedTimer probe;
     if (t) probe.start();
 
-    /* Fixed pipeline order: spatial ops own a pass, point ops share the fused pass.
-       See notes/Documentation.txt "DEVELOP / IMAGE EDIT". Denoise (#1) -> fused point
-       pass (#2-5: WB, exposure, contrast, tone regions) -> Texture (#6) ->
-       Clarity (#6.5, mid-radius local contrast) -> Dehaze (#7) ->
+    /* Fixed pipeline order. See notes/Documentation.txt "DEVELOP / IMAGE EDIT". Denoise
+       (#1) -> fused point ops (#2-5: WB, exposure, contrast, tone regions) -> Texture
+       (#6) -> Clarity (#6.5, mid-radius local contrast) -> Dehaze (#7) ->
        Vignette (#8, a radial exposure falloff) -> Sharpen (#8.5, capture USM) ->
-       Grain (#9, film grain, last). */
+       Grain (#9, film grain, last).
+
+       Denoise works on the whole frame. Every op after it queues its per-pixel work on
+       the Tiler, which runs consecutive ops as one pass per tile and only ends a pass
+       where an op needs the whole frame first (see Develop::Tiler). */
     Denoise(img, p);
     if (t) t->denoiseMs = probe.restart();
 
-    PointCoeffs c = buildPointCoeffs(p, img);
-    if (c.active) applyPointOps(img, c);
-    if (t) t->pointMs = probe.restart();
-
-    Texture(img, p);
-    if (t) t->textureMs = probe.restart();
-
-    Clarity(img, p);
-    if (t) t->clarityMs = probe.restart();
-
-    Dehaze(img, p);
-    if (t) t->dehazeMs = probe.restart();
-
-    Vignette(img, p);
-    if (t) t->vignetteMs = probe.restart();
-
-    Sharpen(img, p);
-    if (t) t->sharpenMs = probe.restart();
-
-    Grain(img, p);
-    if (t) t->grainMs = probe.restart();
+    Tiler tiler(img, t);
+    PointCoeffs c;
+    PointLut lut;
+    const bool bake = pointPath == PointPath::Lut &&
+                      static_cast<size_t>(img.width) * img.height >= PointLut::kMinPixels;
+    tiler.wide(Tiler::Slot::Point, [&] {
+        c = buildPointCoeffs(p, img);
+        /* Gain and calibration alone run ahead of the table anyway (PointLut's SHAPER);
+           only a tone curve, HSL or a grade gives it something to hold. */
+        if (c.active && bake && (c.toneActive || c.hslActive || c.gradeActive)) lut.Bake(c);
+    });
+    if (c.active) {
+        const PointLut *table = lut.isBaked() ? &lut : nullptr;
+        tiler.add(Tiler::Slot::Point, [&img, &c, table](const Tile &tile) {
+            applyPointOps(img, c, table, tile);
+        });
+    }
+    Texture(tiler, p);
+    Clarity(tiler, p);
+    Dehaze(tiler, p);
+    Vignette(tiler, p);
+    Sharpen(tiler, p);
+    Grain(tiler, p);
+    tiler.finish();
     return true;
 }
 
@@ -417,21 +844,21 @@ void Develop::Denoise(WorkingImage &img, const EditParams &p)
         /* Edge-preserving smoothing on luminance only; strength scales the range/space sigmas.
            d = 0 derives the kernel diameter from sigmaSpace. The bilateral is the expensive part
            and (unlike the O(n) passes) grows with pixel count, so run it at a BOUNDED resolution:
-           downscale to ~2 MP, filter with a proportionally smaller spatial sigma (same effective
-           radius), then upscale. This keeps the interactive proxy render off the GUI thread's
-           critical path (see the Develop perf note in Documentation.txt); small images (<=2 MP,
-           e.g. the proxy on a modest display) skip the downscale and filter at full resolution. */
+           downscale the frame to ~2 MP (denoiseLumaScale), filter with a proportionally
+           smaller spatial sigma (same effective radius), then upscale. This keeps the
+           interactive proxy render off the GUI thread's critical path (see the Develop perf
+           note in Documentation.txt); small images (<=2 MP, e.g. the proxy on a modest
+           display) skip the downscale and filter at full resolution. */
         const double sigmaColor = 0.03 + 0.09 * static_cast<double>(lumAmt);
-        const double sigmaSpace = 2.0 + 4.0 * static_cast<double>(lumAmt);
-        const double mp = static_cast<double>(n) / 1e6;
-        const int scale = (mp > 2.0) ? std::max(1, int(std::lround(std::sqrt(mp / 2.0)))) : 1;
+        const double sigmaSpace = denoiseLumaSigma(lumAmt);
+        const int scale = denoiseLumaScale(img.frameWidth(), img.frameHeight());
         cv::Mat Ypd;
         if (scale > 1) {
-            const int sw = std::max(1, w / scale), sh = std::max(1, h / scale);
-            cv::Mat lo, loD;
-            cv::resize(Yp, lo, cv::Size(sw, sh), 0, 0, cv::INTER_AREA);
-            cv::bilateralFilter(lo, loD, 0, sigmaColor, sigmaSpace / scale);
-            cv::resize(loD, Ypd, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
+            Ypd = reducedRoundTrip(Yp, img, scale, [&](cv::Mat &lo) {
+                cv::Mat loD;
+                cv::bilateralFilter(lo, loD, 0, sigmaColor, sigmaSpace / scale);
+                lo = loD;
+            });
         }
         else {
             cv::bilateralFilter(Yp, Ypd, 0, sigmaColor, sigmaSpace);
@@ -477,15 +904,14 @@ void Develop::Denoise(WorkingImage &img, const EditParams &p)
         });
 
         /* Downscaled edge-preserving blur of the chroma; strength scales the sigmas. */
-        const int scale = 4;
-        const int sw = std::max(1, w / scale), sh = std::max(1, h / scale);
-        cv::Mat lo, loD;
-        cv::resize(chroma, lo, cv::Size(sw, sh), 0, 0, cv::INTER_AREA);
         const double sigmaColorC = 0.02 + 0.10 * static_cast<double>(chrAmt);
-        const double sigmaSpaceC = 2.0 + 6.0 * static_cast<double>(chrAmt);
-        cv::bilateralFilter(lo, loD, 0, sigmaColorC, sigmaSpaceC);
-        cv::Mat chromaD;
-        cv::resize(loD, chromaD, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
+        const double sigmaSpaceC = denoiseChromaSigma(chrAmt);
+        const cv::Mat chromaD = reducedRoundTrip(chroma, img, kDenoiseChromaScale,
+                                                 [&](cv::Mat &lo) {
+            cv::Mat loD;
+            cv::bilateralFilter(lo, loD, 0, sigmaColorC, sigmaSpaceC);
+            lo = loD;
+        });
 
         /* Recombine: keep Y exact, take the smoothed chroma; derive G so Y is preserved. */
         const float *cpd = chromaD.ptr<float>();
@@ -540,25 +966,31 @@ void Develop::BlendRawDenoise(const WorkingImage &clean, const WorkingImage &den
 /* Texture (spatial op #6). Ratio-preserving luminance local contrast in the perceptual domain:
    a Gaussian base isolates a mid-frequency detail band, which the slider amplifies (crisper) or
    attenuates (smoother). Runs after the point pass. See the class doc and the constants above. */
-void Develop::Texture(WorkingImage &img, const EditParams &p)
+void Develop::Texture(Tiler &tiler, const EditParams &p)
 {
     const float amt = p.texture / kTextureFullScale;     // -1..1
     if (amt == 0.0f) return;
 
-    cv::Mat Yp;
-    std::vector<float> Ylin;
-    buildPerceptualLuma(img, Yp, Ylin);
+    WorkingImage &img = tiler.img;
+    tiler.syncLuma(Tiler::Slot::Texture);
 
     /* Mid-frequency base; sigma scales with the long edge so proxy and full-res match. */
-    const cv::Mat base = gaussianBase(Yp, kTextureSigmaFrac, img.width, img.height);
+    cv::Mat base;
+    tiler.wide(Tiler::Slot::Texture, [&] {
+        base = gaussianBase(tiler.Yp, kTextureSigmaFrac, img);
+    });
 
     /* Positive uses the stronger kTextureGain; negative scales the detail down to zero
        at -1 (bandFactor clamps, so it lands on the base rather than inverting). */
     const float factor =
         LocalContrast::bandFactor(amt, (amt >= 0.0f) ? kTextureGain : 1.0f);
-    const float *bp = base.ptr<float>();
-    shapeAndFoldLuma(img, Yp.ptr<float>(), Ylin.data(), [=](size_t i, float yp) {
-        return LocalContrast::applyBand(yp, bp[i], factor);
+    const float *yp = tiler.Yp.ptr<float>();
+    const float *ylin = tiler.Ylin.data();
+    tiler.add(Tiler::Slot::Texture, [&img, base, yp, ylin, factor](const Tile &tile) {
+        const float *bp = base.ptr<float>();
+        foldLumaTile(img, yp, ylin, tile, [=](size_t i, int, int, float y) {
+            return LocalContrast::applyBand(y, bp[i], factor);
+        });
     });
 }
 
@@ -575,24 +1007,30 @@ void Develop::Texture(WorkingImage &img, const EditParams &p)
    Shares gaussianBase with Texture (the downscale trick keeps the wider blur cheap) and
    the perceptual-luma prep / ratio fold-back with every other band op. Math in
    Develop/localcontrast.h; no-op at 0. */
-void Develop::Clarity(WorkingImage &img, const EditParams &p)
+void Develop::Clarity(Tiler &tiler, const EditParams &p)
 {
     const float amt = p.clarity / kClarityFullScale;     // -1..1
     if (amt == 0.0f) return;
 
-    cv::Mat Yp;
-    std::vector<float> Ylin;
-    buildPerceptualLuma(img, Yp, Ylin);
+    WorkingImage &img = tiler.img;
+    tiler.syncLuma(Tiler::Slot::Clarity);
 
-    const cv::Mat base = gaussianBase(Yp, kClaritySigmaFrac, img.width, img.height);
-    const float *bp = base.ptr<float>();
+    cv::Mat base;
+    tiler.wide(Tiler::Slot::Clarity, [&] {
+        base = gaussianBase(tiler.Yp, kClaritySigmaFrac, img);
+    });
 
-    shapeAndFoldLuma(img, Yp.ptr<float>(), Ylin.data(), [=](size_t i, float yp) {
-        const float b = bp[i];
-        const float w = LocalContrast::midtoneWeight(yp) *
-                        LocalContrast::haloGuard(yp - b, kClarityHaloKnee);
-        const float factor = LocalContrast::bandFactor(amt * w, kClarityGain);
-        return LocalContrast::applyBand(yp, b, factor);
+    const float *yp = tiler.Yp.ptr<float>();
+    const float *ylin = tiler.Ylin.data();
+    tiler.add(Tiler::Slot::Clarity, [&img, base, yp, ylin, amt](const Tile &tile) {
+        const float *bp = base.ptr<float>();
+        foldLumaTile(img, yp, ylin, tile, [=](size_t i, int, int, float y) {
+            const float b = bp[i];
+            const float w = LocalContrast::midtoneWeight(y) *
+                            LocalContrast::haloGuard(y - b, kClarityHaloKnee);
+            const float factor = LocalContrast::bandFactor(amt * w, kClarityGain);
+            return LocalContrast::applyBand(y, b, factor);
+        });
     });
 }
 
@@ -600,84 +1038,92 @@ void Develop::Clarity(WorkingImage &img, const EditParams &p)
    contrast plus a contrast pull about a low pivot (deepens shadows / extends range, the look of
    clearing haze). Stage 2: a saturation lift (haze desaturates). Positive removes haze, negative
    adds it. Not a physical dark-channel-prior dehaze -- see notes/Documentation.txt. */
-void Develop::Dehaze(WorkingImage &img, const EditParams &p)
+void Develop::Dehaze(Tiler &tiler, const EditParams &p)
 {
     const float amt = p.dehaze / kDehazeFullScale;       // -1..1
     if (amt == 0.0f) return;
 
-    const int w = img.width;
-    const int h = img.height;
-    const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h);
-    float *rgb = img.rgb.data();
-
-    cv::Mat Yp;
-    std::vector<float> Ylin;
-    buildPerceptualLuma(img, Yp, Ylin);
+    WorkingImage &img = tiler.img;
+    tiler.syncLuma(Tiler::Slot::Dehaze);
 
     /* Large-radius base via a box blur: its running-sum cost is ~independent of kernel
        size, so the wide blur stays cheap even at full resolution -- which is why this op
        does NOT use gaussianBase like Texture and Clarity. */
-    const int rad = qMax(1, static_cast<int>(std::lround(static_cast<double>(kDehazeSigmaFrac) * qMax(w, h))));
+    const int rad = qMax(1, static_cast<int>(std::lround(static_cast<double>(kDehazeSigmaFrac) *
+                                                         frameLongEdge(img))));
     const int ksz = rad * 2 + 1;
     cv::Mat base;
-    cv::blur(Yp, base, cv::Size(ksz, ksz));
+    tiler.wide(Tiler::Slot::Dehaze, [&] { cv::blur(tiler.Yp, base, cv::Size(ksz, ksz)); });
 
     /* Stage 1: luminance local contrast + low-pivot contrast (ratio-preserving). The
        local
        contrast is the shared band expression: this op historically wrote it as
        yp + k*(yp-base), which is the same thing as base + (1+k)*(yp-base) in exact
        arithmetic and differs only in float rounding (~1e-7, far below one 8-bit code
-       value). tst_localcontrast pins the pre-extraction render to prove it stayed put. */
+       value). tst_localcontrast pins the pre-extraction render to prove it stayed put.
+       Stage 2, the saturation lift, runs on the tile straight after it. */
     const float factor = LocalContrast::bandFactor(amt, kDehazeLocalGain);
     const float cont  = amt * kDehazeContrast;
-    const float *bp = base.ptr<float>();
-    shapeAndFoldLuma(img, Yp.ptr<float>(), Ylin.data(), [=](size_t i, float yp) {
-        const float s = LocalContrast::applyBand(yp, bp[i], factor);
-        return kDehazePivot + (s - kDehazePivot) * (1.0f + cont);   // deepen shadows
-    });
-
-    /* Stage 2: saturation about per-pixel luminance (haze desaturates; dehaze restores). */
     const float sat = 1.0f + amt * kDehazeSat;
-    parallelFor(n, [=](size_t i0, size_t i1) {
-        for (size_t i = i0; i < i1; ++i) {
-            const float r = rgb[i * 3 + 0], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
-            const float Y2 = 0.2126f * r + 0.7152f * g + 0.0722f * b;
-            float nr = Y2 + sat * (r - Y2);
-            float ng = Y2 + sat * (g - Y2);
-            float nb = Y2 + sat * (b - Y2);
-            if (nr < 0.0f) nr = 0.0f;
-            if (ng < 0.0f) ng = 0.0f;
-            if (nb < 0.0f) nb = 0.0f;
-            rgb[i * 3 + 0] = nr;
-            rgb[i * 3 + 1] = ng;
-            rgb[i * 3 + 2] = nb;
+    const float *yp = tiler.Yp.ptr<float>();
+    const float *ylin = tiler.Ylin.data();
+    tiler.add(Tiler::Slot::Dehaze, [&img, base, yp, ylin, factor, cont, sat](const Tile &tile) {
+        const float *bp = base.ptr<float>();
+        foldLumaTile(img, yp, ylin, tile, [=](size_t i, int, int, float y) {
+            const float s = LocalContrast::applyBand(y, bp[i], factor);
+            return kDehazePivot + (s - kDehazePivot) * (1.0f + cont);   // deepen shadows
+        });
+
+        /* Stage 2: saturation about per-pixel luminance (haze desaturates; dehaze
+           restores). */
+        float *rgb = img.rgb.data();
+        const size_t stride = static_cast<size_t>(img.width);
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            const size_t end = y * stride + tile.x1;
+            for (size_t i = y * stride + tile.x0; i < end; ++i) {
+                const float r = rgb[i * 3 + 0], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+                const float Y2 = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+                float nr = Y2 + sat * (r - Y2);
+                float ng = Y2 + sat * (g - Y2);
+                float nb = Y2 + sat * (b - Y2);
+                if (nr < 0.0f) nr = 0.0f;
+                if (ng < 0.0f) ng = 0.0f;
+                if (nb < 0.0f) nb = 0.0f;
+                rgb[i * 3 + 0] = nr;
+                rgb[i * 3 + 1] = ng;
+                rgb[i * 3 + 2] = nb;
+            }
         }
     });
 }
 
-/* Vignette (spatial op #8, runs last). Per-pixel radial exposure gain about the centre;
-   see the constants block above for the mask/feather model. A pure per-pixel op (no
-   neighbourhood), but kept out of the fused point pass since it needs pixel coordinates,
-   not just the channel value. Custom / off-centre vignettes are handled by radial masks,
-   so this global op is centre-only. */
-void Develop::Vignette(WorkingImage &img, const EditParams &p)
+/* Vignette (spatial op #8). Per-pixel radial exposure gain about the centre; see the
+   constants block above for the mask/feather model. A pure per-pixel op (no
+   neighbourhood), but kept out of applyPointOps since it needs pixel coordinates, not
+   just the channel value; it rides the same tile pass as a stage of its own. Custom /
+   off-centre vignettes are handled by radial masks, so this global op is centre-only. */
+void Develop::Vignette(Tiler &tiler, const EditParams &p)
 {
     const float ev = p.vignetteExposure;                 // EV applied at the corners
     if (ev == 0.0f) return;
 
+    WorkingImage &img = tiler.img;
     const int w = img.width;
     const int h = img.height;
     if (w < 1 || h < 1) return;
-    const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h);
-    float *rgb = img.rgb.data();
 
     /* Elliptical normalisation: dx,dy in [-1,1] across the frame, so the radius reaches 1
        at the mid-edges and sqrt(2) at the corners; dividing by sqrt(2) puts full effect
-       at the corners. */
-    const float cx = (w - 1) * 0.5f;
-    const float cy = (h - 1) * 0.5f;
-    const float invHalfW = (w > 1) ? 2.0f / (w - 1) : 0.0f;
-    const float invHalfH = (h > 1) ? 2.0f / (h - 1) : 0.0f;
+       at the corners. The FRAME's centre and size, so a viewport window is vignetted as
+       its part of the frame (ox, oy place it). */
+    const int fw = img.frameWidth();
+    const int fh = img.frameHeight();
+    const int ox = img.frameX;
+    const int oy = img.frameY;
+    const float cx = (fw - 1) * 0.5f;
+    const float cy = (fh - 1) * 0.5f;
+    const float invHalfW = (fw > 1) ? 2.0f / (fw - 1) : 0.0f;
+    const float invHalfH = (fh > 1) ? 2.0f / (fh - 1) : 0.0f;
     const float invCorner = 0.70710678f;                 // 1 / sqrt(2)
 
     /* Feather -> falloff exponent. High feather spreads the effect inward (low k); low
@@ -686,19 +1132,22 @@ void Develop::Vignette(WorkingImage &img, const EditParams &p)
     const float k = kVignetteFeatherKMin +
                     (1.0f - feather) * (kVignetteFeatherKMax - kVignetteFeatherKMin);
 
-    parallelFor(n, [=](size_t i0, size_t i1) {
-        for (size_t i = i0; i < i1; ++i) {
-            const int x = static_cast<int>(i % static_cast<size_t>(w));
-            const int y = static_cast<int>(i / static_cast<size_t>(w));
-            const float dx = (x - cx) * invHalfW;         // -1..1
-            const float dy = (y - cy) * invHalfH;         // -1..1
-            float rn = std::sqrt(dx * dx + dy * dy) * invCorner;   // 0 centre -> 1 corner
-            if (rn > 1.0f) rn = 1.0f;
-            const float mask = std::pow(rn, k);           // 0 centre -> 1 corner
-            const float gain = std::exp2(ev * mask);      // ev stops at corner
-            rgb[i * 3 + 0] *= gain;
-            rgb[i * 3 + 1] *= gain;
-            rgb[i * 3 + 2] *= gain;
+    tiler.add(Tiler::Slot::Vignette, [&img, w, ox, oy, cx, cy, invHalfW, invHalfH, invCorner,
+                                      k, ev](const Tile &tile) {
+        float *rgb = img.rgb.data();
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            const float dy = ((oy + y) - cy) * invHalfH;  // -1..1
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                const size_t i = static_cast<size_t>(y) * w + x;
+                const float dx = ((ox + x) - cx) * invHalfW;   // -1..1
+                float rn = std::sqrt(dx * dx + dy * dy) * invCorner;   // 0 centre -> 1 corner
+                if (rn > 1.0f) rn = 1.0f;
+                const float mask = std::pow(rn, k);       // 0 centre -> 1 corner
+                const float gain = std::exp2(ev * mask);  // ev stops at corner
+                rgb[i * 3 + 0] *= gain;
+                rgb[i * 3 + 1] *= gain;
+                rgb[i * 3 + 2] *= gain;
+            }
         }
     });
 }
@@ -717,48 +1166,64 @@ void Develop::Vignette(WorkingImage &img, const EditParams &p)
    local edge strength so flat sky / skin is left alone. Both live in Develop/sharpen.h.
    The Gaussian here is small (sigma <= 3), so unlike Texture there is no downscale
    trick -- a separable blur at this radius is already cheap. No-op at amount 0. */
-void Develop::Sharpen(WorkingImage &img, const EditParams &p)
+void Develop::Sharpen(Tiler &tiler, const EditParams &p)
 {
     const float amount = qMax(0.0f, p.sharpenAmount);
     if (amount == 0.0f) return;
 
+    WorkingImage &img = tiler.img;
     const int w = img.width;
     const int h = img.height;
     if (w < 3 || h < 3) return;                      // no neighbourhood to work with
 
-    cv::Mat Yp;
-    std::vector<float> Ylin;
-    buildPerceptualLuma(img, Yp, Ylin);
+    tiler.syncLuma(Tiler::Slot::Sharpen);
 
     const float scale = (img.renderScale > 0.0f) ? img.renderScale : 1.0f;
     const float sigma = Sharpen::effectiveSigma(p.sharpenRadius, scale);
-
-    cv::Mat base;
-    cv::GaussianBlur(Yp, base, cv::Size(0, 0), sigma);
-
-    /* Edge strength for the mask gate. Only computed when Masking is actually engaged --
-       at 0 the gate is 1 everywhere and the Sobel pair would be pure waste. */
     const float masking = qBound(0.0f, p.sharpenMasking, 1.0f);
-    cv::Mat grad;
-    if (masking > 0.0f) {
-        /* Gradient of the BLURRED luma, so noise does not read as an edge. The 3x3 Sobel
-           kernel has a gain of 8 (a ramp of slope s answers 8s), so scale by 1/8 to get
-           the TRUE per-pixel slope -- Sharpen::maskKnee is expressed in perceptual-luma
-           units per pixel, and unscaled Sobel would open the gate ~8x too easily. */
-        constexpr double kSobelNorm = 1.0 / 8.0;
-        cv::Mat gx, gy;
-        cv::Sobel(base, gx, CV_32F, 1, 0, 3, kSobelNorm);
-        cv::Sobel(base, gy, CV_32F, 0, 1, 3, kSobelNorm);
-        cv::magnitude(gx, gy, grad);
-    }
-
     const float detail = qBound(0.0f, p.sharpenDetail, 1.0f);
-    const float *bp = base.ptr<float>();
-    const float *gp = grad.empty() ? nullptr : grad.ptr<float>();
-    shapeAndFoldLuma(img, Yp.ptr<float>(), Ylin.data(), [=](size_t i, float yp) {
-        const float gm = gp ? gp[i] : 0.0f;
-        return Sharpen::applyPixel(yp, bp[i], gm, amount, detail, masking, scale);
-    });
+
+    /* Per tile, with a halo. GaussianBlur on an ROI of the shared luma reads the rows and
+       columns beyond it from the parent plane (OpenCV extrapolates only at the real frame
+       edge), so the blur's own ~4-sigma reach needs nothing here; the gradient reads the
+       BLURRED luma one pixel out, so the blurred rect is the tile grown by one while
+       Masking is engaged. Nothing frame-sized is allocated. */
+    const int halo = (masking > 0.0f) ? 1 : 0;
+    const cv::Mat Yp = tiler.Yp;
+    const float *ylin = tiler.Ylin.data();
+    tiler.add(Tiler::Slot::Sharpen, [=, &img](const Tile &tile) {
+        const int gx0 = qMax(0, tile.x0 - halo), gy0 = qMax(0, tile.y0 - halo);
+        const int gx1 = qMin(w, tile.x1 + halo), gy1 = qMin(h, tile.y1 + halo);
+        cv::Mat base;
+        cv::GaussianBlur(Yp(cv::Rect(gx0, gy0, gx1 - gx0, gy1 - gy0)), base,
+                         cv::Size(0, 0), sigma);
+
+        /* Edge strength for the mask gate. Only computed when Masking is actually
+           engaged -- at 0 the gate is 1 everywhere and the Sobel pair would be pure
+           waste. */
+        cv::Mat grad;
+        if (masking > 0.0f) {
+            /* Gradient of the BLURRED luma, so noise does not read as an edge. The 3x3
+               Sobel kernel has a gain of 8 (a ramp of slope s answers 8s), so scale by 1/8
+               to get the TRUE per-pixel slope -- Sharpen::maskKnee is expressed in
+               perceptual-luma units per pixel, and unscaled Sobel would open the gate ~8x
+               too easily. */
+            constexpr double kSobelNorm = 1.0 / 8.0;
+            cv::Mat gx, gy;
+            cv::Sobel(base, gx, CV_32F, 1, 0, 3, kSobelNorm);
+            cv::Sobel(base, gy, CV_32F, 0, 1, 3, kSobelNorm);
+            cv::magnitude(gx, gy, grad);
+        }
+
+        const float *bp = base.ptr<float>();
+        const float *gp = grad.empty() ? nullptr : grad.ptr<float>();
+        const size_t bw = static_cast<size_t>(base.cols);
+        foldLumaTile(img, Yp.ptr<float>(), ylin, tile, [=](size_t, int x, int y, float v) {
+            const size_t j = (y - gy0) * bw + (x - gx0);
+            const float gm = gp ? gp[j] : 0.0f;
+            return Sharpen::applyPixel(v, bp[j], gm, amount, detail, masking, scale);
+        });
+    }, /*readsHalo*/ true);
 }
 
 /* Grain (spatial op #9, runs LAST). Monochromatic film grain: a deterministic noise field
@@ -767,72 +1232,85 @@ void Develop::Sharpen(WorkingImage &img, const EditParams &p)
    luminance and folded back as a ratio-preserving RGB scale (like Texture) so only the
    luminance is perturbed. A midtone weight fades the grain toward pure black / white. See
    the grain constants block for the size / roughness / proxy-match model. No-op at 0. */
-void Develop::Grain(WorkingImage &img, const EditParams &p)
+void Develop::Grain(Tiler &tiler, const EditParams &p)
 {
     const float amount = qBound(0.0f, p.grainAmount, 1.0f);
     if (amount == 0.0f) return;
 
+    WorkingImage &img = tiler.img;
     const int w = img.width;
     const int h = img.height;
     if (w < 1 || h < 1) return;
-    const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h);
-    float *rgb = img.rgb.data();
     const float white = (img.white > 0.0f) ? img.white : 1.0f;
     const float invWhite = 1.0f / white;
 
     /* Grain cell size in pixels: scales with the long edge (so the proxy and full-res
        render show the same grain proportionally) and grows with grainSize (fine to
-       coarse). The noise grid divides the image into cells: bigger cell = bigger grain. */
+       coarse). The noise grid divides the FRAME into cells: bigger cell = bigger grain.
+       A viewport window samples the same grid at its own offset (fw, fh, ox, oy). */
+    const int fw = img.frameWidth();
+    const int fh = img.frameHeight();
+    const int ox = img.frameX;
+    const int oy = img.frameY;
     const float size01 = qBound(0.0f, p.grainSize, 1.0f);
-    const double unit = qMax(1.0, static_cast<double>(qMax(w, h)) / kGrainCellUnit);
+    const double unit = qMax(1.0, static_cast<double>(qMax(fw, fh)) / kGrainCellUnit);
     const double cellPx = unit * (kGrainCellMin + size01 * (kGrainCellMax - kGrainCellMin));
-    const int nw = qMax(1, static_cast<int>(std::lround(w / cellPx)));
-    const int nh = qMax(1, static_cast<int>(std::lround(h / cellPx)));
+    const int nw = qMax(1, static_cast<int>(std::lround(fw / cellPx)));
+    const int nh = qMax(1, static_cast<int>(std::lround(fh / cellPx)));
 
     /* Fixed-seed noise -> stable across re-renders (no shimmer). Grain N(0,1) on the cell
-       grid, upsampled to full res; the roughness field is a coarser [0,1] grid that patchily
-       modulates the grain amplitude (0 roughness = uniform, 1 = strongly varying). */
-    cv::RNG rng(kGrainSeed);
-    cv::Mat grainSmall(nh, nw, CV_32FC1);
-    rng.fill(grainSmall, cv::RNG::NORMAL, 0.0, 1.0);
-    cv::Mat grain;
-    cv::resize(grainSmall, grain, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
-
+       grid, upsampled to full res a tile at a time; the roughness field is a coarser
+       [0,1] grid that patchily modulates the grain amplitude (0 roughness = uniform, 1 =
+       strongly varying). */
     const float rough01 = qBound(0.0f, p.grainRoughness, 1.0f);
-    cv::Mat roughUp;
-    if (rough01 > 0.0f) {
-        const int rw = qMax(1, nw / kGrainRoughFreqDiv);
-        const int rh = qMax(1, nh / kGrainRoughFreqDiv);
-        cv::Mat roughSmall(rh, rw, CV_32FC1);
-        rng.fill(roughSmall, cv::RNG::UNIFORM, 0.0, 1.0);
-        cv::resize(roughSmall, roughUp, cv::Size(w, h), 0, 0, cv::INTER_LINEAR);
-    }
+    cv::Mat grainSmall(nh, nw, CV_32FC1);
+    cv::Mat roughSmall;
+    tiler.wide(Tiler::Slot::Grain, [&] {
+        cv::RNG rng(kGrainSeed);
+        rng.fill(grainSmall, cv::RNG::NORMAL, 0.0, 1.0);
+        if (rough01 > 0.0f) {
+            const int rw = qMax(1, nw / kGrainRoughFreqDiv);
+            const int rh = qMax(1, nh / kGrainRoughFreqDiv);
+            roughSmall.create(rh, rw, CV_32FC1);
+            rng.fill(roughSmall, cv::RNG::UNIFORM, 0.0, 1.0);
+        }
+    });
 
     const float strength = amount * kGrainStrength;
-    const float *gp = grain.ptr<float>();
-    const float *rp = roughUp.empty() ? nullptr : roughUp.ptr<float>();
-    constexpr float kEps = 1e-6f;
-    parallelFor(n, [=](size_t i0, size_t i1) {
-        for (size_t i = i0; i < i1; ++i) {
-            const float r = rgb[i * 3 + 0], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
-            const float Y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
-            if (Y <= kEps) continue;
-            float nrm = Y * invWhite;
-            if (nrm < 0.0f) nrm = 0.0f;
-            const float s = std::pow(nrm, kInvGamma);
-            /* Midtone weight: peaks at mid-grey, fades to 0 at black / white; sqrt broadens
-               it so shadows and highlights still carry some grain. Shared with Clarity --
-               the expression is unchanged, so grain renders exactly as before. */
-            const float lw = LocalContrast::midtoneWeight(s);
-            /* Roughness: mean-1 amplitude that varies more as roughness rises (u in [0,1]). */
-            const float amp = rp ? (1.0f - rough01 + rough01 * 2.0f * rp[i]) : 1.0f;
-            float s2 = s + strength * lw * amp * gp[i];
-            if (s2 < 0.0f) s2 = 0.0f;
-            const float Yd = std::pow(s2, kGamma) * white;
-            const float ratio = Yd / Y;
-            rgb[i * 3 + 0] = r * ratio;
-            rgb[i * 3 + 1] = g * ratio;
-            rgb[i * 3 + 2] = b * ratio;
+    const bool doRough = !roughSmall.empty();
+    tiler.add(Tiler::Slot::Grain, [=, &img](const Tile &tile) {
+        LinearUpsample grain(grainSmall, fw, fh, tile, ox, oy);
+        LinearUpsample rough(doRough ? roughSmall : grainSmall, fw, fh, tile, ox, oy);
+        float *rgb = img.rgb.data();
+        constexpr float kEps = 1e-6f;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            grain.row(y);
+            if (doRough) rough.row(y);
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                const size_t i = static_cast<size_t>(y) * w + x;
+                const float r = rgb[i * 3 + 0], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+                const float Y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+                if (Y <= kEps) continue;
+                float nrm = Y * invWhite;
+                if (nrm < 0.0f) nrm = 0.0f;
+                const float s = std::pow(nrm, kInvGamma);
+                /* Midtone weight: peaks at mid-grey, fades to 0 at black / white; sqrt
+                   broadens it so shadows and highlights still carry some grain. Shared
+                   with Clarity -- the expression is unchanged, so grain renders exactly
+                   as before. */
+                const float lw = LocalContrast::midtoneWeight(s);
+                /* Roughness: mean-1 amplitude that varies more as roughness rises (u in
+                   [0,1]). */
+                const float amp = doRough ? (1.0f - rough01 + rough01 * 2.0f * rough.at(x))
+                                          : 1.0f;
+                float s2 = s + strength * lw * amp * grain.at(x);
+                if (s2 < 0.0f) s2 = 0.0f;
+                const float Yd = std::pow(s2, kGamma) * white;
+                const float ratio = Yd / Y;
+                rgb[i * 3 + 0] = r * ratio;
+                rgb[i * 3 + 1] = g * ratio;
+                rgb[i * 3 + 2] = b * ratio;
+            }
         }
     });
 }
@@ -864,6 +1342,7 @@ Develop::PointCoeffs Develop::buildPointCoeffs(const EditParams &p, const Workin
     c.channelGain[2] = wbGain[2] * exposureGain * bGain;
 
     c.white = (img.white > 0.0f ? img.white : 1.0f);
+    c.invGamma = kInvGamma;
 
     /* Perceptual tone curve = contrast + the four tone-region controls + the Curves
        panel's point curves, baked into a per-channel 1-D LUT (see PointCoeffs). Everything here is in the PERCEPTUAL (gamma) domain, NOT scene-linear:
@@ -987,175 +1466,17 @@ void Develop::ParametricCurve(const EditParams &p, float *out, int n)
     }
 }
 
-void Develop::applyPointOps(WorkingImage &img, const PointCoeffs &c)
+void Develop::applyPointOps(WorkingImage &img, const PointCoeffs &c, const PointLut *lut,
+                            const Tile &t)
 {
-    const int w = img.width;
-    const int h = img.height;
-    float *rgb = img.rgb.data();
-
-    const float g0 = c.channelGain[0];
-    const float g1 = c.channelGain[1];
-    const float g2 = c.channelGain[2];
-    const float white = c.white;
-    const float invWhite = 1.0f / white;
-    const bool doGain = (g0 != 1.0f) || (g1 != 1.0f) || (g2 != 1.0f);
-    const bool doTone = c.toneActive;
-    const bool doCal  = c.calActive;
-    const bool doHsl  = c.hslActive;
-    const bool doGrade = c.gradeActive;
-
-    /* Calibration matrix, local so the block folds into the inner loop like the rest. */
-    const float cm0 = c.calMat[0], cm1 = c.calMat[1], cm2 = c.calMat[2];
-    const float cm3 = c.calMat[3], cm4 = c.calMat[4], cm5 = c.calMat[5];
-    const float cm6 = c.calMat[6], cm7 = c.calMat[7], cm8 = c.calMat[8];
-
-    /* HSL coeffs (cross-channel, applied after the tone curve). Locals so they fold into the
-       inner loop the same way the gain/tone constants do. */
-    const float hm0 = c.hueMat[0], hm1 = c.hueMat[1], hm2 = c.hueMat[2];
-    const float hm3 = c.hueMat[3], hm4 = c.hueMat[4], hm5 = c.hueMat[5];
-    const float hm6 = c.hueMat[6], hm7 = c.hueMat[7], hm8 = c.hueMat[8];
-    const float satF = c.satFactor;
-    const float vibA = c.vibAmount;
-    const bool  doVib = (vibA != 0.0f);
-    const float lumG = c.lumGain;
-
-    /* Colour-grading coeffs (per-range zero-luma tint + luminance delta). Locals so the
-       grade block folds into the inner loop like the HSL constants. Tonal weights split the
-       pixel's PERCEPTUAL lightness (gamma-encoded luma), matching the slider feel. */
-    const float gt00 = c.gradeTint[0][0], gt01 = c.gradeTint[0][1], gt02 = c.gradeTint[0][2];
-    const float gt10 = c.gradeTint[1][0], gt11 = c.gradeTint[1][1], gt12 = c.gradeTint[1][2];
-    const float gt20 = c.gradeTint[2][0], gt21 = c.gradeTint[2][1], gt22 = c.gradeTint[2][2];
-    /* Range 3 is Global: no tonal window, so it is added at weight 1. */
-    const float gt30 = c.gradeTint[3][0], gt31 = c.gradeTint[3][1], gt32 = c.gradeTint[3][2];
-    const float gl0 = c.gradeLum[0], gl1 = c.gradeLum[1], gl2 = c.gradeLum[2];
-    const float gl3 = c.gradeLum[3];
-    const float gShadowEnd = c.gradeShadowEnd, gHighStart = c.gradeHighStart;
-
-    /* Perceptual tone curve via the precomputed LUT (contrast + tone regions, see
-       buildPointCoeffs). The table is indexed by the perceptual value s = (v/white)^(1/gamma)
-       and already returns the white-normalised linear output, so the only transcendental in the
-       hot loop is the single encode pow. Constants are local so they fold into the inner loop. */
-    const float *lutR = c.toneLut[0];
-    const float *lutG = c.toneLut[1];
-    const float *lutB = c.toneLut[2];
-    const int lutLast = PointCoeffs::kLutSize - 1;
-    const float lutScale = lutLast / c.toneLutSMax;
-    /* `lut` is the channel's own table -- the three differ only when a per-channel
-       Curves R/G/B curve is in play, and are byte-identical otherwise. */
-    auto toneCh = [=](const float *lut, float v) -> float {
-        float n = v * invWhite;
-        if (n < 0.0f) n = 0.0f;
-        const float s = std::pow(n, kInvGamma);
-        float fi = s * lutScale;
-        if (fi >= lutLast) return lut[lutLast] * white;      // clamp above the table's domain
-        const int i = static_cast<int>(fi);
-        const float frac = fi - i;
-        return (lut[i] + (lut[i + 1] - lut[i]) * frac) * white;
-    };
-
-    /* One fused per-pixel kernel over a band of rows. Point ops apply PER CHANNEL (R,G,B
-       interleaved), so the inner loop walks a pixel at a time: per-channel linear gain (white
-       balance + exposure) then the perceptual tone curve, matching the fixed pipeline order
-       (WB/exposure in scene-linear, contrast + tone regions in the gamma domain). */
-    auto processRows = [=](int y0, int y1) {
-        const int span = w * 3;
-        for (int y = y0; y < y1; ++y) {
-            float *row = rgb + static_cast<size_t>(y) * span;
-            for (int x = 0; x < w; ++x) {
-                float *px = row + static_cast<size_t>(x) * 3;
-                if (doGain) { px[0] *= g0; px[1] *= g1; px[2] *= g2; }
-                if (doCal) {
-                    /* Re-point the primaries in LINEAR light, before any tone shaping.
-                       The matrix fixes the neutral axis, so greys pass through. */
-                    const float r = px[0], g = px[1], b = px[2];
-                    float cr = cm0 * r + cm1 * g + cm2 * b;
-                    float cg = cm3 * r + cm4 * g + cm5 * b;
-                    float cb = cm6 * r + cm7 * g + cm8 * b;
-                    px[0] = (cr < 0.0f) ? 0.0f : cr;
-                    px[1] = (cg < 0.0f) ? 0.0f : cg;
-                    px[2] = (cb < 0.0f) ? 0.0f : cb;
-                }
-                if (doTone) {
-                    px[0] = toneCh(lutR, px[0]);
-                    px[1] = toneCh(lutG, px[1]);
-                    px[2] = toneCh(lutB, px[2]);
-                }
-                if (doHsl) {
-                    float r = px[0], g = px[1], b = px[2];
-                    /* Hue: rotate about the neutral axis (identity matrix when hue == 0). */
-                    const float hr = hm0 * r + hm1 * g + hm2 * b;
-                    const float hg = hm3 * r + hm4 * g + hm5 * b;
-                    const float hb = hm6 * r + hm7 * g + hm8 * b;
-                    /* Saturation: scale chroma about Rec.709 luma. Vibrance adds a
-                       per-pixel boost weighted by (1 - HSV saturation), so muted pixels
-                       move more than already-saturated ones; the two factors combine
-                       multiplicatively. */
-                    const float Y = 0.2126f * hr + 0.7152f * hg + 0.0722f * hb;
-                    float sF = satF;
-                    if (doVib) {
-                        const float mx = (hr > hg ? (hr > hb ? hr : hb) : (hg > hb ? hg : hb));
-                        const float mn = (hr < hg ? (hr < hb ? hr : hb) : (hg < hb ? hg : hb));
-                        const float pxSat = (mx > 1e-6f) ? (mx - mn) / mx : 0.0f;  // 0..1
-                        sF *= 1.0f + vibA * (1.0f - pxSat);
-                        if (sF < 0.0f) sF = 0.0f;        // never invert chroma
-                    }
-                    r = (Y + sF * (hr - Y)) * lumG;       // luminance: uniform gain
-                    g = (Y + sF * (hg - Y)) * lumG;
-                    b = (Y + sF * (hb - Y)) * lumG;
-                    px[0] = (r < 0.0f) ? 0.0f : r;
-                    px[1] = (g < 0.0f) ? 0.0f : g;
-                    px[2] = (b < 0.0f) ? 0.0f : b;
-                }
-                if (doGrade) {
-                    /* Split the pixel's perceptual lightness into three smooth tonal
-                       windows (shadows/mid/highlights, weights sum to 1), then apply each
-                       range's luminance gain + zero-luma chroma tint, weighted by its
-                       window -- plus the Global range, which is not tone-selective and so
-                       rides in at weight 1. Tint is in 0..1 RGB units, scaled to the
-                       working range by white. The perceptual encode pow is the only
-                       transcendental. */
-                    float Yg = 0.2126f * px[0] + 0.7152f * px[1] + 0.0722f * px[2];
-                    float n = Yg * invWhite;
-                    if (n < 0.0f) n = 0.0f; else if (n > 1.0f) n = 1.0f;
-                    const float L = std::pow(n, kInvGamma);          // perceptual 0..1
-                    float wS, wM, wH;
-                    ColorGrade::gradeTonalWeights(L, gShadowEnd, gHighStart, wS, wM, wH);
-                    const float lumMul = 1.0f + wS * gl0 + wM * gl1 + wH * gl2 + gl3;
-                    const float tR = (wS * gt00 + wM * gt10 + wH * gt20 + gt30) * white;
-                    const float tG = (wS * gt01 + wM * gt11 + wH * gt21 + gt31) * white;
-                    const float tB = (wS * gt02 + wM * gt12 + wH * gt22 + gt32) * white;
-                    float r = px[0] * lumMul + tR;
-                    float g = px[1] * lumMul + tG;
-                    float b = px[2] * lumMul + tB;
-                    px[0] = (r < 0.0f) ? 0.0f : r;
-                    px[1] = (g < 0.0f) ? 0.0f : g;
-                    px[2] = (b < 0.0f) ? 0.0f : b;
-                }
-            }
-        }
-    };
-
-    /* Data-parallel over row ranges within this single render (QtConcurrent + the global
-       pool, the same idiom as FocusStack). The interactive edit is one image, so splitting
-       its rows is what uses all cores; a background decoder that also calls render() shares
-       the fixed-size pool, which bounds oversubscription. */
-    const int maxThreads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
-    const int kMinRowsPerChunk = 64;
-    if (maxThreads == 1 || h < kMinRowsPerChunk * 2) {
-        processRows(0, h);
-        return;
-    }
-
-    const int chunks = qMin(maxThreads, (h + kMinRowsPerChunk - 1) / kMinRowsPerChunk);
-    const int rowsPerChunk = (h + chunks - 1) / chunks;
-    QVector<QFuture<void>> futures;
-    futures.reserve(chunks);
-    for (int k = 0; k < chunks; ++k) {
-        const int y0 = k * rowsPerChunk;
-        const int y1 = qMin(h, y0 + rowsPerChunk);
-        if (y0 >= y1) break;
-        futures.append(QtConcurrent::run(QThreadPool::globalInstance(),
-                                         [processRows, y0, y1]() { processRows(y0, y1); }));
+    /* Gain + calibration in scene-linear, then the perceptual tone curve, HSL and the grade
+       (see PointCoeffs for each block). The kernel runs the tile a row at a time through
+       planar runs, eight pixels per step at the AVX2 level (Develop/pointkernels.h); the
+       baked table takes the same rows (Develop/pointlut.h). */
+    const size_t span = static_cast<size_t>(img.width) * 3;
+    for (int y = t.y0; y < t.y1; ++y) {
+        float *row = img.rgb.data() + y * span + static_cast<size_t>(t.x0) * 3;
+        if (lut) lut->ApplyInterleaved(row, t.x1 - t.x0);
+        else PointKernels::ApplyInterleaved(row, t.x1 - t.x0, c);
     }
-    for (QFuture<void> &f : futures) f.waitForFinished();
 }
@@ -3,26 +3,39 @@
 
 #include "Develop/editparams.h"
 #include "Develop/workingimage.h"
+#include "Develop/pointkernels.h"
+#include "Develop/pointlut.h"
 #include <QtGlobal>
 
 /*
-    Applies parametric develop adjustments to a WorkingImage in place. Stateless and
-    reentrant, constructed per decode (same discipline as Demosaic / RawFormat) so it
-    carries no cross-thread state.
+    Applies parametric develop adjustments to a WorkingImage in place. Reentrant,
+    constructed per decode (same discipline as Demosaic / RawFormat) so it carries no
+    cross-thread state; its one setting, setPointPath, is per instance.
 
     The operation order is fixed and hard-coded (Lightroom-like); order matters and is not a
     caller concern. Ops are split by cost (see notes/Documentation.txt "Scope & masking
     model"):
 
-        SPATIAL ops (denoise, texture, dehaze) need a neighbourhood, so each owns a full-image
-        pass. Denoise runs first; texture and dehaze run after the point pass. Each is a no-op
-        when its slider is 0.
-
         POINT ops (white balance, exposure, contrast, tone regions) are pure per-pixel functions,
-        so they are FUSED into a single parallel pass: coefficients are precomputed once from
-        EditParams, then applied per pixel in one loop over the image. This is the slider-drag
-        hot path. All Basic sliders are now implemented; the proxy/coalesce preview pipeline
-        (MW::renderDevelopPreview) keeps spatial-op cost off the interactive drag.
+        so they are FUSED into a single kernel: coefficients are precomputed once from
+        EditParams, then applied per pixel. This is the slider-drag hot path. All Basic sliders
+        are now implemented; the proxy/coalesce preview pipeline (MW::renderDevelopPreview)
+        keeps spatial-op cost off the interactive drag.
+
+        SPATIAL ops need a neighbourhood. Each is a no-op when its slider is 0.
+
+    Tiling. Everything after Denoise runs as FUSED TILE PASSES (Develop::Tiler): the frame is
+    cut into kTile x kTile squares handed to the global QThreadPool, and each tile runs every
+    queued op back to back while its pixels are still in cache, instead of each op streaming
+    the whole frame through memory on its own. A pass ends only where an op needs the whole
+    frame first -- the blurred base of Texture, Clarity and Dehaze (a frame-wide blur at
+    reduced resolution, far cheaper than a per-tile halo of their 3-sigma reach) and the
+    luma Sharpen reads a halo of. The band ops share one perceptual-luma plane, re-derived
+    in the same tile pass that last changed the pixels rather than by a pass of its own.
+    Sharpen and Grain are tile-local: Sharpen blurs its tile plus a halo of the shared
+    luma sized to its kernel, Grain upsamples its noise field per tile. Denoise stays a
+    frame-wide op ahead of the passes (its bilateral runs at a bounded resolution). The
+    result does not depend on the tile size or the thread count.
 */
 class Develop
 {
@@ -34,7 +47,14 @@ public:
     struct StageTimings { qint64 denoiseMs = 0; qint64 pointMs = 0; qint64 textureMs = 0;
                           qint64 clarityMs = 0; qint64 dehazeMs = 0;
                           qint64 vignetteMs = 0; qint64 sharpenMs = 0;
-                          qint64 grainMs = 0; };
+                          qint64 grainMs = 0;
+                          /* The fused tile passes. An op's field above is its frame-wide
+                             work plus its share of each pass's wall-clock, split by the
+                             CPU time its stage took across the pass's tiles -- so the
+                             fields still add up to the whole Apply(). tileCpuUs is that
+                             CPU time summed over every tile; tileMaxUs the slowest tile. */
+                          int tilePasses = 0; int tiles = 0;
+                          qint64 tileCpuUs = 0; qint64 tileMaxUs = 0; };
 
     /* Apply p to img in place. Returns true on success (and trivially when p is identity,
        leaving img untouched). Fills *t when non-null. */
@@ -59,7 +79,33 @@ public:
     */
     static void ParametricCurve(const EditParams &p, float *out, int n);
 
+    /* How far, in full-resolution pixels, p's spatial ops reach on a frameW x frameH frame:
+       a developed pixel depends on source pixels up to this far away (the active ops'
+       reaches add, each blurring what the one before produced). A viewport render
+       (WorkingImageCache::renderWindow) develops its rect grown by this much, so the part
+       it keeps matches the full-frame render. 0 when only per-pixel ops are active. */
+    static int halo(const EditParams &p, int frameW, int frameH);
+
+    static constexpr int kTile = 256;   // tile edge (px): ~1.5 MB of RGB + luma + base
+    struct Tile { int x0, y0, x1, y1; };        // rect [x0,x1) x [y0,y1)
+
+    /* Tests only: run with tileEdge x tileEdge tiles (0 restores kTile). An edge at least
+       as large as the frame runs the chain as one full-frame tile -- the untiled reference
+       the tiled render must match. Process-wide, like Winnow::Simd::setLevel. */
+    static void setTileEdge(int tileEdge);
+
+    /* How the fused point pass evaluates its chain. Direct runs it per pixel; Lut bakes it
+       into a 3D table once per Apply and interpolates (Develop/pointlut.h) -- an
+       approximation, for the drag ticks a slider waits on. Frames below
+       PointLut::kMinPixels run Direct either way. */
+    enum class PointPath { Direct, Lut };
+    void setPointPath(PointPath path) { pointPath = path; }
+
 private:
+    PointPath pointPath = PointPath::Direct;
+
+    class Tiler;                                // fused tile passes + shared luma (develop.cpp)
+
     /* Spatial op: local (maskable) NR, owns a full-image pass, run BEFORE the fused point pass
        (fixed pipeline order). Two independent strengths: EditParams::localDenoiseLuma = luminance
        NR (ratio-preserving, chroma untouched); EditParams::localDenoiseChroma = colour/chroma NR
@@ -74,7 +120,7 @@ private:
        band; positive texture amplifies it, negative attenuates it. The base radius scales with
        image size so the proxy preview matches the full-res result. Runs AFTER the point pass.
        No-op when EditParams::texture is 0. */
-    void Texture(WorkingImage &img, const EditParams &p);
+    void Texture(Tiler &tiler, const EditParams &p);
 
     /* Spatial op (pipeline #6.5): mid-radius luminance local contrast, between Texture
        (~13px) and Dehaze (~170px) on an 8640px edge, so the three occupy separate bands
@@ -83,13 +129,13 @@ private:
        (it will not crush blacks or flatten highlights) and rolled off at strong edges
        (where a band this wide would ring). Ratio-preserving on luminance like the rest;
        shares gaussianBase with Texture. Math in Develop/localcontrast.h. No-op at 0. */
-    void Clarity(WorkingImage &img, const EditParams &p);
+    void Clarity(Tiler &tiler, const EditParams &p);
 
     /* Spatial op (pipeline #7): an APPROXIMATE dehaze (not dark-channel-prior) -- large-radius
        luminance local contrast + a contrast pull about a low pivot (deepens shadows / extends
        range) + a saturation boost, since haze flattens contrast and desaturates. Positive
        removes haze, negative adds it. No-op when EditParams::dehaze is 0. */
-    void Dehaze(WorkingImage &img, const EditParams &p);
+    void Dehaze(Tiler &tiler, const EditParams &p);
 
     /* Spatial op (pipeline #8, runs LAST): a radial exposure vignette about the image
        centre. vignetteExposure is the EV applied at the corners (negative darkens = the
@@ -97,7 +143,7 @@ private:
        vignetteFeather (0..1) shapes the falloff (high = gradual/reaches inward, low =
        concentrated in the corners). Custom / off-centre vignettes are done with radial
        masks, so this global op is just the two sliders. No-op when the EV is 0. */
-    void Vignette(WorkingImage &img, const EditParams &p);
+    void Vignette(Tiler &tiler, const EditParams &p);
 
     /* Spatial op (pipeline #8.5, between Vignette and Grain): capture sharpening, an
        unsharp mask on perceptual luminance, ratio-preserving like Texture/Denoise. Placed
@@ -110,7 +156,7 @@ private:
        for a proxy. The proxy preview is therefore scale-honest but only true at 1:1.
        Distinct from Texture, a resolution-proportional mid-frequency band -- the two
        occupy disjoint bands and stack. Math in Develop/sharpen.h. No-op at amount 0. */
-    void Sharpen(WorkingImage &img, const EditParams &p);
+    void Sharpen(Tiler &tiler, const EditParams &p);
 
     /* Spatial op (pipeline #9, runs LAST -- after Sharpen): monochromatic film grain
        added to luminance (ratio-preserving, like Texture/Denoise). Deterministic
@@ -118,79 +164,17 @@ private:
        size scales with the image so the proxy preview matches full res. grainAmount is
        the strength, grainSize the particle size, grainRoughness the amplitude
        irregularity. No-op when grainAmount is 0. */
-    void Grain(WorkingImage &img, const EditParams &p);
-
-    /* Precomputed once per Apply(); the fused point pass reads only these. active == false
-       means no implemented point op would change a pixel, so the pass is skipped entirely. */
-    struct PointCoeffs {
-        bool  active        = false;
-        /* Per-channel scene-linear gain = white balance (temp/tint) folded with exposure (2^EV)
-           AND the Colour RGB sliders (red/green/blue). All are pure linear multiplies, so they
-           commute and combine into one per-channel factor applied before the perceptual tone
-           curve. {1,1,1} = identity. */
-        float channelGain[3] = {1.0f, 1.0f, 1.0f};
-        float white         = 1.0f;   // linear value that maps to display white
-
-        /* Perceptual-domain tone curve: contrast, the four tone-region controls
-           (highlights/shadows/whites/blacks) and the Curves panel's tone curve are all
-           pure 1-D functions of a channel's white-normalised value, so they are baked
-           once into a lookup table. The table is indexed by the perceptual value
-           s = (v/white)^(1/gamma) in [0, toneLutSMax] and returns the white-normalised
-           LINEAR output (i.e. it folds the gamma decode back in), so the hot loop does
-           one pow (encode) + one interpolated lookup instead of several pow/exp per
-           pixel.
-           toneActive == false => identity tone curve (skip it).
-
-           THREE tables, one per channel, because the Curves panel carries separate Red /
-           Green / Blue curves on top of its RGB composite. Everything shared -- contrast,
-           the region lifts, the composite curve -- is computed once and written into all
-           three, so the extra cost is the table build, not the hot loop (which does the
-           same single lookup either way, just into toneLut[ch]). */
-        static constexpr int kLutSize = 1024;
-        bool  toneActive = false;
-        float toneLutSMax = 1.0f;          // perceptual s domain the table spans is [0, this]
-        /* s -> white-normalised linear output, one table per channel. */
-        float toneLut[3][kLutSize] = {};
-
-        /* Calibration (Calibrate panel) -- a 3x3 matrix (row-major) re-pointing the R/G/B
-           primaries, applied in LINEAR light right after channelGain and BEFORE the tone
-           curve. Its columns are the rotated/chroma-scaled primaries, built so neutrals
-           are fixed. calActive == false => identity (skip the block). */
-        bool  calActive = false;
-        float calMat[9] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
-
-        /* HSL (hue/saturation/luminance) -- a cross-channel point op applied AFTER the
-           tone curve in the same fused pass (it mixes the three channels, so unlike the
-           tone curve it cannot be a per-channel LUT). hueMat is a 3x3 rotation about the
-           neutral axis (row-major, used only when hue != 0); satFactor scales chroma
-           about luma; vibAmount is a per-pixel saturation boost weighted by how muted the
-           pixel already is (0 = off); lumGain is a uniform gain. hslActive == false =>
-           identity (skip the block). */
-        bool  hslActive  = false;
-        float hueMat[9]  = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
-        float satFactor  = 1.0f;
-        float vibAmount  = 0.0f;
-        float lumGain    = 1.0f;
-
-        /* Colour grading (Color Grade panel) -- tonal-range tinting applied after HSL in
-           the same fused pass. For each of the four ranges [0]=shadows, [1]=midtones,
-           [2]=highlights, [3]=GLOBAL: gradeTint is a zero-luma RGB chroma push (hue+sat
-           pre-scaled) ADDED to the pixel, gradeLum a per-range luminance gain delta.
-           Ranges 0-2 are weighted per pixel by smooth tonal windows of the pixel's luma;
-           range 3 is NOT tone-selective and applies at weight 1 everywhere, so it needs
-           no window (see applyPointOps). gradeShadowEnd / gradeHighStart are those
-           windows' split points, derived once from the panel's Blending + Balance
-           sliders. gradeActive == false => identity (skip the block). */
-        bool  gradeActive = false;
-        float gradeTint[4][3] = {};   // [range][rgb], zero-luma chroma offset
-        float gradeLum[4]     = {};   // [range] luminance gain delta (0 = none)
-        float gradeShadowEnd  = 0.5f; // perceptual L where the shadow window closes
-        float gradeHighStart  = 0.5f; // perceptual L where the highlight window opens
-    };
+    void Grain(Tiler &tiler, const EditParams &p);
+
+    /* Precomputed once per Apply(); the fused point pass reads only these. Defined with
+       the kernel that reads them (Develop/pointkernels.h). */
+    using PointCoeffs = PointKernels::Coeffs;
     static PointCoeffs buildPointCoeffs(const EditParams &p, const WorkingImage &img);
 
-    /* The fused per-pixel pass, parallelised over row ranges. */
-    void applyPointOps(WorkingImage &img, const PointCoeffs &c);
+    /* The fused per-pixel kernel over one tile (the Tiler parallelises it), through lut
+       when it is non-null. */
+    static void applyPointOps(WorkingImage &img, const PointCoeffs &c, const PointLut *lut,
+                              const Tile &t);
 };
 
 #endif // DEVELOP_H
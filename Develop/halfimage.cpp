@@ -0,0 +1,179 @@
+#include "Develop/halfimage.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QFuture>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+
+WINNOW_SIMD_NO_FP_CONTRACT
+
+using Winnow::Simd::Level;
+
+namespace {
+
+/* ---- Clamp + convert ----------------------------------------------------------------- */
+
+/* Written as compares rather than std::min / std::max so a NaN lands on kMax, the way
+   minps / fminnm treat it in the vector paths. */
+inline float ClampHalf(float v)
+{
+    v = (v < HalfFloat::kMax) ? v : HalfFloat::kMax;
+    return (v > -HalfFloat::kMax) ? v : -HalfFloat::kMax;
+}
+
+void PackScalar(const float *src, uint16_t *dst, size_t from, size_t n)
+{
+    for (size_t i = from; i < n; ++i) dst[i] = HalfFloat::FromFloat(ClampHalf(src[i]));
+}
+
+void UnpackScalar(const uint16_t *src, float *dst, size_t from, size_t n)
+{
+    for (size_t i = from; i < n; ++i) dst[i] = HalfFloat::ToFloat(src[i]);
+}
+
+#if defined(WINNOW_SIMD_X86)
+WINNOW_TARGET_F16C
+size_t PackF16c(const float *src, uint16_t *dst, size_t n)
+{
+    const __m256 hi = _mm256_set1_ps(HalfFloat::kMax), lo = _mm256_set1_ps(-HalfFloat::kMax);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        /* minps returns its SECOND operand when either is NaN, so NaN -> kMax as in
+           ClampHalf. */
+        const __m256 v = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(src + i), hi), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    return i;
+}
+
+WINNOW_TARGET_F16C
+size_t UnpackF16c(const uint16_t *src, float *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i))));
+    return i;
+}
+#endif
+
+#if defined(WINNOW_SIMD_NEON)
+size_t PackNeon(const float *src, uint16_t *dst, size_t n)
+{
+    const float32x4_t hi = vdupq_n_f32(HalfFloat::kMax), lo = vdupq_n_f32(-HalfFloat::kMax);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        /* The "nm" forms return the number when the other operand is NaN. */
+        const float32x4_t v = vmaxnmq_f32(vminnmq_f32(vld1q_f32(src + i), hi), lo);
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+    }
+    return i;
+}
+
+size_t UnpackNeon(const uint16_t *src, float *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    return i;
+}
+#endif
+
+/* ---- Whole images ----------------------------------------------------------------------
+
+   Band by band across the global pool: workers (and the caller) take the next band off
+   an atomic counter until none are left. A band is 64 K values -- 256 KB of float, so
+   the source and destination of one band stay in L2 together. */
+constexpr size_t kBand = size_t(1) << 16;
+
+template <class F>
+void ForEachBand(size_t n, F fn)
+{
+    const size_t bands = (n + kBand - 1) / kBand;
+    const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int workers = int(qMin<size_t>(bands, size_t(threads)));
+    std::atomic<size_t> next{0};
+    auto run = [&]() {
+        for (size_t b = next.fetch_add(1); b < bands; b = next.fetch_add(1)) {
+            const size_t i0 = b * kBand;
+            fn(i0, qMin(n, i0 + kBand));
+        }
+    };
+    QVector<QFuture<void>> futures;
+    for (int k = 1; k < workers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), run));
+    run();
+    for (QFuture<void> &f : futures) f.waitForFinished();
+}
+
+} // namespace
+
+void HalfFloat::Pack(const float *src, uint16_t *dst, size_t n, Level level)
+{
+    size_t i = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  i = PackF16c(src, dst, n); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  i = PackNeon(src, dst, n); break;
+#endif
+    default: break;
+    }
+    PackScalar(src, dst, i, n);
+}
+
+void HalfFloat::Unpack(const uint16_t *src, float *dst, size_t n, Level level)
+{
+    size_t i = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  i = UnpackF16c(src, dst, n); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  i = UnpackNeon(src, dst, n); break;
+#endif
+    default: break;
+    }
+    UnpackScalar(src, dst, i, n);
+}
+
+void PackImage(const WorkingImage &src, HalfImage &dst)
+{
+    dst.width         = src.width;
+    dst.height        = src.height;
+    dst.cam           = src.cam;
+    dst.white         = src.white;
+    dst.sceneReferred = src.sceneReferred;
+    dst.renderScale   = src.renderScale;
+    dst.rgb.resize(src.rgb.size());
+    const float *s = src.rgb.data();
+    uint16_t *d = dst.rgb.data();
+    const Level level = Winnow::Simd::level();
+    ForEachBand(src.rgb.size(), [s, d, level](size_t i0, size_t i1) {
+        HalfFloat::Pack(s + i0, d + i0, i1 - i0, level);
+    });
+}
+
+void UnpackImage(const HalfImage &src, WorkingImage &dst)
+{
+    dst.width         = src.width;
+    dst.height        = src.height;
+    dst.cam           = src.cam;
+    dst.white         = src.white;
+    dst.sceneReferred = src.sceneReferred;
+    dst.renderScale   = src.renderScale;
+    dst.frameX = dst.frameY = dst.frameW = dst.frameH = 0;    // a cached image is a frame
+    /* Same rule as assignReusing: keep an allocation that already fits, otherwise take a
+       fresh one rather than growing through the old one. */
+    if (dst.rgb.capacity() < src.rgb.size()) std::vector<float>().swap(dst.rgb);
+    dst.rgb.resize(src.rgb.size());
+    const uint16_t *s = src.rgb.data();
+    float *d = dst.rgb.data();
+    const Level level = Winnow::Simd::level();
+    ForEachBand(src.rgb.size(), [s, d, level](size_t i0, size_t i1) {
+        HalfFloat::Unpack(s + i0, d + i0, i1 - i0, level);
+    });
+}
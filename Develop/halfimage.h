@@ -0,0 +1,121 @@
+#ifndef HALFIMAGE_H
+#define HALFIMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Develop/workingimage.h"
+#include "Utilities/simd.h"
+
+/*
+    Half-float (IEEE 754 binary16) storage for a WorkingImage that is being KEPT rather
+    than worked on: the LRU tail of WorkingImageCache and the full-strength PMRID base MW
+    holds only for re-blending. A 45 MP float base is ~540 MB; at 6 bytes per pixel it is
+    half that, so the cache holds twice as many images in the same budget.
+
+    PRECISION. binary16 keeps 11 significant bits, so a normal value comes back within
+    2^-11 (0.05%) of what was stored -- a few hundredths of an 8-bit step at mid grey,
+    and the same relative error at every exposure, which is what scene-linear headroom
+    needs.
+    Values below 2^-14 (~ -84 dB) are stored as subnormals with an absolute step of 2^-24.
+    Anything beyond +-65504 is clamped to it (a scene-linear value that large is already
+    a blown highlight), and so is a NaN, which would be a bug upstream. tst_halfimage
+    asserts these bounds, and that the rendered 8-bit output of a packed image is within
+    one code of the float original.
+
+    Storage only. Develop and OutputTransform work on float, so a HalfImage is unpacked
+    before use -- in bands across the global pool, with F16C at the AVX2 level and the
+    NEON conversions on arm64. Every level is bit-exact with the scalar reference below,
+    and half -> float -> half is the identity, so an image that is packed, unpacked and
+    packed again does not drift.
+*/
+namespace HalfFloat {
+
+constexpr float kMax = 65504.0f;         // largest finite binary16
+
+/* Round-to-nearest-even float -> binary16, the same result F16C's vcvtps2ph gives with
+   _MM_FROUND_TO_NEAREST_INT. v must already be clamped to +-kMax (Pack does that). */
+inline uint16_t FromFloat(float v)
+{
+    uint32_t u;
+    std::memcpy(&u, &v, 4);
+    const uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+    uint16_t h;
+    if (u >= 0x47800000u) {                              // >= 65536: Inf or NaN
+        h = (u > 0x7f800000u) ? 0x7e00 : 0x7c00;
+    }
+    else if (u < 0x38800000u) {                          // below 2^-14: subnormal or zero
+        /* Adding 0.5 lines the 10 mantissa bits up at the bottom of the float and lets
+           the FPU do the round-to-nearest-even. */
+        float f;
+        std::memcpy(&f, &u, 4);
+        f += 0.5f;
+        std::memcpy(&u, &f, 4);
+        h = uint16_t(u - 0x3f000000u);
+    }
+    else {
+        const uint32_t odd = (u >> 13) & 1;
+        u += 0xc8000fffu + odd;                          // rebias exponent, round half even
+        h = uint16_t(u >> 13);
+    }
+    return uint16_t(h | (sign >> 16));
+}
+
+/* Exact binary16 -> float. */
+inline float ToFloat(uint16_t h)
+{
+    uint32_t u = uint32_t(h & 0x7fff) << 13;
+    const uint32_t exp = u & 0x0f800000u;
+    u += 0x38000000u;                                    // rebias exponent 15 -> 127
+    if (exp == 0x0f800000u) {                            // Inf / NaN
+        u += 0x38000000u;
+    }
+    else if (exp == 0) {                                 // zero / subnormal: renormalise
+        u += 0x00800000u;
+        float f;
+        std::memcpy(&f, &u, 4);
+        f -= 6.103515625e-05f;                           // 2^-14
+        std::memcpy(&u, &f, 4);
+    }
+    u |= uint32_t(h & 0x8000) << 16;
+    float f;
+    std::memcpy(&f, &u, 4);
+    return f;
+}
+
+/* n floats -> n halves, clamping to +-kMax first. */
+void Pack(const float *src, uint16_t *dst, size_t n,
+          Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* n halves -> n floats. */
+void Unpack(const uint16_t *src, float *dst, size_t n,
+            Winnow::Simd::Level level = Winnow::Simd::level());
+
+} // namespace HalfFloat
+
+/* A WorkingImage with its pixels in binary16; every other field is carried unchanged. */
+struct HalfImage {
+    std::vector<uint16_t> rgb;  // interleaved R,G,B, scene-linear, binary16
+    int width = 0;
+    int height = 0;
+    CameraColor cam;
+    float white = 1.0f;
+    bool sceneReferred = false;
+    float renderScale = 1.0f;
+
+    bool isValid() const {
+        return width > 0 && height > 0 &&
+               rgb.size() == static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+    }
+};
+
+/* Pack src into dst, reusing dst's buffer when it is already big enough. */
+void PackImage(const WorkingImage &src, HalfImage &dst);
+
+/* Unpack src into dst with the same buffer reuse as assignReusing (workingimage.h), so a
+   scratch refilled tick after tick does not go back to the allocator. */
+void UnpackImage(const HalfImage &src, WorkingImage &dst);
+
+#endif // HALFIMAGE_H
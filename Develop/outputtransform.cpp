@@ -1,13 +1,19 @@
 #include "Develop/outputtransform.h"
+#include "Utilities/simd.h"
 #include <QtConcurrent>
 #include <QThreadPool>
 #include <QFuture>
 #include <QVector>
 #include <QtGlobal>
 #include <cmath>
+#include <cstring>
+
+WINNOW_SIMD_NO_FP_CONTRACT
 
 namespace {
 
+using Winnow::Simd::Level;
+
 inline float Clamp01(float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
 
 /* Linear -> sRGB transfer (IEC 61966-2-1). */
@@ -187,9 +193,144 @@ inline uchar LutSample(const TransferLut &t, float v)
     return static_cast<uchar>(std::lround((t.v[i] + (t.v[i + 1] - t.v[i]) * fr) * 255.0f));
 }
 
+/*
+    LutSample over a run of n floats (a whole RGB888 row: the three channels take the same
+    table, so the interleave does not matter), vectorised. Bit-exact with LutSample, which
+    is the tail and the reference:
+      - NaN, <= 0 and >= the table end are selected by mask AFTER the sample is computed
+        from a zeroed index, so a stray NaN can never index off the table;
+      - the interpolation runs in LutSample's order, with no FMA (WINNOW_SIMD_NO_FP_CONTRACT);
+      - lround is trunc + (fraction >= 0.5). y - trunc(y) is exact, whereas the usual
+        floor(y + 0.5) rounds 0.49999997 up.
+    checkOver (display-referred input): return -1 as soon as a value exceeds 1, so the
+    caller runs that row through the exact rolloff path. Otherwise returns how many
+    leading elements were written.
+*/
+#if defined(WINNOW_SIMD_X86)
+WINNOW_TARGET_SSE41
+int LutRowSse41(const float *src, uchar *dst, int n, float scale, const TransferLut &t,
+                bool checkOver)
+{
+    const __m128 vs = _mm_set1_ps(scale), ts = _mm_set1_ps(t.scale);
+    const __m128 lim = _mm_set1_ps(float(kLutSize)), zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f), k255 = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    const __m128i top = _mm_set1_epi32(int(std::lround(t.v[kLutSize] * 255.0f)));
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), vs);
+        if (checkOver && _mm_movemask_ps(_mm_cmpgt_ps(v, one))) return -1;
+        const __m128 fi = _mm_mul_ps(v, ts);
+        const __m128 over = _mm_cmpge_ps(fi, lim);
+        const __m128 in = _mm_andnot_ps(over, _mm_cmpgt_ps(fi, zero));
+        const __m128 fs = _mm_and_ps(fi, in);
+        const __m128i idx = _mm_cvttps_epi32(fs);
+        const __m128 fr = _mm_sub_ps(fs, _mm_cvtepi32_ps(idx));
+        alignas(16) int k[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(k), idx);
+        const __m128 a = _mm_setr_ps(t.v[k[0]], t.v[k[1]], t.v[k[2]], t.v[k[3]]);
+        const __m128 b = _mm_setr_ps(t.v[k[0] + 1], t.v[k[1] + 1], t.v[k[2] + 1], t.v[k[3] + 1]);
+        const __m128 y = _mm_mul_ps(_mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fr)), k255);
+        const __m128 tr = _mm_round_ps(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        const __m128 up = _mm_cmpge_ps(_mm_sub_ps(y, tr), half);
+        __m128i r = _mm_sub_epi32(_mm_cvttps_epi32(tr), _mm_castps_si128(up));
+        r = _mm_and_si128(r, _mm_castps_si128(in));
+        r = _mm_blendv_epi8(r, top, _mm_castps_si128(over));
+        r = _mm_packus_epi32(r, r);
+        const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+        std::memcpy(dst + i, &bytes, 4);
+    }
+    return i;
+}
+
+WINNOW_TARGET_AVX2
+int LutRowAvx2(const float *src, uchar *dst, int n, float scale, const TransferLut &t,
+               bool checkOver)
+{
+    const __m256 vs = _mm256_set1_ps(scale), ts = _mm256_set1_ps(t.scale);
+    const __m256 lim = _mm256_set1_ps(float(kLutSize)), zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f), k255 = _mm256_set1_ps(255.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i top = _mm256_set1_epi32(int(std::lround(t.v[kLutSize] * 255.0f)));
+    const __m256i oneI = _mm256_set1_epi32(1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i), vs);
+        if (checkOver && _mm256_movemask_ps(_mm256_cmp_ps(v, one, _CMP_GT_OQ))) return -1;
+        const __m256 fi = _mm256_mul_ps(v, ts);
+        const __m256 over = _mm256_cmp_ps(fi, lim, _CMP_GE_OQ);
+        const __m256 in = _mm256_andnot_ps(over, _mm256_cmp_ps(fi, zero, _CMP_GT_OQ));
+        const __m256 fs = _mm256_and_ps(fi, in);
+        const __m256i idx = _mm256_cvttps_epi32(fs);
+        const __m256 fr = _mm256_sub_ps(fs, _mm256_cvtepi32_ps(idx));
+        const __m256 a = _mm256_i32gather_ps(t.v, idx, 4);
+        const __m256 b = _mm256_i32gather_ps(t.v, _mm256_add_epi32(idx, oneI), 4);
+        const __m256 y = _mm256_mul_ps(_mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), fr)), k255);
+        const __m256 tr = _mm256_round_ps(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        const __m256 up = _mm256_cmp_ps(_mm256_sub_ps(y, tr), half, _CMP_GE_OQ);
+        __m256i r = _mm256_sub_epi32(_mm256_cvttps_epi32(tr), _mm256_castps_si256(up));
+        r = _mm256_and_si256(r, _mm256_castps_si256(in));
+        r = _mm256_blendv_epi8(r, top, _mm256_castps_si256(over));
+        const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(w, w));
+    }
+    return i;
+}
+#endif
+
+#if defined(WINNOW_SIMD_NEON)
+int LutRowNeon(const float *src, uchar *dst, int n, float scale, const TransferLut &t,
+               bool checkOver)
+{
+    const float32x4_t lim = vdupq_n_f32(float(kLutSize)), zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f), half = vdupq_n_f32(0.5f);
+    const uint32x4_t top = vdupq_n_u32(uint32_t(std::lround(t.v[kLutSize] * 255.0f)));
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vmulq_n_f32(vld1q_f32(src + i), scale);
+        if (checkOver && vmaxvq_u32(vcgtq_f32(v, one))) return -1;
+        const float32x4_t fi = vmulq_n_f32(v, t.scale);
+        const uint32x4_t over = vcgeq_f32(fi, lim);
+        const uint32x4_t in = vbicq_u32(vcgtq_f32(fi, zero), over);
+        const float32x4_t fs = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(fi), in));
+        const int32x4_t idx = vcvtq_s32_f32(fs);
+        const float32x4_t fr = vsubq_f32(fs, vcvtq_f32_s32(idx));
+        int k[4];
+        vst1q_s32(k, idx);
+        const float av[4] = {t.v[k[0]], t.v[k[1]], t.v[k[2]], t.v[k[3]]};
+        const float bv[4] = {t.v[k[0] + 1], t.v[k[1] + 1], t.v[k[2] + 1], t.v[k[3] + 1]};
+        const float32x4_t a = vld1q_f32(av), b = vld1q_f32(bv);
+        const float32x4_t y = vmulq_n_f32(vaddq_f32(a, vmulq_f32(vsubq_f32(b, a), fr)), 255.0f);
+        const float32x4_t tr = vrndq_f32(y);
+        const uint32x4_t up = vcgeq_f32(vsubq_f32(y, tr), half);
+        uint32x4_t r = vsubq_u32(vreinterpretq_u32_s32(vcvtq_s32_f32(tr)), up);
+        r = vbslq_u32(over, top, vandq_u32(r, in));
+        const uint16x4_t h = vqmovn_u32(r);
+        const uint8x8_t b8 = vqmovn_u16(vcombine_u16(h, h));
+        vst1_lane_u32(reinterpret_cast<uint32_t *>(dst + i), vreinterpret_u32_u8(b8), 0);
+    }
+    return i;
+}
+#endif
+
+int LutRow(const float *src, uchar *dst, int n, float scale, const TransferLut &t,
+           bool checkOver, Level level)
+{
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  return LutRowAvx2(src, dst, n, scale, t, checkOver);
+    case Level::SSE41: return LutRowSse41(src, dst, n, scale, t, checkOver);
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  return LutRowNeon(src, dst, n, scale, t, checkOver);
+#endif
+    default: break;
+    }
+    return 0;
+}
+
 /*
     Run processRows(y0, y1) over the image's rows, parallelised over disjoint row chunks
-    (QtConcurrent + the global pool) exactly as Develop::applyPointOps is. Rows are
+    (QtConcurrent + the global pool) exactly as Develop's tile passes are. Rows are
     disjoint, so the threads write into the output buffer without contention. Shared by
     the 8-bit and 16-bit transforms -- only the per-pixel packing differs between them.
 */
@@ -217,6 +358,18 @@ void RunRows(int H, RowFn processRows)
     for (QFuture<void> &f : futures) f.waitForFinished();
 }
 
+/* Widen a row packed as RGB888 in the first 3W bytes of line to RGB32 (0xffRRGGBB) over the
+   whole line. Last pixel first: pixel x is written to bytes 4x..4x+3 after it is read from
+   3x..3x+2, so no byte still to be read is overwritten. */
+inline void WidenRowToRgb32(uchar *line, int W)
+{
+    QRgb *px = reinterpret_cast<QRgb *>(line);
+    for (int x = W - 1; x >= 0; --x) {
+        const uchar *s = line + static_cast<qsizetype>(x) * 3;
+        px[x] = qRgb(s[0], s[1], s[2]);
+    }
+}
+
 } // namespace
 
 QColorSpace OutputTransform::ColorSpaceOf(Space space)
@@ -229,16 +382,21 @@ QColorSpace OutputTransform::ColorSpaceOf(Space space)
     return QColorSpace(QColorSpace::SRgb);
 }
 
-bool OutputTransform::ToImage(const WorkingImage &img, QImage &out, Space space)
+bool OutputTransform::ToImage(const WorkingImage &img, QImage &out, Space space,
+                              QImage::Format format)
 {
     if (!img.isValid()) return false;
+    if (format != QImage::Format_RGB888 && format != QImage::Format_RGB32) return false;
 
     const int W = img.width;
     const int H = img.height;
     const float scale = img.white > 0.0f ? 1.0f / img.white : 1.0f;
 
-    out = QImage(W, H, QImage::Format_RGB888);
+    /* Every row is packed as RGB888; for RGB32 it is packed into the start of its own line
+       and widened in place (WidenRowToRgb32), so the display format costs no second image. */
+    out = QImage(W, H, format);
     if (out.isNull()) return false;
+    const bool wide = format == QImage::Format_RGB32;
 
     const bool tone = img.sceneReferred;    // baseline tone curve for RAW only
     const Encoding enc = EncodingFor(space);
@@ -256,11 +414,16 @@ bool OutputTransform::ToImage(const WorkingImage &img, QImage &out, Space space)
        overwhelming majority) still take the table. */
     if (enc.identity) {
         const TransferLut &lut = ToneLut(tone);
+        const Level simd = Winnow::Simd::level();
         auto processRowsLut = [=, &lut](int y0, int y1) {
             for (int y = y0; y < y1; ++y) {
                 uchar *line = bits + static_cast<qsizetype>(y) * bpl;
                 const size_t base = static_cast<size_t>(y) * W * 3;
-                for (int x = 0; x < W; ++x) {
+                /* Vectorised head of the row (LutRow), then the scalar loop from the
+                   first pixel it did not finish. A display-referred row with a value
+                   over 1 comes back -1 and runs scalar from the start. */
+                const int done = LutRow(rgb + base, line, W * 3, scale, lut, !tone, simd);
+                for (int x = qMax(0, done) / 3; x < W; ++x) {
                     const size_t o = base + static_cast<size_t>(x) * 3;
                     const float v0 = rgb[o + 0] * scale;
                     const float v1 = rgb[o + 1] * scale;
@@ -280,6 +443,7 @@ bool OutputTransform::ToImage(const WorkingImage &img, QImage &out, Space space)
                     line[x * 3 + 1] = LutSample(lut, v1);
                     line[x * 3 + 2] = LutSample(lut, v2);
                 }
+                if (wide) WidenRowToRgb32(line, W);
             }
         };
         RunRows(H, processRowsLut);
@@ -307,6 +471,7 @@ bool OutputTransform::ToImage(const WorkingImage &img, QImage &out, Space space)
                     line[x * 3 + c] = static_cast<uchar>(
                         std::lround(Transfer(v[c], enc.gammaInv) * 255.0f));
             }
+            if (wide) WidenRowToRgb32(line, W);
         }
     };
 
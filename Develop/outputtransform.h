@@ -34,8 +34,8 @@
     Whatever writes the QImage must tag it to MATCH: use ColorSpaceOf(space), or the file
     says one thing and the pixels another.
 
-    BIT DEPTH. ToImage packs to 8-bit RGB888 -- the loupe hot path, and what every
-    interactive render uses. ToImage16 is its 16-bit twin (Format_RGBX64) for EXPORT: the
+    BIT DEPTH. ToImage packs to 8 bits, as RGB888 or, for the image cache, RGB32 -- the
+    loupe hot path, and what every interactive render uses. ToImage16 is its 16-bit twin (Format_RGBX64) for EXPORT: the
     develop pipeline is float throughout, so 8-bit packing is the only place precision is
     lost, and a 16-bit TIFF/PNG export is worth having for images that will be edited
     onward. The maths is identical in both; only the final quantisation differs.
@@ -51,8 +51,11 @@ public:
     /* The QColorSpace to TAG output produced for space with. */
     static QColorSpace ColorSpaceOf(Space space);
 
-    /* Scene-linear float -> 8-bit QImage (Format_RGB888) in space. */
-    bool ToImage(const WorkingImage &img, QImage &out, Space space = Space::sRGB);
+    /* Scene-linear float -> 8-bit QImage in space. format is Format_RGB888 (the default)
+       or Format_RGB32, the raster-native format the image cache hands to QPixmap without
+       a conversion (ImageCacheData::toDisplayFormat). Same pixels either way. */
+    bool ToImage(const WorkingImage &img, QImage &out, Space space = Space::sRGB,
+                 QImage::Format format = QImage::Format_RGB888);
 
     /* Scene-linear float -> 16-bit QImage (Format_RGBX64), for export. Same tone curve,
        primaries and transfer function as ToImage, quantised to 16 bits instead of 8. */
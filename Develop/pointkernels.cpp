@@ -0,0 +1,822 @@
+#include "Develop/pointkernels.h"
+#include "Develop/colorgrade.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+WINNOW_SIMD_NO_FP_CONTRACT
+
+using Winnow::Simd::Level;
+
+namespace {
+
+/* ---- Pow ------------------------------------------------------------------------------
+
+   x = 2^e * m with m in [sqrt(1/2), sqrt(2)), ln m = 2 atanh((m-1)/(m+1)) to z^11 (|z| <=
+   0.172, so the next term is below 1e-10), then 2^t = 2^k * e^((t-k) ln 2) with the
+   exponential's Taylor series to u^7 (|u| <= 0.35). The vector versions below repeat these
+   steps operation for operation. */
+constexpr float kPowMin  = 1e-30f;
+constexpr float kPowMax  = 1e30f;
+constexpr float kSqrt2   = 1.41421356f;
+constexpr float kLog2e   = 1.44269504f;
+constexpr float kLn2     = 0.693147181f;
+constexpr float kAtanh3  = 1.0f / 3.0f;
+constexpr float kAtanh5  = 1.0f / 5.0f;
+constexpr float kAtanh7  = 1.0f / 7.0f;
+constexpr float kAtanh9  = 1.0f / 9.0f;
+constexpr float kAtanh11 = 1.0f / 11.0f;
+constexpr float kExp2    = 1.0f / 2.0f;
+constexpr float kExp3    = 1.0f / 6.0f;
+constexpr float kExp4    = 1.0f / 24.0f;
+constexpr float kExp5    = 1.0f / 120.0f;
+constexpr float kExp6    = 1.0f / 720.0f;
+constexpr float kExp7    = 1.0f / 5040.0f;
+
+/* ---- Scalar reference ----------------------------------------------------------------- */
+
+/* The per-kernel constants every level derives the same way from Coeffs. */
+struct Consts {
+    bool  doGain, doCal, doTone, doHsl, doVib, doGrade;
+    float white, invWhite, invGamma;
+    int   lutLast;
+    float lutScale;
+    float oneMinusHigh;          // gradeTonalWeights' highlight denominator
+};
+
+Consts MakeConsts(const PointKernels::Coeffs &c)
+{
+    Consts k;
+    k.doGain   = (c.channelGain[0] != 1.0f) || (c.channelGain[1] != 1.0f) ||
+                 (c.channelGain[2] != 1.0f);
+    k.doCal    = c.calActive;
+    k.doTone   = c.toneActive;
+    k.doHsl    = c.hslActive;
+    k.doVib    = (c.vibAmount != 0.0f);
+    k.doGrade  = c.gradeActive;
+    k.white    = c.white;
+    k.invWhite = 1.0f / c.white;
+    k.invGamma = c.invGamma;
+    k.lutLast  = PointKernels::Coeffs::kLutSize - 1;
+    k.lutScale = k.lutLast / c.toneLutSMax;
+    k.oneMinusHigh = 1.0f - c.gradeHighStart;
+    return k;
+}
+
+inline float Clamp0(float v) { return (v < 0.0f) ? 0.0f : v; }
+
+/* White-normalise, encode, look up and interpolate one channel's tone table. */
+inline float Tone(const float *lut, float v, const Consts &k)
+{
+    float n = v * k.invWhite;
+    if (n < 0.0f) n = 0.0f;
+    const float s = PointKernels::Pow(n, k.invGamma);
+    const float fi = s * k.lutScale;
+    if (fi >= k.lutLast) return lut[k.lutLast] * k.white;   // above the table's domain
+    const int i = static_cast<int>(fi);
+    const float frac = fi - i;
+    return (lut[i] + (lut[i + 1] - lut[i]) * frac) * k.white;
+}
+
+void ApplyScalar(float *R, float *G, float *B, int from, int n,
+                 const PointKernels::Coeffs &c, const Consts &k)
+{
+    const float *gain = c.channelGain;
+    const float *cm = c.calMat;
+    const float *hm = c.hueMat;
+    const float (*gt)[3] = c.gradeTint;
+    const float *gl = c.gradeLum;
+    for (int i = from; i < n; ++i) {
+        float r = R[i], g = G[i], b = B[i];
+        if (k.doGain) { r *= gain[0]; g *= gain[1]; b *= gain[2]; }
+        if (k.doCal) {
+            /* Re-point the primaries in LINEAR light, before any tone shaping. */
+            const float cr = cm[0] * r + cm[1] * g + cm[2] * b;
+            const float cg = cm[3] * r + cm[4] * g + cm[5] * b;
+            const float cb = cm[6] * r + cm[7] * g + cm[8] * b;
+            r = Clamp0(cr); g = Clamp0(cg); b = Clamp0(cb);
+        }
+        if (k.doTone) {
+            r = Tone(c.toneLut[0], r, k);
+            g = Tone(c.toneLut[1], g, k);
+            b = Tone(c.toneLut[2], b, k);
+        }
+        if (k.doHsl) {
+            /* Hue rotates about the neutral axis; saturation scales chroma about Rec.709
+               luma, boosted per pixel by vibrance in proportion to how muted the pixel
+               is; luminance is a uniform gain. */
+            const float hr = hm[0] * r + hm[1] * g + hm[2] * b;
+            const float hg = hm[3] * r + hm[4] * g + hm[5] * b;
+            const float hb = hm[6] * r + hm[7] * g + hm[8] * b;
+            const float Y = 0.2126f * hr + 0.7152f * hg + 0.0722f * hb;
+            float sF = c.satFactor;
+            if (k.doVib) {
+                const float mx = (hr > hg ? (hr > hb ? hr : hb) : (hg > hb ? hg : hb));
+                const float mn = (hr < hg ? (hr < hb ? hr : hb) : (hg < hb ? hg : hb));
+                const float pxSat = (mx > 1e-6f) ? (mx - mn) / mx : 0.0f;  // 0..1
+                sF *= 1.0f + c.vibAmount * (1.0f - pxSat);
+                if (sF < 0.0f) sF = 0.0f;            // never invert chroma
+            }
+            r = Clamp0((Y + sF * (hr - Y)) * c.lumGain);
+            g = Clamp0((Y + sF * (hg - Y)) * c.lumGain);
+            b = Clamp0((Y + sF * (hb - Y)) * c.lumGain);
+        }
+        if (k.doGrade) {
+            /* Three smooth tonal windows of the pixel's perceptual lightness weight each
+               range's luminance gain and zero-luma tint; Global rides in at weight 1. */
+            const float Yg = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+            float n = Yg * k.invWhite;
+            if (n < 0.0f) n = 0.0f; else if (n > 1.0f) n = 1.0f;
+            const float L = PointKernels::Pow(n, k.invGamma);
+            float wS, wM, wH;
+            ColorGrade::gradeTonalWeights(L, c.gradeShadowEnd, c.gradeHighStart, wS, wM, wH);
+            const float lumMul = 1.0f + wS * gl[0] + wM * gl[1] + wH * gl[2] + gl[3];
+            const float tR = (wS * gt[0][0] + wM * gt[1][0] + wH * gt[2][0] + gt[3][0]) * k.white;
+            const float tG = (wS * gt[0][1] + wM * gt[1][1] + wH * gt[2][1] + gt[3][1]) * k.white;
+            const float tB = (wS * gt[0][2] + wM * gt[1][2] + wH * gt[2][2] + gt[3][2]) * k.white;
+            r = Clamp0(r * lumMul + tR);
+            g = Clamp0(g * lumMul + tG);
+            b = Clamp0(b * lumMul + tB);
+        }
+        R[i] = r; G[i] = g; B[i] = b;
+    }
+}
+
+/* ---- SSE4.1 ----------------------------------------------------------------------------
+
+   Four pixels per step. Every (a < b) ? x : y of the scalar loop is a compare and a blend
+   with the same operand order, so NaNs and signed zeros go the same way. There is no
+   gather before AVX2, so the tone lookup reads its two table entries per lane. */
+#if defined(WINNOW_SIMD_X86)
+WINNOW_TARGET_SSE41
+inline __m128 Sel(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+    return _mm_blendv_ps(ifFalse, ifTrue, mask);
+}
+
+WINNOW_TARGET_SSE41
+inline __m128 Clamp0Sse(__m128 v)
+{
+    const __m128 zero = _mm_setzero_ps();
+    return Sel(_mm_cmplt_ps(v, zero), zero, v);
+}
+
+WINNOW_TARGET_SSE41
+inline __m128 Dot3Sse(const float *m, __m128 r, __m128 g, __m128 b)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0]), r),
+                                 _mm_mul_ps(_mm_set1_ps(m[1]), g)),
+                      _mm_mul_ps(_mm_set1_ps(m[2]), b));
+}
+
+WINNOW_TARGET_SSE41
+inline __m128 SatLumSse(__m128 Y, __m128 sF, __m128 h, __m128 lumG)
+{
+    return Clamp0Sse(_mm_mul_ps(_mm_add_ps(Y, _mm_mul_ps(sF, _mm_sub_ps(h, Y))), lumG));
+}
+
+WINNOW_TARGET_SSE41
+__m128 PowSse(__m128 x, __m128 p)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 valid = _mm_cmpgt_ps(x, _mm_set1_ps(kPowMin));
+    x = Sel(valid, x, one);
+    x = Sel(_mm_cmplt_ps(x, _mm_set1_ps(kPowMax)), x, _mm_set1_ps(kPowMax));
+
+    const __m128i u = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(u, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(u, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    const __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(kSqrt2));
+    m = Sel(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+    e = _mm_add_epi32(e, _mm_and_si128(_mm_castps_si128(big), _mm_set1_epi32(1)));
+
+    const __m128 z = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    const __m128 z2 = _mm_mul_ps(z, z);
+    __m128 s = _mm_set1_ps(kAtanh11);
+    s = _mm_add_ps(_mm_mul_ps(s, z2), _mm_set1_ps(kAtanh9));
+    s = _mm_add_ps(_mm_mul_ps(s, z2), _mm_set1_ps(kAtanh7));
+    s = _mm_add_ps(_mm_mul_ps(s, z2), _mm_set1_ps(kAtanh5));
+    s = _mm_add_ps(_mm_mul_ps(s, z2), _mm_set1_ps(kAtanh3));
+    s = _mm_add_ps(_mm_mul_ps(s, z2), one);
+    const __m128 lnm = _mm_mul_ps(_mm_add_ps(z, z), s);
+    const __m128 l2 = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_mul_ps(lnm, _mm_set1_ps(kLog2e)));
+
+    const __m128 t = _mm_mul_ps(l2, p);
+    const __m128 kf = _mm_round_ps(_mm_add_ps(t, _mm_set1_ps(0.5f)),
+                                   _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    const __m128 f = _mm_mul_ps(_mm_sub_ps(t, kf), _mm_set1_ps(kLn2));
+    __m128 q = _mm_set1_ps(kExp7);
+    q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(kExp6));
+    q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(kExp5));
+    q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(kExp4));
+    q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(kExp3));
+    q = _mm_add_ps(_mm_mul_ps(q, f), _mm_set1_ps(kExp2));
+    q = _mm_add_ps(_mm_mul_ps(q, f), one);
+    q = _mm_add_ps(_mm_mul_ps(q, f), one);
+    const __m128i scaled = _mm_add_epi32(_mm_castps_si128(q),
+                                         _mm_slli_epi32(_mm_cvttps_epi32(kf), 23));
+    return _mm_and_ps(valid, _mm_castsi128_ps(scaled));
+}
+
+WINNOW_TARGET_SSE41
+__m128 ToneSse(const float *lut, __m128 v, const Consts &k)
+{
+    const __m128 zero = _mm_setzero_ps();
+    __m128 n = _mm_mul_ps(v, _mm_set1_ps(k.invWhite));
+    n = Sel(_mm_cmplt_ps(n, zero), zero, n);
+    const __m128 s = PowSse(n, _mm_set1_ps(k.invGamma));
+    const __m128 fi = _mm_mul_ps(s, _mm_set1_ps(k.lutScale));
+    const __m128 above = _mm_cmpge_ps(fi, _mm_set1_ps(float(k.lutLast)));
+    /* Lanes above the table read entry 0 and are replaced by the end value below. */
+    const __m128i i = _mm_cvttps_epi32(Sel(above, zero, fi));
+    const __m128 frac = _mm_sub_ps(fi, _mm_cvtepi32_ps(i));
+    alignas(16) int idx[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(idx), i);
+    const __m128 lo = _mm_setr_ps(lut[idx[0]], lut[idx[1]], lut[idx[2]], lut[idx[3]]);
+    const __m128 hi = _mm_setr_ps(lut[idx[0] + 1], lut[idx[1] + 1], lut[idx[2] + 1],
+                                  lut[idx[3] + 1]);
+    const __m128 white = _mm_set1_ps(k.white);
+    const __m128 out = _mm_mul_ps(_mm_add_ps(lo, _mm_mul_ps(_mm_sub_ps(hi, lo), frac)), white);
+    return Sel(above, _mm_mul_ps(_mm_set1_ps(lut[k.lutLast]), white), out);
+}
+
+WINNOW_TARGET_SSE41
+inline __m128 SmoothStepSse(__m128 t)
+{
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    t = Sel(_mm_cmplt_ps(t, zero), zero, Sel(_mm_cmpgt_ps(t, one), one, t));
+    return _mm_mul_ps(_mm_mul_ps(t, t),
+                      _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), t)));
+}
+
+WINNOW_TARGET_SSE41
+inline __m128 GradeSumSse(__m128 wS, __m128 wM, __m128 wH, float a, float b, float c, float d)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wS, _mm_set1_ps(a)),
+                                            _mm_mul_ps(wM, _mm_set1_ps(b))),
+                                 _mm_mul_ps(wH, _mm_set1_ps(c))),
+                      _mm_set1_ps(d));
+}
+
+WINNOW_TARGET_SSE41
+int ApplySse(float *R, float *G, float *B, int n, const PointKernels::Coeffs &c,
+             const Consts &k)
+{
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 gain0 = _mm_set1_ps(c.channelGain[0]);
+    const __m128 gain1 = _mm_set1_ps(c.channelGain[1]);
+    const __m128 gain2 = _mm_set1_ps(c.channelGain[2]);
+    const __m128 yR = _mm_set1_ps(0.2126f), yG = _mm_set1_ps(0.7152f), yB = _mm_set1_ps(0.0722f);
+    const __m128 white = _mm_set1_ps(k.white);
+    const float (*gt)[3] = c.gradeTint;
+    const float *gl = c.gradeLum;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(R + i), g = _mm_loadu_ps(G + i), b = _mm_loadu_ps(B + i);
+        if (k.doGain) {
+            r = _mm_mul_ps(r, gain0); g = _mm_mul_ps(g, gain1); b = _mm_mul_ps(b, gain2);
+        }
+        if (k.doCal) {
+            const __m128 cr = Dot3Sse(c.calMat + 0, r, g, b);
+            const __m128 cg = Dot3Sse(c.calMat + 3, r, g, b);
+            const __m128 cb = Dot3Sse(c.calMat + 6, r, g, b);
+            r = Clamp0Sse(cr); g = Clamp0Sse(cg); b = Clamp0Sse(cb);
+        }
+        if (k.doTone) {
+            r = ToneSse(c.toneLut[0], r, k);
+            g = ToneSse(c.toneLut[1], g, k);
+            b = ToneSse(c.toneLut[2], b, k);
+        }
+        if (k.doHsl) {
+            const __m128 hr = Dot3Sse(c.hueMat + 0, r, g, b);
+            const __m128 hg = Dot3Sse(c.hueMat + 3, r, g, b);
+            const __m128 hb = Dot3Sse(c.hueMat + 6, r, g, b);
+            const __m128 Y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(yR, hr), _mm_mul_ps(yG, hg)),
+                                        _mm_mul_ps(yB, hb));
+            __m128 sF = _mm_set1_ps(c.satFactor);
+            if (k.doVib) {
+                const __m128 rgtg = _mm_cmpgt_ps(hr, hg);
+                const __m128 mx = Sel(rgtg, Sel(_mm_cmpgt_ps(hr, hb), hr, hb),
+                                      Sel(_mm_cmpgt_ps(hg, hb), hg, hb));
+                const __m128 rltg = _mm_cmplt_ps(hr, hg);
+                const __m128 mn = Sel(rltg, Sel(_mm_cmplt_ps(hr, hb), hr, hb),
+                                      Sel(_mm_cmplt_ps(hg, hb), hg, hb));
+                const __m128 pxSat = Sel(_mm_cmpgt_ps(mx, _mm_set1_ps(1e-6f)),
+                                         _mm_div_ps(_mm_sub_ps(mx, mn), mx), zero);
+                sF = _mm_mul_ps(sF, _mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(c.vibAmount),
+                                                               _mm_sub_ps(one, pxSat))));
+                sF = Clamp0Sse(sF);
+            }
+            const __m128 lumG = _mm_set1_ps(c.lumGain);
+            r = SatLumSse(Y, sF, hr, lumG);
+            g = SatLumSse(Y, sF, hg, lumG);
+            b = SatLumSse(Y, sF, hb, lumG);
+        }
+        if (k.doGrade) {
+            const __m128 Yg = _mm_add_ps(_mm_add_ps(_mm_mul_ps(yR, r), _mm_mul_ps(yG, g)),
+                                         _mm_mul_ps(yB, b));
+            __m128 nL = _mm_mul_ps(Yg, _mm_set1_ps(k.invWhite));
+            nL = Sel(_mm_cmplt_ps(nL, zero), zero, Sel(_mm_cmpgt_ps(nL, one), one, nL));
+            const __m128 L = PowSse(nL, _mm_set1_ps(k.invGamma));
+            /* ColorGrade::gradeTonalWeights, step for step. */
+            const __m128 wS = _mm_sub_ps(one, SmoothStepSse(
+                _mm_div_ps(L, _mm_set1_ps(c.gradeShadowEnd))));
+            const __m128 wH = SmoothStepSse(_mm_div_ps(
+                _mm_sub_ps(L, _mm_set1_ps(c.gradeHighStart)), _mm_set1_ps(k.oneMinusHigh)));
+            const __m128 wM = Clamp0Sse(_mm_sub_ps(_mm_sub_ps(one, wS), wH));
+            __m128 lumMul = _mm_add_ps(one, _mm_mul_ps(wS, _mm_set1_ps(gl[0])));
+            lumMul = _mm_add_ps(lumMul, _mm_mul_ps(wM, _mm_set1_ps(gl[1])));
+            lumMul = _mm_add_ps(lumMul, _mm_mul_ps(wH, _mm_set1_ps(gl[2])));
+            lumMul = _mm_add_ps(lumMul, _mm_set1_ps(gl[3]));
+            const __m128 tR = _mm_mul_ps(GradeSumSse(wS, wM, wH, gt[0][0], gt[1][0],
+                                                      gt[2][0], gt[3][0]), white);
+            const __m128 tG = _mm_mul_ps(GradeSumSse(wS, wM, wH, gt[0][1], gt[1][1],
+                                                      gt[2][1], gt[3][1]), white);
+            const __m128 tB = _mm_mul_ps(GradeSumSse(wS, wM, wH, gt[0][2], gt[1][2],
+                                                      gt[2][2], gt[3][2]), white);
+            r = Clamp0Sse(_mm_add_ps(_mm_mul_ps(r, lumMul), tR));
+            g = Clamp0Sse(_mm_add_ps(_mm_mul_ps(g, lumMul), tG));
+            b = Clamp0Sse(_mm_add_ps(_mm_mul_ps(b, lumMul), tB));
+        }
+        _mm_storeu_ps(R + i, r); _mm_storeu_ps(G + i, g); _mm_storeu_ps(B + i, b);
+    }
+    return i;
+}
+#endif
+
+/* ---- AVX2 ------------------------------------------------------------------------------
+
+   The SSE4.1 kernel eight pixels wide, with the tone lookup as two gathers. */
+#if defined(WINNOW_SIMD_X86)
+WINNOW_TARGET_AVX2
+inline __m256 Sel(__m256 mask, __m256 ifTrue, __m256 ifFalse)
+{
+    return _mm256_blendv_ps(ifFalse, ifTrue, mask);
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 Clamp0Avx2(__m256 v)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    return Sel(_mm256_cmp_ps(v, zero, _CMP_LT_OQ), zero, v);
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 Dot3Avx2(const float *m, __m256 r, __m256 g, __m256 b)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[0]), r),
+                                       _mm256_mul_ps(_mm256_set1_ps(m[1]), g)),
+                         _mm256_mul_ps(_mm256_set1_ps(m[2]), b));
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 SatLumAvx2(__m256 Y, __m256 sF, __m256 h, __m256 lumG)
+{
+    const __m256 v = _mm256_add_ps(Y, _mm256_mul_ps(sF, _mm256_sub_ps(h, Y)));
+    return Clamp0Avx2(_mm256_mul_ps(v, lumG));
+}
+
+WINNOW_TARGET_AVX2
+__m256 PowAvx2(__m256 x, __m256 p)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 valid = _mm256_cmp_ps(x, _mm256_set1_ps(kPowMin), _CMP_GT_OQ);
+    x = Sel(valid, x, one);
+    x = Sel(_mm256_cmp_ps(x, _mm256_set1_ps(kPowMax), _CMP_LT_OQ), x, _mm256_set1_ps(kPowMax));
+
+    const __m256i u = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(u, 23), _mm256_set1_epi32(127));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(u, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+    const __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(kSqrt2), _CMP_GT_OQ);
+    m = Sel(big, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), m);
+    e = _mm256_add_epi32(e, _mm256_and_si256(_mm256_castps_si256(big), _mm256_set1_epi32(1)));
+
+    const __m256 z = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+    const __m256 z2 = _mm256_mul_ps(z, z);
+    __m256 s = _mm256_set1_ps(kAtanh11);
+    s = _mm256_add_ps(_mm256_mul_ps(s, z2), _mm256_set1_ps(kAtanh9));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z2), _mm256_set1_ps(kAtanh7));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z2), _mm256_set1_ps(kAtanh5));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z2), _mm256_set1_ps(kAtanh3));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z2), one);
+    const __m256 lnm = _mm256_mul_ps(_mm256_add_ps(z, z), s);
+    const __m256 l2 = _mm256_add_ps(_mm256_cvtepi32_ps(e),
+                                    _mm256_mul_ps(lnm, _mm256_set1_ps(kLog2e)));
+
+    const __m256 t = _mm256_mul_ps(l2, p);
+    const __m256 kf = _mm256_round_ps(_mm256_add_ps(t, _mm256_set1_ps(0.5f)),
+                                      _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    const __m256 f = _mm256_mul_ps(_mm256_sub_ps(t, kf), _mm256_set1_ps(kLn2));
+    __m256 q = _mm256_set1_ps(kExp7);
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(kExp6));
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(kExp5));
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(kExp4));
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(kExp3));
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), _mm256_set1_ps(kExp2));
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), one);
+    q = _mm256_add_ps(_mm256_mul_ps(q, f), one);
+    const __m256i scaled = _mm256_add_epi32(_mm256_castps_si256(q),
+                                            _mm256_slli_epi32(_mm256_cvttps_epi32(kf), 23));
+    return _mm256_and_ps(valid, _mm256_castsi256_ps(scaled));
+}
+
+WINNOW_TARGET_AVX2
+__m256 ToneAvx2(const float *lut, __m256 v, const Consts &k)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 n = _mm256_mul_ps(v, _mm256_set1_ps(k.invWhite));
+    n = Sel(_mm256_cmp_ps(n, zero, _CMP_LT_OQ), zero, n);
+    const __m256 s = PowAvx2(n, _mm256_set1_ps(k.invGamma));
+    const __m256 fi = _mm256_mul_ps(s, _mm256_set1_ps(k.lutScale));
+    const __m256 above = _mm256_cmp_ps(fi, _mm256_set1_ps(float(k.lutLast)), _CMP_GE_OQ);
+    /* Lanes above the table gather entry 0 and are replaced by the end value below. */
+    const __m256i i = _mm256_cvttps_epi32(Sel(above, zero, fi));
+    const __m256 frac = _mm256_sub_ps(fi, _mm256_cvtepi32_ps(i));
+    const __m256 lo = _mm256_i32gather_ps(lut, i, 4);
+    const __m256 hi = _mm256_i32gather_ps(lut + 1, i, 4);
+    const __m256 white = _mm256_set1_ps(k.white);
+    const __m256 out = _mm256_mul_ps(_mm256_add_ps(lo, _mm256_mul_ps(_mm256_sub_ps(hi, lo), frac)),
+                                     white);
+    return Sel(above, _mm256_mul_ps(_mm256_set1_ps(lut[k.lutLast]), white), out);
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 SmoothStepAvx2(__m256 t)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    t = Sel(_mm256_cmp_ps(t, zero, _CMP_LT_OQ), zero,
+            Sel(_mm256_cmp_ps(t, one, _CMP_GT_OQ), one, t));
+    const __m256 cubic = _mm256_sub_ps(_mm256_set1_ps(3.0f),
+                                       _mm256_mul_ps(_mm256_set1_ps(2.0f), t));
+    return _mm256_mul_ps(_mm256_mul_ps(t, t), cubic);
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 GradeSumAvx2(__m256 wS, __m256 wM, __m256 wH, float a, float b, float c, float d)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wS, _mm256_set1_ps(a)),
+                                                     _mm256_mul_ps(wM, _mm256_set1_ps(b))),
+                                       _mm256_mul_ps(wH, _mm256_set1_ps(c))),
+                         _mm256_set1_ps(d));
+}
+
+WINNOW_TARGET_AVX2
+int ApplyAvx2(float *R, float *G, float *B, int n, const PointKernels::Coeffs &c,
+              const Consts &k)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256 gain0 = _mm256_set1_ps(c.channelGain[0]);
+    const __m256 gain1 = _mm256_set1_ps(c.channelGain[1]);
+    const __m256 gain2 = _mm256_set1_ps(c.channelGain[2]);
+    const __m256 yR = _mm256_set1_ps(0.2126f), yG = _mm256_set1_ps(0.7152f),
+                 yB = _mm256_set1_ps(0.0722f);
+    const __m256 white = _mm256_set1_ps(k.white);
+    const float (*gt)[3] = c.gradeTint;
+    const float *gl = c.gradeLum;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(R + i), g = _mm256_loadu_ps(G + i), b = _mm256_loadu_ps(B + i);
+        if (k.doGain) {
+            r = _mm256_mul_ps(r, gain0); g = _mm256_mul_ps(g, gain1); b = _mm256_mul_ps(b, gain2);
+        }
+        if (k.doCal) {
+            const __m256 cr = Dot3Avx2(c.calMat + 0, r, g, b);
+            const __m256 cg = Dot3Avx2(c.calMat + 3, r, g, b);
+            const __m256 cb = Dot3Avx2(c.calMat + 6, r, g, b);
+            r = Clamp0Avx2(cr); g = Clamp0Avx2(cg); b = Clamp0Avx2(cb);
+        }
+        if (k.doTone) {
+            r = ToneAvx2(c.toneLut[0], r, k);
+            g = ToneAvx2(c.toneLut[1], g, k);
+            b = ToneAvx2(c.toneLut[2], b, k);
+        }
+        if (k.doHsl) {
+            const __m256 hr = Dot3Avx2(c.hueMat + 0, r, g, b);
+            const __m256 hg = Dot3Avx2(c.hueMat + 3, r, g, b);
+            const __m256 hb = Dot3Avx2(c.hueMat + 6, r, g, b);
+            const __m256 Y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yR, hr),
+                                                         _mm256_mul_ps(yG, hg)),
+                                           _mm256_mul_ps(yB, hb));
+            __m256 sF = _mm256_set1_ps(c.satFactor);
+            if (k.doVib) {
+                const __m256 rgtg = _mm256_cmp_ps(hr, hg, _CMP_GT_OQ);
+                const __m256 mx = Sel(rgtg, Sel(_mm256_cmp_ps(hr, hb, _CMP_GT_OQ), hr, hb),
+                                            Sel(_mm256_cmp_ps(hg, hb, _CMP_GT_OQ), hg, hb));
+                const __m256 rltg = _mm256_cmp_ps(hr, hg, _CMP_LT_OQ);
+                const __m256 mn = Sel(rltg, Sel(_mm256_cmp_ps(hr, hb, _CMP_LT_OQ), hr, hb),
+                                            Sel(_mm256_cmp_ps(hg, hb, _CMP_LT_OQ), hg, hb));
+                const __m256 pxSat = Sel(_mm256_cmp_ps(mx, _mm256_set1_ps(1e-6f), _CMP_GT_OQ),
+                                         _mm256_div_ps(_mm256_sub_ps(mx, mn), mx), zero);
+                sF = _mm256_mul_ps(sF, _mm256_add_ps(one, _mm256_mul_ps(
+                         _mm256_set1_ps(c.vibAmount), _mm256_sub_ps(one, pxSat))));
+                sF = Clamp0Avx2(sF);
+            }
+            const __m256 lumG = _mm256_set1_ps(c.lumGain);
+            r = SatLumAvx2(Y, sF, hr, lumG);
+            g = SatLumAvx2(Y, sF, hg, lumG);
+            b = SatLumAvx2(Y, sF, hb, lumG);
+        }
+        if (k.doGrade) {
+            const __m256 Yg = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yR, r),
+                                                          _mm256_mul_ps(yG, g)),
+                                            _mm256_mul_ps(yB, b));
+            __m256 nL = _mm256_mul_ps(Yg, _mm256_set1_ps(k.invWhite));
+            nL = Sel(_mm256_cmp_ps(nL, zero, _CMP_LT_OQ), zero,
+                     Sel(_mm256_cmp_ps(nL, one, _CMP_GT_OQ), one, nL));
+            const __m256 L = PowAvx2(nL, _mm256_set1_ps(k.invGamma));
+            /* ColorGrade::gradeTonalWeights, step for step. */
+            const __m256 wS = _mm256_sub_ps(one, SmoothStepAvx2(
+                _mm256_div_ps(L, _mm256_set1_ps(c.gradeShadowEnd))));
+            const __m256 wH = SmoothStepAvx2(_mm256_div_ps(
+                _mm256_sub_ps(L, _mm256_set1_ps(c.gradeHighStart)),
+                _mm256_set1_ps(k.oneMinusHigh)));
+            const __m256 wM = Clamp0Avx2(_mm256_sub_ps(_mm256_sub_ps(one, wS), wH));
+            __m256 lumMul = _mm256_add_ps(one, _mm256_mul_ps(wS, _mm256_set1_ps(gl[0])));
+            lumMul = _mm256_add_ps(lumMul, _mm256_mul_ps(wM, _mm256_set1_ps(gl[1])));
+            lumMul = _mm256_add_ps(lumMul, _mm256_mul_ps(wH, _mm256_set1_ps(gl[2])));
+            lumMul = _mm256_add_ps(lumMul, _mm256_set1_ps(gl[3]));
+            const __m256 tR = _mm256_mul_ps(GradeSumAvx2(wS, wM, wH, gt[0][0], gt[1][0],
+                                                         gt[2][0], gt[3][0]), white);
+            const __m256 tG = _mm256_mul_ps(GradeSumAvx2(wS, wM, wH, gt[0][1], gt[1][1],
+                                                         gt[2][1], gt[3][1]), white);
+            const __m256 tB = _mm256_mul_ps(GradeSumAvx2(wS, wM, wH, gt[0][2], gt[1][2],
+                                                         gt[2][2], gt[3][2]), white);
+            r = Clamp0Avx2(_mm256_add_ps(_mm256_mul_ps(r, lumMul), tR));
+            g = Clamp0Avx2(_mm256_add_ps(_mm256_mul_ps(g, lumMul), tG));
+            b = Clamp0Avx2(_mm256_add_ps(_mm256_mul_ps(b, lumMul), tB));
+        }
+        _mm256_storeu_ps(R + i, r); _mm256_storeu_ps(G + i, g); _mm256_storeu_ps(B + i, b);
+    }
+    return i;
+}
+#endif
+
+/* ---- NEON ------------------------------------------------------------------------------
+
+   Four pixels per step, the same shape as the AVX2 path. NEON has no gather, so the tone
+   lookup reads its two table entries per lane. */
+#if defined(WINNOW_SIMD_NEON)
+inline float32x4_t Sel(uint32x4_t mask, float32x4_t ifTrue, float32x4_t ifFalse)
+{
+    return vbslq_f32(mask, ifTrue, ifFalse);
+}
+
+inline float32x4_t Clamp0Neon(float32x4_t v)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    return Sel(vcltq_f32(v, zero), zero, v);
+}
+
+inline float32x4_t Dot3Neon(const float *m, float32x4_t r, float32x4_t g, float32x4_t b)
+{
+    return vaddq_f32(vaddq_f32(vmulq_n_f32(r, m[0]), vmulq_n_f32(g, m[1])),
+                     vmulq_n_f32(b, m[2]));
+}
+
+inline float32x4_t SatLumNeon(float32x4_t Y, float32x4_t sF, float32x4_t h, float lumG)
+{
+    return Clamp0Neon(vmulq_n_f32(vaddq_f32(Y, vmulq_f32(sF, vsubq_f32(h, Y))), lumG));
+}
+
+float32x4_t PowNeon(float32x4_t x, float p)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const uint32x4_t valid = vcgtq_f32(x, vdupq_n_f32(kPowMin));
+    x = Sel(valid, x, one);
+    x = Sel(vcltq_f32(x, vdupq_n_f32(kPowMax)), x, vdupq_n_f32(kPowMax));
+
+    const uint32x4_t u = vreinterpretq_u32_f32(x);
+    int32x4_t e = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(u, 23)), vdupq_n_s32(127));
+    float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(u, vdupq_n_u32(0x007fffff)),
+                                                    vdupq_n_u32(0x3f800000)));
+    const uint32x4_t big = vcgtq_f32(m, vdupq_n_f32(kSqrt2));
+    m = Sel(big, vmulq_n_f32(m, 0.5f), m);
+    e = vaddq_s32(e, vreinterpretq_s32_u32(vandq_u32(big, vdupq_n_u32(1))));
+
+    const float32x4_t z = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+    const float32x4_t z2 = vmulq_f32(z, z);
+    float32x4_t s = vdupq_n_f32(kAtanh11);
+    s = vaddq_f32(vmulq_f32(s, z2), vdupq_n_f32(kAtanh9));
+    s = vaddq_f32(vmulq_f32(s, z2), vdupq_n_f32(kAtanh7));
+    s = vaddq_f32(vmulq_f32(s, z2), vdupq_n_f32(kAtanh5));
+    s = vaddq_f32(vmulq_f32(s, z2), vdupq_n_f32(kAtanh3));
+    s = vaddq_f32(vmulq_f32(s, z2), one);
+    const float32x4_t lnm = vmulq_f32(vaddq_f32(z, z), s);
+    const float32x4_t l2 = vaddq_f32(vcvtq_f32_s32(e), vmulq_n_f32(lnm, kLog2e));
+
+    const float32x4_t t = vmulq_n_f32(l2, p);
+    const float32x4_t kf = vrndmq_f32(vaddq_f32(t, vdupq_n_f32(0.5f)));
+    const float32x4_t f = vmulq_n_f32(vsubq_f32(t, kf), kLn2);
+    float32x4_t q = vdupq_n_f32(kExp7);
+    q = vaddq_f32(vmulq_f32(q, f), vdupq_n_f32(kExp6));
+    q = vaddq_f32(vmulq_f32(q, f), vdupq_n_f32(kExp5));
+    q = vaddq_f32(vmulq_f32(q, f), vdupq_n_f32(kExp4));
+    q = vaddq_f32(vmulq_f32(q, f), vdupq_n_f32(kExp3));
+    q = vaddq_f32(vmulq_f32(q, f), vdupq_n_f32(kExp2));
+    q = vaddq_f32(vmulq_f32(q, f), one);
+    q = vaddq_f32(vmulq_f32(q, f), one);
+    const int32x4_t scaled = vaddq_s32(vreinterpretq_s32_f32(q),
+                                       vshlq_n_s32(vcvtq_s32_f32(kf), 23));
+    return vreinterpretq_f32_u32(vandq_u32(valid, vreinterpretq_u32_s32(scaled)));
+}
+
+float32x4_t ToneNeon(const float *lut, float32x4_t v, const Consts &k)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t n = vmulq_n_f32(v, k.invWhite);
+    n = Sel(vcltq_f32(n, zero), zero, n);
+    const float32x4_t fi = vmulq_n_f32(PowNeon(n, k.invGamma), k.lutScale);
+    const uint32x4_t above = vcgeq_f32(fi, vdupq_n_f32(float(k.lutLast)));
+    const int32x4_t i = vcvtq_s32_f32(Sel(above, zero, fi));
+    const float32x4_t frac = vsubq_f32(fi, vcvtq_f32_s32(i));
+    int idx[4];
+    vst1q_s32(idx, i);
+    const float lo4[4] = {lut[idx[0]], lut[idx[1]], lut[idx[2]], lut[idx[3]]};
+    const float hi4[4] = {lut[idx[0] + 1], lut[idx[1] + 1], lut[idx[2] + 1], lut[idx[3] + 1]};
+    const float32x4_t lo = vld1q_f32(lo4), hi = vld1q_f32(hi4);
+    const float32x4_t out = vmulq_n_f32(vaddq_f32(lo, vmulq_f32(vsubq_f32(hi, lo), frac)),
+                                        k.white);
+    return Sel(above, vdupq_n_f32(lut[k.lutLast] * k.white), out);
+}
+
+inline float32x4_t SmoothStepNeon(float32x4_t t)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+    t = Sel(vcltq_f32(t, zero), zero, Sel(vcgtq_f32(t, one), one, t));
+    return vmulq_f32(vmulq_f32(t, t), vsubq_f32(vdupq_n_f32(3.0f), vmulq_n_f32(t, 2.0f)));
+}
+
+inline float32x4_t GradeSumNeon(float32x4_t wS, float32x4_t wM, float32x4_t wH,
+                                float a, float b, float c, float d)
+{
+    return vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(wS, a), vmulq_n_f32(wM, b)),
+                               vmulq_n_f32(wH, c)),
+                     vdupq_n_f32(d));
+}
+
+int ApplyNeon(float *R, float *G, float *B, int n, const PointKernels::Coeffs &c,
+              const Consts &k)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+    const float (*gt)[3] = c.gradeTint;
+    const float *gl = c.gradeLum;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t r = vld1q_f32(R + i), g = vld1q_f32(G + i), b = vld1q_f32(B + i);
+        if (k.doGain) {
+            r = vmulq_n_f32(r, c.channelGain[0]);
+            g = vmulq_n_f32(g, c.channelGain[1]);
+            b = vmulq_n_f32(b, c.channelGain[2]);
+        }
+        if (k.doCal) {
+            const float32x4_t cr = Dot3Neon(c.calMat + 0, r, g, b);
+            const float32x4_t cg = Dot3Neon(c.calMat + 3, r, g, b);
+            const float32x4_t cb = Dot3Neon(c.calMat + 6, r, g, b);
+            r = Clamp0Neon(cr); g = Clamp0Neon(cg); b = Clamp0Neon(cb);
+        }
+        if (k.doTone) {
+            r = ToneNeon(c.toneLut[0], r, k);
+            g = ToneNeon(c.toneLut[1], g, k);
+            b = ToneNeon(c.toneLut[2], b, k);
+        }
+        if (k.doHsl) {
+            const float32x4_t hr = Dot3Neon(c.hueMat + 0, r, g, b);
+            const float32x4_t hg = Dot3Neon(c.hueMat + 3, r, g, b);
+            const float32x4_t hb = Dot3Neon(c.hueMat + 6, r, g, b);
+            const float32x4_t Y = vaddq_f32(vaddq_f32(vmulq_n_f32(hr, 0.2126f),
+                                                      vmulq_n_f32(hg, 0.7152f)),
+                                            vmulq_n_f32(hb, 0.0722f));
+            float32x4_t sF = vdupq_n_f32(c.satFactor);
+            if (k.doVib) {
+                const float32x4_t mx = Sel(vcgtq_f32(hr, hg), Sel(vcgtq_f32(hr, hb), hr, hb),
+                                                              Sel(vcgtq_f32(hg, hb), hg, hb));
+                const float32x4_t mn = Sel(vcltq_f32(hr, hg), Sel(vcltq_f32(hr, hb), hr, hb),
+                                                              Sel(vcltq_f32(hg, hb), hg, hb));
+                const float32x4_t pxSat = Sel(vcgtq_f32(mx, vdupq_n_f32(1e-6f)),
+                                              vdivq_f32(vsubq_f32(mx, mn), mx), zero);
+                sF = vmulq_f32(sF, vaddq_f32(one, vmulq_n_f32(vsubq_f32(one, pxSat),
+                                                              c.vibAmount)));
+                sF = Clamp0Neon(sF);
+            }
+            r = SatLumNeon(Y, sF, hr, c.lumGain);
+            g = SatLumNeon(Y, sF, hg, c.lumGain);
+            b = SatLumNeon(Y, sF, hb, c.lumGain);
+        }
+        if (k.doGrade) {
+            const float32x4_t Yg = vaddq_f32(vaddq_f32(vmulq_n_f32(r, 0.2126f),
+                                                       vmulq_n_f32(g, 0.7152f)),
+                                             vmulq_n_f32(b, 0.0722f));
+            float32x4_t nL = vmulq_n_f32(Yg, k.invWhite);
+            nL = Sel(vcltq_f32(nL, zero), zero, Sel(vcgtq_f32(nL, one), one, nL));
+            const float32x4_t L = PowNeon(nL, k.invGamma);
+            const float32x4_t wS = vsubq_f32(one, SmoothStepNeon(
+                vdivq_f32(L, vdupq_n_f32(c.gradeShadowEnd))));
+            const float32x4_t wH = SmoothStepNeon(vdivq_f32(
+                vsubq_f32(L, vdupq_n_f32(c.gradeHighStart)), vdupq_n_f32(k.oneMinusHigh)));
+            const float32x4_t wM = Clamp0Neon(vsubq_f32(vsubq_f32(one, wS), wH));
+            float32x4_t lumMul = vaddq_f32(one, vmulq_n_f32(wS, gl[0]));
+            lumMul = vaddq_f32(lumMul, vmulq_n_f32(wM, gl[1]));
+            lumMul = vaddq_f32(lumMul, vmulq_n_f32(wH, gl[2]));
+            lumMul = vaddq_f32(lumMul, vdupq_n_f32(gl[3]));
+            const float32x4_t tR = vmulq_n_f32(GradeSumNeon(wS, wM, wH, gt[0][0], gt[1][0],
+                                                            gt[2][0], gt[3][0]), k.white);
+            const float32x4_t tG = vmulq_n_f32(GradeSumNeon(wS, wM, wH, gt[0][1], gt[1][1],
+                                                            gt[2][1], gt[3][1]), k.white);
+            const float32x4_t tB = vmulq_n_f32(GradeSumNeon(wS, wM, wH, gt[0][2], gt[1][2],
+                                                            gt[2][2], gt[3][2]), k.white);
+            r = Clamp0Neon(vaddq_f32(vmulq_f32(r, lumMul), tR));
+            g = Clamp0Neon(vaddq_f32(vmulq_f32(g, lumMul), tG));
+            b = Clamp0Neon(vaddq_f32(vmulq_f32(b, lumMul), tB));
+        }
+        vst1q_f32(R + i, r); vst1q_f32(G + i, g); vst1q_f32(B + i, b);
+    }
+    return i;
+}
+#endif
+
+void ApplyPlanar(float *R, float *G, float *B, int n, const PointKernels::Coeffs &c,
+                 const Consts &k, Level level)
+{
+    int i = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::SSE41: i = ApplySse(R, G, B, n, c, k); break;
+    case Level::AVX2:  i = ApplyAvx2(R, G, B, n, c, k); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  i = ApplyNeon(R, G, B, n, c, k); break;
+#endif
+    default: break;
+    }
+    ApplyScalar(R, G, B, i, n, c, k);
+}
+
+} // namespace
+
+float PointKernels::Pow(float x, float p)
+{
+    if (!(x > kPowMin)) return 0.0f;
+    x = (x < kPowMax) ? x : kPowMax;
+
+    uint32_t u;
+    std::memcpy(&u, &x, 4);
+    int e = int(u >> 23) - 127;
+    u = (u & 0x007fffffu) | 0x3f800000u;
+    float m;
+    std::memcpy(&m, &u, 4);
+    if (m > kSqrt2) { m = m * 0.5f; e += 1; }
+
+    const float z = (m - 1.0f) / (m + 1.0f);
+    const float z2 = z * z;
+    float s = kAtanh11;
+    s = s * z2 + kAtanh9;
+    s = s * z2 + kAtanh7;
+    s = s * z2 + kAtanh5;
+    s = s * z2 + kAtanh3;
+    s = s * z2 + 1.0f;
+    const float lnm = (z + z) * s;
+    const float l2 = float(e) + lnm * kLog2e;
+
+    const float t = l2 * p;
+    const float kf = std::floor(t + 0.5f);
+    const float f = (t - kf) * kLn2;
+    float q = kExp7;
+    q = q * f + kExp6;
+    q = q * f + kExp5;
+    q = q * f + kExp4;
+    q = q * f + kExp3;
+    q = q * f + kExp2;
+    q = q * f + 1.0f;
+    q = q * f + 1.0f;
+    std::memcpy(&u, &q, 4);
+    u += uint32_t(int(kf)) << 23;
+    std::memcpy(&q, &u, 4);
+    return q;
+}
+
+void PointKernels::Apply(float *r, float *g, float *b, int n, const Coeffs &c, Level level)
+{
+    if (n <= 0) return;
+    ApplyPlanar(r, g, b, n, c, MakeConsts(c), level);
+}
+
+void PointKernels::ApplyInterleaved(float *rgb, int n, const Coeffs &c, Level level)
+{
+    if (n <= 0) return;
+    const Consts k = MakeConsts(c);
+    alignas(32) float R[kChunk], G[kChunk], B[kChunk];
+    for (int x0 = 0; x0 < n; x0 += kChunk) {
+        const int m = std::min(kChunk, n - x0);
+        float *px = rgb + size_t(x0) * 3;
+        for (int i = 0; i < m; ++i) {
+            R[i] = px[3 * i]; G[i] = px[3 * i + 1]; B[i] = px[3 * i + 2];
+        }
+        ApplyPlanar(R, G, B, m, c, k, level);
+        for (int i = 0; i < m; ++i) {
+            px[3 * i] = R[i]; px[3 * i + 1] = G[i]; px[3 * i + 2] = B[i];
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef POINTKERNELS_H
+#define POINTKERNELS_H
+
+#include <cstddef>
+#include "Utilities/simd.h"
+
+/*
+    Develop's fused per-pixel point pass -- gain, calibration, tone curve, HSL and colour
+    grade -- as a kernel over PLANAR rows, with a scalar reference and SSE4.1 / AVX2 / NEON
+    versions picked by Winnow::Simd::level(). All levels produce bit-identical output
+    (tst_pointkernels). Only AVX2 gathers the tone table; SSE4.1 and NEON read it per lane.
+
+    PLANAR. WorkingImage stays interleaved (every other op, the decoders and the caches
+    use it), so ApplyInterleaved splits a row into R, G and B runs of kChunk pixels on the
+    stack, runs the planar kernel and writes them back. The transpose is a few percent of
+    the work; what it buys is eight pixels per instruction through the matrices and the
+    lookups, where the interleaved loop had one.
+
+    POW. The tone curve and the grade windows both need s = v^(1/gamma). std::pow has no
+    vector form, so the kernel uses Pow below -- log2 by the atanh series, exp2 by its
+    Taylor series, spelled out with the same operations in the same order at every level,
+    so the scalar reference and the vector paths agree to the bit. It is within 5e-7
+    relative of std::pow (tst_pointkernels asserts 2e-6); against the std::pow pass it
+    replaced, no output value moves by as much as a 16-bit step.
+*/
+namespace PointKernels {
+
+/* Precomputed once per Apply() (Develop::buildPointCoeffs); the fused point pass reads
+   only these. active == false means no implemented point op would change a pixel, so the
+   pass is skipped entirely. */
+struct Coeffs {
+    bool  active        = false;
+    /* Per-channel scene-linear gain = white balance (temp/tint) folded with exposure (2^EV)
+       AND the Colour RGB sliders (red/green/blue). All are pure linear multiplies, so they
+       commute and combine into one per-channel factor applied before the perceptual tone
+       curve. {1,1,1} = identity. */
+    float channelGain[3] = {1.0f, 1.0f, 1.0f};
+    float white         = 1.0f;   // linear value that maps to display white
+    float invGamma      = 1.0f / 2.2f;   // perceptual encode exponent (Develop's kInvGamma)
+
+    /* Perceptual-domain tone curve: contrast, the four tone-region controls
+       (highlights/shadows/whites/blacks) and the Curves panel's tone curve are all
+       pure 1-D functions of a channel's white-normalised value, so they are baked
+       once into a lookup table. The table is indexed by the perceptual value
+       s = (v/white)^(1/gamma) in [0, toneLutSMax] and returns the white-normalised
+       LINEAR output (i.e. it folds the gamma decode back in), so the hot loop does
+       one pow (encode) + one interpolated lookup instead of several pow/exp per
+       pixel.
+       toneActive == false => identity tone curve (skip it).
+
+       THREE tables, one per channel, because the Curves panel carries separate Red /
+       Green / Blue curves on top of its RGB composite. Everything shared -- contrast,
+       the region lifts, the composite curve -- is computed once and written into all
+       three, so the extra cost is the table build, not the hot loop (which does the
+       same single lookup either way, just into toneLut[ch]). */
+    static constexpr int kLutSize = 1024;
+    bool  toneActive = false;
+    float toneLutSMax = 1.0f;          // perceptual s domain the table spans is [0, this]
+    /* s -> white-normalised linear output, one table per channel. */
+    float toneLut[3][kLutSize] = {};
+
+    /* Calibration (Calibrate panel) -- a 3x3 matrix (row-major) re-pointing the R/G/B
+       primaries, applied in LINEAR light right after channelGain and BEFORE the tone
+       curve. Its columns are the rotated/chroma-scaled primaries, built so neutrals
+       are fixed. calActive == false => identity (skip the block). */
+    bool  calActive = false;
+    float calMat[9] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+
+    /* HSL (hue/saturation/luminance) -- a cross-channel point op applied AFTER the
+       tone curve in the same fused pass (it mixes the three channels, so unlike the
+       tone curve it cannot be a per-channel LUT). hueMat is a 3x3 rotation about the
+       neutral axis (row-major, used only when hue != 0); satFactor scales chroma
+       about luma; vibAmount is a per-pixel saturation boost weighted by how muted the
+       pixel already is (0 = off); lumGain is a uniform gain. hslActive == false =>
+       identity (skip the block). */
+    bool  hslActive  = false;
+    float hueMat[9]  = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    float satFactor  = 1.0f;
+    float vibAmount  = 0.0f;
+    float lumGain    = 1.0f;
+
+    /* Colour grading (Color Grade panel) -- tonal-range tinting applied after HSL in
+       the same fused pass. For each of the four ranges [0]=shadows, [1]=midtones,
+       [2]=highlights, [3]=GLOBAL: gradeTint is a zero-luma RGB chroma push (hue+sat
+       pre-scaled) ADDED to the pixel, gradeLum a per-range luminance gain delta.
+       Ranges 0-2 are weighted per pixel by smooth tonal windows of the pixel's luma;
+       range 3 is NOT tone-selective and applies at weight 1 everywhere, so it needs
+       no window (see Apply). gradeShadowEnd / gradeHighStart are those
+       windows' split points, derived once from the panel's Blending + Balance
+       sliders. gradeActive == false => identity (skip the block). */
+    bool  gradeActive = false;
+    float gradeTint[4][3] = {};   // [range][rgb], zero-luma chroma offset
+    float gradeLum[4]     = {};   // [range] luminance gain delta (0 = none)
+    float gradeShadowEnd  = 0.5f; // perceptual L where the shadow window closes
+    float gradeHighStart  = 0.5f; // perceptual L where the highlight window opens
+};
+
+/* Pixels per planar run in ApplyInterleaved: three runs are 768 bytes of stack. */
+constexpr int kChunk = 64;
+
+/* x^p for 0 < p <= 1. x <= 1e-30 (and NaN) gives 0, x is capped at 1e30. */
+float Pow(float x, float p);
+
+/* The point ops over n pixels of planar rows, in place. */
+void Apply(float *r, float *g, float *b, int n, const Coeffs &c,
+           Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* The same over n interleaved RGB pixels (a WorkingImage row), through planar runs. */
+void ApplyInterleaved(float *rgb, int n, const Coeffs &c,
+                      Winnow::Simd::Level level = Winnow::Simd::level());
+
+} // namespace PointKernels
+
+#endif // POINTKERNELS_H
@@ -0,0 +1,380 @@
+#include "Develop/pointlut.h"
+#include <algorithm>
+#include <cmath>
+
+WINNOW_SIMD_NO_FP_CONTRACT
+
+using Winnow::Simd::Level;
+
+namespace {
+
+constexpr int kLast = PointLut::kSize - 1;
+
+/* Table strides in floats, and the step to a cell's far corner. */
+constexpr int kStrideB = 3;
+constexpr int kStrideG = PointLut::kSize * kStrideB;
+constexpr int kStrideR = PointLut::kSize * kStrideG;
+constexpr int kStrideAll = kStrideR + kStrideG + kStrideB;
+
+/* The pixel-side constants every level uses. */
+struct Lattice {
+    const float *t;
+    float range, scale;
+};
+
+/* ---- Scalar reference -----------------------------------------------------------------
+
+   Each axis: f = (v / range)^(1/4) * kLast -- two square roots --, cell = trunc(f)
+   capped at kLast - 1, fraction d = f - cell. The cube's six tetrahedra share the
+   diagonal from the cell's low corner to its high corner; the one holding the pixel is
+   found by ordering its three fractions, and its vertices are reached by stepping along
+   the axes in that order. The weights are the gaps between the ordered fractions. */
+inline bool InDomain(float v, float range) { return v >= 0.0f && v <= range; }
+
+inline void Axis(float v, float scale, int &cell, float &d)
+{
+    const float f = std::sqrt(std::sqrt(v * scale)) * float(kLast);
+    cell = static_cast<int>(f);
+    if (cell > kLast - 1) cell = kLast - 1;
+    d = f - float(cell);
+}
+
+inline float Decode(float w0, float w1, float w2, float w3, const float *c0, const float *c1,
+                    const float *c2, const float *c3, int ch, float range)
+{
+    const float e = ((w0 * c0[ch] + w1 * c1[ch]) + w2 * c2[ch]) + w3 * c3[ch];
+    return (e * e) * range;
+}
+
+/* Pixels [from, n): in-domain ones are replaced by the table, the rest are left alone and
+   their indices appended to miss. Returns the new miss count. */
+int LookupScalar(float *R, float *G, float *B, int from, int n, const Lattice &k,
+                 int *miss, int misses)
+{
+    for (int i = from; i < n; ++i) {
+        if (!(InDomain(R[i], k.range) && InDomain(G[i], k.range) && InDomain(B[i], k.range))) {
+            miss[misses++] = i;
+            continue;
+        }
+        int ir, ig, ib;
+        float dr, dg, db;
+        Axis(R[i], k.scale, ir, dr);
+        Axis(G[i], k.scale, ig, dg);
+        Axis(B[i], k.scale, ib, db);
+
+        float dMax, dMid, dMin;
+        int o1, o2;
+        const bool rg = dr >= dg, gb = dg >= db, rb = dr >= db;
+        if (rg) {
+            if (gb)      { dMax = dr; dMid = dg; dMin = db; o1 = kStrideR; o2 = kStrideR + kStrideG; }
+            else if (rb) { dMax = dr; dMid = db; dMin = dg; o1 = kStrideR; o2 = kStrideR + kStrideB; }
+            else         { dMax = db; dMid = dr; dMin = dg; o1 = kStrideB; o2 = kStrideB + kStrideR; }
+        }
+        else {
+            if (rb)      { dMax = dg; dMid = dr; dMin = db; o1 = kStrideG; o2 = kStrideG + kStrideR; }
+            else if (gb) { dMax = dg; dMid = db; dMin = dr; o1 = kStrideG; o2 = kStrideG + kStrideB; }
+            else         { dMax = db; dMid = dg; dMin = dr; o1 = kStrideB; o2 = kStrideB + kStrideG; }
+        }
+        const float w0 = 1.0f - dMax, w1 = dMax - dMid, w2 = dMid - dMin, w3 = dMin;
+        const float *c0 = k.t + ir * kStrideR + ig * kStrideG + ib * kStrideB;
+        const float *c1 = c0 + o1, *c2 = c0 + o2, *c3 = c0 + kStrideAll;
+        R[i] = Decode(w0, w1, w2, w3, c0, c1, c2, c3, 0, k.range);
+        G[i] = Decode(w0, w1, w2, w3, c0, c1, c2, c3, 1, k.range);
+        B[i] = Decode(w0, w1, w2, w3, c0, c1, c2, c3, 2, k.range);
+    }
+    return misses;
+}
+
+/* ---- AVX2 ------------------------------------------------------------------------------
+
+   Eight pixels per step. The scalar if-tree becomes masks: which axis has the largest
+   fraction picks the first step, which has the smallest is the one the second step
+   leaves out. Out-of-domain lanes look up the origin and keep their input. Twelve
+   gathers per step (four nodes x three channels). */
+#if defined(WINNOW_SIMD_X86)
+WINNOW_TARGET_AVX2
+inline __m256 Sel(__m256 mask, __m256 ifTrue, __m256 ifFalse)
+{
+    return _mm256_blendv_ps(ifFalse, ifTrue, mask);
+}
+
+WINNOW_TARGET_AVX2
+inline __m256i SelI(__m256 mask, __m256i ifTrue, __m256i ifFalse)
+{
+    return _mm256_blendv_epi8(ifFalse, ifTrue, _mm256_castps_si256(mask));
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 InDomainAvx2(__m256 v, __m256 range)
+{
+    return _mm256_and_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ),
+                         _mm256_cmp_ps(v, range, _CMP_LE_OQ));
+}
+
+WINNOW_TARGET_AVX2
+inline void AxisAvx2(__m256 v, __m256 scale, __m256i &cell, __m256 &d)
+{
+    const __m256 f = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sqrt_ps(_mm256_mul_ps(v, scale))),
+                                   _mm256_set1_ps(float(kLast)));
+    cell = _mm256_min_epi32(_mm256_cvttps_epi32(f), _mm256_set1_epi32(kLast - 1));
+    d = _mm256_sub_ps(f, _mm256_cvtepi32_ps(cell));
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 DecodeAvx2(__m256 w0, __m256 w1, __m256 w2, __m256 w3, __m256i c0, __m256i c1,
+                         __m256i c2, __m256i c3, const float *t, __m256 range)
+{
+    __m256 e = _mm256_add_ps(_mm256_mul_ps(w0, _mm256_i32gather_ps(t, c0, 4)),
+                             _mm256_mul_ps(w1, _mm256_i32gather_ps(t, c1, 4)));
+    e = _mm256_add_ps(e, _mm256_mul_ps(w2, _mm256_i32gather_ps(t, c2, 4)));
+    e = _mm256_add_ps(e, _mm256_mul_ps(w3, _mm256_i32gather_ps(t, c3, 4)));
+    return _mm256_mul_ps(_mm256_mul_ps(e, e), range);
+}
+
+WINNOW_TARGET_AVX2
+int LookupAvx2(float *R, float *G, float *B, int n, const Lattice &k, int *miss, int &misses)
+{
+    const __m256 range = _mm256_set1_ps(k.range), scale = _mm256_set1_ps(k.scale);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 allOnes = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    const __m256i sR = _mm256_set1_epi32(kStrideR), sG = _mm256_set1_epi32(kStrideG);
+    const __m256i sB = _mm256_set1_epi32(kStrideB), sAll = _mm256_set1_epi32(kStrideAll);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 r0 = _mm256_loadu_ps(R + i), g0 = _mm256_loadu_ps(G + i);
+        const __m256 b0 = _mm256_loadu_ps(B + i);
+        const __m256 in = _mm256_and_ps(_mm256_and_ps(InDomainAvx2(r0, range),
+                                                      InDomainAvx2(g0, range)),
+                                        InDomainAvx2(b0, range));
+        const int out = ~_mm256_movemask_ps(in) & 0xff;
+        if (out) {
+            for (int j = 0; j < 8; ++j)
+                if (out & (1 << j)) miss[misses++] = i + j;
+        }
+
+        __m256i ir, ig, ib;
+        __m256 dr, dg, db;
+        AxisAvx2(_mm256_and_ps(in, r0), scale, ir, dr);
+        AxisAvx2(_mm256_and_ps(in, g0), scale, ig, dg);
+        AxisAvx2(_mm256_and_ps(in, b0), scale, ib, db);
+
+        const __m256 rg = _mm256_cmp_ps(dr, dg, _CMP_GE_OQ);
+        const __m256 gb = _mm256_cmp_ps(dg, db, _CMP_GE_OQ);
+        const __m256 rb = _mm256_cmp_ps(dr, db, _CMP_GE_OQ);
+        const __m256 nrg = _mm256_xor_ps(rg, allOnes);
+        const __m256 maxR = _mm256_and_ps(rg, _mm256_or_ps(gb, rb));
+        const __m256 maxG = _mm256_and_ps(nrg, _mm256_or_ps(gb, rb));
+        const __m256 minB = _mm256_or_ps(_mm256_and_ps(rg, gb), _mm256_and_ps(nrg, rb));
+        const __m256 minG = _mm256_andnot_ps(gb, rg);
+        const __m256 midR = _mm256_xor_ps(_mm256_or_ps(maxR, _mm256_andnot_ps(
+                                              _mm256_or_ps(minB, minG), allOnes)), allOnes);
+        const __m256 midG = _mm256_xor_ps(_mm256_or_ps(maxG, minG), allOnes);
+
+        const __m256 dMax = Sel(maxR, dr, Sel(maxG, dg, db));
+        const __m256 dMin = Sel(minB, db, Sel(minG, dg, dr));
+        const __m256 dMid = Sel(midR, dr, Sel(midG, dg, db));
+        const __m256 w0 = _mm256_sub_ps(one, dMax), w1 = _mm256_sub_ps(dMax, dMid);
+        const __m256 w2 = _mm256_sub_ps(dMid, dMin), w3 = dMin;
+
+        const __m256i c0 = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(ir, sR),
+                                                             _mm256_mullo_epi32(ig, sG)),
+                                            _mm256_mullo_epi32(ib, sB));
+        const __m256i o1 = SelI(maxR, sR, SelI(maxG, sG, sB));
+        const __m256i o2 = _mm256_sub_epi32(sAll, SelI(minB, sB, SelI(minG, sG, sR)));
+        const __m256i c1 = _mm256_add_epi32(c0, o1), c2 = _mm256_add_epi32(c0, o2);
+        const __m256i c3 = _mm256_add_epi32(c0, sAll);
+
+        const __m256 r = DecodeAvx2(w0, w1, w2, w3, c0, c1, c2, c3, k.t, range);
+        const __m256 g = DecodeAvx2(w0, w1, w2, w3, c0, c1, c2, c3, k.t + 1, range);
+        const __m256 b = DecodeAvx2(w0, w1, w2, w3, c0, c1, c2, c3, k.t + 2, range);
+        _mm256_storeu_ps(R + i, Sel(in, r, r0));
+        _mm256_storeu_ps(G + i, Sel(in, g, g0));
+        _mm256_storeu_ps(B + i, Sel(in, b, b0));
+    }
+    return i;
+}
+#endif
+
+/* ---- NEON ------------------------------------------------------------------------------
+
+   Four pixels per step, the AVX2 masks with NEON's bit-selects. No gather: the four
+   nodes are read per lane. */
+#if defined(WINNOW_SIMD_NEON)
+inline float32x4_t Sel(uint32x4_t mask, float32x4_t ifTrue, float32x4_t ifFalse)
+{
+    return vbslq_f32(mask, ifTrue, ifFalse);
+}
+
+inline uint32x4_t InDomainNeon(float32x4_t v, float range)
+{
+    return vandq_u32(vcgeq_f32(v, vdupq_n_f32(0.0f)), vcleq_f32(v, vdupq_n_f32(range)));
+}
+
+inline void AxisNeon(float32x4_t v, float scale, int32x4_t &cell, float32x4_t &d)
+{
+    const float32x4_t f = vmulq_n_f32(vsqrtq_f32(vsqrtq_f32(vmulq_n_f32(v, scale))),
+                                      float(kLast));
+    cell = vminq_s32(vcvtq_s32_f32(f), vdupq_n_s32(kLast - 1));
+    d = vsubq_f32(f, vcvtq_f32_s32(cell));
+}
+
+inline float32x4_t DecodeNeon(float32x4_t w0, float32x4_t w1, float32x4_t w2, float32x4_t w3,
+                              const int *c0, const int *c1, const int *c2, const int *c3,
+                              const float *t, float range)
+{
+    const float a[4] = {t[c0[0]], t[c0[1]], t[c0[2]], t[c0[3]]};
+    const float b[4] = {t[c1[0]], t[c1[1]], t[c1[2]], t[c1[3]]};
+    const float c[4] = {t[c2[0]], t[c2[1]], t[c2[2]], t[c2[3]]};
+    const float d[4] = {t[c3[0]], t[c3[1]], t[c3[2]], t[c3[3]]};
+    float32x4_t e = vaddq_f32(vmulq_f32(w0, vld1q_f32(a)), vmulq_f32(w1, vld1q_f32(b)));
+    e = vaddq_f32(e, vmulq_f32(w2, vld1q_f32(c)));
+    e = vaddq_f32(e, vmulq_f32(w3, vld1q_f32(d)));
+    return vmulq_n_f32(vmulq_f32(e, e), range);
+}
+
+int LookupNeon(float *R, float *G, float *B, int n, const Lattice &k, int *miss, int &misses)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const int32x4_t sR = vdupq_n_s32(kStrideR), sG = vdupq_n_s32(kStrideG);
+    const int32x4_t sB = vdupq_n_s32(kStrideB), sAll = vdupq_n_s32(kStrideAll);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t r0 = vld1q_f32(R + i), g0 = vld1q_f32(G + i), b0 = vld1q_f32(B + i);
+        const uint32x4_t in = vandq_u32(vandq_u32(InDomainNeon(r0, k.range),
+                                                  InDomainNeon(g0, k.range)),
+                                        InDomainNeon(b0, k.range));
+        uint32_t inLane[4];
+        vst1q_u32(inLane, in);
+        for (int j = 0; j < 4; ++j)
+            if (!inLane[j]) miss[misses++] = i + j;
+
+        int32x4_t ir, ig, ib;
+        float32x4_t dr, dg, db;
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        AxisNeon(Sel(in, r0, zero), k.scale, ir, dr);
+        AxisNeon(Sel(in, g0, zero), k.scale, ig, dg);
+        AxisNeon(Sel(in, b0, zero), k.scale, ib, db);
+
+        const uint32x4_t rg = vcgeq_f32(dr, dg), gb = vcgeq_f32(dg, db), rb = vcgeq_f32(dr, db);
+        const uint32x4_t maxR = vandq_u32(rg, vorrq_u32(gb, rb));
+        const uint32x4_t maxG = vbicq_u32(vorrq_u32(gb, rb), rg);
+        const uint32x4_t minB = vorrq_u32(vandq_u32(rg, gb), vbicq_u32(rb, rg));
+        const uint32x4_t minG = vbicq_u32(rg, gb);
+        const uint32x4_t midR = vmvnq_u32(vorrq_u32(maxR, vmvnq_u32(vorrq_u32(minB, minG))));
+        const uint32x4_t midG = vmvnq_u32(vorrq_u32(maxG, minG));
+
+        const float32x4_t dMax = Sel(maxR, dr, Sel(maxG, dg, db));
+        const float32x4_t dMin = Sel(minB, db, Sel(minG, dg, dr));
+        const float32x4_t dMid = Sel(midR, dr, Sel(midG, dg, db));
+        const float32x4_t w0 = vsubq_f32(one, dMax), w1 = vsubq_f32(dMax, dMid);
+        const float32x4_t w2 = vsubq_f32(dMid, dMin), w3 = dMin;
+
+        const int32x4_t c0 = vaddq_s32(vaddq_s32(vmulq_s32(ir, sR), vmulq_s32(ig, sG)),
+                                       vmulq_s32(ib, sB));
+        const int32x4_t o1 = vbslq_s32(maxR, sR, vbslq_s32(maxG, sG, sB));
+        const int32x4_t o2 = vsubq_s32(sAll, vbslq_s32(minB, sB, vbslq_s32(minG, sG, sR)));
+        int n0[4], n1[4], n2[4], n3[4];
+        vst1q_s32(n0, c0);
+        vst1q_s32(n1, vaddq_s32(c0, o1));
+        vst1q_s32(n2, vaddq_s32(c0, o2));
+        vst1q_s32(n3, vaddq_s32(c0, sAll));
+
+        const float32x4_t r = DecodeNeon(w0, w1, w2, w3, n0, n1, n2, n3, k.t, k.range);
+        const float32x4_t g = DecodeNeon(w0, w1, w2, w3, n0, n1, n2, n3, k.t + 1, k.range);
+        const float32x4_t b = DecodeNeon(w0, w1, w2, w3, n0, n1, n2, n3, k.t + 2, k.range);
+        vst1q_f32(R + i, Sel(in, r, r0));
+        vst1q_f32(G + i, Sel(in, g, g0));
+        vst1q_f32(B + i, Sel(in, b, b0));
+    }
+    return i;
+}
+#endif
+
+int Lookup(float *R, float *G, float *B, int n, const Lattice &k, int *miss, Level level)
+{
+    int i = 0, misses = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  i = LookupAvx2(R, G, B, n, k, miss, misses); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  i = LookupNeon(R, G, B, n, k, miss, misses); break;
+#endif
+    default: break;
+    }
+    return LookupScalar(R, G, B, i, n, k, miss, misses);
+}
+
+} // namespace
+
+void PointLut::Bake(const PointKernels::Coeffs &c, Level level)
+{
+    /* Split the chain where the kernel's blocks split: gain + calibration ahead of the
+       table, everything after them in it. Running the two halves back to back is the
+       whole chain to the bit. */
+    shaper = c;
+    shaper.toneActive = shaper.hslActive = shaper.gradeActive = false;
+    shaper.active = c.calActive || c.channelGain[0] != 1.0f || c.channelGain[1] != 1.0f ||
+                    c.channelGain[2] != 1.0f;
+    tail = c;
+    tail.channelGain[0] = tail.channelGain[1] = tail.channelGain[2] = 1.0f;
+    tail.calActive = false;
+
+    range = kRange * c.white;
+    scale = 1.0f / range;
+
+    /* The lattice as planar rows, run through the kernel in one call. */
+    float axis[kSize];
+    for (int i = 0; i < kSize; ++i) {
+        const float e = float(i) / float(kLast);
+        axis[i] = ((e * e) * (e * e)) * range;
+    }
+    std::vector<float> r(kNodes), g(kNodes), b(kNodes);
+    for (int ir = 0, node = 0; ir < kSize; ++ir)
+        for (int ig = 0; ig < kSize; ++ig)
+            for (int ib = 0; ib < kSize; ++ib, ++node) {
+                r[node] = axis[ir]; g[node] = axis[ig]; b[node] = axis[ib];
+            }
+    PointKernels::Apply(r.data(), g.data(), b.data(), kNodes, tail, level);
+
+    /* Written as a compare so a NaN out of the chain encodes as 0 too. */
+    auto encode = [this](float v) { return (v > 0.0f) ? std::sqrt(v * scale) : 0.0f; };
+    table.resize(size_t(kNodes) * 3);
+    for (int node = 0; node < kNodes; ++node) {
+        table[size_t(node) * 3 + 0] = encode(r[node]);
+        table[size_t(node) * 3 + 1] = encode(g[node]);
+        table[size_t(node) * 3 + 2] = encode(b[node]);
+    }
+}
+
+void PointLut::ApplyInterleaved(float *rgb, int n, Level level) const
+{
+    if (n <= 0 || table.empty()) return;
+    const Lattice k{table.data(), range, scale};
+    constexpr int kChunk = PointKernels::kChunk;
+    alignas(32) float R[kChunk], G[kChunk], B[kChunk];
+    alignas(32) float mr[kChunk], mg[kChunk], mb[kChunk];
+    int miss[kChunk];
+    for (int x0 = 0; x0 < n; x0 += kChunk) {
+        const int m = std::min(kChunk, n - x0);
+        float *px = rgb + size_t(x0) * 3;
+        for (int i = 0; i < m; ++i) {
+            R[i] = px[3 * i]; G[i] = px[3 * i + 1]; B[i] = px[3 * i + 2];
+        }
+        if (shaper.active) PointKernels::Apply(R, G, B, m, shaper, level);
+        const int misses = Lookup(R, G, B, m, k, miss, level);
+        if (misses) {
+            /* Outside the table: gather them into a run of their own for the kernel. */
+            for (int j = 0; j < misses; ++j) {
+                mr[j] = R[miss[j]]; mg[j] = G[miss[j]]; mb[j] = B[miss[j]];
+            }
+            PointKernels::Apply(mr, mg, mb, misses, tail, level);
+            for (int j = 0; j < misses; ++j) {
+                R[miss[j]] = mr[j]; G[miss[j]] = mg[j]; B[miss[j]] = mb[j];
+            }
+        }
+        for (int i = 0; i < m; ++i) {
+            px[3 * i] = R[i]; px[3 * i + 1] = G[i]; px[3 * i + 2] = B[i];
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef POINTLUT_H
+#define POINTLUT_H
+
+#include <cstddef>
+#include <vector>
+#include "Develop/pointkernels.h"
+
+/*
+    Develop's point chain (PointKernels) baked into a 3D table, for the renders a slider
+    drag waits on. Once the EditParams are fixed the chain is a pure function of a pixel's
+    RGB, so Bake evaluates it at kSize^3 lattice points -- through the kernel itself, ~1 ms
+    -- and every pixel after that is one tetrahedral interpolation: four table nodes and a
+    dozen multiplies in place of the chain's powers, matrices and lookups.
+
+    SHAPER. Gain and calibration are linear, and a lattice in any perceptual encoding
+    bends a linear mix of channels into a curve it can only approximate. They are also
+    the cheap part, so they run exactly, per pixel, on the way into the table; the table
+    holds the rest of the chain (tone curve, HSL, grade) from the calibrated values.
+
+    DOMAIN. The axes are encoded e = (v / (kRange x white))^(1/4), two square roots per
+    channel, so half the lattice sits below white / 2 and a quarter below white / 32,
+    where the tone curve and the display encode bend hardest. The stored outputs are
+    square roots against the same range. Pixels with a calibrated channel below 0, above
+    kRange x white or NaN are outside the table and run through the kernel directly, so
+    the table never extrapolates and those pixels match the direct path to the bit.
+
+    ACCURACY. Within the table the result is an approximation. The tone curve and the
+    per-channel curves land within two 8-bit codes of the direct path and most bytes do
+    not move at all; HSL and the grade mix channels and clamp them at 0, and a dark
+    channel of a saturated colour that crosses that clamp inside a cell can be off by far
+    more -- rarely, but visibly. tst_pointlut holds both kinds of bound. So the table is
+    for drag ticks only; the settle render and export stay Direct.
+
+    SIMD. AVX2 gathers the four nodes, NEON reads them per lane; SSE4.1 runs the scalar
+    reference, which every level matches to the bit.
+*/
+class PointLut
+{
+public:
+    static constexpr int   kSize  = 33;                 // lattice points per axis
+    static constexpr int   kNodes = kSize * kSize * kSize;
+    static constexpr float kRange = 8.0f;               // domain top, in multiples of white
+    /* Smaller frames run the chain directly: baking costs about as much as kNodes pixels,
+       so below ~8x that the table does not pay for itself. */
+    static constexpr size_t kMinPixels = size_t(kNodes) * 8;
+
+    /* Bake c: its gain and calibration are kept to run ahead of the table, the rest of
+       the chain is evaluated at every lattice point. */
+    void Bake(const PointKernels::Coeffs &c,
+              Winnow::Simd::Level level = Winnow::Simd::level());
+    bool isBaked() const { return !table.empty(); }
+
+    /* n interleaved RGB pixels in place, through the baked chain. */
+    void ApplyInterleaved(float *rgb, int n,
+                          Winnow::Simd::Level level = Winnow::Simd::level()) const;
+
+private:
+    std::vector<float> table;   // kNodes x encoded RGB, blue fastest, then green, then red
+    float range = 1.0f;         // kRange * white: the linear value at the top of each axis
+    float scale = 1.0f;         // 1 / range
+    PointKernels::Coeffs shaper;  // gain + calibration of the baked chain, run per pixel
+    PointKernels::Coeffs tail;    // the chain after them: what the table and misses run
+};
+
+#endif // POINTLUT_H
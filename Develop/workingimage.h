@@ -76,6 +76,19 @@ struct WorkingImage {
        sidecar and make the proxy and settle renders miss each other's cache entries. */
     float renderScale = 1.0f;
 
+    /* The full-resolution frame this image is a WINDOW of, for a viewport render
+       (WorkingImageCache::renderWindow): its size, and where this image's (0,0) sits in
+       it. Zero frameW/frameH -- every image but a window -- means the image IS the frame.
+       The spatial ops that size a radius from the long edge (Texture, Clarity, Dehaze,
+       Grain, Denoise's working resolution) or place a pattern on the frame (Vignette's
+       centre, Grain's noise field) read the frame instead of width/height, so a window
+       develops as that part of the whole frame would. Not carried by downscaled(): a
+       proxy is always a whole frame. */
+    int frameX = 0, frameY = 0;
+    int frameW = 0, frameH = 0;
+    int frameWidth() const { return frameW > 0 ? frameW : width; }
+    int frameHeight() const { return frameH > 0 ? frameH : height; }
+
     bool isValid() const {
         return width > 0 && height > 0 &&
                rgb.size() == static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
@@ -113,6 +126,10 @@ inline void assignReusing(WorkingImage &dst, const WorkingImage &src)
     dst.white         = src.white;
     dst.sceneReferred = src.sceneReferred;
     dst.renderScale   = src.renderScale;
+    dst.frameX        = src.frameX;
+    dst.frameY        = src.frameY;
+    dst.frameW        = src.frameW;
+    dst.frameH        = src.frameH;
     dst.rgb.assign(src.rgb.begin(), src.rgb.end());
 }
 
@@ -2,15 +2,35 @@
 #include "Develop/develop.h"
 #include "Develop/outputtransform.h"
 #include <QImage>
+#include <QRect>
 #include <QElapsedTimer>
 #include <QtConcurrent>
 #include <QThreadPool>
 #include <QFuture>
+#include <QPair>
+#include <QVector>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <algorithm>
 #include <cmath>
 
+namespace {
+/* The final OutputTransform at the requested depth (WorkingImageCache::OutDepth). */
+bool toImageAt(OutputTransform &output, const WorkingImage &src, QImage &dst,
+               WorkingImageCache::OutDepth depth, OutputTransform::Space space)
+{
+    switch (depth) {
+    case WorkingImageCache::OutDepth::Sixteen:
+        return output.ToImage16(src, dst, space);
+    case WorkingImageCache::OutDepth::Display:
+        return output.ToImage(src, dst, space, QImage::Format_RGB32);
+    case WorkingImageCache::OutDepth::Eight:
+        break;
+    }
+    return output.ToImage(src, dst, space);
+}
+} // namespace
+
 WorkingImageCache &WorkingImageCache::instance()
 {
     static WorkingImageCache cache;
@@ -23,38 +43,106 @@ qint64 WorkingImageCache::bytesOf(const WorkingImage &work)
     return static_cast<qint64>(work.rgb.size()) * static_cast<qint64>(sizeof(float));
 }
 
+qint64 WorkingImageCache::bytesOf(const HalfImage &half)
+{
+    return static_cast<qint64>(half.rgb.size()) * static_cast<qint64>(sizeof(uint16_t));
+}
+
 void WorkingImageCache::put(const QString &fPath,
                             const std::shared_ptr<const WorkingImage> &work)
 {
     if (fPath.isEmpty() || !work || !work->isValid()) return;
 
-    QMutexLocker lock(&mutex);
-    if (!enabled) return;
+    {
+        QMutexLocker lock(&mutex);
+        if (!enabled) return;
 
-    /* Replace any existing entry (e.g. re-decode of the same path). */
-    auto it = entries.find(fPath);
-    if (it != entries.end()) {
-        totalBytes -= it->bytes;
-        lru.removeOne(fPath);
+        /* Replace any existing entry (e.g. re-decode of the same path). */
+        auto it = entries.find(fPath);
+        if (it != entries.end()) {
+            totalBytes -= it->bytes;
+            lru.removeOne(fPath);
+        }
+
+        Entry e;
+        e.work = work;
+        e.bytes = bytesOf(*work);
+        entries.insert(fPath, e);
+        lru.append(fPath);           // most-recently-used at the back
+        totalBytes += e.bytes;
     }
+    /* The previous MRU is now the tail: pack it before the budget is judged, or the
+       eviction would drop an image that fits at half size. */
+    demoteAndEvict();
+}
 
-    Entry e;
-    e.work = work;
-    e.bytes = bytesOf(*work);
-    entries.insert(fPath, e);
-    lru.append(fPath);           // most-recently-used at the back
-    totalBytes += e.bytes;
+std::shared_ptr<const WorkingImage> WorkingImageCache::get(const QString &fPath)
+{
+    std::shared_ptr<const WorkingImage> work;
+    std::shared_ptr<const HalfImage> half;
+    {
+        QMutexLocker lock(&mutex);
+        auto it = entries.constFind(fPath);
+        if (it == entries.constEnd()) return nullptr;
+        touchLocked(fPath);
+        work = it->work;
+        half = it->half;
+    }
+    if (!work) {
+        /* A packed entry becoming the MRU: unpack it outside the lock, then install the
+           float unless another get() got there first (use theirs) or the entry went. */
+        auto unpacked = std::make_shared<WorkingImage>();
+        UnpackImage(*half, *unpacked);
+        work = unpacked;
+        QMutexLocker lock(&mutex);
+        auto it = entries.find(fPath);
+        if (it != entries.end()) {
+            if (it->half == half) {
+                totalBytes -= it->bytes;
+                it->work = work;
+                it->half.reset();
+                it->bytes = bytesOf(*work);
+                totalBytes += it->bytes;
+            }
+            else if (it->work) {
+                work = it->work;
+            }
+        }
+    }
+    demoteAndEvict();
+    return work;
+}
 
-    evictLocked();
+void WorkingImageCache::setActive(const QString &fPath)
+{
+    {
+        QMutexLocker lock(&mutex);
+        if (activePath == fPath) return;
+        activePath = fPath;
+    }
+    /* The previous active image, unless it is also the MRU, is an ordinary entry now. */
+    demoteAndEvict();
 }
 
-std::shared_ptr<const WorkingImage> WorkingImageCache::get(const QString &fPath)
+QString WorkingImageCache::active() const
 {
     QMutexLocker lock(&mutex);
-    auto it = entries.constFind(fPath);
-    if (it == entries.constEnd()) return nullptr;
-    touchLocked(fPath);
-    return it->work;
+    return activePath;
+}
+
+void WorkingImageCache::setStorage(Storage s)
+{
+    {
+        QMutexLocker lock(&mutex);
+        store = s;
+    }
+    demoteAndEvict();
+}
+
+WorkingImageCache::Storage WorkingImageCache::storage() const
+{
+    QMutexLocker lock(&mutex);
+    return store;
 }
 
 bool WorkingImageCache::contains(const QString &fPath) const
@@ -130,13 +218,63 @@ void WorkingImageCache::touchLocked(const QString &fPath)
     lru.append(fPath);
 }
 
+bool WorkingImageCache::pinnedLocked(const QString &fPath) const
+{
+    return fPath == activePath || (!lru.isEmpty() && lru.last() == fPath);
+}
+
+void WorkingImageCache::demoteAndEvict()
+{
+    /* Collect under the lock, pack without it (tens of ms at full resolution, and the GUI
+       thread get()s), then swap each packed image in only if its entry still holds the
+       float we packed -- a put() or remove() in between wins. */
+    QVector<QPair<QString, std::shared_ptr<const WorkingImage>>> stale;
+    {
+        QMutexLocker lock(&mutex);
+        if (store == Storage::Half) {
+            for (int i = 0; i < lru.size(); ++i) {
+                if (pinnedLocked(lru.at(i))) continue;
+                auto it = entries.constFind(lru.at(i));
+                if (it != entries.constEnd() && it->work) stale.append({lru.at(i), it->work});
+            }
+        }
+        if (stale.isEmpty()) {
+            evictLocked();
+            return;
+        }
+    }
+    QVector<std::shared_ptr<const HalfImage>> packed;
+    packed.reserve(stale.size());
+    for (const auto &s : stale) {
+        auto half = std::make_shared<HalfImage>();
+        PackImage(*s.second, *half);
+        packed.append(half);
+    }
+    QMutexLocker lock(&mutex);
+    for (int i = 0; i < stale.size(); ++i) {
+        auto it = entries.find(stale[i].first);
+        if (it == entries.end() || it->work != stale[i].second) continue;
+        /* Re-promoted or made active while we packed: it is being worked on again. */
+        if (pinnedLocked(stale[i].first)) continue;
+        totalBytes -= it->bytes;
+        it->half = packed[i];
+        it->work.reset();
+        it->bytes = bytesOf(*it->half);
+        totalBytes += it->bytes;
+    }
+    evictLocked();
+}
+
 void WorkingImageCache::evictLocked()
 {
-    /* Trim from the least-recently-used front while over budget, but never evict the last
-       (most-recently-used) entry: the image being edited must stay resident even if it alone
-       exceeds the budget. */
-    while (totalBytes > budget && lru.size() > 1) {
-        const QString victim = lru.takeFirst();
+    /* Trim from the least-recently-used front while over budget, but never evict the
+       active entry or the last (most-recently-used) one: the image being edited must stay
+       resident even if it alone exceeds the budget. */
+    while (totalBytes > budget) {
+        int i = 0;
+        while (i + 1 < lru.size() && lru.at(i) == activePath) ++i;
+        if (i + 1 >= lru.size()) break;
+        const QString victim = lru.takeAt(i);
         auto it = entries.find(victim);
         if (it != entries.end()) {
             totalBytes -= it->bytes;
@@ -147,15 +285,14 @@ void WorkingImageCache::evictLocked()
 
 bool WorkingImageCache::render(const WorkingImage &work, const EditParams &edit, QImage &out,
                                RenderTimings *timings, OutDepth depth, Space space,
-                               WorkingImage *scratch)
+                               WorkingImage *scratch, PointPath point)
 {
     if (!work.isValid()) return false;
 
     OutputTransform output;
     /* One place decides the final quantisation and colour space, for both paths below. */
     auto toImage = [&output, depth, space](const WorkingImage &src, QImage &dst) {
-        return depth == OutDepth::Sixteen ? output.ToImage16(src, dst, space)
-                                          : output.ToImage(src, dst, space);
+        return toImageAt(output, src, dst, depth, space);
     };
 
     /* Identity edit: no Develop, no copy -- transform the cached image straight to
@@ -177,6 +314,7 @@ bool WorkingImageCache::render(const WorkingImage &work, const EditParams &edit,
     assignReusing(developed, work);
     if (timings) timings->copyMs = t.restart();
     Develop develop;
+    develop.setPointPath(point);
     Develop::StageTimings stage;
     develop.Apply(developed, edit, timings ? &stage : nullptr);
     if (timings) {
@@ -238,7 +376,7 @@ inline float maskDec(float y) { return y <= 0.0f ? 0.0f : std::pow(y, 2.2f); }
 bool WorkingImageCache::renderStack(const WorkingImage &work, const EditParams &base,
                                     const std::vector<StackScope> &scopes,
                                     QImage &out, RenderTimings *timings, OutDepth depth,
-                                    Space space, StackResume *resume)
+                                    Space space, StackResume *resume, PointPath point)
 {
     if (!work.isValid()) return false;
     const size_t n = size_t(work.width) * size_t(work.height);
@@ -246,6 +384,7 @@ bool WorkingImageCache::renderStack(const WorkingImage &work, const EditParams &
     QElapsedTimer t;
     if (timings) t.start();
     Develop develop;
+    develop.setPointPath(point);
 
     /* Sub-stage probe (diagnostic only; see RenderTimings). `sub` is restarted around
        each of the three kinds of work so a [DevTime] line can say whether a params drag
@@ -415,8 +554,7 @@ bool WorkingImageCache::renderStack(const WorkingImage &work, const EditParams &
     if (timings) timings->developMs = t.restart();
 
     OutputTransform output;
-    const bool ok = depth == OutDepth::Sixteen ? output.ToImage16(acc, out, space)
-                                               : output.ToImage(acc, out, space);
+    const bool ok = toImageAt(output, acc, out, depth, space);
     if (timings) timings->toImageMs = t.restart();
 
     /* Same reason: a locally-allocated accumulator is ~w*h*12 bytes and dies on return,
@@ -427,6 +565,65 @@ bool WorkingImageCache::renderStack(const WorkingImage &work, const EditParams &
     return ok;
 }
 
+bool WorkingImageCache::renderWindow(const WorkingImage &work, const EditParams &edit,
+                                     const QRect &rect, QImage &out, RenderTimings *timings,
+                                     OutDepth depth, Space space)
+{
+    if (!work.isValid() || work.frameW > 0) return false;
+    const QRect keep = rect & QRect(0, 0, work.width, work.height);
+    if (keep.isEmpty()) return false;
+
+    /* The window: keep grown by the ops' reach, clamped to the frame (where the frame's
+       own edge handling applies, exactly as in the full render). */
+    const int halo = Develop::halo(edit, work.width, work.height);
+    const int x0 = qMax(0, keep.left() - halo);
+    const int y0 = qMax(0, keep.top() - halo);
+    const int x1 = qMin(work.width, keep.left() + keep.width() + halo);
+    const int y1 = qMin(work.height, keep.top() + keep.height() + halo);
+
+    QElapsedTimer t;
+    if (timings) t.start();
+    WorkingImage win;
+    win.width = x1 - x0;
+    win.height = y1 - y0;
+    win.cam = work.cam;
+    win.white = work.white;
+    win.sceneReferred = work.sceneReferred;
+    win.renderScale = work.renderScale;
+    win.frameX = x0;
+    win.frameY = y0;
+    win.frameW = work.width;
+    win.frameH = work.height;
+    win.rgb.resize(static_cast<size_t>(win.width) * win.height * 3);
+    const size_t span = static_cast<size_t>(win.width) * 3;
+    for (int y = 0; y < win.height; ++y)
+        std::copy_n(work.rgb.data() + (static_cast<size_t>(y0 + y) * work.width + x0) * 3,
+                    span, win.rgb.data() + y * span);
+    if (timings) timings->copyMs = t.restart();
+
+    /* win is already a private copy, so Develop runs on it in place (render() would copy
+       it again). */
+    Develop develop;
+    Develop::StageTimings stage;
+    develop.Apply(win, edit, timings ? &stage : nullptr);
+    if (timings) {
+        timings->developMs = t.restart();
+        timings->denoiseMs = stage.denoiseMs;
+        timings->pointMs   = stage.pointMs;
+        timings->textureMs = stage.textureMs;
+        timings->dehazeMs  = stage.dehazeMs;
+        timings->vignetteMs = stage.vignetteMs;
+        timings->grainMs = stage.grainMs;
+    }
+    OutputTransform output;
+    QImage developed;
+    const bool ok = toImageAt(output, win, developed, depth, space);
+    if (!ok) return false;
+    out = developed.copy(keep.translated(-x0, -y0));
+    if (timings) timings->toImageMs = t.elapsed();
+    return !out.isNull();
+}
+
 WorkingImage WorkingImageCache::downscaled(const WorkingImage &src, int targetLongEdge)
 {
     if (!src.isValid() || targetLongEdge <= 0) return src;
@@ -7,10 +7,13 @@
 #include <QMutex>
 #include <memory>
 #include "Develop/workingimage.h"
+#include "Develop/halfimage.h"
 #include "Develop/editparams.h"
 #include "Develop/outputtransform.h"
+#include "Develop/develop.h"
 
 class QImage;
+class QRect;
 
 /*
     Caches the post-decode, PRE-develop WorkingImage (scene-linear float, see
@@ -36,6 +39,21 @@ class QImage;
     most-recently-used entry is never evicted, so a single image larger than the budget is
     still served (the active edit always hits).
 
+    ACTIVE entry. Decoder threads get() and put() other paths while an image is being
+    edited, so the MRU is not always the image Develop works on. MW names that one with
+    setActive(): it is never evicted or packed, whatever touched the cache last. With no
+    active path the MRU stands in for it.
+
+    HALF STORAGE (Storage::Half, the default). Only the active entry -- the image being
+    edited -- and the MRU are held as float. Every other entry is packed to binary16 (see
+    Develop/halfimage.h) when it stops being either, and unpacked again by the get() that
+    makes it the MRU, so the same budget holds about twice as many images and the active
+    edit reads float exactly as before. The pack and unpack run outside the mutex, band by
+    band across the global pool (tens of ms at 45 MP with F16C). A re-promoted image carries
+    the half rounding (within 2^-11 relative, under one 8-bit code after OutputTransform:
+    tst_halfimage); packing it again is lossless, so it never drifts further.
+    Storage::Float keeps every entry as float, which is what the cache always did.
+
     Threading: decoder threads put(); the GUI/editor thread get()s and render()s. All access
     is guarded by one mutex. render() is a free static that touches no cache state, so it can
     run on a WorkingImage the caller already holds.
@@ -57,6 +75,18 @@ public:
        most-recently-used. */
     std::shared_ptr<const WorkingImage> get(const QString &fPath);
 
+    /* The image being edited (see ACTIVE entry above), or empty when Develop has none.
+       Does not need an entry yet: a later put() or get() of fPath is pinned too. */
+    void setActive(const QString &fPath);
+    QString active() const;
+
+    /* How entries other than the active one and the MRU are held; see HALF STORAGE
+       above. Switching to Half packs the existing tail now; switching to Float leaves
+       packed entries packed until their next get(). */
+    enum class Storage { Float, Half };
+    void setStorage(Storage s);
+    Storage storage() const;
+
     bool contains(const QString &fPath) const;
     void remove(const QString &fPath);   // invalidate one entry (e.g. file changed on disk)
     void clear();                        // drop everything (new folder / new instance)
@@ -114,8 +144,9 @@ public:
     /* Output bit depth of the final OutputTransform. Eight (Format_RGB888) is the
        interactive/loupe path and the default everywhere. Sixteen (Format_RGBX64) is used
        only by the EXPORT path -- the develop pipeline is float throughout, so the pack to
-       8 bits is the sole place precision is lost. */
-    enum class OutDepth { Eight, Sixteen };
+       8 bits is the sole place precision is lost. Display is Eight packed as Format_RGB32,
+       for an image going into the image cache (ImageDecoder::applyDevelop). */
+    enum class OutDepth { Eight, Sixteen, Display };
 
     /* Output colour space of the final OutputTransform, defaulting to sRGB so every
        interactive caller is unaffected. Only the EXPORT path passes anything else; note
@@ -123,6 +154,12 @@ public:
        OutputTransform::ColorSpaceOf). */
     using Space = OutputTransform::Space;
 
+    /* How Develop evaluates the fused point pass (Develop::setPointPath). Direct, the
+       default, is exact; Lut interpolates a table baked once per render. Only the drag
+       ticks of the interactive preview pass Lut -- its settle render, export and the
+       reference builders stay Direct. */
+    using PointPath = Develop::PointPath;
+
     /* Render a WorkingImage through Develop + OutputTransform into out. Copies the image
        only when edit is non-identity (Develop mutates in place). Returns false if work is
        invalid or the output transform fails. Static and stateless: usable with a cached
@@ -138,7 +175,8 @@ public:
                        RenderTimings *timings = nullptr,
                        OutDepth depth = OutDepth::Eight,
                        Space space = Space::sRGB,
-                       WorkingImage *scratch = nullptr);
+                       WorkingImage *scratch = nullptr,
+                       PointPath point = PointPath::Direct);
 
     /* One scope of a stack composite: its develop params and a 0..1 mask (row-major
        width*height, matching work; null or empty => the scope applies globally).
@@ -244,7 +282,23 @@ public:
                             QImage &out, RenderTimings *timings = nullptr,
                             OutDepth depth = OutDepth::Eight,
                             Space space = Space::sRGB,
-                            StackResume *resume = nullptr);
+                            StackResume *resume = nullptr,
+                            PointPath point = PointPath::Direct);
+
+    /* VIEWPORT RENDER: Develop + OutputTransform for just rect of work (full-resolution
+       pixel coordinates, clipped to the frame) into out, rect-sized. What is developed is
+       a WINDOW -- rect grown by Develop::halo, clamped to the frame -- that carries the
+       frame it was cut from (WorkingImage::frameW), so every op sizes, places and
+       resamples itself as it would on the whole frame; the halo is then dropped. The
+       result matches that rect of the full render to float rounding (tst_renderwindow).
+       Copies the window, never the frame, so a 1:1 view of a 50 MP image costs a few
+       MP. work must be a whole frame. Fills *timings (copy, develop, toImage) when
+       non-null. */
+    static bool renderWindow(const WorkingImage &work, const EditParams &edit,
+                             const QRect &rect, QImage &out,
+                             RenderTimings *timings = nullptr,
+                             OutDepth depth = OutDepth::Eight,
+                             Space space = Space::sRGB);
 
     /* Area-downsampled copy of src whose longest edge is <= targetLongEdge (white /
        sceneReferred carried through). Used to build the interactive develop PROXY so a slider
@@ -253,26 +307,35 @@ public:
     static WorkingImage downscaled(const WorkingImage &src, int targetLongEdge);
 
     static qint64 bytesOf(const WorkingImage &work);
+    static qint64 bytesOf(const HalfImage &half);
 
 private:
     WorkingImageCache() = default;
     Q_DISABLE_COPY(WorkingImageCache)
 
+    /* Exactly one of work / half is set. */
     struct Entry {
         std::shared_ptr<const WorkingImage> work;
+        std::shared_ptr<const HalfImage> half;
         qint64 bytes = 0;
     };
 
     void evictLocked();                  // call with mutex held
     void touchLocked(const QString &fPath);
+    bool pinnedLocked(const QString &fPath) const;   // the active entry or the MRU
+    /* Pack every float entry but the pinned ones (Storage::Half), then evict to the
+       budget. Call WITHOUT the mutex: it drops it for the packing. */
+    void demoteAndEvict();
 
     static constexpr qint64 kDefaultMaxBytes = 768LL * 1024 * 1024;   // ~768 MB
 
     mutable QMutex mutex;
     QHash<QString, Entry> entries;
     QList<QString> lru;                  // front = least-recently-used, back = most-recent
+    QString activePath;                  // setActive(); empty = none
     qint64 totalBytes = 0;
     qint64 budget = kDefaultMaxBytes;
+    Storage store = Storage::Half;
     bool enabled = true;
 };
 
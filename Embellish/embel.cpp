@@ -601,7 +601,7 @@ void Embel::addImageToScene()
 
     // QHash<QString, QImage> imCache
     if (icd->contains(fPath)) {
-        pm = QPixmap::fromImage(icd->imCache.value(fPath)).scaledToWidth(image.w);
+        pm = QPixmap::fromImage(icd->value(fPath)).scaledToWidth(image.w);
     }
     else {
         pm = pmItem->pixmap().scaledToWidth(image.w);
@@ -850,7 +850,7 @@ void Embel::updateImage()       // all effects bundled in style
 
         // QHash<QString, QImage> imCache
         if (icd->contains(fPath)) {
-            pmItem->setPixmap(QPixmap::fromImage(icd->imCache.value(fPath)).scaledToWidth(image.w));
+            pmItem->setPixmap(QPixmap::fromImage(icd->value(fPath)).scaledToWidth(image.w));
         }
 
         GraphicsEffect *imageEffect = new GraphicsEffect(src);
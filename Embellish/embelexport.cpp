@@ -67,8 +67,9 @@ bool EmbelExport::loadImage(QString fPath)
     if (G::embelLog) G::log(srcFun, msg);
 
     if (!embellish->isRemote) {
-        if (icd->contains(fPath)) {
-            pmItem->setPixmap(QPixmap::fromImage(icd->imCache.value(fPath)));
+        // export needs real pixels: a reduced tier entry falls through to a decode
+        if (icd->contains(fPath) && !icd->isReduced(fPath)) {
+            pmItem->setPixmap(QPixmap::fromImage(icd->value(fPath)));
             return true;
         }
         // check metadata loaded for image
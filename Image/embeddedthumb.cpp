@@ -0,0 +1,182 @@
+#include "Image/embeddedthumb.h"
+#include "ImageFormats/Raw/tiffwalk.h"
+#include <QSet>
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+inline int be16(const uchar *p) { return (p[0] << 8) | p[1]; }
+
+struct Candidate {
+    quint32 offset;
+    quint32 length;
+    QSize size;
+};
+
+/* Offset of the TIFF header inside a JPEG's EXIF APP1 segment, 0 if there is none. The
+   APP segments come first, so stop at the first marker that is not one. */
+quint32 exifBase(const MappedFile &file)
+{
+    const uchar *p = file.at(0, 4);
+    if (!p || p[0] != 0xFF || p[1] != 0xD8) return 0;
+    qint64 i = 2;
+    for (int segments = 0; segments < 32; ++segments) {
+        const uchar *m = file.at(i, 4);
+        if (!m || m[0] != 0xFF) return 0;
+        const int marker = m[1];
+        if (marker < 0xE0 || marker > 0xEF) return 0;
+        const int len = be16(m + 2);
+        if (marker == 0xE1 && len >= 14) {
+            const uchar *id = file.at(i + 4, 6);
+            if (id && !memcmp(id, "Exif\0\0", 6)) return quint32(i + 10);
+        }
+        i += 2 + len;
+    }
+    return 0;
+}
+
+/* Nikon keeps its icon-sized preview (about 640 px) in the maker note's PreviewIFD; the
+   SubIFD preview of a recent body is full size. A type 3 maker note is "Nikon\0" and a
+   version, then a TIFF header its offsets are relative to. */
+template <typename Add>
+void addNikonPreview(const MappedFile &file, TiffWalk::Reader &tw, Add &add)
+{
+    TiffWalk::Ifd ifd0, exif, maker;
+    QList<quint32> subs;
+    quint32 next = 0;
+    if (!tw.readIfd(tw.firstIfd(), ifd0, subs, next) || !ifd0.contains(0x8769)) return;
+    if (!tw.readIfd(tw.ifdPointer(ifd0.value(0x8769)), exif, subs, next)) return;
+    if (!exif.contains(0x927C)) return;
+    const quint32 note = tw.base() + tw.ifdPointer(exif.value(0x927C));
+    const uchar *id = file.at(note, 10);
+    if (!id || memcmp(id, "Nikon\0", 6)) return;
+    TiffWalk::Reader mn;
+    if (!mn.init(&file, note + 10)) return;
+    if (!mn.readIfd(mn.firstIfd(), maker, subs, next) || !maker.contains(0x0011)) return;
+    TiffWalk::Ifd preview;
+    if (!mn.readIfd(mn.scalar(maker.value(0x0011)), preview, subs, next)) return;
+    if (preview.contains(0x0201) && preview.contains(0x0202))
+        add(mn.base(), mn.scalar(preview.value(0x0201)), mn.scalar(preview.value(0x0202)));
+}
+
+}
+
+bool EmbeddedThumb::supports(const QString &ext)
+{
+    static const QSet<QString> exts {"arw", "cr2", "dng", "nef", "nrw", "sr2", "jpg", "jpeg"};
+    return exts.contains(ext);
+}
+
+QSize EmbeddedThumb::jpegSize(const uchar *p, qint64 len)
+{
+    if (!p || len < 4 || p[0] != 0xFF || p[1] != 0xD8) return QSize();
+    qint64 i = 2;
+    while (i + 4 <= len) {
+        if (p[i] != 0xFF) return QSize();
+        const int marker = p[i + 1];
+        if (marker == 0xFF) { ++i; continue; }                          // fill byte
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) { i += 2; continue; }
+        if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2) {
+            if (i + 9 > len) return QSize();
+            const QSize s(be16(p + i + 7), be16(p + i + 5));
+            return s.isEmpty() ? QSize() : s;
+        }
+        // other frame types (lossless, hierarchical, arithmetic), scan or end first
+        if ((marker >= 0xC3 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8
+             && marker != 0xCC) || marker == 0xDA || marker == 0xD9)
+            return QSize();
+        i += 2 + be16(p + i + 2);
+    }
+    return QSize();
+}
+
+bool EmbeddedThumb::locate(const MappedFile &file, const QString &ext, int minLongSide,
+                           Location &loc)
+{
+    if (!file.isValid() || !supports(ext)) return false;
+    const bool isJpeg = ext == "jpg" || ext == "jpeg";
+
+    TiffWalk::Reader tw;
+    const quint32 base = isJpeg ? exifBase(file) : 0;
+    const bool hasTiff = (!isJpeg || base) && tw.init(&file, base);
+    if (!isJpeg && !hasTiff) return false;
+
+    QVector<Candidate> found;
+    // a JPEG at off, relative to the TIFF header at from
+    auto add = [&](quint32 from, quint32 off, quint32 len) {
+        if (!off) return;
+        const qint64 at = qint64(from) + off;
+        const uchar *p = file.at(at, len);
+        if (!p) return;
+        // the SOF is in the first few KB; do not touch the rest of a large preview
+        const QSize s = jpegSize(p, qMin<qint64>(len, 65536));
+        if (s.isValid()) found.append({quint32(at), len, s});
+    };
+
+    loc.orientation = 1;
+    if (hasTiff) {
+        /* IFD0 and the IFDs chained after it, and their SubIFDs (a level deeper for the
+           DNGs that nest them). The visited set stops a corrupt file's offset loop. */
+        QList<quint32> queue {tw.firstIfd()};
+        QList<int> depth {0};
+        QSet<quint32> seen {tw.firstIfd()};
+        int chained = 1;
+        for (int k = 0; k < queue.size() && k < 32; ++k) {
+            TiffWalk::Ifd tags;
+            QList<quint32> subs;
+            quint32 next = 0;
+            if (!tw.readIfd(queue.at(k), tags, subs, next)) continue;
+            if (k == 0 && tags.contains(0x0112)) {
+                const int o = int(tw.scalar(tags.value(0x0112)));
+                if (o >= 1 && o <= 8) loc.orientation = o;
+            }
+            if (depth.at(k) == 0 && next && chained < 8 && !seen.contains(next)) {
+                seen.insert(next);
+                queue << next;
+                depth << 0;
+                ++chained;
+            }
+            if (depth.at(k) < 2) {
+                for (quint32 sub : subs) {
+                    if (!sub || seen.contains(sub)) continue;
+                    seen.insert(sub);
+                    queue << sub;
+                    depth << depth.at(k) + 1;
+                }
+            }
+            // JPEGInterchangeFormat / Length
+            if (tags.contains(0x0201) && tags.contains(0x0202)) {
+                add(base, tw.scalar(tags.value(0x0201)), tw.scalar(tags.value(0x0202)));
+                continue;
+            }
+            // a JPEG compressed image in one strip (CR2 IFD0, DNG previews)
+            const quint32 compression = tags.contains(0x0103) ? tw.scalar(tags.value(0x0103)) : 1;
+            if ((compression == 6 || compression == 7) && tags.contains(0x0111)
+                && tags.contains(0x0117) && tags.value(0x0111).count == 1)
+                add(base, tw.scalar(tags.value(0x0111)), tw.scalar(tags.value(0x0117)));
+        }
+        if (ext == "nef" || ext == "nrw") addNikonPreview(file, tw, add);
+    }
+    if (isJpeg && found.isEmpty()) {
+        // no EXIF thumbnail: the file is the preview
+        const QSize s = jpegSize(file.data(), qMin<qint64>(file.size(), 1 << 20));
+        if (!s.isValid() || file.size() > 0xFFFFFFFFLL) return false;
+        found.append({0, quint32(file.size()), s});
+    }
+    if (found.isEmpty()) return false;
+
+    auto longSide = [](const Candidate &c) { return qMax(c.size.width(), c.size.height()); };
+    const Candidate *fit = nullptr, *under = nullptr, *least = nullptr;
+    for (const Candidate &c : found) {
+        const int ls = longSide(c);
+        if (ls >= minLongSide && ls <= 8 * minLongSide && (!fit || ls < longSide(*fit))) fit = &c;
+        if (ls < minLongSide && (!under || ls > longSide(*under))) under = &c;
+        if (!least || ls < longSide(*least)) least = &c;
+    }
+    const Candidate *pick = fit ? fit : under ? under : least;
+    loc.offset = pick->offset;
+    loc.length = pick->length;
+    loc.size = pick->size;
+    return true;
+}
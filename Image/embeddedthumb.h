@@ -0,0 +1,56 @@
+#ifndef EMBEDDEDTHUMB_H
+#define EMBEDDEDTHUMB_H
+
+#include <QSize>
+#include <QString>
+#include "ImageFormats/Raw/mappedfile.h"
+
+/*
+    Finds the embedded JPEG preview of a file without the Metadata parse.
+
+    Reader::read used to run the whole Metadata::loadImageMetadata parse (every IFD, EXIF,
+    the maker notes, XMP, IPTC, ICC) before Thumb::loadThumb reopened the file for the
+    embedded JPEG, so no icon of a card dump showed until its file had been fully parsed.
+    locate() is the minimal walk that the icon needs: the TIFF header, the IFD0 chain and
+    its SubIFDs (TiffWalk::Reader over a MappedFile) for the JPEG previews they point to
+    and the Orientation tag, plus Nikon's maker-note PreviewIFD -- for a JPEG the same walk
+    inside its EXIF APP1 segment. The size of each preview comes from its SOF marker, so
+    the one that best fits the icon is chosen without decoding anything.
+    Reader::readIconFirst decodes it (DCT scaled) and shows the icon; the full parse
+    follows and fills the rest of ImageMetadata.
+
+    Formats whose previews live elsewhere (CR3 and RAF containers, ORF and RW2 maker
+    notes) and TIFFs (whose thumbnails are not JPEG) are not supported; they keep the
+    metadata-then-icon order.
+*/
+class EmbeddedThumb
+{
+public:
+    struct Location {
+        quint32 offset = 0;     // the JPEG, from the start of the file
+        quint32 length = 0;
+        QSize size;             // from its SOF marker
+        int orientation = 1;    // EXIF Orientation of the image
+    };
+
+    /* True for the extensions locate() understands. */
+    static bool supports(const QString &ext);
+
+    /* The embedded JPEG to decode for an icon minLongSide on its long side:
+
+           the smallest preview at least minLongSide and at most 8x that (a 1/8 DCT-scaled
+           decode still covers the icon), else
+           the largest one smaller than minLongSide (the thumbnail the metadata parsers
+           pick, e.g. a 160 x 120 EXIF thumbnail), else
+           the smallest one.
+
+       A JPEG with no EXIF thumbnail is its own preview. False when nothing is found. */
+    static bool locate(const MappedFile &file, const QString &ext, int minLongSide,
+                       Location &loc);
+
+    /* Frame size of a baseline or progressive JPEG; invalid for anything else (lossless
+       JPEG raw data, truncated or not a JPEG). Only the first len bytes are read. */
+    static QSize jpegSize(const uchar *p, qint64 len);
+};
+
+#endif // EMBEDDEDTHUMB_H
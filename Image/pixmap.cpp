@@ -325,10 +325,12 @@ void Pixmap::applyOrientation(QImage &image, int orientation, int rotationDegree
     }
 }
 
-bool Pixmap::loadFromJpgData(QString &fPath, QImage &image, uint offset, uint length)
+bool Pixmap::loadFromJpgData(QString &fPath, QImage &image, uint offset, uint length,
+                             int longSide)
 {
 /*
-    Read an embedded JPG (known offset and length) and decode it into a QImage.
+    Read an embedded JPG (known offset and length) and decode it into a QImage. With
+    longSide > 0 the decode may stop at a DCT scale whose long side still covers it.
 */
     QString fun = "Pixmap::loadFromJpgData";
     if (G::isLogger) G::log(fun, fPath);
@@ -342,7 +344,12 @@ bool Pixmap::loadFromJpgData(QString &fPath, QImage &image, uint offset, uint le
         bool success = false;
         if (imFile.seek(offset)) {
             QByteArray buf = imFile.read(length);
-            success = image.loadFromData(buf, "JPEG");
+            #ifdef Q_OS_MAC
+            JpegTurbo jpegTurbo;
+            image = jpegTurbo.decode(buf, longSide);
+            success = !image.isNull();
+            #endif
+            if (!success) success = image.loadFromData(buf, "JPEG");
         }
         imFile.close();
         return success;
@@ -445,7 +452,7 @@ bool Pixmap::loadIndependent(QString &fPath, QImage &image, int longSide, QStrin
 
     // raw image file or tiff with embedded jpg
     if (isEmbeddedJpg) {
-        success = loadFromJpgData(fPath, image, offsetThumb, lengthThumb);
+        success = loadFromJpgData(fPath, image, offsetThumb, lengthThumb, longSide);
     }
     // the image type might not have metadata we can read, so load entire image
     else if (!metadata->hasMetadataFormats.contains(ext)) {
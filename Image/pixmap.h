@@ -48,7 +48,8 @@ private:
     bool loadFromHeic(QString &fPath, QImage &image);
 
     // helpers for loadIndependent (decode files not in the datamodel)
-    bool loadFromJpgData(QString &fPath, QImage &image, uint offset, uint length);
+    bool loadFromJpgData(QString &fPath, QImage &image, uint offset, uint length,
+                         int longSide = 0);
     bool loadFromTiff(QString &fPath, QImage &image, ImageMetadata *m);
     bool loadFromEntireFile(QString &fPath, QImage &image);
     void applyOrientation(QImage &image, int orientation, int rotationDegrees);
@@ -81,8 +81,8 @@ QString Stack::mean()
     for (int i = 0; i < n; ++i) {
         if (abort) break;
         QString fPath = selection.at(i);
-        if (icd->contains(fPath)) {
-            image = icd->imCache.value(fPath);
+        if (icd->contains(fPath) && !icd->isReduced(fPath)) {
+            image = icd->value(fPath);
         }
         else {
             pix->load(fPath, image, "Stack::doMean");
@@ -108,7 +108,8 @@ QString Stack::mean()
         }
         // load image to vector s
         for (int y = 0; y < h; ++y) {
-            memcpy(&s[y][0], image.scanLine(y), static_cast<size_t>(image.bytesPerLine()));
+            // constScanLine: scanLine() would detach (deep copy) the cached image
+            memcpy(&s[y][0], image.constScanLine(y), static_cast<size_t>(image.bytesPerLine()));
         }
 
         // increment mean vector by s/n
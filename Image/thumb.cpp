@@ -1,4 +1,5 @@
 #include "Image/thumb.h"
+#include "Image/embeddedthumb.h"
 #include "Main/global.h"
 
 #ifdef Q_OS_MAC
@@ -237,7 +238,13 @@ Thumb::Status Thumb::loadFromJpgData(QString &fPath, QImage &image)
         if (!abort) {
             if (imFile.seek(offsetThumb)) {
                 QByteArray buf = imFile.read(lengthThumb);
-                success =  image.loadFromData(buf, "JPEG");
+                #ifdef Q_OS_MAC
+                /* DCT-scaled decode: the thumb only needs to cover the icon size. */
+                JpegTurbo jpegTurbo;
+                image = jpegTurbo.decode(buf, G::maxIconSize);
+                success = !image.isNull();
+                #endif
+                if (!success) success = image.loadFromData(buf, "JPEG");
                 /* Embedded thumb is JPEG for all current formats; fall back to
                    Qt format auto-detection (content sniffing) in case a format
                    stores a non-JPEG thumb. */
@@ -609,6 +616,75 @@ bool Thumb::loadThumb(QString &fPath, int dmRow , QImage &image, int instance,
     else return false;
 }
 
+bool Thumb::loadThumbFirst(QString &fPath, int dmRow, QImage &image, int instance)
+{
+/*
+    The thumbnail-first path of Reader::read: the icon from the embedded JPEG that
+    EmbeddedThumb::locate finds with a minimal IFD walk, before the metadata has been
+    read, so m is not used. The JPEG is decoded DCT scaled to about the icon size, then
+    scaled, converted and rotated as loadThumb does.
+
+    Returns false, having emitted nothing, when the format is not supported or no
+    preview is found or decodes; Reader then falls back to loadThumb after the
+    metadata.
+*/
+    QString fun = "Thumb::loadThumbFirst";
+    if (G::isLogger) G::log(fun, fPath);
+    if (isDebug)
+        qDebug().noquote()
+            << fun.leftJustified(col0Width)
+            << "row =" << dmRow << fPath;
+
+    const QString ext = QFileInfo(fPath).suffix().toLower();
+    if (!EmbeddedThumb::supports(ext)) return false;
+    if (G::instanceClash(instance, "Thumb::loadThumbFirst")) return false;
+
+    setBusy();
+    abort = false;
+    this->dmRow = dmRow;
+    this->instance = instance;
+
+    bool ok = false;
+    {
+        QFile imFile(fPath);
+        MappedFile file(imFile);
+        EmbeddedThumb::Location loc;
+        if (!abort && EmbeddedThumb::locate(file, ext, G::maxIconSize, loc)) {
+            const uchar *jpg = file.at(loc.offset, loc.length);
+            /* fromRawData: no copy of the preview, which is only read while the file
+               is mapped */
+            QByteArray buf = QByteArray::fromRawData(reinterpret_cast<const char *>(jpg),
+                                                     int(loc.length));
+            #ifdef Q_OS_MAC
+            JpegTurbo jpegTurbo;
+            image = jpegTurbo.decode(buf, G::maxIconSize);
+            ok = !image.isNull();
+            #endif
+            if (!ok && !abort) {
+                QBuffer device(&buf);
+                device.open(QIODevice::ReadOnly);
+                QImageReader reader(&device, "jpeg");
+                reader.setAutoTransform(false);
+                // a scaled size lets libjpeg run the IDCT at 1/2, 1/4 or 1/8
+                if (loc.size.width() > thumbMax.width() || loc.size.height() > thumbMax.height())
+                    reader.setScaledSize(loc.size.scaled(thumbMax, Qt::KeepAspectRatio));
+                ok = reader.read(&image) && !image.isNull();
+            }
+            if (ok) {
+                image = image.scaled(thumbMax, Qt::KeepAspectRatio);
+                image.convertTo(QImage::Format_RGB32);
+                /* rotationDegrees is always 0 until the metadata has been read
+                   (Metadata::loadImageMetadata) */
+                if (metadata->rotateFormats.contains(ext))
+                    checkOrientation(image, loc.orientation, 0);
+            }
+        }
+    }
+
+    setIdle();
+    return ok && !abort;
+}
+
 void Thumb::insertThumbnailsInJpg(QModelIndexList &selection)
 {
 /*
@@ -18,6 +18,7 @@ public:
     void abortProcessing();
     bool loadThumb(QString &fPath, int dmRow, QImage &image,
                    int instance, const ImageMetadata &m, QString src);
+    bool loadThumbFirst(QString &fPath, int dmRow, QImage &image, int instance);
     void presetOffset(uint offset, uint length);
     void insertThumbnailsInJpg(QModelIndexList &selection);
     bool insertingThumbnails = false;
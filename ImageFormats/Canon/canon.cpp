@@ -4,6 +4,7 @@
 #include "ImageFormats/Raw/losslessjpeg.h"
 #include "ImageFormats/Raw/rawimage.h"
 #include "ImageFormats/Raw/cameramatrix.h"
+#include <algorithm>
 
 Canon::Canon()
 {
@@ -331,7 +332,7 @@ bool Canon::parse(MetadataParameters &p,
    CanonRaw::UnpackCfa  --  Canon CR2 sensor unpack (lossless JPEG + slices + crop)
    ------------------------------------------------------------------------------------------ */
 
-bool CanonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool CanonRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
     Q_UNUSED(m)
     using namespace TiffWalk;
@@ -363,47 +364,75 @@ bool CanonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     }
     if (!haveRaw) { errMsg = "CR2: no raw IFD (slice tag absent)."; return false; }
 
-    /* Decode the lossless-JPEG raw. */
-    if (!file.seek(r.scalar(rawIfd[273]))) { errMsg = "CR2: seek to raw failed."; return false; }
-    const QByteArray buf = file.read(int(r.scalar(rawIfd[279])));
-    LosslessJpeg::Image im;
-    QString lerr;
-    if (!LosslessJpeg::Decode(reinterpret_cast<const uint8_t *>(buf.constData()),
-                              size_t(buf.size()), im, &lerr)) {
-        errMsg = "CR2: lossless JPEG decode failed (" + lerr + ")."; return false;
-    }
-    const int clrs = im.components;
-    const int jwide = im.width * clrs;
-    const int H = im.height;
-
-    /* Canon vertical slices (tag 0xC640 = [nFullSlices, sliceWidth, lastSliceWidth]). Map the
-       component-interleaved JPEG raster back to sensor (row,col). dcraw's reassembly. */
+    /* Canon vertical slices (tag 0xC640 = [nFullSlices, sliceWidth, lastSliceWidth]). */
     const QVector<quint32> sl = r.u32s(rawIfd[0xC640]);
     const int s0 = sl.size() > 0 ? int(sl[0]) : 0;
     const int s1 = sl.size() > 1 ? int(sl[1]) : 0;
     const int s2 = sl.size() > 2 ? int(sl[2]) : 0;
-    const int W = s0 ? s0 * s1 + s2 : jwide;
-    if (W <= 0 || H <= 0) { errMsg = "CR2: bad raw dimensions."; return false; }
 
-    std::vector<uint16_t> full(size_t(W) * H, 0);
-    const size_t total = size_t(jwide) * H;
-    const size_t slcw = size_t(s1) * H;
-    for (size_t jidx = 0; jidx < total && jidx < im.samples.size(); ++jidx) {
-        int row, col;
-        if (s0 && slcw) {
-            size_t i = jidx / slcw;
-            const int j = (i >= size_t(s0)) ? 1 : 0;
-            if (j) i = size_t(s0);
-            const size_t k = jidx - i * slcw;
-            const int wsl = j ? s2 : s1;
-            row = int(k / wsl);
-            col = int(k % wsl) + int(i) * s1;
-        } else {
-            row = int(jidx / jwide);
-            col = int(jidx % jwide);
+    /*
+        Decode the lossless-JPEG raw straight out of the mapped file. Unlike DNG tiles
+        the slices are not separate bitstreams -- a CR2 is ONE scan with no restart markers,
+        so it decodes sequentially -- but each decoded line is un-sliced as it arrives, so no
+        full-size copy of the JPEG raster is made. The JPEG raster is the slices laid end to
+        end: jidx runs down slice 0 row by row, then slice 1, ... (dcraw's reassembly); a line
+        maps to a few runs of consecutive sensor columns.
+    */
+    const quint32 rawOff = r.scalar(rawIfd[273]);
+    const qint64 rawLen = qMin<qint64>(r.scalar(rawIfd[279]), file.available(rawOff));
+    if (rawLen <= 0) { errMsg = "CR2: seek to raw failed."; return false; }
+    file.willNeed(rawOff, rawLen);
+    const uint8_t *jpeg = file.at(rawOff, rawLen);
+    const size_t jpegLen = size_t(rawLen);
+
+    std::vector<uint16_t> full;
+    int W = 0, H = 0;
+    size_t slcw = 0;
+    auto unslice = [&](int y, const uint16_t *line, int jwide) {
+        if (y == 0) {
+            /* First line: the frame size is known now. */
+            W = s0 ? s0 * s1 + s2 : jwide;
+            full.assign(size_t(qMax(W, 0)) * size_t(H), 0);
+            slcw = size_t(s1) * H;
         }
-        if (row < H && col < W) full[size_t(row) * W + col] = im.samples[jidx];
+        if (W <= 0) return;
+        size_t jidx = size_t(y) * jwide;
+        for (int i = 0; i < jwide; ) {
+            int row, col, run;
+            if (s0 && slcw) {
+                size_t sIdx = jidx / slcw;
+                const int j = (sIdx >= size_t(s0)) ? 1 : 0;
+                if (j) sIdx = size_t(s0);
+                const size_t k = jidx - sIdx * slcw;
+                const int wsl = j ? s2 : s1;
+                if (wsl <= 0) return;
+                row = int(k / wsl);
+                col = int(k % wsl) + int(sIdx) * s1;
+                run = wsl - int(k % wsl);
+            } else {
+                row = y;
+                col = i;
+                run = jwide;
+            }
+            run = qMin(run, jwide - i);
+            if (row < H && col < W) {
+                const int n = qMin(run, W - col);
+                std::copy(line + i, line + i + n, full.begin() + (size_t(row) * W + col));
+            }
+            i += run;
+            jidx += size_t(run);
+        }
+    };
+
+    LosslessJpeg::Image im;         // frame only: the lines arrive through unslice
+    QString lerr;
+    bool ok = LosslessJpeg::ReadFrame(jpeg, jpegLen, im, &lerr);
+    if (ok) {
+        H = im.height;
+        ok = LosslessJpeg::DecodeRows(jpeg, jpegLen, unslice, &lerr);
     }
+    if (!ok) { errMsg = "CR2: lossless JPEG decode failed (" + lerr + ")."; return false; }
+    if (W <= 0 || H <= 0) { errMsg = "CR2: bad raw dimensions."; return false; }
 
     /* Canon makernote: IFD0 -> ExifIFD (0x8769) -> MakerNote (0x927C). Read SensorInfo (0xE0)
        for the active-area crop and ColorData (0x4001) for the as-shot white balance. */
@@ -41,7 +41,7 @@ private:
 class CanonRaw : public RawFormat
 {
 protected:
-    bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) override;
+    bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) override;
 };
 
 /*
@@ -56,7 +56,7 @@ protected:
 class CanonCR3Raw : public RawFormat
 {
 protected:
-    bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) override;
+    bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) override;
 };
 
 #endif // CANON_H
@@ -8,22 +8,30 @@
 
     Pipeline for CR3:
       1. Walk the ISO-BMFF box tree, pick the full-resolution CRAW track, read its CMP1
-         geometry, IAD1 active-area crop, and the CRX bitstream location (stbl co64 + stsz).
-      2. Decode the CRX entropy stream: the tile's 4 Bayer planes share ONE continuous
-         bitstream (do NOT re-seek per plane) -- adaptive Golomb-Rice + MED prediction + T.87
-         run mode, with the non-top-line K adapted from a look-ahead-adjusted code.
+         geometry (frame, tile, bits, planes), IAD1 active-area crop, and the CRX bitstream
+         location (stbl co64 + stsz).
+      2. Read the CRX headers at the start of the sample: one 0xff01 per tile (its data size)
+         and a 0xff02/0xff03 pair per plane. Tiles are separate bitstreams and decode in
+         parallel on the global thread pool. Within a tile the 4 Bayer planes share ONE
+         continuous bitstream (do NOT re-seek per plane) -- adaptive Golomb-Rice + MED
+         prediction + T.87 run mode, with the non-top-line K adapted from a look-ahead-adjusted
+         code.
       3. Interleave the 4 planes row-major into the RGGB mosaic, crop to the active area.
       4. Self-calibrate per-channel black from the masked border; white/matrix/WB from the
          bit depth, the per-model table, and the CMT3 makernote ColorData.
 
-    Only level-0 (no wavelet) single-tile CRAW is handled -- true for current full-frame
-    bodies. Anything else returns false and the caller falls back to the embedded preview.
+    Only level-0 (no wavelet) CRAW is handled, single- or multi-tile. Anything else returns
+    false and the caller falls back to the embedded preview.
 */
 
 #include "ImageFormats/Canon/canon.h"
 #include "ImageFormats/Raw/cameramatrix.h"
 #include "ImageFormats/Raw/tiffwalk.h"
+#include <QtConcurrent>
+#include <QThreadPool>
 
+#include <atomic>
+#include <bit>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -33,7 +41,13 @@
 namespace {
 
 /* ---- little BMFF helpers (big-endian) ------------------------------------------------- */
-using Bytes = std::vector<uint8_t>;
+/* The file as RawFormat::Decode mapped it: a read-only view, never copied. */
+struct Bytes {
+    const uint8_t *p = nullptr;
+    size_t n = 0;
+    size_t size() const { return n; }
+    const uint8_t &operator[](size_t i) const { return p[i]; }
+};
 inline uint16_t u16(const uint8_t *b) { return (uint16_t(b[0]) << 8) | b[1]; }
 inline uint32_t u32(const uint8_t *b) {
     return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | b[3];
@@ -69,10 +83,21 @@ struct BitReader {
     uint32_t getBits(int n) {
         if (n == 0) return 0;
         if (nbits < n) fill();
-        if (nbits < n) { uint32_t v = (uint32_t)(cache & ((1ull << nbits) - 1)); nbits = 0; return v; }
+        if (nbits < n) { uint32_t v = (uint32_t)(cache & ((1ull << nbits) - 1)); nbits = 0; eof = true; return v; }
         nbits -= n; return (uint32_t)((cache >> nbits) & ((1ull << n) - 1));
     }
-    uint32_t zeros() { uint32_t z = 0; while (getBit() == 0) { if (eof) return CRX_ESC; z++; } return z; }
+    /* Zero bits before the next 1 (consumed), counted a cache word at a time -- the Golomb
+       prefix is most of the bits read. */
+    uint32_t zeros() {
+        uint32_t z = 0;
+        for (;;) {
+            if (nbits < 1) fill();
+            if (nbits < 1) { eof = true; return CRX_ESC; }
+            const uint64_t top = cache << (64 - nbits);       // unread bits, MSB first
+            if (top) { const int lz = std::countl_zero(top); nbits -= lz + 1; return z + uint32_t(lz); }
+            z += uint32_t(nbits); nbits = 0;
+        }
+    }
 };
 
 /* Adaptive Golomb-Rice K predictor (identical for top-line adapt and the non-top update). */
@@ -129,7 +154,7 @@ struct Band {
             if (J[s_param] > 0) n += br.getBits((int)J[s_param]);
             if (s_param > 0) s_param--;
         }
-        return n;
+        return std::min(n, remaining);                  // a corrupt count must not run off the line
     }
     void topLine() {
         pos = 1; int64_t rem = w; buf1[0] = 0;
@@ -202,7 +227,7 @@ void parseCraw(const Bytes &d, size_t seBody, size_t seEnd, CrxLoc &c) {
             const int l = u16(&d[p + 16]), t = u16(&d[p + 18]);
             const int r = u16(&d[p + 20]), bo = u16(&d[p + 22]);
             /* Keep only the full-raw IAD1 (its full dims match CMP1), and a sane crop. */
-            if ((uint32_t)fw == c.tileW && (uint32_t)fh == c.tileH &&
+            if ((uint32_t)fw == c.fW && (uint32_t)fh == c.fH &&
                 l >= 0 && t >= 0 && r > l && bo > t && r <= fw && bo <= fh) {
                 c.cropL = l; c.cropT = t; c.cropR = r; c.cropB = bo;
             }
@@ -233,28 +258,67 @@ void parseTrak(const Bytes &d, size_t body, size_t end, CrxLoc &loc) {
             });
         });
     });
-    if (isCraw && t.fW && t.tileW == t.fW && t.tileH == t.fH) {   // single-tile full-raw only
+    if (isCraw && t.fW && t.fH && t.tileW && t.tileH && t.tileW <= t.fW && t.tileH <= t.fH) {
         if (!loc.ok || uint64_t(t.fW) * t.fH > uint64_t(loc.fW) * loc.fH) {
             t.mdatOff = mdat; t.streamLen = slen; t.ok = true; loc = t;
         }
     }
 }
 
-/* CRX header bytes (TLV markers 0xff01/02/03), and validate level 0 (1 subband/plane). */
-bool crxHeaderInfo(const Bytes &d, uint64_t off, uint64_t len, size_t &headerBytes, int &nPlanes) {
-    size_t o = (size_t)off, end = o + (size_t)len;
+/* One tile of the CRX frame, in plane coordinates (half the mosaic), and the bytes of its
+   bitstream. */
+struct CrxTile {
+    int x0 = 0, y0 = 0, w = 0, h = 0;
+    uint64_t off = 0, len = 0;
+};
+
+/*
+    Read the CRX headers at the start of the sample and lay out the tiles. The headers are
+    TLVs (u16 marker, u16 length): per tile an 0xff01 whose u32 at +4 is the tile's data size,
+    then per plane an 0xff02 and its subbands (0xff03) -- exactly one at level 0. The tile data
+    follows the headers, tile after tile in row-major order. Within a tile the four planes are
+    one continuous bitstream (see Band), so a tile is the unit that can be decoded alone.
+*/
+bool crxReadTiles(const Bytes &d, const CrxLoc &loc, std::vector<CrxTile> &tiles, QString &err) {
+    const int pw = int(loc.fW / 2), ph = int(loc.fH / 2);
+    const int tw = int(loc.tileW / 2), th = int(loc.tileH / 2);
+    if (pw <= 0 || ph <= 0 || tw <= 0 || th <= 0) { err = "CR3: bad plane geometry."; return false; }
+    const int cols = (pw + tw - 1) / tw, rows = (ph + th - 1) / th;
+
+    const uint64_t end = loc.mdatOff + loc.streamLen;
+    uint64_t o = loc.mdatOff;
+    std::vector<uint32_t> tileSize;
     int planes = 0, sb = 0;
     while (o + 4 <= end) {
-        uint16_t t = u16(&d[o]);
+        const uint16_t t = u16(&d[o]), l = u16(&d[o + 2]);
         if (t < 0xff01 || t > 0xff04) break;
-        uint16_t l = u16(&d[o + 2]);
-        if (t == 0xff02) planes++;
+        if (t == 0xff01) {
+            if (l < 8 || o + 8 > end) break;
+            tileSize.push_back(u32(&d[o + 4]));
+        }
+        else if (t == 0xff02) planes++;
         else if (t == 0xff03) sb++;
         o += 4 + l;
     }
-    headerBytes = o - (size_t)off;
-    nPlanes = planes;
-    return planes > 0 && sb == planes;    // 1 subband/plane => levels == 0
+    /* 1 subband per plane => levels == 0. */
+    if (tileSize.size() != size_t(cols) * rows || planes != 4 * int(tileSize.size()) || sb != planes) {
+        err = "CR3: unsupported CRX (levels>0, plane or tile count)."; return false;
+    }
+
+    tiles.assign(tileSize.size(), CrxTile());
+    uint64_t data = o;
+    for (size_t ti = 0; ti < tiles.size(); ++ti) {
+        CrxTile &t = tiles[ti];
+        const int tc = int(ti % cols), tr = int(ti / cols);
+        t.x0 = tc * tw; t.y0 = tr * th;
+        t.w = std::min(tw, pw - t.x0); t.h = std::min(th, ph - t.y0);
+        t.off = data;
+        /* The last tile reads to the end of the sample, as a single-tile frame always has. */
+        t.len = (ti + 1 < tiles.size()) ? tileSize[ti] : end - data;
+        if (data > end || t.len > end - data) { err = "CR3: CRX tile data runs past the sample."; return false; }
+        data += tileSize[ti];
+    }
+    return true;
 }
 
 } // namespace
@@ -262,14 +326,10 @@ bool crxHeaderInfo(const Bytes &d, uint64_t off, uint64_t len, size_t &headerByt
 /* ------------------------------------------------------------------------------------------
    CanonCR3Raw::UnpackCfa  --  CR3 CRX sensor unpack (container -> planes -> RGGB mosaic)
    ------------------------------------------------------------------------------------------ */
-bool CanonCR3Raw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool CanonCR3Raw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
-    if (!file.isOpen() && !file.open(QIODevice::ReadOnly)) { errMsg = "CR3: cannot open file."; return false; }
-    if (!file.seek(0)) { errMsg = "CR3: seek failed."; return false; }
-    const QByteArray all = file.readAll();
-    if (all.size() < 16) { errMsg = "CR3: file too small."; return false; }
-    Bytes d(reinterpret_cast<const uint8_t *>(all.constData()),
-            reinterpret_cast<const uint8_t *>(all.constData()) + all.size());
+    if (file.size() < 16) { errMsg = "CR3: file too small."; return false; }
+    const Bytes d{file.data(), size_t(file.size())};
 
     if (!tagEq(&d[4], "ftyp")) { errMsg = "CR3: not an ISO-BMFF file."; return false; }
 
@@ -280,43 +340,67 @@ bool CanonCR3Raw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
             if (!std::memcmp(ty2, "trak", 4)) parseTrak(d, tb, te, loc);
         });
     });
-    if (!loc.ok) { errMsg = "CR3: no single-tile full-raw CRAW track."; return false; }
+    if (!loc.ok) { errMsg = "CR3: no full-raw CRAW track."; return false; }
     if (loc.nBits == 0 || loc.nPlanes != 4) { errMsg = "CR3: unexpected CMP1 (planes/bits)."; return false; }
     if (loc.mdatOff == 0 || loc.streamLen == 0 || loc.mdatOff + loc.streamLen > d.size()) {
         errMsg = "CR3: bad CRX bitstream location."; return false;
     }
 
-    size_t headerBytes = 0; int nPlanes = 0;
-    if (!crxHeaderInfo(d, loc.mdatOff, loc.streamLen, headerBytes, nPlanes) || nPlanes != 4) {
-        errMsg = "CR3: unsupported CRX (levels>0 or plane count)."; return false;
-    }
+    file.willNeed(qint64(loc.mdatOff), qint64(loc.streamLen));
 
-    /* Continuous entropy stream: all planes decode from one reader starting after the header. */
-    const int pw = int(loc.tileW / 2), ph = int(loc.tileH / 2);
-    const int fW = int(loc.tileW), fH = int(loc.tileH);
-    if (pw <= 0 || ph <= 0) { errMsg = "CR3: bad plane geometry."; return false; }
-    const uint8_t *stream = &d[loc.mdatOff + headerBytes];
-    const size_t streamBytes = (size_t)loc.streamLen - headerBytes;
+    std::vector<CrxTile> tiles;
+    if (!crxReadTiles(d, loc, tiles, errMsg)) return false;
+
+    const int pw = int(loc.fW / 2), ph = int(loc.fH / 2);
+    const int fW = 2 * pw, fH = 2 * ph;
     const int32_t median = 1 << (loc.nBits - 1);
     const int32_t maxv = (1 << loc.nBits) - 1;
 
-    /* Decode 4 planes and interleave row-major into the full RGGB mosaic. */
-    std::vector<uint16_t> full((size_t)fW * fH, 0);
-    Band band(stream, streamBytes, pw);
-    for (int pl = 0; pl < 4; ++pl) {
-        std::fill(band.buf0.begin(), band.buf0.end(), 0);
-        std::fill(band.buf1.begin(), band.buf1.end(), 0);
-        band.k = 0; band.s_param = 0;
-        const int dy = pl >> 1, dx = pl & 1;                  // plane 0/1/2/3 -> quad (0,0)(0,1)(1,0)(1,1)
-        for (int y = 0; y < ph; ++y) {
-            if (y == 0) band.topLine(); else { std::swap(band.buf0, band.buf1); band.nonTopLine(); }
-            uint16_t *row = &full[(size_t)(2 * y + dy) * fW + dx];
-            for (int x = 0; x < pw; ++x) {
-                int32_t v = median + band.buf1[x + 1];
-                row[(size_t)2 * x] = (uint16_t)std::max(0, std::min(maxv, v));
+    /* Decode every tile into the four Bayer planes, plane 0/1/2/3 -> quad (0,0)(0,1)(1,0)(1,1).
+       Tiles are independent bitstreams writing disjoint samples, so the caller and pool helpers
+       take them off a shared counter. A tile whose planes need more bits than its header gave
+       it was misaddressed or is corrupt: fail to the preview rather than show noise. */
+    std::vector<uint16_t> plane[4];
+    for (std::vector<uint16_t> &pv : plane) pv.assign((size_t)pw * ph, 0);
+    auto decodeTile = [&](const CrxTile &t) -> bool {
+        Band band(&d[t.off], size_t(t.len), t.w);
+        for (int pl = 0; pl < 4; ++pl) {
+            std::fill(band.buf0.begin(), band.buf0.end(), 0);
+            std::fill(band.buf1.begin(), band.buf1.end(), 0);
+            band.k = 0; band.s_param = 0;
+            for (int y = 0; y < t.h; ++y) {
+                if (y == 0) band.topLine(); else { std::swap(band.buf0, band.buf1); band.nonTopLine(); }
+                uint16_t *row = &plane[pl][(size_t)(t.y0 + y) * pw + t.x0];
+                for (int x = 0; x < t.w; ++x) {
+                    int32_t v = median + band.buf1[x + 1];
+                    row[x] = (uint16_t)std::max(0, std::min(maxv, v));
+                }
             }
         }
-    }
+        return tiles.size() == 1 || !band.br.eof;
+    };
+    std::atomic<int> next{0};
+    std::atomic<bool> failed{false};
+    const int n = int(tiles.size());
+    auto work = [&]() {
+        for (int i; !failed.load(std::memory_order_relaxed) &&
+                    (i = next.fetch_add(1, std::memory_order_relaxed)) < n; )
+            if (!decodeTile(tiles[size_t(i)])) failed.store(true);
+    };
+    const int maxThreads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int helpers = qMin(maxThreads, n) - 1;
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 0; k < helpers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), work));
+    work();
+    for (QFuture<void> &f : futures) f.waitForFinished();
+    if (failed.load()) { errMsg = "CR3: CRX tile bitstream overran its tile."; return false; }
+
+    /* Mosaic sample (x, y) of the full sensor. */
+    auto mosaic = [&](int x, int y) -> uint16_t {
+        return plane[((y & 1) << 1) | (x & 1)][(size_t)(y >> 1) * pw + (x >> 1)];
+    };
 
     /* Active-area crop (IAD1). Fall back to the full sensor if absent/implausible. Keep the
        origin even so the RGGB phase is preserved. */
@@ -335,16 +419,22 @@ bool CanonCR3Raw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
         for (int y = 0; y < fH; ++y)
             for (int x = 2; x < mb; ++x) {
                 const int idx = ((y & 1) << 1) | (x & 1);
-                sum[idx] += full[(size_t)y * fW + x]; ++cnt[idx];
+                sum[idx] += mosaic(x, y); ++cnt[idx];
             }
         for (int i = 0; i < 4; ++i) if (cnt[i]) black[i] = uint16_t(sum[i] / double(cnt[i]) + 0.5);
     }
 
+    /* Interleave the planes into the cropped mosaic; left is even, so column x of the crop
+       comes from the odd plane of its row exactly when x is odd. */
     raw.width = cw; raw.height = ch;
     raw.cfa.assign((size_t)cw * ch, 0);
-    for (int y = 0; y < ch; ++y)
-        for (int x = 0; x < cw; ++x)
-            raw.cfa[(size_t)y * cw + x] = full[(size_t)(top + y) * fW + (left + x)];
+    for (int y = 0; y < ch; ++y) {
+        const int sy = top + y;
+        const uint16_t *even = &plane[(sy & 1) << 1][(size_t)(sy >> 1) * pw + (left >> 1)];
+        const uint16_t *odd  = &plane[((sy & 1) << 1) | 1][(size_t)(sy >> 1) * pw + (left >> 1)];
+        uint16_t *dst = &raw.cfa[(size_t)y * cw];
+        for (int x = 0; x < cw; ++x) dst[x] = (x & 1) ? odd[x >> 1] : even[x >> 1];
+    }
 
     raw.pattern = CfaPattern::RGGB;                           // Canon full-frame CRAW is RGGB
     raw.white = uint16_t(maxv);
@@ -352,8 +442,10 @@ bool CanonCR3Raw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
 
     /* As-shot white balance from the CMT3 (Canon makernote) ColorData tag 0x4001. */
     {
-        int t = all.indexOf(QByteArray("CMT3", 4));
-        if (t >= 4) {
+        static const char cmt3[4] = {'C', 'M', 'T', '3'};
+        const uint8_t *hit = std::search(d.p, d.p + d.n, cmt3, cmt3 + 4);
+        const qint64 t = hit - d.p;
+        if (hit != d.p + d.n && t >= 4) {
             using namespace TiffWalk;
             Reader r;
             if (r.init(&file, quint32(t + 4))) {              // TIFF embedded at the box payload
@@ -4,7 +4,11 @@
 #include "ImageFormats/Raw/tiffwalk.h"
 #include "ImageFormats/Raw/losslessjpeg.h"
 #include "ImageFormats/Raw/rawimage.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <atomic>
 #include <cmath>
+#include <limits>
 
 DNG::DNG()
 {
@@ -386,28 +390,9 @@ enum DngTag {
 };
 const int PHOTO_CFA = 32803;
 
-/* Place one decoded lossless-JPEG segment (component-interleaved) into the CFA at (gx,gy). */
-void placeLjpeg(const LosslessJpeg::Image &im, int gx, int gy,
-                std::vector<uint16_t> &cfa, int W, int H)
-{
-    const int cs = im.components;
-    for (int ty = 0; ty < im.height; ++ty) {
-        const int cy = gy + ty;
-        if (cy < 0 || cy >= H) continue;
-        for (int tx = 0; tx < im.width; ++tx) {
-            for (int c = 0; c < cs; ++c) {
-                const int cx = gx + tx * cs + c;
-                if (cx < 0 || cx >= W) continue;
-                cfa[size_t(cy) * W + cx] =
-                    im.samples[(size_t(ty) * im.width + tx) * cs + c];
-            }
-        }
-    }
-}
-
 } // namespace
 
-bool DngRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool DngRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
     Q_UNUSED(m)
     using namespace TiffWalk;
@@ -489,38 +474,77 @@ bool DngRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
         errMsg = "DNG: no strips or tiles."; return false;
     }
 
-    /* Decode each segment into the CFA. */
+    /*
+        Decode the segments straight out of the mapped file into raw.cfa. Tiles (and strips)
+        are independent bitstreams that write disjoint parts of the mosaic, so they are
+        claimed from a shared counter by this thread and pool helpers, as in
+        Demosaic::ForEachTile; a 24 MP DNG is a few hundred 256x256 tiles.
+    */
+    quint32 dataStart = std::numeric_limits<quint32>::max(), dataEnd = 0;
     for (const Seg &s : segs) {
-        if (!file.seek(s.off)) { errMsg = "DNG: seek to segment failed."; return false; }
-        const QByteArray buf = file.read(int(s.len));
-        if (buf.size() < int(s.len)) { errMsg = "DNG: short segment read."; return false; }
+        if (!file.at(s.off, s.len)) { errMsg = "DNG: short segment read."; return false; }
+        dataStart = qMin(dataStart, s.off);
+        dataEnd = qMax(dataEnd, s.off + s.len);
+    }
+    file.willNeed(dataStart, qint64(dataEnd) - dataStart);
 
+    const bool big = r.big();
+    QVector<QString> segErr(segs.size());
+    auto decodeSeg = [&](int i) -> bool {
+        const Seg &s = segs[i];
+        const uchar *p = file.at(s.off, s.len);
         if (comp == 7) {
-            LosslessJpeg::Image im;
-            QString lerr;
-            if (!LosslessJpeg::Decode(reinterpret_cast<const uint8_t *>(buf.constData()),
-                                      size_t(buf.size()), im, &lerr)) {
-                errMsg = "DNG: lossless JPEG decode failed (" + lerr + ").";
-                return false;
+            LosslessJpeg::Target t;
+            t.dst = raw.cfa.data();
+            t.stride = W;
+            t.width = W;
+            t.height = H;
+            t.x0 = s.gx;
+            t.y0 = s.gy;
+            return LosslessJpeg::DecodeInto(p, s.len, t, &segErr[i]);
+        }
+        /* Uncompressed: 16-bit little/big-endian samples, segW x segH, row-major. */
+        const int rows = qMin(segH, H - s.gy);
+        const int cols = qMin(segW, W - s.gx);
+        const size_t avail = size_t(s.len) / 2;
+        for (int ty = 0; ty < rows; ++ty) {
+            uint16_t *dst = raw.cfa.data() + size_t(s.gy + ty) * W + s.gx;
+            for (int tx = 0; tx < cols; ++tx) {
+                const size_t idx = size_t(ty) * segW + tx;
+                if (idx >= avail) break;
+                const uchar *q = p + idx * 2;
+                dst[tx] = big ? uint16_t((q[0] << 8) | q[1]) : uint16_t((q[1] << 8) | q[0]);
             }
-            placeLjpeg(im, s.gx, s.gy, raw.cfa, W, H);
-        } else {
-            /* Uncompressed: 16-bit little/big-endian samples, segW x segH, row-major. */
-            const uchar *p = reinterpret_cast<const uchar *>(buf.constData());
-            const int rows = qMin(segH, H - s.gy);
-            const int cols = qMin(segW, W - s.gx);
-            const size_t avail = size_t(buf.size()) / 2;
-            for (int ty = 0; ty < rows; ++ty) {
-                for (int tx = 0; tx < cols; ++tx) {
-                    const size_t idx = size_t(ty) * segW + tx;
-                    if (idx >= avail) break;
-                    const uchar *q = p + idx * 2;
-                    const uint16_t v = r.big() ? uint16_t((q[0] << 8) | q[1])
-                                               : uint16_t((q[1] << 8) | q[0]);
-                    raw.cfa[size_t(s.gy + ty) * W + (s.gx + tx)] = v;
-                }
+        }
+        return true;
+    };
+
+    std::atomic<int> next{0};
+    std::atomic<int> failed{-1};
+    auto work = [&]() {
+        for (;;) {
+            if (failed.load(std::memory_order_relaxed) >= 0) return;
+            const int i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= segs.size()) return;
+            if (!decodeSeg(i)) {
+                int none = -1;
+                failed.compare_exchange_strong(none, i);
+                return;
             }
         }
+    };
+    const int maxThreads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int helpers = qMin(maxThreads, int(segs.size())) - 1;
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 0; k < helpers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), work));
+    work();
+    for (QFuture<void> &f : futures) f.waitForFinished();
+
+    if (failed.load() >= 0) {
+        errMsg = "DNG: lossless JPEG decode failed (" + segErr[failed.load()] + ").";
+        return false;
     }
 
     /* CFA pattern. */
@@ -38,7 +38,7 @@ private:
 class DngRaw : public RawFormat
 {
 protected:
-    bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) override;
+    bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) override;
 };
 
 #endif // DNG_H
@@ -5,6 +5,7 @@
 #include "ImageFormats/Fuji/fujicompressed.h"
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
 Fuji::Fuji()
 {
@@ -298,14 +299,13 @@ bool Fuji::parse(MetadataParameters &p,
    Validated byte-identical to libraw on an uncompressed X-Trans RAF (X-T50).
    ------------------------------------------------------------------------------------------ */
 
-bool FujiRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool FujiRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
     Q_UNUSED(m)
 
-    const QByteArray all = (file.seek(0), file.readAll());
-    const uchar *d = reinterpret_cast<const uchar *>(all.constData());
-    const qint64 n = all.size();
-    if (n < 128 || all.left(16) != QByteArray("FUJIFILMCCD-RAW ")) {
+    const uchar *d = file.data();
+    const qint64 n = file.size();
+    if (n < 128 || std::memcmp(d, "FUJIFILMCCD-RAW ", 16) != 0) {
         errMsg = "RAF: not a Fuji RAF file."; return false;
     }
     auto be = [&](qint64 o, int k) -> quint32 {     // RAF header values are big-endian
@@ -318,6 +318,7 @@ bool FujiRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     const quint32 cfaOff = be(100, 4);              // raw CFA data offset
     const quint32 cfaLen = be(104, 4);              // raw CFA data length
     if (cfaHdr + 4 > n) { errMsg = "RAF: bad CFA header offset."; return false; }
+    file.willNeed(cfaOff, cfaLen);                  // page the sensor data in while the directory is walked
 
     /* Walk the Fuji CFA directory (big-endian tag/len records). */
     int rawW = 0, rawH = 0;
@@ -407,19 +408,46 @@ bool FujiRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
         raw.pattern = CfaPattern::RGGB;
     }
 
+    /* The active area (RawImageCropTopLeft 0x0110 + RawImageCroppedSize 0x0111) of a
+       frameW x frameH sensor, dropping the optical-black margins -- otherwise the dark border
+       shows as a black edge (most visible on Bayer GFX, which has ~190 black columns on the
+       right). Preserve CFA phase: for Bayer the crop origin must stay even (RGGB unchanged);
+       for X-Trans the 6x6 map is rolled by the crop origin below so the demosaicer, which
+       tiles from (0,0), still sees the right colours. The whole frame when the tags are
+       absent or do not fit. */
+    auto activeArea = [&](int frameW, int frameH) -> QRect {
+        if (cropW <= 0 || cropH <= 0 || cropTop < 0 || cropLeft < 0 ||
+            cropLeft + cropW > frameW || cropTop + cropH > frameH)
+            return QRect(0, 0, frameW, frameH);
+        int top = cropTop, left = cropLeft, cw = cropW, ch = cropH;
+        if (raw.pattern != CfaPattern::XTrans) {          // keep Bayer origin even
+            if (left & 1) { ++left; --cw; }
+            if (top & 1)  { ++top;  --ch; }
+        }
+        return QRect(left, top, cw, ch);
+    };
+
     /* The compressed data block opens with a 16-byte header (signature 0x4953) at cfaOff +
-       StripOffset; uncompressed bodies store interleaved 16-bit samples instead. Route on it. */
+       StripOffset; uncompressed bodies store interleaved 16-bit samples instead. Route on it.
+       The compressed decoder writes the active area straight into raw.cfa. */
+    QRect area;
     const qint64 dataOffset = qint64(cfaOff) + stripOffset;
     if (stripOffset && FujiCompressed::isCompressed(d, n, dataOffset)) {
         static const int bayerRGGB[2][2] = {{0, 1}, {1, 2}};
         QString derr;
         int rw = 0, rh = 0;
-        if (!FujiCompressed::decode(d, n, dataOffset, raw.cfa, rw, rh, xt, bayerRGGB, derr)) {
+        if (!FujiCompressed::readHeader(d, n, dataOffset, rw, rh, derr)) {
+            errMsg = "RAF: " + derr;
+            return false;
+        }
+        area = activeArea(rw, rh);
+        raw.cfa.assign(size_t(area.width()) * size_t(area.height()), 0);
+        if (!FujiCompressed::decode(d, n, dataOffset, area, raw.cfa.data(), xt, bayerRGGB, derr)) {
             errMsg = "RAF: " + derr;
             return false;
         }
-        raw.width = rw;
-        raw.height = rh;
+        raw.width = area.width();
+        raw.height = area.height();
     } else {
         /* Uncompressed RAF (16-bit samples): the data block is raw_width*raw_height*2 bytes plus
            a small leading header inside the CFA block. */
@@ -429,42 +457,21 @@ bool FujiRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
         const qint64 base = qint64(cfaOff) + hdr;
         if (base + need > n) { errMsg = "RAF: CFA data out of range."; return false; }
 
-        raw.width = rawW;
-        raw.height = rawH;
-        raw.cfa.assign(size_t(rawW) * size_t(rawH), 0);
-        const uchar *p = d + base;                        // little-endian 16-bit samples
-        const size_t count = size_t(rawW) * size_t(rawH);
-        for (size_t i = 0; i < count; ++i)
-            raw.cfa[i] = uint16_t(p[2 * i] | (p[2 * i + 1] << 8));
+        area = activeArea(rawW, rawH);
+        raw.width = area.width();
+        raw.height = area.height();
+        raw.cfa.assign(size_t(raw.width) * size_t(raw.height), 0);
+        for (int y = 0; y < raw.height; ++y) {           // little-endian 16-bit samples
+            const uchar *p = d + base + (qint64(area.top() + y) * rawW + area.left()) * 2;
+            uint16_t *dst = raw.cfa.data() + size_t(y) * raw.width;
+            for (int x = 0; x < raw.width; ++x) dst[x] = uint16_t(p[2 * x] | (p[2 * x + 1] << 8));
+        }
     }
 
-    /* Crop to the active area (RawImageCropTopLeft 0x0110 + RawImageCroppedSize 0x0111), dropping
-       the optical-black margins -- otherwise the dark border shows as a black edge (most visible on
-       Bayer GFX, which has ~190 black columns on the right). Preserve CFA phase: for Bayer the crop
-       origin must stay even (RGGB unchanged); for X-Trans the 6x6 map is rolled by the crop origin
-       so the demosaicer, which tiles from (0,0), still sees the right colours. */
-    if (cropW > 0 && cropH > 0 && cropTop >= 0 && cropLeft >= 0 &&
-        cropLeft + cropW <= raw.width && cropTop + cropH <= raw.height) {
-        int top = cropTop, left = cropLeft, cw = cropW, ch = cropH;
-        if (raw.pattern != CfaPattern::XTrans) {          // keep Bayer origin even
-            if (left & 1) { ++left; --cw; }
-            if (top & 1)  { ++top;  --ch; }
-        }
-        std::vector<uint16_t> cropped(size_t(cw) * size_t(ch));
-        for (int y = 0; y < ch; ++y) {
-            const uint16_t *src = raw.cfa.data() + size_t(top + y) * raw.width + left;
-            std::copy(src, src + cw, cropped.data() + size_t(y) * cw);
-        }
-        if (raw.pattern == CfaPattern::XTrans) {
-            uint8_t rolled[6][6];
-            for (int r = 0; r < 6; ++r)
-                for (int c = 0; c < 6; ++c) rolled[r][c] = xt[(top + r) % 6][(left + c) % 6];
-            for (int r = 0; r < 6; ++r)
-                for (int c = 0; c < 6; ++c) raw.xtrans[r][c] = rolled[r][c];
-        }
-        raw.cfa.swap(cropped);
-        raw.width = cw;
-        raw.height = ch;
+    if (raw.pattern == CfaPattern::XTrans && (area.left() || area.top())) {
+        for (int r = 0; r < 6; ++r)
+            for (int c = 0; c < 6; ++c)
+                raw.xtrans[r][c] = xt[(area.top() + r) % 6][(area.left() + c) % 6];
     }
 
     /* White balance. Prefer the explicit 0x2FF0 tag; otherwise locate the as-shot WB_GRBLevels
@@ -497,7 +504,7 @@ bool FujiRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
 
     /* Colour matrix by model: TIFF tag 272 lives in the embedded JPEG's TIFF, not here, so use
        the camera id text in the RAF header (bytes 0x1C..) -> "Fujifilm " + model. */
-    QString model = QString::fromLatin1(all.mid(0x1C, 32)).trimmed();
+    QString model = QString::fromLatin1(file.read(0x1C, 32)).trimmed();
     if (!model.isEmpty()) model = "Fujifilm " + model;
     xyzToCamForModel(model, raw.xyzToCam);
 
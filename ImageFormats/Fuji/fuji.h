@@ -37,7 +37,7 @@ private:
 class FujiRaw : public RawFormat
 {
 protected:
-    bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) override;
+    bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) override;
 };
 
 #endif // FUJI_H
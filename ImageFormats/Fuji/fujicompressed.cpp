@@ -1,8 +1,11 @@
 #include "ImageFormats/Fuji/fujicompressed.h"
 
+#include <QtConcurrent>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <stdexcept>
+#include <vector>
 
 /*
     Fujifilm compressed RAF CFA decoder. Faithful port of LibRaw's fuji_compressed.cpp
@@ -34,7 +37,8 @@ struct Ctx {
     int bayer_pat[2][2] = {{0}};
     const uchar *file = nullptr;
     INT64 fileSize = 0;
-    ushort *raw = nullptr;                 // output mosaic, raw_width*raw_height
+    ushort *raw = nullptr;                 // output mosaic: the window, win_width*win_height
+    int win_left = 0, win_top = 0, win_width = 0, win_height = 0;
 };
 
 static inline int FC(const Ctx &c, int r, int col) { return c.bayer_pat[r & 1][col & 1]; }
@@ -185,15 +189,19 @@ static void init_fuji_block(const Ctx &c, fuji_compressed_block *info, const fuj
     }
 }
 
+/* The stripe's 6 decoded lines go to the output window: only the rows and columns inside it
+   are written (LibRaw wrote the whole raw frame and the caller cropped a copy). */
 static void copy_line_to_xtrans(const Ctx &c, fuji_compressed_block *info, int cur_line, int cur_block, int cur_block_width) {
-    ushort *lineBufB[3], *lineBufG[6], *lineBufR[3], *line_buf; unsigned pixel_count; int index;
-    int offset = c.fuji_block_width * cur_block + 6 * c.raw_width * cur_line;
-    ushort *raw_block_data = c.raw + offset; int row_count = 0;
+    ushort *lineBufB[3], *lineBufG[6], *lineBufR[3], *line_buf; int index;
+    const int x0 = c.fuji_block_width * cur_block - c.win_left;
+    const int from = _max(0, -x0), to = _min(cur_block_width, c.win_width - x0);
     for (int i = 0; i < 3; i++) { lineBufR[i] = info->linebuf[_R2+i] + 1; lineBufB[i] = info->linebuf[_B2+i] + 1; }
     for (int i = 0; i < 6; i++) lineBufG[i] = info->linebuf[_G2+i] + 1;
-    while (row_count < 6) {
-        pixel_count = 0;
-        while (pixel_count < (unsigned)cur_block_width) {
+    for (int row_count = 0; row_count < 6; ++row_count) {
+        const int y = 6 * cur_line + row_count - c.win_top;
+        if (y < 0 || y >= c.win_height) continue;
+        ushort *raw_block_data = c.raw + (size_t)y * c.win_width + x0;
+        for (int pixel_count = from; pixel_count < to; ++pixel_count) {
             switch (c.xtrans_abs[row_count][pixel_count % 6]) {
                 case 0: line_buf = lineBufR[row_count >> 1]; break;
                 case 1: default: line_buf = lineBufG[row_count]; break;
@@ -201,31 +209,29 @@ static void copy_line_to_xtrans(const Ctx &c, fuji_compressed_block *info, int c
             }
             index = (((pixel_count * 2 / 3) & 0x7FFFFFFE) | ((pixel_count % 3) & 1)) + ((pixel_count % 3) >> 1);
             raw_block_data[pixel_count] = line_buf[index];
-            ++pixel_count;
         }
-        ++row_count; raw_block_data += c.raw_width;
     }
 }
 
 static void copy_line_to_bayer(const Ctx &c, fuji_compressed_block *info, int cur_line, int cur_block, int cur_block_width) {
-    ushort *lineBufB[3], *lineBufG[6], *lineBufR[3], *line_buf; unsigned pixel_count;
+    ushort *lineBufB[3], *lineBufG[6], *lineBufR[3], *line_buf;
     int fuji_bayer[2][2]; for (int r = 0; r < 2; r++) for (int col = 0; col < 2; col++) fuji_bayer[r][col] = FC(c, r, col);
-    int offset = c.fuji_block_width * cur_block + 6 * c.raw_width * cur_line;
-    ushort *raw_block_data = c.raw + offset; int row_count = 0;
+    const int x0 = c.fuji_block_width * cur_block - c.win_left;
+    const int from = _max(0, -x0), to = _min(cur_block_width, c.win_width - x0);
     for (int i = 0; i < 3; i++) { lineBufR[i] = info->linebuf[_R2+i] + 1; lineBufB[i] = info->linebuf[_B2+i] + 1; }
     for (int i = 0; i < 6; i++) lineBufG[i] = info->linebuf[_G2+i] + 1;
-    while (row_count < 6) {
-        pixel_count = 0;
-        while (pixel_count < (unsigned)cur_block_width) {
+    for (int row_count = 0; row_count < 6; ++row_count) {
+        const int y = 6 * cur_line + row_count - c.win_top;
+        if (y < 0 || y >= c.win_height) continue;
+        ushort *raw_block_data = c.raw + (size_t)y * c.win_width + x0;
+        for (int pixel_count = from; pixel_count < to; ++pixel_count) {
             switch (fuji_bayer[row_count & 1][pixel_count & 1]) {
                 case 0: line_buf = lineBufR[row_count >> 1]; break;
                 case 1: case 3: default: line_buf = lineBufG[row_count]; break;
                 case 2: line_buf = lineBufB[row_count >> 1]; break;
             }
             raw_block_data[pixel_count] = line_buf[pixel_count >> 1];
-            ++pixel_count;
         }
-        ++row_count; raw_block_data += c.raw_width;
     }
 }
 
@@ -478,6 +484,11 @@ static void fuji_decode_strip(const Ctx &c, fuji_compressed_params *params, int
         info_common->qt[0].q_table = (int8_t *)(info_common + 1);
         info_common->qt[0].q_base = -1;
     }
+    info.linealloc = nullptr; info.cur_buf = nullptr;
+    struct Release {
+        fuji_compressed_block &b;
+        ~Release() { free(b.linealloc); free(b.cur_buf); }
+    } release{info};
     init_fuji_block(c, &info, info_common, raw_offset, dsize);
     unsigned line_size = sizeof(ushort) * (info_common->line_width + 2);
     int cur_block_width = c.fuji_block_width;
@@ -503,7 +514,27 @@ static void fuji_decode_strip(const Ctx &c, fuji_compressed_params *params, int
             info.linebuf[ztable[i].a][info_common->line_width+1] = info.linebuf[ztable[i].a-1][info_common->line_width];
         }
     }
-    free(info.linealloc); free(info.cur_buf);
+}
+
+/* The 16-byte big-endian compressed header, validated as LibRaw::parse_fuji_compressed_header. */
+static bool parse_header(const uint8_t *data, int64_t dataOffset, Ctx &c) {
+    const uchar *h = data + dataOffset;
+    c.fuji_lossless    = h[2];
+    c.fuji_raw_type    = h[3];
+    c.fuji_bits        = h[4];
+    c.raw_height       = (int)sgetn(2, h + 5);
+    int rounded_width  = (int)sgetn(2, h + 7);
+    c.raw_width        = (int)sgetn(2, h + 9);
+    c.fuji_block_width = (int)sgetn(2, h + 11);
+    c.fuji_total_blocks = h[13];
+    c.fuji_total_lines = (int)sgetn(2, h + 14);
+    return !(c.fuji_lossless > 1 || c.raw_height < 6 || c.raw_height % 6 ||
+             c.fuji_block_width != 0x300 || c.fuji_total_blocks == 0 || c.fuji_total_blocks > 0x10 ||
+             rounded_width < c.fuji_block_width || rounded_width % c.fuji_block_width ||
+             c.fuji_total_blocks != rounded_width / c.fuji_block_width ||
+             c.fuji_total_lines == 0 || c.fuji_total_lines != c.raw_height / 6 ||
+             (c.fuji_bits != 12 && c.fuji_bits != 14 && c.fuji_bits != 16) ||
+             (c.fuji_raw_type != 16 && c.fuji_raw_type != 0));
 }
 
 } // anonymous namespace
@@ -514,76 +545,99 @@ bool isCompressed(const uint8_t *data, int64_t size, int64_t dataOffset)
     return sgetn(2, data + dataOffset) == 0x4953;       // compressed-header signature
 }
 
-bool decode(const uint8_t *data, int64_t size, int64_t dataOffset,
-            std::vector<uint16_t> &out, int &rawW, int &rawH,
-            const uint8_t xtrans[6][6], const int bayer[2][2], QString &err)
+bool readHeader(const uint8_t *data, int64_t size, int64_t dataOffset, int &rawW, int &rawH, QString &err)
 {
+    Ctx c;
     if (!isCompressed(data, size, dataOffset)) { err = "Fuji: not a compressed RAF header."; return false; }
+    if (!parse_header(data, dataOffset, c)) { err = "Fuji: invalid compressed header."; return false; }
+    rawW = c.raw_width; rawH = c.raw_height;
+    return true;
+}
 
+bool decode(const uint8_t *data, int64_t size, int64_t dataOffset, const QRect &window, uint16_t *out,
+            const uint8_t xtrans[6][6], const int bayer[2][2], QString &err)
+{
     Ctx c;
-    c.file = data; c.fileSize = size;
-    const uchar *h = data + dataOffset;
-    /* 16-byte big-endian compressed header. */
-    c.fuji_lossless    = h[2];
-    c.fuji_raw_type    = h[3];
-    c.fuji_bits        = h[4];
-    c.raw_height       = (int)sgetn(2, h + 5);
-    int rounded_width  = (int)sgetn(2, h + 7);
-    c.raw_width        = (int)sgetn(2, h + 9);
-    c.fuji_block_width = (int)sgetn(2, h + 11);
-    c.fuji_total_blocks = h[13];
-    c.fuji_total_lines = (int)sgetn(2, h + 14);
-
-    /* Validation mirroring LibRaw::parse_fuji_compressed_header. */
-    if (c.fuji_lossless > 1 || c.raw_height < 6 || c.raw_height % 6 ||
-        c.fuji_block_width != 0x300 || c.fuji_total_blocks == 0 || c.fuji_total_blocks > 0x10 ||
-        rounded_width < c.fuji_block_width || rounded_width % c.fuji_block_width ||
-        c.fuji_total_blocks != rounded_width / c.fuji_block_width ||
-        c.fuji_total_lines == 0 || c.fuji_total_lines != c.raw_height / 6 ||
-        (c.fuji_bits != 12 && c.fuji_bits != 14 && c.fuji_bits != 16) ||
-        (c.fuji_raw_type != 16 && c.fuji_raw_type != 0)) {
-        err = "Fuji: invalid compressed header."; return false;
+    if (!isCompressed(data, size, dataOffset)) { err = "Fuji: not a compressed RAF header."; return false; }
+    if (!parse_header(data, dataOffset, c)) { err = "Fuji: invalid compressed header."; return false; }
+    if (!out || window.isEmpty() || !QRect(0, 0, c.raw_width, c.raw_height).contains(window)) {
+        err = "Fuji: output window outside the raw frame."; return false;
     }
+    c.file = data; c.fileSize = size;
+    c.raw = out;
+    c.win_left = window.x(); c.win_top = window.y();
+    c.win_width = window.width(); c.win_height = window.height();
     INT64 strip_data = dataOffset + 16;        // block-size table follows the header
 
     for (int i = 0; i < 6; i++) for (int j = 0; j < 6; j++) c.xtrans_abs[i][j] = xtrans ? xtrans[i][j] : 0;
     for (int i = 0; i < 2; i++) for (int j = 0; j < 2; j++) c.bayer_pat[i][j] = bayer ? bayer[i][j] : 0;
 
-    out.assign((size_t)c.raw_width * c.raw_height, 0);
-    c.raw = out.data();
-
     fuji_compressed_params common; memset(&common, 0, sizeof(common));
+    std::vector<INT64> raw_block_offsets(c.fuji_total_blocks);
+    std::vector<unsigned> block_sizes(c.fuji_total_blocks);
+    std::vector<uchar> qb;
+    int lineStep = (c.fuji_total_lines + 0xF) & ~0xF;
     try {
         init_fuji_compr(c, &common);
 
-        std::vector<unsigned> block_sizes(c.fuji_total_blocks);
-        std::vector<INT64> raw_block_offsets(c.fuji_total_blocks);
         if (strip_data + (INT64)sizeof(unsigned) * c.fuji_total_blocks > size) throw std::runtime_error("Fuji: truncated block table");
         memcpy(block_sizes.data(), data + strip_data, sizeof(unsigned) * c.fuji_total_blocks);
 
         INT64 raw_offset = ((INT64)(sizeof(unsigned) * c.fuji_total_blocks) + 0xF) & ~0xF;
-        uchar *q_bases = nullptr; std::vector<uchar> qb;
-        int lineStep = (c.fuji_total_lines + 0xF) & ~0xF;
         if (!c.fuji_lossless) {
             int total_q = c.fuji_total_blocks * lineStep;
             if (strip_data + raw_offset + total_q > size) throw std::runtime_error("Fuji: truncated q_bases");
             qb.assign(total_q, 0);
             memcpy(qb.data(), data + strip_data + raw_offset, total_q);
-            q_bases = qb.data();
             raw_offset += total_q;
         }
         raw_offset += strip_data;
         for (int b = 0; b < c.fuji_total_blocks; b++) block_sizes[b] = sgetn(4, (uchar *)&block_sizes[b]);
         raw_block_offsets[0] = raw_offset;
         for (int b = 1; b < c.fuji_total_blocks; b++) raw_block_offsets[b] = raw_block_offsets[b-1] + block_sizes[b-1];
-
-        for (int b = 0; b < c.fuji_total_blocks; b++)
-            fuji_decode_strip(c, &common, b, raw_block_offsets[b], block_sizes[b], q_bases ? q_bases + b * lineStep : nullptr);
     } catch (const std::exception &e) {
         free(common.buf); err = QString::fromLatin1(e.what()); return false;
     }
+
+    /* The stripes (LibRaw's blocks, 768 sensor columns each) are coded independently: each
+       has its own bitstream, line buffers and gradient state, and the shared parameters are
+       only read (a lossy stripe works on its own copy). So they decode in parallel, on pool
+       helpers plus this thread, each writing its own columns of the window. A stripe that
+       lies wholly outside the window is skipped. */
+    const int blocks = c.fuji_total_blocks;
+    std::vector<QString> errs(blocks);
+    std::atomic<int> nextBlock{0};
+    std::atomic<bool> failed{false};
+    auto run = [&]() {
+        for (;;) {
+            if (failed.load(std::memory_order_relaxed)) return;
+            const int b = nextBlock.fetch_add(1, std::memory_order_relaxed);
+            if (b >= blocks) return;
+            const int x0 = c.fuji_block_width * b;
+            if (x0 >= c.win_left + c.win_width || x0 + c.fuji_block_width <= c.win_left) continue;
+            try {
+                fuji_decode_strip(c, &common, b, raw_block_offsets[b], block_sizes[b],
+                                  qb.empty() ? nullptr : qb.data() + b * lineStep);
+            } catch (const std::exception &e) {
+                errs[b] = QString::fromLatin1(e.what());
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    };
+    const int helpers = qMin(qMax(1, QThreadPool::globalInstance()->maxThreadCount()), blocks) - 1;
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 0; k < helpers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), run));
+    run();
+    for (QFuture<void> &f : futures) f.waitForFinished();
     free(common.buf);
-    rawW = c.raw_width; rawH = c.raw_height;
+
+    if (failed.load()) {
+        for (const QString &e : errs) if (!e.isEmpty()) { err = e; break; }
+        return false;
+    }
     return true;
 }
 
@@ -2,7 +2,7 @@
 #define FUJICOMPRESSED_H
 
 #include <cstdint>
-#include <vector>
+#include <QRect>
 #include <QString>
 
 /*
@@ -14,22 +14,28 @@
     LibRaw on the compressed X-Trans (X-T2) and Bayer (GFX 50S II) sample RAFs.
 
     The compressed data block begins with a 16-byte big-endian header (signature 0x4953) that
-    carries the geometry, bit depth, block layout and lossless flag; decode() parses it, walks
-    the per-block bitstreams and writes one uint16 sample per photosite, row-major over the full
-    raw_width x raw_height sensor area (the same layout the uncompressed path produces).
+    carries the geometry, bit depth, block layout and lossless flag; readHeader() validates it
+    and returns the raw_width x raw_height sensor area. The sensor is coded as independent
+    vertical stripes of 768 columns, which decode() runs in parallel on the global thread pool
+    (the calling thread takes a share), each stripe writing its own columns.
 
     'data' points at the whole RAF mapped in memory; 'dataOffset' is the absolute offset of the
-    16-byte header (cfaOff + FujiIFD StripOffset 0xf007). 'xtrans' is the 6x6 colour map
-    (0=R,1=G,2=B) for X-Trans bodies; 'bayer' is the 2x2 FC map for Bayer bodies (e.g. GFX).
-    On success out is sized rawW*rawH and rawW/rawH are set from the header. Returns false with
-    err set on malformed input.
+    16-byte header (cfaOff + FujiIFD StripOffset 0xf007). decode() writes the samples inside
+    'window' (sensor coordinates, which must lie within the raw area) row-major to 'out', which
+    holds window.width() * window.height() uint16 -- RawImage::cfa sized to the active area, so
+    the margins are never copied. Stripes wholly outside the window are not decoded. 'xtrans'
+    is the 6x6 colour map (0=R,1=G,2=B) for X-Trans bodies; 'bayer' is the 2x2 FC map for Bayer
+    bodies (e.g. GFX). Both return false with err set on malformed input.
 */
 namespace FujiCompressed {
 
 bool isCompressed(const uint8_t *data, int64_t size, int64_t dataOffset);
 
+bool readHeader(const uint8_t *data, int64_t size, int64_t dataOffset,
+                int &rawW, int &rawH, QString &err);
+
 bool decode(const uint8_t *data, int64_t size, int64_t dataOffset,
-            std::vector<uint16_t> &out, int &rawW, int &rawH,
+            const QRect &window, uint16_t *out,
             const uint8_t xtrans[6][6], const int bayer[2][2], QString &err);
 
 }
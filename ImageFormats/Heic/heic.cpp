@@ -1,5 +1,10 @@
 #include "heic.h"
 #include "Main/global.h"
+#include "ImageFormats/Heic/heicgrid.h"
+#ifdef Q_OS_WIN
+#include <QtConcurrent>
+#include <atomic>
+#endif
 
 Heic::Heic(/*QFile &file*/)
 {
@@ -291,55 +296,204 @@ heif_error readContext(As... as)
 #endif
 }
 
+/* Decode one HEVC coded picture -- a grid tile or the thumbnail item -- with libde265,
+   the way libheif's decoder plugin does (one worker thread, the hvcC parameter sets then
+   the item's NAL units, end of stream), and write it as RGB888 into dst at (x0, y0).
+   With no dst, picture is allocated at the picture's size and written instead. Only
+   8-bit 4:2:0 is handled; anything else returns false and the caller leaves the image
+   to libheif. */
+bool decodeHevc(const QList<QByteArray> &params, const QByteArray &data, int lengthSize,
+                HeicGrid::Rgb888 dst, int x0, int y0, QImage *picture = nullptr)
+{
+    QList<QByteArray> nals;
+    if (!HeicGrid::splitNals(data, lengthSize, nals)) return false;
+
+    auto ctx = wrapPointer(de265_new_decoder(), de265_free_decoder);
+    if (!ctx) return false;
+    de265_start_worker_threads(ctx.get(), 1);
+    for (const QByteArray &nal : params)
+        if (de265_push_NAL(ctx.get(), nal.constData(), nal.size(), 0, nullptr) != DE265_OK) return false;
+    for (const QByteArray &nal : nals)
+        if (de265_push_NAL(ctx.get(), nal.constData(), nal.size(), 0, nullptr) != DE265_OK) return false;
+    de265_push_end_of_stream(ctx.get());
+
+    const de265_image *img = nullptr;
+    for (int guard = 0; guard < 64 && !img; ++guard) {
+        const int action = de265_get_action(ctx.get(), 1);
+        if (action & de265_action_get_image) img = de265_get_next_picture(ctx.get());
+        else if (action & (de265_action_end_of_stream | de265_action_push_more_input)) break;
+    }
+    if (!img) return false;
+    auto picture = wrapPointer(img, de265_release_picture);
+
+    if (de265_get_chroma_format(img) != de265_chroma_420
+        || de265_get_bits_per_pixel(img, 0) != 8 || de265_get_bits_per_pixel(img, 1) != 8)
+        return false;
+    const int w = de265_get_image_width(img, 0);
+    const int h = de265_get_image_height(img, 0);
+    int yStride = 0, cbStride = 0, crStride = 0;
+    const uint8_t *y = de265_get_image_plane(img, 0, &yStride);
+    const uint8_t *cb = de265_get_image_plane(img, 1, &cbStride);
+    const uint8_t *cr = de265_get_image_plane(img, 2, &crStride);
+    if (!y || !cb || !cr || w <= 0 || h <= 0) return false;
+    if (!dst.bits) {
+        if (!picture) return false;
+        *picture = QImage(w, h, QImage::Format_RGB888);
+        if (picture->isNull()) return false;
+        dst = HeicGrid::Rgb888(*picture);
+    }
+    HeicGrid::yuv420ToRgb888(y, yStride, cb, cbStride, cr, crStride, w, h, dst, x0, y0);
+    return true;
+}
+
+/* The primary image of an iPhone style grid HEIC, its tiles decoded concurrently.
+
+   libheif 1.5.1 decodes a grid tile by tile on the calling thread, then copies every
+   tile into the output. Here each pool thread (and the caller) takes the next tile off
+   a counter, decodes it with its own libde265 context and converts it straight into its
+   rectangle of the destination, which is allocated once at the grid's output size; the
+   tiles share one hvcC, so its parameter sets are split once for all of them. */
+bool decodeGrid(const QString &fPath, QImage &image)
+{
+    QFile f(fPath);
+    MappedFile file(f);
+    const HeicGrid::Plan plan = HeicGrid::parse(file);
+    if (!plan.gridOk()) return false;
+
+    QElapsedTimer t;
+    t.start();
+    QList<QByteArray> params;
+    int lengthSize = 4;
+    if (!HeicGrid::hvcCNals(plan.tiles.first().hvcC, params, lengthSize)) return false;
+
+    QImage out(plan.output, QImage::Format_RGB888);
+    if (out.isNull()) return false;
+    const HeicGrid::Rgb888 dst(out);    // detach once, before the tiles write into it
+    const int tileW = plan.tiles.first().size.width();
+    const int tileH = plan.tiles.first().size.height();
+    const int n = plan.tiles.size();
+
+    std::atomic<int> nextTile{0};
+    std::atomic<bool> failed{false};
+    auto run = [&]() {
+        for (;;) {
+            if (failed.load(std::memory_order_relaxed)) return;
+            const int i = nextTile.fetch_add(1, std::memory_order_relaxed);
+            if (i >= n) return;
+            const HeicGrid::Item &tile = plan.tiles.at(i);
+            QList<QByteArray> ownParams;
+            int ownLength = lengthSize;
+            if (tile.hvcC != plan.tiles.first().hvcC
+                && !HeicGrid::hvcCNals(tile.hvcC, ownParams, ownLength)) {
+                failed = true;
+                return;
+            }
+            const QByteArray data = HeicGrid::itemData(file, plan, tile);
+            const int x0 = (i % plan.columns) * tileW;
+            const int y0 = (i / plan.columns) * tileH;
+            if (data.isEmpty()
+                || !decodeHevc(ownParams.isEmpty() ? params : ownParams, data, ownLength,
+                               dst, x0, y0)) {
+                failed = true;
+                return;
+            }
+        }
+    };
+    const int threads = qMin(qMax(1, QThreadPool::globalInstance()->maxThreadCount()), n);
+    QVector<QFuture<void>> helpers;
+    for (int k = 1; k < threads; ++k)
+        helpers.append(QtConcurrent::run(QThreadPool::globalInstance(), run));
+    run();
+    for (QFuture<void> &h : helpers) h.waitForFinished();
+    if (failed) return false;
+
+    image = HeicGrid::transformed(out, plan.primary.transforms);
+    const qint64 ns = t.nsecsElapsed();
+    HeicGrid::stats.gridDecodes++;
+    HeicGrid::stats.gridNs += ns;
+    HeicGrid::stats.lastGridNs = ns;
+    HeicGrid::stats.lastTiles = n;
+    HeicGrid::stats.lastThreads = threads;
+    return true;
+}
+
+/* The thmb item of the primary image at its own size (about 320 px for an iPhone). */
+bool decodeThumbItem(const QString &fPath, QImage &image)
+{
+    QFile f(fPath);
+    MappedFile file(f);
+    const HeicGrid::Plan plan = HeicGrid::parse(file);
+    if (!plan.thumbOk()) return false;
+
+    QElapsedTimer t;
+    t.start();
+    QList<QByteArray> params;
+    int lengthSize = 4;
+    if (!HeicGrid::hvcCNals(plan.thumb.hvcC, params, lengthSize)) return false;
+    const QByteArray data = HeicGrid::itemData(file, plan, plan.thumb);
+    QImage out;
+    if (data.isEmpty() || !decodeHevc(params, data, lengthSize, {}, 0, 0, &out)) return false;
+    // the coded picture is padded to whole coding blocks; ispe is the image
+    if (plan.thumb.size.isValid() && plan.thumb.size != out.size())
+        out = out.copy(QRect(QPoint(0, 0), plan.thumb.size));
+    image = HeicGrid::transformed(out, plan.thumb.transforms);
+    HeicGrid::stats.thumbDecodes++;
+    HeicGrid::stats.thumbNs += t.nsecsElapsed();
+    return true;
+}
+
 }  // namespace
 
 bool Heic::decodePrimaryImage(QString &fPath, QImage &image)
 {
-    heif_context* ctx = heif_context_alloc();
-    auto error = heif_context_read_from_file(ctx, fPath.toLatin1().data(), nullptr);
+    // grid images (every recent iPhone) decode tile-parallel
+    if (decodeGrid(fPath, image)) return true;
+    HeicGrid::stats.fallbacks++;
+
+    heif_context* ctxPtr = heif_context_alloc();
+    auto ctx = wrapPointer(ctxPtr, heif_context_free);
+    auto error = heif_context_read_from_file(ctx.get(), fPath.toLatin1().data(), nullptr);
     if (error.code) {
         qDebug() << "Heic::decodePrimaryImage" << "heif_context_read_from_file" << error.message;
         return false;
     }
 
     // get a handle to the primary image
-    heif_image_handle* handle = nullptr;
-    error = heif_context_get_primary_image_handle(ctx, &handle);
+    heif_image_handle* handlePtr = nullptr;
+    error = heif_context_get_primary_image_handle(ctx.get(), &handlePtr);
     if (error.code) {
         qDebug() << "Heic::decodePrimaryImage" << "heif_context_get_primary_image_handle" << error.message;
         return false;
     }
+    auto handle = wrapPointer(handlePtr, heif_image_handle_release);
 
     // decode the image and convert colorspace to RGB, saved as 24bit interleaved
-    heif_image* img = nullptr;
-    error = heif_decode_image(handle,
-                      &img,
+    heif_image* imgPtr = nullptr;
+    error = heif_decode_image(handle.get(),
+                      &imgPtr,
                       heif_colorspace_RGB,
                       heif_chroma_interleaved_RGB,
                       nullptr);
-    if (error.code || !img) {
+    if (error.code || !imgPtr) {
         qDebug() << "Heic::decodePrimaryImage" << "heif_decode_image" << error.message;
         return false;
     }
+    auto img = wrapPointer(imgPtr, heif_image_release);
 
-    int w = heif_image_get_width(img, heif_channel_interleaved);
-    int h = heif_image_get_height(img, heif_channel_interleaved);
-//    m.width = w;
-//    m.height = h;
-//    m.widthPreview = w;
-//    m.heightPreview = h;
+    int w = heif_image_get_width(img.get(), heif_channel_interleaved);
+    int h = heif_image_get_height(img.get(), heif_channel_interleaved);
 
     int stride = 0;
-    const uint8_t* data = heif_image_get_plane_readonly(img, heif_channel_interleaved, &stride);
+    const uint8_t* data = heif_image_get_plane_readonly(img.get(), heif_channel_interleaved, &stride);
     if (!data) {
         QString msg = "No pixel data.";
-        G::issueDedup("Warning", msg, "Heic::heic", m->row, m->fPath);
+        G::issueDedup("Warning", msg, "Heic::heic", -1, fPath);
         return false;
     }
 
     if (stride <= 0) {
         QString msg = "Invalid stride = " + QString::number(stride) + ".";
-        G::issueDedup("Warning", msg, "Heic::heic", m->row, m->fPath);
+        G::issueDedup("Warning", msg, "Heic::heic", -1, fPath);
         return false;
     }
     /*
@@ -347,80 +501,58 @@ bool Heic::decodePrimaryImage(QString &fPath, QImage &image)
              << "w =" << w << "h =" << h
              << "stride =" << stride;
 //             */
-    image = QImage(data, w, h, stride, QImage::Format_RGB888);
+    // copy out of the heif_image, which is released on return
+    image = QImage(data, w, h, stride, QImage::Format_RGB888).copy();
     return true;
-    /*
-    heif_image* srcImagePtr = nullptr;
-    heif_decode_image(handle,
-                      &srcImagePtr,
-                      heif_colorspace_RGB,
-                      heif_chroma_interleaved_RGB,
-                      nullptr);
-    auto srcImage = wrapPointer(srcImagePtr, heif_image_release);
-    auto channel = heif_channel_interleaved;
-    int w = heif_image_get_width(srcImage.get(), channel);
-    int h = heif_image_get_height(srcImage.get(), channel);
-    m.width = w;
-    m.height = h;
-    m.widthFull = w;
-    m.heightFull = h;
-    QSize imgSize(w, h);
-    int stride;
-    const uint8_t* data = heif_image_get_plane_readonly(srcImage.get(),
-                                                        heif_channel_interleaved,
-                                                        &stride);
-    qDebug() << "Heic::decodePrimaryImage" << fPath
-             << "imgSize =" << imgSize
-             << "stride =" << stride;
-    // move data ownership to QImage
-    heif_image* dataImage = srcImage.release();
-    image = QImage(
-                data, imgSize.width(), imgSize.height(),
-                stride, QImage::Format_RGBA8888,
-                [](void* img) { heif_image_release(static_cast<heif_image*>(img)); },
-    dataImage
-    );
-    return true;
-    */
 }
 
 bool Heic::decodeThumbnail(QString &fPath, QImage &image)
 {
-    heif_context* ctx = heif_context_alloc();
-    heif_context_read_from_file(ctx, fPath.toLatin1().data(), nullptr);
+    // the thmb item at its native size, without libheif's context
+    if (decodeThumbItem(fPath, image)) return true;
+
+    heif_context* ctxPtr = heif_context_alloc();
+    auto ctx = wrapPointer(ctxPtr, heif_context_free);
+    auto error = heif_context_read_from_file(ctx.get(), fPath.toLatin1().data(), nullptr);
+    if (error.code) return false;
 
     // get a handle to the primary image
-    heif_image_handle* handle = nullptr;
-    heif_context_get_primary_image_handle(ctx, &handle);
+    heif_image_handle* handlePtr = nullptr;
+    error = heif_context_get_primary_image_handle(ctx.get(), &handlePtr);
+    if (error.code) return false;
+    auto handle = wrapPointer(handlePtr, heif_image_handle_release);
 
     // get a handle to the primary image thumbnail
-    heif_image_handle* thumbHandle = nullptr;
-    int count = heif_image_handle_get_number_of_thumbnails(handle);
+    heif_image_handle* thumbPtr = nullptr;
+    int count = heif_image_handle_get_number_of_thumbnails(handle.get());
     if (count > 0) {
         heif_item_id ids[1];
-        heif_image_handle_get_list_of_thumbnail_IDs(handle, ids, count);
+        heif_image_handle_get_list_of_thumbnail_IDs(handle.get(), ids, 1);
 //        qDebug() << "Heic::decodeThumbnail" << ids[0];
-        heif_image_handle_get_thumbnail(handle, ids[0], &thumbHandle);
-        handle = thumbHandle;
+        heif_image_handle_get_thumbnail(handle.get(), ids[0], &thumbPtr);
     }
+    auto thumbHandle = wrapPointer(thumbPtr, heif_image_handle_release);
 
     // decode the image and convert colorspace to RGB, saved as 24bit interleaved
-    heif_image* img = nullptr;
-    heif_decode_image(handle,
-                      &img,
+    heif_image* imgPtr = nullptr;
+    error = heif_decode_image(thumbHandle ? thumbHandle.get() : handle.get(),
+                      &imgPtr,
                       heif_colorspace_RGB,
                       heif_chroma_interleaved_RGB,
                       nullptr);
+    if (error.code || !imgPtr) return false;
+    auto img = wrapPointer(imgPtr, heif_image_release);
 
-    int w = heif_image_get_width(img, heif_channel_interleaved);
-    int h = heif_image_get_height(img, heif_channel_interleaved);
-    int stride;
-    const uint8_t* data = heif_image_get_plane_readonly(img, heif_channel_interleaved, &stride);
+    int w = heif_image_get_width(img.get(), heif_channel_interleaved);
+    int h = heif_image_get_height(img.get(), heif_channel_interleaved);
+    int stride = 0;
+    const uint8_t* data = heif_image_get_plane_readonly(img.get(), heif_channel_interleaved, &stride);
+    if (!data || stride <= 0) return false;
     /*
     qDebug() << "Heic::decodeThumbnail" << fPath
              << "w =" << w << "h =" << h
              << "stride =" << stride;   //*/
-    image = QImage(data, w, h, stride, QImage::Format_RGB888);
+    image = QImage(data, w, h, stride, QImage::Format_RGB888).copy();
     return true;
 }
 #endif
@@ -0,0 +1,377 @@
+#include "ImageFormats/Heic/heicgrid.h"
+#include <QHash>
+#include <QTransform>
+
+HeicGrid::Stats HeicGrid::stats;
+
+namespace {
+
+/* Big-endian reads inside one box payload. A read past the end clears ok and returns 0,
+   so a truncated box is detected once, after the fields are read. */
+struct Cursor {
+    const uchar *p;
+    qint64 n;
+    qint64 i = 0;
+    bool ok = true;
+
+    Cursor(const uchar *p, qint64 n) : p(p), n(n) {}
+    bool need(qint64 k)
+    {
+        if (!ok || k < 0 || i + k > n) { ok = false; return false; }
+        return true;
+    }
+    quint64 u(int bytes)
+    {
+        if (!need(bytes)) return 0;
+        quint64 v = 0;
+        for (int k = 0; k < bytes; ++k) v = (v << 8) | p[i++];
+        return v;
+    }
+    quint32 u8() { return quint32(u(1)); }
+    quint32 u16() { return quint32(u(2)); }
+    quint32 u32() { return quint32(u(4)); }
+    QByteArray fourcc()
+    {
+        if (!need(4)) return QByteArray();
+        QByteArray t(reinterpret_cast<const char *>(p + i), 4);
+        i += 4;
+        return t;
+    }
+    void skip(qint64 k) { if (need(k)) i += k; }
+    qint64 left() const { return ok ? n - i : 0; }
+};
+
+struct Box {
+    QByteArray type;
+    const uchar *payload = nullptr;
+    qint64 size = 0;
+};
+
+/* The boxes in [p, p + n). Stops at the first malformed header. */
+QList<Box> children(const uchar *p, qint64 n)
+{
+    QList<Box> boxes;
+    Cursor c(p, n);
+    while (c.left() >= 8 && boxes.size() < 4096) {
+        const qint64 start = c.i;
+        quint64 size = c.u32();
+        Box b;
+        b.type = c.fourcc();
+        if (size == 1) size = c.u(8);
+        else if (size == 0) size = quint64(n - start);
+        const qint64 header = c.i - start;
+        if (!c.ok || size < quint64(header) || size > quint64(n - start)) break;
+        b.payload = p + c.i;
+        b.size = qint64(size) - header;
+        boxes.append(b);
+        c.i = start + qint64(size);
+    }
+    return boxes;
+}
+
+/* Payload of a full box after its version and flags. */
+Cursor fullBox(const Box &b, int &version, quint32 &flags)
+{
+    Cursor c(b.payload, b.size);
+    version = int(c.u8());
+    flags = quint32(c.u(3));
+    return c;
+}
+
+inline uchar clip(int v) { return uchar(v < 0 ? 0 : v > 255 ? 255 : v); }
+
+}
+
+bool HeicGrid::Plan::gridOk() const
+{
+    if (!ok || primary.type != "grid" || primary.hasClap || primary.hasAlpha) return false;
+    if (rows < 1 || columns < 1 || output.isEmpty()) return false;
+    if (tiles.size() != rows * columns) return false;
+    const QSize tile = tiles.first().size;
+    if (tile.isEmpty()) return false;
+    // the tiles must cover the output; the last row and column are cropped
+    if (tile.width() * columns < output.width() || tile.height() * rows < output.height())
+        return false;
+    for (const Item &t : tiles) {
+        if (t.type != "hvc1" || t.hvcC.isEmpty() || t.size != tile) return false;
+        if (t.hasClap || !t.transforms.isEmpty() || t.extents.isEmpty()) return false;
+    }
+    return true;
+}
+
+bool HeicGrid::Plan::thumbOk() const
+{
+    return ok && thumb.id && thumb.type == "hvc1" && !thumb.hvcC.isEmpty()
+           && !thumb.hasClap && !thumb.hasAlpha && !thumb.extents.isEmpty();
+}
+
+HeicGrid::Plan HeicGrid::parse(const MappedFile &file)
+{
+    Plan plan;
+    if (!file.isValid() || file.size() < 16) return plan;
+
+    const QList<Box> top = children(file.data(), file.size());
+    if (top.isEmpty() || top.first().type != "ftyp") return plan;
+    const Box *meta = nullptr;
+    for (const Box &b : top) if (b.type == "meta") { meta = &b; break; }
+    if (!meta || meta->size < 4) return plan;
+
+    QHash<quint32, Item> items;
+    quint32 primaryId = 0;
+    QHash<quint32, QList<quint32>> dimg;        // grid -> tiles
+    QList<QPair<quint32, QList<quint32>>> thmb; // thumbnail -> the items it stands for
+    QList<quint32> auxOf;                       // items with an auxl (alpha, depth) item
+    QList<Box> properties;
+    QHash<quint32, QList<int>> associations;    // item -> 1-based ipco indexes
+
+    for (const Box &b : children(meta->payload + 4, meta->size - 4)) {
+        int v; quint32 flags;
+        if (b.type == "pitm") {
+            Cursor c = fullBox(b, v, flags);
+            primaryId = v == 0 ? c.u16() : c.u32();
+            if (!c.ok) return plan;
+        }
+        else if (b.type == "iinf") {
+            Cursor c = fullBox(b, v, flags);
+            c.skip(v == 0 ? 2 : 4);
+            if (!c.ok) return plan;
+            for (const Box &e : children(b.payload + c.i, c.left())) {
+                if (e.type != "infe") continue;
+                int ev; quint32 ef;
+                Cursor ec = fullBox(e, ev, ef);
+                if (ev < 2) continue;
+                const quint32 id = ev == 2 ? ec.u16() : ec.u32();
+                ec.skip(2);                             // item_protection_index
+                const QByteArray type = ec.fourcc();
+                if (!ec.ok) continue;
+                items[id].id = id;
+                items[id].type = type;
+            }
+        }
+        else if (b.type == "iloc") {
+            Cursor c = fullBox(b, v, flags);
+            if (v > 2) return plan;
+            const int sizes = int(c.u8());
+            const int offsetSize = sizes >> 4, lengthSize = sizes & 15;
+            const int sizes2 = int(c.u8());
+            const int baseSize = sizes2 >> 4, indexSize = v >= 1 ? sizes2 & 15 : 0;
+            const quint32 count = v < 2 ? c.u16() : c.u32();
+            for (quint32 k = 0; k < count && c.ok; ++k) {
+                const quint32 id = v < 2 ? c.u16() : c.u32();
+                const int construction = v >= 1 ? int(c.u16() & 15) : 0;
+                c.skip(2);                              // data_reference_index
+                const quint64 base = c.u(baseSize);
+                const int extents = int(c.u16());
+                Item &item = items[id];
+                item.id = id;
+                item.construction = construction;
+                item.extents.clear();
+                for (int e = 0; e < extents && c.ok; ++e) {
+                    c.skip(indexSize);
+                    const quint64 off = c.u(offsetSize);
+                    const quint64 len = c.u(lengthSize);
+                    item.extents.append({base + off, len});
+                }
+            }
+            if (!c.ok) return plan;
+        }
+        else if (b.type == "iref") {
+            Cursor c = fullBox(b, v, flags);
+            for (const Box &r : children(b.payload + c.i, c.left())) {
+                Cursor rc(r.payload, r.size);
+                const quint32 from = v == 0 ? rc.u16() : rc.u32();
+                const int n = int(rc.u16());
+                QList<quint32> to;
+                for (int k = 0; k < n && rc.ok; ++k) to << (v == 0 ? rc.u16() : rc.u32());
+                if (!rc.ok) continue;
+                if (r.type == "dimg") dimg[from] = to;
+                else if (r.type == "thmb") thmb.append({from, to});
+                else if (r.type == "auxl") auxOf << to;
+            }
+        }
+        else if (b.type == "iprp") {
+            for (const Box &p : children(b.payload, b.size)) {
+                if (p.type == "ipco") properties = children(p.payload, p.size);
+                else if (p.type == "ipma") {
+                    int pv; quint32 pf;
+                    Cursor c = fullBox(p, pv, pf);
+                    const quint32 n = c.u32();
+                    for (quint32 k = 0; k < n && c.ok; ++k) {
+                        const quint32 id = pv < 1 ? c.u16() : c.u32();
+                        const int count = int(c.u8());
+                        for (int a = 0; a < count && c.ok; ++a) {
+                            const int index = (pf & 1) ? int(c.u16() & 0x7FFF) : int(c.u8() & 0x7F);
+                            if (index) associations[id] << index;
+                        }
+                    }
+                    if (!c.ok) return plan;
+                }
+            }
+        }
+        else if (b.type == "idat") {
+            plan.idat = QByteArray(reinterpret_cast<const char *>(b.payload), int(b.size));
+        }
+    }
+    if (!primaryId || !items.contains(primaryId)) return plan;
+
+    // the properties each item needs
+    for (auto it = associations.constBegin(); it != associations.constEnd(); ++it) {
+        if (!items.contains(it.key())) continue;
+        Item &item = items[it.key()];
+        for (int index : it.value()) {
+            if (index > properties.size()) continue;
+            const Box &p = properties.at(index - 1);
+            if (p.type == "hvcC") {
+                item.hvcC = QByteArray(reinterpret_cast<const char *>(p.payload), int(p.size));
+            }
+            else if (p.type == "ispe") {
+                int v; quint32 f;
+                Cursor c = fullBox(p, v, f);
+                const int w = int(c.u32()), h = int(c.u32());
+                if (c.ok) item.size = QSize(w, h);
+            }
+            else if (p.type == "irot" && p.size >= 1) {
+                item.transforms.append({Transform::Rotate, p.payload[0] & 3});
+            }
+            else if (p.type == "imir" && p.size >= 1) {
+                item.transforms.append({Transform::Mirror, p.payload[0] & 1});
+            }
+            else if (p.type == "clap") {
+                item.hasClap = true;
+            }
+        }
+    }
+    for (quint32 id : auxOf) if (items.contains(id)) items[id].hasAlpha = true;
+
+    plan.primary = items.value(primaryId);
+    for (const auto &t : thmb) {
+        if (t.second.contains(primaryId) && items.contains(t.first)) {
+            plan.thumb = items.value(t.first);
+            break;
+        }
+    }
+
+    if (plan.primary.type == "grid") {
+        const QByteArray g = itemData(file, plan, plan.primary);
+        Cursor c(reinterpret_cast<const uchar *>(g.constData()), g.size());
+        c.skip(1);                                      // version
+        const int large = int(c.u8()) & 1;
+        plan.rows = int(c.u8()) + 1;
+        plan.columns = int(c.u8()) + 1;
+        const int w = int(c.u(large ? 4 : 2)), h = int(c.u(large ? 4 : 2));
+        if (!c.ok) return plan;
+        plan.output = QSize(w, h);
+        for (quint32 id : dimg.value(primaryId)) plan.tiles.append(items.value(id));
+    }
+    plan.ok = true;
+    return plan;
+}
+
+QByteArray HeicGrid::itemData(const MappedFile &file, const Plan &plan, const Item &item)
+{
+    QByteArray data;
+    for (const Extent &e : item.extents) {
+        if (item.construction == 0) {
+            const qint64 len = e.length ? qint64(e.length) : file.available(qint64(e.offset));
+            const uchar *p = file.at(qint64(e.offset), len);
+            if (!p || len > 0x7FFFFFFF - data.size()) return QByteArray();
+            data.append(reinterpret_cast<const char *>(p), int(len));
+        }
+        else if (item.construction == 1) {
+            const qint64 len = e.length ? qint64(e.length) : plan.idat.size() - qint64(e.offset);
+            if (qint64(e.offset) + len > plan.idat.size() || len < 0) return QByteArray();
+            data.append(plan.idat.mid(int(e.offset), int(len)));
+        }
+        else return QByteArray();
+    }
+    return data;
+}
+
+bool HeicGrid::hvcCNals(const QByteArray &hvcC, QList<QByteArray> &nals, int &lengthSize)
+{
+    Cursor c(reinterpret_cast<const uchar *>(hvcC.constData()), hvcC.size());
+    c.skip(21);
+    lengthSize = int(c.u8() & 3) + 1;
+    const int arrays = int(c.u8());
+    for (int a = 0; a < arrays && c.ok; ++a) {
+        c.skip(1);                                      // completeness, NAL unit type
+        const int n = int(c.u16());
+        for (int k = 0; k < n && c.ok; ++k) {
+            const int len = int(c.u16());
+            if (!c.need(len)) break;
+            nals.append(QByteArray(reinterpret_cast<const char *>(c.p + c.i), len));
+            c.i += len;
+        }
+    }
+    return c.ok && lengthSize != 3;
+}
+
+bool HeicGrid::splitNals(const QByteArray &data, int lengthSize, QList<QByteArray> &nals)
+{
+    Cursor c(reinterpret_cast<const uchar *>(data.constData()), data.size());
+    while (c.left() > 0) {
+        const qint64 len = qint64(c.u(lengthSize));
+        if (!c.need(len)) return false;
+        nals.append(QByteArray(reinterpret_cast<const char *>(c.p + c.i), int(len)));
+        c.i += len;
+    }
+    return c.ok && !nals.isEmpty();
+}
+
+void HeicGrid::yuv420ToRgb888(const uchar *y, int yStride, const uchar *cb, int cbStride,
+                              const uchar *cr, int crStride, int w, int h,
+                              const Rgb888 &dst, int x0, int y0)
+{
+    const int cw = qMin(w, dst.width - x0);
+    const int ch = qMin(h, dst.height - y0);
+    if (!dst.bits || cw <= 0 || ch <= 0 || x0 < 0 || y0 < 0) return;
+    for (int row = 0; row < ch; ++row) {
+        const uchar *py = y + row * yStride;
+        const uchar *pcb = cb + (row >> 1) * cbStride;
+        const uchar *pcr = cr + (row >> 1) * crStride;
+        uchar *out = dst.bits + (y0 + row) * dst.bytesPerLine + 3 * x0;
+        for (int x = 0; x < cw; ++x) {
+            const int yv = py[x];
+            const int u = pcb[x >> 1] - 128;
+            const int v = pcr[x >> 1] - 128;
+            out[0] = clip(yv + ((359 * v) >> 8));
+            out[1] = clip(yv - ((88 * u + 183 * v) >> 8));
+            out[2] = clip(yv + ((454 * u) >> 8));
+            out += 3;
+        }
+    }
+}
+
+QImage HeicGrid::transformed(const QImage &image, const QVector<Transform> &transforms)
+{
+    QImage out = image;
+    for (const Transform &t : transforms) {
+        if (t.kind == Transform::Rotate) {
+            if (!t.value) continue;
+            // irot turns counter-clockwise; QTransform::rotate is clockwise on screen
+            out = out.transformed(QTransform().rotate(-90 * t.value));
+        }
+        else {
+            // axis 0 is the vertical axis: left and right swap
+            out = t.value == 0 ? out.mirrored(true, false) : out.mirrored(false, true);
+        }
+    }
+    return out;
+}
+
+QString HeicGrid::report()
+{
+    const int grids = stats.gridDecodes.load();
+    const int thumbs = stats.thumbDecodes.load();
+    QString s = "HEIC grid decodes: " + QString::number(grids);
+    if (grids) {
+        s += "  avg " + QString::number(stats.gridNs.load() / grids / 1000000) + " ms"
+             + "  last " + QString::number(stats.lastGridNs.load() / 1000000) + " ms"
+             + " (" + QString::number(stats.lastTiles.load()) + " tiles on "
+             + QString::number(stats.lastThreads.load()) + " threads)";
+    }
+    s += "  thmb decodes: " + QString::number(thumbs);
+    if (thumbs) s += "  avg " + QString::number(stats.thumbNs.load() / thumbs / 1000000.0, 'f', 1) + " ms";
+    s += "  libheif fallbacks: " + QString::number(stats.fallbacks.load());
+    return s;
+}
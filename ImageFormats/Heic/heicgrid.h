@@ -0,0 +1,126 @@
+#ifndef HEICGRID_H
+#define HEICGRID_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "ImageFormats/Raw/mappedfile.h"
+
+/*
+    The item structure of a HEIF file, read straight from its boxes, for the tile-parallel
+    grid decode in Heic::decodePrimaryImage and the thumbnail decode in
+    Heic::decodeThumbnail.
+
+    An iPhone 48 MP HEIC is a grid item of 512 x 512 HEVC tiles, each tile its own
+    coded picture. libheif 1.5.1 decodes them one after another inside
+    heif_decode_image and has no API to reach a single tile, so the decode of one image
+    used one core. parse() finds what libheif would: the primary item, the grid layout
+    (rows, columns, output size), every tile's extents and HEVC configuration, the
+    thumbnail item that references the primary, and the irot / imir transformations.
+    Heic then decodes the tiles concurrently with libde265 and writes each one straight
+    into its place in the destination QImage.
+
+    Only what this decode handles is reported as usable (Plan::gridOk / thumbOk): hvc1
+    tiles, no clean aperture crop, no alpha plane. Anything else goes through libheif as
+    before.
+
+    Everything here is Qt Core only -- the libde265 calls are in heic.cpp (Windows, where
+    libde265 is linked) -- so tst_heicgrid can check it on a built file.
+*/
+class HeicGrid
+{
+public:
+    struct Extent {
+        quint64 offset = 0;
+        quint64 length = 0;
+    };
+
+    // an irot or imir property, in the order the item lists them
+    struct Transform {
+        enum Kind { Rotate, Mirror } kind = Rotate;
+        int value = 0;          // irot: quarter turns counter-clockwise; imir: axis
+    };
+
+    struct Item {
+        quint32 id = 0;
+        QByteArray type;        // "hvc1", "grid", "Exif" ...
+        int construction = 0;   // iloc construction method: 0 file offset, 1 idat
+        QVector<Extent> extents;
+        QByteArray hvcC;        // HEVC decoder configuration record payload
+        QSize size;             // ispe
+        QVector<Transform> transforms;
+        bool hasClap = false;
+        bool hasAlpha = false;  // an auxl item (alpha or depth) references this one
+    };
+
+    struct Plan {
+        bool ok = false;        // the boxes parsed
+        Item primary;
+        int rows = 0;           // grid only
+        int columns = 0;
+        QSize output;           // grid output size
+        QVector<Item> tiles;    // dimg references of the grid, in raster order
+        Item thumb;             // id 0 when there is none
+        QByteArray idat;
+
+        bool gridOk() const;
+        bool thumbOk() const;
+    };
+
+    static Plan parse(const MappedFile &file);
+
+    /* The bytes of an item: its extents concatenated, from the file or the idat. */
+    static QByteArray itemData(const MappedFile &file, const Plan &plan, const Item &item);
+
+    /* The parameter sets (VPS, SPS, PPS ...) of an hvcC record, each NAL without a start
+       code, and the length-field size of the NAL units in the item data. */
+    static bool hvcCNals(const QByteArray &hvcC, QList<QByteArray> &nals, int &lengthSize);
+
+    /* Split item data into NAL units (no length prefix). */
+    static bool splitNals(const QByteArray &data, int lengthSize, QList<QByteArray> &nals);
+
+    /* An RGB888 destination's pixels, taken once on the thread that owns the QImage.
+       scanLine() and bits() may detach the image, so tile workers only ever see these. */
+    struct Rgb888 {
+        uchar *bits = nullptr;
+        qsizetype bytesPerLine = 0;
+        int width = 0;
+        int height = 0;
+
+        Rgb888() = default;
+        explicit Rgb888(QImage &image)
+            : bits(image.bits()), bytesPerLine(image.bytesPerLine()),
+              width(image.width()), height(image.height()) {}
+    };
+
+    /* One 8-bit 4:2:0 YCbCr picture to RGB888 into dst at (x0, y0), clipped to dst.
+       The same fixed-point full-range BT.601 conversion, with the chroma sample repeated
+       over its 2 x 2 pixels, that libheif 1.5.1 applies, so a tile-parallel decode gives
+       the pixels heif_decode_image did. */
+    static void yuv420ToRgb888(const uchar *y, int yStride, const uchar *cb, int cbStride,
+                               const uchar *cr, int crStride, int w, int h,
+                               const Rgb888 &dst, int x0, int y0);
+
+    /* Apply an item's transforms in order. */
+    static QImage transformed(const QImage &image, const QVector<Transform> &transforms);
+
+    /* Decode timing for ImageCache::reportCacheDecoders. */
+    struct Stats {
+        std::atomic<int> gridDecodes{0};
+        std::atomic<qint64> gridNs{0};
+        std::atomic<int> lastTiles{0};
+        std::atomic<int> lastThreads{0};
+        std::atomic<qint64> lastGridNs{0};
+        std::atomic<int> thumbDecodes{0};
+        std::atomic<qint64> thumbNs{0};
+        std::atomic<int> fallbacks{0};     // decodes left to libheif
+    };
+    static Stats stats;
+    static QString report();
+};
+
+#endif // HEICGRID_H
@@ -1,9 +1,55 @@
 #include "jpegturbo.h"
 #include "Main/global.h"
 
+namespace {
+
+/*
+    One decompressor per thread, created on the thread's first decode and destroyed when the
+    thread exits. A tjhandle must not be shared between threads, and creating one allocates
+    the whole libjpeg decompress state, which was being done for every image.
+*/
+struct Decompressor
+{
+    tjhandle handle = tjInitDecompress();
+    ~Decompressor() { if (handle) tjDestroy(handle); }
+};
+
+tjhandle threadDecompressor()
+{
+    thread_local Decompressor d;
+    return d.handle;
+}
+
+/* QImage::Format_ARGB32 is 0xAARRGGBB per pixel in host order. turbojpeg sets the alpha
+   byte to 0xFF. */
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+const int argb32PixelFormat = TJPF_BGRA;
+#else
+const int argb32PixelFormat = TJPF_ARGB;
+#endif
+
+/* Smallest 1/1, 1/2, 1/4 or 1/8 scaling of width x height whose long side still reaches
+   longSide (full size when longSide <= 0). */
+QSize scaledSize(int width, int height, int longSide)
+{
+    QSize best(width, height);
+    if (longSide <= 0) return best;
+    int n = 0;
+    const tjscalingfactor *sf = tjGetScalingFactors(&n);
+    for (int i = 0; sf && i < n; ++i) {
+        if (sf[i].num != 1 || sf[i].denom > 8) continue;
+        const int w = TJSCALED(width, sf[i]);
+        const int h = TJSCALED(height, sf[i]);
+        if (qMax(w, h) >= longSide && w * h < best.width() * best.height()) best = QSize(w, h);
+    }
+    return best;
+}
+
+} // namespace
+
 JpegTurbo::JpegTurbo() {}
 
-QImage JpegTurbo::decode(QString &fPath)
+QImage JpegTurbo::decode(QString &fPath, int longSide, QSize *fullSize)
 {
 /*
     libjpeg-turbo library
@@ -19,16 +65,16 @@ QImage JpegTurbo::decode(QString &fPath)
     QByteArray ba = file.readAll();
     file.close();
 
-    return decode(ba);
+    return decode(ba, longSide, fullSize);
 }
 
-QImage JpegTurbo::decode(QByteArray &ba)
+QImage JpegTurbo::decode(QByteArray &ba, int longSide, QSize *fullSize)
 {
     /*
     libjpeg-turbo library
 */
-    // Initialize TurboJPEG decompressor
-    tjhandle tjInstance = tjInitDecompress();
+    // This thread's TurboJPEG decompressor
+    tjhandle tjInstance = threadDecompressor();
     if (!tjInstance) {
         QString msg = "Failed to initialize TurboJPEG: " + QString(tjGetErrorStr());
         G::issue("Warning", msg, "JpegTurbo::decode(fPath)", -1);
@@ -39,50 +85,38 @@ QImage JpegTurbo::decode(QByteArray &ba)
     int width, height, jpegSubsamp, jpegColorspace;
     if (tjDecompressHeader3(tjInstance, (unsigned char*)ba.data(), ba.size(),
                             &width, &height, &jpegSubsamp, &jpegColorspace) != 0) {
-        QString msg = "Failed to read JPEG header: " + QString(tjGetErrorStr());
+        QString msg = "Failed to read JPEG header: " + QString(tjGetErrorStr2(tjInstance));
         G::issue("Warning", msg, "JpegTurbo::decode(fPath)", -1);
-        tjDestroy(tjInstance);
         return QImage();
     }
+    if (fullSize) *fullSize = QSize(width, height);
 
-    // Allocate memory for the decompressed image
-    int pixelFormat = TJPF_RGB;
-    int pitch = width * tjPixelSize[pixelFormat];
-    unsigned char* imgBuffer = (unsigned char*)tjAlloc(pitch * height);
-    if (!imgBuffer) {
+    // Allocate the destination at the decode (possibly DCT-scaled) size
+    const QSize size = scaledSize(width, height, longSide);
+    QImage image(size, QImage::Format_ARGB32);
+    if (image.isNull()) {
         QString msg = "Failed to allocate memory for decompressed image.";
         G::issue("Warning", msg, "JpegTurbo::decode(fPath)", -1);
-        tjDestroy(tjInstance);
         return QImage();
     }
 
     /*
-    qDebug() << "JpegTurbo::decode1(QString)"
+    qDebug() << "JpegTurbo::decode(QByteArray)"
              << "width = " << width
              << "height =" << height
-             << "pitch =" << pitch
+             << "scaled =" << size
              << "jpegSubsamp = " << jpegSubsamp
              << "jpegColorspace = " << jpegColorspace
         ; //*/
 
-    // Decompress the JPEG image
-    if (tjDecompress2(tjInstance, (unsigned char*)ba.data(), ba.size(), imgBuffer,
-                      width, pitch, height, pixelFormat, 0) != 0) {
-        QString msg = "Failed to decompress JPEG image: " + QString(tjGetErrorStr());
+    // Decompress straight into the QImage scanlines
+    if (tjDecompress2(tjInstance, (unsigned char*)ba.data(), ba.size(), image.bits(),
+                      size.width(), int(image.bytesPerLine()), size.height(),
+                      argb32PixelFormat, 0) != 0) {
+        QString msg = "Failed to decompress JPEG image: " + QString(tjGetErrorStr2(tjInstance));
         G::issue("Warning", msg, "JpegTurbo::decode(fPath)", -1);
-        tjFree(imgBuffer);
-        tjDestroy(tjInstance);
         return QImage();
     }
 
-    // Create QImage from the decompressed data
-    QImage img(imgBuffer, width, height, pitch, QImage::Format_RGB888);
-    QImage finalImage = img.copy(); // Make a deep copy to take ownership of the buffer
-    finalImage.convertTo(QImage::Format_ARGB32);
-
-    // Cleanup
-    tjFree(imgBuffer);
-    tjDestroy(tjInstance);
-
-    return finalImage;
+    return image;
 }
@@ -18,13 +18,23 @@
     https://libjpeg-turbo.org/
 */
 
+/*
+    decode() returns a Format_ARGB32 image, decoded straight into the QImage scanlines by a
+    decompressor handle that each thread creates once and keeps (the thread pool and the
+    decoder threads are long-lived, so a handle is no longer set up and torn down per image).
+
+    longSide > 0 asks only for an image whose long side is at least longSide: the largest
+    libjpeg-turbo scaling factor (1/2, 1/4 or 1/8) that still covers it runs the IDCT, upsampling
+    and colour conversion at that size. The caller scales the result the rest of the way.
+    fullSize, when given, is set to the JPEG's own dimensions.
+*/
 class JpegTurbo : public QObject
 {
     Q_OBJECT
 public:
     JpegTurbo();
-    QImage decode(QString &fPath);
-    QImage decode(QByteArray &ba);
+    QImage decode(QString &fPath, int longSide = 0, QSize *fullSize = nullptr);
+    QImage decode(QByteArray &ba, int longSide = 0, QSize *fullSize = nullptr);
 };
 
 #endif // JPEGTURBO_H
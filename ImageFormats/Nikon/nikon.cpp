@@ -4,6 +4,7 @@
 #include "Metadata/ExifTool.h"  // req'd for some Nikon lenses not in lookup
 #include "ImageFormats/Raw/tiffwalk.h"
 #include "ImageFormats/Raw/rawimage.h"
+#include "ImageFormats/Raw/rawunpack.h"
 #include "ImageFormats/Raw/cameramatrix.h"
 
 // ExifTool documentation: https://exiftool.org/TagNames/Nikon.html
@@ -1072,59 +1073,10 @@ bool Nikon::parse(MetadataParameters &p,
 /* ------------------------------------------------------------------------------------------
    NikonRaw::UnpackCfa  --  Nikon NEF compressed sensor unpack (Huffman + curve + predictors)
    Ported from dcraw's nikon_load_raw; validated byte-identical to libraw on 12/14-bit lossless.
+   The Huffman/predictor loop itself is RawUnpack::nikon, shared with the other raw unpackers.
    ------------------------------------------------------------------------------------------ */
 
-namespace {
-
-/* dcraw's Nikon Huffman trees: 16 code-length counts followed by the leaf symbols (low nibble =
-   bit length, high nibble = shift for the lossy trees). Index by version/bit-depth. */
-const quint8 kNikonTree[6][32] = {
- {0,1,5,1,1,1,1,1,1,2,0,0,0,0,0,0, 5,4,3,6,2,7,1,0,8,9,11,10,12,0,0,0},
- {0,1,5,1,1,1,1,1,1,2,0,0,0,0,0,0, 0x39,0x5a,0x38,0x27,0x16,5,4,3,2,1,0,11,12,12,0,0},
- {0,1,4,2,3,1,2,0,0,0,0,0,0,0,0,0, 5,4,6,3,7,2,8,1,9,0,10,11,12,0,0,0},
- {0,1,4,3,1,1,1,1,1,2,0,0,0,0,0,0, 5,6,4,7,8,3,9,2,1,0,10,11,12,13,14,0},
- {0,1,5,1,1,1,1,1,1,1,2,0,0,0,0,0, 8,0x5c,0x4b,0x3a,0x29,7,6,5,4,3,2,1,0,13,14,0},
- {0,1,4,2,2,3,1,2,0,0,0,0,0,0,0,0, 7,6,8,5,9,4,10,3,11,12,2,0,1,13,14,0},
-};
-
-struct NHuff {
-    int mincode[17];
-    int maxcode[17];
-    int valptr[17];
-    quint8 sym[16];
-    void build(const quint8 *tree) {
-        int counts[16], nsym = 0;
-        for (int i = 0; i < 16; ++i) { counts[i] = tree[i]; nsym += counts[i]; }
-        for (int i = 0; i < nsym && i < 16; ++i) sym[i] = tree[16 + i];
-        int code = 0, j = 0;
-        for (int l = 1; l <= 16; ++l) {
-            if (counts[l - 1]) {
-                valptr[l] = j; mincode[l] = code; code += counts[l - 1];
-                maxcode[l] = code - 1; j += counts[l - 1];
-            } else maxcode[l] = -1;
-            code <<= 1;
-        }
-    }
-};
-
-/* Plain MSB-first bit reader over the raw data (Nikon raw has no byte stuffing). */
-struct NBits {
-    const uchar *d; qint64 size, pos; quint32 buf = 0; int cnt = 0;
-    int bit() {
-        if (cnt == 0) { buf = (pos < size) ? d[pos] : 0; ++pos; cnt = 8; }
-        --cnt; return (buf >> cnt) & 1;
-    }
-    quint32 bits(int n) { quint32 v = 0; while (n-- > 0) v = (v << 1) | bit(); return v; }
-    int huff(const NHuff &h) {
-        int l = 1, code = bit();
-        while (l <= 16 && code > h.maxcode[l]) { ++l; code = (code << 1) | bit(); }
-        return l <= 16 ? h.sym[h.valptr[l] + code - h.mincode[l]] : 0;
-    }
-};
-
-} // namespace
-
-bool NikonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool NikonRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
     Q_UNUSED(m)
     using namespace TiffWalk;
@@ -1164,6 +1116,10 @@ bool NikonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     const int bps = rawIfd.contains(258) ? int(r.scalar(rawIfd[258])) : 14;
     const quint32 dataOff = r.scalar(rawIfd[273]);
     if (W <= 0 || H <= 0 || (bps != 12 && bps != 14)) { errMsg = "NEF: bad CFA geometry/bps."; return false; }
+    const qint64 dataLen = file.available(dataOff);
+    if (dataLen <= 0) { errMsg = "NEF: raw data offset past end of file."; return false; }
+    /* Start paging the compressed data in while the MakerNote is parsed. */
+    file.willNeed(dataOff, dataLen);
 
     /* Navigate the Nikon type-3 MakerNote: IFD0 -> ExifIFD (0x8769) -> MakerNote (0x927C).
        Its data is "Nikon\0" + 2 version bytes + "\0\0" + an embedded TIFF whose offsets are
@@ -1183,8 +1139,7 @@ bool NikonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
 
     /* The 0x96 linearization/Huffman metadata. Read enough to cover the optional curve+split. */
     const quint32 metaAbs = mnBase + mr.ifdPointer(mn[0x96]);
-    if (!file.seek(metaAbs)) { errMsg = "NEF: seek to 0x96 failed."; return false; }
-    const QByteArray meta = file.read(2048);
+    const QByteArray meta = file.read(metaAbs, 2048);
     if (meta.size() < 14) { errMsg = "NEF: short 0x96."; return false; }
     const bool mbig = mr.big();
     auto mg16 = [&](int o) -> int {
@@ -1222,35 +1177,18 @@ bool NikonRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     }
     while (maxv > 1 && curve[maxv - 2] == curve[maxv - 1]) --maxv;
 
-    /* Read the compressed raw data and decode. */
-    if (!file.seek(dataOff)) { errMsg = "NEF: seek to raw data failed."; return false; }
-    const QByteArray data = file.readAll();
-    NBits br{ reinterpret_cast<const uchar *>(data.constData()), data.size(), 0 };
-
-    NHuff h; h.build(kNikonTree[huff]);
+    /* Decode the compressed raw data in place from the mapping. */
+    RawUnpack::NikonParams np;
+    np.tree = huff;
+    np.split = split;
+    for (int i = 0; i < 4; ++i) np.vpred[i >> 1][i & 1] = vpred[i >> 1][i & 1];
+    np.curve = curve.data();
 
     raw.width = W;
     raw.height = H;
     raw.cfa.assign(size_t(W) * size_t(H), 0);
-    int hpred[2] = { 0, 0 };
-    uint16_t lo = 0xFFFF;                                // running min for the black estimate
-
-    for (int row = 0; row < H; ++row) {
-        if (split && row == split) { h.build(kNikonTree[huff + 1]); maxv += 16 << 1; }
-        for (int col = 0; col < W; ++col) {
-            const int i = br.huff(h);
-            const int len = i & 15, shl = i >> 4;
-            int diff = ((int(br.bits(len - shl)) << 1) + 1) << shl >> 1;
-            if (len > 0 && (diff & (1 << (len - 1))) == 0) diff -= (1 << len) - (shl ? 0 : 1);
-            if ((col & ~1) == 0) { vpred[row & 1][col] += diff; hpred[col] = vpred[row & 1][col]; }
-            else                   hpred[col & 1] += diff;
-            int val = hpred[col & 1];
-            if (val < 0) val = 0;
-            const uint16_t out = uint16_t(curve[val & 0x3FFF]);
-            raw.cfa[size_t(row) * W + col] = out;
-            if (out < lo) lo = out;
-        }
-    }
+    uint16_t lo = 0xFFFF;                                // frame min for the black estimate
+    RawUnpack::nikon(file.data() + dataOff, size_t(dataLen), W, H, np, raw.cfa.data(), lo);
 
     /* CFA phase. Most Nikon bodies are RGGB, but older sensors start the active area on a
        different Bayer phase (D100 is GRBG, D2H is GBRG); decoding those as RGGB swaps the
@@ -46,7 +46,7 @@ private:
 class OlympusRaw : public RawFormat
 {
 protected:
-    bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) override;
+    bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) override;
 };
 
 #endif // OLYMPUS_H
@@ -2,8 +2,8 @@
 #include "Main/global.h"
 #include "ImageFormats/Raw/tiffwalk.h"
 #include "ImageFormats/Raw/rawimage.h"
+#include "ImageFormats/Raw/rawunpack.h"
 #include "ImageFormats/Raw/cameramatrix.h"
-#include <vector>
 
 Panasonic::Panasonic()
 {
@@ -368,9 +368,10 @@ bool Panasonic::parse(MetadataParameters &p,
 /* ------------------------------------------------------------------------------------------
    PanasonicRaw::UnpackCfa  --  Panasonic RW2 (RawFormat 4) decode
    Ported from dcraw's panasonic_load_raw / pana_bits; validated byte-identical to libraw (GX9).
+   The bit unpacking itself is RawUnpack::panasonic.
    ------------------------------------------------------------------------------------------ */
 
-bool PanasonicRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool PanasonicRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
     Q_UNUSED(m)
     using namespace TiffWalk;
@@ -391,54 +392,15 @@ bool PanasonicRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     if (rawFormat != 4) { errMsg = "RW2: RawFormat != 4 (newer compression unsupported)."; return false; }
     const int loadFlags = 0x2008;                       // RawFormat 4
 
-    if (!file.seek(strip)) { errMsg = "RW2: seek to raw data failed."; return false; }
-    const QByteArray data = file.readAll();
-    const uchar *dp = reinterpret_cast<const uchar *>(data.constData());
-    const qint64 dn = data.size();
-
-    /* Panasonic "pana_bits": bits come from a reversed 0x4000-byte buffer, refilled (rotated by
-       loadFlags) each time it empties. */
-    std::vector<uchar> buf(0x4000, 0);
-    qint64 fp = 0; int vbits = 0;
-    auto pana = [&](int nbits) -> int {
-        if (nbits == 0) { vbits = 0; return 0; }
-        if (vbits == 0) {
-            for (int i = 0; i < 0x4000 - loadFlags; ++i)
-                buf[loadFlags + i] = (fp + i < dn) ? dp[fp + i] : 0;
-            for (int i = 0; i < loadFlags; ++i) {
-                const qint64 src = fp + 0x4000 - loadFlags + i;
-                buf[i] = (src < dn) ? dp[src] : 0;
-            }
-            fp += 0x4000;
-        }
-        vbits = (vbits - nbits) & 0x1ffff;
-        const int byte = (vbits >> 3) ^ 0x3ff0;
-        const int b = buf[byte] | (buf[byte + 1] << 8);
-        return (b >> (vbits & 7)) & ((1 << nbits) - 1);
-    };
+    const qint64 dn = file.available(strip);
+    if (dn <= 0) { errMsg = "RW2: raw data offset past end of file."; return false; }
+    const uchar *dp = file.data() + strip;
+    file.willNeed(strip, dn);
 
     raw.width = W;
     raw.height = H;
     raw.cfa.assign(size_t(W) * size_t(H), 0);
-    for (int row = 0; row < H; ++row) {
-        int pred[2] = {0, 0}, nonz[2] = {0, 0}, sh = 0;
-        for (int col = 0; col < W; ++col) {
-            const int i = col % 14;
-            if (i == 0) { pred[0] = pred[1] = 0; nonz[0] = nonz[1] = 0; }
-            if (i % 3 == 2) sh = 4 >> (3 - pana(2));
-            if (nonz[i & 1]) {
-                const int j = pana(8);
-                if (j) {
-                    pred[i & 1] -= 0x80 << sh;
-                    if (pred[i & 1] < 0 || sh == 4) pred[i & 1] &= (1 << sh) - 1;
-                    pred[i & 1] += j << sh;
-                }
-            } else if ((nonz[i & 1] = pana(8)) || i > 11) {
-                pred[i & 1] = (nonz[i & 1] << 4) | pana(4);
-            }
-            raw.cfa[size_t(row) * W + col] = uint16_t(pred[i & 1] & 0xffff);
-        }
-    }
+    RawUnpack::panasonic(dp, size_t(dn), W, H, loadFlags, raw.cfa.data());
 
     /* Pattern (tag 0x09: 1=RGGB 2=GRBG 3=GBRG 4=BGGR), levels, WB, matrix. */
     switch (t.contains(0x09) ? int(r.scalar(t[0x09])) : 4) {
@@ -0,0 +1,229 @@
+#ifndef BITREADER_H
+#define BITREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+/*
+    The bit-reading core shared by the proprietary raw unpackers in RawUnpack (Nikon NEF
+    Huffman, Olympus ORF, Panasonic RW2, Sony ARW2).
+
+    Each of them used to carry its own loop: Nikon read one bit per call and walked its
+    Huffman tree a bit at a time, Olympus refilled a byte at a time, Panasonic rebuilt its
+    0x4000-byte buffer with a bounds check per byte, and Sony assembled every 7-bit field
+    from two bytes. Here:
+
+      loadLe32/64   unaligned word loads (loadBe64 byte-swapped); Sony's fixed-layout
+                    blocks need nothing more.
+      Msb           a 64-bit cache refilled with one 8-byte big-endian load while 8 bytes
+                    remain, a byte at a time near the end, and zero bits past it -- what
+                    every one of the old readers returned at the end of the data. After
+                    fill() at least 56 bits are cached; peek(), skip() and get() are
+                    branch-free for 0 <= n <= 32.
+      Huffman       a canonical table built from the 16 code-length counts and the symbols
+                    (the dcraw / JPEG layout) with a kLutBits lookup on the next bits giving
+                    the code length and symbol -- and, for Nikon's difference codes, the
+                    decoded difference as well, so the common sample is one lookup and one
+                    shift. Codes longer than kLutBits take the canonical search.
+
+    The same scheme as LosslessJpeg's entropy decoder, minus its 0xFF00 unstuffing, which
+    none of these formats use. Header-only so the hot calls inline into the unpackers.
+*/
+namespace RawBits {
+
+/* Unaligned loads. Every platform Winnow builds for is little-endian. */
+inline uint64_t loadLe64(const uint8_t *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint32_t loadLe32(const uint8_t *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t loadBe64(const uint8_t *p)
+{
+#if defined(_MSC_VER)
+    return _byteswap_uint64(loadLe64(p));
+#else
+    return __builtin_bswap64(loadLe64(p));
+#endif
+}
+
+/* MSB first: the next bit is the top bit of cache. The bits below the cnt valid ones are
+   the stream's next bits or zero, so a refill ORs the same values over them. */
+struct Msb {
+    const uint8_t *d;
+    size_t size;
+    size_t pos = 0;         // next byte to load
+    uint64_t cache = 0;
+    int cnt = 0;
+
+    Msb(const uint8_t *data, size_t n) : d(data), size(n) {}
+
+    void fill()
+    {
+        if (pos + 8 <= size) {
+            cache |= loadBe64(d + pos) >> cnt;
+            pos += size_t(63 - cnt) >> 3;
+            cnt |= 56;
+            return;
+        }
+        while (cnt <= 56) {
+            const uint64_t b = pos < size ? d[pos] : 0;
+            ++pos;
+            cache |= b << (56 - cnt);
+            cnt += 8;
+        }
+    }
+    /* Split so that no shift is by 64: n == 0 shifts the zeroed top bit of (cache >> 1)
+       down and returns 0, n == 32 shifts by 31. */
+    uint32_t peek(int n) const { return uint32_t((cache >> 1) >> (63 - n)); }
+    void skip(int n) { cache <<= n; cnt -= n; }
+    uint32_t get(int n)
+    {
+        if (cnt < n) fill();
+        const uint32_t v = peek(n);
+        skip(n);
+        return v;
+    }
+    /* Bits consumed since the start of the data. */
+    size_t consumed() const { return pos * 8 - size_t(cnt); }
+};
+
+/*
+    Canonical Huffman decoding over an Msb reader.
+
+    Values::Symbol      decode() returns the symbol.
+    Values::NikonDiff   the symbol is Nikon's (length | shift << 4) and diff() returns the
+                        signed difference its bits encode (dcraw's nikon_load_raw formula;
+                        with shift 0 it is the JPEG "receive and extend").
+*/
+class Huffman
+{
+public:
+    static constexpr int kLutBits = 12;
+    enum class Values { Symbol, NikonDiff };
+
+    void build(const uint8_t counts[16], const uint8_t *symbols, Values values = Values::Symbol)
+    {
+        nsym = 0;
+        for (int l = 0; l < 16; ++l) nsym += counts[l];
+        if (nsym > 256) nsym = 256;
+        for (int i = 0; i < nsym; ++i) vals[i] = symbols[i];
+        for (Entry &e : lut) e = Entry{0, 0, 0};
+        mode = values;
+        int code = 0, j = 0;
+        for (int l = 1; l <= 16; ++l) {
+            const int n = counts[l - 1];
+            if (n && j + n <= nsym) {
+                valptr[l] = j;
+                mincode[l] = code;
+                if (l <= kLutBits)
+                    for (int k = 0; k < n; ++k) fill(code + k, l, vals[j + k]);
+                code += n;
+                maxcode[l] = code - 1;
+                j += n;
+            } else {
+                maxcode[l] = -1;
+            }
+            code <<= 1;
+        }
+    }
+
+    /* The next symbol (Values::Symbol tables). */
+    int decode(Msb &br) const
+    {
+        if (br.cnt < 32) br.fill();
+        const Entry e = lut[br.peek(kLutBits)];
+        if (e.len) { br.skip(e.len); return e.sym; }
+        return slowSymbol(br);
+    }
+
+    /* The next difference (Values::NikonDiff tables). */
+    int diff(Msb &br) const
+    {
+        if (br.cnt < 32) br.fill();
+        const Entry e = lut[br.peek(kLutBits)];
+        int sym;
+        if (e.len) {
+            br.skip(e.len);
+            if (e.sym == kFull) return e.value;
+            sym = e.sym;
+        } else {
+            sym = slowSymbol(br);
+        }
+        const int len = sym & 15, shl = sym >> 4;
+        return nikonDiff(int(br.get(len - shl)), len, shl);
+    }
+
+    static int nikonDiff(int bits, int len, int shl)
+    {
+        int d = ((bits << 1) + 1) << shl >> 1;
+        if (len > 0 && (d & (1 << (len - 1))) == 0) d -= (1 << len) - (shl ? 0 : 1);
+        return d;
+    }
+
+private:
+    static constexpr uint8_t kFull = 0xFF;      // Entry::sym of an entry that holds the value
+
+    /* Code length (0: longer than kLutBits) and either the symbol or, when sym == kFull,
+       the decoded difference with len counting the code and its difference bits. */
+    struct Entry {
+        int16_t value;
+        uint8_t len;
+        uint8_t sym;
+    };
+
+    void fill(int code, int l, uint8_t sym)
+    {
+        const int free = kLutBits - l;
+        const int base = code << free;
+        const int len = sym & 15, shl = sym >> 4, n = len - shl;
+        for (int i = 0; i < (1 << free); ++i) {
+            Entry &e = lut[base + i];
+            if (mode == Values::NikonDiff && sym != kFull && n >= 0 && n <= free) {
+                const int bits = (i >> (free - n)) & ((1 << n) - 1);
+                e = Entry{int16_t(nikonDiff(bits, len, shl)), uint8_t(l + n), kFull};
+            } else {
+                e = Entry{0, uint8_t(l), sym};
+            }
+        }
+    }
+
+    /* Codes of kLutBits + 1 .. 16 bits. No such code (corrupt data): 16 bits, symbol 0. */
+    int slowSymbol(Msb &br) const
+    {
+        const int bits16 = int(br.peek(16));
+        for (int l = kLutBits + 1; l <= 16; ++l) {
+            const int code = bits16 >> (16 - l);
+            if (code <= maxcode[l]) {
+                br.skip(l);
+                return vals[valptr[l] + code - mincode[l]];
+            }
+        }
+        br.skip(16);
+        return 0;
+    }
+
+    Entry lut[1 << kLutBits];
+    uint8_t vals[256];
+    int nsym = 0;
+    int mincode[17] = {};
+    int maxcode[17] = {};
+    int valptr[17] = {};
+    Values mode = Values::Symbol;
+};
+
+} // namespace RawBits
+
+#endif // BITREADER_H
@@ -1,40 +1,249 @@
 #include "ImageFormats/Raw/demosaic.h"
+#include "ImageFormats/Raw/rawkernels.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QFuture>
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+/* Per-worker RCD / Markesteijn buffers, sized for one tile plus halo and reused tile
+   after tile. */
+struct Demosaic::Scratch
+{
+    std::vector<float> cfa, lpf, hpfA, hpfB, vhDir, pqDir, rgb[3];
+    /* Markesteijn planes: mosaic, 4 directions x RGB, perceptual l/a/b, 4 derivatives,
+       4 homogeneity maps and a row-sum buffer. */
+    static constexpr int kXTransPlanes = 1 + 12 + 3 + 4 + 4 + 1;
+    std::vector<float> xtrans;
+
+    void ensure(size_t n)
+    {
+        if (cfa.size() >= n) return;
+        for (std::vector<float> *v : {&cfa, &lpf, &hpfA, &hpfB, &vhDir, &pqDir,
+                                      &rgb[0], &rgb[1], &rgb[2]})
+            v->assign(n, 0.0f);
+    }
+
+    float *ensureXTrans(size_t n)
+    {
+        if (xtrans.size() < n * kXTransPlanes) xtrans.assign(n * kXTransPlanes, 0.0f);
+        return xtrans.data();
+    }
+};
+
+/*
+    The X-Trans neighbourhoods Markesteijn interpolates from, derived once per run from
+    raw.xtrans (dcraw's xtrans_interpolate setup). Green sites repeat every 3 photosites,
+    so the tables are indexed by (row % 3, col % 3) and hold (dy, dx) offsets:
+
+      R/B site            the six greens of its hexagon: [0] [1] the horizontal pair,
+                          [3] the near and [2] the far vertical one, [4] [5] the diagonals.
+      green in a 2x2      one (near, far) pair of R/B-bearing sites per direction:
+      block               horizontal, vertical, diagonal, anti-diagonal.
+
+    Each pattern is written for one orientation and rotated to wherever the site's green
+    neighbours actually are. sgRow / sgCol is the phase of the solitary greens (no green
+    4-neighbour). build() is false for a map that is not X-Trans shaped -- greens not on
+    a period-3 lattice of 2x2 blocks and solitary sites -- and Run then falls back to
+    XTransWindow.
+*/
+struct Demosaic::XTransHex
+{
+    int dy[3][3][8] = {};
+    int dx[3][3][8] = {};
+    int sgRow = -1;
+    int sgCol = -1;
+
+    bool build(const uint8_t xtrans[6][6])
+    {
+        static const int orth[12] = {1, 0, 0, 1, -1, 0, 0, -1, 1, 0, 0, 1};
+        static const int patt[2][16] = {
+            {0, 1, 0, -1, 2, 0, -1, 0, 1, 1, 1, -1, 0, 0, 0, 0},
+            {0, 1, 0, -2, 1, 0, -2, 0, 1, 1, -2, -2, 1, -1, -1, 1}
+        };
+        auto green = [xtrans](int r, int c) { return xtrans[(r + 6) % 6][(c + 6) % 6] == 1; };
+
+        for (int r = 0; r < 6; ++r)
+            for (int c = 0; c < 6; ++c)
+                if (green(r, c) != green(r % 3, c % 3)) return false;
+
+        int solitary = 0;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                const int g = green(row, col);
+                bool filled = false;
+                /* Walk the 4-neighbours (down, left, up, right, down again) counting
+                   consecutive non-green ones; the first site of such a run fixes the
+                   rotation of the pattern. */
+                for (int ng = 0, d = 0; d < 10; d += 2) {
+                    ng = green(row + orth[d], col + orth[d + 2]) ? 0 : ng + 1;
+                    if (ng == 4) {
+                        sgRow = row;
+                        sgCol = col;
+                        ++solitary;
+                    }
+                    if (ng != g + 1) continue;
+                    filled = true;
+                    for (int c = 0; c < 8; ++c) {
+                        const int k = c ^ (g * 2 & d);
+                        dy[row][col][k] = orth[d] * patt[g][c * 2] + orth[d + 1] * patt[g][c * 2 + 1];
+                        dx[row][col][k] = orth[d + 2] * patt[g][c * 2] + orth[d + 3] * patt[g][c * 2 + 1];
+                    }
+                }
+                if (!filled) return false;
+            }
+        }
+        if (solitary != 1) return false;
+        for (int row = 0; row < 3; ++row)
+            for (int col = 0; col < 3; ++col)
+                if (green(row, col) != ((row == sgRow) == (col == sgCol))) return false;
+        return true;
+    }
+};
 
 bool Demosaic::Run(const RawImage &raw, std::vector<float> &rgb, Algorithm algo,
                    const QAtomicInt *abort, const std::function<void(int, int)> &progress)
 {
     if (!raw.isValid()) return false;
-    if (raw.pattern == CfaPattern::XTrans) return XTransWindow(raw, rgb, abort, progress);
     if (raw.pattern == CfaPattern::Unknown) return false;
 
-    switch (algo) {
-    case Bilinear: return Bilinear3x3(raw, rgb, abort, progress);
+    const int W = raw.width;
+    const int H = raw.height;
+    /* Every tile writes every one of its pixels, so a buffer of the right size is reused
+       as is: re-zeroing 45 MP x 3 floats single-threaded costs more than the demosaic. */
+    const size_t n = static_cast<size_t>(W) * static_cast<size_t>(H) * 3;
+    if (rgb.size() != n) rgb.assign(n, 0.0f);
+    float *out = rgb.data();
+
+    /* RCD and Markesteijn fill their halo from inside the sensor, which needs the sensor
+       to be wider than the halo; anything that small is a thumbnail-sized test mosaic,
+       so the same-colour average. */
+    const bool quality = algo != Bilinear && W > 2 * kHalo && H > 2 * kHalo;
+
+    if (raw.pattern == CfaPattern::XTrans) {
+        XTransHex hex;
+        if (quality && hex.build(raw.xtrans)) {
+            return ForEachTile(W, H, abort, progress, [&raw, &hex, out](const Tile &t, Scratch &s) {
+                MarkesteijnTile(raw, hex, out, t, s);
+            });
+        }
+        return ForEachTile(W, H, abort, progress, [&raw, out](const Tile &t, Scratch &) {
+            XTransWindow(raw, out, t);
+        });
+    }
+
+    if (quality) {
+        return ForEachTile(W, H, abort, progress, [&raw, out](const Tile &t, Scratch &s) {
+            RcdTile(raw, out, t, s);
+        });
     }
-    return false;
+    return ForEachTile(W, H, abort, progress, [&raw, out](const Tile &t, Scratch &) {
+        Bilinear3x3(raw, out, t);
+    });
+}
+
+bool Demosaic::RunHalfSize(const RawImage &raw, std::vector<float> &rgb,
+                           int &outW, int &outH, const QAtomicInt *abort)
+{
+    if (!raw.isValid()) return false;
+    if (raw.pattern == CfaPattern::Unknown || raw.pattern == CfaPattern::XTrans) return false;
+
+    const int W = raw.width / 2;
+    const int H = raw.height / 2;
+    if (W <= 0 || H <= 0) return false;
+    const size_t n = static_cast<size_t>(W) * static_cast<size_t>(H) * 3;
+    if (rgb.size() != n) rgb.assign(n, 0.0f);
+    float *out = rgb.data();
+
+    /* Tiled like the full-size algorithms, over the output grid: no halo, so it is only
+       the parallel streaming of the mosaic. */
+    if (!ForEachTile(W, H, abort, {}, [&raw, out, W](const Tile &t, Scratch &) {
+            Superpixel(raw, out, W, t);
+        }))
+        return false;
+    outW = W;
+    outH = H;
+    return true;
+}
+
+bool Demosaic::ForEachTile(int W, int H, const QAtomicInt *abort,
+                           const std::function<void(int, int)> &progress,
+                           const TileFn &fn)
+{
+/*
+    Tiles are claimed from a shared counter in row-major order, so neighbouring tiles
+    (which share halo rows of the mosaic) run at about the same time and the mosaic is
+    streamed through memory once. The calling thread claims tiles too: it is the only
+    one that calls progress (the status-bar sinks are not thread-safe), and it keeps the
+    run going even when every pool thread is busy elsewhere.
+
+    Abort is polled before each tile -- a 256x256 tile is well under a millisecond --
+    so a long sensor decode bails promptly on shutdown / navigation rather than blocking
+    the decoder thread, and with it the BlockingQueuedConnection in ImageCache::stop.
+*/
+    const int tilesX = (W + kTile - 1) / kTile;
+    const int tilesY = (H + kTile - 1) / kTile;
+    const int nTiles = tilesX * tilesY;
+
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    std::atomic<bool> stop{false};
+
+    auto work = [&](bool caller) {
+        Scratch scratch;
+        for (;;) {
+            if (stop.load(std::memory_order_relaxed)) return;
+            if (abort && abort->loadAcquire()) {
+                stop.store(true, std::memory_order_relaxed);
+                return;
+            }
+            const int i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= nTiles) return;
+            Tile t;
+            t.x0 = (i % tilesX) * kTile;
+            t.y0 = (i / tilesX) * kTile;
+            t.x1 = qMin(W, t.x0 + kTile);
+            t.y1 = qMin(H, t.y0 + kTile);
+            fn(t, scratch);
+            const int d = done.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (caller && progress) progress(d, nTiles);
+        }
+    };
+
+    const int maxThreads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int helpers = qMin(maxThreads, nTiles) - 1;
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 0; k < helpers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), [&work]() { work(false); }));
+    work(true);
+    for (QFuture<void> &f : futures) f.waitForFinished();
+
+    if (stop.load() || (abort && abort->loadAcquire())) return false;
+    if (progress) progress(nTiles, nTiles);
+    return true;
 }
 
-bool Demosaic::XTransWindow(const RawImage &raw, std::vector<float> &rgb,
-                            const QAtomicInt *abort,
-                            const std::function<void(int, int)> &progress)
+void Demosaic::XTransWindow(const RawImage &raw, float *rgb, const Tile &t)
 {
 /*
     Simple Fuji X-Trans demosaic. The 6x6 colour map (raw.xtrans) is tiled across the sensor.
     For each pixel the measured channel is exact; the two missing channels are the average of
     the same-colour photosites in a 5x5 window -- which, for X-Trans, always contains at least
     one of every colour. Soft but obviously correct (the X-Trans analogue of the bilinear Bayer
-    path); a higher-quality algorithm can replace it later.
+    path); Markesteijn is the quality path, and hands its sensor-edge band back to this.
 */
     const int W = raw.width;
     const int H = raw.height;
     const float scale = raw.white > 0 ? 1.0f / static_cast<float>(raw.white) : 1.0f;
     const int R = 2;                                  // 5x5 window
 
-    rgb.assign(static_cast<size_t>(W) * static_cast<size_t>(H) * 3, 0.0f);
-
-    for (int y = 0; y < H; ++y) {
-        if (abort && abort->loadAcquire()) return false;
-        if (progress && (y & 31) == 0) progress(y, H);   // status bar, every 32 rows
-        for (int x = 0; x < W; ++x) {
+    for (int y = t.y0; y < t.y1; ++y) {
+        for (int x = t.x0; x < t.x1; ++x) {
             float sum[3] = {0, 0, 0};
             int   cnt[3] = {0, 0, 0};
             for (int dy = -R; dy <= R; ++dy) {
@@ -57,7 +266,6 @@ bool Demosaic::XTransWindow(const RawImage &raw, std::vector<float> &rgb,
                 static_cast<float>(raw.cfa[static_cast<size_t>(y) * W + x]) * scale;
         }
     }
-    return true;
 }
 
 int Demosaic::BayerColorAt(CfaPattern pattern, int row, int col)
@@ -79,31 +287,55 @@ int Demosaic::BayerColorAt(CfaPattern pattern, int row, int col)
     }
 }
 
-bool Demosaic::Bilinear3x3(const RawImage &raw, std::vector<float> &rgb,
-                           const QAtomicInt *abort,
-                           const std::function<void(int, int)> &progress)
+void Demosaic::Superpixel(const RawImage &raw, float *rgb, int outW, const Tile &t)
+{
+/*
+    Output pixel (x,y) is the quad at mosaic (2x,2y). Which of the quad's four photosites
+    holds R, B and the two greens depends only on the pattern, so it is resolved once
+    into offsets from the quad's top-left sample.
+*/
+    const size_t W = static_cast<size_t>(raw.width);
+    const float scale = raw.white > 0 ? 1.0f / static_cast<float>(raw.white) : 1.0f;
+    const float gScale = 0.5f * scale;
+
+    size_t offR = 0, offB = 0, offG[2] = {0, 0};
+    int g = 0;
+    for (int i = 0; i < 4; ++i) {
+        const size_t off = (i >> 1) * W + (i & 1);
+        switch (BayerColorAt(raw.pattern, i >> 1, i & 1)) {
+        case 0:  offR = off; break;
+        case 2:  offB = off; break;
+        default: offG[g++ & 1] = off; break;
+        }
+    }
+
+    for (int y = t.y0; y < t.y1; ++y) {
+        const uint16_t *quad = raw.cfa.data() + static_cast<size_t>(2 * y) * W + 2 * t.x0;
+        float *o = rgb + (static_cast<size_t>(y) * outW + t.x0) * 3;
+        for (int x = t.x0; x < t.x1; ++x, quad += 2, o += 3) {
+            o[0] = static_cast<float>(quad[offR]) * scale;
+            o[1] = (static_cast<float>(quad[offG[0]]) + static_cast<float>(quad[offG[1]])) * gScale;
+            o[2] = static_cast<float>(quad[offB]) * scale;
+        }
+    }
+}
+
+void Demosaic::Bilinear3x3(const RawImage &raw, float *rgb, const Tile &t)
 {
 /*
     Generic 3x3 bilinear demosaic. For every pixel the native colour is taken from the
     sample itself; the two missing colours are the average of the same-colour samples in
     the surrounding 3x3 neighbourhood (edge-clamped). A Bayer 3x3 window always contains
     at least one sample of each colour, so this handles all positions, including both
-    green types, without special cases. Simple and obviously correct — good enough to
-    prove the pipeline; AHD/DCB replace it in a later phase.
+    green types, without special cases. Simple and obviously correct; RCD is the quality
+    path.
 */
     const int W = raw.width;
     const int H = raw.height;
     const float scale = raw.white > 0 ? 1.0f / static_cast<float>(raw.white) : 1.0f;
 
-    rgb.assign(static_cast<size_t>(W) * static_cast<size_t>(H) * 3, 0.0f);
-
-    for (int y = 0; y < H; ++y) {
-        /* Poll abort once per row (cheap relative to a full row of pixels) so a long
-           sensor decode bails promptly on shutdown / navigation rather than blocking the
-           decoder thread -- and with it the BlockingQueuedConnection in ImageCache::stop. */
-        if (abort && abort->loadAcquire()) return false;
-        if (progress && (y & 31) == 0) progress(y, H);   // status bar, every 32 rows
-        for (int x = 0; x < W; ++x) {
+    for (int y = t.y0; y < t.y1; ++y) {
+        for (int x = t.x0; x < t.x1; ++x) {
             float sum[3] = {0, 0, 0};
             int   cnt[3] = {0, 0, 0};
 
@@ -129,5 +361,500 @@ bool Demosaic::Bilinear3x3(const RawImage &raw, std::vector<float> &rgb,
                 static_cast<float>(raw.cfa[static_cast<size_t>(y) * W + x]) * scale;
         }
     }
-    return true;
+}
+
+void Demosaic::RcdTile(const RawImage &raw, float *rgb, const Tile &t, Scratch &s)
+{
+/*
+    Ratio Corrected Demosaicing (Luis Sanz Rodriguez, v2.3 -- the algorithm RawTherapee
+    and darktable ship as "RCD"), on one tile.
+
+    1. Vertical/horizontal discrimination VH_Dir from squared high-pass colour
+       differences along columns and rows.
+    2. A low-pass luminance estimate (3x3 binomial) over the mosaic.
+    3. Green at red/blue sites: the four cardinal neighbours, each corrected by the ratio
+       of the low-pass at the site and two pixels out, blended by gradient weights and
+       then by VH_Dir (or its diagonal neighbourhood, whichever is more decisive).
+    4. Red/blue at blue/red sites along the diagonals (P/Q discrimination, colour
+       differences against the new green), then red/blue at green sites from the now
+       complete cardinal neighbours.
+
+    The passes run over a private copy of the tile plus kHalo pixels on every side, in
+    local coordinates. Each pass reads further out than the one before it (step 4b
+    depends on pixels 10 out), so each loop stays inside the region its inputs are valid
+    for and the tile's own pixels come out exact. The tile origin and kHalo are even, so
+    local (r,c) has the CFA colour of BayerColorAt(pattern, r, c), and the halo is
+    mirrored about the sensor edge (x -> -x, x -> 2(W-1)-x), which also keeps the phase.
+*/
+    const int W = raw.width;
+    const int H = raw.height;
+    const float scale = raw.white > 0 ? 1.0f / static_cast<float>(raw.white) : 1.0f;
+    const CfaPattern pat = raw.pattern;
+    constexpr float eps = 1e-5f;
+    constexpr float epssq = 1e-10f;
+
+    const int px0 = t.x0 - kHalo;
+    const int py0 = t.y0 - kHalo;
+    const int tw = (t.x1 - t.x0) + 2 * kHalo;
+    const int th = (t.y1 - t.y0) + 2 * kHalo;
+    s.ensure(static_cast<size_t>(tw) * static_cast<size_t>(th));
+    float *cfa = s.cfa.data();
+    float *lpf = s.lpf.data();
+    float *hpfV = s.hpfA.data();
+    float *hpfH = s.hpfB.data();
+    float *vhDir = s.vhDir.data();
+    float *pqDir = s.pqDir.data();
+    float *R = s.rgb[0].data();
+    float *G = s.rgb[1].data();
+    float *B = s.rgb[2].data();
+    float *ch[3] = {R, G, B};
+
+    auto mirror = [](int v, int n) {
+        if (v < 0) v = -v;
+        if (v >= n) v = 2 * (n - 1) - v;
+        return v;
+    };
+    auto sqr = [](float v) { return v * v; };
+    auto intp = [](float a, float b, float c) { return a * (b - c) + c; };
+
+    // Load tile + halo, normalised; the native channel is known everywhere
+    for (int r = 0; r < th; ++r) {
+        const uint16_t *src = raw.cfa.data() + static_cast<size_t>(mirror(py0 + r, H)) * W;
+        const int c0 = BayerColorAt(pat, r, 0);
+        const int c1 = BayerColorAt(pat, r, 1);
+        const size_t base = static_cast<size_t>(r) * tw;
+        const bool inside = px0 >= 0 && px0 + tw <= W;    // no mirrored columns
+        for (int c = 0; c < tw; ++c) {
+            const int x = inside ? px0 + c : mirror(px0 + c, W);
+            const float v = static_cast<float>(src[x]) * scale;
+            cfa[base + c] = v;
+            R[base + c] = G[base + c] = B[base + c] = 0.0f;
+            ch[(c & 1) ? c1 : c0][base + c] = v;
+        }
+    }
+
+    const int w1 = tw, w2 = 2 * tw, w3 = 3 * tw, w4 = 4 * tw;
+
+    // Step 1: vertical / horizontal discrimination
+    for (int r = 3; r < th - 3; ++r) {
+        for (int c = 3; c < tw - 3; ++c) {
+            const int i = r * tw + c;
+            hpfV[i] = sqr((cfa[i - w3] - cfa[i - w1] - cfa[i + w1] + cfa[i + w3])
+                          - 3.0f * (cfa[i - w2] + cfa[i + w2]) + 6.0f * cfa[i]);
+            hpfH[i] = sqr((cfa[i - 3] - cfa[i - 1] - cfa[i + 1] + cfa[i + 3])
+                          - 3.0f * (cfa[i - 2] + cfa[i + 2]) + 6.0f * cfa[i]);
+        }
+    }
+    for (int r = 4; r < th - 4; ++r) {
+        for (int c = 4; c < tw - 4; ++c) {
+            const int i = r * tw + c;
+            const float vStat = std::max(epssq, hpfV[i - w1] + hpfV[i] + hpfV[i + w1]);
+            const float hStat = std::max(epssq, hpfH[i - 1] + hpfH[i] + hpfH[i + 1]);
+            vhDir[i] = vStat / (vStat + hStat);
+        }
+    }
+
+    // Step 2: low-pass filter over the mosaic
+    for (int r = 1; r < th - 1; ++r) {
+        for (int c = 1; c < tw - 1; ++c) {
+            const int i = r * tw + c;
+            lpf[i] = cfa[i]
+                   + 0.5f * (cfa[i - w1] + cfa[i + w1] + cfa[i - 1] + cfa[i + 1])
+                   + 0.25f * (cfa[i - w1 - 1] + cfa[i - w1 + 1] + cfa[i + w1 - 1] + cfa[i + w1 + 1]);
+        }
+    }
+
+    // Step 3: green at red and blue sites
+    for (int r = 5; r < th - 5; ++r) {
+        for (int c = 5 + (BayerColorAt(pat, r, 5) == 1); c < tw - 5; c += 2) {
+            const int i = r * tw + c;
+
+            const float nGrad = eps + std::fabs(cfa[i - w1] - cfa[i + w1]) + std::fabs(cfa[i] - cfa[i - w2])
+                              + std::fabs(cfa[i - w1] - cfa[i - w3]) + std::fabs(cfa[i - w2] - cfa[i - w4]);
+            const float sGrad = eps + std::fabs(cfa[i - w1] - cfa[i + w1]) + std::fabs(cfa[i] - cfa[i + w2])
+                              + std::fabs(cfa[i + w1] - cfa[i + w3]) + std::fabs(cfa[i + w2] - cfa[i + w4]);
+            const float wGrad = eps + std::fabs(cfa[i - 1] - cfa[i + 1]) + std::fabs(cfa[i] - cfa[i - 2])
+                              + std::fabs(cfa[i - 1] - cfa[i - 3]) + std::fabs(cfa[i - 2] - cfa[i - 4]);
+            const float eGrad = eps + std::fabs(cfa[i - 1] - cfa[i + 1]) + std::fabs(cfa[i] - cfa[i + 2])
+                              + std::fabs(cfa[i + 1] - cfa[i + 3]) + std::fabs(cfa[i + 2] - cfa[i + 4]);
+
+            const float nEst = cfa[i - w1] * (1.0f + (lpf[i] - lpf[i - w2]) / (eps + lpf[i] + lpf[i - w2]));
+            const float sEst = cfa[i + w1] * (1.0f + (lpf[i] - lpf[i + w2]) / (eps + lpf[i] + lpf[i + w2]));
+            const float wEst = cfa[i - 1] * (1.0f + (lpf[i] - lpf[i - 2]) / (eps + lpf[i] + lpf[i - 2]));
+            const float eEst = cfa[i + 1] * (1.0f + (lpf[i] - lpf[i + 2]) / (eps + lpf[i] + lpf[i + 2]));
+
+            const float vEst = (sGrad * nEst + nGrad * sEst) / (nGrad + sGrad);
+            const float hEst = (wGrad * eEst + eGrad * wEst) / (eGrad + wGrad);
+
+            const float central = vhDir[i];
+            const float neighbourhood = 0.25f * (vhDir[i - w1 - 1] + vhDir[i - w1 + 1]
+                                               + vhDir[i + w1 - 1] + vhDir[i + w1 + 1]);
+            const float disc = std::fabs(0.5f - central) < std::fabs(0.5f - neighbourhood)
+                             ? neighbourhood : central;
+            G[i] = intp(disc, hEst, vEst);
+        }
+    }
+
+    /* Step 4a: diagonal discrimination, then red at blue and blue at red. P/Q are read
+       only at red/blue sites and their diagonal neighbours (also red/blue), so they are
+       computed there only. */
+    for (int r = 3; r < th - 3; ++r) {
+        for (int c = 3 + (BayerColorAt(pat, r, 3) == 1); c < tw - 3; c += 2) {
+            const int i = r * tw + c;
+            hpfV[i] = sqr((cfa[i - w3 - 3] - cfa[i - w1 - 1] - cfa[i + w1 + 1] + cfa[i + w3 + 3])
+                          - 3.0f * (cfa[i - w2 - 2] + cfa[i + w2 + 2]) + 6.0f * cfa[i]);
+            hpfH[i] = sqr((cfa[i - w3 + 3] - cfa[i - w1 + 1] - cfa[i + w1 - 1] + cfa[i + w3 - 3])
+                          - 3.0f * (cfa[i - w2 + 2] + cfa[i + w2 - 2]) + 6.0f * cfa[i]);
+        }
+    }
+    for (int r = 4; r < th - 4; ++r) {
+        for (int c = 4 + (BayerColorAt(pat, r, 4) == 1); c < tw - 4; c += 2) {
+            const int i = r * tw + c;
+            const float pStat = std::max(epssq, hpfV[i - w1 - 1] + hpfV[i] + hpfV[i + w1 + 1]);
+            const float qStat = std::max(epssq, hpfH[i - w1 + 1] + hpfH[i] + hpfH[i + w1 - 1]);
+            pqDir[i] = pStat / (pStat + qStat);
+        }
+    }
+    for (int r = 7; r < th - 7; ++r) {
+        for (int c = 7 + (BayerColorAt(pat, r, 7) == 1); c < tw - 7; c += 2) {
+            const int i = r * tw + c;
+            float *X = ch[2 - BayerColorAt(pat, r, c)];     // the opposite colour
+
+            const float central = pqDir[i];
+            const float neighbourhood = 0.25f * (pqDir[i - w1 - 1] + pqDir[i - w1 + 1]
+                                               + pqDir[i + w1 - 1] + pqDir[i + w1 + 1]);
+            const float disc = std::fabs(0.5f - central) < std::fabs(0.5f - neighbourhood)
+                             ? neighbourhood : central;
+
+            const float nwGrad = eps + std::fabs(X[i - w1 - 1] - X[i + w1 + 1])
+                               + std::fabs(X[i - w1 - 1] - X[i - w3 - 3]) + std::fabs(G[i] - G[i - w2 - 2]);
+            const float neGrad = eps + std::fabs(X[i - w1 + 1] - X[i + w1 - 1])
+                               + std::fabs(X[i - w1 + 1] - X[i - w3 + 3]) + std::fabs(G[i] - G[i - w2 + 2]);
+            const float swGrad = eps + std::fabs(X[i + w1 - 1] - X[i - w1 + 1])
+                               + std::fabs(X[i + w1 - 1] - X[i + w3 - 3]) + std::fabs(G[i] - G[i + w2 - 2]);
+            const float seGrad = eps + std::fabs(X[i + w1 + 1] - X[i - w1 - 1])
+                               + std::fabs(X[i + w1 + 1] - X[i + w3 + 3]) + std::fabs(G[i] - G[i + w2 + 2]);
+
+            const float nwEst = X[i - w1 - 1] - G[i - w1 - 1];
+            const float neEst = X[i - w1 + 1] - G[i - w1 + 1];
+            const float swEst = X[i + w1 - 1] - G[i + w1 - 1];
+            const float seEst = X[i + w1 + 1] - G[i + w1 + 1];
+
+            const float pEst = (nwGrad * seEst + seGrad * nwEst) / (nwGrad + seGrad);
+            const float qEst = (neGrad * swEst + swGrad * neEst) / (neGrad + swGrad);
+            X[i] = G[i] + intp(disc, qEst, pEst);
+        }
+    }
+
+    // Step 4b: red and blue at green sites
+    for (int r = 10; r < th - 10; ++r) {
+        for (int c = 10 + (BayerColorAt(pat, r, 10) != 1); c < tw - 10; c += 2) {
+            const int i = r * tw + c;
+
+            const float central = vhDir[i];
+            const float neighbourhood = 0.25f * (vhDir[i - w1 - 1] + vhDir[i - w1 + 1]
+                                               + vhDir[i + w1 - 1] + vhDir[i + w1 + 1]);
+            const float disc = std::fabs(0.5f - central) < std::fabs(0.5f - neighbourhood)
+                             ? neighbourhood : central;
+
+            for (float *X : {R, B}) {
+                const float nGrad = eps + std::fabs(G[i] - G[i - w2]) + std::fabs(X[i - w1] - X[i + w1])
+                                  + std::fabs(X[i - w1] - X[i - w3]);
+                const float sGrad = eps + std::fabs(G[i] - G[i + w2]) + std::fabs(X[i + w1] - X[i - w1])
+                                  + std::fabs(X[i + w1] - X[i + w3]);
+                const float wGrad = eps + std::fabs(G[i] - G[i - 2]) + std::fabs(X[i - 1] - X[i + 1])
+                                  + std::fabs(X[i - 1] - X[i - 3]);
+                const float eGrad = eps + std::fabs(G[i] - G[i + 2]) + std::fabs(X[i + 1] - X[i - 1])
+                                  + std::fabs(X[i + 1] - X[i + 3]);
+
+                const float nEst = X[i - w1] - G[i - w1];
+                const float sEst = X[i + w1] - G[i + w1];
+                const float wEst = X[i - 1] - G[i - 1];
+                const float eEst = X[i + 1] - G[i + 1];
+
+                const float vEst = (nGrad * sEst + sGrad * nEst) / (nGrad + sGrad);
+                const float hEst = (eGrad * wEst + wGrad * eEst) / (eGrad + wGrad);
+                X[i] = G[i] + intp(disc, hEst, vEst);
+            }
+        }
+    }
+
+    // Write the tile's own pixels; estimates can undershoot at hard edges
+    for (int y = t.y0; y < t.y1; ++y) {
+        const int r = y - py0;
+        float *dst = rgb + (static_cast<size_t>(y) * W + t.x0) * 3;
+        for (int x = t.x0; x < t.x1; ++x) {
+            const int i = r * tw + (x - px0);
+            *dst++ = std::max(0.0f, R[i]);
+            *dst++ = std::max(0.0f, G[i]);
+            *dst++ = std::max(0.0f, B[i]);
+        }
+    }
+}
+
+void Demosaic::MarkesteijnTile(const RawImage &raw, const XTransHex &hex, float *rgb,
+                               const Tile &t, Scratch &s)
+{
+/*
+    Frank Markesteijn's X-Trans demosaic, one pass, four directions -- dcraw's
+    xtrans_interpolate(1), which RawTherapee and darktable also ship -- on one tile.
+
+    1. Green at every R/B site, once per direction (horizontal, vertical and the two
+       diagonals) from the greens of its hexagon, clamped to their range.
+    2. Per direction, R and B from colour differences against that direction's green:
+       at the solitary greens, then B at R and R at B, then at the 2x2 green blocks.
+    3. Per direction, a perceptual (square-root encoded luma and colour difference)
+       image and its squared second derivative along the direction. dcraw uses CIELab
+       here; this stage sees no camera matrix, and the square root runs in SIMD.
+    4. Homogeneity: in each 3x3 window, how many of a direction's derivatives are within
+       8x the smallest of all four at the centre; summed over 5x5, the directions within
+       an eighth of the best are averaged for the output.
+
+    The passes run over a private copy of the tile plus kHalo pixels on every side, in
+    local coordinates, each loop inside the region its inputs are valid for: green reads
+    3 out, the solitary greens 2 more, R/B at R/B sites 1 more, the 2x2 blocks 2 more,
+    the derivative 1, the homogeneity 1 and its sum 2 -- 12 in all, so the tile's own
+    pixels come out exact. The X-Trans pattern has no mirror symmetry, so the halo outside
+    the sensor is filled from whole 6x6 periods further in; the kXTransBorder band nearest
+    the edge, which would see that seam, is XTransWindow's instead. Stages 3 and 4 are the
+    RawKernels X-Trans kernels; the interpolation is scalar, as its neighbours depend on
+    the site.
+*/
+    const int W = raw.width;
+    const int H = raw.height;
+    const float scale = raw.white > 0 ? 1.0f / static_cast<float>(raw.white) : 1.0f;
+
+    const int px0 = t.x0 - kHalo;
+    const int py0 = t.y0 - kHalo;
+    const int tw = (t.x1 - t.x0) + 2 * kHalo;
+    const int th = (t.y1 - t.y0) + 2 * kHalo;
+    const size_t n = static_cast<size_t>(tw) * static_cast<size_t>(th);
+    float *plane = s.ensureXTrans(n);
+    auto next = [&plane, n]() { float *p = plane; plane += n; return p; };
+    float *cfa = next();
+    float *dir[4][3];
+    for (auto &d : dir)
+        for (float *&c : d) c = next();
+    float *lab[3] = {next(), next(), next()};
+    float *drv[4] = {next(), next(), next(), next()};
+    float *homo[4] = {next(), next(), next(), next()};
+    float *rowSum = next();
+
+    /* Local (r,c) is sensor (py0 + r, px0 + c); the 6x6 map and the 3x3 tables are
+       re-phased to it. */
+    const int oy6 = ((py0 % 6) + 6) % 6, ox6 = ((px0 % 6) + 6) % 6;
+    const int oy3 = oy6 % 3, ox3 = ox6 % 3;
+    auto color = [&raw, oy6, ox6](int r, int c) { return raw.xtrans[(r + oy6) % 6][(c + ox6) % 6]; };
+    auto sgRow = [&hex, oy3](int r) { return (r + oy3 + 3 - hex.sgRow) % 3 == 0; };
+    auto sgCol = [&hex, ox3](int c) { return (c + ox3 + 3 - hex.sgCol) % 3 == 0; };
+    int off[3][3][8];
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+            for (int k = 0; k < 8; ++k)
+                off[r][c][k] = hex.dy[(r + oy3) % 3][(c + ox3) % 3][k] * tw
+                             + hex.dx[(r + oy3) % 3][(c + ox3) % 3][k];
+
+    auto shift = [](int v, int size) {
+        while (v < 0) v += 6;
+        while (v >= size) v -= 6;
+        return v;
+    };
+    auto clip = [](float v) { return v > 0.0f ? v : 0.0f; };
+
+    // Load tile + halo, normalised; the native channel is known everywhere
+    for (int r = 0; r < th; ++r) {
+        const uint16_t *src = raw.cfa.data() + static_cast<size_t>(shift(py0 + r, H)) * W;
+        const bool inside = px0 >= 0 && px0 + tw <= W;
+        const size_t base = static_cast<size_t>(r) * tw;
+        for (int c = 0; c < tw; ++c) {
+            const float v = static_cast<float>(src[inside ? px0 + c : shift(px0 + c, W)]) * scale;
+            const int k = color(r, c);
+            cfa[base + c] = v;
+            dir[0][0][base + c] = k == 0 ? v : 0.0f;
+            dir[0][1][base + c] = k == 1 ? v : 0.0f;
+            dir[0][2][base + c] = k == 2 ? v : 0.0f;
+        }
+    }
+    for (int d = 1; d < 4; ++d)
+        for (int c = 0; c < 3; ++c)
+            std::memcpy(dir[d][c], dir[0][c], n * sizeof(float));
+
+    // Step 1: green at R/B sites in each direction, within the range of the hexagon
+    for (int r = 3; r < th - 3; ++r) {
+        const int swap = sgRow(r) ? 1 : 0;      // the hexagon lies the other way round
+        for (int c = 3; c < tw - 3; ++c) {
+            if (color(r, c) == 1) continue;
+            const int i = r * tw + c;
+            const int *h = off[r % 3][c % 3];
+            float lo = cfa[i + h[0]], hi = lo;
+            for (int k = 1; k < 6; ++k) {
+                lo = std::min(lo, cfa[i + h[k]]);
+                hi = std::max(hi, cfa[i + h[k]]);
+            }
+            float est[4];
+            est[0] = 174.0f * (cfa[i + h[1]] + cfa[i + h[0]])
+                   - 46.0f * (cfa[i + 2 * h[1]] + cfa[i + 2 * h[0]]);
+            est[1] = 223.0f * cfa[i + h[3]] + 33.0f * cfa[i + h[2]]
+                   + 92.0f * (cfa[i] - cfa[i - h[2]]);
+            for (int k = 0; k < 2; ++k)
+                est[2 + k] = 164.0f * cfa[i + h[4 + k]] + 92.0f * cfa[i - 2 * h[4 + k]]
+                           + 33.0f * (2.0f * cfa[i] - cfa[i + 3 * h[4 + k]] - cfa[i - 3 * h[4 + k]]);
+            for (int d = 0; d < 4; ++d)
+                dir[d ^ swap][1][i] = std::clamp(est[d] * (1.0f / 256.0f), lo, hi);
+        }
+    }
+
+    /* Step 2a: R and B at the solitary greens, from the nearest sites of each colour in
+       line (one colour 1 out, the other 2 out). The diagonal directions have no such
+       line, so they take whichever of horizontal / vertical is smoother in their green. */
+    for (int r = 5; r < th - 5; ++r) {
+        if (!sgRow(r)) continue;
+        for (int c = 5; c < tw - 5; ++c) {
+            if (!sgCol(c)) continue;
+            const int i = r * tw + c;
+            const int nearH = color(r, c + 1);      // 1 out horizontally, 2 out vertically
+            for (int d = 0; d < 4; ++d) {
+                const float *G = dir[d][1];
+                float est[2][3] = {};
+                float diff[2] = {0.0f, 0.0f};
+                for (int v = 0; v < 2; ++v) {           // 0 horizontal, 1 vertical
+                    const int step = v ? tw : 1;
+                    for (int k = 1; k <= 2; ++k) {
+                        const int o = k * step;
+                        const int x = (k == 1) == (v == 0) ? nearH : 2 - nearH;
+                        const float *X = dir[d][x];
+                        const float g = 2.0f * G[i] - G[i + o] - G[i - o];
+                        est[v][x] = g + X[i + o] + X[i - o];
+                        const float e = G[i + o] - G[i - o] - X[i + o] + X[i - o];
+                        diff[v] += e * e + g * g;
+                    }
+                }
+                const int v = d < 2 ? d : (diff[0] < diff[1] ? 0 : 1);
+                dir[d][0][i] = clip(est[v][0] * 0.5f);
+                dir[d][2][i] = clip(est[v][2] * 0.5f);
+            }
+        }
+    }
+
+    /* Step 2b: B at R sites and R at B sites, from the same colour in line through the
+       site (next to it across a solitary green, or 3 out). In the one direction that
+       runs across that line, the line is used only where green is no less smooth along
+       it than across. */
+    for (int r = 6; r < th - 6; ++r) {
+        const bool sg = sgRow(r);
+        const int along = sg ? 1 : tw;
+        const int across = sg ? 3 * tw : 3;
+        const int crossDir = sg ? 1 : 0;
+        for (int c = 6; c < tw - 6; ++c) {
+            const int k = color(r, c);
+            if (k == 1) continue;
+            const int i = r * tw + c;
+            for (int d = 0; d < 4; ++d) {
+                const float *G = dir[d][1];
+                float *X = dir[d][2 - k];
+                int o = along;
+                if (d == crossDir) {
+                    const float gAlong = std::fabs(G[i] - G[i + along]) + std::fabs(G[i] - G[i - along]);
+                    const float gAcross = std::fabs(G[i] - G[i + across]) + std::fabs(G[i] - G[i - across]);
+                    if (!(gAlong < 2.0f * gAcross)) o = across;
+                }
+                X[i] = clip((X[i + o] + X[i - o] + 2.0f * G[i] - G[i + o] - G[i - o]) * 0.5f);
+            }
+        }
+    }
+
+    /* Step 2c: R and B at the 2x2 green blocks, from the near / far R/B-bearing pair of
+       each direction, weighted by distance (2:1) or equally when they are opposite. */
+    for (int r = 8; r < th - 8; ++r) {
+        if (sgRow(r)) continue;
+        for (int c = 8; c < tw - 8; ++c) {
+            if (sgCol(c)) continue;
+            const int i = r * tw + c;
+            const int *h = off[r % 3][c % 3];
+            for (int d = 0; d < 4; ++d) {
+                const float *G = dir[d][1];
+                const int a = h[2 * d], b = h[2 * d + 1];
+                for (int x = 0; x < 3; x += 2) {
+                    float *X = dir[d][x];
+                    if (a + b) {
+                        const float g = 3.0f * G[i] - 2.0f * G[i + a] - G[i + b];
+                        X[i] = clip((g + 2.0f * X[i + a] + X[i + b]) * (1.0f / 3.0f));
+                    } else {
+                        const float g = 2.0f * G[i] - G[i + a] - G[i + b];
+                        X[i] = clip((g + X[i + a] + X[i + b]) * 0.5f);
+                    }
+                }
+            }
+        }
+    }
+
+    // Step 3: perceptual image and its derivative along each direction
+    const int step[4] = {1, tw, tw + 1, tw - 1};
+    for (int d = 0; d < 4; ++d) {
+        for (int r = 8; r < th - 8; ++r) {
+            const size_t i = static_cast<size_t>(r) * tw + 8;
+            RawKernels::XTransPerceptual(dir[d][0] + i, dir[d][1] + i, dir[d][2] + i,
+                                         lab[0] + i, lab[1] + i, lab[2] + i, tw - 16);
+        }
+        for (int r = 9; r < th - 9; ++r) {
+            const size_t i = static_cast<size_t>(r) * tw + 9;
+            RawKernels::XTransDerivative(lab[0] + i, lab[1] + i, lab[2] + i, step[d],
+                                         drv[d] + i, tw - 18);
+        }
+    }
+
+    // Step 4: homogeneity maps, then their 5x5 sums (into drv, no longer needed)
+    for (int r = 10; r < th - 10; ++r) {
+        const size_t i = static_cast<size_t>(r) * tw + 10;
+        const float *const d[4] = {drv[0] + i, drv[1] + i, drv[2] + i, drv[3] + i};
+        float *const h[4] = {homo[0] + i, homo[1] + i, homo[2] + i, homo[3] + i};
+        RawKernels::XTransHomogeneity(d, tw, h, tw - 20);
+    }
+    float *hm[4] = {drv[0], drv[1], drv[2], drv[3]};
+    for (int d = 0; d < 4; ++d) {
+        for (int r = 10; r < th - 10; ++r) {
+            const float *src = homo[d] + static_cast<size_t>(r) * tw;
+            float *dst = rowSum + static_cast<size_t>(r) * tw;
+            for (int c = kHalo; c < tw - kHalo; ++c)
+                dst[c] = src[c - 2] + src[c - 1] + src[c] + src[c + 1] + src[c + 2];
+        }
+        for (int r = kHalo; r < th - kHalo; ++r) {
+            const float *src = rowSum + static_cast<size_t>(r) * tw;
+            float *dst = hm[d] + static_cast<size_t>(r) * tw;
+            for (int c = kHalo; c < tw - kHalo; ++c)
+                dst[c] = src[c - 2 * tw] + src[c - tw] + src[c] + src[c + tw] + src[c + 2 * tw];
+        }
+    }
+
+    // Average the most homogeneous directions into the tile's own pixels
+    const int ix0 = std::max(t.x0, kXTransBorder), ix1 = std::min(t.x1, W - kXTransBorder);
+    const int iy0 = std::max(t.y0, kXTransBorder), iy1 = std::min(t.y1, H - kXTransBorder);
+    for (int y = iy0; y < iy1; ++y) {
+        const int r = y - py0;
+        float *dst = rgb + (static_cast<size_t>(y) * W + ix0) * 3;
+        for (int x = ix0; x < ix1; ++x, dst += 3) {
+            const int i = r * tw + (x - px0);
+            int best = 0;
+            for (int d = 0; d < 4; ++d) best = std::max(best, static_cast<int>(hm[d][i]));
+            best -= best >> 3;
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+            int cnt = 0;
+            for (int d = 0; d < 4; ++d) {
+                if (static_cast<int>(hm[d][i]) < best) continue;
+                for (int c = 0; c < 3; ++c) sum[c] += dir[d][c][i];
+                ++cnt;
+            }
+            for (int c = 0; c < 3; ++c) dst[c] = sum[c] / static_cast<float>(cnt);
+        }
+    }
+
+    // The sensor-edge band
+    const Tile band[4] = {
+        {t.x0, t.y0, t.x1, iy0},                // top
+        {t.x0, std::max(iy1, t.y0), t.x1, t.y1},    // bottom
+        {t.x0, iy0, ix0, iy1},                  // left
+        {std::max(ix1, t.x0), iy0, t.x1, iy1}   // right
+    };
+    for (const Tile &b : band)
+        if (b.x0 < b.x1 && b.y0 < b.y1) XTransWindow(raw, rgb, b);
 }
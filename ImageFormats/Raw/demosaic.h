@@ -14,37 +14,80 @@
 
     Output is an interleaved float RGB buffer (size width*height*3, range 0..1 relative
     to the white level) which RawColor then converts to a display QImage.
+
+    Tiling. Every algorithm runs tile by tile: the output is cut into kTile x kTile
+    squares and the tiles are handed out to the global QThreadPool (plus the calling
+    thread, so a caller that is itself a pool thread cannot deadlock the run). A tile
+    reads the mosaic a halo beyond its own edge and writes only its own pixels, so tiles
+    are independent and the result does not depend on the thread count. RCD and
+    Markesteijn work on a private copy of tile + halo (kHalo rows/columns; mirrored at
+    the sensor edge for Bayer, shifted by whole 6x6 periods for X-Trans) that stays in
+    cache through all of their passes.
 */
 class Demosaic
 {
 public:
     enum Algorithm {
-        Bilinear        // simple, fast; the only algorithm in the scaffold
-        // AHD, DCB, XTrans ... added in later phases
+        Bilinear,       // simple, fast; same-colour average over the 3x3 neighbourhood
+        RCD,            // Ratio Corrected Demosaicing: edge-directed, low zipper/maze
+        Markesteijn     // X-Trans: 1-pass Markesteijn, four directions picked by homogeneity
     };
 
     Demosaic() = default;
 
-    /* Demosaic raw.cfa into interleaved RGB floats. Returns false for unsupported
-       patterns (e.g. XTrans), an invalid RawImage, or if abort is signalled mid-run.
-       progress (when set) is called periodically as (rowsDone, totalRows) for the
-       status bar -- the demosaic is a visible slice of a "Denoise raw" decode. */
+    /* Demosaic raw.cfa into interleaved RGB floats. Returns false for an unknown
+       pattern, an invalid RawImage, or if abort is signalled mid-run. algo picks the
+       quality: Bilinear is the same-colour average for either CFA (XTransWindow for
+       X-Trans), while RCD and Markesteijn both mean the edge-directed algorithm for the
+       mosaic's pattern -- RCD on Bayer, Markesteijn on X-Trans. progress (when set)
+       is called from the calling thread as (tilesDone, totalTiles) for the status bar
+       -- the demosaic is a visible slice of a "Denoise raw" decode. */
     bool Run(const RawImage &raw,
              std::vector<float> &rgb,
              Algorithm algo = Bilinear,
              const QAtomicInt *abort = nullptr,
              const std::function<void(int, int)> &progress = {});
 
+    /* Half-size preview demosaic for a Bayer mosaic: every 2x2 quad becomes one pixel (its
+       R, the mean of its two greens, its B), so rgb is (width/2) x (height/2), reported in
+       outW / outH; an odd last row or column is dropped. Nothing is interpolated, so it
+       costs a fraction of Bilinear3x3 at a quarter of the area and has no demosaic
+       artefacts -- what it gives up is resolution a fit-to-window view cannot show.
+       Returns false for X-Trans (no 2x2 period), an invalid RawImage, or on abort. */
+    bool RunHalfSize(const RawImage &raw,
+                     std::vector<float> &rgb,
+                     int &outW, int &outH,
+                     const QAtomicInt *abort = nullptr);
+
+    static constexpr int kTile = 256;   // output tile edge (px); even keeps the CFA phase
+    static constexpr int kHalo = 12;    // RCD reach is 10 px (rounded up to even), Markesteijn's 12
+    static constexpr int kXTransBorder = 8;  // sensor-edge band Markesteijn leaves to XTransWindow
+
 private:
-    bool Bilinear3x3(const RawImage &raw, std::vector<float> &rgb,
-                     const QAtomicInt *abort,
-                     const std::function<void(int, int)> &progress);
+    struct Tile { int x0, y0, x1, y1; };        // output rect [x0,x1) x [y0,y1)
+    struct Scratch;                             // per-worker RCD / Markesteijn buffers (demosaic.cpp)
+    struct XTransHex;                           // Markesteijn neighbourhood tables (demosaic.cpp)
+    using TileFn = std::function<void(const Tile &, Scratch &)>;
+
+    /* Run fn over every tile on the thread pool; false if abort was signalled. */
+    static bool ForEachTile(int W, int H, const QAtomicInt *abort,
+                            const std::function<void(int, int)> &progress,
+                            const TileFn &fn);
+
+    static void Bilinear3x3(const RawImage &raw, float *rgb, const Tile &t);
 
     /* Fuji X-Trans: per-pixel average of same-colour photosites in a 5x5 window (the 6x6
        pattern guarantees all three colours in that window), native colour kept exact. */
-    bool XTransWindow(const RawImage &raw, std::vector<float> &rgb,
-                      const QAtomicInt *abort,
-                      const std::function<void(int, int)> &progress);
+    static void XTransWindow(const RawImage &raw, float *rgb, const Tile &t);
+
+    /* Fuji X-Trans: 1-pass Markesteijn (dcraw's xtrans_interpolate) on one tile. */
+    static void MarkesteijnTile(const RawImage &raw, const XTransHex &hex, float *rgb,
+                                const Tile &t, Scratch &s);
+
+    static void RcdTile(const RawImage &raw, float *rgb, const Tile &t, Scratch &s);
+
+    /* RunHalfSize: t is in output (half-size) pixels, outW the output row length. */
+    static void Superpixel(const RawImage &raw, float *rgb, int outW, const Tile &t);
 
     /* Colour of photosite (row,col) for a Bayer pattern: 0=R, 1=G, 2=B. */
     static int BayerColorAt(CfaPattern pattern, int row, int col);
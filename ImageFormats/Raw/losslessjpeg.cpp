@@ -1,32 +1,61 @@
 #include "ImageFormats/Raw/losslessjpeg.h"
+#include <algorithm>
+#include <cstring>
 
 /*
-    Implementation note: this is a direct port of a reference decoder validated end-to-end
-    against a real lossless-JPEG DNG (Leica M10 CFA: SOF3, 14-bit, 2 components, predictor 1) --
-    the decoded mosaic demosaiced/colour-converted to a coherent, correctly-coloured image,
-    confirming the Huffman tables, bit reader and predictors are correct.
+    Implementation note: this started as a direct port of a reference decoder validated
+    end-to-end against a real lossless-JPEG DNG (Leica M10 CFA: SOF3, 14-bit, 2 components,
+    predictor 1) -- the decoded mosaic demosaiced/colour-converted to a coherent, correctly-
+    coloured image, confirming the Huffman tables, bit reader and predictors are correct.
+    The table-driven entropy decoder that replaced the bit-at-a-time one is checked against
+    an independent encoder in tst_losslessjpeg.
 */
 
 namespace LosslessJpeg {
 
 namespace {
 
-/* Canonical Huffman table: per code length 1..16, the value range, plus the symbol list. */
+/* Bits looked up at once. 12 covers every code of a typical raw table together with the
+   difference bits of the small (most frequent) differences; 4096 entries = 16 KB. */
+constexpr int kLutBits = 12;
+constexpr uint8_t kFull = 0xFF;     // Lut::sym marking an entry that already holds the diff
+
+/* One lookup-table slot: code length (0 = longer than kLutBits, use the canonical search)
+   and either the SSSS symbol or, when sym == kFull, the decoded difference with len then
+   counting the code AND its difference bits. */
+struct Lut {
+    int16_t diff;
+    uint8_t len;
+    uint8_t sym;
+};
+
+/* JPEG "extend": v is the s raw difference bits, returns the signed difference. */
+inline int Extend(int v, int s)
+{
+    return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+/* Canonical Huffman table: per code length 1..16, the value range, plus the symbol list;
+   and the kLutBits lookup table derived from it. */
 struct HuffTable {
     int mincode[17];
     int maxcode[17];     // -1 when no codes of that length
     int valptr[17];
     std::vector<uint8_t> vals;
+    std::vector<Lut> lut;
     bool built = false;
 
     void build(const uint8_t counts[16], const uint8_t *symbols, int nsym)
     {
         vals.assign(symbols, symbols + nsym);
+        lut.assign(size_t(1) << kLutBits, Lut{0, 0, 0});
         int code = 0, j = 0;
         for (int l = 1; l <= 16; ++l) {
             if (counts[l - 1]) {
                 valptr[l] = j;
                 mincode[l] = code;
+                if (l <= kLutBits)
+                    for (int k = 0; k < counts[l - 1]; ++k) fill(code + k, l, vals[j + k]);
                 code += counts[l - 1];
                 maxcode[l] = code - 1;
                 j += counts[l - 1];
@@ -37,22 +66,46 @@ struct HuffTable {
         }
         built = true;
     }
+
+private:
+    /* Every slot whose top l bits are this code. When the difference bits that follow
+       also fit in the lookup, decode them here so the scan loop does not have to. */
+    void fill(int code, int l, uint8_t sym)
+    {
+        const int free = kLutBits - l;
+        const int base = code << free;
+        for (int i = 0; i < (1 << free); ++i) {
+            Lut &e = lut[base + i];
+            if (sym == 0 || sym >= 16) {
+                e = Lut{int16_t(sym ? -32768 : 0), uint8_t(l), kFull};
+            } else if (sym <= free) {
+                const int bits = (i >> (free - sym)) & ((1 << sym) - 1);
+                e = Lut{int16_t(Extend(bits, sym)), uint8_t(l + sym), kFull};
+            } else {
+                e = Lut{0, uint8_t(l), sym};
+            }
+        }
+    }
 };
 
-/* MSB-first bit reader over the entropy-coded segment. Handles 0xFF00 byte stuffing; on any
-   real marker (or end of data) it stops consuming and feeds zero bits, which is the standard
-   way to let a well-formed scan finish decoding its last samples. */
+/*
+    MSB-first bit reader over the entropy-coded segment, 64 bits buffered and refilled a
+    byte at a time so a sample's code and difference (at most 32 bits) never straddle a
+    refill. Handles 0xFF00 byte stuffing; on any real marker (or end of data) it stops
+    consuming and feeds zero bits, which is the standard way to let a well-formed scan
+    finish decoding its last samples.
+*/
 struct BitReader {
     const uint8_t *d;
     size_t size, pos = 0;
-    uint32_t buf = 0;
+    uint64_t cache = 0;     // valid bits left-aligned
     int cnt = 0;
     bool ended = false;
 
     uint8_t nextByte()
     {
         if (ended || pos >= size) return 0;
-        uint8_t c = d[pos++];
+        const uint8_t c = d[pos++];
         if (c == 0xFF) {
             const uint8_t n = (pos < size) ? d[pos] : 0;
             if (n == 0) ++pos;                  // stuffed 0xFF00 -> literal 0xFF
@@ -60,53 +113,64 @@ struct BitReader {
         }
         return c;
     }
-    int bit()
+    void fill()
     {
-        if (cnt == 0) { buf = nextByte(); cnt = 8; }
-        --cnt;
-        return (buf >> cnt) & 1;
-    }
-    uint32_t bits(int k)
-    {
-        uint32_t v = 0;
-        while (k-- > 0) v = (v << 1) | bit();
-        return v;
+        while (cnt <= 56) {
+            cache |= uint64_t(nextByte()) << (56 - cnt);
+            cnt += 8;
+        }
     }
+    uint32_t peek(int k) const { return uint32_t(cache >> (64 - k)); }    // 1 <= k <= 32
+    void skip(int k) { cache <<= k; cnt -= k; }
+    uint32_t get(int k) { const uint32_t v = peek(k); skip(k); return v; }
 };
 
-inline int DecodeHuff(BitReader &br, const HuffTable &h)
+/* JPEG "receive + extend" for a symbol the lookup could not finish. SSSS 16 carries no
+   difference bits: the difference is 32768 (T.81 H.1.2.2; what DNG writers emit). */
+inline int Receive(BitReader &br, int s)
 {
-    int l = 1, code = br.bit();
-    while (l <= 16 && code > h.maxcode[l]) { ++l; code = (code << 1) | br.bit(); }
-    if (l > 16) return 0;
-    return h.vals[h.valptr[l] + code - h.mincode[l]];
+    if (s == 0) return 0;
+    if (s >= 16) return -32768;
+    return Extend(int(br.get(s)), s);
 }
 
-/* JPEG "receive + extend": read s bits, sign-extend to the signed difference. */
-inline int Receive(BitReader &br, int s)
+/* The next sample's difference: one lookup for the common case, else the canonical
+   search over code lengths kLutBits+1 .. 16. */
+inline int DecodeDiff(BitReader &br, const HuffTable &h)
 {
-    if (s == 0) return 0;
-    int v = static_cast<int>(br.bits(s));
-    if (v < (1 << (s - 1))) v += (-1 << s) + 1;
-    return v;
+    if (br.cnt < 32) br.fill();
+    const Lut e = h.lut[br.peek(kLutBits)];
+    if (e.len) {
+        br.skip(e.len);
+        return e.sym == kFull ? e.diff : Receive(br, e.sym);
+    }
+    const int bits16 = int(br.peek(16));
+    int l = kLutBits + 1;
+    int code = bits16 >> (16 - l);
+    while (l <= 16 && code > h.maxcode[l]) { ++l; code = bits16 >> (16 - l); }
+    if (l > 16) { br.skip(16); return 0; }          // no such code: corrupt data
+    br.skip(l);
+    return Receive(br, h.vals[h.valptr[l] + code - h.mincode[l]]);
 }
 
 inline uint16_t rd16(const uint8_t *p) { return uint16_t((p[0] << 8) | p[1]); }
 
 void setErr(QString *err, const char *m) { if (err) *err = QString::fromLatin1(m); }
 
-} // namespace
-
-bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
-{
-    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) { setErr(err, "ljpeg: no SOI"); return false; }
-
+/* Everything the markers ahead of the entropy-coded data say about the scan. */
+struct Frame {
     HuffTable huff[4];          // up to 4 DC tables (Th 0..3)
     int prec = 0, Y = 0, X = 0, Nf = 0;
-    int psv = 1, Pt = 0, Ri = 0;
+    int psv = 1, Pt = 0;
     int scanTd[4] = {0, 0, 0, 0};   // per scan-component Huffman table selector
-    int scanNs = 0;
+    size_t scanStart = 0;           // first byte of entropy-coded data
+};
+
+bool ReadHeader(const uint8_t *data, size_t size, Frame &f, QString *err)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) { setErr(err, "ljpeg: no SOI"); return false; }
 
+    int Ri = 0, scanNs = 0;
     size_t p = 2;
     bool haveScan = false;
     while (p + 1 < size) {
@@ -123,13 +187,13 @@ bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
 
         if (marker == 0xC3) {                            // SOF3 (lossless, Huffman)
             if (segLen < 6) { setErr(err, "ljpeg: short SOF3"); return false; }
-            prec = seg[0];
-            Y = (seg[1] << 8) | seg[2];
-            X = (seg[3] << 8) | seg[4];
-            Nf = seg[5];
-            if (Nf < 1 || Nf > 4 || prec < 2 || prec > 16) { setErr(err, "ljpeg: unsupported SOF3"); return false; }
-            if (segLen < 6 + Nf * 3) { setErr(err, "ljpeg: short SOF3 components"); return false; }
-            for (int i = 0; i < Nf; ++i) {
+            f.prec = seg[0];
+            f.Y = (seg[1] << 8) | seg[2];
+            f.X = (seg[3] << 8) | seg[4];
+            f.Nf = seg[5];
+            if (f.Nf < 1 || f.Nf > 4 || f.prec < 2 || f.prec > 16) { setErr(err, "ljpeg: unsupported SOF3"); return false; }
+            if (segLen < 6 + f.Nf * 3) { setErr(err, "ljpeg: short SOF3 components"); return false; }
+            for (int i = 0; i < f.Nf; ++i) {
                 const uint8_t hv = seg[7 + i * 3];
                 if ((hv >> 4) != 1 || (hv & 0xF) != 1) { setErr(err, "ljpeg: subsampling unsupported"); return false; }
             }
@@ -150,7 +214,7 @@ bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
                 for (int i = 0; i < 16; ++i) { counts[i] = seg[q + i]; nsym += counts[i]; }
                 q += 16;
                 if (q + nsym > segLen) { setErr(err, "ljpeg: bad Huffman table"); return false; }
-                huff[Th].build(counts, seg + q, nsym);
+                f.huff[Th].build(counts, seg + q, nsym);
                 q += nsym;
             }
         }
@@ -160,9 +224,9 @@ bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
         else if (marker == 0xDA) {                       // SOS
             const int Ns = seg[0];
             if (Ns < 1 || Ns > 4 || segLen < 1 + Ns * 2 + 3) { setErr(err, "ljpeg: bad SOS"); return false; }
-            for (int i = 0; i < Ns; ++i) scanTd[i] = seg[2 + i * 2] >> 4;
-            psv = seg[1 + Ns * 2];
-            Pt  = seg[3 + Ns * 2] & 0xF;
+            for (int i = 0; i < Ns; ++i) f.scanTd[i] = seg[2 + i * 2] >> 4;
+            f.psv = seg[1 + Ns * 2];
+            f.Pt  = seg[3 + Ns * 2] & 0xF;
             scanNs = Ns;
             haveScan = true;
             p += L;
@@ -171,63 +235,146 @@ bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
         p += L;
     }
 
-    if (!haveScan || Nf == 0 || X == 0 || Y == 0) { setErr(err, "ljpeg: missing SOF/SOS"); return false; }
-    if (scanNs != Nf) { setErr(err, "ljpeg: scan/frame component mismatch"); return false; }
+    if (!haveScan || f.Nf == 0 || f.X == 0 || f.Y == 0) { setErr(err, "ljpeg: missing SOF/SOS"); return false; }
+    if (scanNs != f.Nf) { setErr(err, "ljpeg: scan/frame component mismatch"); return false; }
     if (Ri != 0) { setErr(err, "ljpeg: restart intervals not supported yet"); return false; }
-    for (int c = 0; c < Nf; ++c)
-        if (!huff[scanTd[c]].built) { setErr(err, "ljpeg: missing Huffman table"); return false; }
-    if (psv < 1 || psv > 7) { setErr(err, "ljpeg: bad predictor"); return false; }
-
-    const int clrs = Nf;
-    out.width = X;
-    out.height = Y;
-    out.components = clrs;
-    out.precision = prec;
-    out.samples.assign(static_cast<size_t>(X) * Y * clrs, 0);
-
-    BitReader br{data + p, size - p};
-    const int def = 1 << (prec - Pt - 1);
-    const int mask = 0xFFFF;
-
-    std::vector<int> cur(static_cast<size_t>(X) * clrs, 0);
-    std::vector<int> above(static_cast<size_t>(X) * clrs, def);
-
-    for (int row = 0; row < Y; ++row) {
-        for (int col = 0; col < X; ++col) {
-            for (int c = 0; c < clrs; ++c) {
-                const int s = DecodeHuff(br, huff[scanTd[c]]);
-                const int diff = Receive(br, s);
-
-                int pred;
-                if (col == 0) {
-                    pred = (row == 0) ? def : above[c];                 // first column: Rb
-                } else if (row == 0) {
-                    pred = cur[(col - 1) * clrs + c];                   // first row: Ra
-                } else {
-                    const int Ra = cur[(col - 1) * clrs + c];
-                    const int Rb = above[col * clrs + c];
-                    const int Rc = above[(col - 1) * clrs + c];
-                    switch (psv) {
-                    case 1:  pred = Ra; break;
-                    case 2:  pred = Rb; break;
-                    case 3:  pred = Rc; break;
-                    case 4:  pred = Ra + Rb - Rc; break;
-                    case 5:  pred = Ra + ((Rb - Rc) >> 1); break;
-                    case 6:  pred = Rb + ((Ra - Rc) >> 1); break;
-                    default: pred = (Ra + Rb) >> 1; break;              // 7
-                    }
-                }
+    for (int c = 0; c < f.Nf; ++c)
+        if (f.scanTd[c] > 3 || !f.huff[f.scanTd[c]].built) { setErr(err, "ljpeg: missing Huffman table"); return false; }
+    if (f.psv < 1 || f.psv > 7) { setErr(err, "ljpeg: bad predictor"); return false; }
+    if (f.prec - f.Pt < 1) { setErr(err, "ljpeg: bad point transform"); return false; }
+    f.scanStart = p;
+    return true;
+}
 
-                const int val = (pred + diff) & mask;
-                cur[col * clrs + c] = val;
-                out.samples[(static_cast<size_t>(row) * X + col) * clrs + c] =
-                    static_cast<uint16_t>((val << Pt) & mask);
-            }
+template <int Psv>
+inline int Predict(int Ra, int Rb, int Rc)
+{
+    switch (Psv) {
+    case 1:  return Ra;
+    case 2:  return Rb;
+    case 3:  return Rc;
+    case 4:  return Ra + Rb - Rc;
+    case 5:  return Ra + ((Rb - Rc) >> 1);
+    case 6:  return Rb + ((Ra - Rc) >> 1);
+    default: return (Ra + Rb) >> 1;                     // 7
+    }
+}
+
+/*
+    The scan loop, one instantiation per predictor so the per-sample switch folds away.
+    Line history is kept unshifted in 16 bits (every value is masked to 16 bits anyway), so
+    with Pt == 0 -- all raw files -- the decoded line is handed to the sink as is.
+*/
+template <int Psv, typename Sink>
+void ScanLines(BitReader &br, const Frame &f, Sink &sink)
+{
+    const int clrs = f.Nf;
+    const int n = f.X * clrs;
+    const int def = 1 << (f.prec - f.Pt - 1);
+    const HuffTable *tab[4];
+    for (int c = 0; c < clrs; ++c) tab[c] = &f.huff[f.scanTd[c]];
+
+    std::vector<uint16_t> lines(size_t(n) * (f.Pt ? 3 : 2));
+    uint16_t *cur = lines.data();
+    uint16_t *above = cur + n;
+    uint16_t *shifted = f.Pt ? above + n : nullptr;
+
+    for (int row = 0; row < f.Y; ++row) {
+        if (row == 0) {
+            for (int c = 0; c < clrs; ++c)                          // first sample: default
+                cur[c] = uint16_t(def + DecodeDiff(br, *tab[c]));
+            for (int i = clrs; i < n; i += clrs)                     // first row: Ra
+                for (int c = 0; c < clrs; ++c)
+                    cur[i + c] = uint16_t(cur[i - clrs + c] + DecodeDiff(br, *tab[c]));
+        } else {
+            for (int c = 0; c < clrs; ++c)                          // first column: Rb
+                cur[c] = uint16_t(above[c] + DecodeDiff(br, *tab[c]));
+            for (int i = clrs; i < n; i += clrs)
+                for (int c = 0; c < clrs; ++c) {
+                    const int pred = Predict<Psv>(cur[i - clrs + c], above[i + c],
+                                                  above[i - clrs + c]);
+                    cur[i + c] = uint16_t(pred + DecodeDiff(br, *tab[c]));
+                }
         }
-        cur.swap(above);
+        if (shifted) {
+            for (int i = 0; i < n; ++i) shifted[i] = uint16_t(cur[i] << f.Pt);
+            sink(row, shifted, n);
+        } else {
+            sink(row, cur, n);
+        }
+        std::swap(cur, above);
+    }
+}
+
+template <typename Sink>
+bool Scan(const uint8_t *data, size_t size, const Frame &f, Sink &sink)
+{
+    BitReader br{data + f.scanStart, size - f.scanStart};
+    switch (f.psv) {
+    case 1:  ScanLines<1>(br, f, sink); break;
+    case 2:  ScanLines<2>(br, f, sink); break;
+    case 3:  ScanLines<3>(br, f, sink); break;
+    case 4:  ScanLines<4>(br, f, sink); break;
+    case 5:  ScanLines<5>(br, f, sink); break;
+    case 6:  ScanLines<6>(br, f, sink); break;
+    default: ScanLines<7>(br, f, sink); break;
     }
+    return true;
+}
+
+} // namespace
+
+bool Decode(const uint8_t *data, size_t size, Image &out, QString *err)
+{
+    Frame f;
+    if (!ReadHeader(data, size, f, err)) return false;
+
+    out.width = f.X;
+    out.height = f.Y;
+    out.components = f.Nf;
+    out.precision = f.prec;
+    out.samples.resize(static_cast<size_t>(f.X) * f.Y * f.Nf);   // every line is written
+
+    uint16_t *dst = out.samples.data();
+    auto sink = [dst](int y, const uint16_t *line, int n) {
+        std::memcpy(dst + size_t(y) * n, line, size_t(n) * sizeof(uint16_t));
+    };
+    return Scan(data, size, f, sink);
+}
 
+bool ReadFrame(const uint8_t *data, size_t size, Image &info, QString *err)
+{
+    Frame f;
+    if (!ReadHeader(data, size, f, err)) return false;
+    info.width = f.X;
+    info.height = f.Y;
+    info.components = f.Nf;
+    info.precision = f.prec;
+    info.samples.clear();
     return true;
 }
 
+bool DecodeInto(const uint8_t *data, size_t size, const Target &t, QString *err)
+{
+    if (!t.dst || t.x0 < 0 || t.y0 < 0) { setErr(err, "ljpeg: bad target"); return false; }
+    Frame f;
+    if (!ReadHeader(data, size, f, err)) return false;
+
+    /* Lines past the bottom are still decoded (the bitstream is sequential) but dropped. */
+    const int visible = std::clamp(t.width - t.x0, 0, f.X * f.Nf);
+    auto sink = [&t, visible](int y, const uint16_t *line, int) {
+        const int cy = t.y0 + y;
+        if (cy >= t.height || !visible) return;
+        std::memcpy(t.dst + size_t(cy) * t.stride + t.x0, line, size_t(visible) * sizeof(uint16_t));
+    };
+    return Scan(data, size, f, sink);
+}
+
+bool DecodeRows(const uint8_t *data, size_t size, const RowFn &rowFn, QString *err)
+{
+    Frame f;
+    if (!ReadHeader(data, size, f, err)) return false;
+    return Scan(data, size, f, rowFn);
+}
+
 } // namespace LosslessJpeg
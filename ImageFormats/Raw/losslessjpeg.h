@@ -2,6 +2,7 @@
 #define LOSSLESSJPEG_H
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <QString>
 
@@ -21,6 +22,21 @@
     sensor encoded as 2 components, width is half the sensor width and the caller interleaves the
     two components back to full width.
 
+    Three ways to receive the samples, all from the same scan loop:
+      Decode      -- into an Image that owns the whole raster (simplest; one full-size copy)
+      DecodeInto  -- straight into the caller's mosaic at a grid position (DNG tiles/strips:
+                     no intermediate buffer, and independent tiles can run on different threads)
+      DecodeRows  -- one decoded line at a time to a callback (CR2, whose slice layout is not
+                     a rectangle the decoder can write to)
+
+    The entropy decoder is table driven: one lookup on the next kLutBits bits of the stream
+    yields the Huffman code length and, for short codes followed by a short difference, the
+    decoded difference too -- so the common case is one lookup and one shift per sample.
+    Longer codes fall back to the canonical (mincode/maxcode) search.
+
+    The decoder keeps no state between calls and is safe to run concurrently on different
+    bytestreams.
+
     SCOPE: single scan, Huffman (not arithmetic), no restart intervals (DRI/RSTn) yet -- those
     return false so the caller can fall back. Covers CR2 and uncompressed/lossless-JPEG DNG.
 */
@@ -48,6 +64,36 @@ struct Image {
 */
 bool Decode(const uint8_t *data, size_t size, Image &out, QString *err = nullptr);
 
+/*
+    Read only the frame: fills width, height, components and precision and leaves samples
+    empty. For callers that size their destination before DecodeInto / DecodeRows.
+*/
+bool ReadFrame(const uint8_t *data, size_t size, Image &info, QString *err = nullptr);
+
+/*
+    Destination for DecodeInto. Sample c of scan column x on scan line y is written to
+    dst[(y0 + y) * stride + x0 + x * components + c]; anything at or past width / height is
+    dropped (edge tiles of a DNG overhang the image). x0 / y0 must be >= 0.
+*/
+struct Target {
+    uint16_t *dst = nullptr;
+    int stride = 0;         // samples per destination row
+    int width = 0;          // destination columns
+    int height = 0;         // destination rows
+    int x0 = 0;
+    int y0 = 0;
+};
+
+bool DecodeInto(const uint8_t *data, size_t size, const Target &target, QString *err = nullptr);
+
+/*
+    Decode line by line: rowFn(y, samples, count) is called once per scan line, in order, with
+    the line's component-interleaved samples (count = width * components). The pointer is only
+    valid during the call. Returns false on the same conditions as Decode.
+*/
+using RowFn = std::function<void(int y, const uint16_t *samples, int count)>;
+bool DecodeRows(const uint8_t *data, size_t size, const RowFn &rowFn, QString *err = nullptr);
+
 } // namespace LosslessJpeg
 
 #endif // LOSSLESSJPEG_H
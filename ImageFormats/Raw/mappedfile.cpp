@@ -0,0 +1,64 @@
+#include "ImageFormats/Raw/mappedfile.h"
+#include <QtGlobal>
+#include <algorithm>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(QFile &f)
+    : file(f)
+{
+    if (!file.isOpen() && !file.open(QIODevice::ReadOnly)) return;
+    const qint64 n = file.size();
+    if (n <= 0) return;
+    map = file.map(0, n);
+    if (map) {
+        bytes = map;
+        length = n;
+        return;
+    }
+    if (!file.seek(0)) return;
+    buffer = file.readAll();
+    if (buffer.isEmpty()) return;
+    bytes = reinterpret_cast<const uchar *>(buffer.constData());
+    length = buffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+    if (map) file.unmap(map);
+}
+
+const uchar *MappedFile::at(qint64 off, qint64 len) const
+{
+    if (!bytes || off < 0 || len < 0 || off > length || len > length - off) return nullptr;
+    return bytes + off;
+}
+
+qint64 MappedFile::available(qint64 off) const
+{
+    return (off >= 0 && off < length) ? length - off : 0;
+}
+
+QByteArray MappedFile::read(qint64 off, qint64 n) const
+{
+    n = std::min(n, available(off));
+    if (n <= 0) return QByteArray();
+    return QByteArray(reinterpret_cast<const char *>(bytes + off), n);
+}
+
+void MappedFile::willNeed(qint64 off, qint64 len) const
+{
+#ifdef Q_OS_UNIX
+    len = std::min(len, available(off));
+    if (!map || len <= 0) return;
+    /* madvise wants a page-aligned start; the mapping itself starts on a page. */
+    const qint64 page = qint64(sysconf(_SC_PAGESIZE));
+    const qint64 start = page > 0 ? off - off % page : off;
+    posix_madvise(map + start, size_t(off + len - start), POSIX_MADV_WILLNEED);
+#else
+    Q_UNUSED(off)
+    Q_UNUSED(len)
+#endif
+}
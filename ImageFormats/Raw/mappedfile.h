@@ -0,0 +1,58 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <QFile>
+#include <QByteArray>
+
+/*
+    The whole RAW file as one read-only byte range, for RawFormat::UnpackCfa and the TiffWalk
+    reader it uses. RawFormat::Decode builds one per decode and every stage reads from it.
+
+    The file is memory-mapped, so a decode costs no copy of the file: the sensor data is read
+    straight from the page cache into RawImage::cfa. Before, a 50-60 MB NEF was readAll()'d into
+    the heap, and a CR3 was read and then copied a second time. Pages load as the decoder first
+    touches them. willNeed() asks the OS to start reading the sensor data in the background once
+    its offset is known, so the first rows decode while the rest is still coming off the disk.
+
+    Only when the file cannot be mapped (not a local file, exotic filesystem) is it read into a
+    buffer instead -- the old behaviour, same bytes, same API.
+
+    The QFile must stay open for the MappedFile's lifetime; pointers from data()/at() are valid
+    until it is destroyed.
+*/
+class MappedFile
+{
+public:
+    explicit MappedFile(QFile &f);          // opens the file read-only if it is not open
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isValid() const { return bytes != nullptr; }
+    bool isMapped() const { return map != nullptr; }
+    QString fileName() const { return file.fileName(); }
+
+    const uchar *data() const { return bytes; }
+    qint64 size() const { return length; }
+
+    /* [off, off + len), or nullptr unless that range lies entirely inside the file. */
+    const uchar *at(qint64 off, qint64 len) const;
+    /* Bytes from off to the end of the file (0 when off is outside it). */
+    qint64 available(qint64 off) const;
+    /* A copy of [off, off + n) clipped to the file: short for a range past the end, like
+       QFile::read. For header and tag reads. */
+    QByteArray read(qint64 off, qint64 n) const;
+
+    /* Hint that [off, off + len) is about to be read: start paging it in now. No-op when
+       the file is not mapped or the OS has no such hint. */
+    void willNeed(qint64 off, qint64 len) const;
+
+private:
+    QFile &file;
+    uchar *map = nullptr;
+    QByteArray buffer;                      // fallback when the file cannot be mapped
+    const uchar *bytes = nullptr;
+    qint64 length = 0;
+};
+
+#endif // MAPPEDFILE_H
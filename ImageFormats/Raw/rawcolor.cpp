@@ -1,4 +1,5 @@
 #include "ImageFormats/Raw/rawcolor.h"
+#include "ImageFormats/Raw/rawkernels.h"
 #include "Develop/whitebalance.h"
 #include <cmath>
 
@@ -38,8 +39,14 @@ bool RawColor::ToWorking(const RawImage &raw,
                          const std::vector<float> &rgb,
                          WorkingImage &out)
 {
-    const int W = raw.width;
-    const int H = raw.height;
+    return ToWorking(raw, rgb, raw.width, raw.height, out);
+}
+
+bool RawColor::ToWorking(const RawImage &raw,
+                         const std::vector<float> &rgb,
+                         int W, int H,
+                         WorkingImage &out)
+{
     if (W <= 0 || H <= 0) return false;
     if (rgb.size() != static_cast<size_t>(W) * static_cast<size_t>(H) * 3) return false;
 
@@ -118,25 +125,12 @@ bool RawColor::ToWorking(const RawImage &raw,
     out.height = H;
     out.white = 1.0f;       // rgb was scaled to 0..1 by Demosaic using raw.white
     out.sceneReferred = true;   // sensor data -> OutputTransform applies the baseline tone curve
-    out.rgb.assign(static_cast<size_t>(W) * static_cast<size_t>(H) * 3, 0.0f);
-
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            const size_t o = (static_cast<size_t>(y) * W + x) * 3;
-            /* White balance in camera space. */
-            const float cam[3] = {
-                rgb[o + 0] * wb[0],
-                rgb[o + 1] * wb[1],
-                rgb[o + 2] * wb[2]
-            };
-            /* Camera -> linear sRGB. Clamp negatives (out-of-gamut) but keep highlight
-               headroom (values may exceed 1) so OutputTransform's baseline tone curve can roll
-               highlights off instead of hard-clipping them here. */
-            for (int c = 0; c < 3; ++c) {
-                const float v = m[c][0] * cam[0] + m[c][1] * cam[1] + m[c][2] * cam[2];
-                out.rgb[o + c] = v < 0.0f ? 0.0f : v;
-            }
-        }
-    }
+    /* One pass: every element is written by the kernel, so a buffer of the right size is
+       not zeroed first. White balance in camera space, then camera -> linear sRGB,
+       negatives (out-of-gamut) clamped, highlight headroom above 1 kept for
+       OutputTransform's baseline tone curve -- SIMD where the CPU has it (RawKernels). */
+    const size_t n = static_cast<size_t>(W) * static_cast<size_t>(H);
+    if (out.rgb.size() != n * 3) out.rgb.assign(n * 3, 0.0f);
+    RawKernels::CamToWorking(rgb.data(), out.rgb.data(), n, wb, m);
     return true;
 }
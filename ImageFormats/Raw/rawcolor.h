@@ -24,6 +24,13 @@ public:
     bool ToWorking(const RawImage &raw,
                    const std::vector<float> &rgb,
                    WorkingImage &out);
+
+    /* Same, for rgb that is not raw.width x raw.height (Demosaic::RunHalfSize): raw
+       supplies only the colour characterisation. */
+    bool ToWorking(const RawImage &raw,
+                   const std::vector<float> &rgb,
+                   int width, int height,
+                   WorkingImage &out);
 };
 
 #endif // RAWCOLOR_H
@@ -1,12 +1,14 @@
 #include "ImageFormats/Raw/rawformat.h"
 #include "ImageFormats/Raw/demosaic.h"
 #include "ImageFormats/Raw/rawcolor.h"
+#include "ImageFormats/Raw/rawkernels.h"
 #include "ImageFormats/Raw/pmrid.h"
 #include "ImageFormats/Raw/applerawdecode.h"
 #include "Develop/workingimage.h"
 #include "Develop/develop.h"
 #include "Develop/outputtransform.h"
 #include "Main/global.h"
+#include "Cache/decodetier.h"
 #include <algorithm>
 #include <QHash>
 
@@ -77,6 +79,7 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
         UnpackCfa()         per-format bitstream -> normalised CFA mosaic   (virtual)
         SubtractBlack()                                                      (shared)
         Demosaic::Run()     mosaic -> linear camera RGB                      (shared)
+                            (RunHalfSize for a reduced decode, SetReduceToEdge)
         RawColor::ToWorking() white balance + matrix -> LINEAR WorkingImage  (shared)
         Develop::Apply()    parametric adjustments in linear space           (shared, opt)
         OutputTransform::ToImage() gamma/ICC -> display QImage               (shared)
@@ -91,6 +94,8 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
        every early return -- unsupported format, abort, Apple engine -- reads as "not
        denoised" rather than leaving the caller's flag untouched. */
     if (outDenoiseApplied) *outDenoiseApplied = false;
+    halfSize = false;
+    sensorSize = QSize();
 
     auto work = std::make_shared<WorkingImage>();
     bool decoded = false;
@@ -117,9 +122,17 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
     if (!decoded) {
         /* Engine B (portable): in-house sensor decode. */
         RawImage raw;
-        if (!UnpackCfa(file, m, raw)) {
-            if (errMsg.isEmpty()) errMsg = "UnpackCfa failed.";
-            return false;
+        {
+            /* One mapping of the file for the unpack, dropped once the mosaic exists. */
+            const MappedFile mapped(file);
+            if (!mapped.isValid()) {
+                errMsg = "Could not read " + file.fileName() + ".";
+                return false;
+            }
+            if (!UnpackCfa(mapped, m, raw)) {
+                if (errMsg.isEmpty()) errMsg = "UnpackCfa failed.";
+                return false;
+            }
         }
         if (!raw.isValid()) {
             errMsg = "UnpackCfa produced an invalid RawImage.";
@@ -128,6 +141,40 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
         if (aborted()) { errMsg = "Aborted"; return false; }
 
         SubtractBlack(raw);
+        sensorSize = QSize(raw.width, raw.height);
+
+        /* Half-size preview (SetReduceToEdge): the view only needs reduceToEdge pixels on
+           the long edge, so when half the sensor covers that, each Bayer quad becomes one
+           pixel and the full demosaic is deferred to the decode that zoom or Develop asks
+           for. renderScale tells Develop's one absolute-radius op (Sharpen) the image is
+           downscaled. Not a develop base, so outWork stays empty. */
+        const bool bayer = raw.pattern != CfaPattern::XTrans
+                           && raw.pattern != CfaPattern::Unknown;
+        halfSize = Winnow::Cache::DecodeTier::halfSize(reduceToEdge, raw.width, raw.height,
+                                                       bayer, denoiseRaw);
+        if (halfSize) {
+            Demosaic preview;
+            std::vector<float> rgb;
+            int halfW = 0, halfH = 0;
+            if (!preview.RunHalfSize(raw, rgb, halfW, halfH, abort)) {
+                errMsg = aborted() ? "Aborted" : "Half-size demosaic failed.";
+                return false;
+            }
+            RawColor color;
+            if (!color.ToWorking(raw, rgb, halfW, halfH, *work)) {
+                errMsg = "Colour conversion failed.";
+                return false;
+            }
+            work->renderScale = static_cast<float>(std::max(halfW, halfH)) /
+                                static_cast<float>(std::max(raw.width, raw.height));
+            if (aborted()) { errMsg = "Aborted"; return false; }
+            return Render(*work, edit, abort, out);
+        }
+
+        /* One algorithm for every demosaic of this decode: the clean and PMRID-denoised
+           bases below are blended pixel for pixel, so they must not differ in method.
+           On an X-Trans mosaic RCD runs as Markesteijn (Demosaic::Run). */
+        const Demosaic::Algorithm demAlgo = G::useRcdDemosaic ? Demosaic::RCD : Demosaic::Bilinear;
 
         /* Combined status-bar progress for a "Denoise raw" decode: the clean pre-PMRID
            demosaic, the PMRID model, and the denoised demosaic each drive a slice of one
@@ -154,7 +201,7 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
                 RawColor cleanColor;
                 auto cleanWork = std::make_shared<WorkingImage>();
                 auto cleanProg = [&stage](int d, int t) { stage(0, 250, d, t); };
-                if (cleanDemosaic.Run(raw, rgbClean, Demosaic::Bilinear, abort, cleanProg) &&
+                if (cleanDemosaic.Run(raw, rgbClean, demAlgo, abort, cleanProg) &&
                     cleanColor.ToWorking(raw, rgbClean, *cleanWork)) {
                     *outClean = cleanWork;
                 }
@@ -174,7 +221,7 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
         /* A clean (non-denoise) decode with a progress sink: the demosaic drives the
            whole bar -- lets MW::ensureDevelopWork show demosaic progress on open. */
         else if (denoiseProgress) demProg = [&stage](int d, int t) { stage(0, 1000, d, t); };
-        if (!demosaic.Run(raw, rgb, Demosaic::Bilinear, abort, demProg)) {
+        if (!demosaic.Run(raw, rgb, demAlgo, abort, demProg)) {
             errMsg = aborted() ? "Aborted" : "Demosaic failed (unsupported CFA pattern?).";
             return false;
         }
@@ -200,7 +247,7 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
             if (applied) {
                 std::vector<float> rgbDen;
                 WorkingImage pmridWork;
-                if (demosaic.Run(rawDen, rgbDen, Demosaic::Bilinear, abort) &&
+                if (demosaic.Run(rawDen, rgbDen, demAlgo, abort) &&
                     color.ToWorking(rawDen, rgbDen, pmridWork)) {
                     denoisedBase = std::make_shared<WorkingImage>();
                     Develop::BlendRawDenoise(*work, pmridWork, edit->denoiseLuma,
@@ -224,13 +271,22 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
        PRE-demosaic denoiser: when set it is baked into denoisedBase above (a blended copy),
        leaving *work clean, and the develop pass renders from that base so the exported/displayed
        image matches the interactive preview (MW::ensureRawDenoise). */
+    return Render(denoisedBase ? *denoisedBase : *work, edit, abort, out);
+}
+
+bool RawFormat::Render(const WorkingImage &base, const EditParams *edit,
+                       const QAtomicInt *abort, QImage &out)
+{
+    /* Develop (on a private copy: base may be the shared cached image) + OutputTransform. */
+    const auto aborted = [abort]{ return abort && abort->loadAcquire(); };
     OutputTransform output;
+    const auto space = OutputTransform::Space::sRGB;
     if (edit && !edit->isIdentity()) {
-        WorkingImage developed = denoisedBase ? *denoisedBase : *work;
+        WorkingImage developed = base;
         Develop develop;
         develop.Apply(developed, *edit);
         if (aborted()) { errMsg = "Aborted"; return false; }
-        if (!output.ToImage(developed, out)) {
+        if (!output.ToImage(developed, out, space, QImage::Format_RGB32)) {
             errMsg = "Output transform failed.";
             return false;
         }
@@ -238,7 +294,7 @@ bool RawFormat::Decode(QFile &file, const ImageMetadata &m, QImage &out,
     }
     if (aborted()) { errMsg = "Aborted"; return false; }
 
-    if (!output.ToImage(*work, out)) {
+    if (!output.ToImage(base, out, space, QImage::Format_RGB32)) {
         errMsg = "Output transform failed.";
         return false;
     }
@@ -251,16 +307,8 @@ void RawFormat::SubtractBlack(RawImage &raw)
     for (int i = 0; i < 4; ++i) maxBlack = std::max(maxBlack, raw.black[i]);
     if (maxBlack == 0) return;
 
-    const int W = raw.width;
-    const int H = raw.height;
-    for (int y = 0; y < H; ++y) {
-        const int rowBit = (y & 1) << 1;
-        for (int x = 0; x < W; ++x) {
-            const uint16_t b = raw.black[rowBit | (x & 1)];
-            uint16_t &v = raw.cfa[static_cast<size_t>(y) * W + x];
-            v = (v > b) ? static_cast<uint16_t>(v - b) : uint16_t(0);
-        }
-    }
+    /* Saturating per-2x2-position subtract, vectorised (RawKernels). */
+    RawKernels::SubtractBlack(raw.cfa.data(), raw.width, raw.height, raw.black);
     raw.white = (raw.white > maxBlack)
                     ? static_cast<uint16_t>(raw.white - maxBlack)
                     : raw.white;
@@ -9,6 +9,7 @@
 #include <QAtomicInt>
 #include "Metadata/imagemetadata.h"
 #include "ImageFormats/Raw/rawimage.h"
+#include "ImageFormats/Raw/mappedfile.h"
 #include "Develop/editparams.h"
 #include "Develop/workingimage.h"
 
@@ -42,7 +43,8 @@ public:
        (see rawformat.cpp), so the two can never drift out of sync. */
     static bool HasSensorDecoder(const QString &ext);
 
-    /* Full sensor decode: file -> demosaiced, colour-managed display QImage. When edit is
+    /* Full sensor decode: file -> demosaiced, colour-managed display QImage, in Format_RGB32
+       so the image cache can hand it to the loupe as is (ImageCacheData). When edit is
        non-null and non-identity, develop adjustments are applied in the linear working space
        (before the output transform). abort (when non-null) is polled between stages and inside
        the demosaic loop so a long decode can bail promptly on shutdown / navigation; an aborted
@@ -81,15 +83,40 @@ public:
 
     QString lastError() const { return errMsg; }
 
+    /* Reduced decode for a fit-to-window view (ImageDecoder::reduceToEdge). When edge > 0
+       and half the sensor's long edge still covers it, Decode() takes the half-size preview
+       path: Demosaic::RunHalfSize instead of the full demosaic, and RawColor, Develop and
+       OutputTransform on a quarter of the pixels. outWork is then left empty -- a half-size
+       image must never become the cached develop base -- and "Denoise raw" (denoiseRaw, or a
+       saved denoise edit) is not applied. Bayer only; X-Trans, a "Denoise raw" decode and a
+       sensor too small to halve decode in full as before. 0 (the default) is always full. */
+    void SetReduceToEdge(int edge) { reduceToEdge = edge; }
+
+    /* After Decode(): whether it took the half-size path, and the full sensor size (active
+       area) the image stands in for. Invalid for the Apple engine. */
+    bool DecodedHalfSize() const { return halfSize; }
+    QSize SensorSize() const { return sensorSize; }
+
 protected:
     /* THE override point. Read the vendor bitstream described by m and produce a
-       normalised CFA mosaic in raw (width/height/pattern/levels/matrix). */
-    virtual bool UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw) = 0;
+       normalised CFA mosaic in raw (width/height/pattern/levels/matrix). file is the
+       whole RAW file, mapped once by Decode(); read it in place rather than copying. */
+    virtual bool UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw) = 0;
 
     /* Shared pre-demosaic step: per-2x2-position black subtraction + clip. */
     static void SubtractBlack(RawImage &raw);
 
     QString errMsg;
+
+private:
+    /* Decode()'s last stage: develop base (when edit is non-identity) and output transform
+       to RGB32. */
+    bool Render(const WorkingImage &base, const EditParams *edit,
+                const QAtomicInt *abort, QImage &out);
+
+    int reduceToEdge = 0;
+    bool halfSize = false;
+    QSize sensorSize;
 };
 
 #endif // RAWFORMAT_H
@@ -0,0 +1,480 @@
+#include "ImageFormats/Raw/rawkernels.h"
+#include <algorithm>
+#include <cmath>
+
+WINNOW_SIMD_NO_FP_CONTRACT
+
+using Winnow::Simd::Level;
+
+namespace {
+
+/* ---- SubtractBlack ---------------------------------------------------------------- */
+
+void SubtractBlackRow(uint16_t *row, int from, int W, uint16_t bEven, uint16_t bOdd)
+{
+    for (int x = from; x < W; ++x) {
+        const uint16_t b = (x & 1) ? bOdd : bEven;
+        uint16_t &v = row[x];
+        v = (v > b) ? static_cast<uint16_t>(v - b) : uint16_t(0);
+    }
+}
+
+#if defined(WINNOW_SIMD_X86)
+/* SSE2 is the x86-64 baseline; the SSE4.1 level needs nothing newer here. */
+int SubtractBlackSse(uint16_t *row, int W, uint16_t bEven, uint16_t bOdd)
+{
+    const __m128i b = _mm_set_epi16(short(bOdd), short(bEven), short(bOdd), short(bEven),
+                                    short(bOdd), short(bEven), short(bOdd), short(bEven));
+    int x = 0;
+    for (; x + 8 <= W; x += 8) {
+        __m128i *p = reinterpret_cast<__m128i *>(row + x);
+        _mm_storeu_si128(p, _mm_subs_epu16(_mm_loadu_si128(p), b));
+    }
+    return x;
+}
+
+WINNOW_TARGET_AVX2
+int SubtractBlackAvx2(uint16_t *row, int W, uint16_t bEven, uint16_t bOdd)
+{
+    const __m256i b = _mm256_set1_epi32(int(uint32_t(bOdd) << 16 | bEven));
+    int x = 0;
+    for (; x + 16 <= W; x += 16) {
+        __m256i *p = reinterpret_cast<__m256i *>(row + x);
+        _mm256_storeu_si256(p, _mm256_subs_epu16(_mm256_loadu_si256(p), b));
+    }
+    return x;
+}
+#endif
+
+#if defined(WINNOW_SIMD_NEON)
+int SubtractBlackNeon(uint16_t *row, int W, uint16_t bEven, uint16_t bOdd)
+{
+    const uint16_t pat[8] = {bEven, bOdd, bEven, bOdd, bEven, bOdd, bEven, bOdd};
+    const uint16x8_t b = vld1q_u16(pat);
+    int x = 0;
+    for (; x + 8 <= W; x += 8)
+        vst1q_u16(row + x, vqsubq_u16(vld1q_u16(row + x), b));
+    return x;
+}
+#endif
+
+/* ---- CamToWorking ------------------------------------------------------------------ */
+
+void CamToWorkingScalar(const float *rgb, float *out, size_t from, size_t pixels,
+                        const float wb[3], const float m[3][3])
+{
+    for (size_t p = from; p < pixels; ++p) {
+        const size_t o = p * 3;
+        /* White balance in camera space. */
+        const float cam[3] = {
+            rgb[o + 0] * wb[0],
+            rgb[o + 1] * wb[1],
+            rgb[o + 2] * wb[2]
+        };
+        /* Camera -> linear sRGB. Clamp negatives (out-of-gamut) but keep highlight
+           headroom (values may exceed 1) so OutputTransform's baseline tone curve can roll
+           highlights off instead of hard-clipping them here. */
+        for (int c = 0; c < 3; ++c) {
+            const float v = m[c][0] * cam[0] + m[c][1] * cam[1] + m[c][2] * cam[2];
+            out[o + c] = v < 0.0f ? 0.0f : v;
+        }
+    }
+}
+
+#if defined(WINNOW_SIMD_X86)
+/*
+    Four pixels per step. The 12 interleaved floats are shuffled into planar R, G, B
+    registers, the maths runs in the scalar loop's exact order (mul, mul, add, mul, add),
+    and the result is shuffled back. A 256-bit version would need lane-crossing permutes
+    for the same shuffle, so the AVX2 level runs this kernel too (the mosaic stages get
+    the wider registers).
+        in:  A = r0 g0 b0 r1   B = g1 b1 r2 g2   C = b2 r3 g3 b3
+*/
+size_t CamToWorkingSse(const float *rgb, float *out, size_t pixels,
+                       const float wb[3], const float m[3][3])
+{
+    const __m128 wr = _mm_set1_ps(wb[0]), wg = _mm_set1_ps(wb[1]), wbl = _mm_set1_ps(wb[2]);
+    __m128 k[3][3];
+    for (int c = 0; c < 3; ++c)
+        for (int j = 0; j < 3; ++j) k[c][j] = _mm_set1_ps(m[c][j]);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t p = 0;
+    for (; p + 4 <= pixels; p += 4) {
+        const float *s = rgb + p * 3;
+        const __m128 A = _mm_loadu_ps(s), B = _mm_loadu_ps(s + 4), C = _mm_loadu_ps(s + 8);
+
+        const __m128 R = _mm_shuffle_ps(_mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 3, 0, 0)),
+                                        _mm_shuffle_ps(B, C, _MM_SHUFFLE(1, 1, 2, 2)),
+                                        _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 G = _mm_shuffle_ps(_mm_shuffle_ps(A, B, _MM_SHUFFLE(0, 0, 1, 1)),
+                                        _mm_shuffle_ps(B, C, _MM_SHUFFLE(2, 2, 3, 3)),
+                                        _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 Bl = _mm_shuffle_ps(_mm_shuffle_ps(A, B, _MM_SHUFFLE(1, 1, 2, 2)),
+                                         _mm_shuffle_ps(C, C, _MM_SHUFFLE(3, 3, 0, 0)),
+                                         _MM_SHUFFLE(2, 0, 2, 0));
+
+        const __m128 c0 = _mm_mul_ps(R, wr), c1 = _mm_mul_ps(G, wg), c2 = _mm_mul_ps(Bl, wbl);
+        __m128 v[3];
+        for (int c = 0; c < 3; ++c) {
+            const __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(k[c][0], c0), _mm_mul_ps(k[c][1], c1)),
+                                        _mm_mul_ps(k[c][2], c2));
+            v[c] = _mm_andnot_ps(_mm_cmplt_ps(t, zero), t);    // v < 0 ? 0 : v
+        }
+
+        // back to  r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+        const __m128 rg = _mm_unpacklo_ps(v[0], v[1]);                              // r0 g0 r1 g1
+        const __m128 o0 = _mm_shuffle_ps(rg, _mm_shuffle_ps(v[2], v[0], _MM_SHUFFLE(1, 1, 0, 0)),
+                                         _MM_SHUFFLE(2, 0, 1, 0));
+        const __m128 o1 = _mm_shuffle_ps(_mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 1, 1, 1)),
+                                         _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(2, 2, 2, 2)),
+                                         _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 o2 = _mm_shuffle_ps(_mm_shuffle_ps(v[2], v[0], _MM_SHUFFLE(3, 3, 2, 2)),
+                                         _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(3, 3, 3, 3)),
+                                         _MM_SHUFFLE(2, 0, 2, 0));
+        float *d = out + p * 3;
+        _mm_storeu_ps(d, o0);
+        _mm_storeu_ps(d + 4, o1);
+        _mm_storeu_ps(d + 8, o2);
+    }
+    return p;
+}
+#endif
+
+#if defined(WINNOW_SIMD_NEON)
+size_t CamToWorkingNeon(const float *rgb, float *out, size_t pixels,
+                        const float wb[3], const float m[3][3])
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    size_t p = 0;
+    for (; p + 4 <= pixels; p += 4) {
+        const float32x4x3_t in = vld3q_f32(rgb + p * 3);
+        const float32x4_t c0 = vmulq_n_f32(in.val[0], wb[0]);
+        const float32x4_t c1 = vmulq_n_f32(in.val[1], wb[1]);
+        const float32x4_t c2 = vmulq_n_f32(in.val[2], wb[2]);
+        float32x4x3_t o;
+        for (int c = 0; c < 3; ++c) {
+            const float32x4_t t = vaddq_f32(vaddq_f32(vmulq_n_f32(c0, m[c][0]), vmulq_n_f32(c1, m[c][1])),
+                                            vmulq_n_f32(c2, m[c][2]));
+            o.val[c] = vbslq_f32(vcltq_f32(t, zero), zero, t);
+        }
+        vst3q_f32(out + p * 3, o);
+    }
+    return p;
+}
+#endif
+
+/* ---- X-Trans Markesteijn homogeneity ---------------------------------------------- */
+
+void XTransPerceptualScalar(const float *r, const float *g, const float *b,
+                            float *l, float *a, float *bOut, int from, int n)
+{
+    for (int x = from; x < n; ++x) {
+        const float sr = std::sqrt(r[x] > 0.0f ? r[x] : 0.0f);
+        const float sg = std::sqrt(g[x] > 0.0f ? g[x] : 0.0f);
+        const float sb = std::sqrt(b[x] > 0.0f ? b[x] : 0.0f);
+        l[x] = (sr + (sg + sg) + sb) * 0.25f;
+        a[x] = sr - sg;
+        bOut[x] = sb - sg;
+    }
+}
+
+void XTransDerivativeScalar(const float *l, const float *a, const float *b, ptrdiff_t step,
+                            float *drv, int from, int n)
+{
+    for (int x = from; x < n; ++x) {
+        const float dl = (l[x] + l[x]) - l[x - step] - l[x + step];
+        const float da = (a[x] + a[x]) - a[x - step] - a[x + step];
+        const float db = (b[x] + b[x]) - b[x - step] - b[x + step];
+        drv[x] = (dl * dl + da * da) + db * db;
+    }
+}
+
+void XTransHomogeneityScalar(const float *const drv[4], ptrdiff_t stride,
+                             float *const homo[4], int from, int n)
+{
+    for (int x = from; x < n; ++x) {
+        const float t = std::min(std::min(drv[0][x], drv[1][x]),
+                                 std::min(drv[2][x], drv[3][x])) * 8.0f;
+        for (int d = 0; d < 4; ++d) {
+            float cnt = 0.0f;
+            for (int v = -1; v <= 1; ++v)
+                for (int h = -1; h <= 1; ++h)
+                    cnt += drv[d][x + v * stride + h] <= t ? 1.0f : 0.0f;
+            homo[d][x] = cnt;
+        }
+    }
+}
+
+#if defined(WINNOW_SIMD_X86)
+int XTransPerceptualSse(const float *r, const float *g, const float *b,
+                        float *l, float *a, float *bOut, int n)
+{
+    const __m128 zero = _mm_setzero_ps(), quarter = _mm_set1_ps(0.25f);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const __m128 sr = _mm_sqrt_ps(_mm_max_ps(_mm_loadu_ps(r + x), zero));
+        const __m128 sg = _mm_sqrt_ps(_mm_max_ps(_mm_loadu_ps(g + x), zero));
+        const __m128 sb = _mm_sqrt_ps(_mm_max_ps(_mm_loadu_ps(b + x), zero));
+        _mm_storeu_ps(l + x, _mm_mul_ps(_mm_add_ps(_mm_add_ps(sr, _mm_add_ps(sg, sg)), sb), quarter));
+        _mm_storeu_ps(a + x, _mm_sub_ps(sr, sg));
+        _mm_storeu_ps(bOut + x, _mm_sub_ps(sb, sg));
+    }
+    return x;
+}
+
+inline __m128 SecondDiffSse(const float *p, ptrdiff_t step)
+{
+    const __m128 c = _mm_loadu_ps(p);
+    return _mm_sub_ps(_mm_sub_ps(_mm_add_ps(c, c), _mm_loadu_ps(p - step)), _mm_loadu_ps(p + step));
+}
+
+int XTransDerivativeSse(const float *l, const float *a, const float *b, ptrdiff_t step,
+                        float *drv, int n)
+{
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const __m128 dl = SecondDiffSse(l + x, step);
+        const __m128 da = SecondDiffSse(a + x, step);
+        const __m128 db = SecondDiffSse(b + x, step);
+        _mm_storeu_ps(drv + x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dl, dl), _mm_mul_ps(da, da)),
+                                          _mm_mul_ps(db, db)));
+    }
+    return x;
+}
+
+int XTransHomogeneitySse(const float *const drv[4], ptrdiff_t stride, float *const homo[4], int n)
+{
+    const __m128 eight = _mm_set1_ps(8.0f), one = _mm_set1_ps(1.0f);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const __m128 t = _mm_mul_ps(_mm_min_ps(_mm_min_ps(_mm_loadu_ps(drv[0] + x), _mm_loadu_ps(drv[1] + x)),
+                                               _mm_min_ps(_mm_loadu_ps(drv[2] + x), _mm_loadu_ps(drv[3] + x))),
+                                    eight);
+        for (int d = 0; d < 4; ++d) {
+            __m128 cnt = _mm_setzero_ps();
+            for (int v = -1; v <= 1; ++v)
+                for (int h = -1; h <= 1; ++h) {
+                    const __m128 s = _mm_loadu_ps(drv[d] + x + v * stride + h);
+                    cnt = _mm_add_ps(cnt, _mm_and_ps(_mm_cmple_ps(s, t), one));
+                }
+            _mm_storeu_ps(homo[d] + x, cnt);
+        }
+    }
+    return x;
+}
+
+WINNOW_TARGET_AVX2
+int XTransPerceptualAvx2(const float *r, const float *g, const float *b,
+                         float *l, float *a, float *bOut, int n)
+{
+    const __m256 zero = _mm256_setzero_ps(), quarter = _mm256_set1_ps(0.25f);
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        const __m256 sr = _mm256_sqrt_ps(_mm256_max_ps(_mm256_loadu_ps(r + x), zero));
+        const __m256 sg = _mm256_sqrt_ps(_mm256_max_ps(_mm256_loadu_ps(g + x), zero));
+        const __m256 sb = _mm256_sqrt_ps(_mm256_max_ps(_mm256_loadu_ps(b + x), zero));
+        _mm256_storeu_ps(l + x, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(sr, _mm256_add_ps(sg, sg)), sb),
+                                              quarter));
+        _mm256_storeu_ps(a + x, _mm256_sub_ps(sr, sg));
+        _mm256_storeu_ps(bOut + x, _mm256_sub_ps(sb, sg));
+    }
+    return x;
+}
+
+WINNOW_TARGET_AVX2
+inline __m256 SecondDiffAvx2(const float *p, ptrdiff_t step)
+{
+    const __m256 c = _mm256_loadu_ps(p);
+    return _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(c, c), _mm256_loadu_ps(p - step)),
+                         _mm256_loadu_ps(p + step));
+}
+
+WINNOW_TARGET_AVX2
+int XTransDerivativeAvx2(const float *l, const float *a, const float *b, ptrdiff_t step,
+                         float *drv, int n)
+{
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        const __m256 dl = SecondDiffAvx2(l + x, step);
+        const __m256 da = SecondDiffAvx2(a + x, step);
+        const __m256 db = SecondDiffAvx2(b + x, step);
+        _mm256_storeu_ps(drv + x, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dl, dl), _mm256_mul_ps(da, da)),
+                                                _mm256_mul_ps(db, db)));
+    }
+    return x;
+}
+
+WINNOW_TARGET_AVX2
+int XTransHomogeneityAvx2(const float *const drv[4], ptrdiff_t stride, float *const homo[4], int n)
+{
+    const __m256 eight = _mm256_set1_ps(8.0f), one = _mm256_set1_ps(1.0f);
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        const __m256 t = _mm256_mul_ps(
+            _mm256_min_ps(_mm256_min_ps(_mm256_loadu_ps(drv[0] + x), _mm256_loadu_ps(drv[1] + x)),
+                          _mm256_min_ps(_mm256_loadu_ps(drv[2] + x), _mm256_loadu_ps(drv[3] + x))),
+            eight);
+        for (int d = 0; d < 4; ++d) {
+            __m256 cnt = _mm256_setzero_ps();
+            for (int v = -1; v <= 1; ++v)
+                for (int h = -1; h <= 1; ++h) {
+                    const __m256 s = _mm256_loadu_ps(drv[d] + x + v * stride + h);
+                    cnt = _mm256_add_ps(cnt, _mm256_and_ps(_mm256_cmp_ps(s, t, _CMP_LE_OQ), one));
+                }
+            _mm256_storeu_ps(homo[d] + x, cnt);
+        }
+    }
+    return x;
+}
+#endif
+
+#if defined(WINNOW_SIMD_NEON)
+int XTransPerceptualNeon(const float *r, const float *g, const float *b,
+                         float *l, float *a, float *bOut, int n)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const float32x4_t sr = vsqrtq_f32(vmaxq_f32(vld1q_f32(r + x), zero));
+        const float32x4_t sg = vsqrtq_f32(vmaxq_f32(vld1q_f32(g + x), zero));
+        const float32x4_t sb = vsqrtq_f32(vmaxq_f32(vld1q_f32(b + x), zero));
+        vst1q_f32(l + x, vmulq_n_f32(vaddq_f32(vaddq_f32(sr, vaddq_f32(sg, sg)), sb), 0.25f));
+        vst1q_f32(a + x, vsubq_f32(sr, sg));
+        vst1q_f32(bOut + x, vsubq_f32(sb, sg));
+    }
+    return x;
+}
+
+inline float32x4_t SecondDiffNeon(const float *p, ptrdiff_t step)
+{
+    const float32x4_t c = vld1q_f32(p);
+    return vsubq_f32(vsubq_f32(vaddq_f32(c, c), vld1q_f32(p - step)), vld1q_f32(p + step));
+}
+
+int XTransDerivativeNeon(const float *l, const float *a, const float *b, ptrdiff_t step,
+                         float *drv, int n)
+{
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const float32x4_t dl = SecondDiffNeon(l + x, step);
+        const float32x4_t da = SecondDiffNeon(a + x, step);
+        const float32x4_t db = SecondDiffNeon(b + x, step);
+        vst1q_f32(drv + x, vaddq_f32(vaddq_f32(vmulq_f32(dl, dl), vmulq_f32(da, da)), vmulq_f32(db, db)));
+    }
+    return x;
+}
+
+int XTransHomogeneityNeon(const float *const drv[4], ptrdiff_t stride, float *const homo[4], int n)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const float32x4_t t = vmulq_n_f32(vminq_f32(vminq_f32(vld1q_f32(drv[0] + x), vld1q_f32(drv[1] + x)),
+                                                    vminq_f32(vld1q_f32(drv[2] + x), vld1q_f32(drv[3] + x))),
+                                          8.0f);
+        for (int d = 0; d < 4; ++d) {
+            float32x4_t cnt = vdupq_n_f32(0.0f);
+            for (int v = -1; v <= 1; ++v)
+                for (int h = -1; h <= 1; ++h) {
+                    const uint32x4_t le = vcleq_f32(vld1q_f32(drv[d] + x + v * stride + h), t);
+                    cnt = vaddq_f32(cnt, vreinterpretq_f32_u32(vandq_u32(le, vreinterpretq_u32_f32(one))));
+                }
+            vst1q_f32(homo[d] + x, cnt);
+        }
+    }
+    return x;
+}
+#endif
+
+} // namespace
+
+void RawKernels::SubtractBlack(uint16_t *cfa, int W, int H, const uint16_t black[4], Level level)
+{
+    for (int y = 0; y < H; ++y) {
+        const int rowBit = (y & 1) << 1;
+        const uint16_t bEven = black[rowBit];
+        const uint16_t bOdd = black[rowBit | 1];
+        uint16_t *row = cfa + static_cast<size_t>(y) * W;
+        int x = 0;
+        switch (level) {
+#if defined(WINNOW_SIMD_X86)
+        case Level::AVX2:  x = SubtractBlackAvx2(row, W, bEven, bOdd); break;
+        case Level::SSE41: x = SubtractBlackSse(row, W, bEven, bOdd); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+        case Level::NEON:  x = SubtractBlackNeon(row, W, bEven, bOdd); break;
+#endif
+        default: break;
+        }
+        SubtractBlackRow(row, x, W, bEven, bOdd);
+    }
+}
+
+void RawKernels::CamToWorking(const float *rgb, float *out, size_t pixels,
+                              const float wb[3], const float m[3][3], Level level)
+{
+    size_t p = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:
+    case Level::SSE41: p = CamToWorkingSse(rgb, out, pixels, wb, m); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  p = CamToWorkingNeon(rgb, out, pixels, wb, m); break;
+#endif
+    default: break;
+    }
+    CamToWorkingScalar(rgb, out, p, pixels, wb, m);
+}
+
+void RawKernels::XTransPerceptual(const float *r, const float *g, const float *b,
+                                  float *l, float *a, float *bOut, int n, Level level)
+{
+    int x = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  x = XTransPerceptualAvx2(r, g, b, l, a, bOut, n); break;
+    case Level::SSE41: x = XTransPerceptualSse(r, g, b, l, a, bOut, n); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  x = XTransPerceptualNeon(r, g, b, l, a, bOut, n); break;
+#endif
+    default: break;
+    }
+    XTransPerceptualScalar(r, g, b, l, a, bOut, x, n);
+}
+
+void RawKernels::XTransDerivative(const float *l, const float *a, const float *b, ptrdiff_t step,
+                                  float *drv, int n, Level level)
+{
+    int x = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  x = XTransDerivativeAvx2(l, a, b, step, drv, n); break;
+    case Level::SSE41: x = XTransDerivativeSse(l, a, b, step, drv, n); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  x = XTransDerivativeNeon(l, a, b, step, drv, n); break;
+#endif
+    default: break;
+    }
+    XTransDerivativeScalar(l, a, b, step, drv, x, n);
+}
+
+void RawKernels::XTransHomogeneity(const float *const drv[4], ptrdiff_t stride,
+                                   float *const homo[4], int n, Level level)
+{
+    int x = 0;
+    switch (level) {
+#if defined(WINNOW_SIMD_X86)
+    case Level::AVX2:  x = XTransHomogeneityAvx2(drv, stride, homo, n); break;
+    case Level::SSE41: x = XTransHomogeneitySse(drv, stride, homo, n); break;
+#endif
+#if defined(WINNOW_SIMD_NEON)
+    case Level::NEON:  x = XTransHomogeneityNeon(drv, stride, homo, n); break;
+#endif
+    default: break;
+    }
+    XTransHomogeneityScalar(drv, stride, homo, x, n);
+}
@@ -0,0 +1,49 @@
+#ifndef RAWKERNELS_H
+#define RAWKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "Utilities/simd.h"
+
+/*
+    The per-pixel loops of the shared RAW pipeline that are pure arithmetic over a whole
+    buffer: black subtraction on the mosaic (RawFormat::SubtractBlack), white balance +
+    camera matrix (RawColor::ToWorking) and the direction-selection passes of the X-Trans
+    Markesteijn demosaic. Each has a scalar reference and SSE4.1 / AVX2 / NEON versions
+    picked by Winnow::Simd::level(); all levels produce bit-identical output
+    (tst_rawkernels).
+*/
+namespace RawKernels {
+
+/* cfa[y*W+x] -= black[((y & 1) << 1) | (x & 1)], saturating at 0. */
+void SubtractBlack(uint16_t *cfa, int W, int H, const uint16_t black[4],
+                   Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* Interleaved camera RGB -> interleaved linear working RGB, per pixel:
+       cam = rgb * wb;  out[c] = max(0, m[c][0]*cam[0] + m[c][1]*cam[1] + m[c][2]*cam[2])
+   (a negative result becomes 0; values above 1 are kept as highlight headroom). */
+void CamToWorking(const float *rgb, float *out, size_t pixels,
+                  const float wb[3], const float m[3][3],
+                  Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* Markesteijn homogeneity (Demosaic::MarkesteijnTile), over n pixels of one row of
+   planar tile buffers. Perceptual maps one direction's linear R, G, B to a square-root
+   encoded luma and two colour differences:
+       s = sqrt(max(0, v));  l = (sR + (sG + sG) + sB) * 0.25;  a = sR - sG;  b = sB - sG */
+void XTransPerceptual(const float *r, const float *g, const float *b,
+                      float *l, float *a, float *bOut, int n,
+                      Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* Squared second derivative of (l, a, b) along step (a pixel offset: 1, the row stride,
+   or a diagonal): drv = (dl*dl + da*da) + db*db with dx = ((x + x) - x[-step]) - x[step]. */
+void XTransDerivative(const float *l, const float *a, const float *b, ptrdiff_t step,
+                      float *drv, int n, Winnow::Simd::Level level = Winnow::Simd::level());
+
+/* Homogeneity of the four directions: with t = 8 * min over d of drv[d], homo[d] counts
+   the 3x3 neighbours (rows stride apart) whose drv[d] <= t, as a float 0..9. */
+void XTransHomogeneity(const float *const drv[4], ptrdiff_t stride, float *const homo[4],
+                       int n, Winnow::Simd::Level level = Winnow::Simd::level());
+
+} // namespace RawKernels
+
+#endif // RAWKERNELS_H
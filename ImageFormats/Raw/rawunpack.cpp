@@ -0,0 +1,276 @@
+#include "ImageFormats/Raw/rawunpack.h"
+#include "ImageFormats/Raw/bitreader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace RawUnpack {
+
+namespace {
+
+/* dcraw's Nikon Huffman trees: 16 code-length counts followed by the leaf symbols (low
+   nibble = bit length, high nibble = shift for the lossy trees). Index by version/bit-depth. */
+const uint8_t kNikonTree[6][32] = {
+ {0,1,5,1,1,1,1,1,1,2,0,0,0,0,0,0, 5,4,3,6,2,7,1,0,8,9,11,10,12,0,0,0},
+ {0,1,5,1,1,1,1,1,1,2,0,0,0,0,0,0, 0x39,0x5a,0x38,0x27,0x16,5,4,3,2,1,0,11,12,12,0,0},
+ {0,1,4,2,3,1,2,0,0,0,0,0,0,0,0,0, 5,4,6,3,7,2,8,1,9,0,10,11,12,0,0,0},
+ {0,1,4,3,1,1,1,1,1,2,0,0,0,0,0,0, 5,6,4,7,8,3,9,2,1,0,10,11,12,13,14,0},
+ {0,1,5,1,1,1,1,1,1,1,2,0,0,0,0,0, 8,0x5c,0x4b,0x3a,0x29,7,6,5,4,3,2,1,0,13,14,0},
+ {0,1,4,2,2,3,1,2,0,0,0,0,0,0,0,0, 7,6,8,5,9,4,10,3,11,12,2,0,1,13,14,0},
+};
+
+inline size_t bytesRead(size_t bits, size_t size) { return std::min((bits + 7) / 8, size); }
+
+/* An ARW2 block's last delta word starts at byte 16: the most a block decode touches. */
+constexpr size_t kSonyReach = 20;
+
+}
+
+size_t nikon(const uint8_t *data, size_t size, int width, int height,
+             const NikonParams &params, uint16_t *out, uint16_t &minValue)
+{
+    minValue = 0xFFFF;
+    if (!data || !out || !params.curve || width <= 0 || height <= 0) return 0;
+    if (params.tree < 0 || params.tree > 5) return 0;
+
+    /* The trees are complete and at most 11 bits long, so every code is one lookup; the
+       difference bits are folded into it whenever they fit in the lookup too. */
+    std::vector<RawBits::Huffman> tables(2);
+    tables[0].build(kNikonTree[params.tree], kNikonTree[params.tree] + 16,
+                    RawBits::Huffman::Values::NikonDiff);
+    const bool split = params.split > 0 && params.tree < 5;
+    if (split)
+        tables[1].build(kNikonTree[params.tree + 1], kNikonTree[params.tree + 1] + 16,
+                        RawBits::Huffman::Values::NikonDiff);
+
+    RawBits::Msb br(data, size);
+    const RawBits::Huffman *h = &tables[0];
+    int vpred[2][2] = {{params.vpred[0][0], params.vpred[0][1]},
+                       {params.vpred[1][0], params.vpred[1][1]}};
+    int hpred[2] = {0, 0};
+    const int *curve = params.curve;
+    uint16_t lo = 0xFFFF;
+
+    for (int row = 0; row < height; ++row) {
+        if (split && row == params.split) h = &tables[1];
+        uint16_t *o = out + size_t(row) * size_t(width);
+        // the first two columns restart from the vertical predictors
+        for (int col = 0; col < width && col < 2; ++col) {
+            vpred[row & 1][col] += h->diff(br);
+            hpred[col] = vpred[row & 1][col];
+            const uint16_t v = uint16_t(curve[std::max(hpred[col], 0) & 0x3FFF]);
+            o[col] = v;
+            lo = std::min(lo, v);
+        }
+        for (int col = 2; col < width; ++col) {
+            int &p = hpred[col & 1];
+            p += h->diff(br);
+            const uint16_t v = uint16_t(curve[std::max(p, 0) & 0x3FFF]);
+            o[col] = v;
+            lo = std::min(lo, v);
+        }
+    }
+    minValue = lo;
+    return bytesRead(br.consumed(), size);
+}
+
+size_t olympus(const uint8_t *data, size_t size, int width, int height, uint16_t *out)
+{
+    if (!data || !out || width <= 2 || height <= 0) return 0;
+
+    /* dcraw's Olympus Huffman: a direct 4096-entry table indexed by the top 12 bits ->
+       (codeLength << 8) | magnitudeValue. */
+    std::vector<int> huff(4096);
+    huff[0] = 0xc0c;
+    int hn = 0;
+    for (int i = 11; i >= 0; --i)
+        for (int c = 0; c < (2048 >> i); ++c) huff[++hn] = ((i + 1) << 8) | i;
+
+    // the bits start 7 bytes into the strip (dcraw skips 7)
+    const size_t skip = std::min<size_t>(7, size);
+    RawBits::Msb br(data + skip, size - skip);
+
+    /* The predictors look two rows up, so four rows of signed values are enough (the whole
+       frame used to be kept, 4 bytes a photosite). */
+    const size_t W = size_t(width);
+    std::vector<int> rows(4 * W, 0);
+
+    for (int row = 0; row < height; ++row) {
+        int *cur = &rows[size_t(row & 3) * W];
+        const int *up = &rows[size_t((row - 2) & 3) * W];
+        uint16_t *o = out + size_t(row) * W;
+        int acarry[2][3] = {{0, 0, 0}, {0, 0, 0}};
+        for (int col = 0; col < width; ++col) {
+            int *carry = acarry[col & 1];
+            const int i = 2 * (carry[2] < 3);
+            int nbits = 2 + i;
+            while ((carry[0] & 0xffff) >> (nbits + i)) ++nbits;
+            const int sign3 = int(br.get(3));
+            const int low = sign3 & 3;
+            const int sign = ((sign3 >> 2) & 1) ? -1 : 0;     // sign<<29>>31
+            if (br.cnt < 12) br.fill();
+            const int e = huff[br.peek(12)];
+            br.skip(e >> 8);
+            int high = e & 0xff;
+            if (high == 12) high = int(br.get(16 - nbits)) >> 1;
+            carry[0] = (high << nbits) | int(br.get(nbits));
+            const int diff = (carry[0] ^ sign) + carry[1];
+            carry[1] = (diff * 3 + carry[1]) >> 5;
+            carry[2] = carry[0] > 16 ? 0 : carry[2] + 1;
+
+            int pred;
+            if (row < 2 && col < 2) pred = 0;
+            else if (row < 2) pred = cur[col - 2];
+            else if (col < 2) pred = up[col];
+            else {
+                const int w = cur[col - 2];
+                const int n = up[col];
+                const int nw = up[col - 2];
+                if ((w < nw && nw < n) || (n < nw && nw < w)) {
+                    if (std::abs(w - nw) > 32 || std::abs(n - nw) > 32) pred = w + n - nw;
+                    else pred = (w + n) >> 1;
+                } else {
+                    pred = (std::abs(w - nw) > std::abs(n - nw)) ? w : n;
+                }
+            }
+            const int val = pred + ((diff << 2) | low);
+            cur[col] = val;
+            o[col] = uint16_t(val & 0xffff);
+        }
+    }
+    return skip + bytesRead(br.consumed(), size - skip);
+}
+
+size_t panasonic(const uint8_t *data, size_t size, int width, int height, int loadFlags,
+                 uint16_t *out)
+{
+    if (!data || !out || width <= 0 || height <= 0) return 0;
+    constexpr int kBlock = 0x4000;
+    if (loadFlags < 0 || loadFlags >= kBlock) loadFlags = 0;
+
+    /* The camera writes each 0x4000-byte block rotated by loadFlags, and pana_bits handed
+       out each 16-byte chunk's bits from its last byte down. Loading a block un-rotated,
+       with every chunk's byte order reversed, turns that into a plain MSB-first stream. A
+       new block starts when the last one has been read to its end, as before. */
+    std::vector<uint8_t> block(kBlock);
+    size_t next = 0;                                    // offset of the next block
+    auto load = [&]() {
+        if (next + kBlock <= size) {
+            std::memcpy(block.data() + loadFlags, data + next, size_t(kBlock - loadFlags));
+            std::memcpy(block.data(), data + next + kBlock - loadFlags, size_t(loadFlags));
+            for (int j = 0; j < kBlock; j += 16)
+                std::reverse(block.begin() + j, block.begin() + j + 16);
+        } else {
+            for (int j = 0; j < kBlock; ++j) {
+                const int b = (j & ~15) | (15 - (j & 15));
+                const size_t src = next + size_t(b >= loadFlags ? b - loadFlags
+                                                                : b + kBlock - loadFlags);
+                block[size_t(j)] = src < size ? data[src] : 0;
+            }
+        }
+        next += kBlock;
+    };
+    load();
+    RawBits::Msb br(block.data(), kBlock);
+    auto bits = [&](int n) -> int {
+        if (br.consumed() >= size_t(kBlock) * 8) {
+            load();
+            br = RawBits::Msb(block.data(), kBlock);
+        }
+        return int(br.get(n));
+    };
+
+    /* A 14-photosite group reads at most 14 * 14 bits; when that much of the block is left
+       the group is decoded without checking for the block end on every field. */
+    constexpr size_t kGroupBits = 14 * 14;
+    int pred[2], nonz[2], sh;
+    auto pixel = [&](int i, auto &&get) -> uint16_t {
+        if (i == 0) { pred[0] = pred[1] = 0; nonz[0] = nonz[1] = 0; }
+        if (i % 3 == 2) sh = 4 >> (3 - get(2));
+        if (nonz[i & 1]) {
+            const int j = get(8);
+            if (j) {
+                pred[i & 1] -= 0x80 << sh;
+                if (pred[i & 1] < 0 || sh == 4) pred[i & 1] &= (1 << sh) - 1;
+                pred[i & 1] += j << sh;
+            }
+        } else if ((nonz[i & 1] = get(8)) || i > 11) {
+            pred[i & 1] = (nonz[i & 1] << 4) | get(4);
+        }
+        return uint16_t(pred[i & 1] & 0xffff);
+    };
+    auto fast = [&](int n) { return int(br.get(n)); };
+
+    for (int row = 0; row < height; ++row) {
+        uint16_t *o = out + size_t(row) * size_t(width);
+        pred[0] = pred[1] = 0;
+        nonz[0] = nonz[1] = 0;
+        sh = 0;
+        int col = 0;
+        while (col < width) {
+            if (col % 14 == 0 && col + 14 <= width &&
+                br.consumed() + kGroupBits <= size_t(kBlock) * 8) {
+                for (int i = 0; i < 14; ++i) o[col + i] = pixel(i, fast);
+                col += 14;
+            } else {
+                o[col] = pixel(col % 14, bits);
+                ++col;
+            }
+        }
+    }
+    return std::min(next - kBlock + bytesRead(br.consumed(), kBlock), size);
+}
+
+size_t sonyArw2(const uint8_t *data, size_t size, int width, int height, size_t rowBytes,
+                const int *curve, uint16_t *out)
+{
+    if (!data || !out || !curve || width <= 32 || height <= 0) return 0;
+    size_t end = 0;
+    for (int row = 0; row < height; ++row) {
+        uint16_t *o = out + size_t(row) * size_t(width);
+        const size_t rowStart = size_t(row) * rowBytes;
+        int col = 0;
+        size_t dpo = 0;
+        while (col < width - 30) {
+            /* One 16-byte block: an 11-bit max and min, the 4-bit indexes of the photosites
+               holding them, then 7-bit deltas, each taken from a little-endian word at its
+               byte. A corrupt block naming the same photosite for both has a 15th delta,
+               which comes from the next block's first byte as it always did. */
+            const size_t off = rowStart + dpo;
+            uint8_t tail[kSonyReach];
+            const uint8_t *p = data + off;
+            if (off + kSonyReach > size) {
+                for (size_t k = 0; k < kSonyReach; ++k)
+                    tail[k] = off + k < size ? data[off + k] : 0;
+                p = tail;
+            }
+            const uint64_t head = RawBits::loadLe64(p);
+            const int mx = int(head & 0x7ff), mn = int((head >> 11) & 0x7ff);
+            const int imax = int((head >> 22) & 0xf), imin = int((head >> 26) & 0xf);
+            int sh = 0;
+            while (sh < 4 && (0x80 << sh) <= mx - mn) ++sh;
+            int pix[16];
+            int bit = 30;
+            for (int i = 0; i < 16; ++i) {
+                if (i == imax) pix[i] = mx;
+                else if (i == imin) pix[i] = mn;
+                else {
+                    const uint32_t v = RawBits::loadLe32(p + (bit >> 3)) >> (bit & 7);
+                    pix[i] = std::min((int(v & 0x7f) << sh) + mn, 0x7ff);
+                    bit += 7;
+                }
+            }
+            for (int i = 0; i < 16; ++i) {
+                o[col] = uint16_t(curve[pix[i] << 1] >> 2);
+                col += 2;
+            }
+            col -= (col & 1) ? 1 : 31;
+            dpo += 16;
+            end = std::max(end, off + 16);
+        }
+    }
+    return std::min(end, size);
+}
+
+} // namespace RawUnpack
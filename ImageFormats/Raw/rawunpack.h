@@ -0,0 +1,49 @@
+#ifndef RAWUNPACK_H
+#define RAWUNPACK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    The entropy-decoding loops of the proprietary raw formats, over the shared RawBits
+    reader. Each takes the compressed sensor data as a plain byte range and writes the
+    width x height mosaic, one uint16 per photosite, row after row; the container walk,
+    curves and colour stay in the format's UnpackCfa (NikonRaw, OlympusRaw, PanasonicRaw,
+    SonyRaw).
+
+    Every decoder returns the number of input bytes it consumed -- the figure the
+    throughput benchmark in tst_bitreader reports -- and, like the loops they replace,
+    treats data past the end as zero bits rather than failing. They keep no state between
+    calls and are safe to run concurrently on different images.
+*/
+namespace RawUnpack {
+
+/* Nikon NEF compressed (dcraw's nikon_load_raw). tree indexes dcraw's six Huffman trees
+   (version and bit depth select it); from row split on (0 = never) tree + 1 is used. The
+   predictors start at vpred; each value goes through curve (0x4000 entries). minValue is
+   the smallest output value, the black estimate for bodies without a black-level tag. */
+struct NikonParams {
+    int tree = 0;
+    int split = 0;
+    int vpred[2][2] = {{0, 0}, {0, 0}};
+    const int *curve = nullptr;
+};
+size_t nikon(const uint8_t *data, size_t size, int width, int height,
+             const NikonParams &params, uint16_t *out, uint16_t &minValue);
+
+/* Olympus ORF 12-bit compression (dcraw's olympus_load_raw); data is the whole strip. */
+size_t olympus(const uint8_t *data, size_t size, int width, int height, uint16_t *out);
+
+/* Panasonic RW2 RawFormat 4 (dcraw's panasonic_load_raw); loadFlags is the rotation of
+   each 0x4000-byte block (0x2008 for RawFormat 4). */
+size_t panasonic(const uint8_t *data, size_t size, int width, int height, int loadFlags,
+                 uint16_t *out);
+
+/* Sony ARW2 "compressed" (dcraw's sony_arw2_load_raw): rows of rowBytes, 16-byte blocks
+   of 16 same-colour photosites, values through curve (0x4000 entries). */
+size_t sonyArw2(const uint8_t *data, size_t size, int width, int height, size_t rowBytes,
+                const int *curve, uint16_t *out);
+
+} // namespace RawUnpack
+
+#endif // RAWUNPACK_H
@@ -27,16 +27,16 @@ quint32 Reader::g32(const uchar *p) const
 
 QByteArray Reader::readAt(quint32 off, int n)
 {
-    if (!file || !file->seek(baseOff + off)) return QByteArray();
-    return file->read(n);
+    if (!file) return QByteArray();
+    return file->read(qint64(baseOff) + off, n);
 }
 
-bool Reader::init(QFile *f, quint32 base)
+bool Reader::init(const MappedFile *f, quint32 base)
 {
     file = f;
     baseOff = base;
-    if (!file || !file->seek(base)) return false;
-    const QByteArray hdr = file->read(8);
+    if (!file) return false;
+    const QByteArray hdr = file->read(base, 8);
     if (hdr.size() < 8) return false;
     const uchar *h = reinterpret_cast<const uchar *>(hdr.constData());
     if (h[0] == 'M' && h[1] == 'M') isBig = true;
@@ -1,13 +1,13 @@
 #ifndef TIFFWALK_H
 #define TIFFWALK_H
 
-#include <QFile>
 #include <QHash>
 #include <QList>
 #include <QVector>
 #include <QByteArray>
 #include <QString>
 #include <cstdint>
+#include "ImageFormats/Raw/mappedfile.h"
 
 /*
     Minimal TIFF/EP IFD reader shared by the RAW decoders (DngRaw today; the other vendor
@@ -15,8 +15,8 @@
     SubIFD pointers), and interpret a tag's value -- as a scalar, an integer array, a real
     array (rationals / floats), bytes, or ASCII -- transparently handling the "inline if <= 4
     bytes, else at an offset" rule. It does NOT decode pixel data; the caller reads strips/tiles
-    itself. Endian-aware. Values are re-read from the QFile on demand, so the file must stay
-    open for the Reader's lifetime.
+    itself. Endian-aware. Values are read from the MappedFile on demand, so it must outlive the
+    Reader.
 */
 namespace TiffWalk {
 
@@ -32,11 +32,11 @@ public:
     /* Read the TIFF header. base != 0 is for an embedded TIFF whose offsets are relative to its
        own start (e.g. a Nikon type-3 MakerNote): all offsets passed to / returned from this
        Reader are then relative to base, and file reads are at base + offset. */
-    bool init(QFile *f, quint32 base = 0);          // read TIFF header; false if not TIFF
+    bool init(const MappedFile *f, quint32 base = 0);   // read TIFF header; false if not TIFF
     /* For an embedded IFD with a non-standard or absent TIFF header (e.g. an Olympus type-3
        MakerNote "OLYMPUS\0II\3\0"): supply the base, the first-IFD offset relative to base, and
        endianness directly. Offsets to/from this Reader are then relative to base. */
-    void initEmbedded(QFile *f, quint32 base, quint32 firstIfdRel, bool bigEndian) {
+    void initEmbedded(const MappedFile *f, quint32 base, quint32 firstIfdRel, bool bigEndian) {
         file = f; baseOff = base; first = firstIfdRel; isBig = bigEndian;
     }
     bool big() const { return isBig; }
@@ -60,7 +60,7 @@ public:
     static int typeSize(quint16 t);
 
 private:
-    QFile *file = nullptr;
+    const MappedFile *file = nullptr;
     bool isBig = false;
     quint32 first = 0;
     quint32 baseOff = 0;
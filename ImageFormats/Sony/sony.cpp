@@ -2,6 +2,7 @@
 #include "Main/global.h"
 #include "ImageFormats/Raw/cameramatrix.h"
 #include "ImageFormats/Raw/tiffwalk.h"
+#include "ImageFormats/Raw/rawunpack.h"
 #include <QSet>
 #include <vector>
 
@@ -645,10 +646,9 @@ struct RawTag {
     the shared unpack below then reads the strip. Returns false if no uncompressed CFA IFD is
     present (compressed ARW -> caller falls back to the embedded JPG).
 */
-bool readSonyTiffSensorInfo(QFile &file, RawSensorInfo &info)
+bool readSonyTiffSensorInfo(const MappedFile &file, RawSensorInfo &info)
 {
-    if (!file.seek(0)) return false;
-    const QByteArray hdr = file.read(8);
+    const QByteArray hdr = file.read(0, 8);
     if (hdr.size() < 8) return false;
     const bool big = (quint8(hdr[0]) == 'M' && quint8(hdr[1]) == 'M');
 
@@ -663,8 +663,7 @@ bool readSonyTiffSensorInfo(QFile &file, RawSensorInfo &info)
                    : (quint32(w)<<24 | quint32(z)<<16 | quint32(y)<<8 | x);
     };
     auto readAt = [&](quint32 off, int n) -> QByteArray {
-        if (!file.seek(off)) return QByteArray();
-        return file.read(n);
+        return file.read(off, n);
     };
 
     /* Read one IFD: fill tags, append any SubIFD offsets, return the next-IFD offset. */
@@ -788,11 +787,11 @@ bool readSonyTiffSensorInfo(QFile &file, RawSensorInfo &info)
     16 photosites of one Bayer colour across 32 columns: an 11-bit max and min, the indices of
     the pixels holding them, then 7-bit deltas (shifted to fit max-min). The 11-bit values are
     expanded through a Sony tone curve (tag 0x7010, 4 control points). Ported from dcraw's
-    sony_arw2_load_raw and validated BYTE-IDENTICAL to libraw on an A9 ARW. Returns 1 on success,
-    0 if the file is not ARW-compressed (caller falls through to the uncompressed path), -1 on a
-    compressed-but-failed decode (err set).
+    sony_arw2_load_raw and validated BYTE-IDENTICAL to libraw on an A9 ARW; the block decode is
+    RawUnpack::sonyArw2. Returns 1 on success, 0 if the file is not ARW-compressed (caller falls
+    through to the uncompressed path), -1 on a compressed-but-failed decode (err set).
 */
-int decodeSonyArw2(QFile &file, RawImage &raw, QString &err)
+int decodeSonyArw2(const MappedFile &file, RawImage &raw, QString &err)
 {
     using namespace TiffWalk;
     Reader r;
@@ -843,48 +842,15 @@ int decodeSonyArw2(QFile &file, RawImage &raw, QString &err)
 
     const quint32 so = r.scalar(rawIfd[273]);
     const quint32 sl = r.scalar(rawIfd[279]);
-    if (!file.seek(so)) { err = "ARW2: seek to strip failed."; return -1; }
-    QByteArray strip = file.read(int(sl));
-    if (strip.size() < int(sl)) { err = "ARW2: short strip read."; return -1; }
-    strip.append('\0');                                  // +1 pad: last block reads 1 byte past
-    const uchar *data = reinterpret_cast<const uchar *>(strip.constData());
+    const uchar *data = file.at(so, sl);
+    if (!data) { err = "ARW2: strip runs past end of file."; return -1; }
+    file.willNeed(so, sl);
     const int rowbytes = (H > 0) ? int(sl / H) : W;      // 1 byte per column
 
     raw.width = W;
     raw.height = H;
     raw.cfa.assign(size_t(W) * size_t(H), 0);
-
-    for (int row = 0; row < H; ++row) {
-        const uchar *rd = data + size_t(row) * rowbytes;
-        int col = 0, dpo = 0;
-        while (col < W - 30) {
-            const uchar *dp = rd + dpo;
-            const quint32 v4 = quint32(dp[0]) | (quint32(dp[1]) << 8) |
-                               (quint32(dp[2]) << 16) | (quint32(dp[3]) << 24);
-            const int mx = v4 & 0x7ff, mn = (v4 >> 11) & 0x7ff;
-            const int imax = (v4 >> 22) & 0xf, imin = (v4 >> 26) & 0xf;
-            int sh = 0;
-            while (sh < 4 && (0x80 << sh) <= mx - mn) ++sh;
-            int pix[16]; int bit = 30;
-            for (int i = 0; i < 16; ++i) {
-                if (i == imax) pix[i] = mx;
-                else if (i == imin) pix[i] = mn;
-                else {
-                    const int b = bit >> 3;
-                    const int s2 = int(dp[b]) | (int(dp[b + 1]) << 8);
-                    pix[i] = (((s2 >> (bit & 7)) & 0x7f) << sh) + mn;
-                    if (pix[i] > 0x7ff) pix[i] = 0x7ff;
-                    bit += 7;
-                }
-            }
-            for (int i = 0; i < 16; ++i) {
-                raw.cfa[size_t(row) * W + col] = uint16_t(curve[pix[i] << 1] >> 2);
-                col += 2;
-            }
-            col -= (col & 1) ? 1 : 31;
-            dpo += 16;
-        }
-    }
+    RawUnpack::sonyArw2(data, sl, W, H, size_t(rowbytes), curve.data(), raw.cfa.data());
 
     /* Levels / pattern / colour, read from the same SR2 tags as the uncompressed path. */
     raw.pattern = CfaPattern::RGGB;
@@ -910,7 +876,7 @@ int decodeSonyArw2(QFile &file, RawImage &raw, QString &err)
 
 } // namespace
 
-bool SonyRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
+bool SonyRaw::UnpackCfa(const MappedFile &file, const ImageMetadata &m, RawImage &raw)
 {
 /*
     Unpack a Sony ARW CFA mosaic. First try the lossy "ARW Compressed" (32767) path; if the file
@@ -967,13 +933,9 @@ bool SonyRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     for (int i = 0; i < 4; ++i)
         raw.black[i] = haveBlack ? quint16(info.black[i]) : blackDefault;
 
-    /* Read the sensor strip and unpack little/big-endian uint16 samples (masked to bps). */
-    if (!file.seek(info.stripOffset)) {
-        errMsg = "Sony raw: seek to sensor strip failed.";
-        return false;
-    }
-    const QByteArray strip = file.read(int(quint32(W) * quint32(H) * 2));
-    if (strip.size() < W * H * 2) {
+    /* Unpack the sensor strip from the mapping: little/big-endian uint16 samples (masked to bps). */
+    const uchar *s = file.at(info.stripOffset, qint64(W) * H * 2);
+    if (!s) {
         errMsg = "Sony raw: could not read full sensor strip.";
         return false;
     }
@@ -982,7 +944,6 @@ bool SonyRaw::UnpackCfa(QFile &file, const ImageMetadata &m, RawImage &raw)
     raw.height = H;
     raw.cfa.resize(size_t(W) * size_t(H));
     const quint16 mask = quint16((1u << bps) - 1);
-    const uchar *s = reinterpret_cast<const uchar *>(strip.constData());
     const size_t count = size_t(W) * size_t(H);
     if (!info.littleEndianSamples) {
         for (size_t i = 0; i < count; ++i)
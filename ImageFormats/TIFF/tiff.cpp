@@ -1,5 +1,10 @@
 #include "tiff.h"
 #include "Metadata/metareport.h"
+#include "ImageFormats/Raw/mappedfile.h"
+#include "ImageFormats/Tiff/tiffcodec.h"
+#include <cstring>
+#include <memory>
+#include <vector>
 
 /*
 
@@ -912,6 +917,23 @@ bool Tiff::decode(MetadataParameters &p, QImage &image, int newSize)
     bytesPerRow = (uint)(bytesPerPixel * width);
     scanBytesAvail = (uint)(width * height * bytesPerPixel);
 
+    /* Interleaved RGB, uncompressed, LZW or deflate: all strips at once, straight to
+       RGB32 (decodeStrips). Planar, JPEG compressed and other layouts keep the serial
+       strip decoders below. */
+    if (planarConfiguration == 1 && photoInterp == 2 && samplesPerPixel == 3
+        && (compression == 1 || compression == 5 || compression == 8)
+        && predictor <= 2) {
+        QImage decoded;
+        const bool ok = decodeStrips(p, decoded);
+        p.file.close();
+        if (!ok) return false;
+        if (newSize) {
+            decoded = decoded.scaled(G::maxIconSize, G::maxIconSize, Qt::KeepAspectRatio, Qt::FastTransformation);
+        }
+        image = decoded;
+        return true;
+    }
+
     if (bitsPerSample == 16) im = new QImage(width, height, QImage::Format_RGBX64);
     if (bitsPerSample == 8)  im = new QImage(width, height, QImage::Format_RGB888);
     /*
@@ -949,6 +971,113 @@ bool Tiff::decode(MetadataParameters &p, QImage &image, int newSize)
     return true;
 }
 
+namespace {
+
+/* Deflate (compression 8) strip into exactly outLen bytes. */
+bool inflateStrip(const uchar *in, qsizetype inLen, uchar *out, qsizetype outLen)
+{
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    if (inflateInit(&strm) != Z_OK) return false;
+    strm.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(in));
+    strm.avail_in = uInt(inLen);
+    strm.next_out = reinterpret_cast<Bytef *>(out);
+    strm.avail_out = uInt(outLen);
+    inflate(&strm, Z_FINISH);
+    const bool ok = strm.avail_out == 0;    // a longer stream is clipped, not an error
+    inflateEnd(&strm);
+    return ok;
+}
+
+} // namespace
+
+bool Tiff::decodeStrips(MetadataParameters &p, QImage &out)
+{
+/*
+    Decode every strip of an interleaved 8 or 16 bit RGB image concurrently, each
+    straight into its rows of an RGB32 QImage (see ImageFormats/Tiff/tiffcodec.h).
+
+    The strips are read from one MappedFile, so no strip is copied before it is
+    decompressed. Per strip: LZW or deflate into a worker buffer, then per row the 16 bit
+    samples are put in host order, the horizontal predictor is undone per sample (the
+    old decoders added bytes, which lost the carry between the two bytes of a 16 bit
+    sample, and the deflate path added the previous row instead), and the row is
+    converted to RGB32. 16 -> 8 bits rounds as QImage's RGBX64 -> RGB32 conversion, which
+    the old path ran over the whole image afterwards.
+*/
+    if (G::isLogger || isDebug) G::log("Tiff::decodeStrips", p.fPath + " Source = " + source);
+    const int strips = stripOffsets.count();
+    if (width <= 0 || height <= 0 || strips == 0) return false;
+    if (stripByteCounts.count() < strips) return false;
+    // RowsPerStrip 2^32 - 1 (read as -1) means one strip for the whole image
+    const int rps = (rowsPerStrip <= 0 || rowsPerStrip > height) ? height : rowsPerStrip;
+    if (qint64(strips) * rps < height) return false;             // rows with no strip
+    if (bitsPerSample != 8 && bitsPerSample != 16) return false;
+    // same 1 GB cap as decodeBase
+    const qsizetype rowBytes = qsizetype(width) * samplesPerPixel * (bitsPerSample / 8);
+    if (quint64(rowBytes) * quint64(height) > (1ULL << 30)) return false;
+
+    MappedFile file(p.file);
+    if (!file.isValid()) return false;
+
+    out = QImage(width, height, QImage::Format_RGB32);
+    if (out.isNull()) return false;
+    uchar *bits = out.bits();                   // detach once, before the workers
+    const qsizetype bpl = out.bytesPerLine();
+
+    const int w = width;
+    const int h = height;
+    const int spp = samplesPerPixel;
+    const int bps = bitsPerSample;
+    const int comp = compression;
+    const bool pred = predictor == 2;
+    const bool big = isBigEnd;
+    const QVector<quint32> offsets = stripOffsets;
+    const QVector<quint32> counts = stripByteCounts;
+
+    return TiffCodec::forEachWorker(strips, [&]() -> TiffCodec::Work {
+        auto buf = std::make_shared<std::vector<uchar>>(size_t(rowBytes) * rps);
+        return [&, buf](int s) {
+            const qint64 y0 = qint64(s) * rps;
+            if (y0 >= h) return true;           // trailing strips past the image
+            const int rows = int(qMin<qint64>(rps, h - y0));
+            const qsizetype need = rowBytes * rows;
+            const uchar *in = file.at(offsets.at(s), counts.at(s));
+            if (!in) return false;
+            uchar *px = buf->data();
+            switch (comp) {
+            case 1:
+                if (counts.at(s) < need) return false;
+                std::memcpy(px, in, size_t(need));
+                break;
+            case 5:
+                if (TiffCodec::lzwDecode(in, counts.at(s), px, need) < need) return false;
+                break;
+            case 8:
+                if (!inflateStrip(in, counts.at(s), px, need)) return false;
+                break;
+            default:
+                return false;
+            }
+            for (int r = 0; r < rows; ++r) {
+                uchar *row = px + r * rowBytes;
+                QRgb *dst = reinterpret_cast<QRgb *>(bits + (y0 + r) * bpl);
+                if (bps == 8) {
+                    if (pred) TiffCodec::undoPredictor8(row, w * spp, spp);
+                    TiffCodec::rgb24ToRgb32(row, dst, w);
+                }
+                else {
+                    quint16 *row16 = reinterpret_cast<quint16 *>(row);
+                    TiffCodec::toHost16(row16, qsizetype(w) * spp, big);
+                    if (pred) TiffCodec::undoPredictor16(row16, w * spp, spp);
+                    TiffCodec::rgb48ToRgb32(row16, dst, w);
+                }
+            }
+            return true;
+        };
+    });
+}
+
 bool Tiff::decodeBase(MetadataParameters &p)
 {
 /*
@@ -2524,6 +2653,14 @@ bool Tiff::read(QString fPath, QImage *image, quint32 ifdOffset)
         return false;
     }
 
+    // the common large-file layouts, all strips or tiles at once
+    if (readParallel(fPath, ifdOffset, tiff, size, format, photometric, floatingPoint, image)) {
+        readResolution(tiff, image);
+        image->convertTo(QImage::Format_RGB32);
+        TIFFClose(tiff);
+        return true;
+    }
+
     /*
     if (isDebug)
     qDebug() << "Tiff::read"
@@ -2689,6 +2826,26 @@ bool Tiff::read(QString fPath, QImage *image, quint32 ifdOffset)
     }
 
 
+    readResolution(tiff, image);
+
+    // convert to standard QImage format for display in Winnow
+    image->convertTo(QImage::Format_RGB32);
+
+    // uint32_t count;
+    // void *profile;
+    // if (TIFFGetField(tiff, TIFFTAG_ICCPROFILE, &count, &profile)) {
+    //     QByteArray iccProfile(reinterpret_cast<const char *>(profile), count);
+    //     image->setColorSpace(QColorSpace::fromIccProfile(iccProfile));
+    // }
+    // We do not handle colorimetric metadata not on ICC profile form, it seems to be a lot
+    // less common, and would need additional API in QColorSpace.
+
+    TIFFClose(tiff);
+    return true;
+}
+
+void Tiff::readResolution(TIFF *tiff, QImage *image)
+{
     float resX = 0;
     float resY = 0;
     uint16_t resUnit;
@@ -2714,19 +2871,220 @@ bool Tiff::read(QString fPath, QImage *image, quint32 ifdOffset)
             break;
         }
     }
+}
 
-    // convert to standard QImage format for display in Winnow
-    image->convertTo(QImage::Format_RGB32);
+namespace {
 
-    // uint32_t count;
-    // void *profile;
-    // if (TIFFGetField(tiff, TIFFTAG_ICCPROFILE, &count, &profile)) {
-    //     QByteArray iccProfile(reinterpret_cast<const char *>(profile), count);
-    //     image->setColorSpace(QColorSpace::fromIccProfile(iccProfile));
-    // }
-    // We do not handle colorimetric metadata not on ICC profile form, it seems to be a lot
-    // less common, and would need additional API in QColorSpace.
+/* A libtiff handle of one read worker: its own TIFF *, since libtiff handles are not
+   thread-safe, positioned on the same directory as the caller's. */
+struct TiffHandle
+{
+    TIFF *tiff = nullptr;
+    TiffHandle(const QString &fPath, quint32 ifdOffset)
+    {
+        tiff = TIFFOpen(fPath.toStdString().c_str(), "r");
+        if (tiff && ifdOffset && !TIFFSetSubDirectory(tiff, ifdOffset)) close();
+    }
+    ~TiffHandle() { close(); }
+    void close() { if (tiff) TIFFClose(tiff); tiff = nullptr; }
+};
+
+/* The same for the RGBA reader, which keeps per-image conversion state. */
+struct RgbaHandle : TiffHandle
+{
+    TIFFRGBAImage img;
+    bool ok = false;
+    RgbaHandle(const QString &fPath, quint32 ifdOffset) : TiffHandle(fPath, ifdOffset)
+    {
+        char emsg[1024] = "";
+        ok = tiff && TIFFRGBAImageOK(tiff, emsg) && TIFFRGBAImageBegin(&img, tiff, 1, emsg);
+        if (ok) img.req_orientation = ORIENTATION_TOPLEFT;
+    }
+    ~RgbaHandle() { if (ok) TIFFRGBAImageEnd(&img); }
+};
+
+} // namespace
+
+bool Tiff::readParallel(const QString &fPath, quint32 ifdOffset, TIFF *tiff, QSize size,
+                        QImage::Format format, uint16_t photometric, bool floatingPoint,
+                        QImage *image)
+{
+/*
+    read() used to pull a large TIFF through libtiff one scanline or tile at a time, or
+    through TIFFReadRGBAImage in one call, all on the ImageDecoder thread. Strips and
+    tiles are compressed independently, so here every worker (TiffCodec::forEachWorker)
+    opens its own handle on the file and decodes a share of them into their place in
+    the image:
+
+        16 bit RGB      TIFFReadEncodedStrip/Tile (libtiff undoes the predictor and the
+                        byte order), then 48 -> 32 bit straight into an RGB32 image --
+                        the RGBX64 image, rgb48fixup and the whole-image convertTo are
+                        gone, and so is the 8 bytes per pixel intermediate.
+        RGBA reader     (8 bit RGB, YCbCr, CMYK, JPEG compressed ...) bands of whole
+                        strips or tile rows through TIFFRGBAImageGet with row_offset.
+
+    Contiguous planar configuration and top-left orientation only, where the result is
+    exactly what the serial code below produces. Returns false, having changed nothing
+    the caller relies on, for anything else or a single strip.
+*/
+    uint16_t planar = PLANARCONFIG_CONTIG;
+    uint16_t orientation = ORIENTATION_TOPLEFT;
+    uint16_t spp = 1;
+    uint16_t bps = 1;
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG, &planar);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_ORIENTATION, &orientation);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bps);
+    if (planar != PLANARCONFIG_CONTIG || orientation != ORIENTATION_TOPLEFT) return false;
+
+    const int w = size.width();
+    const int h = size.height();
+    const bool tiled = TIFFIsTiled(tiff);
+    quint32 unitW = quint32(w);
+    quint32 unitH = 0;
+    if (tiled) {
+        TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &unitW);
+        TIFFGetField(tiff, TIFFTAG_TILELENGTH, &unitH);
+    }
+    else {
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &unitH);
+        unitH = qMin(unitH, quint32(h));
+    }
+    if (w <= 0 || h <= 0 || !unitW || !unitH) return false;
+    const int units = tiled ? int(TIFFNumberOfTiles(tiff)) : int(TIFFNumberOfStrips(tiff));
+    if (units < 2) return false;
+
+    const bool rgb48 = format == QImage::Format_RGBX64 && photometric == PHOTOMETRIC_RGB
+                       && !floatingPoint && spp == 3 && bps == 16;
+    const bool rgba = format == QImage::Format_RGB32 || format == QImage::Format_ARGB32
+                      || format == QImage::Format_ARGB32_Premultiplied;
+    if (!rgb48 && !rgba) return false;
+
+    QImage out(size, rgb48 ? QImage::Format_RGB32 : format);
+    if (out.isNull()) return false;
+    uchar *bits = out.bits();
+    const qsizetype bpl = out.bytesPerLine();
+    bool ok = false;
+
+    if (rgb48) {
+        const int across = tiled ? int((quint32(w) + unitW - 1) / unitW) : 1;
+        const tmsize_t unitBytes = tiled ? TIFFTileSize(tiff) : TIFFStripSize(tiff);
+        const qsizetype unitRowBytes = qsizetype(unitW) * 6;
+        if (unitBytes < tmsize_t(unitRowBytes)) return false;
+        ok = TiffCodec::forEachWorker(units, [&]() -> TiffCodec::Work {
+            auto t = std::make_shared<TiffHandle>(fPath, ifdOffset);
+            if (!t->tiff) return {};
+            auto buf = std::make_shared<std::vector<quint16>>(size_t(unitBytes / 2 + 1));
+            return [&, t, buf](int i) {
+                const int x0 = tiled ? int(i % across * unitW) : 0;
+                const qint64 y0 = tiled ? qint64(i / across) * unitH : qint64(i) * unitH;
+                if (x0 >= w || y0 >= h) return true;        // padding tiles
+                const tmsize_t n = tiled
+                    ? TIFFReadEncodedTile(t->tiff, uint32_t(i), buf->data(), unitBytes)
+                    : TIFFReadEncodedStrip(t->tiff, uint32_t(i), buf->data(), unitBytes);
+                if (n < 0) return false;
+                const int rows = int(qMin<qint64>(unitH, h - y0));
+                const int cols = qMin(int(unitW), w - x0);
+                if (!tiled && n < tmsize_t(rows) * unitRowBytes) return false;
+                for (int r = 0; r < rows; ++r) {
+                    const quint16 *src = buf->data() + qsizetype(r) * unitW * 3;
+                    QRgb *dst = reinterpret_cast<QRgb *>(bits + (y0 + r) * bpl) + x0;
+                    TiffCodec::rgb48ToRgb32(src, dst, cols);
+                }
+                return true;
+            };
+        });
+    }
+    else {
+        /* Bands of whole strips (at least 64 rows, so each TIFFRGBAImageGet is worth its
+           setup) or of one tile row: a band never shares a strip or tile with another. */
+        const quint32 bandH = tiled ? unitH : unitH * qMax(1u, 64 / unitH);
+        const int bands = int((quint32(h) + bandH - 1) / bandH);
+        if (bands < 2) return false;
+        ok = TiffCodec::forEachWorker(bands, [&]() -> TiffCodec::Work {
+            auto t = std::make_shared<RgbaHandle>(fPath, ifdOffset);
+            if (!t->ok) return {};
+            return [&, t](int b) {
+                const qint64 y0 = qint64(b) * bandH;
+                const int rows = int(qMin<qint64>(bandH, h - y0));
+                uchar *first = bits + y0 * bpl;
+                t->img.row_offset = int(y0);
+                t->img.col_offset = 0;
+                // the raster is w x rows packed uint32, which these QImage rows are
+                if (!TIFFRGBAImageGet(&t->img, reinterpret_cast<uint32_t *>(first),
+                                      uint32_t(w), uint32_t(rows)))
+                    return false;
+                for (int r = 0; r < rows; ++r) convert32BitOrder(first + r * bpl, w);
+                return true;
+            };
+        });
+    }
+    if (!ok) return false;
+    *image = out;
+    return true;
+}
 
+bool Tiff::readRegion(QString fPath, const QRect &rect, QImage *image, quint32 ifdOffset)
+{
+/*
+    Decode just rect of the image, for RegionDecoder (the loupe at 1:1 while the full
+    decode is pending). libtiff's RGBA reader starts at row_offset / col_offset and reads
+    only the strips or tiles that overlap the rect, so a viewport of a 60 MP TIFF costs a
+    few percent of read().
+
+    Every layout goes through the 8 bit RGBA reader: the result is a placeholder for the
+    full decode, shown at display depth anyway. Returns false (the caller waits for the
+    full decode) when the file's orientation tag is anything but top-left, because read()
+    and ImageDecoder::rotate then disagree on where the rect is.
+*/
+    QString fun = "Tiff::readRegion";
+    if (G::isLogger) G::log(fun, fPath);
+
+    TIFF *tiff = TIFFOpen(fPath.toStdString().c_str(), "r");
+    if (!tiff) {
+        if (isDebug) qDebug() << "Tiff::readRegion Failed to open TIFF file." << fPath;
+        return false;
+    }
+
+    if (ifdOffset) {
+        TIFFSetSubDirectory(tiff, ifdOffset);
+    }
+
+    uint16_t orientation = ORIENTATION_TOPLEFT;
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_ORIENTATION, &orientation);
+    char emsg[1024] = "";
+    TIFFRGBAImage img;
+    if (orientation != ORIENTATION_TOPLEFT || !TIFFRGBAImageOK(tiff, emsg)
+        || !TIFFRGBAImageBegin(&img, tiff, 1, emsg)) {
+        if (isDebug) qDebug() << "Tiff::readRegion Unsupported." << emsg << fPath;
+        TIFFClose(tiff);
+        return false;
+    }
+
+    const QRect r = rect & QRect(0, 0, int(img.width), int(img.height));
+    bool ok = !r.isEmpty();
+    if (ok) {
+        *image = QImage(r.size(), QImage::Format_ARGB32);
+        ok = !image->isNull();
+    }
+    if (ok) {
+        img.req_orientation = ORIENTATION_TOPLEFT;
+        img.row_offset = r.y();
+        img.col_offset = r.x();
+        // the raster is width x height packed uint32, which an ARGB32 QImage is
+        ok = TIFFRGBAImageGet(&img, reinterpret_cast<uint32_t *>(image->bits()),
+                              uint32_t(r.width()), uint32_t(r.height()));
+    }
+    TIFFRGBAImageEnd(&img);
+    TIFFClose(tiff);
+    if (!ok) {
+        if (isDebug) qDebug() << "Tiff::readRegion Failed to TIFFRGBAImageGet." << fPath;
+        return false;
+    }
+
+    for (int y = 0; y < image->height(); ++y)
+        convert32BitOrder(image->scanLine(y), image->width());
+    image->convertTo(QImage::Format_RGB32);
     return true;
 }
 
@@ -73,6 +73,8 @@ public:
 
     // // from QTiffHandler, adapted for Winnow and using Winnow libtiff, which reads jpg encoding
     bool read(QString fPath, QImage *image, quint32 ifdOffset = 0);
+    // decode only rect (top-left orientation only), for the loupe's RegionDecoder
+    bool readRegion(QString fPath, const QRect &rect, QImage *image, quint32 ifdOffset = 0);
     // produces a thumbnail-sized QImage directly via nearest-neighbor sampling
     bool readSample(QString fPath, QImage *image, int longSide, quint32 ifdOffset = 0);
     // // #endif
@@ -168,6 +170,7 @@ private:
     quint32 parseIFDs(MetadataParameters &p, ImageMetadata &m, IFD *ifd,
                    quint32 &nextIFDOffset, int &thumbLongside, QString hdr);
 
+    bool decodeStrips(MetadataParameters &p, QImage &out);
     bool decodeBase(MetadataParameters &p);
     bool decodeLZW(MetadataParameters &p);
     bool decodeZip(MetadataParameters &p);
@@ -198,6 +201,10 @@ private:
     bool readHeaders(TIFF *tiff, QSize &size, QImage::Format &format, uint16_t &photometric,
                      bool &grayscale, bool &floatingPoint,
                      QImageIOHandler::Transformations transformation);
+    bool readParallel(const QString &fPath, quint32 ifdOffset, TIFF *tiff, QSize size,
+                      QImage::Format format, uint16_t photometric, bool floatingPoint,
+                      QImage *image);
+    void readResolution(TIFF *tiff, QImage *image);
 };
 
 #endif // TIFF_H
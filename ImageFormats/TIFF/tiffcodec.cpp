@@ -0,0 +1,177 @@
+#include "ImageFormats/Tiff/tiffcodec.h"
+#include <QFuture>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <atomic>
+
+namespace TiffCodec {
+
+qsizetype lzwDecode(const uchar *in, qsizetype inLen, uchar *out, qsizetype outLen)
+{
+/*
+    The string table is kept as (prefix code, last byte) pairs with each entry's first
+    byte and length, so a string is written back to front straight into out and adding
+    an entry is four stores -- no per-entry buffers. Codes outside the table end the
+    strip as corrupt; whatever was decoded by then is kept.
+*/
+    enum { ClearCode = 256, EoiCode = 257, FirstFree = 258, MaxCodes = 4096 };
+    quint16 prefix[MaxCodes];
+    uchar suffix[MaxCodes];
+    uchar first[MaxCodes];
+    quint16 length[MaxCodes];
+    for (int i = 0; i < 256; ++i) {
+        prefix[i] = 0;
+        suffix[i] = uchar(i);
+        first[i] = uchar(i);
+        length[i] = 1;
+    }
+
+    // write the string for code at out[o], clipped to outLen
+    auto put = [&](int code, qsizetype o) {
+        qsizetype pos = o + length[code] - 1;
+        for (;;) {
+            if (pos < outLen) out[pos] = suffix[code];
+            if (length[code] == 1) break;
+            code = prefix[code];
+            --pos;
+        }
+    };
+
+    qsizetype i = 0;
+    qsizetype o = 0;
+    quint32 bits = 0;
+    int nBits = 0;
+    int codeBits = 9;
+    int next = FirstFree;
+    int prev = -1;
+    while (o < outLen) {
+        while (nBits < codeBits) {
+            if (i >= inLen) return o;
+            bits = (bits << 8) | in[i++];
+            nBits += 8;
+        }
+        const int code = int(bits >> (nBits - codeBits)) & ((1 << codeBits) - 1);
+        nBits -= codeBits;
+
+        if (code == ClearCode) {
+            codeBits = 9;
+            next = FirstFree;
+            prev = -1;
+            continue;
+        }
+        if (code == EoiCode) break;
+
+        if (prev < 0) {
+            if (code > 255) break;
+            out[o++] = uchar(code);
+            prev = code;
+            continue;
+        }
+
+        uchar head;
+        if (code < next) {
+            put(code, o);
+            head = first[code];
+            o += length[code];
+        }
+        else if (code == next) {
+            // KwKwK: the previous string plus its own first byte
+            put(prev, o);
+            head = first[prev];
+            if (o + length[prev] < outLen) out[o + length[prev]] = head;
+            o += length[prev] + 1;
+        }
+        else break;
+
+        if (next < MaxCodes) {
+            prefix[next] = quint16(prev);
+            suffix[next] = head;
+            first[next] = first[prev];
+            length[next] = quint16(length[prev] + 1);
+            ++next;
+        }
+        // early change: widen one code before the table fills the current width
+        if (next == (1 << codeBits) - 1 && codeBits < 12) ++codeBits;
+        prev = code;
+    }
+    return qMin(o, outLen);
+}
+
+void toHost16(quint16 *s, qsizetype n, bool bigEndian)
+{
+    if (bigEndian == (Q_BYTE_ORDER == Q_BIG_ENDIAN)) return;
+    for (qsizetype i = 0; i < n; ++i) s[i] = quint16((s[i] >> 8) | (s[i] << 8));
+}
+
+void undoPredictor8(uchar *row, int samples, int spp)
+{
+    for (int i = spp; i < samples; ++i) row[i] = uchar(row[i] + row[i - spp]);
+}
+
+void undoPredictor16(quint16 *row, int samples, int spp)
+{
+    for (int i = spp; i < samples; ++i) row[i] = quint16(row[i] + row[i - spp]);
+}
+
+void rgb24ToRgb32(const uchar *src, QRgb *dst, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const uchar *p = src + 3 * x;
+        dst[x] = 0xff000000u | (uint(p[0]) << 16) | (uint(p[1]) << 8) | uint(p[2]);
+    }
+}
+
+namespace {
+// round(v / 257), the 16 -> 8 bit reduction QRgba64::toArgb32 uses
+inline uint to8(uint v) { return (v + 128 - ((v + 128) >> 8)) >> 8; }
+}
+
+void rgb48ToRgb32(const quint16 *src, QRgb *dst, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const quint16 *p = src + 3 * x;
+        dst[x] = 0xff000000u | (to8(p[0]) << 16) | (to8(p[1]) << 8) | to8(p[2]);
+    }
+}
+
+bool forEachWorker(int n, const std::function<Work()> &makeWorker, int threads)
+{
+    if (n <= 0) return true;
+    std::atomic<int> nextItem{0};
+    std::atomic<int> done{0};
+    std::atomic<bool> failed{false};
+    auto run = [&]() {
+        const Work work = makeWorker();
+        if (!work) return;
+        for (;;) {
+            if (failed.load(std::memory_order_relaxed)) return;
+            const int i = nextItem.fetch_add(1, std::memory_order_relaxed);
+            if (i >= n) return;
+            if (!work(i)) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            done.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    const int maxThreads = threads > 0
+                               ? threads
+                               : qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int helpers = qMin(maxThreads, n) - 1;
+    QVector<QFuture<void>> futures;
+    futures.reserve(helpers);
+    for (int k = 0; k < helpers; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), run));
+    run();
+    for (QFuture<void> &f : futures) f.waitForFinished();
+    return !failed.load() && done.load() == n;
+}
+
+bool forEach(int n, const Work &work, int threads)
+{
+    return forEachWorker(n, [&work]() { return work; }, threads);
+}
+
+} // namespace TiffCodec
@@ -0,0 +1,58 @@
+#ifndef TIFFCODEC_H
+#define TIFFCODEC_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <functional>
+
+/*
+    Per-strip kernels for Tiff::decode and Tiff::read, and the loop that runs them.
+
+    A TIFF strip (or tile) is compressed on its own, so strips decode independently and
+    in any order. Both decoders used to walk them one after another on the ImageDecoder
+    thread: a 16-bit 60 MP focus-stack TIFF spent seconds in LZW or deflate, predictor
+    undo and the RGBX64 -> RGB32 conversion, with the other cores idle. forEach() spreads
+    the strips over the global QThreadPool; each strip is decompressed, un-predicted and
+    converted straight into its rows of the RGB32 target.
+
+    The pixel loops (byte swap, 24/48 bit -> RGB32) are branch-free passes over plain
+    arrays so the compiler vectorises them. Predictor undo is a running sum along the
+    row, so it stays a scalar loop, but it now runs in the strip workers.
+
+    Qt Core only, so tst_tiffcodec can exercise it without libtiff.
+*/
+namespace TiffCodec {
+
+/* TIFF LZW (MSB-first 9-12 bit codes, early change). Decodes into out, never writing
+   past outLen. Returns the number of bytes the stream produced, clipped to outLen. */
+qsizetype lzwDecode(const uchar *in, qsizetype inLen, uchar *out, qsizetype outLen);
+
+/* 16-bit samples in file byte order -> host order. */
+void toHost16(quint16 *s, qsizetype n, bool bigEndian);
+
+/* Undo horizontal differencing (Predictor = 2) on one row of `samples` samples,
+   spp samples per pixel. */
+void undoPredictor8(uchar *row, int samples, int spp);
+void undoPredictor16(quint16 *row, int samples, int spp);
+
+/* One row of interleaved RGB to opaque RGB32. 16-bit samples are rounded to 8 bits
+   exactly as QImage's RGBX64 -> RGB32 conversion does (round(v / 257)). */
+void rgb24ToRgb32(const uchar *src, QRgb *dst, int width);
+void rgb48ToRgb32(const quint16 *src, QRgb *dst, int width);
+
+using Work = std::function<bool(int)>;
+
+/* Run work(i) for i in [0, n) on the calling thread plus up to threads - 1 helpers
+   from the global pool (threads <= 0: the pool's size). Stops handing out work after
+   the first false and returns false. */
+bool forEach(int n, const Work &work, int threads = 0);
+
+/* The same, but each worker first calls makeWorker() for a Work of its own -- for
+   state that must not be shared between threads, such as a libtiff handle, owned by
+   the closure. A worker given an empty Work takes no strips. True only if every i
+   was done. */
+bool forEachWorker(int n, const std::function<Work()> &makeWorker, int threads = 0);
+
+} // namespace TiffCodec
+
+#endif // TIFFCODEC_H
@@ -485,6 +485,14 @@ QString MW::developDiagnostics()
             << "   (~" << QString::number(mb, 'f', 1) << " MB)";
         rpt << "\n" << "  isValid = " << G::s(work->isValid());
     }
+    {
+        const WorkingImageCache &wic = WorkingImageCache::instance();
+        rpt << "\n" << "  cache = " << G::s(wic.count()) << " images, "
+            << QString::number(double(wic.currentBytes()) / (1024.0 * 1024.0), 'f', 1)
+            << " of " << QString::number(double(wic.maxBytes()) / (1024.0 * 1024.0), 'f', 0)
+            << " MB, tail stored as "
+            << (wic.storage() == WorkingImageCache::Storage::Half ? "half float" : "float");
+    }
     rpt << "\n";
 
     // RAW SENSOR INFO
@@ -541,7 +549,10 @@ QString MW::developDiagnostics()
                 ? "" : "   (inert: PMRID needs the CFA mosaic, not available on the Apple engine)");
     rpt << "\n" << "  developDenoised = " << dims(developDenoised)
         << "   key = " << (developDenoisedKey.isEmpty() ? "(clean)" : developDenoisedKey);
-    rpt << "\n" << "  developPmridFull = " << dims(developPmridFull)
+    rpt << "\n" << "  developPmridFull = "
+        << (developPmridFull ? QString("%1 x %2 (half float)").arg(developPmridFull->width)
+                                   .arg(developPmridFull->height)
+                             : QString("(none)"))
         << "   key = " << (developPmridKey.isEmpty() ? "(none)" : developPmridKey);
     rpt << "\n" << "  developDenoiseInFlightKey = "
         << (developDenoiseInFlightKey.isEmpty() ? "(idle)" : developDenoiseInFlightKey);
@@ -571,6 +582,8 @@ QString MW::developDiagnostics()
                 : "");
     rpt << "\n" << "  developParamsGen = " << G::s((int)developParamsGen);
     rpt << "\n" << "  developFullResInFlight = " << G::s(developFullResInFlight);
+    rpt << "\n" << "  developViewportInFlight = " << G::s(developViewportInFlight)
+        << "   path = " << (developViewportPath.isEmpty() ? "(none)" : developViewportPath);
     rpt << "\n" << "  developProxy = " << dims(developProxy)
         << "   path = " << (developProxyPath.isEmpty() ? "(none)" : developProxyPath);
     rpt << "\n";
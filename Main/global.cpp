@@ -231,6 +231,10 @@ int minIconSize = 40;
 int maxIconChunk = 10000;
 bool   useJitIconCache = false;         // testing flag; see DataModel::resolveIconChunkSize
 double jitIconCacheMemFraction = 0.5;   // share of free-remainder memory budgeted for thumbnails
+bool   useDiskPreviewCache = false;     // on-disk preview tier, see PreviewDiskCache
+int    diskPreviewCacheMB = 4000;       // size cap for the on-disk preview tier
+bool   useTieredImageCache = true;      // cache non-current images at loupe resolution
+std::atomic<int> loupeEdgePx{0};        // loupe long edge in device pixels (ImageView::resizeEvent)
 bool   showCacheProgress = true;        // single gate for ImageCache + MetaRead progress display
 std::atomic<qint64> imageCacheHeadroomMB{0};  // image cache's remaining intended claim (MB)
 int iconPressureTestLevel = -1;         // -1 real; 0 normal+recovered; 1 warn; 2 critical; 3 normal-not-recovered
@@ -266,6 +270,8 @@ bool autoAddMissingThumbnails;
 bool renderVideoThumb;
 bool combineRawJpg;
 bool useRaw;
+bool useRcdDemosaic = true;
+bool useRawInLoupe = false;
 bool isFilter;
 bool isRemote;
 
@@ -395,6 +395,18 @@ Q_NAMESPACE
     extern bool   useJitIconCache;
     extern double jitIconCacheMemFraction;
 
+    /* On-disk preview tier behind the image cache (see PreviewDiskCache). Off by default;
+       diskPreviewCacheMB caps the folder, least recently used previews are deleted. */
+    extern bool   useDiskPreviewCache;
+    extern int    diskPreviewCacheMB;
+
+    /* Resolution tiers in the image cache (see ImageCacheData). When on, images other
+       than the current one are cached scaled to the loupe (loupeEdgePx, the viewport's
+       long edge in device pixels, kept up to date by ImageView::resizeEvent) and the full
+       decode is fetched only for the current image or on zoom-in. */
+    extern bool   useTieredImageCache;
+    extern std::atomic<int> loupeEdgePx;
+
     /* Single flag gating both ImageCache and MetaRead caching progress. When false,
        progress is neither calculated nor displayed (see ImageCache::updateStatus,
        MetaRead::dispatch and the Progress widget). */
@@ -570,6 +582,8 @@ Q_NAMESPACE
     extern bool renderVideoThumb;
     extern bool combineRawJpg;
     extern bool useRaw;         // decode raw sensor data (true) vs embedded preview/jpg (false)
+    extern bool useRcdDemosaic; // Winnow engine demosaic: RCD / X-Trans Markesteijn (true) vs bilinear (false)
+    extern bool useRawInLoupe;  // Preview shows raws from the sensor decode (half size until zoomed)
     extern bool isFilter;
 
     // focus stack
@@ -1,5 +1,6 @@
 #include "Main/mainwindow.h"
 #include "Develop/workingimagecache.h"
+#include "Cache/previewdiskcache.h"
 
 void MW::initialize()
 {
@@ -439,6 +440,10 @@ void MW::createImageCache()
         }
     }
 
+    // on-disk preview tier (G:: values loaded in MW::loadSettings)
+    PreviewDiskCache::instance().setMaxBytes(qint64(G::diskPreviewCacheMB) << 20);
+    PreviewDiskCache::instance().setEnabled(G::useDiskPreviewCache);
+
     connect(&imageCacheThread, &QThread::finished,
             imageCache, &QObject::deleteLater);
 
@@ -807,6 +812,9 @@ void MW::createImageView()
             thumbView, &IconView::loupeRect);
     connect(imageView, &ImageView::showLoupeRect,
             thumbView, &IconView::showLoupeRect);
+    // resolution tiers: zoom past a reduced cache entry fetches the full decode
+    connect(imageView, &ImageView::needFullResolution,
+            imageCache, &ImageCache::requestFullResolution);
 }
 
 void MW::createCompareView()
@@ -1957,7 +1965,9 @@ void MW::createDevelopDock()
        instead of twice and the veil composite is not re-run per mouse-move event. */
     connect(developProxyRenderTimer, &QTimer::timeout, this, [this]{
         updateMaskOverlayTint();
-        renderDevelopPreview(false);
+        /* The one caller whose frame is always replaced (developFullResTimer settles it),
+           so the only one that takes the baked point table. */
+        renderDevelopPreview(false, WorkingImageCache::PointPath::Lut);
     });
     developFullResTimer = new QTimer(this);
     developFullResTimer->setSingleShot(true);
@@ -1976,6 +1986,9 @@ void MW::createDevelopDock()
     developProxyPool = new QThreadPool(this);
     developProxyPool->setMaxThreadCount(1);
 
+    /* A pan or zoom during a 1:1 viewport settle renders the tiles it uncovers. */
+    connect(imageView, &ImageView::developViewChanged, this, &MW::onDevelopViewChanged);
+
     developDockTabText = "Develop";
     dockTextNames << developDockTabText;
     developDock = new DockWidget(developDockTabText, "DevelopDock", this);  // Develop
@@ -2717,7 +2730,7 @@ void MW::setOperationMode(G::OperationMode mode)
        to verify). */
     if (mode == G::OperationMode::Develop && icd && dm && !dm->currentFilePath.isEmpty()
         && icd->contains(dm->currentFilePath)) {
-        const QImage prev = icd->imCache.value(dm->currentFilePath);
+        const QImage prev = icd->value(dm->currentFilePath);
         developVerifyPreviewBaseline = prev.isNull()
             ? QImage()
             : prev.scaled(256, 256, Qt::KeepAspectRatio, Qt::SmoothTransformation);
@@ -2765,6 +2778,9 @@ void MW::setOperationMode(G::OperationMode mode)
             const bool selIsVideo = currentIsVideo();
             developProperties->setCurrentImage(selIsVideo || !dm ? QString()
                                                                  : dm->currentFilePath);
+            /* The image being edited: never packed or evicted by decoder traffic. */
+            WorkingImageCache::instance().setActive(selIsVideo || !dm ? QString()
+                                                                      : dm->currentFilePath);
             /* Entering Develop re-decodes the current image (~3s). If it has a "Denoise
                raw" amount, start that decode NOW so its progress shows immediately --
                otherwise it would not fire until the clean decode + settle. Produces the
@@ -2779,6 +2795,7 @@ void MW::setOperationMode(G::OperationMode mode)
         }
         else {
             developProperties->flushAll();
+            WorkingImageCache::instance().setActive(QString());
         }
         /* Show/hide the multi-image warning for the mode we just entered (the banner is
            only reachable in Develop, but its text is stale until refreshed). */
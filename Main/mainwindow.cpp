@@ -3089,6 +3089,8 @@ void MW::fileSelectionChange(QModelIndex current, QModelIndex previous, bool cle
     if (developProperties && G::operationMode == G::OperationMode::Develop) {
         const bool selIsVideo = dm->sf->index(current.row(), G::VideoColumn).data().toBool();
         developProperties->setCurrentImage(selIsVideo ? QString() : fPath);
+        /* Keep its pre-develop image float and resident while the decoders read ahead. */
+        WorkingImageCache::instance().setActive(selIsVideo ? QString() : fPath);
         /* The banner and the panel's enabled state both follow the current index as well
            as the selection set, and are refreshed together further down (once the central
            widget has been switched to the loupe or the video player). */
@@ -5727,10 +5729,12 @@ QImage developComposite(const WorkingImage &src, const EditParams &edit, int deg
                         WorkingImageCache::Space space =
                             WorkingImageCache::Space::sRGB,
                         bool upscaleToFull = true,
-                        WorkingImage *scratch = nullptr)
+                        WorkingImage *scratch = nullptr,
+                        WorkingImageCache::PointPath point =
+                            WorkingImageCache::PointPath::Direct)
 {
     QImage out;
-    if (!WorkingImageCache::render(src, edit, out, timings, depth, space, scratch))
+    if (!WorkingImageCache::render(src, edit, out, timings, depth, space, scratch, point))
         return QImage();
     QElapsedTimer probe;
     if (timings) probe.start();
@@ -6453,7 +6457,10 @@ void applySpots(QImage &img, const QVector<FillSpot> &spots, const QString &fPat
 /* cache (optional) is the interactive proxy's per-scope intermediate store -- see
    Develop/developstackcache.h. Only the GUI-thread proxy path passes one; the off-thread
    settle render and the small verification renders pass nullptr and recompute everything,
-   which is also what keeps the cache lock-free. */
+   which is also what keeps the cache lock-free.
+   point picks how Develop runs the fused point pass (WorkingImageCache::PointPath):
+   renderDevelopPreview passes Lut for the drag tick's proxy only; its other callers, the
+   settle render that replaces them, export and the verification renders keep Direct. */
 /* Defined below, next to the other stack predicates; needed here for the mask keys. */
 bool scopeMaskDependsOnBase(const DevelopProperties::StackRenderJob::Scope &L);
 
@@ -6467,7 +6474,9 @@ QImage developCompositeStack(const WorkingImage &src, const DevelopProperties::S
                              DevelopStackCache *cache = nullptr,
                              QSize *displaySize = nullptr,
                              MaskBuildStats *maskStats = nullptr,
-                             const QByteArray &baseKey = QByteArray())
+                             const QByteArray &baseKey = QByteArray(),
+                             WorkingImageCache::PointPath point =
+                                 WorkingImageCache::PointPath::Direct)
 {
     /* An interactive (proxy) render is normally left at PROXY resolution -- the loupe
        stretches it (ScaledPixmapItem) instead of this function allocating and filling a
@@ -6493,7 +6502,7 @@ QImage developCompositeStack(const WorkingImage &src, const DevelopProperties::S
         std::shared_ptr<WorkingImage> scratchHold;
         if (cache) scratchHold = cache->accScratch();
         out = developComposite(src, job.global, degrees, fullRes, fullW, fullH, timings,
-                               depth, space, upscale, scratchHold.get());
+                               depth, space, upscale, scratchHold.get(), point);
     }
     else {
         QElapsedTimer probe;
@@ -6586,7 +6595,7 @@ QImage developCompositeStack(const WorkingImage &src, const DevelopProperties::S
             resumeP = &resume;
         }
         if (!WorkingImageCache::renderStack(src, job.global, sl, out, timings, depth,
-                                           space, resumeP))
+                                           space, resumeP, point))
             return QImage();
         /* setHot REPLACES the previous tick's prefix/layer, so the shared_ptrs it drops
            free two proxy-resolution WorkingImages here. That is not bookkeeping -- it is
@@ -7438,7 +7447,7 @@ void MW::syncPendingMaskOp()
     developProperties->setPendingMaskOp(DevelopProperties::maskOpFromModifiers());
 }
 
-void MW::renderDevelopPreview(bool fullRes)
+void MW::renderDevelopPreview(bool fullRes, WorkingImageCache::PointPath point)
 {
 /*
     Re-render the current image through Develop + OutputTransform and push the result straight
@@ -7448,6 +7457,8 @@ void MW::renderDevelopPreview(bool fullRes)
     fullRes=false (interactive drag) renders a screen-resolution PROXY (cached per path) and
     upscales it to the displayed dimensions, so a 50MP RAW costs a few MP of work per tick.
     fullRes=true (drag settled) renders the full image once for a crisp result.
+    point is Lut only from the drag tick (developProxyRenderTimer): the settle render
+    replaces those frames. The full render is always Direct.
 
     PHASE 1 (Develop ops): this is a live, in-session preview. The edit is NOT yet persisted
     or written back to the image cache, so navigating away and back shows the un-developed
@@ -7487,8 +7498,9 @@ void MW::renderDevelopPreview(bool fullRes)
     if (!work) {
         /* Non-raw (JPG/TIFF/HEIC), or the raw re-decode failed: build the pre-develop WorkingImage
            from the decoded display image. Correct for display-referred files; a last resort for raw. */
-        if (!icd->contains(fPath)) return;          // not decoded yet; nothing to preview
-        const QImage src = icd->imCache.value(fPath);
+        // not decoded yet (a reduced tier entry is a stand-in until the full decode lands)
+        if (!icd->contains(fPath) || icd->isReduced(fPath)) return;
+        const QImage src = icd->value(fPath);
         if (src.isNull()) return;
         auto built = std::make_shared<WorkingImage>();
         InputTransform input;
@@ -7626,9 +7638,12 @@ void MW::renderDevelopPreview(bool fullRes)
     const bool wantTime = G::isReportDevelopTime;
     const qint64 tProxyCap = tProxy;
 
+    const WorkingImageCache::PointPath pointPath =
+        fullRes ? WorkingImageCache::PointPath::Direct : point;
+
     developProxyPool->start([this, proxySrc, mj, degrees, fullRes, fw, fh, fPath, cache,
                             reqGen, geomGen, wantTime, tProxyCap, cacheSurvived,
-                            baseKey]() {
+                            baseKey, pointPath]() {
         QElapsedTimer wt;
         wt.start();
         WorkingImageCache::RenderTimings rt;
@@ -7640,7 +7655,7 @@ void MW::renderDevelopPreview(bool fullRes)
                                            WorkingImageCache::OutDepth::Eight,
                                            WorkingImageCache::Space::sRGB, cache,
                                            &displaySize,
-                                           wantTime ? &ms : nullptr, baseKey);
+                                           wantTime ? &ms : nullptr, baseKey, pointPath);
         const qint64 tRender = wt.restart();
         const Geometry appliedGeom = mj.geometry;
         const QSize orientedSize(fw, fh);
@@ -7809,7 +7824,7 @@ void MW::applyDevelopPreviewIfEdited()
        setDevelopPreview. Otherwise nothing overlays the loupe, so refresh the scopes here from the
        decoded image actually shown (valid in preview mode too). */
     if (!currentDevelopEditsVisible()) {
-        updateDevelopScopes(icd->imCache.value(dm->currentFilePath));
+        updateDevelopScopes(icd->value(dm->currentFilePath));
         return;
     }
     developParamsChange();   // schedule the proxy + full-res settle render of the saved params
@@ -7881,6 +7896,12 @@ void MW::renderDevelopFullResAsync()
        worker, so the off-thread render confines the stroke the same as the proxy did. */
     if (stackHasLumAutoMaskBrush(mj)) imageView->ensureAutoGuide();
 
+    /* At 1:1 develop only what the view shows; the whole frame otherwise. */
+    developViewportPath = fPath;
+    developViewportGen = gen;
+    if (renderDevelopViewport()) return;
+    developViewportPath.clear();
+
     developFullResInFlight = true;
     updateDevelopRenderingHint();
     std::shared_ptr<const WorkingImage> src = base;   // denoised base when set, else clean; kept alive
@@ -8051,6 +8072,129 @@ void MW::onDevelopFullResReady(const QImage &out, const QString &fPath, quint64
         developFullResTimer->start(kDevelopSettleMs);
 }
 
+bool MW::renderDevelopViewport()
+{
+/*
+    The settle render for a loupe that shows only part of the frame. At 1:1 on a 50 MP
+    RAW the view is a few megapixels of it, and developing the whole frame to show them
+    took ~1.3 s; a window around the view takes tens of ms. So the settle develops the
+    visible cells of a kDevelopViewportTile grid (display coordinates) through
+    WorkingImageCache::renderWindow -- which grows the window by Develop::halo so the
+    neighbourhood ops see what they would in the whole frame -- and lays them over the
+    proxy pmItem already holds. A pan renders only the cells it uncovers, the bounding
+    rect of them in one batch; ImageView keeps the ones rendered, so panning back is free.
+
+    It handles a GLOBAL-only recipe with no geometry: masks, spots and crop/warp are
+    composited over the whole frame (masks are rasterised per frame, spots heal from
+    content anywhere in it, geometry moves every pixel), so those settle in full. So
+    does a view showing more than half the frame, where a window saves too little to
+    be worth a proxy left on screen around it. The scopes and the render verification
+    stay on the proxy tick's numbers until a full settle runs.
+*/
+    if (!imageView || !dm || !developProperties) return false;
+    const QString fPath = dm->currentFilePath;
+    if (fPath.isEmpty() || fPath != developViewportPath) return false;
+    if (developViewportGen != developParamsGen) return false;
+    if (G::operationMode != G::OperationMode::Develop) return false;
+    auto work = WorkingImageCache::instance().get(fPath);
+    if (!work) return false;
+
+    auto mj = developProperties->stackJob();
+    if (developCropEditing && !developCropShowResult) {   // suppress crop, as the settle does
+        mj.geometry.cropX = 0.0; mj.geometry.cropY = 0.0;
+        mj.geometry.cropW = 1.0; mj.geometry.cropH = 1.0;
+    }
+    if (!mj.scopes.isEmpty() || !mj.spots.isEmpty() || !mj.geometry.isIdentity()) return false;
+
+    const int degrees = work->sceneReferred ? developOrientationDegrees(*work, fPath) : 0;
+    const int W = work->width, H = work->height;
+    const bool quarter = degrees == 90 || degrees == 270;
+    const QSize frame = quarter ? QSize(H, W) : QSize(W, H);
+    if (imageView->developDisplaySize() != frame) return false;    // not this frame on screen
+    const QRect visible = imageView->developVisibleRect();
+    if (visible.isEmpty()) return false;
+    if (2 * qint64(visible.width()) * visible.height() > qint64(W) * H) return false;
+
+    if (developViewportInFlight) { developViewportPending = true; return true; }
+
+    /* The grid cells the view touches, less what the tiles already cover. */
+    const int T = kDevelopViewportTile;
+    const QRect cells = QRect(QPoint(visible.left() / T * T, visible.top() / T * T),
+                              QPoint((visible.right() / T + 1) * T - 1,
+                                     (visible.bottom() / T + 1) * T - 1))
+                        & QRect(QPoint(0, 0), frame);
+    const QRegion needed = QRegion(cells) - imageView->developTileRegion();
+    if (needed.isEmpty()) return true;
+    const QRect disp = needed.boundingRect();
+
+    /* Display rect -> the sensor rect it was rotated from (developComposite rotates the
+       frame by degrees, clockwise). */
+    const int dx0 = disp.left(), dx1 = disp.left() + disp.width();
+    const int dy0 = disp.top(),  dy1 = disp.top() + disp.height();
+    QRect sensor = disp;
+    switch (degrees) {
+    case 90:  sensor = QRect(dy0, H - dx1, dy1 - dy0, dx1 - dx0); break;
+    case 180: sensor = QRect(W - dx1, H - dy1, dx1 - dx0, dy1 - dy0); break;
+    case 270: sensor = QRect(W - dy1, dx0, dy1 - dy0, dx1 - dx0); break;
+    default:  break;
+    }
+
+    const std::shared_ptr<const WorkingImage> src = developRawDenoisedBase(fPath, mj.global, work);
+    const EditParams edit = mj.global;
+    const quint64 gen = developParamsGen;
+    const int tileGen = imageView->developTileGeneration();
+    developViewportInFlight = true;
+    developViewportPending = false;
+    developRenderPool->start([this, src, edit, sensor, disp, degrees, fPath, gen, tileGen]() {
+        QElapsedTimer t;
+        WorkingImageCache::RenderTimings rt;
+        const bool probe = G::isReportDevelopTime;
+        if (probe) t.start();
+        QImage out;
+        if (WorkingImageCache::renderWindow(*src, edit, sensor, out, probe ? &rt : nullptr)
+            && degrees != 0) {
+            QTransform trans;
+            trans.rotate(degrees);
+            out = out.transformed(trans, Qt::SmoothTransformation);
+        }
+        const qint64 ms = probe ? t.elapsed() : 0;
+        QMetaObject::invokeMethod(this, [this, out, disp, fPath, gen, tileGen, ms, rt]() {
+            if (G::isReportDevelopTime)
+                qDebug().noquote() << "[DevTime] viewport(async)" << out.width() << "x"
+                                   << out.height() << "at" << disp.x() << "," << disp.y()
+                                   << " total" << ms
+                                   << " (copy" << rt.copyMs << " develop" << rt.developMs
+                                   << " toImage" << rt.toImageMs << ")ms"
+                                   << " develop=[denoise" << rt.denoiseMs << " point" << rt.pointMs
+                                   << " texture" << rt.textureMs << " dehaze" << rt.dehazeMs
+                                   << " vignette" << rt.vignetteMs << " grain" << rt.grainMs << "]";
+            developViewportInFlight = false;
+            if (!out.isNull() && dm && fPath == dm->currentFilePath && gen == developParamsGen)
+                imageView->addDevelopTile(out, disp, tileGen);
+            if (developViewportPending) {
+                developViewportPending = false;
+                onDevelopViewChanged();
+            }
+        });
+    });
+    return true;
+}
+
+void MW::onDevelopViewChanged()
+{
+/*
+    The view moved while the viewport settle holds the loupe. Render what the move
+    uncovered; if the view no longer qualifies (zoomed out past half the frame), the
+    proxy would be all that is left on screen, so settle the whole frame instead.
+*/
+    if (!dm || developViewportPath.isEmpty()) return;
+    if (developViewportPath != dm->currentFilePath || developViewportGen != developParamsGen)
+        return;
+    if (renderDevelopViewport()) return;
+    developViewportPath.clear();
+    developFullResTimer->start(kDevelopSettleMs);
+}
+
 /* Cache key for the raw-denoised base: image path + the two Global "Denoise raw" amounts + ISO. */
 static QString rawDenoiseKey(const QString &fPath, const EditParams &base, int iso)
 {
@@ -8139,7 +8283,7 @@ void MW::ensureRawDenoise(const QString &fPath, const EditParams &base,
     // model drives the PMRID calibration
     m.model = dm->sf->index(dm->currentSfRow, G::CameraModelColumn).data().toString();
     dm->fPathRawInfoGet(fPath, m.rawInfo);
-    std::shared_ptr<const WorkingImage> pmridCached =
+    std::shared_ptr<const HalfImage> pmridCached =
         (developPmridKey == pkey && developPmridFull) ? developPmridFull : nullptr;
 
     // clean base if the caller had one (may be null on select)
@@ -8150,7 +8294,13 @@ void MW::ensureRawDenoise(const QString &fPath, const EditParams &base,
            (shared UnpackCfa) when either is missing; a pure amount change (both cached)
            skips the decode and just re-blends. clean is taken from the caller, else
            WorkingImageCache, else the decode's outClean. */
-        std::shared_ptr<const WorkingImage> pmrid = pmridCached;
+        std::shared_ptr<const WorkingImage> pmrid;
+        std::shared_ptr<const HalfImage> pmridHalf = pmridCached;
+        if (pmridCached) {
+            auto unpacked = std::make_shared<WorkingImage>();
+            UnpackImage(*pmridCached, *unpacked);
+            pmrid = unpacked;
+        }
         std::shared_ptr<const WorkingImage> cleanBase =
             src ? src : WorkingImageCache::instance().get(fPath);
         // freshClean is published to WorkingImageCache if the decode produced it
@@ -8225,8 +8375,15 @@ void MW::ensureRawDenoise(const QString &fPath, const EditParams &base,
         auto blended = std::make_shared<WorkingImage>();
         Develop::BlendRawDenoise(*cleanBase, *pmrid, b.denoiseLuma, b.denoiseChroma, *blended);
         std::shared_ptr<const WorkingImage> result = blended;
+        /* A fresh PMRID base is kept only to re-blend on an amount change, so it is held
+           packed (half the memory); a cached one already is. */
+        if (!pmridHalf) {
+            auto packed = std::make_shared<HalfImage>();
+            PackImage(*pmrid, *packed);
+            pmridHalf = packed;
+        }
 
-        QMetaObject::invokeMethod(this, [this, result, pmrid, freshClean, key, pkey, fPath,
+        QMetaObject::invokeMethod(this, [this, result, pmridHalf, freshClean, key, pkey, fPath,
                                          decodeRes, capturedRes]() {
             // job finished; allow the next (latest) one
             developDenoiseInFlightKey.clear();
@@ -8239,7 +8396,7 @@ void MW::ensureRawDenoise(const QString &fPath, const EditParams &base,
                ensureDevelopWork reuse it, not trigger another scene-linear decode. */
             if (freshClean && !WorkingImageCache::instance().contains(fPath))
                 WorkingImageCache::instance().put(fPath, freshClean);
-            developPmridFull = pmrid;      // cache the full base for other amounts
+            developPmridFull = pmridHalf;  // cache the full base for other amounts
             developPmridKey = pkey;
             if (capturedRes) {             // noise-model snapshot for this base (diag)
                 developPmridResSource = decodeRes.source;
@@ -8478,8 +8635,9 @@ void MW::ensureWorkingImageNow(const QString &fPath)
     }
     if (work && work->isValid()) return;
 
-    if (!icd->contains(fPath)) return;      // not decoded yet; nothing to build from
-    const QImage src = icd->imCache.value(fPath);
+    // not decoded yet (a reduced tier entry is a stand-in until the full decode lands)
+    if (!icd->contains(fPath) || icd->isReduced(fPath)) return;
+    const QImage src = icd->value(fPath);
     if (src.isNull()) return;
     auto built = std::make_shared<WorkingImage>();
     InputTransform input;
@@ -8632,7 +8790,7 @@ void MW::setDevelopScopesVisible(bool isVisible)
         if (currentDevelopEditsVisible())
             developParamsChange();
         else
-            updateDevelopScopes(icd->imCache.value(dm->currentFilePath));
+            updateDevelopScopes(icd->value(dm->currentFilePath));
     }
 }
 
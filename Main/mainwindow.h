@@ -43,6 +43,8 @@
 #include "Embellish/Properties/embelproperties.h"
 #include "Develop/Properties/developproperties.h"
 #include "Develop/workingimage.h"
+#include "Develop/workingimagecache.h"     // MW::renderDevelopPreview point path
+#include "Develop/halfimage.h"            // MW::developPmridFull
 #include "Develop/developstackcache.h"   // MW::developStackCache (interactive proxy)
 #include "Develop/Scopes/scopesview.h"
 #include "Develop/Transform/transformpanel.h"
@@ -586,8 +588,13 @@ private slots:
     void developParamsChange();
     /* Re-render the current image through Develop + OutputTransform and push it to the loupe.
        fullRes=false renders the screen-resolution proxy (interactive drag); fullRes=true
-       renders the full image (drag settled). The WorkingImage-cache hot path: no decode. */
-    void renderDevelopPreview(bool fullRes);
+       renders the full image (drag settled). The WorkingImage-cache hot path: no decode.
+       point: only the developProxyRenderTimer drag tick passes Lut, whose frames the
+       settle render replaces; every other caller's proxy may be the last frame shown, so
+       it keeps the exact Direct path. */
+    void renderDevelopPreview(bool fullRes,
+                              WorkingImageCache::PointPath point =
+                                  WorkingImageCache::PointPath::Direct);
     /* Launch the full-resolution settle render on developRenderPool (off the GUI thread) so a
        large RAW does not freeze the drag. At most one runs at a time; the result is applied via
        onDevelopFullResReady only if still current. */
@@ -609,6 +616,15 @@ private slots:
     /* GUI-thread completion for a background full-res render: apply the image if its params/image
        are still current, otherwise discard, then re-arm if newer params arrived while it ran. */
     void onDevelopFullResReady(const QImage &out, const QString &fPath, quint64 gen);
+    /* Viewport settle: when the loupe shows only part of the frame (1:1 and closer), the
+       settle develops just the visible tiles of it -- plus the ops' halo -- and lays them
+       over the proxy (ImageView::addDevelopTile); a pan renders the tiles it uncovers.
+       False, with nothing started, when the image, recipe or view is not one it handles;
+       the caller then settles the whole frame. See the impl. */
+    bool renderDevelopViewport();
+    /* ImageView::developViewChanged: feed the viewport settle the tiles a pan or zoom
+       uncovered, or hand over to the full settle once the view outgrows it. */
+    void onDevelopViewChanged();
     /* Global image the develop render pipeline should start from: the raw-DENOISED WorkingImage when
        the Global scope has "Denoise raw" (denoiseLuma/denoiseChroma) set and it is ready, else the
        clean cached WorkingImage. Pure lookup (no work); the async compute is ensureRawDenoise(). */
@@ -1556,6 +1572,15 @@ private:
     QThreadPool *developRenderPool = nullptr;
     quint64 developParamsGen = 0;                 // ++ on every Develop param change (staleness guard)
     bool developFullResInFlight = false;      // a background full-res render is running
+    /* Viewport settle (renderDevelopViewport). developViewportPath/Gen name the settle the
+       tiles belong to -- a view change under any other image or recipe is not its
+       business. It shares developRenderPool with the full settle; one tile batch runs at
+       a time and a view change meanwhile is picked up when it lands (Pending). */
+    static constexpr int kDevelopViewportTile = 512;   // display px: the grid a pan renders in
+    QString developViewportPath;
+    quint64 developViewportGen = 0;
+    bool developViewportInFlight = false;
+    bool developViewportPending = false;
     /* Interactive PROXY render, off the GUI thread. The brush cursor and every mask
        overlay are painted by ImageView on the GUI thread, so compositing there capped how
        smoothly the cursor could move no matter how cheap the render got. Its own 1-thread
@@ -1632,8 +1657,9 @@ private:
     bool developAutoRunDenoise = true;
     QString developDenoisedKey;                   // "path|dnL|dnC|iso"; empty when clean
     QString developDenoiseInFlightKey;            // key currently being computed (coalesce guard)
-    // full-strength PMRID base, reused across amounts
-    std::shared_ptr<const WorkingImage> developPmridFull;
+    /* full-strength PMRID base, reused across amounts. Read only to re-blend, so held as
+       binary16 (Develop/halfimage.h) and unpacked on the worker that blends. */
+    std::shared_ptr<const HalfImage> developPmridFull;
     QString developPmridKey;                      // "path|iso" for developPmridFull
     /* PMRID proved it cannot denoise: session-wide when the model itself cannot run (no
        ONNX Runtime / no pmrid.onnx -- nothing on any image will change that), per path
@@ -68,6 +68,8 @@ void MW::writeSettings()
     settings->setValue("includeSidecars", G::includeSidecars);
     settings->setValue("colorManage", G::colorManage);
     settings->setValue("useRaw", G::useRaw);
+    settings->setValue("useRcdDemosaic", G::useRcdDemosaic);
+    settings->setValue("useRawInLoupe", G::useRawInLoupe);
     settings->setValue("decodeRawEngine", static_cast<int>(G::decodeRawEngine));
     settings->setValue("rememberLastDir", rememberLastDir);
     settings->setValue("checkIfUpdate", checkIfUpdate);
@@ -115,6 +117,9 @@ void MW::writeSettings()
     // performance / productivity
     settings->setValue("showCacheProgress", G::showCacheProgress);
     settings->setValue("useJitIconCache", G::useJitIconCache);
+    settings->setValue("useDiskPreviewCache", G::useDiskPreviewCache);
+    settings->setValue("diskPreviewCacheMB", G::diskPreviewCacheMB);
+    settings->setValue("useTieredImageCache", G::useTieredImageCache);
 
     settings->setValue("isRatingBadgeVisible", ratingBadgeVisibleAction->isChecked());
     settings->setValue("isIconNumberVisible", iconNumberVisibleAction->isChecked());
@@ -333,6 +338,8 @@ bool MW::loadSettings()
         // files
         G::colorManage = true;
         G::useRaw = false;
+        G::useRcdDemosaic = true;
+        G::useRawInLoupe = false;
         rememberLastDir = false;
         checkIfUpdate = true;
         updateSkipVersion = "";
@@ -367,6 +374,9 @@ bool MW::loadSettings()
         // performance / productivity
         G::showCacheProgress = true;
         G::useJitIconCache = false;
+        G::useDiskPreviewCache = false;
+        G::diskPreviewCacheMB = 4000;
+        G::useTieredImageCache = true;
 
         // cache (see MW::createImageCache in initialize.cpp)
 
@@ -461,11 +471,16 @@ bool MW::loadSettings()
     // performance / productivity
     if (settings->contains("showCacheProgress")) G::showCacheProgress = settings->value("showCacheProgress").toBool();
     if (settings->contains("useJitIconCache")) G::useJitIconCache = settings->value("useJitIconCache").toBool();
+    if (settings->contains("useDiskPreviewCache")) G::useDiskPreviewCache = settings->value("useDiskPreviewCache").toBool();
+    if (settings->contains("diskPreviewCacheMB")) G::diskPreviewCacheMB = settings->value("diskPreviewCacheMB").toInt();
+    if (settings->contains("useTieredImageCache")) G::useTieredImageCache = settings->value("useTieredImageCache").toBool();
 
     // files
     if (settings->contains("includeSidecars")) G::includeSidecars = settings->value("includeSidecars").toBool();
     if (settings->contains("colorManage")) G::colorManage = settings->value("colorManage").toBool();
     if (settings->contains("useRaw")) G::useRaw = settings->value("useRaw").toBool();
+    if (settings->contains("useRcdDemosaic")) G::useRcdDemosaic = settings->value("useRcdDemosaic").toBool();
+    if (settings->contains("useRawInLoupe")) G::useRawInLoupe = settings->value("useRawInLoupe").toBool();
     if (settings->contains("decodeRawEngine")) {
         /* Sticky RAW decode engine (Develop "Demosaic" combo). appleDecodeRawEngine is
            macOS-only; off-mac the decode callers fall back to winnow anyway, but
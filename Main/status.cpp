@@ -455,7 +455,7 @@ void MW::updateImageCachingThreadRunStatus(bool isRunning, bool showCacheLabel)
     else {
         if (G::isTest) {
             int ms = testTime.elapsed();
-            int n = icd->imCache.count();
+            int n = icd->count();
             if (n)
             qDebug() << "MW::updateImageCachingThreadRunStatus"
                     << "Total time to fill cache =" << ms
@@ -1,6 +1,7 @@
 #include "preferences.h"
 #include "Main/mainwindow.h"
 #include "Main/global.h"
+#include "Cache/previewdiskcache.h"
 #include <QDebug>
 
 // this works because propertyeditor and preferences are friend classes of MW
@@ -170,6 +171,22 @@ void Preferences::itemChange(QModelIndex idx)
         mw->settings->setValue("colorManage", G::colorManage);
     }
 
+    if (source == "rcdDemosaic") {
+        G::useRcdDemosaic = v.toBool();
+        /* no rebuild: applies from the next raw decode (RawFormat::Decode) */
+        mw->settings->setValue("useRcdDemosaic", G::useRcdDemosaic);
+    }
+
+    if (source == "rawInLoupe") {
+        G::useRawInLoupe = v.toBool();
+        /* in Preview this switches the loupe's source, so rebuild the image cache the way
+           the Decode Raw button does, leaving G::useRaw as the mode set it. Develop always
+           decodes the sensor data, so it is unchanged there. */
+        if (G::operationMode != G::OperationMode::Develop)
+            mw->toggleUseRaw(G::useRaw ? MW::on : MW::off);
+        mw->settings->setValue("useRawInLoupe", G::useRawInLoupe);
+    }
+
     if (source == "hideCachingProgressBars") {
         /* Single gate for ImageCache + MetaRead progress. Checkbox is "hide", so
            G::showCacheProgress is the inverse. ImageCache and MetaRead read
@@ -188,6 +205,25 @@ void Preferences::itemChange(QModelIndex idx)
         mw->settings->setValue("useJitIconCache", G::useJitIconCache);
     }
 
+    if (source == "tieredImageCache") {
+        G::useTieredImageCache = v.toBool();
+        /* no rebuild: cached entries stay valid at either tier and the next decodes
+           follow the new setting (ImageCache::decodeEdge) */
+        mw->settings->setValue("useTieredImageCache", G::useTieredImageCache);
+    }
+
+    if (source == "diskPreviewCache") {
+        G::useDiskPreviewCache = v.toBool();
+        PreviewDiskCache::instance().setEnabled(G::useDiskPreviewCache);
+        mw->settings->setValue("useDiskPreviewCache", G::useDiskPreviewCache);
+    }
+
+    if (source == "diskPreviewCacheMB") {
+        G::diskPreviewCacheMB = v.toInt();
+        PreviewDiskCache::instance().setMaxBytes(qint64(G::diskPreviewCacheMB) << 20);
+        mw->settings->setValue("diskPreviewCacheMB", G::diskPreviewCacheMB);
+    }
+
     if (source == "progressWidthSlider") {
         mw->cacheBarProgressWidth = v.toInt();
         mw->updateProgressBarWidth();
@@ -1120,6 +1156,37 @@ void Preferences::addProductivity()
     i.type = "bool";
     addItem(i);
 
+    // Winnow raw engine demosaic algorithm
+    i.name = "rcdDemosaic";
+    i.parentName = "ProductivityHeader";
+    i.captionText = "High quality raw demosaic";
+    i.tooltip = "When Winnow decodes the raw sensor data, rebuild colour with the\n"
+                "edge-aware RCD algorithm (Markesteijn for Fujifilm X-Trans sensors)\n"
+                "instead of bilinear interpolation.\n"
+                "Sharper edges without zipper artifacts, slightly slower.";
+    i.hasValue = true;
+    i.captionIsEditable = false;
+    i.value = G::useRcdDemosaic;
+    i.key = "rcdDemosaic";
+    i.delegateType = DT_Checkbox;
+    i.type = "bool";
+    addItem(i);
+
+    // Decode Raw in the loupe: half-size sensor decode until zoomed
+    i.name = "rawInLoupe";
+    i.parentName = "ProductivityHeader";
+    i.captionText = "Decode raw in loupe";
+    i.tooltip = "In Preview mode, show raw files decoded from the sensor data instead\n"
+                "of the embedded preview. Fit to window they are decoded at half size;\n"
+                "zooming in decodes the full resolution. Develop always decodes raw.";
+    i.hasValue = true;
+    i.captionIsEditable = false;
+    i.value = G::useRawInLoupe;
+    i.key = "rawInLoupe";
+    i.delegateType = DT_Checkbox;
+    i.type = "bool";
+    addItem(i);
+
     // Show caching activity
     i.name = "hideCachingProgressBars";
     i.parentName = "ProductivityHeader";
@@ -1232,6 +1299,54 @@ void Preferences::addProductivity()
                 ;
     addItem(i);
 
+    // Cache non-current images at loupe resolution
+    i.name = "tieredImageCache";
+    i.parentName = "ProductivityHeader";
+    i.captionText = "Cache at screen resolution";
+    i.tooltip = "Cache images other than the current one at the size of the\n"
+                "loupe instead of full resolution, so the same cache size holds\n"
+                "many more images.  The full resolution image is loaded for the\n"
+                "current image when you zoom in.";
+    i.hasValue = true;
+    i.captionIsEditable = false;
+    i.value = G::useTieredImageCache;
+    i.key = "tieredImageCache";
+    i.delegateType = DT_Checkbox;
+    i.type = "bool";
+    addItem(i);
+
+    // Persistent preview cache on disk
+    i.name = "diskPreviewCache";
+    i.parentName = "ProductivityHeader";
+    i.captionText = "Cache previews on disk";
+    i.tooltip = "Keep a display size copy of every decoded image on disk so\n"
+                "revisiting a folder shows images at disk speed instead of\n"
+                "decoding them again (RAW files benefit most).";
+    i.hasValue = true;
+    i.captionIsEditable = false;
+    i.value = G::useDiskPreviewCache;
+    i.key = "diskPreviewCache";
+    i.delegateType = DT_Checkbox;
+    i.type = "bool";
+    addItem(i);
+
+    // Size cap for the preview cache on disk
+    i.name = "diskPreviewCacheMB";
+    i.parentName = "ProductivityHeader";
+    i.captionText = "Disk preview cache (MB)";
+    i.tooltip = "Maximum disk space used by cached previews.  The least\n"
+                "recently viewed previews are deleted first.";
+    i.hasValue = true;
+    i.captionIsEditable = false;
+    i.value = G::diskPreviewCacheMB;
+    i.key = "diskPreviewCacheMB";
+    i.delegateType = DT_Spinbox;
+    i.type = "int";
+    i.min = 100;
+    i.max = 200000;
+    i.fixedWidth = 60;
+    addItem(i);
+
     // // Available memory for caching
     // i.name = "availableMBToCache";
     // i.parentName = "ProductivityHeader";
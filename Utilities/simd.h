@@ -0,0 +1,124 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#pragma once
+#include <atomic>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WINNOW_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WINNOW_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*
+    Runtime SIMD dispatch for the per-pixel kernels (RawKernels, the OutputTransform pack).
+
+    x86 builds target the baseline ISA, so SSE4.1 and AVX2 code is compiled per function
+    (WINNOW_TARGET_SSE41 / WINNOW_TARGET_AVX2) and chosen at run time from level(). NEON
+    is part of the arm64 baseline (Apple silicon), so there it is always on. Every kernel
+    keeps its scalar loop as the reference: the SIMD paths are required to be bit-exact
+    with it (tst_rawkernels, tst_outputtransform), which they can only be if the compiler
+    does not fuse a*b+c into an FMA in one path and not the other -- so a kernel .cpp
+    starts with WINNOW_SIMD_NO_FP_CONTRACT.
+
+    The half-float conversions (Develop/halfimage.h) use F16C at the AVX2 level: every CPU
+    that shipped AVX2 also has F16C, so it is not detected separately.
+
+    setLevel() forces a level (tests compare each supported level against Scalar); it
+    refuses one the CPU cannot run.
+*/
+#if defined(__clang__)
+#define WINNOW_SIMD_NO_FP_CONTRACT _Pragma("clang fp contract(off)")
+#elif defined(__GNUC__)
+#define WINNOW_SIMD_NO_FP_CONTRACT _Pragma("GCC optimize(\"fp-contract=off\")")
+#else
+#define WINNOW_SIMD_NO_FP_CONTRACT
+#endif
+
+#if defined(WINNOW_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define WINNOW_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define WINNOW_TARGET_AVX2  __attribute__((target("avx2")))
+#define WINNOW_TARGET_F16C  __attribute__((target("avx2,f16c")))
+#else
+#define WINNOW_TARGET_SSE41
+#define WINNOW_TARGET_AVX2
+#define WINNOW_TARGET_F16C
+#endif
+
+namespace Winnow::Simd {
+
+enum class Level { Scalar, SSE41, AVX2, NEON };
+
+inline const char *name(Level l)
+{
+    switch (l) {
+    case Level::SSE41: return "SSE4.1";
+    case Level::AVX2:  return "AVX2";
+    case Level::NEON:  return "NEON";
+    case Level::Scalar: break;
+    }
+    return "scalar";
+}
+
+inline bool supported(Level l)
+{
+    if (l == Level::Scalar) return true;
+#if defined(WINNOW_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 1);
+    const bool sse41 = (r[2] & (1 << 19)) != 0;
+    const bool osAvx = (r[2] & (1 << 27)) && (r[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(r, 7, 0);
+    const bool avx2 = osAvx && (r[1] & (1 << 5)) != 0;
+#else
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (l == Level::SSE41) return sse41;
+    if (l == Level::AVX2) return avx2;
+    return false;
+#elif defined(WINNOW_SIMD_NEON)
+    return l == Level::NEON;
+#else
+    return false;
+#endif
+}
+
+inline Level detected()
+{
+    static const Level best = [] {
+        for (Level l : {Level::AVX2, Level::SSE41, Level::NEON})
+            if (supported(l)) return l;
+        return Level::Scalar;
+    }();
+    return best;
+}
+
+inline std::atomic<int> forcedLevel{-1};
+
+// The level kernels should run at: detected(), unless a test forced one.
+inline Level level()
+{
+    const int f = forcedLevel.load(std::memory_order_relaxed);
+    return f < 0 ? detected() : Level(f);
+}
+
+inline bool setLevel(Level l)
+{
+    if (!supported(l)) return false;
+    forcedLevel.store(int(l), std::memory_order_relaxed);
+    return true;
+}
+
+inline void resetLevel() { forcedLevel.store(-1, std::memory_order_relaxed); }
+
+} // namespace Winnow::Simd
+
+#endif // SIMD_H
@@ -136,8 +136,13 @@ bool CompareView::loadImage(QModelIndex idx, QString fPath)
 
     // load the image from the image cache if available
     QImage image;
-    if (icd->contains(fPath)) {
-        pmItem->setPixmap(QPixmap::fromImage(icd->imCache.value(fPath)));
+    QSize fullSize;
+    /* A reduced cache entry (ImageCacheData resolution tiers) is a miss here: compare
+       zooms, pans and aligns the images in their own pixel coordinates, at 100% too, so
+       it needs the full resolution decode. */
+    if (icd->find(fPath, image, &fullSize) && !fullSize.isValid()) {
+        // cached images are already raster-native (ImageCacheData::toDisplayFormat)
+        pmItem->setPixmap(QPixmap::fromImage(image, Qt::NoOpaqueDetection));
         isLoaded = true;
     }
     else {
@@ -232,6 +232,12 @@ ImageView::ImageView(QWidget *parent,
     pmItem->setOpacity(1.0);
     scene->addItem(pmItem);
 
+    roiItem = new QGraphicsPixmapItem(pmItem);
+    roiItem->setTransformationMode(Qt::SmoothTransformation);
+    roiItem->setVisible(false);
+    roiWatcher = new QFutureWatcher<RegionDecoder::Result>(this);
+    connect(roiWatcher, &QFutureWatcherBase::finished, this, &ImageView::regionDecoded);
+
     setAcceptDrops(true);
     pmItem->setAcceptDrops(true);
     setAttribute(Qt::WA_TranslucentBackground);
@@ -412,6 +418,7 @@ bool ImageView::loadImage(QString fPath, bool replace, QString src)
         isLoaded = pixmap->load(fPath, displayPixmap, srcFun);
 
         if (isLoaded) {
+            clearRegion();
             pmItem->setPixmap(displayPixmap);
             isBusy = false;
         }
@@ -438,12 +445,32 @@ bool ImageView::loadImage(QString fPath, bool replace, QString src)
         return false;
     }
 
-    if (icd->contains(fPath)) {
-        QImage image; // confirm the cached image is in the image cache
+    QImage image;
+    QSize fullSize;
+    if (icd->find(fPath, image, &fullSize)) {
         if (isDebug)
             qDebug() << srcFun + "  row =" << sfRow << fPath;
 
-        pmItem->setPixmap(QPixmap::fromImage(icd->imCache.value(fPath)));
+        /* A reduced cache entry (ImageCacheData resolution tiers) is presented at its full
+           size, so zoom, fit and overlays stay in full image coordinates; scale() asks for
+           the full decode if the zoom outgrows it. When that full decode lands for the
+           image already showing, swap the pixels in place: no refit, no pan reset. */
+        const QSize shown = fullSize.isValid() ? fullSize : image.size();
+        const bool inPlace = isCurrent && replace && pmItem->isScaled()
+                             && shown == pmItem->displaySize();
+        /* Zero-copy: the decoder left the image in the raster-native format, so this
+           QPixmap wraps the cached buffer (NoOpaqueDetection skips the alpha scan). */
+        const QPixmap pm = QPixmap::fromImage(image, Qt::NoOpaqueDetection);
+        icd->noteViewHandoff(pm.toImage().constBits() == image.constBits());
+        pmItem->setTransformationMode(Qt::SmoothTransformation);
+        pmItem->setPixmapScaled(pm, shown);
+        clearRegion();      // the full decode has landed, or this is another image
+        if (inPlace) {
+            isBusy = false;
+            isLoadingImage = false;
+            return true;
+        }
+        fullResRequested = false;
         isLoaded = true;
         if (isDebug)
             qDebug() << srcFun
@@ -526,6 +553,7 @@ bool ImageView::loadImage(QString fPath, bool replace, QString src)
         if (isDebug)
             qDebug() << "ImageView::loadImage isLoaded = false";
         // set null pixmap
+        clearRegion();
         QPixmap nullPm;
         pmItem->setPixmap(nullPm);
         /*
@@ -566,6 +594,7 @@ bool ImageView::loadImageInterim(QString fPath)
     developCaptureLocked = true;
 
     currentImagePath = fPath;
+    clearRegion();
     pmItem->setPixmap(QPixmap::fromImage(preview));
     pmItem->setVisible(true);
     setSceneRect(scene->itemsBoundingRect());
@@ -662,6 +691,7 @@ void ImageView::setDevelopPreview(const QImage &image, QSize displaySize)
     pmItem->setTransformationMode(shown == image.size() ? Qt::SmoothTransformation
                                                         : Qt::FastTransformation);
     pmItem->setPixmapScaled(QPixmap::fromImage(image), shown);
+    clearRegion();
     pmItem->setVisible(true);
     if (sizeChanged) {
         imAspect = shown.height() ? double(shown.width()) / shown.height() : 1.0;
@@ -3245,6 +3275,7 @@ void ImageView::clear()
     if (G::isLogger) G::log("ImageView::clear");
     infoText = "";
     infoOverlay->setText("");
+    clearRegion();
     QPixmap nullPm;
     pmItem->setPixmap(nullPm);
     pmItem->setVisible(false);
@@ -3304,6 +3335,7 @@ void ImageView::scale(bool isNewImage)
     }
 
     emit zoomChange(zoom, "ImageView::scale");
+    requestFullResolutionIfZoomed();
 
     // The rest of your functional logic remains identical
     isScrollable = (zoom > zoomFit);
@@ -3311,6 +3343,7 @@ void ImageView::scale(bool isNewImage)
 
     /* Keep a pending Develop capture in step with a user zoom on the interim preview. */
     refreshDevelopCapture();
+    if (G::operationMode == G::OperationMode::Develop) emit developViewChanged();
 
     // Maintain predictive focus and panning logic
     int i = dm->currentSfRow;
@@ -3337,6 +3370,158 @@ void ImageView::scale(bool isNewImage)
     //*/
 }
 
+void ImageView::requestFullResolutionIfZoomed()
+{
+/*
+    The loupe is showing a reduced cache entry (pmItem stretched to the full image size)
+    and the zoom now asks for more device pixels per image pixel than the reduced copy
+    holds: ask ImageCache for the full decode, once per image. Preview mode only --
+    Develop always caches full resolution, and its scaled pixmaps are render proxies.
+*/
+    if (fullResRequested) { requestRegionDecode(); return; }
+    if (!pmItem->isScaled() || currentImagePath.isEmpty()) return;
+    if (G::operationMode != G::OperationMode::Preview) return;
+    const QSize disp = pmItem->displaySize();
+    if (disp.isEmpty()) return;
+    const qreal held = qreal(pmItem->pixmap().width()) / disp.width();
+    if (zoom <= held * 1.05) return;    // a little upscaling is invisible
+    fullResRequested = true;
+    emit needFullResolution(currentImagePath);
+    requestRegionDecode();
+}
+
+void ImageView::requestRegionDecode()
+{
+/*
+    The full decode is on its way but, for a large file, seconds off. Decode the part of
+    the image the viewport shows, grown by half its size each way so a pan does not leave
+    it at once, at the zoom's scale (1:1 at 100% and above), on the global thread pool.
+    regionDecoded lays it over the stretched reduced pixmap.
+
+    Called from scale() and scrollChange, so a zoom or pan that leaves the region held
+    fetches another. One decode runs at a time; a view change while it runs is picked up
+    when it finishes.
+*/
+    if (!fullResRequested || roiUnavailable || !pmItem->isScaled()) return;
+    if (currentImagePath.isEmpty() || G::isSlideShow || G::isEmbellish) return;
+    if (G::operationMode != G::OperationMode::Preview) return;
+
+    const QSize disp = pmItem->displaySize();
+    const QRect image(QPoint(0, 0), disp);
+    const QRect visible =
+        pmItem->mapFromScene(mapToScene(viewport()->rect())).boundingRect().toAlignedRect()
+        & image;
+    if (visible.isEmpty()) return;
+    const qreal scale = zoom >= 0.95 ? 1.0 : zoom;
+    if (roiItem->isVisible() && roiRect.contains(visible) && roiScale >= scale * 0.95) return;
+    if (roiPending) { roiAgain = true; return; }
+
+    const int sfRow = dm->proxyRowFromPath(currentImagePath, "ImageView::requestRegionDecode");
+    RegionDecoder::Request req = RegionDecoder::request(dm, metadata, sfRow, disp);
+    if (req.source == RegionDecoder::None || req.fPath != currentImagePath) {
+        roiUnavailable = true;
+        return;
+    }
+    const int mx = visible.width() / 2;
+    const int my = visible.height() / 2;
+    req.rect = visible.adjusted(-mx, -my, mx, my) & image;
+    req.scale = scale;
+
+    if (G::isLogger) G::log("ImageView::requestRegionDecode", currentImagePath);
+    roiPending = true;
+    roiAgain = false;
+    roiPendingGeneration = roiGeneration;
+    roiPendingScale = scale;
+    roiWatcher->setFuture(QtConcurrent::run([req]() { return RegionDecoder::decode(req); }));
+}
+
+void ImageView::regionDecoded()
+{
+    roiPending = false;
+    const RegionDecoder::Result r = roiWatcher->result();
+    if (roiPendingGeneration != roiGeneration) {
+        // decoded for an image, or pixels, no longer showing
+        if (roiAgain) { roiAgain = false; requestRegionDecode(); }
+        return;
+    }
+    if (!r.ok || r.image.isNull() || r.rect.isEmpty()) {
+        roiUnavailable = true;          // the loupe waits for the full decode, as before
+        return;
+    }
+    roiItem->setPixmap(QPixmap::fromImage(r.image, Qt::NoOpaqueDetection));
+    roiItem->setPos(r.rect.topLeft());
+    roiItem->setTransform(QTransform::fromScale(qreal(r.rect.width()) / r.image.width(),
+                                                qreal(r.rect.height()) / r.image.height()));
+    roiItem->setVisible(true);
+    roiRect = r.rect;
+    roiScale = roiPendingScale;
+    if (roiAgain) { roiAgain = false; requestRegionDecode(); }
+}
+
+QRect ImageView::developVisibleRect() const
+{
+    const QRect image(QPoint(0, 0), pmItem->displaySize());
+    return pmItem->mapFromScene(mapToScene(viewport()->rect())).boundingRect().toAlignedRect()
+           & image;
+}
+
+void ImageView::addDevelopTile(const QImage &image, const QRect &rect, int generation)
+{
+/*
+    Lay a full-resolution piece of the developed image over the proxy pmItem holds (see
+    MW::renderDevelopViewport). Dropped if pmItem's pixels changed since it was asked for.
+    The tiles are kept while the view pans so panning back costs nothing, up to
+    kDevelopTileBudget pixels; past that the ones the view has left go first, oldest
+    first. The region they cover is rebuilt from what is left.
+*/
+    if (generation != roiGeneration || image.isNull() || rect.isEmpty()) return;
+    if (image.size() != rect.size()) return;
+    auto *item = new QGraphicsPixmapItem(QPixmap::fromImage(image, Qt::NoOpaqueDetection),
+                                         pmItem);
+    item->setTransformationMode(Qt::SmoothTransformation);     // below 1:1 it is reduced
+    item->setPos(rect.topLeft());
+    devTiles.append(item);
+    devTileRegion += rect;
+
+    qint64 held = 0;
+    for (const QGraphicsPixmapItem *t : std::as_const(devTiles))
+        held += qint64(t->pixmap().width()) * t->pixmap().height();
+    if (held <= kDevelopTileBudget) return;
+    const QRect visible = developVisibleRect();
+    for (int i = 0; i < devTiles.size() - 1 && held > kDevelopTileBudget; ) {
+        QGraphicsPixmapItem *t = devTiles.at(i);
+        const QRect r(t->pos().toPoint(), t->pixmap().size());
+        if (r.intersects(visible)) { ++i; continue; }
+        held -= qint64(r.width()) * r.height();
+        devTiles.removeAt(i);
+        delete t;
+    }
+    devTileRegion = QRegion();
+    for (const QGraphicsPixmapItem *t : std::as_const(devTiles))
+        devTileRegion += QRect(t->pos().toPoint(), t->pixmap().size());
+}
+
+void ImageView::clearRegion()
+{
+/*
+    pmItem's pixels are changing: drop the region overlay and any decode in flight, and
+    the Develop viewport tiles. Called wherever pmItem gets a new pixmap, including the
+    full decode landing in place.
+*/
+    ++roiGeneration;
+    qDeleteAll(devTiles);
+    devTiles.clear();
+    devTileRegion = QRegion();
+    roiAgain = false;
+    roiUnavailable = false;
+    roiRect = QRect();
+    roiScale = 0;
+    if (roiItem->isVisible() || !roiItem->pixmap().isNull()) {
+        roiItem->setVisible(false);
+        roiItem->setPixmap(QPixmap());
+    }
+}
+
 bool ImageView::sceneBiggerThanView()
 {
     if (G::isLogger) G::log("ImageView::sceneBiggerThanView");
@@ -3522,6 +3707,10 @@ void ImageView::resizeEvent(QResizeEvent *event)
     // Call the base class implementation
     QGraphicsView::resizeEvent(event);
 
+    // loupe size for the image cache resolution tiers (ImageCache::decodeEdge)
+    const QSize vp = viewport()->size() * G::actDevicePixelRatio;
+    G::loupeEdgePx.store(std::max(vp.width(), vp.height()), std::memory_order_relaxed);
+
     // Recalculate the factor required to fit the image in the new window size
     zoomFit = getFitScaleFactor(rect(), scene->itemsBoundingRect());
 
@@ -3898,6 +4087,7 @@ void ImageView::rotateImage(int degrees)
     QPixmap pm = pmItem->pixmap();
     QTransform trans;
     trans.rotate(degrees);
+    clearRegion();
     pmItem->setPixmap(pm.transformed(trans, Qt::SmoothTransformation));
 
     // reset the scene
@@ -4188,6 +4378,8 @@ void ImageView::scrollChange(int /*value*/)
         ;//*/
     if (!isLoadingImage) {
         refreshDevelopCapture();    // a pan while the Develop decode is in flight
+        requestRegionDecode();      // a pan while the full decode is in flight
+        if (G::operationMode == G::OperationMode::Develop) emit developViewChanged();
         bool adjustCenter = true;
         bool refresh = true;
         showNormalizedViewport(adjustCenter, refresh, "ImageView::scrollChange");
@@ -5475,19 +5667,29 @@ void ImageView::copyImage()
     if (G::isLogger) G::log("ImageView::copyImage");
     qDebug() << "ImageView::copyImage";
     QPixmap pm = pmItem->pixmap();
+    /* In Preview a scaled item holds a reduced cache entry (ImageCacheData resolution
+       tiers): stretching it would copy upscaled pixels, so take the full resolution entry
+       or decode the file. */
+    const bool reduced = G::operationMode == G::OperationMode::Preview && pmItem->isScaled();
     /* Mid-develop-drag the item holds a screen-resolution proxy. The clipboard must get
        the image at its real size, so stretch it back -- the same thing the render path
        did inline before ScaledPixmapItem made the upscale unnecessary on screen. */
-    if (!pm.isNull() && pmItem->isScaled())
+    if (!pm.isNull() && !reduced && pmItem->isScaled())
         pm = pm.scaled(pmItem->displaySize(), Qt::IgnoreAspectRatio,
                        Qt::SmoothTransformation);
-    if (pm.isNull()) {
-       if (icd->contains(dm->currentFilePath)) {
-            pm = QPixmap::fromImage(icd->imCache.value(dm->currentFilePath));
-        }
-        else {
+    if (pm.isNull() || reduced) {
+        pm = QPixmap();
+        QString fPath = dm->currentFilePath;
+        QImage image;
+        QSize fullSize;
+        if (icd->find(fPath, image, &fullSize) && !fullSize.isValid())
+            pm = QPixmap::fromImage(image);
+        else if (!fPath.isEmpty())
+            pixmap->load(fPath, pm, "ImageView::copyImage");
+        if (pm.isNull()) {
             QString msg = "Could not copy the current image to the clipboard";
             G::popup->showPopup(msg, 1500);
+            return;
         }
     }
     QApplication::clipboard()->setPixmap(pm, QClipboard::Clipboard);
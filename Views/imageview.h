@@ -11,6 +11,7 @@
 #include "Datamodel/datamodel.h"
 #include "Datamodel/selection.h"
 #include "Cache/imagecache.h"
+#include "Cache/regiondecoder.h"
 #include "Views/iconview.h"
 #include "Views/infostring.h"
 #include "Views/scaledpixmapitem.h"
@@ -147,6 +148,18 @@ public slots:
        that size to the scene while holding the small pixmap, instead of the caller
        upscaling a 50MP QImage per drag tick. Omit it when `image` IS the full render. */
     void setDevelopPreview(const QImage &image, QSize displaySize = QSize());
+    /* Develop VIEWPORT settle (MW::renderDevelopViewport). At 1:1 the settle develops only
+       what the view shows, and lays it over the proxy pmItem holds as full-resolution
+       tiles, in image coordinates. developVisibleRect is the part of the image the view
+       shows; developTileRegion what the tiles already cover. A tile is rendered for one
+       generation of pmItem's pixels (developTileGeneration) and dropped, like the region
+       overlay, by clearRegion -- so a tile that lands after the next drag tick is
+       ignored. */
+    QRect developVisibleRect() const;
+    QSize developDisplaySize() const { return pmItem->displaySize(); }
+    QRegion developTileRegion() const { return devTileRegion; }
+    int developTileGeneration() const { return roiGeneration; }
+    void addDevelopTile(const QImage &image, const QRect &rect, int generation);
     void monitorCursorState();
     void copyImage();
     void panTo(float xPct, float yPct);
@@ -301,6 +314,9 @@ signals:
     void keyPress(QKeyEvent *event);
     void mouseSideKeyPress(int direction);  // logitech mouse NativeGesture event
     void zoomChange(qreal zoomValue, QString src);
+    /* The zoom outgrew the reduced cache entry being shown: ImageCache should decode
+       the full resolution image (ImageCache::requestFullResolution). */
+    void needFullResolution(QString fPath);
     void loupeRect(QSizeF vpSizeN, qreal vpA, QPointF vpCntr, bool refresh);
     void showLoupeRect(bool isVisible);
 
@@ -360,6 +376,9 @@ signals:
     /* A spot pin was clicked (remove that spot), or Escape disarmed the tool. */
     void spotRemoveRequested(int index);
     void spotToolExited();
+    /* Develop: a zoom or pan moved the view, so the viewport settle may need more tiles
+       (MW::onDevelopViewChanged). */
+    void developViewChanged();
 
 private slots:
     void wheelStopped();
@@ -392,6 +411,28 @@ protected:
 private:
     void noJpgAvailable();
     void scale(bool isNewImage = false);
+    void requestFullResolutionIfZoomed();
+    bool fullResRequested = false;      // needFullResolution sent for the current image
+    /* Region decode (Cache/regiondecoder.h): while that full decode is in flight, the
+       visible part is decoded at the zoom's scale and laid over pmItem as roiItem. */
+    void requestRegionDecode();
+    void regionDecoded();
+    void clearRegion();
+    QGraphicsPixmapItem *roiItem;       // child of pmItem, so in image coordinates
+    QFutureWatcher<RegionDecoder::Result> *roiWatcher;
+    QRect roiRect;                      // image coordinates roiItem covers
+    qreal roiScale = 0;                 // its pixels per image pixel
+    int roiGeneration = 0;              // bumped by clearRegion, stale results are dropped
+    int roiPendingGeneration = -1;
+    qreal roiPendingScale = 0;
+    bool roiPending = false;            // a decode is running
+    bool roiAgain = false;              // the view moved while it ran
+    bool roiUnavailable = false;        // no region path, or it failed, for this image
+    /* Develop viewport tiles (addDevelopTile), children of pmItem like roiItem. Past
+       kDevelopTileBudget pixels the tiles the view has left are dropped, oldest first. */
+    static constexpr qint64 kDevelopTileBudget = 24'000'000;
+    QList<QGraphicsPixmapItem *> devTiles;
+    QRegion devTileRegion;
     qreal getZoom();
 
     QPointF getScrollPct();
@@ -0,0 +1,37 @@
+/*
+    Opt-in benchmark slots.
+
+    A timing slot prints numbers and asserts nothing, and most of them develop, decode or
+    demosaic a full-size frame several times over, so ctest skips them. One runs when it is
+    named on the command line (`tst_demosaic fullFrameTiming`, or `slot:tag`), or for every
+    test binary when WINNOW_BENCH is set in the environment:
+
+        WINNOW_BENCH=1 ctest -L unit --output-on-failure -V
+
+    The first statement of a timing slot is WINNOW_BENCHMARK_SLOT();.
+*/
+#pragma once
+
+#include <QtTest>
+#include <QCoreApplication>
+#include <QStringList>
+
+namespace WinnowTest {
+
+inline bool benchmarkRequested()
+{
+    if (qEnvironmentVariableIsSet("WINNOW_BENCH")) return true;
+    const QString slot = QString::fromLatin1(QTest::currentTestFunction());
+    const QStringList args = QCoreApplication::arguments();
+    for (int i = 1; i < args.size(); ++i)
+        if (args.at(i) == slot || args.at(i).startsWith(slot + ':')) return true;
+    return false;
+}
+
+} // namespace WinnowTest
+
+#define WINNOW_BENCHMARK_SLOT()                                                         \
+    do {                                                                                \
+        if (!WinnowTest::benchmarkRequested())                                          \
+            QSKIP("benchmark: name the slot on the command line or set WINNOW_BENCH");  \
+    } while (false)
@@ -0,0 +1,274 @@
+/*
+    ImageCacheData -- the sharded decoded-image store.
+
+    Correctness first: byte accounting has to survive replace / take / rename / removeIf
+    and concurrent writers, because ImageCache sizes its target range from sizeBytes()
+    and a drift shows up only as a cache that silently stops filling (the health check
+    in ImageCache::reportHealthChecks reports it, this pins it).
+
+    insertLookupScaling is the microbenchmark the stripe split was justified by: N
+    threads each insert their own keys and then hammer value()/contains() on the whole
+    key set. It prints ops/s per thread count; nothing is asserted about the rate (CI
+    boxes are too noisy for that), only that every thread saw every key. Opt-in: ctest
+    skips it (benchmark.h).
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <thread>
+#include <vector>
+#include "Cache/cachedata.h"
+#include "benchmark.h"
+
+namespace {
+
+QImage makeImage(int w, int h)
+{
+    QImage im(w, h, QImage::Format_RGB888);
+    im.fill(Qt::gray);
+    return im;
+}
+
+QString keyFor(int thread, int i)
+{
+    return QString("/Volumes/Card/DCIM/T%1/IMG_%2.CR3").arg(thread).arg(i, 5, 10, QChar('0'));
+}
+
+} // namespace
+
+class TestCacheData : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertContainsRemove();
+    void replaceKeepsByteCount();
+    void renameMovesEntry();
+    void removeIfReturnsKeys();
+    void budgetIsCheckedNotEnforced();
+    void reducedTierRoundTrip();
+    void displayFormatIsZeroCopy();
+    void concurrentWritersKeepAccounting();
+    void insertLookupScaling();
+};
+
+void TestCacheData::insertContainsRemove()
+{
+    ImageCacheData icd(nullptr);
+    const QImage im = makeImage(64, 32);
+    QVERIFY(!icd.contains("a"));
+    icd.insert("a", im);
+    QVERIFY(icd.contains("a"));
+    QCOMPARE(icd.count(), 1);
+    QCOMPARE(icd.sizeBytes(), quint64(im.sizeInBytes()));
+    QCOMPARE(icd.value("a").size(), im.size());
+    QVERIFY(icd.value("missing").isNull());
+
+    icd.remove("a");
+    QVERIFY(!icd.contains("a"));
+    QCOMPARE(icd.count(), 0);
+    QCOMPARE(icd.sizeBytes(), quint64(0));
+    icd.remove("a");                            // absent: no underflow
+    QCOMPARE(icd.sizeBytes(), quint64(0));
+}
+
+void TestCacheData::replaceKeepsByteCount()
+{
+    ImageCacheData icd(nullptr);
+    icd.insert("a", makeImage(64, 64));
+    const QImage big = makeImage(128, 128);
+    icd.insert("a", big);
+    QCOMPARE(icd.count(), 1);
+    QCOMPARE(icd.sizeBytes(), quint64(big.sizeInBytes()));
+}
+
+void TestCacheData::renameMovesEntry()
+{
+    ImageCacheData icd(nullptr);
+    const QImage im = makeImage(40, 30);
+    icd.insert("old", im);
+    QVERIFY(icd.rename("old", "new"));
+    QVERIFY(!icd.contains("old"));
+    QVERIFY(icd.contains("new"));
+    QCOMPARE(icd.sizeBytes(), quint64(im.sizeInBytes()));
+    QVERIFY(!icd.rename("old", "other"));
+}
+
+void TestCacheData::removeIfReturnsKeys()
+{
+    ImageCacheData icd(nullptr);
+    for (int i = 0; i < 100; ++i) icd.insert(keyFor(0, i), makeImage(8, 8));
+    const QStringList removed = icd.removeIf([](const QString &k) {
+        return k.endsWith("0.CR3");             // every tenth key
+    });
+    QCOMPARE(int(removed.size()), 10);
+    QCOMPARE(icd.count(), 90);
+    for (const QString &k : removed) QVERIFY(!icd.contains(k));
+    QCOMPARE(icd.sizeBytes(), quint64(90) * quint64(makeImage(8, 8).sizeInBytes()));
+
+    icd.clear();
+    QVERIFY(icd.isEmpty());
+    QCOMPARE(icd.sizeBytes(), quint64(0));
+    QVERIFY(!icd.contains(keyFor(0, 1)));
+}
+
+void TestCacheData::budgetIsCheckedNotEnforced()
+{
+    // only ImageCache removes entries (trimOutsideTargetRange); the store counts overruns
+    ImageCacheData icd(nullptr);
+    const QImage im = makeImage(100, 100);
+    const quint64 one = quint64(im.sizeInBytes());
+    icd.setMaxBytes(one * 3);
+    icd.insert("a", im);
+    icd.insert("b", im);
+    icd.insert("c", im);
+    QVERIFY(!icd.overBudget());
+    QCOMPARE(icd.overBudgetCount(), quint64(0));
+
+    icd.insert("d", im);
+    QCOMPARE(icd.count(), 4);
+    for (const char *k : {"a", "b", "c", "d"}) QVERIFY(icd.contains(k));
+    QVERIFY(icd.overBudget());
+    QCOMPARE(icd.overBudgetCount(), quint64(1));
+
+    icd.remove("a");
+    QVERIFY(!icd.overBudget());
+    icd.setMaxBytes(0);                         // unlimited
+    icd.insert("huge", makeImage(400, 400));
+    QVERIFY(!icd.overBudget());
+    QCOMPARE(icd.overBudgetCount(), quint64(1));
+}
+
+void TestCacheData::reducedTierRoundTrip()
+{
+    ImageCacheData icd(nullptr);
+    const QImage full = makeImage(400, 300);
+    const QImage reduced = makeImage(100, 75);
+
+    icd.insert("a", reduced, full.size());
+    QVERIFY(icd.isReduced("a"));
+    QImage im;
+    QSize fullSize;
+    QVERIFY(icd.find("a", im, &fullSize));
+    QCOMPARE(im.size(), reduced.size());
+    QCOMPARE(fullSize, full.size());
+
+    // rename carries the tier
+    QVERIFY(icd.rename("a", "b"));
+    QVERIFY(icd.isReduced("b"));
+
+    // upgrade to full resolution clears it and re-accounts the bytes
+    icd.insert("b", full);
+    QVERIFY(!icd.isReduced("b"));
+    QCOMPARE(icd.sizeBytes(), quint64(full.sizeInBytes()));
+
+    // demote only while the entry still holds the image it was computed from
+    const qint64 stale = reduced.cacheKey();
+    QVERIFY(!icd.replaceIfUnchanged("b", stale, reduced, full.size()));
+    QVERIFY(icd.replaceIfUnchanged("b", icd.value("b").cacheKey(), reduced, full.size()));
+    QVERIFY(icd.isReduced("b"));
+    QCOMPARE(icd.sizeBytes(), quint64(reduced.sizeInBytes()));
+    QVERIFY(!icd.replaceIfUnchanged("missing", 0, reduced, full.size()));
+}
+
+void TestCacheData::displayFormatIsZeroCopy()
+{
+    // ARGB32 from an opaque source (the ICC transform's output) is relabelled, not converted
+    QImage opaque(64, 48, QImage::Format_ARGB32);
+    opaque.fill(qRgba(10, 20, 30, 255));
+    const uchar *bits = opaque.constBits();
+    ImageCacheData::toDisplayFormat(opaque, true);
+    QCOMPARE(opaque.format(), QImage::Format_RGB32);
+    QCOMPARE(opaque.constBits(), bits);
+
+    QImage translucent(8, 8, QImage::Format_ARGB32);
+    translucent.fill(qRgba(10, 20, 30, 128));
+    ImageCacheData::toDisplayFormat(translucent, false);
+    QCOMPARE(translucent.format(), QImage::Format_ARGB32_Premultiplied);
+
+    // RGB32 (OutputTransform's display format) passes through untouched
+    QImage native(8, 8, QImage::Format_RGB32);
+    native.fill(Qt::red);
+    const uchar *nativeBits = native.constBits();
+    ImageCacheData::toDisplayFormat(native, true);
+    QCOMPARE(native.constBits(), nativeBits);
+
+    QImage packed(8, 8, QImage::Format_RGB888);
+    packed.fill(Qt::red);
+    ImageCacheData::toDisplayFormat(packed, true);
+    QCOMPARE(packed.format(), QImage::Format_RGB32);
+    QCOMPARE(packed.pixel(3, 3), qRgb(255, 0, 0));
+
+    // store round trip hands back the very same buffer
+    ImageCacheData icd(nullptr);
+    icd.insert("a", opaque);
+    QCOMPARE(icd.value("a").constBits(), bits);
+}
+
+void TestCacheData::concurrentWritersKeepAccounting()
+{
+    ImageCacheData icd(nullptr);
+    const QImage im = makeImage(16, 16);
+    const int threads = 8, perThread = 500;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (int i = 0; i < perThread; ++i) icd.insert(keyFor(t, i), im);
+            for (int i = 0; i < perThread; i += 2) icd.remove(keyFor(t, i));
+        });
+    }
+    for (auto &th : pool) th.join();
+
+    QCOMPARE(icd.count(), threads * perThread / 2);
+    quint64 sum = 0;
+    icd.forEach([&sum](const QString &, const QImage &image) { sum += quint64(image.sizeInBytes()); });
+    QCOMPARE(icd.sizeBytes(), sum);
+    QCOMPARE(int(icd.keys().size()), icd.count());
+}
+
+void TestCacheData::insertLookupScaling()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const QImage im = makeImage(16, 16);
+    const int perThread = 2000, lookupsPerKey = 20;
+    const int maxThreads = std::max(1, std::min(16, QThread::idealThreadCount()));
+
+    qInfo().noquote() << "threads     ops/s (insert + lookup)";
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        // keys built up front so the timing is the store, not QString::arg
+        std::vector<QStringList> hits(threads), absent(threads);
+        for (int th = 0; th < threads; ++th) {
+            for (int i = 0; i < perThread; ++i) {
+                hits[th].append(keyFor(th, i));
+                absent[th].append(keyFor(th + threads, i));
+            }
+        }
+
+        ImageCacheData icd(nullptr);
+        std::atomic<int> misses{0};
+        QElapsedTimer t;
+        t.start();
+        std::vector<std::thread> pool;
+        for (int th = 0; th < threads; ++th) {
+            pool.emplace_back([&, th] {
+                for (const QString &k : hits[th]) icd.insert(k, im);
+                for (int r = 0; r < lookupsPerKey; ++r) {
+                    for (int i = 0; i < perThread; ++i) {
+                        if (icd.value(hits[th].at(i)).isNull()) misses.fetch_add(1);
+                        // a miss on another thread's keyspace, the okToDecode shape
+                        icd.contains(absent[th].at(i));
+                    }
+                }
+            });
+        }
+        for (auto &p : pool) p.join();
+        const double sec = std::max<qint64>(1, t.nsecsElapsed()) / 1e9;
+        const double ops = double(threads) * perThread * (1 + 2 * lookupsPerKey);
+        qInfo().noquote() << QString("%1  %2").arg(threads, 7).arg(ops / sec, 16, 'f', 0);
+
+        QCOMPARE(misses.load(), 0);
+        QCOMPARE(icd.count(), threads * perThread);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestCacheData)
+#include "tst_cachedata.moc"
@@ -0,0 +1,156 @@
+/*
+    DecodePriority -- the order ImageCache::nextToCache serves toCache in.
+
+    rankOrder pins the ranking itself. jumpTimeToFirstPixel is the before/after
+    measurement for the scheduler: a small discrete-event model of the decoder pool
+    (fixed decode time, decoders busy mid-decode when the user jumps N rows) timing how
+    long the new current image waits for its pixels when toCache is served
+      - in insertion order with in-flight decodes left to finish (the old nextToCache),
+      - by rank with out-of-range decodes cancelled and, if no decoder is free, the
+        lowest priority one preempted (cancelOutOfRangeDecodes / preemptForCurrent).
+    It prints both per jump size. The live equivalent, from real decodes, is the "time
+    to first pixel" block in the ImageCache diagnostics; run the same folder again with
+    WINNOW_INSERTION_ORDER=1 for the insertion order figures.
+*/
+#include <QtTest>
+#include <algorithm>
+#include <vector>
+#include "Cache/decodepriority.h"
+
+using Winnow::Cache::DecodePriority;
+
+namespace {
+
+constexpr int decoders = 4;
+constexpr int decodeMs = 100;
+constexpr int abortMs = 5;          // a cancelled decode noticing its abort flag
+constexpr int behind = 10;          // target range around the current row
+constexpr int ahead = 20;
+
+// setTargetRange: current, then ahead, then behind, skipping rows queued or cached
+void appendRange(QList<int> &toCache, const QList<int> &cached, int pos)
+{
+    auto add = [&](int row) {
+        if (!toCache.contains(row) && !cached.contains(row)) toCache.append(row);
+    };
+    for (int r = pos; r <= pos + ahead; ++r) add(r);
+    for (int r = pos - 1; r >= pos - behind; --r) add(r);
+}
+
+/* ms from the jump until row start + jump is decoded. Before the jump the user sat on
+   `start`: rows start..start+7 are cached, decoders are mid-way through the next four. */
+int timeToFirstPixel(int jump, bool priority)
+{
+    const int start = 100;
+    const int pos = start + jump;
+    QList<int> cached;
+    for (int r = start - behind; r < start + 8; ++r) cached.append(r);
+    QList<int> toCache;
+    appendRange(toCache, cached, start);
+
+    struct Slot { int row; int freeAt; };
+    std::vector<Slot> pool;
+    for (int i = 0; i < decoders; ++i) {
+        const int row = start + 8 + i;
+        toCache.removeOne(row);
+        pool.push_back({row, decodeMs * (i + 1) / decoders});
+    }
+
+    // the jump: new range queued, rows outside it trimmed
+    appendRange(toCache, cached, pos);
+    toCache.erase(std::remove_if(toCache.begin(), toCache.end(), [&](int r) {
+        return r < pos - behind || r > pos + ahead;
+    }), toCache.end());
+
+    if (priority) {
+        DecodePriority::order(toCache, pos, true);
+        bool anyFree = false;
+        for (Slot &s : pool) {
+            if (s.row < pos - behind || s.row > pos + ahead) {
+                s.freeAt = std::min(s.freeAt, abortMs);
+                s.row = -1;                             // cancelled: result dropped
+                anyFree = true;
+            }
+        }
+        const bool currentInFlight = std::any_of(pool.begin(), pool.end(), [&](const Slot &s) {
+            return s.row == pos;
+        });
+        if (!anyFree && !currentInFlight) {
+            auto worst = std::max_element(pool.begin(), pool.end(), [&](const Slot &a, const Slot &b) {
+                return DecodePriority::rank(a.row, pos, true) < DecodePriority::rank(b.row, pos, true);
+            });
+            toCache.append(worst->row);                 // preempted: back in the queue
+            DecodePriority::order(toCache, pos, true);
+            worst->freeAt = std::min(worst->freeAt, abortMs);
+            worst->row = -1;
+        }
+    }
+
+    // run the pool until the current row is decoded
+    for (;;) {
+        auto next = std::min_element(pool.begin(), pool.end(), [](const Slot &a, const Slot &b) {
+            return a.freeAt < b.freeAt;
+        });
+        if (next->row == pos) return next->freeAt;
+        if (next->row >= 0) cached.append(next->row);
+        if (toCache.isEmpty()) return -1;
+        next->row = toCache.takeFirst();
+        next->freeAt += decodeMs;
+    }
+}
+
+} // namespace
+
+class TestDecodePriority : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rankOrder();
+    void orderIsStable();
+    void jumpTimeToFirstPixel();
+};
+
+void TestDecodePriority::rankOrder()
+{
+    QCOMPARE(DecodePriority::rank(50, 50, true), 0);
+    // forward: ahead beats behind at the same distance, and behind d ~ ahead 2d
+    QVERIFY(DecodePriority::rank(51, 50, true) < DecodePriority::rank(49, 50, true));
+    QVERIFY(DecodePriority::rank(49, 50, true) < DecodePriority::rank(52, 50, true));
+    QVERIFY(DecodePriority::rank(52, 50, true) < DecodePriority::rank(48, 50, true));
+    // backward mirrors it
+    QVERIFY(DecodePriority::rank(49, 50, false) < DecodePriority::rank(51, 50, false));
+    QCOMPARE(DecodePriority::rank(40, 50, false), DecodePriority::rank(60, 50, true));
+    // invalid rows sort last
+    QCOMPARE(DecodePriority::rank(-1, 50, true), DecodePriority::lowest);
+}
+
+void TestDecodePriority::orderIsStable()
+{
+    QList<int> rows {58, 45, 50, 53, 49, 51, 60};
+    DecodePriority::order(rows, 50, true);
+    QCOMPARE(rows, QList<int>({50, 51, 49, 53, 58, 45, 60}));
+    // same input, same order: nextToCache re-sorts on every call
+    QList<int> again = rows;
+    DecodePriority::order(again, 50, true);
+    QCOMPARE(again, rows);
+}
+
+void TestDecodePriority::jumpTimeToFirstPixel()
+{
+    qInfo().noquote() << "jump rows   insertion order ms   priority ms";
+    // from 8 rows on the target is not cached; 8-11 it is already being decoded
+    for (int jump : {10, 15, 25, 40, 200}) {
+        const int before = timeToFirstPixel(jump, false);
+        const int after = timeToFirstPixel(jump, true);
+        qInfo().noquote() << QString("%1  %2  %3").arg(jump, 9).arg(before, 20).arg(after, 13);
+        QVERIFY(after > 0);
+        QVERIFY(before > 0);
+        QVERIFY(after <= before);
+        // the current image starts decoding within one abort of the jump
+        QVERIFY(after <= abortMs + decodeMs);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestDecodePriority)
+#include "tst_decodepriority.moc"
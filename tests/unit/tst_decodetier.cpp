@@ -0,0 +1,94 @@
+/*
+    DecodeTier -- which decode a raw file gets, and at what resolution.
+
+    The half size sensor decode only runs if three rules line up: Preview takes the sensor
+    path ("Decode raw in loupe"), ImageCache reduces the current row because it is a
+    sensor decode, and RawFormat finds the reduction small enough to halve the mosaic.
+    Each rule is pinned here, then the states the loupe actually passes through.
+*/
+#include <QtTest>
+#include "Cache/decodetier.h"
+
+using Winnow::Cache::DecodeTier;
+
+namespace {
+
+constexpr int edge = 2560;                  // loupe long edge, device pixels
+constexpr int sensorW = 8256, sensorH = 5504;   // 45 MP Bayer
+
+/* The chain for the current raw row: ImageDecoder::sensorDecodeActive, then
+   ImageCache::decodeEdge, then RawFormat::Decode. True when it decodes at half size. */
+bool currentDecodesHalf(bool develop, bool useRaw, bool rawInLoupe, bool zoomed)
+{
+    const bool sensor = DecodeTier::sensorDecode(develop, useRaw, rawInLoupe);
+    const bool needsFull = develop || zoomed;       // ImageCache::needsFull
+    const int reduce = DecodeTier::reduceToEdge(edge, true, needsFull, true, sensor);
+    return sensor && DecodeTier::halfSize(reduce, sensorW, sensorH, true, false);
+}
+
+} // namespace
+
+class TestDecodeTier : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sensorDecodeFollowsMode();
+    void currentRowReducedOnlyForSensor();
+    void reduceToEdgeOff();
+    void halfSizeNeedsBayerAndRoom();
+    void loupeStates();
+};
+
+void TestDecodeTier::sensorDecodeFollowsMode()
+{
+    // Develop: Decode Raw (the mode turns it on); the loupe preference does not apply
+    QVERIFY(DecodeTier::sensorDecode(true, true, false));
+    QVERIFY(!DecodeTier::sensorDecode(true, false, true));
+    // Preview: G::useRaw is off there, so the loupe preference alone decides
+    QVERIFY(DecodeTier::sensorDecode(false, false, true));
+    QVERIFY(!DecodeTier::sensorDecode(false, false, false));
+}
+
+void TestDecodeTier::currentRowReducedOnlyForSensor()
+{
+    QCOMPARE(DecodeTier::reduceToEdge(edge, true, false, false, false), edge);
+    QCOMPARE(DecodeTier::reduceToEdge(edge, true, false, true, false), 0);
+    QCOMPARE(DecodeTier::reduceToEdge(edge, true, false, true, true), edge);
+}
+
+void TestDecodeTier::reduceToEdgeOff()
+{
+    QCOMPARE(DecodeTier::reduceToEdge(edge, false, false, true, true), 0);  // tiered cache off
+    QCOMPARE(DecodeTier::reduceToEdge(0, true, false, true, true), 0);      // loupe size unknown
+    QCOMPARE(DecodeTier::reduceToEdge(edge, true, true, true, true), 0);    // needsFull
+    QCOMPARE(DecodeTier::reduceToEdge(edge, true, true, false, false), 0);
+}
+
+void TestDecodeTier::halfSizeNeedsBayerAndRoom()
+{
+    QVERIFY(DecodeTier::halfSize(edge, sensorW, sensorH, true, false));
+    QVERIFY(!DecodeTier::halfSize(0, sensorW, sensorH, true, false));       // full decode
+    QVERIFY(!DecodeTier::halfSize(edge, sensorW, sensorH, false, false));   // X-Trans
+    QVERIFY(!DecodeTier::halfSize(edge, sensorW, sensorH, true, true));     // Denoise raw
+    // half the long edge must still cover the loupe: 4128 >= 4128, 4127 < 4128
+    QVERIFY(DecodeTier::halfSize(sensorW / 2, sensorW, sensorH, true, false));
+    QVERIFY(!DecodeTier::halfSize(sensorW / 2 + 1, sensorW, sensorH, true, false));
+    QVERIFY(DecodeTier::halfSize(edge, sensorH, sensorW, true, false));     // portrait
+}
+
+void TestDecodeTier::loupeStates()
+{
+    // Preview, "Decode raw in loupe" on, fit to window: the half size path
+    QVERIFY(currentDecodesHalf(false, false, true, false));
+    // zoomed past the reduced copy: requestFullResolution makes it full
+    QVERIFY(!currentDecodesHalf(false, false, true, true));
+    // preference off: the embedded preview, never RawFormat
+    QVERIFY(!currentDecodesHalf(false, false, false, false));
+    // Develop: always the full demosaic, whatever the preference
+    QVERIFY(!currentDecodesHalf(true, true, true, false));
+    QVERIFY(!currentDecodesHalf(true, true, false, false));
+}
+
+QTEST_GUILESS_MAIN(TestDecodeTier)
+#include "tst_decodetier.moc"
@@ -0,0 +1,190 @@
+/*
+    Develop's fused tile passes (Develop::Tiler).
+
+    Apply() runs every op after Denoise one tile at a time, with the band ops sharing a
+    luma plane re-derived inside the tile pass and Sharpen / Grain reading a halo or
+    upsampling their fields per tile. Cutting the frame up must not change the render, so
+    every recipe here is rendered with tiles small enough to put seams through the
+    ramp, the edges and the black patch, and compared with the same recipe run as one
+    full-frame tile -- which is the old op-per-pass pipeline. The scene is deliberately not
+    a multiple of any tile edge, so the ragged last row and column of tiles are exercised.
+
+    TOLERANCE. The arithmetic is the same per pixel, so the two renders are expected to be
+    identical. kTol allows for OpenCV picking a different blur implementation for a
+    whole-frame Mat than for an ROI of one (IPP is only offered whole images); it is far
+    below one 8-bit code value, so a seam still fails loudly.
+
+    fullFrameTiming prints the per-op split and the tile stats on a 24 MP frame; nothing
+    is asserted about it, and it runs only on request.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <cmath>
+#include <vector>
+#include "Develop/develop.h"
+#include "Develop/workingimage.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr float kTol = 1e-5f;
+constexpr int kFullFrame = 1 << 20;     // a tile edge no frame reaches: one tile
+
+/* A ramp with a checker of hard steps, per-pixel noise and a true-black patch (which the
+   ratio fold-backs skip), in a warm tint so a chroma change would show. */
+WorkingImage makeScene(int w, int h)
+{
+    WorkingImage img;
+    img.width = w; img.height = h; img.white = 1.0f;
+    img.rgb.resize(static_cast<size_t>(w) * h * 3);
+    uint32_t s = 12345;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            s = s * 1664525u + 1013904223u;
+            const float n = ((s >> 8) & 0xffff) / 65535.0f;
+            float v = 0.05f + 0.6f * x / w + 0.3f * y / h + 0.05f * n;
+            if ((x / 37 + y / 29) % 3 == 0) v *= 1.8f;
+            if (x > w / 2 && y < h / 4) v = 0.0f;
+            const size_t i = (static_cast<size_t>(y) * w + x) * 3;
+            img.rgb[i + 0] = v;
+            img.rgb[i + 1] = v * 0.9f;
+            img.rgb[i + 2] = v * (0.7f + 0.3f * n);
+        }
+    }
+    return img;
+}
+
+struct Recipe { const char *name; EditParams p; };
+
+std::vector<Recipe> recipes()
+{
+    std::vector<Recipe> r;
+    EditParams p;
+    p.exposure = 0.5f; p.contrast = 30.0f; p.saturation = 20.0f;
+    r.push_back({"point", p});
+    p = EditParams(); p.texture = 60.0f;
+    r.push_back({"texture", p});
+    p = EditParams(); p.clarity = -40.0f;
+    r.push_back({"clarity", p});
+    p = EditParams(); p.dehaze = 50.0f;
+    r.push_back({"dehaze", p});
+    p = EditParams(); p.vignetteExposure = -1.0f;
+    r.push_back({"vignette", p});
+    p = EditParams(); p.sharpenAmount = 1.0f; p.sharpenRadius = 1.5f;
+    r.push_back({"sharpen", p});
+    p = EditParams(); p.sharpenAmount = 1.0f; p.sharpenMasking = 0.5f;
+    r.push_back({"sharpenMasked", p});
+    p = EditParams(); p.grainAmount = 0.5f; p.grainRoughness = 0.7f;
+    r.push_back({"grain", p});
+    p = EditParams(); p.exposure = 0.3f; p.texture = 40.0f; p.clarity = 30.0f;
+    p.dehaze = 20.0f; p.vignetteExposure = -0.5f; p.sharpenAmount = 0.8f;
+    p.sharpenMasking = 0.3f; p.grainAmount = 0.3f;
+    r.push_back({"everything", p});
+    return r;
+}
+
+WorkingImage render(const EditParams &p, int tileEdge, int w = 700, int h = 530)
+{
+    WorkingImage img = makeScene(w, h);
+    Develop::setTileEdge(tileEdge);
+    Develop().Apply(img, p, nullptr);
+    Develop::setTileEdge(0);
+    return img;
+}
+
+float maxDiff(const WorkingImage &a, const WorkingImage &b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.rgb.size(); ++i)
+        worst = std::max(worst, std::fabs(a.rgb[i] - b.rgb[i]));
+    return worst;
+}
+
+} // namespace
+
+class TestDevelopTiles : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tilesMatchFullFrame();
+    void tilesIndependentOfThreadCount();
+    void stageTimingsCountTiles();
+    void fullFrameTiming();
+};
+
+void TestDevelopTiles::tilesMatchFullFrame()
+{
+    for (const Recipe &r : recipes()) {
+        const WorkingImage ref = render(r.p, kFullFrame);
+        QVERIFY2(maxDiff(ref, makeScene(700, 530)) > 100.0f * kTol,
+                 qPrintable(QString("%1 changed nothing").arg(r.name)));
+        for (const int edge : {64, 100, Develop::kTile}) {
+            const WorkingImage got = render(r.p, edge);
+            const float d = maxDiff(got, ref);
+            QVERIFY2(d <= kTol, qPrintable(QString("%1 tile %2: max delta %3")
+                                               .arg(r.name).arg(edge).arg(double(d))));
+        }
+    }
+}
+
+void TestDevelopTiles::tilesIndependentOfThreadCount()
+{
+    const EditParams p = recipes().back().p;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int saved = pool->maxThreadCount();
+    pool->setMaxThreadCount(1);
+    const WorkingImage one = render(p, 64);
+    pool->setMaxThreadCount(qMax(4, saved));
+    const WorkingImage many = render(p, 64);
+    pool->setMaxThreadCount(saved);
+    QVERIFY(one.rgb == many.rgb);
+}
+
+void TestDevelopTiles::stageTimingsCountTiles()
+{
+    /* Texture, Clarity and Dehaze each need the whole frame's luma before their blur, and
+       Sharpen before its halo, so in "everything" each of those four ends a pass and
+       Sharpen + Grain run as a fifth. Each pass visits every tile. */
+    const int w = 700, h = 530;
+    WorkingImage img = makeScene(w, h);
+    Develop::StageTimings t;
+    Develop().Apply(img, recipes().back().p, &t);
+    const int perPass = ((w + Develop::kTile - 1) / Develop::kTile) *
+                        ((h + Develop::kTile - 1) / Develop::kTile);
+    QCOMPARE(t.tilePasses, 5);
+    QCOMPARE(t.tiles, 5 * perPass);
+    QVERIFY(t.tileMaxUs > 0);
+    QVERIFY(t.tileMaxUs <= t.tileCpuUs);
+
+    /* A point-only recipe is a single pass. */
+    WorkingImage img2 = makeScene(w, h);
+    Develop::StageTimings t2;
+    Develop().Apply(img2, recipes().front().p, &t2);
+    QCOMPARE(t2.tilePasses, 1);
+    QCOMPARE(t2.tiles, perPass);
+}
+
+void TestDevelopTiles::fullFrameTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const int w = 6000, h = 4000;
+    const EditParams p = recipes().back().p;
+    WorkingImage img = makeScene(w, h);
+    Develop::StageTimings t;
+    QElapsedTimer timer;
+    timer.start();
+    Develop().Apply(img, p, &t);
+    const qint64 ms = timer.elapsed();
+    qInfo().noquote() << QString("24 MP everything: %1 ms  (point %2  texture %3  clarity %4"
+                                 "  dehaze %5  vignette %6  sharpen %7  grain %8)")
+                         .arg(ms).arg(t.pointMs).arg(t.textureMs).arg(t.clarityMs)
+                         .arg(t.dehazeMs).arg(t.vignetteMs).arg(t.sharpenMs).arg(t.grainMs);
+    qInfo().noquote() << QString("%1 passes, %2 tiles, %3 ms CPU in tiles, slowest tile %4 us")
+                         .arg(t.tilePasses).arg(t.tiles).arg(t.tileCpuUs / 1000)
+                         .arg(t.tileMaxUs);
+}
+
+QTEST_GUILESS_MAIN(TestDevelopTiles)
+#include "tst_developtiles.moc"
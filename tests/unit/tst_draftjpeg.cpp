@@ -0,0 +1,86 @@
+/*
+    DraftJpeg -- scrubbing drafts of JPEG data (ImageCache::useDraftDecode).
+
+    A draft is kept out of the disk preview tier and replaced when scrubbing stops, so a
+    scaled decode that is not marked as one would be cached and persisted as if it were
+    the image. Both decode paths mark through isDraft(): read() (Qt's handler, Windows
+    and the fallback) on the D700 fixture, and the rule itself with the sizes JpegTurbo
+    reports on macOS, where the decode needs the turbojpeg library.
+*/
+#include <QtTest>
+#include <QBuffer>
+#include <QFile>
+#include "Cache/draftjpeg.h"
+
+namespace {
+
+// 1363 x 2048
+const QString kJpeg = QStringLiteral(WINNOW_TEST_IMAGES "/sample_nikon_d700.jpg");
+
+QByteArray fixture()
+{
+    QFile f(kJpeg);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+} // namespace
+
+class TestDraftJpeg : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readDecodesToTheEdge();
+    void readLeavesSmallImagesAlone();
+    void draftIsMarked();
+};
+
+void TestDraftJpeg::readDecodesToTheEdge()
+{
+    QByteArray data = fixture();
+    QVERIFY(!data.isEmpty());
+    QBuffer buf(&data);
+    QVERIFY(buf.open(QIODevice::ReadOnly));
+    QImage image;
+    QSize full;
+    QVERIFY(DraftJpeg::read(&buf, 512, image, full));
+    QCOMPARE(full, QSize(1363, 2048));
+    QCOMPARE(qMax(image.width(), image.height()), 512);
+    QVERIFY(DraftJpeg::isDraft(true, image.size(), full));
+}
+
+void TestDraftJpeg::readLeavesSmallImagesAlone()
+{
+    QByteArray data = fixture();
+    QBuffer buf(&data);
+    QVERIFY(buf.open(QIODevice::ReadOnly));
+    QImage image;
+    QSize full;
+    // already within the edge: the caller decodes normally from where it started
+    QVERIFY(!DraftJpeg::read(&buf, 2048, image, full));
+    QCOMPARE(buf.pos(), qint64(0));
+    QVERIFY(image.isNull());
+
+    // not a JPEG
+    QByteArray junk(4096, 'x');
+    QBuffer bad(&junk);
+    QVERIFY(bad.open(QIODevice::ReadOnly));
+    QVERIFY(!DraftJpeg::read(&bad, 512, image, full));
+    QCOMPARE(bad.pos(), qint64(0));
+}
+
+void TestDraftJpeg::draftIsMarked()
+{
+    const QSize full(6000, 4000);
+    // JpegTurbo DCT-scaled toward the loupe edge, as a draft decode asked it to
+    QVERIFY(DraftJpeg::isDraft(true, QSize(1500, 1000), full));
+    // the same scaled decode for the reduced (non-draft) tier is not a draft
+    QVERIFY(!DraftJpeg::isDraft(false, QSize(1500, 1000), full));
+    // a draft was wanted but the JPEG was already small: decoded in full
+    QVERIFY(!DraftJpeg::isDraft(true, full, full));
+    // the decode failed
+    QVERIFY(!DraftJpeg::isDraft(true, QSize(), full));
+}
+
+QTEST_GUILESS_MAIN(TestDraftJpeg)
+#include "tst_draftjpeg.moc"
@@ -0,0 +1,260 @@
+/*
+    EmbeddedThumb -- the minimal IFD walk behind the thumbnail-first icon.
+
+    The files are built here: a little-endian TIFF (IFD0 with SubIFDs, IFD1, a Nikon
+    style maker note) or a JPEG with an EXIF APP1 segment, holding "JPEGs" that are just
+    SOI, a frame header and EOI -- locate() reads no further than the SOF. Each test
+    checks which preview is picked, that its offset is absolute, and the orientation.
+*/
+#include <QtTest>
+#include <QTemporaryFile>
+#include "Image/embeddedthumb.h"
+
+namespace {
+
+QByteArray fakeJpeg(int w, int h, uchar sof = 0xC0)
+{
+    QByteArray j;
+    j.append("\xFF\xD8", 2);
+    j.append("\xFF\xE0\x00\x04\x00\x00", 6);            // an APP0 to skip
+    const char frame[] = {char(0xFF), char(sof), 0x00, 0x11, 0x08,
+                          char(h >> 8), char(h), char(w >> 8), char(w), 0x03};
+    j.append(frame, sizeof(frame));
+    j.append(QByteArray(9, '\0'));                      // component specs
+    j.append("\xFF\xD9", 2);
+    return j;
+}
+
+struct Tag { quint16 tag; quint16 type; quint32 value; };
+
+/* Little-endian TIFF under construction. Offsets are relative to the header, which is
+   at the start of bytes. */
+class TiffBuilder
+{
+public:
+    QByteArray bytes;
+    TiffBuilder() { bytes.append("II*\0\x08\0\0\0", 8); }
+
+    quint32 append(const QByteArray &b)
+    {
+        if (bytes.size() & 1) bytes.append('\0');
+        const quint32 off = quint32(bytes.size());
+        bytes.append(b);
+        return off;
+    }
+    // returns the IFD's offset; its next-IFD field is patched with link()
+    quint32 ifd(const QList<Tag> &tags)
+    {
+        QByteArray b;
+        put16(b, quint16(tags.size()));
+        for (const Tag &t : tags) {
+            put16(b, t.tag);
+            put16(b, t.type);
+            put32(b, 1);
+            if (t.type == 3) { put16(b, quint16(t.value)); put16(b, 0); }
+            else put32(b, t.value);
+        }
+        put32(b, 0);
+        return append(b);
+    }
+    void link(quint32 ifdOff, quint32 next)
+    {
+        const int n = uchar(bytes[ifdOff]) | uchar(bytes[ifdOff + 1]) << 8;
+        set32(int(ifdOff) + 2 + n * 12, next);
+    }
+    void setFirst(quint32 off) { set32(4, off); }
+
+    static void put16(QByteArray &b, quint16 v) { b.append(char(v)); b.append(char(v >> 8)); }
+    static void put32(QByteArray &b, quint32 v) { put16(b, quint16(v)); put16(b, quint16(v >> 16)); }
+    void set32(int at, quint32 v) { for (int i = 0; i < 4; ++i) bytes[at + i] = char(v >> (8 * i)); }
+};
+
+/* Write bytes to a temporary file and locate its preview. */
+bool locateIn(const QByteArray &bytes, const QString &ext, int minLongSide,
+              EmbeddedThumb::Location &loc)
+{
+    QTemporaryFile tmp;
+    if (!tmp.open()) return false;
+    tmp.write(bytes);
+    tmp.flush();
+    QFile f(tmp.fileName());
+    MappedFile file(f);
+    return EmbeddedThumb::locate(file, ext, minLongSide, loc);
+}
+
+/* A raw-like TIFF: IFD0 (orientation 6) -> SubIFD with a 1600 x 1066 preview and one with
+   lossless JPEG sensor data, IFD1 with a 160 x 120 thumbnail. */
+QByteArray rawLike(quint32 &previewOff, quint32 &thumbOff, int previewW = 1600)
+{
+    TiffBuilder t;
+    const QByteArray preview = fakeJpeg(previewW, previewW * 2 / 3);
+    const QByteArray thumb = fakeJpeg(160, 120);
+    const QByteArray sensor = fakeJpeg(6000, 4000, 0xC3);
+    previewOff = t.append(preview);
+    thumbOff = t.append(thumb);
+    const quint32 sensorOff = t.append(sensor);
+    const quint32 sub1 = t.ifd({{0x0201, 4, previewOff}, {0x0202, 4, quint32(preview.size())}});
+    const quint32 sub2 = t.ifd({{0x0103, 3, 7}, {0x0111, 4, sensorOff},
+                                {0x0117, 4, quint32(sensor.size())}});
+    // two SubIFD offsets do not fit inline: store them in a LONG[2] array
+    QByteArray subs;
+    TiffBuilder::put32(subs, sub1);
+    TiffBuilder::put32(subs, sub2);
+    const quint32 subsOff = t.append(subs);
+    const quint32 ifd0 = t.ifd({{0x0112, 3, 6}, {330, 4, subsOff}});
+    t.set32(int(ifd0) + 2 + 12 + 4, 2);                // SubIFDs count = 2
+    const quint32 ifd1 = t.ifd({{0x0201, 4, thumbOff}, {0x0202, 4, quint32(thumb.size())}});
+    t.link(ifd0, ifd1);
+    t.setFirst(ifd0);
+    return t.bytes;
+}
+
+}
+
+class TestEmbeddedThumb : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void jpegSize();
+    void picksPreviewThatFitsIcon();
+    void smallThumbWhenPreviewsAreHuge();
+    void nikonMakerNotePreview();
+    void jpegExifThumbnail();
+    void jpegWithoutExifIsItsOwnPreview();
+    void survivesIfdLoop();
+    void unsupported();
+};
+
+void TestEmbeddedThumb::jpegSize()
+{
+    const QByteArray j = fakeJpeg(640, 427);
+    const uchar *p = reinterpret_cast<const uchar *>(j.constData());
+    QCOMPARE(EmbeddedThumb::jpegSize(p, j.size()), QSize(640, 427));
+    QCOMPARE(EmbeddedThumb::jpegSize(p, 12), QSize());                    // truncated
+    const QByteArray progressive = fakeJpeg(10, 20, 0xC2);
+    QCOMPARE(EmbeddedThumb::jpegSize(reinterpret_cast<const uchar *>(progressive.constData()),
+                                     progressive.size()), QSize(10, 20));
+    const QByteArray lossless = fakeJpeg(10, 20, 0xC3);
+    QCOMPARE(EmbeddedThumb::jpegSize(reinterpret_cast<const uchar *>(lossless.constData()),
+                                     lossless.size()), QSize());
+    QCOMPARE(EmbeddedThumb::jpegSize(reinterpret_cast<const uchar *>("GIF89a.."), 8), QSize());
+}
+
+void TestEmbeddedThumb::picksPreviewThatFitsIcon()
+{
+    quint32 previewOff, thumbOff;
+    const QByteArray file = rawLike(previewOff, thumbOff);
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(file, "nef", 256, loc));
+    QCOMPARE(loc.offset, previewOff);
+    QCOMPARE(loc.size, QSize(1600, 1066));
+    QCOMPARE(loc.orientation, 6);
+
+    // an icon the thumbnail covers takes the thumbnail
+    QVERIFY(locateIn(file, "arw", 100, loc));
+    QCOMPARE(loc.offset, thumbOff);
+    QCOMPARE(loc.length, quint32(fakeJpeg(160, 120).size()));
+}
+
+void TestEmbeddedThumb::smallThumbWhenPreviewsAreHuge()
+{
+    // a full-size preview (CR2 IFD0) is not decoded for an icon when a thumbnail exists
+    quint32 previewOff, thumbOff;
+    const QByteArray file = rawLike(previewOff, thumbOff, 6000);
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(file, "cr2", 256, loc));
+    QCOMPARE(loc.offset, thumbOff);
+    QCOMPARE(loc.size, QSize(160, 120));
+}
+
+void TestEmbeddedThumb::nikonMakerNotePreview()
+{
+    // the maker note: "Nikon\0", version, then a TIFF whose offsets are its own
+    TiffBuilder note;
+    const QByteArray preview = fakeJpeg(640, 424);
+    const quint32 previewRel = note.append(preview);
+    const quint32 pIfd = note.ifd({{0x0201, 4, previewRel}, {0x0202, 4, quint32(preview.size())}});
+    const quint32 mIfd = note.ifd({{0x0011, 4, pIfd}});
+    note.setFirst(mIfd);
+
+    TiffBuilder t;
+    const QByteArray full = fakeJpeg(8256, 5504);
+    const quint32 fullOff = t.append(full);
+    const quint32 noteOff = t.append(QByteArray("Nikon\0\x02\x10\0\0", 10) + note.bytes);
+    const quint32 exif = t.ifd({{0x927C, 7, noteOff}});   // MakerNote, UNDEFINED[n]
+    t.set32(int(exif) + 2 + 4, quint32(10 + note.bytes.size()));
+    const quint32 sub = t.ifd({{0x0201, 4, fullOff}, {0x0202, 4, quint32(full.size())}});
+    const quint32 ifd0 = t.ifd({{0x0112, 3, 1}, {330, 4, sub}, {0x8769, 4, exif}});
+    t.setFirst(ifd0);
+
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(t.bytes, "nef", 256, loc));
+    QCOMPARE(loc.offset, noteOff + 10 + previewRel);
+    QCOMPARE(loc.size, QSize(640, 424));
+    QCOMPARE(loc.orientation, 1);
+}
+
+void TestEmbeddedThumb::jpegExifThumbnail()
+{
+    TiffBuilder t;
+    const QByteArray thumb = fakeJpeg(160, 120);
+    const quint32 thumbRel = t.append(thumb);
+    const quint32 ifd1 = t.ifd({{0x0201, 4, thumbRel}, {0x0202, 4, quint32(thumb.size())}});
+    const quint32 ifd0 = t.ifd({{0x0112, 3, 8}});
+    t.link(ifd0, ifd1);
+    t.setFirst(ifd0);
+
+    QByteArray app1("Exif\0\0", 6);
+    app1 += t.bytes;
+    QByteArray file("\xFF\xD8", 2);
+    file += QByteArray("\xFF\xE1", 2);
+    file += char((app1.size() + 2) >> 8);
+    file += char(app1.size() + 2);
+    file += app1;
+    file += fakeJpeg(4000, 3000).mid(2);                // the main image's frame header
+
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(file, "jpg", 256, loc));
+    QCOMPARE(loc.offset, quint32(2 + 4 + 6) + thumbRel);
+    QCOMPARE(loc.size, QSize(160, 120));
+    QCOMPARE(loc.orientation, 8);
+}
+
+void TestEmbeddedThumb::jpegWithoutExifIsItsOwnPreview()
+{
+    const QByteArray file = fakeJpeg(1200, 800);
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(file, "jpeg", 256, loc));
+    QCOMPARE(loc.offset, quint32(0));
+    QCOMPARE(loc.length, quint32(file.size()));
+    QCOMPARE(loc.size, QSize(1200, 800));
+}
+
+void TestEmbeddedThumb::survivesIfdLoop()
+{
+    TiffBuilder t;
+    const QByteArray thumb = fakeJpeg(300, 200);
+    const quint32 thumbOff = t.append(thumb);
+    const quint32 ifd0 = t.ifd({{0x0201, 4, thumbOff}, {0x0202, 4, quint32(thumb.size())},
+                                {330, 4, 8}});          // SubIFD pointing at the header
+    t.link(ifd0, ifd0);                                 // next IFD is itself
+    t.setFirst(ifd0);
+    EmbeddedThumb::Location loc;
+    QVERIFY(locateIn(t.bytes, "dng", 256, loc));
+    QCOMPARE(loc.offset, thumbOff);
+}
+
+void TestEmbeddedThumb::unsupported()
+{
+    quint32 previewOff, thumbOff;
+    const QByteArray file = rawLike(previewOff, thumbOff);
+    EmbeddedThumb::Location loc;
+    QVERIFY(!EmbeddedThumb::supports("cr3"));
+    QVERIFY(!EmbeddedThumb::supports("tif"));
+    QVERIFY(!locateIn(file, "tif", 256, loc));
+    QVERIFY(!locateIn(QByteArray("not a tiff at all"), "nef", 256, loc));
+}
+
+QTEST_GUILESS_MAIN(TestEmbeddedThumb)
+#include "tst_embeddedthumb.moc"
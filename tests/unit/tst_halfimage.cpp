@@ -0,0 +1,319 @@
+/*
+    HalfFloat / HalfImage -- the binary16 storage behind WorkingImageCache's packed tail
+    and MW's PMRID base -- and the cache's float/half bookkeeping.
+
+    The conversions are checked three ways: every SIMD level against the scalar reference
+    bit for bit (the same contract as tst_rawkernels); every finite half surviving
+    half -> float -> half unchanged, so a re-packed image cannot drift; and the rounding
+    error staying within binary16's 2^-11. Then the part a user could see: a scene-linear
+    frame packed and unpacked must render through OutputTransform to within ONE 8-bit code
+    of the float original, and only a small share of bytes may move at all.
+
+    packTiming prints pack / unpack throughput per level on a 45 MP frame; nothing is
+    asserted about it, and ctest skips it.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QImage>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Develop/halfimage.h"
+#include "Develop/outputtransform.h"
+#include "Develop/workingimagecache.h"
+#include "benchmark.h"
+
+using Winnow::Simd::Level;
+
+namespace {
+
+const Level simdLevels[] = {Level::SSE41, Level::AVX2, Level::NEON};
+
+bool sameBits(float a, float b)
+{
+    if (std::isnan(a) && std::isnan(b)) return true;
+    return std::memcmp(&a, &b, 4) == 0;
+}
+
+/* A scene-linear frame with smooth ramps, per-pixel noise, deep shadows (down into the
+   binary16 subnormals) and highlights past white. */
+WorkingImage makeScene(int w, int h, bool sceneReferred)
+{
+    WorkingImage img;
+    img.width = w; img.height = h; img.white = 1.0f;
+    img.sceneReferred = sceneReferred;
+    img.rgb.resize(size_t(w) * h * 3);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> noise(0.97f, 1.03f);
+    const float top = sceneReferred ? 6.0f : 1.0f;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const float ev = -20.0f + 20.0f * float(x) / float(w - 1);  // 2^-20 .. 1
+            const float v = std::min(top, std::exp2(ev) * (0.25f + top * y / float(h)));
+            const size_t i = (size_t(y) * w + x) * 3;
+            img.rgb[i + 0] = v * noise(rng);
+            img.rgb[i + 1] = v * 0.8f * noise(rng);
+            img.rgb[i + 2] = v * 0.6f * noise(rng);
+        }
+    }
+    return img;
+}
+
+WorkingImage roundTrip(const WorkingImage &src)
+{
+    HalfImage half;
+    PackImage(src, half);
+    WorkingImage back;
+    UnpackImage(half, back);
+    return back;
+}
+
+} // namespace
+
+class TestHalfImage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void packMatchesScalar();
+    void unpackMatchesScalar();
+    void roundTripIsExact();
+    void errorWithinHalfPrecision();
+    void renderWithinOneCode();
+    void cacheHoldsTailAsHalf();
+    void activeEntryStaysFloat();
+    void packTiming();
+};
+
+void TestHalfImage::packMatchesScalar()
+{
+    /* Every 4099th float bit pattern (both signs, every exponent, NaNs, infinities) plus
+       the rounding and clamp edges. */
+    std::vector<float> v;
+    for (uint64_t u = 0; u <= 0xffffffffull; u += 4099) {
+        const uint32_t b = uint32_t(u);
+        float f;
+        std::memcpy(&f, &b, 4);
+        v.push_back(f);
+    }
+    for (const float f : {0.0f, -0.0f, 65504.0f, 65519.0f, 65520.0f, 1e9f, -1e9f,
+                          INFINITY, -INFINITY, NAN, 5.9604645e-8f, 2.9802322e-8f,
+                          2.9802326e-8f, 6.1035156e-5f, 6.1035149e-5f, 1.00048828f})
+        v.push_back(f);
+
+    for (const size_t n : {size_t(1), size_t(7), size_t(8), size_t(9), size_t(17), v.size()}) {
+        std::vector<uint16_t> ref(n);
+        HalfFloat::Pack(v.data() + v.size() - n, ref.data(), n, Level::Scalar);
+        for (const Level l : simdLevels) {
+            if (!Winnow::Simd::supported(l)) continue;
+            std::vector<uint16_t> got(n, 0xdead);
+            HalfFloat::Pack(v.data() + v.size() - n, got.data(), n, l);
+            QVERIFY2(got == ref, qPrintable(QString("%1 n %2").arg(Winnow::Simd::name(l)).arg(n)));
+        }
+    }
+
+    /* The clamp: nothing packs to an infinity. */
+    std::vector<uint16_t> h(v.size());
+    HalfFloat::Pack(v.data(), h.data(), v.size());
+    for (const uint16_t x : h) QVERIFY((x & 0x7fff) != 0x7c00);
+}
+
+void TestHalfImage::unpackMatchesScalar()
+{
+    std::vector<uint16_t> h(65536);
+    for (int i = 0; i < 65536; ++i) h[i] = uint16_t(i);
+    std::vector<float> ref(h.size());
+    HalfFloat::Unpack(h.data(), ref.data(), h.size(), Level::Scalar);
+    for (const Level l : simdLevels) {
+        if (!Winnow::Simd::supported(l)) continue;
+        std::vector<float> got(h.size(), -1.0f);
+        HalfFloat::Unpack(h.data(), got.data(), h.size(), l);
+        for (size_t i = 0; i < h.size(); ++i)
+            QVERIFY2(sameBits(got[i], ref[i]),
+                     qPrintable(QString("%1 half 0x%2").arg(Winnow::Simd::name(l))
+                                    .arg(uint(i), 4, 16, QChar('0'))));
+    }
+}
+
+void TestHalfImage::roundTripIsExact()
+{
+    for (int i = 0; i < 65536; ++i) {
+        if ((i & 0x7c00) == 0x7c00) continue;                // Inf / NaN
+        const float f = HalfFloat::ToFloat(uint16_t(i));
+        uint16_t back = 0;
+        HalfFloat::Pack(&f, &back, 1);
+        QCOMPARE(int(back), i);
+    }
+}
+
+void TestHalfImage::errorWithinHalfPrecision()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> ev(-14.0f, 15.99f);
+    std::uniform_real_distribution<float> tiny(0.0f, 6.1035156e-5f);
+    double worstRel = 0.0, worstAbs = 0.0;
+    for (int i = 0; i < 1000000; ++i) {
+        const float x = std::exp2(ev(rng));                  // normal binary16 range
+        uint16_t h;
+        HalfFloat::Pack(&x, &h, 1);
+        worstRel = std::max(worstRel, std::fabs(double(HalfFloat::ToFloat(h)) - x) / x);
+        const float t = tiny(rng);                           // subnormal range
+        HalfFloat::Pack(&t, &h, 1);
+        worstAbs = std::max(worstAbs, std::fabs(double(HalfFloat::ToFloat(h)) - t));
+    }
+    QVERIFY2(worstRel <= std::exp2(-11.0), qPrintable(QString::number(worstRel)));
+    QVERIFY2(worstAbs <= std::exp2(-25.0), qPrintable(QString::number(worstAbs)));
+}
+
+void TestHalfImage::renderWithinOneCode()
+{
+    for (const bool sceneReferred : {true, false}) {
+        const WorkingImage img = makeScene(1024, 256, sceneReferred);
+        const WorkingImage back = roundTrip(img);
+        QCOMPARE(back.width, img.width);
+        QCOMPARE(back.sceneReferred, img.sceneReferred);
+
+        OutputTransform t;
+        QImage a, b;
+        QVERIFY(t.ToImage(img, a));
+        QVERIFY(t.ToImage(back, b));
+        int worst = 0;
+        qint64 offBy = 0, total = 0;
+        for (int y = 0; y < img.height; ++y) {
+            const uchar *la = a.constScanLine(y), *lb = b.constScanLine(y);
+            for (int x = 0; x < img.width * 3; ++x) {
+                const int d = std::abs(int(la[x]) - int(lb[x]));
+                worst = std::max(worst, d);
+                if (d) ++offBy;
+                ++total;
+            }
+        }
+        QVERIFY2(worst <= 1, qPrintable(QString("sceneReferred %1: worst delta %2")
+                                            .arg(int(sceneReferred)).arg(worst)));
+        /* A byte moves only when the rounding straddles a code boundary, a few hundredths
+           of a code wide. Measured ~0.3% of bytes; 1% catches a real loss of precision. */
+        QVERIFY2(offBy * 100 <= total,
+                 qPrintable(QString("sceneReferred %1: %2 of %3 bytes differ")
+                                .arg(int(sceneReferred)).arg(offBy).arg(total)));
+    }
+}
+
+void TestHalfImage::cacheHoldsTailAsHalf()
+{
+    WorkingImageCache &cache = WorkingImageCache::instance();
+    cache.clear();
+    cache.setMaxBytes(qint64(1) << 30);
+    cache.setStorage(WorkingImageCache::Storage::Half);
+
+    auto a = std::make_shared<WorkingImage>(makeScene(300, 200, true));
+    auto b = std::make_shared<WorkingImage>(makeScene(400, 300, true));
+    const qint64 floatA = WorkingImageCache::bytesOf(*a), floatB = WorkingImageCache::bytesOf(*b);
+    cache.put("a", a);
+    QCOMPARE(cache.currentBytes(), floatA);                  // the MRU stays float
+    cache.put("b", b);
+    QCOMPARE(cache.currentBytes(), floatB + floatA / 2);     // a was packed
+
+    /* Fetching a makes it the MRU: unpacked within half precision, b packed instead. */
+    const auto gotA = cache.get("a");
+    QVERIFY(gotA && gotA != a);
+    QCOMPARE(gotA->width, a->width);
+    for (size_t i = 0; i < a->rgb.size(); ++i)
+        QVERIFY(std::fabs(gotA->rgb[i] - a->rgb[i]) <= a->rgb[i] * float(std::exp2(-11.0)) + 1e-7f);
+    QCOMPARE(cache.currentBytes(), floatA + floatB / 2);
+    QVERIFY(cache.get("a") == gotA);                         // MRU hit: no new unpack
+
+    /* A budget that holds one float image plus a packed one keeps both. */
+    cache.setMaxBytes(floatA + floatB / 2);
+    QCOMPARE(cache.count(), 2);
+
+    /* Float storage: packed entries come back as float and stay float. */
+    cache.setStorage(WorkingImageCache::Storage::Float);
+    cache.setMaxBytes(qint64(1) << 30);
+    QVERIFY(cache.get("b"));
+    QVERIFY(cache.get("a"));
+    QCOMPARE(cache.currentBytes(), floatA + floatB);
+
+    cache.clear();
+    cache.setStorage(WorkingImageCache::Storage::Half);
+}
+
+void TestHalfImage::activeEntryStaysFloat()
+{
+    WorkingImageCache &cache = WorkingImageCache::instance();
+    cache.clear();
+    cache.setMaxBytes(qint64(1) << 30);
+    cache.setStorage(WorkingImageCache::Storage::Half);
+    cache.setActive("a");
+
+    auto a = std::make_shared<WorkingImage>(makeScene(300, 200, true));
+    auto b = std::make_shared<WorkingImage>(makeScene(400, 300, true));
+    auto c = std::make_shared<WorkingImage>(makeScene(200, 100, true));
+    const qint64 floatA = WorkingImageCache::bytesOf(*a), floatB = WorkingImageCache::bytesOf(*b),
+                 floatC = WorkingImageCache::bytesOf(*c);
+
+    /* Decoders put and get other images while a is edited: a stays float throughout, only
+       what is neither active nor the MRU is packed. */
+    cache.put("a", a);
+    cache.put("b", b);
+    cache.put("c", c);
+    QCOMPARE(cache.currentBytes(), floatA + floatB / 2 + floatC);
+    QVERIFY(cache.get("b"));
+    QCOMPARE(cache.currentBytes(), floatA + floatB + floatC / 2);
+
+    /* Nor is it evicted when it is not the MRU. */
+    cache.setMaxBytes(1);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(cache.contains("a") && cache.contains("b"));
+
+    /* Once it is no longer active it is an ordinary tail entry. */
+    cache.setMaxBytes(qint64(1) << 30);
+    cache.setActive(QString());
+    QCOMPARE(cache.currentBytes(), floatA / 2 + floatB);
+    const auto gotA = cache.get("a");
+    QVERIFY(gotA && gotA != a);
+
+    cache.clear();
+}
+
+void TestHalfImage::packTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const WorkingImage img = makeScene(8256, 5504, true);    // 45 MP
+    HalfImage half;
+    WorkingImage back;
+    PackImage(img, half);                                    // fault the buffers in
+    UnpackImage(half, back);
+    const double mp = double(img.width) * img.height / 1e6;
+
+    qInfo().noquote() << "level      pack Mpix/s   unpack Mpix/s   (one thread)";
+    const size_t n = img.rgb.size();
+    for (const Level l : {Level::Scalar, Level::SSE41, Level::AVX2, Level::NEON}) {
+        if (!Winnow::Simd::supported(l)) continue;
+        QElapsedTimer t;
+        t.start();
+        HalfFloat::Pack(img.rgb.data(), half.rgb.data(), n, l);
+        const double packSec = qMax<qint64>(1, t.nsecsElapsed()) / 1e9;
+        t.restart();
+        HalfFloat::Unpack(half.rgb.data(), back.rgb.data(), n, l);
+        const double unpackSec = qMax<qint64>(1, t.nsecsElapsed()) / 1e9;
+        qInfo().noquote() << QString("%1  %2  %3").arg(Winnow::Simd::name(l), -8)
+                             .arg(mp / packSec, 12, 'f', 0)
+                             .arg(mp / unpackSec, 14, 'f', 0);
+    }
+
+    QElapsedTimer t;
+    t.start();
+    PackImage(img, half);
+    const qint64 packMs = t.restart();
+    UnpackImage(half, back);
+    const qint64 unpackMs = t.elapsed();
+    qInfo().noquote() << QString("45 MP image, all threads: pack %1 ms, unpack %2 ms, "
+                                 "%3 MB -> %4 MB")
+                         .arg(packMs).arg(unpackMs)
+                         .arg(WorkingImageCache::bytesOf(img) >> 20)
+                         .arg(WorkingImageCache::bytesOf(half) >> 20);
+}
+
+QTEST_GUILESS_MAIN(TestHalfImage)
+#include "tst_halfimage.moc"
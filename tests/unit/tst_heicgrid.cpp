@@ -0,0 +1,384 @@
+/*
+    HeicGrid -- the HEIF box parse behind the tile-parallel grid decode, and the pixel
+    conversion and transforms it applies to the decoded tiles.
+
+    The files are built here: ftyp, a meta box (pitm, iinf, iloc, iref, iprp, idat) and an
+    mdat whose "tiles" are length-prefixed NAL units of marker bytes -- parse() does not
+    look inside them. The libde265 decode itself is Windows only and not tested here.
+*/
+#include <QtTest>
+#include <QTemporaryFile>
+#include "ImageFormats/Heic/heicgrid.h"
+
+namespace {
+
+void put16(QByteArray &b, quint32 v) { b.append(char(v >> 8)); b.append(char(v)); }
+void put32(QByteArray &b, quint32 v) { put16(b, v >> 16); put16(b, v & 0xFFFF); }
+
+QByteArray box(const char *type, const QByteArray &payload)
+{
+    QByteArray b;
+    put32(b, quint32(8 + payload.size()));
+    b.append(type, 4);
+    return b + payload;
+}
+
+QByteArray fullBox(const char *type, int version, quint32 flags, const QByteArray &payload)
+{
+    QByteArray h;
+    h.append(char(version));
+    h.append(char(flags >> 16)); h.append(char(flags >> 8)); h.append(char(flags));
+    return box(type, h + payload);
+}
+
+QByteArray infe(quint16 id, const char *type)
+{
+    QByteArray p;
+    put16(p, id);
+    put16(p, 0);
+    p.append(type, 4);
+    p.append('\0');                                     // item name
+    return fullBox("infe", 2, 0, p);
+}
+
+QByteArray ref(const char *type, quint16 from, const QList<quint16> &to)
+{
+    QByteArray p;
+    put16(p, from);
+    put16(p, quint16(to.size()));
+    for (quint16 t : to) put16(p, t);
+    return box(type, p);
+}
+
+/* An hvcC record with one array each of VPS, SPS and PPS. */
+QByteArray hvcCRecord(int lengthSize = 4)
+{
+    QByteArray p(21, '\0');
+    p[0] = 1;
+    p.append(char(0xFC | (lengthSize - 1)));
+    p.append(char(3));
+    const QList<QByteArray> sets {QByteArray("\x40\x01VPS", 5), QByteArray("\x42\x01SPS!", 6),
+                                  QByteArray("\x44\x01P", 3)};
+    const int types[] = {32, 33, 34};
+    for (int k = 0; k < 3; ++k) {
+        p.append(char(0x80 | types[k]));
+        put16(p, 1);
+        put16(p, quint16(sets.at(k).size()));
+        p.append(sets.at(k));
+    }
+    return p;
+}
+
+QByteArray ispe(int w, int h)
+{
+    QByteArray p;
+    put32(p, quint32(w));
+    put32(p, quint32(h));
+    return fullBox("ispe", 0, 0, p);
+}
+
+struct Options {
+    bool clap = false;
+    bool alpha = false;
+    int rotate = 1;             // irot of the grid
+};
+
+/* A 2 x 2 grid of 64 x 32 tiles with a 120 x 60 output (ids 2..5), the grid item 1 with
+   its description in idat, a thumbnail 6. Tile k's data is "tile k" in one 4-byte length
+   NAL. */
+QByteArray gridFile(const Options &o, QList<QByteArray> *tileData = nullptr,
+                    qint64 *firstTileOffset = nullptr)
+{
+    QList<QByteArray> tiles;
+    for (int k = 0; k < 5; ++k) {
+        QByteArray nal = "tile " + QByteArray::number(k);
+        QByteArray d;
+        put32(d, quint32(nal.size()));
+        tiles << d + nal;
+    }
+    if (tileData) *tileData = tiles;
+
+    QByteArray grid;
+    grid.append(char(0)); grid.append(char(0));        // version, flags: 16-bit sizes
+    grid.append(char(1)); grid.append(char(1));        // rows - 1, columns - 1
+    put16(grid, 120);
+    put16(grid, 60);
+
+    auto meta = [&](quint32 mdatData) {
+        QByteArray iinf;
+        put16(iinf, o.alpha ? 7 : 6);
+        iinf += infe(1, "grid");
+        for (quint16 id = 2; id <= 6; ++id) iinf += infe(id, "hvc1");
+        if (o.alpha) iinf += infe(7, "hvc1");
+
+        // iloc v1: 4-byte offsets and lengths, no base offset
+        QByteArray iloc;
+        iloc.append(char(0x44));
+        iloc.append(char(0x00));
+        put16(iloc, 6);
+        put16(iloc, 1);                                 // the grid, in idat
+        put16(iloc, 1);
+        put16(iloc, 0);
+        put16(iloc, 1);
+        put32(iloc, 0);
+        put32(iloc, quint32(grid.size()));
+        quint32 at = mdatData;
+        for (int k = 0; k < 5; ++k) {
+            put16(iloc, quint16(2 + k));
+            put16(iloc, 0);
+            put16(iloc, 0);
+            put16(iloc, 1);
+            put32(iloc, at);
+            put32(iloc, quint32(tiles.at(k).size()));
+            at += quint32(tiles.at(k).size());
+        }
+
+        QByteArray irefs = ref("dimg", 1, {2, 3, 4, 5}) + ref("thmb", 6, {1});
+        if (o.alpha) irefs += ref("auxl", 7, {1});
+
+        QByteArray irot(1, char(o.rotate));
+        QByteArray ipco = box("hvcC", hvcCRecord()) + ispe(64, 32) + ispe(120, 60)
+                          + box("irot", irot) + ispe(40, 20) + box("imir", QByteArray(1, 0))
+                          + box("clap", QByteArray(32, '\0'));
+        // ipma v0, 8-bit associations: property indexes are 1-based into ipco
+        QByteArray ipma;
+        put32(ipma, 6);
+        put16(ipma, 1);
+        const QByteArray gridProps = o.clap ? QByteArray("\x03\x04\x07", 3) : QByteArray("\x03\x04", 2);
+        ipma.append(char(gridProps.size()));
+        ipma.append(gridProps);
+        for (quint16 id = 2; id <= 5; ++id) {
+            put16(ipma, id);
+            ipma.append(char(2));
+            ipma.append(char(0x81));                    // essential hvcC
+            ipma.append(char(2));
+        }
+        put16(ipma, 6);
+        ipma.append(char(3));
+        ipma.append(char(0x81));
+        ipma.append(char(5));
+        ipma.append(char(6));
+
+        return fullBox("meta", 0, 0,
+                       fullBox("hdlr", 0, 0, QByteArray(4, '\0') + "pict" + QByteArray(13, '\0'))
+                       + fullBox("pitm", 0, 0, QByteArray("\x00\x01", 2))
+                       + fullBox("iinf", 0, 0, iinf)
+                       + fullBox("iloc", 1, 0, iloc)
+                       + fullBox("iref", 0, 0, irefs)
+                       + box("iprp", box("ipco", ipco) + fullBox("ipma", 0, 0, ipma))
+                       + box("idat", grid));
+    };
+
+    const QByteArray ftyp = box("ftyp", QByteArray("heic\0\0\0\0mif1heic", 16));
+    const quint32 dataAt = quint32(ftyp.size() + meta(0).size() + 8);
+    if (firstTileOffset) *firstTileOffset = dataAt;
+    QByteArray mdat;
+    for (const QByteArray &t : tiles) mdat += t;
+    return ftyp + meta(dataAt) + box("mdat", mdat);
+}
+
+HeicGrid::Plan parseBytes(const QByteArray &bytes, QTemporaryFile &tmp)
+{
+    if (!tmp.open()) return HeicGrid::Plan();
+    tmp.write(bytes);
+    tmp.flush();
+    QFile f(tmp.fileName());
+    MappedFile file(f);
+    return HeicGrid::parse(file);
+}
+
+}
+
+class TestHeicGrid : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parsesGrid();
+    void itemData();
+    void fallsBackOnClapOrAlpha();
+    void rejectsGarbage();
+    void hvcCAndNals();
+    void yuvConversion();
+    void tilesClipToOutput();
+    void transforms();
+};
+
+void TestHeicGrid::parsesGrid()
+{
+    QTemporaryFile tmp;
+    qint64 firstTile = 0;
+    const HeicGrid::Plan plan = parseBytes(gridFile(Options(), nullptr, &firstTile), tmp);
+    QVERIFY(plan.ok);
+    QCOMPARE(plan.primary.id, quint32(1));
+    QCOMPARE(plan.primary.type, QByteArray("grid"));
+    QCOMPARE(plan.rows, 2);
+    QCOMPARE(plan.columns, 2);
+    QCOMPARE(plan.output, QSize(120, 60));
+    QCOMPARE(plan.primary.size, QSize(120, 60));
+    QCOMPARE(plan.primary.transforms.size(), 1);
+    QCOMPARE(plan.primary.transforms.first().kind, HeicGrid::Transform::Rotate);
+    QCOMPARE(plan.primary.transforms.first().value, 1);
+
+    QCOMPARE(plan.tiles.size(), 4);
+    for (int k = 0; k < 4; ++k) {
+        QCOMPARE(plan.tiles.at(k).id, quint32(2 + k));
+        QCOMPARE(plan.tiles.at(k).size, QSize(64, 32));
+        QCOMPARE(plan.tiles.at(k).hvcC, hvcCRecord());
+    }
+    QCOMPARE(plan.tiles.first().extents.first().offset, quint64(firstTile));
+
+    QCOMPARE(plan.thumb.id, quint32(6));
+    QCOMPARE(plan.thumb.size, QSize(40, 20));
+    QCOMPARE(plan.thumb.transforms.size(), 1);
+    QCOMPARE(plan.thumb.transforms.first().kind, HeicGrid::Transform::Mirror);
+    QVERIFY(plan.gridOk());
+    QVERIFY(plan.thumbOk());
+}
+
+void TestHeicGrid::itemData()
+{
+    QTemporaryFile tmp;
+    QList<QByteArray> tiles;
+    QVERIFY(tmp.open());
+    tmp.write(gridFile(Options(), &tiles));
+    tmp.flush();
+    QFile f(tmp.fileName());
+    MappedFile file(f);
+    const HeicGrid::Plan plan = HeicGrid::parse(file);
+    QVERIFY(plan.ok);
+    for (int k = 0; k < 4; ++k)
+        QCOMPARE(HeicGrid::itemData(file, plan, plan.tiles.at(k)), tiles.at(k));
+    QCOMPARE(HeicGrid::itemData(file, plan, plan.thumb), tiles.at(4));
+    // construction method 1: the grid description is in idat
+    QCOMPARE(HeicGrid::itemData(file, plan, plan.primary).size(), 8);
+
+    HeicGrid::Item outside = plan.tiles.first();
+    outside.extents.first().offset = quint64(file.size()) - 2;
+    QVERIFY(HeicGrid::itemData(file, plan, outside).isEmpty());
+}
+
+void TestHeicGrid::fallsBackOnClapOrAlpha()
+{
+    Options clap;
+    clap.clap = true;
+    QTemporaryFile tmp1;
+    HeicGrid::Plan plan = parseBytes(gridFile(clap), tmp1);
+    QVERIFY(plan.ok);
+    QVERIFY(plan.primary.hasClap);
+    QVERIFY(!plan.gridOk());
+
+    Options alpha;
+    alpha.alpha = true;
+    QTemporaryFile tmp2;
+    plan = parseBytes(gridFile(alpha), tmp2);
+    QVERIFY(plan.ok);
+    QVERIFY(plan.primary.hasAlpha);
+    QVERIFY(!plan.gridOk());
+}
+
+void TestHeicGrid::rejectsGarbage()
+{
+    QTemporaryFile tmp1;
+    QVERIFY(!parseBytes(QByteArray("definitely not a HEIF file"), tmp1).ok);
+
+    // every truncation parses to a plan that is unusable or consistent, never a crash
+    const QByteArray whole = gridFile(Options());
+    for (int n = 8; n < whole.size(); n += 7) {
+        QTemporaryFile tmp;
+        const HeicGrid::Plan plan = parseBytes(whole.left(n), tmp);
+        if (plan.gridOk()) QCOMPARE(plan.tiles.size(), plan.rows * plan.columns);
+    }
+}
+
+void TestHeicGrid::hvcCAndNals()
+{
+    QList<QByteArray> params;
+    int lengthSize = 0;
+    QVERIFY(HeicGrid::hvcCNals(hvcCRecord(), params, lengthSize));
+    QCOMPARE(lengthSize, 4);
+    QCOMPARE(params.size(), 3);
+    QCOMPARE(params.at(1), QByteArray("\x42\x01SPS!", 6));
+
+    params.clear();
+    QVERIFY(HeicGrid::hvcCNals(hvcCRecord(2), params, lengthSize));
+    QCOMPARE(lengthSize, 2);
+    params.clear();
+    QVERIFY(!HeicGrid::hvcCNals(hvcCRecord().left(30), params, lengthSize));
+
+    QByteArray data;
+    put16(data, 3);
+    data.append("abc");
+    put16(data, 1);
+    data.append("d");
+    QList<QByteArray> nals;
+    QVERIFY(HeicGrid::splitNals(data, 2, nals));
+    QCOMPARE(nals, QList<QByteArray>({"abc", "d"}));
+    nals.clear();
+    QVERIFY(!HeicGrid::splitNals(data.left(6), 2, nals));  // second NAL cut short
+}
+
+void TestHeicGrid::yuvConversion()
+{
+    // 2 x 2 luma, one chroma sample: libheif 1.5's fixed point full-range BT.601
+    const uchar y[4] = {0, 128, 200, 255};
+    const uchar cb[1] = {64};
+    const uchar cr[1] = {200};
+    QImage dst(2, 2, QImage::Format_RGB888);
+    dst.fill(Qt::black);
+    HeicGrid::yuv420ToRgb888(y, 2, cb, 1, cr, 1, 2, 2, HeicGrid::Rgb888(dst), 0, 0);
+    auto expect = [](int yv, int u, int v) {
+        u -= 128; v -= 128;
+        auto c = [](int x) { return qBound(0, x, 255); };
+        return qRgb(c(yv + ((359 * v) >> 8)), c(yv - ((88 * u + 183 * v) >> 8)),
+                    c(yv + ((454 * u) >> 8)));
+    };
+    QCOMPARE(dst.pixel(0, 0), expect(0, 64, 200));
+    QCOMPARE(dst.pixel(1, 0), expect(128, 64, 200));
+    QCOMPARE(dst.pixel(0, 1), expect(200, 64, 200));
+    QCOMPARE(dst.pixel(1, 1), expect(255, 64, 200));
+
+    // neutral chroma is grey
+    const uchar grey[4] = {90, 90, 90, 90};
+    const uchar mid[1] = {128};
+    HeicGrid::yuv420ToRgb888(grey, 2, mid, 1, mid, 1, 2, 2, HeicGrid::Rgb888(dst), 0, 0);
+    QCOMPARE(dst.pixel(1, 1), qRgb(90, 90, 90));
+}
+
+void TestHeicGrid::tilesClipToOutput()
+{
+    // a 4 x 4 tile written at (2, 2) of a 5 x 5 image: only its top-left 3 x 3 lands
+    QVector<uchar> y(16, 255), c(4, 128);
+    QImage dst(5, 5, QImage::Format_RGB888);
+    dst.fill(Qt::black);
+    HeicGrid::yuv420ToRgb888(y.constData(), 4, c.constData(), 2, c.constData(), 2, 4, 4,
+                             HeicGrid::Rgb888(dst), 2, 2);
+    for (int row = 0; row < 5; ++row)
+        for (int col = 0; col < 5; ++col)
+            QCOMPARE(dst.pixel(col, row), row >= 2 && col >= 2 ? qRgb(255, 255, 255) : qRgb(0, 0, 0));
+}
+
+void TestHeicGrid::transforms()
+{
+    QImage image(2, 1, QImage::Format_RGB888);
+    image.setPixel(0, 0, qRgb(255, 0, 0));
+    image.setPixel(1, 0, qRgb(0, 0, 255));
+
+    // a quarter turn counter-clockwise: the right end goes to the top
+    QImage r = HeicGrid::transformed(image, {{HeicGrid::Transform::Rotate, 1}});
+    QCOMPARE(r.size(), QSize(1, 2));
+    QCOMPARE(r.pixel(0, 0), qRgb(0, 0, 255));
+    QCOMPARE(r.pixel(0, 1), qRgb(255, 0, 0));
+
+    QImage m = HeicGrid::transformed(image, {{HeicGrid::Transform::Mirror, 0}});
+    QCOMPARE(m.pixel(0, 0), qRgb(0, 0, 255));
+
+    // irot then imir, in that order
+    QImage both = HeicGrid::transformed(image, {{HeicGrid::Transform::Rotate, 1},
+                                                {HeicGrid::Transform::Mirror, 1}});
+    QCOMPARE(both.pixel(0, 0), qRgb(255, 0, 0));
+    QCOMPARE(both.pixel(0, 1), qRgb(0, 0, 255));
+}
+
+QTEST_GUILESS_MAIN(TestHeicGrid)
+#include "tst_heicgrid.moc"
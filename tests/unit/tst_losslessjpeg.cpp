@@ -0,0 +1,339 @@
+/*
+    LosslessJpeg -- the lossless-JPEG (SOF3) decoder behind CR2 and compressed DNG.
+
+    The bitstreams are made here by a small independent encoder (canonical Huffman codes
+    from a BITS/HUFFVAL table, byte stuffing, the seven predictors), so every decode can be
+    checked against the samples that were encoded. Two tables are used: a compact one like
+    the Adobe DNG SDK writes, whose long codes still reach the canonical fallback behind
+    the lookup table, and a deep one with codes up to 16 bits.
+
+    tiledTiming prints a 24 MP tiled-DNG decode done the old way (each tile into an Image,
+    then copied into the mosaic, one after another) against DecodeInto on the thread pool;
+    nothing is asserted about the times, and ctest skips it.
+*/
+#include <QtTest>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "ImageFormats/Raw/losslessjpeg.h"
+#include "benchmark.h"
+
+namespace {
+
+/* DHT payload for one table: code length per SSSS symbol 0..16. */
+struct Table {
+    std::vector<int> length;    // length[ssss]
+};
+
+const Table compactTable{{3, 3, 3, 2, 3, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14}};
+const Table deepTable{{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 16, 16, 16}};
+
+struct Code { uint32_t bits; int len; };
+
+class BitWriter
+{
+public:
+    std::vector<uint8_t> &out;
+    uint32_t acc = 0;
+    int n = 0;
+
+    explicit BitWriter(std::vector<uint8_t> &o) : out(o) {}
+    void put(uint32_t v, int len)
+    {
+        for (int i = len - 1; i >= 0; --i) {
+            acc = (acc << 1) | ((v >> i) & 1);
+            if (++n == 8) flushByte();
+        }
+    }
+    void finish() { while (n) put(1, 1); }      // pad with 1-bits
+private:
+    void flushByte()
+    {
+        out.push_back(uint8_t(acc));
+        if (uint8_t(acc) == 0xFF) out.push_back(0x00);
+        acc = 0;
+        n = 0;
+    }
+};
+
+void put16(std::vector<uint8_t> &o, int v) { o.push_back(uint8_t(v >> 8)); o.push_back(uint8_t(v)); }
+
+/* Canonical codes in (length, symbol) order, as DHT defines them. */
+std::vector<Code> canonicalCodes(const Table &t, uint8_t counts[16], std::vector<uint8_t> &syms)
+{
+    std::fill(counts, counts + 16, 0);
+    syms.clear();
+    for (int l = 1; l <= 16; ++l)
+        for (int s = 0; s <= 16; ++s)
+            if (t.length[s] == l) { ++counts[l - 1]; syms.push_back(uint8_t(s)); }
+    std::vector<Code> codes(17);
+    uint32_t code = 0;
+    size_t k = 0;
+    for (int l = 1; l <= 16; ++l) {
+        for (int i = 0; i < counts[l - 1]; ++i) codes[syms[k++]] = Code{code++, l};
+        code <<= 1;
+    }
+    return codes;
+}
+
+int predict(int psv, int Ra, int Rb, int Rc)
+{
+    switch (psv) {
+    case 1: return Ra;
+    case 2: return Rb;
+    case 3: return Rc;
+    case 4: return Ra + Rb - Rc;
+    case 5: return Ra + ((Rb - Rc) >> 1);
+    case 6: return Rb + ((Ra - Rc) >> 1);
+    default: return (Ra + Rb) >> 1;
+    }
+}
+
+/* samples: X * Y * comps, interleaved, values < 2^prec with the low Pt bits clear. */
+std::vector<uint8_t> encode(const std::vector<uint16_t> &samples, int X, int Y, int comps,
+                            int prec, int psv, const Table &table, int Pt = 0)
+{
+    uint8_t counts[16];
+    std::vector<uint8_t> syms;
+    const std::vector<Code> codes = canonicalCodes(table, counts, syms);
+
+    std::vector<uint8_t> o = {0xFF, 0xD8};
+    o.insert(o.end(), {0xFF, 0xC4});                            // DHT, table 0
+    put16(o, 2 + 1 + 16 + int(syms.size()));
+    o.push_back(0x00);
+    o.insert(o.end(), counts, counts + 16);
+    o.insert(o.end(), syms.begin(), syms.end());
+    o.insert(o.end(), {0xFF, 0xC3});                            // SOF3
+    put16(o, 8 + 3 * comps);
+    o.push_back(uint8_t(prec));
+    put16(o, Y);
+    put16(o, X);
+    o.push_back(uint8_t(comps));
+    for (int c = 0; c < comps; ++c) o.insert(o.end(), {uint8_t(c + 1), 0x11, 0x00});
+    o.insert(o.end(), {0xFF, 0xDA});                            // SOS
+    put16(o, 6 + 2 * comps);
+    o.push_back(uint8_t(comps));
+    for (int c = 0; c < comps; ++c) o.insert(o.end(), {uint8_t(c + 1), 0x00});
+    o.insert(o.end(), {uint8_t(psv), 0x00, uint8_t(Pt)});
+
+    BitWriter bw(o);
+    const int def = 1 << (prec - Pt - 1);
+    auto at = [&](int x, int y, int c) { return samples[(size_t(y) * X + x) * comps + c] >> Pt; };
+    for (int y = 0; y < Y; ++y)
+        for (int x = 0; x < X; ++x)
+            for (int c = 0; c < comps; ++c) {
+                int pred;
+                if (x == 0) pred = y == 0 ? def : at(0, y - 1, c);
+                else if (y == 0) pred = at(x - 1, 0, c);
+                else pred = predict(psv, at(x - 1, y, c), at(x, y - 1, c), at(x - 1, y - 1, c));
+                int d = (at(x, y, c) - pred) & 0xFFFF;
+                if (d >= 32768) d -= 65536;
+                int ssss = 0;
+                for (int a = std::abs(d); a; a >>= 1) ++ssss;
+                bw.put(codes[ssss].bits, codes[ssss].len);
+                if (ssss && ssss < 16) bw.put(uint32_t(d > 0 ? d : d + (1 << ssss) - 1), ssss);
+            }
+    bw.finish();
+    o.insert(o.end(), {0xFF, 0xD9});
+    return o;
+}
+
+/* A smooth random walk with occasional large jumps, so every SSSS category occurs. */
+std::vector<uint16_t> makeSamples(int X, int Y, int comps, int prec, int Pt, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    const int maxV = (1 << prec) - 1;
+    std::vector<uint16_t> s(size_t(X) * Y * comps);
+    int v = maxV / 3;
+    for (uint16_t &x : s) {
+        if (rng() % 17 == 0) v = int(rng() % uint32_t(maxV + 1));
+        else v = std::clamp(v + int(rng() % 65) - 32, 0, maxV);
+        x = uint16_t((v >> Pt) << Pt);
+    }
+    return s;
+}
+
+} // namespace
+
+class TestLosslessJpeg : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decodeRoundTrip_data();
+    void decodeRoundTrip();
+    void pointTransform();
+    void decodeRowsInOrder();
+    void decodeIntoClipsToTarget();
+    void rejectsRestartIntervals();
+    void tiledTiming();
+};
+
+void TestLosslessJpeg::decodeRoundTrip_data()
+{
+    QTest::addColumn<int>("comps");
+    QTest::addColumn<int>("prec");
+    QTest::addColumn<int>("psv");
+    QTest::addColumn<bool>("deep");
+    for (const int comps : {1, 2, 4})
+        for (const int prec : {12, 14, 16})
+            for (int psv = 1; psv <= 7; ++psv)
+                for (const bool deep : {false, true})
+                    QTest::addRow("c%d p%d psv%d %s", comps, prec, psv, deep ? "deep" : "compact")
+                        << comps << prec << psv << deep;
+}
+
+void TestLosslessJpeg::decodeRoundTrip()
+{
+    QFETCH(int, comps);
+    QFETCH(int, prec);
+    QFETCH(int, psv);
+    QFETCH(bool, deep);
+    const int X = 37, Y = 13;
+    const std::vector<uint16_t> src = makeSamples(X, Y, comps, prec, 0, unsigned(comps * 100 + prec * 10 + psv));
+    const std::vector<uint8_t> jpg = encode(src, X, Y, comps, prec, psv, deep ? deepTable : compactTable);
+
+    LosslessJpeg::Image im;
+    QString err;
+    QVERIFY2(LosslessJpeg::Decode(jpg.data(), jpg.size(), im, &err), qPrintable(err));
+    QVERIFY(im.isValid());
+    QCOMPARE(im.width, X);
+    QCOMPARE(im.height, Y);
+    QCOMPARE(im.components, comps);
+    QCOMPARE(im.precision, prec);
+    QVERIFY(im.samples == src);
+}
+
+void TestLosslessJpeg::pointTransform()
+{
+    const int X = 20, Y = 9;
+    const std::vector<uint16_t> src = makeSamples(X, Y, 2, 14, 2, 7);
+    const std::vector<uint8_t> jpg = encode(src, X, Y, 2, 14, 1, compactTable, 2);
+    LosslessJpeg::Image im;
+    QVERIFY(LosslessJpeg::Decode(jpg.data(), jpg.size(), im));
+    QVERIFY(im.samples == src);
+}
+
+void TestLosslessJpeg::decodeRowsInOrder()
+{
+    const int X = 31, Y = 17, comps = 4;
+    const std::vector<uint16_t> src = makeSamples(X, Y, comps, 14, 0, 11);
+    const std::vector<uint8_t> jpg = encode(src, X, Y, comps, 14, 1, compactTable);
+
+    std::vector<uint16_t> got;
+    int nextRow = 0;
+    bool inOrder = true;
+    const bool ok = LosslessJpeg::DecodeRows(jpg.data(), jpg.size(),
+        [&](int y, const uint16_t *line, int n) {
+            inOrder = inOrder && y == nextRow && n == X * comps;
+            got.insert(got.end(), line, line + n);
+            ++nextRow;
+        });
+    QVERIFY(ok);
+    QVERIFY(inOrder);
+    QCOMPARE(nextRow, Y);
+    QVERIFY(got == src);
+
+    LosslessJpeg::Image frame;
+    QVERIFY(LosslessJpeg::ReadFrame(jpg.data(), jpg.size(), frame));
+    QCOMPARE(frame.width, X);
+    QCOMPARE(frame.height, Y);
+    QCOMPARE(frame.components, comps);
+    QVERIFY(frame.samples.empty());
+}
+
+void TestLosslessJpeg::decodeIntoClipsToTarget()
+{
+    // a 2-component 20 x 32 tile (40 x 32 mosaic samples) overhanging a 100 x 70 mosaic
+    const int W = 100, H = 70, X = 20, Y = 32, comps = 2, gx = 80, gy = 64;
+    const std::vector<uint16_t> src = makeSamples(X, Y, comps, 14, 0, 5);
+    const std::vector<uint8_t> jpg = encode(src, X, Y, comps, 14, 1, compactTable);
+
+    const uint16_t sentinel = 0xBEEF;
+    std::vector<uint16_t> cfa(size_t(W) * H, sentinel);
+    LosslessJpeg::Target t;
+    t.dst = cfa.data();
+    t.stride = W;
+    t.width = W;
+    t.height = H;
+    t.x0 = gx;
+    t.y0 = gy;
+    QVERIFY(LosslessJpeg::DecodeInto(jpg.data(), jpg.size(), t));
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x) {
+            const bool inside = x >= gx && y >= gy;
+            const uint16_t want = inside ? src[size_t(y - gy) * X * comps + (x - gx)] : sentinel;
+            QVERIFY2(cfa[size_t(y) * W + x] == want, qPrintable(QString("at %1,%2").arg(x).arg(y)));
+        }
+}
+
+void TestLosslessJpeg::rejectsRestartIntervals()
+{
+    const std::vector<uint16_t> src = makeSamples(8, 4, 1, 12, 0, 3);
+    std::vector<uint8_t> jpg = encode(src, 8, 4, 1, 12, 1, compactTable);
+    jpg.insert(jpg.begin() + 2, {0xFF, 0xDD, 0x00, 0x04, 0x00, 0x01});     // DRI 1
+    LosslessJpeg::Image im;
+    QString err;
+    QVERIFY(!LosslessJpeg::Decode(jpg.data(), jpg.size(), im, &err));
+    QVERIFY(!err.isEmpty());
+}
+
+void TestLosslessJpeg::tiledTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    // 6016 x 4016 sensor in 256 x 256 tiles, 2 components per tile as DNG writers use
+    const int W = 6016, H = 4016, tile = 256, comps = 2;
+    const int across = (W + tile - 1) / tile, down = (H + tile - 1) / tile;
+    std::vector<std::vector<uint8_t>> tiles(size_t(across) * down);
+    std::vector<uint16_t> expect(size_t(W) * H, 0);
+    for (int i = 0; i < int(tiles.size()); ++i) {
+        const std::vector<uint16_t> src = makeSamples(tile / comps, tile, comps, 14, 0, unsigned(i));
+        tiles[i] = encode(src, tile / comps, tile, comps, 14, 1, compactTable);
+        const int gx = (i % across) * tile, gy = (i / across) * tile;
+        for (int y = 0; y < tile && gy + y < H; ++y)
+            for (int x = 0; x < tile && gx + x < W; ++x)
+                expect[size_t(gy + y) * W + gx + x] = src[size_t(y) * tile + x];
+    }
+
+    QElapsedTimer t;
+    std::vector<uint16_t> cfa(size_t(W) * H, 0);
+    t.start();
+    for (int i = 0; i < int(tiles.size()); ++i) {
+        LosslessJpeg::Image im;
+        QVERIFY(LosslessJpeg::Decode(tiles[i].data(), tiles[i].size(), im));
+        const int gx = (i % across) * tile, gy = (i / across) * tile;
+        for (int y = 0; y < im.height && gy + y < H; ++y)
+            for (int x = 0; x < im.width * comps && gx + x < W; ++x)
+                cfa[size_t(gy + y) * W + gx + x] = im.samples[size_t(y) * im.width * comps + x];
+    }
+    const qint64 serialMs = t.elapsed();
+    QVERIFY(cfa == expect);
+
+    std::fill(cfa.begin(), cfa.end(), 0);
+    std::vector<int> index(tiles.size());
+    std::iota(index.begin(), index.end(), 0);
+    t.restart();
+    QtConcurrent::blockingMap(index, [&](int i) {
+        LosslessJpeg::Target tt;
+        tt.dst = cfa.data();
+        tt.stride = W;
+        tt.width = W;
+        tt.height = H;
+        tt.x0 = (i % across) * tile;
+        tt.y0 = (i / across) * tile;
+        LosslessJpeg::DecodeInto(tiles[i].data(), tiles[i].size(), tt);
+    });
+    const qint64 parallelMs = t.elapsed();
+    QVERIFY(cfa == expect);
+
+    qInfo().noquote() << QString("24 MP tiled: Decode + place %1 ms, DecodeInto on %2 threads %3 ms")
+                         .arg(serialMs).arg(QThreadPool::globalInstance()->maxThreadCount())
+                         .arg(parallelMs);
+}
+
+QTEST_GUILESS_MAIN(TestLosslessJpeg)
+#include "tst_losslessjpeg.moc"
@@ -0,0 +1,105 @@
+/*
+    MappedFile -- the one read-only view of a RAW file that every UnpackCfa decodes from.
+
+    The decoders trust at() to refuse any range that is not wholly inside the file and
+    read() to clip like QFile::read, so those edges are what is checked here.
+*/
+#include <QtTest>
+#include <QTemporaryFile>
+#include <cstring>
+#include <limits>
+#include "ImageFormats/Raw/mappedfile.h"
+
+class TestMappedFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void mapsLocalFile();
+    void atRejectsOutOfRange();
+    void availableAndRead();
+    void willNeedIsHarmless();
+    void emptyFileIsInvalid();
+
+private:
+    QTemporaryFile tmp;
+    QByteArray bytes;
+};
+
+void TestMappedFile::initTestCase()
+{
+    bytes.resize(10000);
+    for (int i = 0; i < bytes.size(); ++i) bytes[i] = char(i * 31 + 7);
+    QVERIFY(tmp.open());
+    QCOMPARE(tmp.write(bytes), qint64(bytes.size()));
+    QVERIFY(tmp.flush());
+    tmp.close();
+}
+
+void TestMappedFile::mapsLocalFile()
+{
+    QFile f(tmp.fileName());
+    const MappedFile mf(f);
+    QVERIFY(mf.isValid());
+    QVERIFY(mf.isMapped());
+    QCOMPARE(mf.size(), qint64(bytes.size()));
+    QVERIFY(memcmp(mf.data(), bytes.constData(), size_t(bytes.size())) == 0);
+}
+
+void TestMappedFile::atRejectsOutOfRange()
+{
+    QFile f(tmp.fileName());
+    const MappedFile mf(f);
+    const qint64 n = mf.size();
+    QCOMPARE(mf.at(0, n), mf.data());
+    QCOMPARE(mf.at(n - 4, 4), mf.data() + n - 4);
+    QCOMPARE(mf.at(n, 0), mf.data() + n);
+    QVERIFY(mf.at(n - 4, 5) == nullptr);
+    QVERIFY(mf.at(n + 1, 0) == nullptr);
+    QVERIFY(mf.at(-1, 2) == nullptr);
+    QVERIFY(mf.at(4, -1) == nullptr);
+    QVERIFY(mf.at(1, std::numeric_limits<qint64>::max()) == nullptr);
+}
+
+void TestMappedFile::availableAndRead()
+{
+    QFile f(tmp.fileName());
+    const MappedFile mf(f);
+    const qint64 n = mf.size();
+    QCOMPARE(mf.available(0), n);
+    QCOMPARE(mf.available(n - 10), qint64(10));
+    QCOMPARE(mf.available(n), qint64(0));
+    QCOMPARE(mf.available(-5), qint64(0));
+
+    QCOMPARE(mf.read(100, 16), bytes.mid(100, 16));
+    QCOMPARE(mf.read(n - 3, 16), bytes.right(3));       // clipped, like QFile::read
+    QVERIFY(mf.read(n + 8, 4).isEmpty());
+}
+
+void TestMappedFile::willNeedIsHarmless()
+{
+    /* Only a hint: unaligned, past-the-end and empty ranges must all be accepted. */
+    QFile f(tmp.fileName());
+    const MappedFile mf(f);
+    mf.willNeed(0, mf.size());
+    mf.willNeed(4097, 123);
+    mf.willNeed(mf.size() - 1, 1000);
+    mf.willNeed(mf.size() + 10, 10);
+    mf.willNeed(5, 0);
+    QCOMPARE(mf.read(0, 4), bytes.left(4));
+}
+
+void TestMappedFile::emptyFileIsInvalid()
+{
+    QTemporaryFile empty;
+    QVERIFY(empty.open());
+    const MappedFile mf(empty);
+    QVERIFY(!mf.isValid());
+    QVERIFY(mf.at(0, 0) == nullptr);
+    QCOMPARE(mf.available(0), qint64(0));
+    QVERIFY(mf.read(0, 4).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestMappedFile)
+#include "tst_mappedfile.moc"
@@ -14,9 +14,11 @@
 */
 #include <QtTest>
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include "Develop/outputtransform.h"
 #include "Develop/workingimage.h"
+#include "Utilities/simd.h"
 
 namespace {
 
@@ -76,6 +78,8 @@ private slots:
     void displayReferredMatchesExactWithinOne();
     void blackAndWhiteAreExact();
     void overRangeSaturatesToWhite();
+    void simdMatchesScalar();
+    void rgb32MatchesRgb888();
 
 private:
     /* Renders `img` and compares every byte with the reference. Returns the worst
@@ -179,5 +183,67 @@ void TestOutputTransform::overRangeSaturatesToWhite()
     QVERIFY(int(line[2]) == 255);
 }
 
+/* The vectorised table pack (LutRow) must be BIT-EXACT with the scalar LutSample it
+   stands in for, at every level this CPU runs: the table's accuracy bound above is
+   measured on the scalar path only. Odd widths exercise the scalar tail, NaN and the
+   clamped ends the masks, and one over-range display-referred row the -1 fallback. */
+void TestOutputTransform::simdMatchesScalar()
+{
+    using Winnow::Simd::Level;
+    for (const bool scene : {true, false}) {
+        for (const int w : {1, 5, 333}) {
+            WorkingImage img = makeRamp(w, 40, scene ? 5.0f : 1.0f, scene);
+            img.rgb[5] = std::nanf("");
+            img.rgb[7] = -0.25f;
+            if (!scene) img.rgb[size_t(w) * 3 * 10 + 1] = 1.5f;
+
+            OutputTransform t;
+            QImage ref;
+            QVERIFY(Winnow::Simd::setLevel(Level::Scalar));
+            QVERIFY(t.ToImage(img, ref));
+            for (const Level l : {Level::SSE41, Level::AVX2, Level::NEON}) {
+                if (!Winnow::Simd::setLevel(l)) continue;      // not this CPU
+                QImage out;
+                QVERIFY(t.ToImage(img, out));
+                for (int y = 0; y < img.height; ++y) {
+                    QVERIFY2(std::memcmp(out.constScanLine(y), ref.constScanLine(y), size_t(w) * 3) == 0,
+                             qPrintable(QString("%1 row %2 width %3 scene %4")
+                                        .arg(Winnow::Simd::name(l)).arg(y).arg(w).arg(scene)));
+                }
+            }
+            Winnow::Simd::resetLevel();
+        }
+    }
+}
+
+/* The image cache's format (RGB32, widened in place row by row) carries the same bytes as
+   RGB888, on the table path and the exact one (a non-sRGB space), alpha opaque. */
+void TestOutputTransform::rgb32MatchesRgb888()
+{
+    using Space = OutputTransform::Space;
+    for (const Space space : {Space::sRGB, Space::AdobeRGB}) {
+        for (const int w : {1, 5, 333}) {
+            const WorkingImage img = makeRamp(w, 40, 5.0f, true);
+            OutputTransform t;
+            QImage packed, wide;
+            QVERIFY(t.ToImage(img, packed, space));
+            QVERIFY(t.ToImage(img, wide, space, QImage::Format_RGB32));
+            QCOMPARE(wide.format(), QImage::Format_RGB32);
+            QCOMPARE(wide.size(), packed.size());
+            for (int y = 0; y < img.height; ++y) {
+                const uchar *p = packed.constScanLine(y);
+                const QRgb *q = reinterpret_cast<const QRgb *>(wide.constScanLine(y));
+                for (int x = 0; x < w; ++x) {
+                    QVERIFY2(q[x] == qRgb(p[x * 3], p[x * 3 + 1], p[x * 3 + 2]),
+                             qPrintable(QString("x %1 y %2 width %3").arg(x).arg(y).arg(w)));
+                }
+            }
+        }
+    }
+    QImage rejected;
+    QVERIFY(!OutputTransform().ToImage(makeRamp(4, 4, 1.0f, true), rejected, Space::sRGB,
+                                       QImage::Format_ARGB32));
+}
+
 QTEST_MAIN(TestOutputTransform)
 #include "tst_outputtransform.moc"
@@ -0,0 +1,322 @@
+/*
+    PointKernels -- Develop's fused point pass (gain, calibration, tone curve, HSL, grade)
+    over planar rows, and the Pow it encodes with.
+
+    Every SIMD level must be BIT-EXACT with the scalar reference (the tst_rawkernels
+    contract), for every combination of blocks the pass can run and at widths that leave a
+    scalar tail; the interleaved entry point must give exactly what the planar one does.
+    Pow replaces std::pow in the pass, so its error against std::pow is bounded here, well
+    inside what the 1024-entry tone table resolves.
+
+    sliderTickTiming is the benchmark: what one slider-drag tick costs -- the point pass
+    over the frame, then the 8-bit pack the loupe shows -- in Mpix/s at each level, for a
+    proxy-sized frame and a 45 MP one. Nothing is asserted about it; ctest skips it.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QImage>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Develop/outputtransform.h"
+#include "Develop/pointkernels.h"
+#include "Develop/workingimage.h"
+#include "benchmark.h"
+
+using Winnow::Simd::Level;
+using PointKernels::Coeffs;
+
+namespace {
+
+const Level simdLevels[] = {Level::SSE41, Level::AVX2, Level::NEON};
+
+bool sameBits(float a, float b)
+{
+    return std::memcmp(&a, &b, 4) == 0;
+}
+
+/* Coefficients shaped like buildPointCoeffs' output, every block switched on: a warm
+   gain, a calibration matrix that fixes neutrals, an S-curve whose per-channel tables
+   differ, a hue turn with saturation and vibrance, and a three-way grade. */
+Coeffs allBlocks(float white)
+{
+    Coeffs c;
+    c.active = true;
+    c.white = white;
+    c.channelGain[0] = 1.31f; c.channelGain[1] = 1.0f; c.channelGain[2] = 0.77f;
+
+    c.toneActive = true;
+    c.toneLutSMax = std::pow(8.0f, c.invGamma);
+    for (int j = 0; j < Coeffs::kLutSize; ++j) {
+        const float s = c.toneLutSMax * j / (Coeffs::kLutSize - 1);
+        const float sc = s + 0.12f * std::sin(6.2831853f * s) * std::exp(-s);
+        for (int ch = 0; ch < 3; ++ch)
+            c.toneLut[ch][j] = std::pow(std::max(0.0f, sc * (1.0f + 0.03f * ch)), 2.2f);
+    }
+
+    c.calActive = true;
+    const float cal[9] = {1.08f, -0.05f, -0.03f, -0.02f, 1.04f, -0.02f, 0.01f, -0.09f, 1.08f};
+    std::memcpy(c.calMat, cal, sizeof cal);
+
+    c.hslActive = true;
+    const float a = 0.3f, cs = std::cos(a), sn = std::sin(a);
+    const float k = (1.0f - cs) / 3.0f, w = sn * 0.57735027f;
+    const float hue[9] = {cs + k, k - w, k + w, k + w, cs + k, k - w, k - w, k + w, cs + k};
+    std::memcpy(c.hueMat, hue, sizeof hue);
+    c.satFactor = 1.2f;
+    c.vibAmount = 0.45f;
+    c.lumGain = 1.05f;
+
+    c.gradeActive = true;
+    const float tint[4][3] = {{-0.02f, 0.01f, 0.05f}, {0.01f, 0.0f, -0.01f},
+                              {0.04f, 0.01f, -0.06f}, {0.005f, -0.004f, 0.0f}};
+    std::memcpy(c.gradeTint, tint, sizeof tint);
+    c.gradeLum[0] = 0.1f; c.gradeLum[1] = -0.05f; c.gradeLum[2] = 0.08f; c.gradeLum[3] = 0.02f;
+    c.gradeShadowEnd = 0.42f;
+    c.gradeHighStart = 0.61f;
+    return c;
+}
+
+/* The variants the pass switches between: each block alone, vibrance off, all on. */
+std::vector<std::pair<const char *, Coeffs>> variants()
+{
+    std::vector<std::pair<const char *, Coeffs>> v;
+    const Coeffs all = allBlocks(1.0f);
+    v.push_back({"all", all});
+    v.push_back({"all, white 4", allBlocks(4.0f)});
+    Coeffs c = all;
+    c.calActive = c.toneActive = c.hslActive = c.gradeActive = false;
+    v.push_back({"gain", c});
+    c = all;
+    c.calActive = c.hslActive = c.gradeActive = false;
+    v.push_back({"tone", c});
+    c = all;
+    c.vibAmount = 0.0f;
+    v.push_back({"no vibrance", c});
+    c = all;
+    c.vibAmount = -1.0f;
+    c.satFactor = 0.4f;
+    v.push_back({"negative vibrance", c});
+    c = all;
+    c.toneActive = c.hslActive = false;
+    v.push_back({"grade", c});
+    return v;
+}
+
+/* Scene-linear samples from deep shadow to past the tone table's top, plus the values the
+   masks have to route: zeros of both signs, negatives, NaN, infinities, a denormal. */
+std::vector<float> samples(size_t n, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> ev(-18.0f, 5.0f);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    std::vector<float> v(n);
+    for (float &x : v) x = std::exp2(ev(rng)) * (u(rng) < 0.05f ? -1.0f : 1.0f);
+    const float special[] = {0.0f, -0.0f, -0.3f, NAN, INFINITY, -INFINITY, 1e-40f, 1.0f,
+                             8.0f, 40.0f, 1e-6f, 0.18f};
+    for (size_t i = 0; i < n && i < 4 * std::size(special); i += 4)
+        v[i] = special[i / 4];
+    return v;
+}
+
+struct Planes { std::vector<float> r, g, b; };
+
+Planes planes(size_t n, uint32_t seed)
+{
+    return {samples(n, seed), samples(n, seed + 1), samples(n, seed + 2)};
+}
+
+/* A scene-linear frame for the tick benchmark: a lit ramp with texture. */
+WorkingImage makeFrame(int w, int h)
+{
+    WorkingImage img;
+    img.width = w; img.height = h; img.white = 1.0f; img.sceneReferred = true;
+    img.rgb.resize(size_t(w) * h * 3);
+    uint32_t s = 1;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            s = s * 1664525u + 1013904223u;
+            const float n = 0.9f + 0.2f * ((s >> 8) & 0xffff) / 65535.0f;
+            const float v = std::exp2(-8.0f + 10.0f * x / w) * (0.3f + 0.7f * y / h) * n;
+            const size_t i = (size_t(y) * w + x) * 3;
+            img.rgb[i] = v; img.rgb[i + 1] = 0.85f * v; img.rgb[i + 2] = 0.7f * v;
+        }
+    }
+    return img;
+}
+
+/* The point pass over the frame in row bands across the global pool, the way Develop's
+   tile pass spreads it. */
+void applyFrame(WorkingImage &img, const Coeffs &c, Level level)
+{
+    constexpr int kBand = 64;
+    const int bands = (img.height + kBand - 1) / kBand;
+    std::atomic<int> next{0};
+    auto run = [&]() {
+        for (int b = next.fetch_add(1); b < bands; b = next.fetch_add(1)) {
+            const int y1 = qMin(img.height, (b + 1) * kBand);
+            for (int y = b * kBand; y < y1; ++y)
+                PointKernels::ApplyInterleaved(img.rgb.data() + size_t(y) * img.width * 3,
+                                               img.width, c, level);
+        }
+    };
+    QVector<QFuture<void>> futures;
+    const int threads = qMin(bands, QThreadPool::globalInstance()->maxThreadCount());
+    for (int k = 1; k < threads; ++k)
+        futures.append(QtConcurrent::run(QThreadPool::globalInstance(), run));
+    run();
+    for (QFuture<void> &f : futures) f.waitForFinished();
+}
+
+} // namespace
+
+class TestPointKernels : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void everyLevelMatchesScalar();
+    void interleavedMatchesPlanar();
+    void powMatchesStdPow();
+    void powEdges();
+    void sliderTickTiming();
+};
+
+void TestPointKernels::everyLevelMatchesScalar()
+{
+    for (const auto &[name, c] : variants()) {
+        for (const int n : {1, 3, 7, 8, 9, 15, 16, 17, 100, 4099}) {
+            const Planes ref0 = planes(size_t(n), 11);
+            Planes ref = ref0;
+            PointKernels::Apply(ref.r.data(), ref.g.data(), ref.b.data(), n, c, Level::Scalar);
+            for (const Level l : simdLevels) {
+                if (!Winnow::Simd::supported(l)) continue;
+                Planes got = ref0;
+                PointKernels::Apply(got.r.data(), got.g.data(), got.b.data(), n, c, l);
+                for (int i = 0; i < n; ++i) {
+                    const bool same = sameBits(got.r[i], ref.r[i]) &&
+                                      sameBits(got.g[i], ref.g[i]) &&
+                                      sameBits(got.b[i], ref.b[i]);
+                    QVERIFY2(same, qPrintable(QString("%1, %2, n %3, pixel %4: in (%5 %6 %7) "
+                                                      "got (%8 %9 %10) want (%11 %12 %13)")
+                        .arg(name, Winnow::Simd::name(l)).arg(n).arg(i)
+                        .arg(ref0.r[i]).arg(ref0.g[i]).arg(ref0.b[i])
+                        .arg(got.r[i]).arg(got.g[i]).arg(got.b[i])
+                        .arg(ref.r[i]).arg(ref.g[i]).arg(ref.b[i])));
+                }
+            }
+        }
+    }
+}
+
+void TestPointKernels::interleavedMatchesPlanar()
+{
+    /* Wider than a planar run, and not a multiple of one. */
+    const int n = 3 * PointKernels::kChunk + 5;
+    const Coeffs c = allBlocks(1.0f);
+    for (const Level l : {Level::Scalar, Level::SSE41, Level::AVX2, Level::NEON}) {
+        if (!Winnow::Simd::supported(l)) continue;
+        Planes p = planes(size_t(n), 23);
+        std::vector<float> rgb(size_t(n) * 3);
+        for (int i = 0; i < n; ++i) {
+            rgb[3 * i] = p.r[i]; rgb[3 * i + 1] = p.g[i]; rgb[3 * i + 2] = p.b[i];
+        }
+        PointKernels::Apply(p.r.data(), p.g.data(), p.b.data(), n, c, l);
+        PointKernels::ApplyInterleaved(rgb.data(), n, c, l);
+        for (int i = 0; i < n; ++i) {
+            QVERIFY2(sameBits(rgb[3 * i], p.r[i]) && sameBits(rgb[3 * i + 1], p.g[i]) &&
+                     sameBits(rgb[3 * i + 2], p.b[i]),
+                     qPrintable(QString("%1 pixel %2").arg(Winnow::Simd::name(l)).arg(i)));
+        }
+    }
+}
+
+void TestPointKernels::powMatchesStdPow()
+{
+    /* The encode exponent and a spread of others, over the range the pass feeds it: the
+       tone table's [0, 8] and everything down to far below one 16-bit step. */
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> ev(-27.0f, 14.0f);
+    double worst = 0.0;
+    for (const float p : {1.0f / 2.2f, 1.0f / 2.4f, 0.25f, 0.5f, 0.75f, 1.0f}) {
+        for (int i = 0; i < 200000; ++i) {
+            const float x = std::exp2(ev(rng));
+            const double want = std::pow(double(x), double(p));
+            worst = std::max(worst, std::fabs(PointKernels::Pow(x, p) - want) / want);
+        }
+    }
+    QVERIFY2(worst <= 2e-6, qPrintable(QString::number(worst)));
+}
+
+void TestPointKernels::powEdges()
+{
+    const float p = 1.0f / 2.2f;
+    QCOMPARE(PointKernels::Pow(1.0f, p), 1.0f);
+    QCOMPARE(PointKernels::Pow(0.0f, p), 0.0f);
+    QCOMPARE(PointKernels::Pow(-0.0f, p), 0.0f);
+    QCOMPARE(PointKernels::Pow(-2.0f, p), 0.0f);
+    QCOMPARE(PointKernels::Pow(1e-31f, p), 0.0f);
+    QCOMPARE(PointKernels::Pow(NAN, p), 0.0f);
+    QVERIFY(std::isfinite(PointKernels::Pow(INFINITY, p)));
+    QCOMPARE(PointKernels::Pow(INFINITY, p), PointKernels::Pow(1e30f, p));
+    /* Monotonic across the [sqrt(1/2), sqrt(2)) mantissa fold, where the series meet. */
+    float x = 1.41421f, prev = PointKernels::Pow(x, p);
+    for (int i = 0; i < 200; ++i) {
+        x = std::nextafter(x, 2.0f);
+        const float v = PointKernels::Pow(x, p);
+        QVERIFY(v >= prev);
+        prev = v;
+    }
+}
+
+void TestPointKernels::sliderTickTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const Coeffs c = allBlocks(1.0f);
+    struct Size { const char *name; int w, h; };
+    const Size sizes[] = {{"proxy", 2560, 1707}, {"full", 8256, 5504}};
+
+    qInfo().noquote() << "tick = point pass + 8-bit pack, all threads; kernel = one thread";
+    qInfo().noquote() << "size    level     kernel Mpix/s   tick Mpix/s   tick ms";
+    for (const Size &s : sizes) {
+        const WorkingImage src = makeFrame(s.w, s.h);
+        const double mp = double(s.w) * s.h / 1e6;
+        for (const Level l : {Level::Scalar, Level::SSE41, Level::AVX2, Level::NEON}) {
+            if (!Winnow::Simd::setLevel(l)) continue;
+
+            /* One thread, a few hundred rows: the kernel's own rate. */
+            WorkingImage img = src;
+            const int rows = qMin(s.h, 400);
+            QElapsedTimer t;
+            t.start();
+            for (int y = 0; y < rows; ++y)
+                PointKernels::ApplyInterleaved(img.rgb.data() + size_t(y) * s.w * 3, s.w, c, l);
+            const double kernelSec = qMax<qint64>(1, t.nsecsElapsed()) / 1e9;
+
+            /* The tick, as the loupe sees it. */
+            img = src;
+            OutputTransform out;
+            QImage shown;
+            t.restart();
+            applyFrame(img, c, l);
+            out.ToImage(img, shown);
+            const qint64 tickNs = qMax<qint64>(1, t.nsecsElapsed());
+
+            qInfo().noquote() << QString("%1  %2  %3  %4  %5")
+                                 .arg(s.name, -6).arg(Winnow::Simd::name(l), -8)
+                                 .arg(double(rows) * s.w / 1e6 / kernelSec, 13, 'f', 0)
+                                 .arg(mp / (tickNs / 1e9), 12, 'f', 0)
+                                 .arg(tickNs / 1e6, 9, 'f', 1);
+        }
+        Winnow::Simd::resetLevel();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPointKernels)
+#include "tst_pointkernels.moc"
@@ -0,0 +1,298 @@
+/*
+    PointLut -- Develop's point chain baked into a 3D table for the interactive renders
+    (Develop::setPointPath).
+
+    The table is an approximation of the direct kernel, so the bounds it was accepted under
+    are asserted here the way tst_halfimage asserts binary16's: each point panel's chain,
+    and all of them together, rendered both ways through OutputTransform. The panels that
+    act per channel must agree to two 8-bit codes; HSL and the grade, which clamp mixed
+    channels at 0 inside a lattice cell, are held to a small mean and a bounded tail.
+    Pixels outside the table (a negative channel, past kRange x white, NaN) must come back
+    from the direct kernel bit for bit, a frame too small to bake must be left to the
+    direct path entirely, and every SIMD level must match the scalar reference to the bit.
+
+    lutTiming prints what the point pass costs both ways on a proxy-sized frame and a
+    45 MP one; nothing is asserted about it, and it only runs on request.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QImage>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Develop/develop.h"
+#include "Develop/outputtransform.h"
+#include "Develop/pointlut.h"
+#include "Develop/workingimage.h"
+#include "benchmark.h"
+
+using Winnow::Simd::Level;
+using PointPath = Develop::PointPath;
+
+namespace {
+
+const Level simdLevels[] = {Level::SSE41, Level::AVX2, Level::NEON};
+
+bool sameBits(float a, float b)
+{
+    if (std::isnan(a) && std::isnan(b)) return true;
+    return std::memcmp(&a, &b, 4) == 0;
+}
+
+/* Scene-linear colours spread over the whole table domain: each channel drawn
+   independently, squared so the shadows are as well covered as the lattice covers them,
+   over smooth ramps so banding would show. A scene-referred frame reaches past white. */
+WorkingImage makeScene(int w, int h, bool sceneReferred, unsigned seed = 3)
+{
+    WorkingImage img;
+    img.width = w; img.height = h; img.white = 1.0f;
+    img.sceneReferred = sceneReferred;
+    img.rgb.resize(size_t(w) * h * 3);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    const float top = sceneReferred ? 4.0f : 1.0f;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const size_t i = (size_t(y) * w + x) * 3;
+            if (y < h / 2) {                                 // random colours
+                for (int ch = 0; ch < 3; ++ch) {
+                    const float e = u(rng);
+                    img.rgb[i + ch] = top * e * e;
+                }
+            }
+            else {                                           // ramps with a slow hue turn
+                const float e = float(x) / float(w - 1);
+                const float a = 6.2831853f * float(y) / float(h);
+                const float v = top * e * e;
+                img.rgb[i + 0] = v * (0.75f + 0.25f * std::cos(a));
+                img.rgb[i + 1] = v * (0.75f + 0.25f * std::cos(a + 2.0944f));
+                img.rgb[i + 2] = v * (0.75f + 0.25f * std::cos(a + 4.1888f));
+            }
+        }
+    }
+    return img;
+}
+
+struct Recipe { const char *name; EditParams p; };
+
+/* Each point panel's sliders, well off their defaults. */
+struct Panel { const char *name; void (*set)(EditParams &); };
+
+const Panel panels[] = {
+    {"whiteBalance", [](EditParams &p) { p.temp = 25.0f; p.tint = -10.0f; p.exposure = 0.7f; }},
+    {"toneRegions", [](EditParams &p) {
+        p.contrast = 40.0f; p.highlights = -60.0f; p.shadows = 50.0f;
+        p.whites = 20.0f; p.blacks = -30.0f;
+    }},
+    {"curves", [](EditParams &p) {
+        p.curveN[0] = 4;                                     // RGB composite: an S
+        p.curveX[0][1] = 0.25f; p.curveY[0][1] = 0.18f;
+        p.curveX[0][2] = 0.75f; p.curveY[0][2] = 0.84f;
+        p.curveX[0][3] = 1.0f;  p.curveY[0][3] = 1.0f;
+        p.curveN[1] = 3;                                     // red lifted
+        p.curveX[1][1] = 0.5f;  p.curveY[1][1] = 0.58f;
+        p.curveX[1][2] = 1.0f;  p.curveY[1][2] = 1.0f;
+    }},
+    {"colorRgb", [](EditParams &p) { p.red = 20.0f; p.blue = -15.0f; }},
+    {"hsl", [](EditParams &p) {
+        p.hue = 15.0f; p.saturation = 30.0f; p.vibrance = 40.0f; p.luminance = 10.0f;
+    }},
+    {"calibrate", [](EditParams &p) {
+        p.calRedHue = 20.0f; p.calRedSat = 30.0f; p.calGreenHue = -15.0f;
+        p.calBlueSat = -25.0f;
+    }},
+    {"colorGrade", [](EditParams &p) {
+        p.gradeShadowHue = 220.0f; p.gradeShadowSat = 0.4f;
+        p.gradeHighHue = 40.0f; p.gradeHighSat = 0.3f; p.gradeMidLum = 10.0f;
+        p.gradeGlobalHue = 120.0f; p.gradeGlobalSat = 0.1f;
+    }},
+};
+
+/* One recipe per panel, then all of them at once. */
+std::vector<Recipe> recipes()
+{
+    std::vector<Recipe> r;
+    EditParams all;
+    for (const Panel &panel : panels) {
+        EditParams p;
+        panel.set(p);
+        panel.set(all);
+        r.push_back({panel.name, p});
+    }
+    r.push_back({"everything", all});
+    return r;
+}
+
+WorkingImage develop(const WorkingImage &src, const EditParams &p, PointPath path)
+{
+    WorkingImage img = src;
+    Develop d;
+    d.setPointPath(path);
+    d.Apply(img, p, nullptr);
+    return img;
+}
+
+} // namespace
+
+class TestPointLut : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void renderAccuracy();
+    void outOfDomainIsDirect();
+    void smallFrameIsDirect();
+    void everyLevelMatchesScalar();
+    void lutTiming();
+};
+
+void TestPointLut::renderAccuracy()
+{
+    /* What each recipe was accepted under, in 8-bit codes of the rendered frame: the worst
+       byte, the mean absolute delta, and the share of bytes more than two codes off. The
+       panels that act one channel at a time (or linearly, ahead of the table) stay within
+       two codes everywhere; HSL and the grade are held to a small mean and a few percent
+       of bytes past two codes, with a bounded worst. */
+    struct Bound { const char *name; int worst; double mean; double farShare; };
+    const Bound bounds[] = {
+        {"whiteBalance", 2, 0.5, 0.0},   {"toneRegions", 2, 0.5, 0.0},
+        {"curves", 2, 0.5, 0.0},         {"colorRgb", 2, 0.5, 0.0},
+        {"calibrate", 2, 0.5, 0.0},      {"hsl", 80, 0.4, 0.025},
+        {"colorGrade", 32, 0.4, 0.025},  {"everything", 96, 1.25, 0.08},
+    };
+    for (const bool sceneReferred : {true, false}) {
+        /* 800 x 400 clears PointLut::kMinPixels, so the Lut render really bakes. */
+        const WorkingImage src = makeScene(800, 400, sceneReferred);
+        QVERIFY(size_t(src.width) * src.height >= PointLut::kMinPixels);
+        for (const Recipe &r : recipes()) {
+            const WorkingImage direct = develop(src, r.p, PointPath::Direct);
+            const WorkingImage lut = develop(src, r.p, PointPath::Lut);
+
+            OutputTransform t;
+            QImage a, b;
+            QVERIFY(t.ToImage(direct, a));
+            QVERIFY(t.ToImage(lut, b));
+            int worst = 0;
+            qint64 sum = 0, far = 0, total = 0;
+            for (int y = 0; y < src.height; ++y) {
+                const uchar *la = a.constScanLine(y), *lb = b.constScanLine(y);
+                for (int x = 0; x < src.width * 3; ++x) {
+                    const int d = std::abs(int(la[x]) - int(lb[x]));
+                    worst = std::max(worst, d);
+                    sum += d;
+                    if (d > 2) ++far;
+                    ++total;
+                }
+            }
+            const double mean = double(sum) / double(total);
+            const double farShare = double(far) / double(total);
+            const Bound *bound = nullptr;
+            for (const Bound &bd : bounds)
+                if (!std::strcmp(bd.name, r.name)) bound = &bd;
+            QVERIFY(bound);
+            const QString what = QString("%1 sceneReferred %2: worst %3, mean %4, %5% past 2")
+                                     .arg(r.name).arg(int(sceneReferred)).arg(worst)
+                                     .arg(mean, 0, 'f', 3).arg(100.0 * farShare, 0, 'f', 3);
+            QVERIFY2(worst <= bound->worst, qPrintable(what));
+            QVERIFY2(mean <= bound->mean, qPrintable(what));
+            QVERIFY2(farShare <= bound->farShare, qPrintable(what));
+        }
+    }
+}
+
+void TestPointLut::outOfDomainIsDirect()
+{
+    WorkingImage src = makeScene(800, 400, true);
+    const float range = PointLut::kRange * src.white;
+    /* Every 97th pixel gets one channel off the table: below 0, just past the top, far
+       past it, NaN or infinite. */
+    const float off[] = {-0.01f, -3.0f, std::nextafter(range, 2.0f * range), 100.0f, NAN,
+                         INFINITY};
+    std::vector<size_t> misses;
+    for (size_t px = 0, k = 0; px < size_t(src.width) * src.height; px += 97, ++k) {
+        src.rgb[px * 3 + k % 3] = off[k % (sizeof off / sizeof off[0])];
+        misses.push_back(px);
+    }
+    /* The table's part of the chain only: white balance, exposure, the RGB gains and
+       calibration run ahead of it and would move a channel back onto the table. */
+    EditParams p;
+    for (const Panel &panel : panels)
+        if (std::strcmp(panel.name, "whiteBalance") && std::strcmp(panel.name, "colorRgb") &&
+            std::strcmp(panel.name, "calibrate"))
+            panel.set(p);
+    const WorkingImage direct = develop(src, p, PointPath::Direct);
+    const WorkingImage lut = develop(src, p, PointPath::Lut);
+    for (const size_t px : misses)
+        for (int ch = 0; ch < 3; ++ch)
+            QVERIFY2(sameBits(lut.rgb[px * 3 + ch], direct.rgb[px * 3 + ch]),
+                     qPrintable(QString("pixel %1 ch %2: %3 vs %4").arg(px).arg(ch)
+                                    .arg(double(lut.rgb[px * 3 + ch]))
+                                    .arg(double(direct.rgb[px * 3 + ch]))));
+}
+
+void TestPointLut::smallFrameIsDirect()
+{
+    const WorkingImage src = makeScene(300, 200, true);
+    QVERIFY(size_t(src.width) * src.height < PointLut::kMinPixels);
+    const EditParams p = recipes().back().p;
+    const WorkingImage direct = develop(src, p, PointPath::Direct);
+    const WorkingImage lut = develop(src, p, PointPath::Lut);
+    QVERIFY(std::memcmp(direct.rgb.data(), lut.rgb.data(), direct.rgb.size() * 4) == 0);
+}
+
+void TestPointLut::everyLevelMatchesScalar()
+{
+    /* A width that leaves a scalar tail in every planar run. */
+    WorkingImage src = makeScene(803, 400, true);
+    src.rgb[3 * 1000] = -1.0f;                               // and a miss or two
+    src.rgb[3 * 2001 + 2] = 50.0f;
+    for (const Recipe &r : recipes()) {
+        Winnow::Simd::setLevel(Level::Scalar);
+        const WorkingImage ref = develop(src, r.p, PointPath::Lut);
+        for (const Level l : simdLevels) {
+            if (!Winnow::Simd::setLevel(l)) continue;
+            const WorkingImage got = develop(src, r.p, PointPath::Lut);
+            for (size_t i = 0; i < ref.rgb.size(); ++i) {
+                if (sameBits(got.rgb[i], ref.rgb[i])) continue;
+                Winnow::Simd::resetLevel();
+                QFAIL(qPrintable(QString("%1 %2: value %3 is %4, scalar %5")
+                                     .arg(r.name).arg(Winnow::Simd::name(l)).arg(i)
+                                     .arg(double(got.rgb[i])).arg(double(ref.rgb[i]))));
+            }
+        }
+    }
+    Winnow::Simd::resetLevel();
+}
+
+void TestPointLut::lutTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const EditParams p = recipes().back().p;
+    struct Size { const char *name; int w, h; };
+    for (const Size &s : {Size{"proxy 2560x1707", 2560, 1707}, Size{"45 MP 8256x5504", 8256, 5504}}) {
+        const WorkingImage src = makeScene(s.w, s.h, true);
+        const double mp = double(s.w) * s.h / 1e6;
+        qInfo().noquote() << s.name << "-- point pass, all threads:";
+        qInfo().noquote() << "level      direct ms   lut ms   (lut Mpix/s)";
+        for (const Level l : {Level::Scalar, Level::SSE41, Level::AVX2, Level::NEON}) {
+            if (!Winnow::Simd::setLevel(l)) continue;
+            qint64 ms[2];
+            for (const PointPath path : {PointPath::Direct, PointPath::Lut}) {
+                WorkingImage img = src;
+                Develop d;
+                d.setPointPath(path);
+                Develop::StageTimings t;
+                d.Apply(img, p, &t);
+                ms[path == PointPath::Lut] = qMax<qint64>(1, t.pointMs);
+            }
+            qInfo().noquote() << QString("%1  %2  %3  %4").arg(Winnow::Simd::name(l), -8)
+                                 .arg(ms[0], 9).arg(ms[1], 7)
+                                 .arg(mp / (ms[1] / 1e3), 12, 'f', 0);
+        }
+        Winnow::Simd::resetLevel();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPointLut)
+#include "tst_pointlut.moc"
@@ -0,0 +1,189 @@
+/*
+    PreviewDiskCache -- the on-disk preview tier behind ImageCache.
+
+    What matters is that a hit returns exactly the pixels that were stored (the view
+    paints straight out of the memory mapping), that any change to the decode signature
+    or to the source file misses instead of showing a stale preview, and that the LRU
+    keeps the folder under its byte budget. Every slot points the singleton at its own
+    QTemporaryDir so nothing touches the user's real cache folder.
+*/
+#include <QtTest>
+#include <QTemporaryDir>
+#include "Cache/previewdiskcache.h"
+
+namespace {
+
+QImage makeImage(int w, int h)
+{
+    QImage im(w, h, QImage::Format_RGB32);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            im.setPixel(x, y, qRgb(x & 0xff, y & 0xff, (x + y) & 0xff));
+    return im;
+}
+
+// a real source file: the key includes its mtime and size
+QString makeSource(const QTemporaryDir &tmp, const QString &name, const QByteArray &bytes)
+{
+    const QString path = tmp.filePath(name);
+    QFile f(path);
+    f.open(QIODevice::WriteOnly);
+    f.write(bytes);
+    return path;
+}
+
+} // namespace
+
+class TestPreviewDiskCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void roundTripIsExact();
+    void signatureChangeMisses();
+    void editedSourceMisses();
+    void largePreviewIsScaled();
+    void budgetTrimsLeastRecentlyUsed();
+    void disabledIsInert();
+
+private:
+    QTemporaryDir *tmp = nullptr;
+};
+
+void TestPreviewDiskCache::init()
+{
+    tmp = new QTemporaryDir;
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    c.setDirectory(tmp->filePath("previews"));
+    c.clear();
+    c.setMaxBytes(qint64(64) << 20);
+    c.setMaxEdge(3840);
+    c.setEnabled(true);
+}
+
+void TestPreviewDiskCache::cleanup()
+{
+    PreviewDiskCache::instance().setEnabled(false);
+    delete tmp;
+    tmp = nullptr;
+}
+
+void TestPreviewDiskCache::roundTripIsExact()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    const QString src = makeSource(*tmp, "a.nef", "raw bytes");
+    const QString sig = PreviewDiskCache::signatureFor(true, false, 1, 0);
+    const QImage im = makeImage(300, 200);
+
+    QImage out;
+    QVERIFY(!c.get(src, sig, out));
+    c.put(src, sig, im);
+    QVERIFY(c.get(src, sig, out));
+    QCOMPARE(out.size(), im.size());
+    QCOMPARE(out.format(), im.format());
+    QVERIFY(out == im);
+
+    // writing to the hit detaches; the mapping (and the next hit) is untouched
+    out.setPixel(0, 0, qRgb(1, 2, 3));
+    QImage again;
+    QVERIFY(c.get(src, sig, again));
+    QVERIFY(again == im);
+}
+
+void TestPreviewDiskCache::signatureChangeMisses()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    const QString src = makeSource(*tmp, "b.cr3", "raw bytes");
+    c.put(src, PreviewDiskCache::signatureFor(true, false, 1, 0), makeImage(64, 64));
+
+    QImage out;
+    QVERIFY(!c.get(src, PreviewDiskCache::signatureFor(false, false, 1, 0), out));
+    QVERIFY(!c.get(src, PreviewDiskCache::signatureFor(true, true, 1, 0), out));
+    QVERIFY(!c.get(src, PreviewDiskCache::signatureFor(true, false, 6, 0), out));
+    QVERIFY(!c.get(src, PreviewDiskCache::signatureFor(true, false, 1, 90), out));
+    QVERIFY(c.get(src, PreviewDiskCache::signatureFor(true, false, 1, 0), out));
+}
+
+void TestPreviewDiskCache::editedSourceMisses()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    const QString src = makeSource(*tmp, "c.jpg", "v1");
+    const QString sig = PreviewDiskCache::signatureFor(false, false, 1, 0);
+    c.put(src, sig, makeImage(32, 32));
+
+    makeSource(*tmp, "c.jpg", "version two");   // size changes
+    QImage out;
+    QVERIFY(!c.get(src, sig, out));
+}
+
+void TestPreviewDiskCache::largePreviewIsScaled()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    c.setMaxEdge(100);
+    const QString src = makeSource(*tmp, "d.arw", "raw bytes");
+    const QString sig = PreviewDiskCache::signatureFor(false, true, 1, 0);
+    c.put(src, sig, makeImage(400, 200));
+    QImage out;
+    QSize full;
+    QVERIFY(c.get(src, sig, out, &full));
+    QCOMPARE(out.size(), QSize(100, 50));
+    QCOMPARE(full, QSize(400, 200));            // reported as a reduced-tier image
+
+    const QString small = makeSource(*tmp, "d2.arw", "raw bytes");
+    c.put(small, sig, makeImage(80, 60));
+    QVERIFY(c.get(small, sig, out, &full));
+    QVERIFY(!full.isValid());                   // stored at full resolution
+
+    // decoded below full size (half-size raw): the decode's full size is kept
+    const QString half = makeSource(*tmp, "d3.arw", "raw bytes");
+    c.put(half, sig, makeImage(80, 60), QSize(160, 120));
+    QVERIFY(c.get(half, sig, out, &full));
+    QCOMPARE(out.size(), QSize(80, 60));
+    QCOMPARE(full, QSize(160, 120));
+}
+
+void TestPreviewDiskCache::budgetTrimsLeastRecentlyUsed()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    const QImage im = makeImage(256, 256);        // 256 KB of pixels + 64 byte header
+    const qint64 one = im.sizeInBytes() + 64;
+    c.setMaxBytes(one * 3);
+    const QString sig = PreviewDiskCache::signatureFor(false, false, 1, 0);
+
+    QStringList srcs;
+    for (int i = 0; i < 4; ++i) {
+        srcs << makeSource(*tmp, QString("e%1.jpg").arg(i), "bytes");
+        c.put(srcs.last(), sig, im);
+        QTest::qWait(5);                          // distinct LRU stamps
+        if (i == 2) {
+            QImage touch;
+            QVERIFY(c.get(srcs.at(0), sig, touch)); // 0 is now newer than 1
+            QTest::qWait(5);
+        }
+    }
+
+    QImage out;
+    QVERIFY(c.get(srcs.at(0), sig, out));
+    QVERIFY(!c.get(srcs.at(1), sig, out));
+    QVERIFY(c.get(srcs.at(2), sig, out));
+    QVERIFY(c.get(srcs.at(3), sig, out));
+    const int files = QDir(c.directory()).entryList({"*.wpv"}, QDir::Files).size();
+    QCOMPARE(files, 3);
+}
+
+void TestPreviewDiskCache::disabledIsInert()
+{
+    PreviewDiskCache &c = PreviewDiskCache::instance();
+    c.setEnabled(false);
+    const QString src = makeSource(*tmp, "f.jpg", "bytes");
+    const QString sig = PreviewDiskCache::signatureFor(false, false, 1, 0);
+    c.put(src, sig, makeImage(16, 16));
+    QImage out;
+    QVERIFY(!c.get(src, sig, out));
+    QVERIFY(!QDir(c.directory()).exists() || QDir(c.directory()).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestPreviewDiskCache)
+#include "tst_previewdiskcache.moc"
@@ -0,0 +1,169 @@
+/*
+    RawKernels -- the vectorised black subtraction, camera-to-working colour pass and
+    X-Trans Markesteijn homogeneity stages.
+
+    Every SIMD level this CPU supports is run against the Scalar level on the same input
+    and must match it BIT FOR BIT: the scalar loops are the reference the pipeline was
+    validated with, and the vector paths are only a faster way of computing the same
+    thing. Widths / pixel counts are chosen to leave scalar tails of every length.
+
+    kernelTiming prints Mpix/s per level on a 24 MP frame; nothing is asserted about it
+    and it only runs on request (benchmark.h).
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ImageFormats/Raw/rawkernels.h"
+#include "benchmark.h"
+
+using Winnow::Simd::Level;
+
+namespace {
+
+const Level simdLevels[] = {Level::SSE41, Level::AVX2, Level::NEON};
+
+const float kWb[3] = {2.1f, 1.0f, 1.6f};
+const float kMatrix[3][3] = {
+    { 1.70f, -0.50f, -0.20f},
+    {-0.30f,  1.50f, -0.20f},
+    { 0.05f, -0.60f,  1.55f}
+};
+
+} // namespace
+
+class TestRawKernels : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void subtractBlackMatchesScalar();
+    void subtractBlackSaturates();
+    void camToWorkingMatchesScalar();
+    void xtransKernelsMatchScalar();
+    void kernelTiming();
+};
+
+void TestRawKernels::subtractBlackMatchesScalar()
+{
+    std::mt19937 rng(1);
+    const uint16_t black[4] = {512, 600, 0, 65535};
+    for (const int w : {1, 2, 7, 8, 15, 16, 17, 33, 100, 6001}) {
+        const int h = 5;
+        std::vector<uint16_t> mosaic(size_t(w) * h);
+        for (uint16_t &v : mosaic) v = uint16_t(rng());
+        std::vector<uint16_t> ref = mosaic;
+        RawKernels::SubtractBlack(ref.data(), w, h, black, Level::Scalar);
+        for (const Level l : simdLevels) {
+            if (!Winnow::Simd::supported(l)) continue;
+            std::vector<uint16_t> got = mosaic;
+            RawKernels::SubtractBlack(got.data(), w, h, black, l);
+            QVERIFY2(got == ref, qPrintable(QString("%1 width %2").arg(Winnow::Simd::name(l)).arg(w)));
+        }
+    }
+}
+
+void TestRawKernels::subtractBlackSaturates()
+{
+    // RGGB-indexed black: row 0 = (10, 20), row 1 = (30, 40)
+    const uint16_t black[4] = {10, 20, 30, 40};
+    std::vector<uint16_t> mosaic = {5, 25, 100, 20,     // row 0
+                                    30, 39, 31, 65535}; // row 1
+    RawKernels::SubtractBlack(mosaic.data(), 4, 2, black, Winnow::Simd::level());
+    QCOMPARE(mosaic, std::vector<uint16_t>({0, 5, 90, 0, 0, 0, 1, 65495}));
+}
+
+void TestRawKernels::camToWorkingMatchesScalar()
+{
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> value(-0.2f, 1.5f);
+    for (const size_t n : {size_t(1), size_t(3), size_t(4), size_t(5), size_t(13), size_t(4099)}) {
+        std::vector<float> rgb(n * 3);
+        for (float &v : rgb) v = value(rng);
+        rgb[0] = 0.0f;
+        if (n > 1) rgb[4] = -0.0f;
+        std::vector<float> ref(n * 3);
+        RawKernels::CamToWorking(rgb.data(), ref.data(), n, kWb, kMatrix, Level::Scalar);
+        for (const Level l : simdLevels) {
+            if (!Winnow::Simd::supported(l)) continue;
+            std::vector<float> got(n * 3, -1.0f);
+            RawKernels::CamToWorking(rgb.data(), got.data(), n, kWb, kMatrix, l);
+            QVERIFY2(std::memcmp(got.data(), ref.data(), n * 3 * sizeof(float)) == 0,
+                     qPrintable(QString("%1 pixels %2").arg(Winnow::Simd::name(l)).arg(n)));
+        }
+    }
+}
+
+void TestRawKernels::xtransKernelsMatchScalar()
+{
+    /* Three rows of planar buffers with the kernels run on the middle one, so the
+       derivative and homogeneity reads one row and one column out stay inside. Output
+       planes: perceptual l, a, b, then the derivative along each of the four steps,
+       then the four homogeneity maps. */
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> value(-0.1f, 1.2f);
+    for (const int n : {1, 3, 4, 5, 8, 13, 17, 258}) {
+        const int stride = n + 2;
+        const size_t size = size_t(stride) * 3;
+        const size_t mid = size_t(stride) + 1;
+        std::vector<float> in[4];
+        for (std::vector<float> &v : in) {
+            v.resize(size);
+            for (float &x : v) x = value(rng);
+        }
+        in[0][mid] = 0.0f;
+        in[1][mid] = -0.0f;
+
+        auto run = [&](Level l) {
+            std::vector<std::vector<float>> out(11, std::vector<float>(size, -1.0f));
+            auto at = [&](int k) { return out[k].data() + mid; };
+            const float *r = in[0].data() + mid, *g = in[1].data() + mid, *b = in[2].data() + mid;
+            RawKernels::XTransPerceptual(r, g, b, at(0), at(1), at(2), n, l);
+            const ptrdiff_t steps[4] = {1, stride, stride + 1, stride - 1};
+            for (int d = 0; d < 4; ++d)
+                RawKernels::XTransDerivative(r, g, b, steps[d], at(3 + d), n, l);
+            const float *const drv[4] = {r, g, b, in[3].data() + mid};
+            float *const homo[4] = {at(7), at(8), at(9), at(10)};
+            RawKernels::XTransHomogeneity(drv, stride, homo, n, l);
+            return out;
+        };
+
+        const std::vector<std::vector<float>> ref = run(Level::Scalar);
+        for (const Level l : simdLevels) {
+            if (!Winnow::Simd::supported(l)) continue;
+            const std::vector<std::vector<float>> got = run(l);
+            for (size_t k = 0; k < ref.size(); ++k)
+                QVERIFY2(std::memcmp(got[k].data(), ref[k].data(), size * sizeof(float)) == 0,
+                         qPrintable(QString("%1 n %2 plane %3").arg(Winnow::Simd::name(l)).arg(n).arg(k)));
+        }
+    }
+}
+
+void TestRawKernels::kernelTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    const int w = 6000, h = 4000;
+    const size_t n = size_t(w) * h;
+    std::vector<uint16_t> mosaic(n, 1000);
+    std::vector<float> rgb(n * 3, 0.25f), out(n * 3);
+    const uint16_t black[4] = {512, 512, 512, 512};
+
+    qInfo().noquote() << "level      black Mpix/s   colour Mpix/s";
+    for (const Level l : {Level::Scalar, Level::SSE41, Level::AVX2, Level::NEON}) {
+        if (!Winnow::Simd::supported(l)) continue;
+        QElapsedTimer t;
+        t.start();
+        RawKernels::SubtractBlack(mosaic.data(), w, h, black, l);
+        const double blackSec = qMax<qint64>(1, t.nsecsElapsed()) / 1e9;
+        t.restart();
+        RawKernels::CamToWorking(rgb.data(), out.data(), n, kWb, kMatrix, l);
+        const double colourSec = qMax<qint64>(1, t.nsecsElapsed()) / 1e9;
+        qInfo().noquote() << QString("%1  %2  %3").arg(Winnow::Simd::name(l), -8)
+                             .arg(n / 1e6 / blackSec, 13, 'f', 0)
+                             .arg(n / 1e6 / colourSec, 14, 'f', 0);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestRawKernels)
+#include "tst_rawkernels.moc"
@@ -0,0 +1,88 @@
+/*
+    RegionDecoder geometry -- where in the file a rect of the displayed image comes from.
+
+    The loupe asks for a rect of the image as shown, after ImageDecoder::rotate; the decode
+    reads the file in its stored orientation. For every rotation ImageDecoder applies,
+    cutting storedRect() out of the stored image and rotating it must give exactly the
+    pixels of the requested rect of the rotated full image, and displayedRect() must put
+    them back where they were asked for.
+*/
+#include <QtTest>
+#include "Cache/regiondecoder.h"
+
+class TestRegionDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sizes();
+    void regionMatchesRotatedImage_data();
+    void regionMatchesRotatedImage();
+    void clipsToImage();
+};
+
+namespace {
+
+// every pixel distinct, so a misplaced region cannot compare equal
+QImage pattern(QSize size)
+{
+    QImage im(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(im.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) line[x] = qRgb(x, y, (x * 7 + y * 13) & 0xff);
+    }
+    return im;
+}
+
+}
+
+void TestRegionDecoder::sizes()
+{
+    QCOMPARE(RegionDecoder::storedSize(QSize(60, 40), 0), QSize(60, 40));
+    QCOMPARE(RegionDecoder::storedSize(QSize(60, 40), 90), QSize(40, 60));
+    QCOMPARE(RegionDecoder::storedSize(QSize(60, 40), 180), QSize(60, 40));
+    QCOMPARE(RegionDecoder::storedSize(QSize(60, 40), 270), QSize(40, 60));
+}
+
+void TestRegionDecoder::regionMatchesRotatedImage_data()
+{
+    QTest::addColumn<int>("degrees");
+    QTest::addColumn<QRect>("rect");
+    for (int d : {0, 90, 180, 270}) {
+        const QByteArray n = QByteArray::number(d);
+        QTest::newRow(n + " interior") << d << QRect(7, 5, 19, 11);
+        QTest::newRow(n + " corner") << d << QRect(0, 0, 10, 9);
+        QTest::newRow(n + " edge") << d << QRect(30, 20, 17, 3);
+    }
+}
+
+void TestRegionDecoder::regionMatchesRotatedImage()
+{
+    QFETCH(int, degrees);
+    QFETCH(QRect, rect);
+
+    const QSize stored(53, 37);
+    const QImage file = pattern(stored);
+    const QImage shown = file.transformed(QTransform().rotate(degrees));
+    const QSize disp = shown.size();
+    QCOMPARE(disp, (degrees % 180) ? stored.transposed() : stored);
+
+    const QRect want = rect & QRect(QPoint(0, 0), disp);
+    const QRect s = RegionDecoder::storedRect(want, disp, degrees);
+    QCOMPARE(s.size(), (degrees % 180) ? want.size().transposed() : want.size());
+    QCOMPARE(RegionDecoder::displayedRect(s, stored, degrees), want);
+
+    const QImage region = file.copy(s).transformed(QTransform().rotate(degrees));
+    QCOMPARE(region, shown.copy(want));
+}
+
+void TestRegionDecoder::clipsToImage()
+{
+    const QSize disp(40, 60);                       // stored 60 x 40, rotated 90
+    const QRect s = RegionDecoder::storedRect(QRect(-10, 50, 30, 30), disp, 90);
+    QVERIFY(QRect(0, 0, 60, 40).contains(s));
+    QCOMPARE(RegionDecoder::displayedRect(s, QSize(60, 40), 90), QRect(0, 50, 20, 10));
+}
+
+QTEST_GUILESS_MAIN(TestRegionDecoder)
+#include "tst_regiondecoder.moc"
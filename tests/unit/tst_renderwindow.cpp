@@ -0,0 +1,219 @@
+/*
+    WorkingImageCache::renderWindow -- the 1:1 VIEWPORT render.
+
+    At 1:1 the loupe shows a few megapixels of a frame that may be fifty, so the settle
+    render develops only a window around what is visible: the visible rect grown by
+    Develop::halo. That is only safe if the window renders the same pixels the whole
+    frame would -- a halo one pixel short, or an op that sizes its kernel, places its
+    vignette or lays its reduced-resolution grid from the window rather than the frame,
+    shows as a seam between tiles or a look that shifts as you pan. So every recipe here
+    is rendered through windows in the interior, on the edges and in a corner, of a frame
+    whose edges are not a multiple of any resampling factor, and compared with the same
+    rect of the full-frame render.
+
+    TOLERANCE. The comparison is on the 16-bit output, where a halo at half its width
+    already misses by well over kTol16 (tens of codes for Texture, thousands for
+    Dehaze's box blur). Per-pixel ops (the point chain, Vignette, Grain) must
+    match exactly. The neighbourhood ops see the same pixels on the same grids; kTol16
+    allows for float rounding -- the window builds its reduced grid itself where the
+    frame calls cv::resize, and OpenCV may pick a different blur implementation for a
+    whole-frame Mat than for a smaller one (see tst_developtiles).
+
+    windowTiming prints a 1:1 view and a pan tile against the full render on a 45 MP
+    frame; nothing is asserted about it, and ctest skips it (see benchmark.h).
+*/
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRect>
+#include <cstdlib>
+#include <vector>
+
+#include "Develop/develop.h"
+#include "Develop/workingimagecache.h"
+#include "Develop/workingimage.h"
+#include "Develop/editparams.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kTol16 = 8;               // 16-bit codes (257 per 8-bit code), neighbourhood ops
+constexpr int kW = 1210, kH = 847;      // no resampling factor (2..6) divides both
+
+/* A ramp with a checker of hard steps and per-pixel noise in a warm tint: edges for the
+   band ops and Sharpen to ring on, noise for Denoise, a gradient for the vignette. */
+WorkingImage makeScene(int w, int h)
+{
+    WorkingImage img;
+    img.width = w; img.height = h; img.white = 1.0f;
+    img.sceneReferred = false;
+    img.rgb.resize(static_cast<size_t>(w) * h * 3);
+    uint32_t s = 12345;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            s = s * 1664525u + 1013904223u;
+            const float n = ((s >> 8) & 0xffff) / 65535.0f;
+            float v = 0.05f + 0.5f * x / w + 0.25f * y / h + 0.05f * n;
+            if ((x / 37 + y / 29) % 3 == 0) v *= 1.6f;
+            const size_t i = (static_cast<size_t>(y) * w + x) * 3;
+            img.rgb[i + 0] = v;
+            img.rgb[i + 1] = v * 0.9f;
+            img.rgb[i + 2] = v * (0.7f + 0.3f * n);
+        }
+    }
+    return img;
+}
+
+struct Recipe { const char *name; EditParams p; bool perPixel; };
+
+std::vector<Recipe> recipes()
+{
+    std::vector<Recipe> r;
+    EditParams p;
+    r.push_back({"identity", p, true});
+    p.exposure = 0.5f; p.contrast = 30.0f; p.saturation = 20.0f;
+    r.push_back({"point", p, true});
+    p = EditParams(); p.vignetteExposure = -1.0f;
+    r.push_back({"vignette", p, true});
+    p = EditParams(); p.grainAmount = 0.5f; p.grainRoughness = 0.7f;
+    r.push_back({"grain", p, true});
+    p = EditParams(); p.texture = 60.0f;
+    r.push_back({"texture", p, false});
+    p = EditParams(); p.clarity = -40.0f;
+    r.push_back({"clarity", p, false});
+    p = EditParams(); p.dehaze = 50.0f;
+    r.push_back({"dehaze", p, false});
+    p = EditParams(); p.sharpenAmount = 1.0f; p.sharpenRadius = 1.5f; p.sharpenMasking = 0.3f;
+    r.push_back({"sharpen", p, false});
+    p = EditParams(); p.localDenoiseLuma = 0.5f; p.localDenoiseChroma = 0.5f;
+    r.push_back({"denoise", p, false});
+    p = EditParams(); p.exposure = 0.3f; p.texture = 40.0f; p.clarity = 30.0f;
+    p.dehaze = 20.0f; p.vignetteExposure = -0.5f; p.sharpenAmount = 0.8f;
+    p.grainAmount = 0.3f; p.localDenoiseLuma = 0.3f;
+    r.push_back({"everything", p, false});
+    return r;
+}
+
+/* Interior, each edge, a corner, odd offsets and sizes, and the whole frame. */
+std::vector<QRect> windows()
+{
+    return {QRect(437, 311, 300, 200), QRect(0, 0, 250, 180),
+            QRect(kW - 333, kH - 207, 333, 207), QRect(0, 400, 190, 300),
+            QRect(601, 0, 409, 121), QRect(0, 0, kW, kH)};
+}
+
+/* Largest per-channel difference, in 16-bit codes, between rect of full and win. */
+int maxDiff(const QImage &full, const QRect &rect, const QImage &win)
+{
+    const QImage a = full.convertToFormat(QImage::Format_RGBX64);
+    const QImage b = win.convertToFormat(QImage::Format_RGBX64);
+    int worst = 0;
+    for (int y = 0; y < rect.height(); ++y) {
+        const quint16 *pa = reinterpret_cast<const quint16 *>(a.constScanLine(rect.top() + y));
+        const quint16 *pb = reinterpret_cast<const quint16 *>(b.constScanLine(y));
+        for (int x = 0; x < rect.width(); ++x)
+            for (int c = 0; c < 3; ++c)
+                worst = qMax(worst, std::abs(int(pa[(rect.left() + x) * 4 + c]) -
+                                             int(pb[x * 4 + c])));
+    }
+    return worst;
+}
+
+/* render and renderWindow at 16 bits, so a sub-code difference still shows. */
+constexpr auto k16 = WorkingImageCache::OutDepth::Sixteen;
+
+} // namespace
+
+class TestRenderWindow : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void haloOnlyForNeighbourhoodOps();
+    void windowsMatchFullFrame();
+    void clipsToTheFrame();
+    void windowTiming();
+};
+
+void TestRenderWindow::haloOnlyForNeighbourhoodOps()
+{
+    for (const Recipe &r : recipes()) {
+        const int halo = Develop::halo(r.p, kW, kH);
+        if (r.perPixel) QVERIFY2(halo == 0, r.name);
+        else            QVERIFY2(halo > 0, r.name);
+    }
+    /* The reach scales with the frame, as the kernels do. */
+    EditParams p;
+    p.clarity = 50.0f;
+    QVERIFY(Develop::halo(p, 8000, 6000) > Develop::halo(p, 2000, 1500));
+}
+
+void TestRenderWindow::windowsMatchFullFrame()
+{
+    const WorkingImage work = makeScene(kW, kH);
+    for (const Recipe &r : recipes()) {
+        QImage full;
+        QVERIFY(WorkingImageCache::render(work, r.p, full, nullptr, k16));
+        for (const QRect &rect : windows()) {
+            QImage win;
+            QVERIFY(WorkingImageCache::renderWindow(work, r.p, rect, win, nullptr, k16));
+            QCOMPARE(win.size(), rect.size());
+            const int d = maxDiff(full, rect, win);
+            QVERIFY2(d <= (r.perPixel ? 0 : kTol16),
+                     qPrintable(QString("%1 at %2,%3 %4x%5: max delta %6 codes")
+                                    .arg(r.name).arg(rect.x()).arg(rect.y())
+                                    .arg(rect.width()).arg(rect.height()).arg(d)));
+        }
+    }
+}
+
+void TestRenderWindow::clipsToTheFrame()
+{
+    const WorkingImage work = makeScene(kW, kH);
+    const EditParams p = recipes().back().p;
+    QImage full, win;
+    QVERIFY(WorkingImageCache::render(work, p, full, nullptr, k16));
+
+    /* A rect hanging off the frame renders the part inside it. */
+    const QRect hanging(kW - 100, -50, 300, 200);
+    QVERIFY(WorkingImageCache::renderWindow(work, p, hanging, win, nullptr, k16));
+    const QRect inside = hanging & QRect(0, 0, kW, kH);
+    QCOMPARE(win.size(), inside.size());
+    QVERIFY(maxDiff(full, inside, win) <= kTol16);
+
+    /* Nothing inside, or a source that is itself a window: no render. */
+    QVERIFY(!WorkingImageCache::renderWindow(work, p, QRect(kW + 10, 0, 50, 50), win));
+    WorkingImage cut = makeScene(120, 120);
+    cut.frameX = 60; cut.frameW = kW; cut.frameH = kH;
+    QVERIFY(!WorkingImageCache::renderWindow(cut, p, QRect(0, 0, 50, 50), win));
+}
+
+void TestRenderWindow::windowTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    /* 45 MP, "everything", and a 2560x1440 viewport at 1:1 in the middle of it. */
+    const int w = 8256, h = 5504;
+    const WorkingImage work = makeScene(w, h);
+    const EditParams p = recipes().back().p;
+    const QRect view((w - 2560) / 2, (h - 1440) / 2, 2560, 1440);
+    const QRect tile(view.topLeft(), QSize(512, 512));
+
+    QElapsedTimer t;
+    QImage out;
+    WorkingImageCache::RenderTimings rt;
+    t.start();
+    WorkingImageCache::render(work, p, out, &rt);
+    const qint64 fullMs = t.restart();
+    WorkingImageCache::renderWindow(work, p, view, out, &rt);
+    const qint64 viewMs = t.restart();
+    WorkingImageCache::renderWindow(work, p, tile, out, &rt);
+    const qint64 tileMs = t.elapsed();
+    qInfo().noquote() << QString("45 MP everything: full %1 ms  2560x1440 view %2 ms"
+                                 "  512 px pan tile %3 ms  (halo %4 px)")
+                         .arg(fullMs).arg(viewMs).arg(tileMs)
+                         .arg(Develop::halo(p, w, h));
+}
+
+QTEST_GUILESS_MAIN(TestRenderWindow)
+#include "tst_renderwindow.moc"
@@ -0,0 +1,319 @@
+/*
+    TiffCodec -- the per-strip kernels behind Tiff::decode and Tiff::read.
+
+    The LZW streams are made here by a small encoder with libtiff's semantics (9-12 bit
+    codes written MSB first, the code width growing one code early, a clear code when the
+    table reaches 4094), so every decode is checked against the bytes that were encoded.
+
+    stripTiming prints a 24 MP 16-bit LZW + predictor TIFF taken through the strip
+    pipeline (LZW, byte order, predictor, 48 -> 32 bit) on one thread and then on the
+    thread pool; nothing is asserted about the times, and ctest skips it.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "ImageFormats/Tiff/tiffcodec.h"
+#include "benchmark.h"
+
+namespace {
+
+std::vector<uchar> lzwEncode(const std::vector<uchar> &in)
+{
+    std::vector<uchar> out;
+    quint32 acc = 0;
+    int nAcc = 0;
+    int bits = 9;
+    auto put = [&](int code) {
+        acc = (acc << bits) | quint32(code);
+        nAcc += bits;
+        while (nAcc >= 8) {
+            out.push_back(uchar(acc >> (nAcc - 8)));
+            nAcc -= 8;
+        }
+    };
+    std::unordered_map<int, int> dict;          // (prefix << 8 | byte) -> code
+    int next = 258;
+    // after each code the decoder adds an entry; match its table size and width
+    auto added = [&]() {
+        if (++next == 4094) {
+            put(256);
+            dict.clear();
+            next = 258;
+            bits = 9;
+        }
+        else if (next > (1 << bits) - 1 && bits < 12) ++bits;
+    };
+
+    put(256);
+    int w = -1;
+    for (const uchar c : in) {
+        if (w < 0) {
+            w = c;
+            continue;
+        }
+        const auto it = dict.find(w << 8 | c);
+        if (it != dict.end()) {
+            w = it->second;
+            continue;
+        }
+        put(w);
+        dict[w << 8 | c] = next;
+        added();
+        w = c;
+    }
+    if (w >= 0) {
+        put(w);
+        added();
+    }
+    put(257);
+    if (nAcc) out.push_back(uchar(acc << (8 - nAcc)));
+    return out;
+}
+
+std::vector<uchar> sample(size_t n, int kind, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uchar> d(n);
+    for (size_t i = 0; i < n; ++i) {
+        switch (kind) {
+        case 0: d[i] = uchar(rng()); break;                 // incompressible
+        case 1: d[i] = uchar(rng() % 3); break;             // long runs of few strings
+        case 2: d[i] = uchar(i / 7); break;                 // KwKwK all the way
+        default: d[i] = uchar((i * i) >> 5); break;
+        }
+    }
+    return d;
+}
+
+/* A 16-bit RGB strip as a TIFF writer stores it: horizontally differenced, little
+   endian, LZW. */
+std::vector<uchar> encodeStrip(const std::vector<quint16> &rgb, int width, int rows)
+{
+    std::vector<uchar> raw(rgb.size() * 2);
+    for (int y = 0; y < rows; ++y) {
+        const quint16 *row = rgb.data() + size_t(y) * width * 3;
+        for (int i = 0; i < width * 3; ++i) {
+            const quint16 d = quint16(row[i] - (i >= 3 ? row[i - 3] : 0));
+            const size_t o = (size_t(y) * width * 3 + i) * 2;
+            raw[o] = uchar(d);
+            raw[o + 1] = uchar(d >> 8);
+        }
+    }
+    return lzwEncode(raw);
+}
+
+}
+
+class TestTiffCodec : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lzwRoundTrip_data();
+    void lzwRoundTrip();
+    void lzwClipsAndSurvivesGarbage();
+    void predictor();
+    void byteOrder();
+    void rgb48MatchesQImage();
+    void forEachCoversAll();
+    void stripTiming();
+};
+
+void TestTiffCodec::lzwRoundTrip_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("size");
+    for (int kind = 0; kind < 4; ++kind)
+        for (const int size : {1, 2, 300, 5000, 150000})
+            QTest::addRow("kind %d, %d bytes", kind, size) << kind << size;
+}
+
+void TestTiffCodec::lzwRoundTrip()
+{
+    QFETCH(int, kind);
+    QFETCH(int, size);
+    const std::vector<uchar> d = sample(size_t(size), kind, unsigned(size + kind));
+    const std::vector<uchar> e = lzwEncode(d);
+    std::vector<uchar> out(d.size() + 16, 0xcd);
+    QCOMPARE(TiffCodec::lzwDecode(e.data(), e.size(), out.data(), qsizetype(d.size())),
+             qsizetype(d.size()));
+    QVERIFY(std::equal(d.begin(), d.end(), out.begin()));
+    QCOMPARE(out[d.size()], uchar(0xcd));           // nothing past outLen
+}
+
+void TestTiffCodec::lzwClipsAndSurvivesGarbage()
+{
+    const std::vector<uchar> d = sample(100000, 3, 7);
+    const std::vector<uchar> e = lzwEncode(d);
+
+    // a short strip buffer gets the first outLen bytes, exactly
+    std::vector<uchar> half(d.size() / 2 + 1);
+    QCOMPARE(TiffCodec::lzwDecode(e.data(), e.size(), half.data(), qsizetype(half.size())),
+             qsizetype(half.size()));
+    QVERIFY(std::equal(half.begin(), half.end(), d.begin()));
+
+    // a truncated strip decodes what is there
+    std::vector<uchar> out(d.size());
+    const qsizetype n = TiffCodec::lzwDecode(e.data(), e.size() / 3, out.data(), qsizetype(out.size()));
+    QVERIFY(n > 0 && n < qsizetype(d.size()));
+    QVERIFY(std::equal(out.begin(), out.begin() + n, d.begin()));
+
+    // and noise stays inside the buffer
+    std::mt19937 rng(3);
+    for (int t = 0; t < 200; ++t) {
+        std::vector<uchar> g(rng() % 4000);
+        for (uchar &c : g) c = uchar(rng());
+        std::vector<uchar> o(8000);
+        QVERIFY(TiffCodec::lzwDecode(g.data(), qsizetype(g.size()), o.data(), qsizetype(o.size()))
+                <= qsizetype(o.size()));
+    }
+}
+
+void TestTiffCodec::predictor()
+{
+    uchar row8[] = {10, 20, 30, 1, 2, 3, 255, 0, 1};
+    TiffCodec::undoPredictor8(row8, 9, 3);
+    const uchar want8[] = {10, 20, 30, 11, 22, 33, 10, 22, 34};
+    QVERIFY(std::equal(std::begin(row8), std::end(row8), want8));
+
+    quint16 row16[] = {1000, 65535, 7, 1, 2, 3, 65535, 0, 1};
+    TiffCodec::undoPredictor16(row16, 9, 3);
+    const quint16 want16[] = {1000, 65535, 7, 1001, 1, 10, 1000, 1, 11};
+    QVERIFY(std::equal(std::begin(row16), std::end(row16), want16));
+}
+
+void TestTiffCodec::byteOrder()
+{
+    const uchar le[] = {0x34, 0x12, 0xcd, 0xab};
+    const uchar be[] = {0x12, 0x34, 0xab, 0xcd};
+    quint16 a[2], b[2];
+    memcpy(a, le, 4);
+    memcpy(b, be, 4);
+    TiffCodec::toHost16(a, 2, false);
+    TiffCodec::toHost16(b, 2, true);
+    QCOMPARE(a[0], quint16(0x1234));
+    QCOMPARE(a[1], quint16(0xabcd));
+    QCOMPARE(b[0], quint16(0x1234));
+    QCOMPARE(b[1], quint16(0xabcd));
+}
+
+void TestTiffCodec::rgb48MatchesQImage()
+{
+    // Tiff::read used to convert its RGBX64 image to RGB32; the direct path must agree
+    const int w = 256, h = 256;
+    QImage x64(w, h, QImage::Format_RGBX64);
+    std::vector<quint16> rgb(size_t(w) * h * 3);
+    for (int y = 0; y < h; ++y) {
+        QRgba64 *line = reinterpret_cast<QRgba64 *>(x64.scanLine(y));
+        for (int x = 0; x < w; ++x) {
+            const quint16 v = quint16(y * w + x);
+            const quint16 r = v, g = quint16(65535 - v), b = quint16(v * 7);
+            line[x] = QRgba64::fromRgba64(r, g, b, 65535);
+            quint16 *p = rgb.data() + (size_t(y) * w + x) * 3;
+            p[0] = r;
+            p[1] = g;
+            p[2] = b;
+        }
+    }
+    const QImage want = x64.convertToFormat(QImage::Format_RGB32);
+    QImage got(w, h, QImage::Format_RGB32);
+    for (int y = 0; y < h; ++y)
+        TiffCodec::rgb48ToRgb32(rgb.data() + size_t(y) * w * 3,
+                                reinterpret_cast<QRgb *>(got.scanLine(y)), w);
+    QCOMPARE(got, want);
+
+    const uchar px[] = {1, 2, 3, 250, 251, 252};
+    QRgb out[2];
+    TiffCodec::rgb24ToRgb32(px, out, 2);
+    QCOMPARE(out[0], qRgb(1, 2, 3));
+    QCOMPARE(out[1], qRgb(250, 251, 252));
+}
+
+void TestTiffCodec::forEachCoversAll()
+{
+    const int n = 1000;
+    std::vector<std::atomic<int>> hits(n);
+    QVERIFY(TiffCodec::forEach(n, [&](int i) { hits[i]++; return true; }));
+    for (int i = 0; i < n; ++i) QCOMPARE(hits[i].load(), 1);
+
+    QVERIFY(!TiffCodec::forEach(n, [](int i) { return i != 500; }));
+
+    // workers that cannot set up take no items; if none can, nothing is done
+    std::atomic<int> made{0};
+    QVERIFY(TiffCodec::forEachWorker(n, [&]() -> TiffCodec::Work {
+        if (made++ % 2) return {};
+        return [](int) { return true; };
+    }));
+    QVERIFY(!TiffCodec::forEachWorker(n, []() { return TiffCodec::Work(); }));
+    QVERIFY(TiffCodec::forEach(0, [](int) { return false; }));
+}
+
+void TestTiffCodec::stripTiming()
+{
+    WINNOW_BENCHMARK_SLOT();
+    // 6000 x 4000, 16 rows per strip; every strip holds the same pixels, which is all
+    // the timing needs and keeps the encoder out of it
+    const int W = 6000, H = 4000, rps = 16;
+    const int strips = (H + rps - 1) / rps;
+    std::vector<quint16> rgb(size_t(W) * rps * 3);
+    std::mt19937 rng(11);
+    for (size_t i = 0; i < rgb.size(); ++i)
+        rgb[i] = quint16((i % (size_t(W) * 3)) * 9 + (rng() & 0xff));
+    const std::vector<uchar> strip = encodeStrip(rgb, W, rps);
+    std::vector<QRgb> want(size_t(W) * rps);
+    for (int y = 0; y < rps; ++y)
+        TiffCodec::rgb48ToRgb32(rgb.data() + size_t(y) * W * 3, want.data() + size_t(y) * W, W);
+
+    QImage image(W, H, QImage::Format_RGB32);
+    uchar *bits = image.bits();
+    const qsizetype bpl = image.bytesPerLine();
+    const qsizetype stripBytes = qsizetype(W) * rps * 6;
+    auto pipeline = [&]() -> TiffCodec::Work {
+        auto buf = std::make_shared<std::vector<quint16>>(size_t(stripBytes / 2));
+        return [&, buf](int s) {
+            const int rows = qMin(rps, H - s * rps);
+            const qsizetype need = qsizetype(W) * rows * 6;
+            uchar *raw = reinterpret_cast<uchar *>(buf->data());
+            if (TiffCodec::lzwDecode(strip.data(), qsizetype(strip.size()), raw, need) != need)
+                return false;
+            TiffCodec::toHost16(buf->data(), need / 2, false);
+            for (int r = 0; r < rows; ++r) {
+                quint16 *row = buf->data() + size_t(r) * W * 3;
+                TiffCodec::undoPredictor16(row, W * 3, 3);
+                TiffCodec::rgb48ToRgb32(row, reinterpret_cast<QRgb *>(bits + (qsizetype(s) * rps + r) * bpl), W);
+            }
+            return true;
+        };
+    };
+    auto check = [&]() {
+        for (int y = 0; y < H; ++y)
+            if (memcmp(image.constScanLine(y), want.data() + size_t(y % rps) * W, size_t(W) * 4))
+                return false;
+        return true;
+    };
+
+    QElapsedTimer t;
+    image.fill(0);
+    t.start();
+    QVERIFY(TiffCodec::forEachWorker(strips, pipeline, 1));
+    const qint64 serialMs = t.elapsed();
+    QVERIFY(check());
+
+    image.fill(0);
+    t.restart();
+    QVERIFY(TiffCodec::forEachWorker(strips, pipeline));
+    const qint64 parallelMs = t.elapsed();
+    QVERIFY(check());
+
+    qInfo().noquote() << QString("24 MP 16-bit LZW strips: 1 thread %1 ms, %2 threads %3 ms")
+                         .arg(serialMs).arg(QThreadPool::globalInstance()->maxThreadCount())
+                         .arg(parallelMs);
+}
+
+QTEST_GUILESS_MAIN(TestTiffCodec)
+#include "tst_tiffcodec.moc"